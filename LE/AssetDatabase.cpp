@@ -0,0 +1,645 @@
+#include "AssetDatabase.h"
+#include "HashUtil.h"
+#include "ImageDecoder.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+	using uint64 = AssetDatabase::uint64;
+
+	// Changes every key, for when the way artifacts are made changes.
+	const uint64 DatabaseVersion = 1;
+
+	uint64 TextureSettingsHash(const AssetDatabase::TextureOptions& options)
+	{
+		const uint64 settings[] = {
+			(uint64)options.Mips.Kernel,
+			(uint64)(options.Mips.AlphaReference * 65536.0f),
+			(uint64)options.Compression.Format,
+			(uint64)options.Compression.Level,
+		};
+		return HashUtil::HashBytes(settings, sizeof(settings));
+	}
+
+	// Just enough of the DDS layout to write one uncompressed 2D texture
+	// with a DX10 header, which DDSTextureLoader reads back.
+	const uint32_t DdsMagic = 0x20534444; // "DDS "
+	const uint32_t DdsFourCCDX10 = 0x30315844; // "DX10"
+
+	struct DdsPixelFormat
+	{
+		uint32_t Size;
+		uint32_t Flags;
+		uint32_t FourCC;
+		uint32_t RGBBitCount;
+		uint32_t RBitMask;
+		uint32_t GBitMask;
+		uint32_t BBitMask;
+		uint32_t ABitMask;
+	};
+
+	struct DdsHeader
+	{
+		uint32_t Size;
+		uint32_t Flags;
+		uint32_t Height;
+		uint32_t Width;
+		uint32_t PitchOrLinearSize;
+		uint32_t Depth;
+		uint32_t MipMapCount;
+		uint32_t Reserved1[11];
+		DdsPixelFormat PixelFormat;
+		uint32_t Caps;
+		uint32_t Caps2;
+		uint32_t Caps3;
+		uint32_t Caps4;
+		uint32_t Reserved2;
+	};
+
+	struct DdsHeaderDX10
+	{
+		uint32_t DxgiFormat;
+		uint32_t ResourceDimension;
+		uint32_t MiscFlag;
+		uint32_t ArraySize;
+		uint32_t MiscFlags2;
+	};
+
+	std::string Directory(const std::string& filename)
+	{
+		const size_t slash = filename.find_last_of("\\/");
+		return slash == std::string::npos ? std::string() : filename.substr(0, slash + 1);
+	}
+
+	std::string Extension(const std::string& filename)
+	{
+		const size_t dot = filename.find_last_of('.');
+		std::string extension = dot == std::string::npos ? std::string() : filename.substr(dot);
+		std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+		return extension;
+	}
+
+	bool ReadFile(const std::string& filename, std::vector<char>& bytes)
+	{
+		std::ifstream fin(filename, std::ios::binary);
+		if (!fin)
+			return false;
+
+		fin.seekg(0, std::ios_base::end);
+		bytes.resize((size_t)fin.tellg());
+		fin.seekg(0, std::ios_base::beg);
+		fin.read(bytes.data(), bytes.size());
+		return fin.good() || bytes.empty();
+	}
+
+	// Writes next to filename first and then moves it over, so a run that
+	// dies half way never leaves a damaged artifact behind.  The temporary
+	// file is per thread, two threads may store the same content at once.
+	bool WriteFile(const std::string& filename, const void* data, size_t byteSize)
+	{
+		const std::string temporary = filename + "." + std::to_string(::GetCurrentThreadId()) + ".tmp";
+		{
+			std::ofstream fout(temporary, std::ios::binary);
+			if (!fout)
+				return false;
+			fout.write(static_cast<const char*>(data), byteSize);
+			if (!fout.good())
+				return false;
+		}
+		return ::MoveFileExA(temporary.c_str(), filename.c_str(), MOVEFILE_REPLACE_EXISTING) != FALSE;
+	}
+
+	// Files named by a line of a source: HLSL #include "x", .mtl texture
+	// maps and .obj mtllib, relative to the file that names them.
+	void FindReferences(const std::string& filename, std::vector<std::string>& references)
+	{
+		const std::string extension = Extension(filename);
+		const bool hlsl = extension == ".hlsl" || extension == ".hlsli";
+		const bool mtl = extension == ".mtl";
+		const bool obj = extension == ".obj";
+		if (!hlsl && !mtl && !obj)
+			return;
+
+		std::ifstream fin(filename);
+		const std::string directory = Directory(filename);
+		std::string line;
+		while (std::getline(fin, line))
+		{
+			std::istringstream tokens(line);
+			std::string keyword;
+			tokens >> keyword;
+
+			if (hlsl)
+			{
+				if (keyword != "#include")
+					continue;
+				const size_t open = line.find_first_of("\"<");
+				const size_t close = open == std::string::npos ? open : line.find_first_of("\">", open + 1);
+				if (close != std::string::npos)
+					references.push_back(directory + line.substr(open + 1, close - open - 1));
+				continue;
+			}
+
+			const bool reference = mtl ?
+				keyword.compare(0, 4, "map_") == 0 || keyword == "bump" || keyword == "disp" || keyword == "decal" || keyword == "norm" :
+				keyword == "mtllib";
+			if (!reference)
+				continue;
+
+			// Options such as -bm 1.0 come first, the path is last.
+			std::string path;
+			for (std::string token; tokens >> token; )
+				path = token;
+			if (!path.empty())
+				references.push_back(directory + path);
+		}
+	}
+
+	// Leaves resource in stateAfter, COPY_DEST records no barrier at all.
+	void UploadSubresources(ID3D12Device* device, ID3D12GraphicsCommandList* commandList, ID3D12Resource* resource,
+		const D3D12_SUBRESOURCE_DATA* subresources, UINT subresourceCount, D3D12_RESOURCE_STATES stateAfter, ID3D12Resource** ppUpload)
+	{
+		const UINT64 uploadBufferSize = GetRequiredIntermediateSize(resource, 0, subresourceCount);
+
+		ThrowIfFailed(
+			device->CreateCommittedResource(
+				&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+				D3D12_HEAP_FLAG_NONE,
+				&CD3DX12_RESOURCE_DESC::Buffer(uploadBufferSize),
+				D3D12_RESOURCE_STATE_GENERIC_READ,
+				nullptr,
+				IID_PPV_ARGS(ppUpload)));
+
+		UpdateSubresources(commandList, resource, *ppUpload, 0, 0, subresourceCount, subresources);
+		if (stateAfter != D3D12_RESOURCE_STATE_COPY_DEST)
+			commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(resource, D3D12_RESOURCE_STATE_COPY_DEST, stateAfter));
+	}
+
+	std::vector<unsigned char> MakeDds(const D3D12_RESOURCE_DESC& desc, const std::vector<D3D12_SUBRESOURCE_DATA>& subresources)
+	{
+		DdsHeader header = {};
+		header.Size = sizeof(DdsHeader);
+		// DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT
+		header.Flags = 0x1 | 0x2 | 0x4 | 0x1000;
+		header.Height = desc.Height;
+		header.Width = (uint32_t)desc.Width;
+		if (BlockCompressor::GetBlockBytes((DdsFile::Format)desc.Format) != 0)
+		{
+			header.Flags |= 0x80000; // DDSD_LINEARSIZE
+			header.PitchOrLinearSize = (uint32_t)subresources[0].SlicePitch;
+		}
+		else
+		{
+			header.Flags |= 0x8; // DDSD_PITCH
+			header.PitchOrLinearSize = (uint32_t)subresources[0].RowPitch;
+		}
+		header.MipMapCount = desc.MipLevels;
+		header.PixelFormat.Size = sizeof(DdsPixelFormat);
+		header.PixelFormat.Flags = 0x4; // DDPF_FOURCC
+		header.PixelFormat.FourCC = DdsFourCCDX10;
+		header.Caps = 0x1000; // DDSCAPS_TEXTURE
+		if (desc.MipLevels > 1)
+		{
+			header.Flags |= 0x20000; // DDSD_MIPMAPCOUNT
+			header.Caps |= 0x8 | 0x400000; // DDSCAPS_COMPLEX | DDSCAPS_MIPMAP
+		}
+
+		DdsHeaderDX10 headerDX10 = {};
+		headerDX10.DxgiFormat = desc.Format;
+		headerDX10.ResourceDimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+		headerDX10.ArraySize = desc.DepthOrArraySize;
+
+		// The subresources are in DDS order already, every mip of a slice
+		// before the next slice.
+		size_t byteSize = sizeof(DdsMagic) + sizeof(header) + sizeof(headerDX10);
+		for (const auto& subresource : subresources)
+			byteSize += (size_t)subresource.SlicePitch;
+
+		std::vector<unsigned char> dds(byteSize);
+		unsigned char* out = dds.data();
+		memcpy(out, &DdsMagic, sizeof(DdsMagic));
+		out += sizeof(DdsMagic);
+		memcpy(out, &header, sizeof(header));
+		out += sizeof(header);
+		memcpy(out, &headerDX10, sizeof(headerDX10));
+		out += sizeof(headerDX10);
+		for (const auto& subresource : subresources)
+		{
+			memcpy(out, subresource.pData, (size_t)subresource.SlicePitch);
+			out += subresource.SlicePitch;
+		}
+		return dds;
+	}
+
+	// PNG, JPEG and TGA without WIC, in the format WIC would give them.
+	// Returns false for files ImageDecoder does not read.
+	bool DecodeImage(const std::string& filename, D3D12_RESOURCE_DESC& desc, std::unique_ptr<uint8_t[]>& data, D3D12_SUBRESOURCE_DATA& subresource)
+	{
+		MappedFile file;
+		ImageDecoder::Info info;
+		if (!file.Open(filename) || !ImageDecoder::ReadInfo(file.GetData(), file.GetSize(), info) ||
+			info.Width > D3D12_REQ_TEXTURE2D_U_OR_V_DIMENSION || info.Height > D3D12_REQ_TEXTURE2D_U_OR_V_DIMENSION)
+			return false;
+
+		const size_t rowPitch = (size_t)info.Width * info.BytesPerPixel;
+		std::unique_ptr<uint8_t[]> decoded(new uint8_t[rowPitch * info.Height]);
+		if (!ImageDecoder::Decode(file.GetData(), file.GetSize(), decoded.get(), rowPitch))
+			return false;
+
+		desc = CD3DX12_RESOURCE_DESC::Tex2D(D3D12Util::GetDxgiFormat(info.Format), info.Width, info.Height, 1, 1);
+		data = std::move(decoded);
+		subresource.pData = data.get();
+		subresource.RowPitch = (LONG_PTR)rowPitch;
+		subresource.SlicePitch = (LONG_PTR)(rowPitch * info.Height);
+		return true;
+	}
+
+	// Single level 2D textures MipGenerator can filter.
+	bool NeedsMips(const DdsFile& dds)
+	{
+		return dds.GetDimension() == DdsFile::Dimension::Texture2D && dds.GetMipLevels() == 1 && !dds.IsCubeMap() &&
+			MipGenerator::IsSupported(dds.GetFormat()) && MipGenerator::GetMipCount((uint32_t)dds.GetWidth(), dds.GetHeight()) > 1;
+	}
+}
+
+AssetDatabase::AssetDatabase(const std::string& cacheDirectory)
+	:
+	mDirectory(cacheDirectory)
+{
+	if (!mDirectory.empty() && mDirectory.back() != '/' && mDirectory.back() != '\\')
+		mDirectory += '/';
+	::CreateDirectoryA(mDirectory.c_str(), nullptr);
+}
+
+AssetDatabase::uint64 AssetDatabase::HashFile(const std::string& filename)
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		auto known = mFileHashes.find(filename);
+		if (known != mFileHashes.end())
+			return known->second;
+	}
+
+	// Read without the lock.  Two threads may both hash a file the first
+	// time, they get the same result.
+	std::vector<char> bytes;
+	uint64 hash = 0;
+	const bool found = ReadFile(filename, bytes);
+	if (found)
+	{
+		// 0 is reserved for a missing file.
+		hash = HashUtil::HashBytes(bytes.data(), bytes.size());
+		hash = hash != 0 ? hash : 1;
+	}
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	if (found)
+	{
+		mStats.HashedFiles++;
+		mStats.HashedBytes += bytes.size();
+	}
+	mFileHashes[filename] = hash;
+	return hash;
+}
+
+std::vector<std::string> AssetDatabase::GetDependencies(const std::string& filename)
+{
+	std::unordered_set<std::string> visited = { filename };
+	std::vector<std::string> dependencies;
+	CollectDependencies(filename, visited, dependencies);
+
+	// Sorted, so the key does not depend on the order of the includes.
+	std::sort(dependencies.begin(), dependencies.end());
+	return dependencies;
+}
+
+void AssetDatabase::CollectDependencies(const std::string& filename, std::unordered_set<std::string>& visited, std::vector<std::string>& dependencies)
+{
+	std::vector<std::string> references;
+	FindReferences(filename, references);
+
+	for (const std::string& reference : references)
+	{
+		if (!visited.insert(reference).second)
+			continue;
+
+		dependencies.push_back(reference);
+		CollectDependencies(reference, visited, dependencies);
+	}
+}
+
+AssetDatabase::uint64 AssetDatabase::ArtifactKey(const std::string& kind, const std::string& source, uint64 settings)
+{
+	std::vector<uint64> values = { DatabaseVersion, settings, HashUtil::HashBytes(kind.data(), kind.size()), HashFile(source) };
+
+	// Dependencies count with their names, so moving an include changes the key too.
+	for (const std::string& dependency : GetDependencies(source))
+	{
+		values.push_back(HashUtil::HashBytes(dependency.data(), dependency.size()));
+		values.push_back(HashFile(dependency));
+	}
+
+	return HashUtil::HashBytes(values.data(), values.size() * sizeof(uint64));
+}
+
+std::string AssetDatabase::ArtifactPath(uint64 key, const std::string& extension) const
+{
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx", (unsigned long long)key);
+	return mDirectory + name + extension;
+}
+
+std::string AssetDatabase::ObjectPath(uint64 contentHash) const
+{
+	return ArtifactPath(contentHash, ".obj");
+}
+
+ComPtr<ID3DBlob> AssetDatabase::Load(uint64 key)
+{
+	// A key file holds the content hash of its artifact.
+	std::vector<char> reference;
+	uint64 contentHash = 0;
+	if (ReadFile(ArtifactPath(key, ".key"), reference) && reference.size() == sizeof(contentHash))
+		memcpy(&contentHash, reference.data(), sizeof(contentHash));
+
+	std::vector<char> bytes;
+	if (contentHash == 0 || !ReadFile(ObjectPath(contentHash), bytes) || HashUtil::HashBytes(bytes.data(), bytes.size()) != contentHash)
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStats.Misses++;
+		return nullptr;
+	}
+
+	ComPtr<ID3DBlob> blob;
+	ThrowIfFailed(D3DCreateBlob(bytes.size(), blob.GetAddressOf()));
+	memcpy(blob->GetBufferPointer(), bytes.data(), bytes.size());
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	mStats.Hits++;
+	return blob;
+}
+
+bool AssetDatabase::Store(uint64 key, const void* data, size_t byteSize)
+{
+	const uint64 contentHash = HashUtil::HashBytes(data, byteSize);
+	const std::string objectPath = ObjectPath(contentHash);
+
+	if (::GetFileAttributesA(objectPath.c_str()) != INVALID_FILE_ATTRIBUTES)
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStats.DeduplicatedStores++;
+	}
+	else if (!WriteFile(objectPath, data, byteSize))
+	{
+		return false;
+	}
+
+	return WriteFile(ArtifactPath(key, ".key"), &contentHash, sizeof(contentHash));
+}
+
+ComPtr<ID3DBlob> AssetDatabase::CompileShader(
+	const std::wstring& filename,
+	const D3D_SHADER_MACRO* defines,
+	const std::string& entrypoint,
+	const std::string& target)
+{
+	// Everything besides the files that goes into the compile.
+	std::string settings = entrypoint + '|' + target + '|';
+	for (const D3D_SHADER_MACRO* define = defines; define != nullptr && define->Name != nullptr; ++define)
+		settings += std::string(define->Name) + '=' + (define->Definition != nullptr ? define->Definition : "") + ';';
+#if defined(DEBUG) || defined(_DEBUG)
+	settings += "debug";
+#endif
+
+	const uint64 key = ArtifactKey("shader", WideToAnsi(filename), HashUtil::HashBytes(settings.data(), settings.size()));
+	if (ComPtr<ID3DBlob> byteCode = Load(key))
+		return byteCode;
+
+	ComPtr<ID3DBlob> byteCode = D3D12Util::CompileShader(filename, defines, entrypoint, target);
+	Store(key, byteCode->GetBufferPointer(), byteCode->GetBufferSize());
+	return byteCode;
+}
+
+void AssetDatabase::DecodeTexture(ID3D12Device* device, const wchar_t* filename, DecodedTexture& texture, const TextureOptions& options)
+{
+	const std::string source = WideToAnsi(filename);
+
+	// The same content imported with other options is another texture.
+	const uint64 contentHash = HashFile(source);
+	const uint64 settingsHash = TextureSettingsHash(options);
+	const uint64 textureKey = HashUtil::HashBytes(&settingsHash, sizeof(settingsHash), contentHash);
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		auto shared = mTextures.find(textureKey);
+		if (contentHash != 0 && shared != mTextures.end())
+		{
+			texture.Resource = shared->second;
+			texture.Shared = true;
+			mStats.SharedTextures++;
+			return;
+		}
+	}
+
+	// A DDS file with its mips, or in a format MipGenerator does not filter,
+	// is in its GPU layout already and there is nothing to cache.  The upload
+	// copies straight from the mapped file.
+	if (Extension(source) == ".dds")
+	{
+		texture.Mapped = std::make_unique<DdsFile>();
+		if (!texture.Mapped->Open(source))
+		{
+			texture.Mapped.reset();
+			ThrowIfFailed(DirectX::LoadDDSTextureFromFile(device, filename, texture.Resource.GetAddressOf(),
+				texture.Data, texture.Subresources));
+		}
+		else if (!NeedsMips(*texture.Mapped))
+		{
+			const D3D12_RESOURCE_DESC desc = D3D12Util::GetDdsDesc(*texture.Mapped);
+			ThrowIfFailed(device->CreateCommittedResource(
+				&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+				D3D12_HEAP_FLAG_NONE,
+				&desc,
+				D3D12_RESOURCE_STATE_COPY_DEST,
+				nullptr,
+				IID_PPV_ARGS(texture.Resource.GetAddressOf())));
+			texture.Subresources = D3D12Util::GetDdsSubresources(*texture.Mapped);
+		}
+	}
+
+	if (texture.Resource == nullptr)
+	{
+		// Everything else is cached decoded, with its mips, and compressed.
+		const uint64 key = ArtifactKey("texture", source, settingsHash);
+		texture.CachedData = Load(key);
+		if (texture.CachedData)
+		{
+			texture.Mapped.reset();
+			ThrowIfFailed(DirectX::LoadDDSTextureFromMemory(device, static_cast<const uint8_t*>(texture.CachedData->GetBufferPointer()),
+				texture.CachedData->GetBufferSize(), texture.Resource.GetAddressOf(), texture.Subresources));
+		}
+		else
+		{
+			D3D12_RESOURCE_DESC desc;
+			if (texture.Mapped)
+			{
+				desc = D3D12Util::GetDdsDesc(*texture.Mapped);
+				texture.Subresources = D3D12Util::GetDdsSubresources(*texture.Mapped);
+			}
+			else
+			{
+				D3D12_SUBRESOURCE_DATA subresource;
+				if (!DecodeImage(source, desc, texture.Data, subresource))
+				{
+					ThrowIfFailed(DirectX::LoadWICTextureFromFile(device, filename, texture.Resource.GetAddressOf(), texture.Data, subresource));
+					desc = texture.Resource->GetDesc();
+				}
+				texture.Subresources.assign(1, subresource);
+			}
+
+			// WIC's resource is only kept when the texture stays as WIC made it.
+			std::vector<DdsFile::Surface> surfaces = D3D12Util::GetSurfaces(texture.Subresources);
+			if (MipGenerator::Generate((DdsFile::Format)desc.Format, (UINT)desc.Width, desc.Height, surfaces, texture.MipData, options.Mips))
+			{
+				desc.MipLevels = (UINT16)MipGenerator::GetMipCount((UINT)desc.Width, desc.Height);
+				texture.Subresources = D3D12Util::GetSubresources(surfaces);
+				texture.Resource.Reset();
+			}
+
+			// Textures the compressor does not take stay uncompressed.
+			BlockCompressor::Report report;
+			std::vector<DdsFile::Surface> compressed;
+			if (options.Compression.Format != DdsFile::Format::UNKNOWN &&
+				BlockCompressor::Compress((DdsFile::Format)desc.Format, (UINT)desc.Width, desc.Height, desc.MipLevels, surfaces,
+					options.Compression, texture.CompressedData, compressed, report))
+			{
+				::OutputDebugStringA((source + ": " + report.ToString()).c_str());
+				desc.Format = (DXGI_FORMAT)report.Format;
+				texture.Subresources = D3D12Util::GetSubresources(compressed);
+				texture.Resource.Reset();
+			}
+			if (texture.Resource == nullptr)
+			{
+				ThrowIfFailed(device->CreateCommittedResource(
+					&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+					D3D12_HEAP_FLAG_NONE,
+					&desc,
+					D3D12_RESOURCE_STATE_COPY_DEST,
+					nullptr,
+					IID_PPV_ARGS(texture.Resource.GetAddressOf())));
+			}
+
+			const std::vector<unsigned char> decoded = MakeDds(desc, texture.Subresources);
+			Store(key, decoded.data(), decoded.size());
+		}
+	}
+
+	if (contentHash == 0)
+		return;
+
+	// Another thread may have loaded the same content in the meantime, the
+	// first one to get here is the one that is kept.
+	std::lock_guard<std::mutex> lock(mMutex);
+	auto inserted = mTextures.emplace(textureKey, texture.Resource);
+	if (!inserted.second)
+	{
+		texture = DecodedTexture();
+		texture.Resource = inserted.first->second;
+		texture.Shared = true;
+		mStats.SharedTextures++;
+	}
+}
+
+void AssetDatabase::UploadTexture(
+	ID3D12Device* device,
+	ID3D12GraphicsCommandList* commandList,
+	DecodedTexture& texture,
+	ID3D12Resource** ppResource,
+	ID3D12Resource** ppUpload,
+	D3D12_RESOURCE_STATES stateAfter)
+{
+	*ppResource = texture.Resource.Get();
+	(*ppResource)->AddRef();
+
+	if (!texture.Shared)
+		UploadSubresources(device, commandList, *ppResource, texture.Subresources.data(), (UINT)texture.Subresources.size(), stateAfter, ppUpload);
+
+	if (texture.KeepSource)
+	{
+		// Only the compressed levels are uploaded again.
+		if (!texture.CompressedData.empty())
+		{
+			texture.Mapped.reset();
+			texture.Data.reset();
+			std::vector<uint8_t>().swap(texture.MipData);
+		}
+		return;
+	}
+
+	// The upload buffer holds its own copy now.
+	texture.Mapped.reset();
+	texture.Data.reset();
+	std::vector<uint8_t>().swap(texture.MipData);
+	std::vector<uint8_t>().swap(texture.CompressedData);
+	texture.CachedData = nullptr;
+	texture.Subresources.clear();
+}
+
+AssetDatabase::uint64 AssetDatabase::GetSourceBytes(const DecodedTexture& texture)
+{
+	uint64 bytes = 0;
+	for (const D3D12_SUBRESOURCE_DATA& subresource : texture.Subresources)
+	{
+		const bool mapped = texture.Mapped && std::any_of(texture.Mapped->GetSurfaces().begin(), texture.Mapped->GetSurfaces().end(),
+			[&subresource](const DdsFile::Surface& surface) { return surface.Data == subresource.pData; });
+		if (!mapped)
+			bytes += (uint64)subresource.SlicePitch;
+	}
+	return bytes;
+}
+
+void AssetDatabase::LoadTexture(
+	ID3D12Device* device,
+	ID3D12GraphicsCommandList* commandList,
+	const wchar_t* filename,
+	ID3D12Resource** ppResource,
+	ID3D12Resource** ppUpload)
+{
+	DecodedTexture texture;
+	DecodeTexture(device, filename, texture, TextureOptions());
+	UploadTexture(device, commandList, texture, ppResource, ppUpload);
+}
+
+void AssetDatabase::ForgetTexture(ID3D12Resource* resource)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	for (auto it = mTextures.begin(); it != mTextures.end();)
+	{
+		if (it->second.Get() == resource)
+			it = mTextures.erase(it);
+		else
+			++it;
+	}
+}
+
+AssetDatabase::Stats AssetDatabase::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mStats;
+}
+
+std::string AssetDatabase::ToString() const
+{
+	const Stats stats = GetStats();
+
+	char buffer[256];
+	snprintf(buffer, sizeof(buffer),
+		"[AssetDatabase] %u hits, %u misses, %u deduplicated stores, %u shared textures, %u files hashed (%llu bytes)\n",
+		stats.Hits, stats.Misses, stats.DeduplicatedStores, stats.SharedTextures,
+		stats.HashedFiles, (unsigned long long)stats.HashedBytes);
+
+	return buffer;
+}
\ No newline at end of file
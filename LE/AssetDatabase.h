@@ -0,0 +1,171 @@
+#pragma once
+#include "BlockCompressor.h"
+#include "D3D12Util.h"
+#include "DdsFile.h"
+#include "MipGenerator.h"
+#include <mutex>
+#include <unordered_set>
+
+// Content addressed cache of derived assets (compiled shaders, decoded
+// textures, cooked meshes) in a local directory.
+//
+// An artifact is found by its key: a hash of what kind of artifact it is,
+// its import settings and the content of its source file and of every file
+// the source depends on (HLSL #includes, textures named by a .mtl, the
+// .mtl named by an .obj).  Editing a file only changes the keys of the
+// artifacts that depend on it, everything else stays cached.
+//
+// The bytes of an artifact are stored once per content hash and keys only
+// refer to them, so artifacts that come out the same share one file.
+// Textures with the same content and options share one resource at runtime.
+//
+// All functions can be called from several threads at once.
+class AssetDatabase
+{
+public:
+	using uint64 = std::uint64_t;
+
+	struct Stats
+	{
+		UINT Hits = 0;
+		UINT Misses = 0;
+		// Stores whose content was already in the cache.
+		UINT DeduplicatedStores = 0;
+		UINT SharedTextures = 0;
+		UINT HashedFiles = 0;
+		UINT64 HashedBytes = 0;
+	};
+
+	// How textures that are cached decoded are processed on import.
+	struct TextureOptions
+	{
+		MipGenerator::Options Mips;
+		BlockCompressor::Options Compression;
+	};
+
+	// A texture read and placed in a resource, but not uploaded yet.
+	struct DecodedTexture
+	{
+		Microsoft::WRL::ComPtr<ID3D12Resource> Resource;
+		std::vector<D3D12_SUBRESOURCE_DATA> Subresources;
+		// What Subresources point into.
+		std::unique_ptr<DdsFile> Mapped;
+		std::unique_ptr<uint8_t[]> Data;
+		std::vector<uint8_t> MipData;
+		std::vector<uint8_t> CompressedData;
+		Microsoft::WRL::ComPtr<ID3DBlob> CachedData;
+		// Resource was loaded before from a file with the same content and
+		// needs no upload.
+		bool Shared = false;
+		// UploadTexture leaves Subresources and what they point into alone,
+		// for textures whose levels are uploaded again later.
+		bool KeepSource = false;
+	};
+
+	explicit AssetDatabase(const std::string& cacheDirectory);
+	AssetDatabase(const AssetDatabase& rhs) = delete;
+	AssetDatabase& operator=(const AssetDatabase& rhs) = delete;
+
+	///<summary>
+	/// Hash of the content of filename, 0 when it is missing.  Every file is
+	/// only read once per run.
+	///</summary>
+	uint64 HashFile(const std::string& filename);
+
+	///<summary>
+	/// Files filename includes or refers to, directly or through other files,
+	/// with paths relative to the working directory.
+	///</summary>
+	std::vector<std::string> GetDependencies(const std::string& filename);
+
+	///<summary>
+	/// Key of the kind artifact made from source with settings.  Changes with
+	/// the content of source and of any of its dependencies.
+	///</summary>
+	uint64 ArtifactKey(const std::string& kind, const std::string& source, uint64 settings);
+
+	///<summary>
+	/// Path of an artifact that is written by its own code (like a cooked
+	/// mesh) instead of through Store.
+	///</summary>
+	std::string ArtifactPath(uint64 key, const std::string& extension) const;
+
+	///<summary>
+	/// The bytes stored for key, or nullptr when there are none.
+	///</summary>
+	Microsoft::WRL::ComPtr<ID3DBlob> Load(uint64 key);
+	bool Store(uint64 key, const void* data, size_t byteSize);
+
+	///<summary>
+	/// D3D12Util::CompileShader through the cache.  The key covers the file,
+	/// its includes, defines, entry point, target and compile flags.
+	///</summary>
+	Microsoft::WRL::ComPtr<ID3DBlob> CompileShader(
+		const std::wstring& filename,
+		const D3D_SHADER_MACRO* defines,
+		const std::string& entrypoint,
+		const std::string& target);
+
+	///<summary>
+	/// The part of LoadTexture that only needs the device, so textures can
+	/// be decoded on other threads than the one recording the uploads.
+	/// Textures without mips get theirs from MipGenerator and are then block
+	/// compressed, as options say.
+	///</summary>
+	void DecodeTexture(ID3D12Device* device, const wchar_t* filename, DecodedTexture& texture, const TextureOptions& options);
+
+	///<summary>
+	/// Records the upload of a decoded texture and the transition to
+	/// stateAfter.  COPY_DEST records no barrier, for copy queues.  Leaves
+	/// *ppUpload alone for shared textures.  Frees the decoded levels unless
+	/// the texture keeps its source, and then still the levels it was block
+	/// compressed from.
+	///</summary>
+	void UploadTexture(
+		ID3D12Device* device,
+		ID3D12GraphicsCommandList* commandList,
+		DecodedTexture& texture,
+		ID3D12Resource** ppResource,
+		ID3D12Resource** ppUpload,
+		D3D12_RESOURCE_STATES stateAfter = D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+
+	///<summary>
+	/// D3D12Util::LoadTexture through the cache.  Images and single level
+	/// DDS files are cached decoded as DDS, with a generated mip chain.  A
+	/// file with the same content as one loaded before gets the same
+	/// resource and no upload buffer.
+	///</summary>
+	void LoadTexture(
+		ID3D12Device* device,
+		ID3D12GraphicsCommandList* commandList,
+		const wchar_t* filename,
+		ID3D12Resource** ppResource,
+		ID3D12Resource** ppUpload);
+
+	///<summary>
+	/// Bytes of memory the levels of a kept source take.  Levels mapped from
+	/// a file do not count, the system pages them in and out on its own.
+	///</summary>
+	static uint64 GetSourceBytes(const DecodedTexture& texture);
+
+	///<summary>
+	/// Stops sharing resource with later loads of the same content, so it is
+	/// released with its last user.
+	///</summary>
+	void ForgetTexture(ID3D12Resource* resource);
+
+	Stats GetStats() const;
+
+	std::string ToString() const;
+
+private:
+	void CollectDependencies(const std::string& filename, std::unordered_set<std::string>& visited, std::vector<std::string>& dependencies);
+	std::string ObjectPath(uint64 contentHash) const;
+
+	std::string mDirectory;
+	mutable std::mutex mMutex;
+	std::unordered_map<std::string, uint64> mFileHashes;
+	// Keyed by content hash and TextureOptions.
+	std::unordered_map<uint64, Microsoft::WRL::ComPtr<ID3D12Resource>> mTextures;
+	Stats mStats;
+};
\ No newline at end of file
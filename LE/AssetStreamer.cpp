@@ -0,0 +1,210 @@
+#include "AssetStreamer.h"
+#include <algorithm>
+#include <cstdio>
+
+const AssetStreamer::Handle AssetStreamer::InvalidHandle;
+
+AssetStreamer::AssetStreamer(Device& device, const Options& options)
+	:
+	mDevice(device),
+	mOptions(options)
+{
+	for (uint32 i = 0; i < std::max(1u, mOptions.ThreadCount); ++i)
+		mThreads.emplace_back([this]() { Work(); });
+}
+
+AssetStreamer::~AssetStreamer()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStopping = true;
+	}
+	mWake.notify_all();
+	for (auto& thread : mThreads)
+		thread.join();
+
+	// The uploads still copy from what their payloads hold.
+	uint64 last = 0;
+	for (const auto& upload : mUploads)
+		last = std::max(last, upload.Fence);
+	if (last > 0)
+		mDevice.WaitForFence(last);
+}
+
+AssetStreamer::Handle AssetStreamer::Request(const std::string& filename, ResidentCallback onResident)
+{
+	Handle handle;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mAssets.emplace_back();
+		Asset& asset = mAssets.back();
+		asset.Filename = filename;
+		asset.OnResident = std::move(onResident);
+		handle = (Handle)mAssets.size();
+		mDecodeQueue.push_back(handle);
+		mStats.Requested++;
+	}
+	mWake.notify_one();
+	return handle;
+}
+
+AssetStreamer::State AssetStreamer::GetState(Handle handle) const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	if (handle == InvalidHandle || handle > mAssets.size())
+		return State::Failed;
+	return mAssets[handle - 1].Current;
+}
+
+void AssetStreamer::SetState(Handle handle, State state)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	mAssets[handle - 1].Current = state;
+	if (state == State::Resident)
+		mStats.Resident++;
+}
+
+void AssetStreamer::Fail(Handle handle, const std::string& message)
+{
+	std::string filename;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		Asset& asset = mAssets[handle - 1];
+		asset.Current = State::Failed;
+		asset.OnResident = nullptr;
+		asset.Decoded.reset();
+		filename = asset.Filename;
+		mStats.Failed++;
+	}
+
+	if (mOptions.Log)
+		mOptions.Log("[AssetStreamer] " + message + " " + filename + "\n");
+}
+
+void AssetStreamer::Work()
+{
+	for (;;)
+	{
+		Handle handle;
+		std::string filename;
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mWake.wait(lock, [this]() { return mStopping || !mDecodeQueue.empty(); });
+			if (mStopping)
+				return;
+			handle = mDecodeQueue.front();
+			mDecodeQueue.pop_front();
+			mAssets[handle - 1].Current = State::Decoding;
+			filename = mAssets[handle - 1].Filename;
+		}
+
+		std::unique_ptr<Payload> decoded;
+		try
+		{
+			decoded = mDevice.Decode(filename);
+		}
+		catch (...)
+		{
+			decoded.reset();
+		}
+
+		if (decoded == nullptr)
+		{
+			Fail(handle, "Could not decode");
+			continue;
+		}
+
+		std::lock_guard<std::mutex> lock(mMutex);
+		Asset& asset = mAssets[handle - 1];
+		asset.Decoded = std::move(decoded);
+		asset.Current = State::Decoded;
+		mUploadQueue.push_back(handle);
+	}
+}
+
+void AssetStreamer::Update()
+{
+	// Hand out what the GPU finished copying.
+	const uint64 completed = mDevice.GetCompletedFence();
+	auto pending = std::partition(mUploads.begin(), mUploads.end(),
+		[completed](const Upload& upload) { return upload.Fence > completed; });
+	std::vector<Upload> done(std::make_move_iterator(pending), std::make_move_iterator(mUploads.end()));
+	mUploads.erase(pending, mUploads.end());
+	for (auto& upload : done)
+	{
+		mDevice.MakeResident(*upload.Decoded);
+		SetState(upload.Id, State::Resident);
+		if (upload.OnResident)
+			upload.OnResident(*upload.Decoded);
+	}
+
+	// Record the next uploads in the order they were decoded, until the
+	// budget of the frame is spent.
+	std::vector<Upload> recorded;
+	uint64 bytes = 0;
+	for (;;)
+	{
+		Upload upload;
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			if (mUploadQueue.empty())
+				break;
+			Asset& asset = mAssets[mUploadQueue.front() - 1];
+			if (bytes > 0 && bytes + asset.Decoded->UploadBytes > mOptions.UploadBytesPerFrame)
+				break;
+			upload.Id = mUploadQueue.front();
+			upload.Decoded = std::move(asset.Decoded);
+			upload.OnResident = std::move(asset.OnResident);
+			upload.Fence = 0;
+			asset.Current = State::Uploading;
+			mUploadQueue.pop_front();
+		}
+
+		try
+		{
+			mDevice.RecordUpload(*upload.Decoded);
+		}
+		catch (...)
+		{
+			// Its staging memory goes with the payload.
+			upload.Decoded.reset();
+			Fail(upload.Id, "Could not upload");
+			continue;
+		}
+
+		bytes += upload.Decoded->UploadBytes;
+		recorded.push_back(std::move(upload));
+	}
+
+	if (recorded.empty())
+		return;
+
+	const uint64 fence = mDevice.Submit();
+	for (auto& upload : recorded)
+	{
+		upload.Fence = fence;
+		mUploads.push_back(std::move(upload));
+	}
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	mStats.Submits++;
+	mStats.UploadedBytes += bytes;
+	mStats.LargestFrameBytes = std::max(mStats.LargestFrameBytes, bytes);
+}
+
+AssetStreamer::Stats AssetStreamer::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mStats;
+}
+
+std::string AssetStreamer::ToString() const
+{
+	const Stats stats = GetStats();
+	char buffer[256];
+	snprintf(buffer, sizeof(buffer),
+		"[AssetStreamer] %u requested, %u resident, %u failed, %u submits, %.1f MB uploaded, at most %.1f MB in a frame\n",
+		stats.Requested, stats.Resident, stats.Failed, stats.Submits,
+		stats.UploadedBytes / (1024.0 * 1024.0), stats.LargestFrameBytes / (1024.0 * 1024.0));
+	return buffer;
+}
\ No newline at end of file
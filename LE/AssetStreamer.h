@@ -0,0 +1,182 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Loads assets while the application keeps rendering.  Request returns a
+// handle right away, worker threads decode the file, and Update (called
+// once a frame on the render thread) records the uploads of what was
+// decoded, a budget of bytes per frame at most, and hands out the assets
+// whose uploads the GPU finished.  Nothing in Update waits for the GPU or
+// for a worker, so until an asset is resident its users keep drawing with
+// a placeholder.
+//
+// An asset goes Queued -> Decoding -> Decoded -> Uploading -> Resident, or
+// ends up Failed when it cannot be decoded or its upload cannot be
+// recorded.  Everything that touches the
+// GPU is behind Device, so the same state machine runs against a headless
+// stand-in that only pretends to upload.
+class AssetStreamer
+{
+public:
+	using uint32 = std::uint32_t;
+	using uint64 = std::uint64_t;
+	using Handle = uint32;
+
+	static const Handle InvalidHandle = 0;
+
+	enum class State
+	{
+		Queued,
+		Decoding,
+		Decoded,
+		Uploading,
+		Resident,
+		Failed,
+	};
+
+	// What Device::Decode makes of a file.  Owned by the streamer until the
+	// asset is resident.
+	struct Payload
+	{
+		virtual ~Payload() = default;
+
+		// Bytes the upload copies, counted against the budget of a frame.
+		uint64 UploadBytes = 0;
+	};
+
+	class Device
+	{
+	public:
+		virtual ~Device() = default;
+
+		///<summary>
+		/// On a worker thread: reads and decodes filename, nullptr when it
+		/// cannot.  May throw as well.
+		///</summary>
+		virtual std::unique_ptr<Payload> Decode(const std::string& filename) = 0;
+
+		///<summary>
+		/// On the render thread: records the upload of payload.  When it
+		/// throws it must not have recorded anything that reads payload, the
+		/// streamer releases it right away.
+		///</summary>
+		virtual void RecordUpload(Payload& payload) = 0;
+
+		///<summary>
+		/// On the render thread: submits the uploads recorded since the last
+		/// Submit and returns the fence value they are done at.
+		///</summary>
+		virtual uint64 Submit() = 0;
+
+		virtual uint64 GetCompletedFence() = 0;
+
+		///<summary>
+		/// Blocks until fence is done, only used when the streamer goes away.
+		///</summary>
+		virtual void WaitForFence(uint64 fence) = 0;
+
+		///<summary>
+		/// On the render thread, once the upload of payload is done: releases
+		/// what only the upload needed.
+		///</summary>
+		virtual void MakeResident(Payload& payload) = 0;
+	};
+
+	struct Options
+	{
+		// Uploads recorded per Update.  An asset larger than that still goes
+		// alone, so it does not wait forever.
+		uint64 UploadBytesPerFrame = 32ull << 20;
+		uint32 ThreadCount = 2;
+		// Receives the assets that failed, one line each, on the thread
+		// that found out.  Nothing is logged when empty.
+		std::function<void(const std::string& message)> Log;
+	};
+
+	struct Stats
+	{
+		uint32 Requested = 0;
+		uint32 Resident = 0;
+		uint32 Failed = 0;
+		uint32 Submits = 0;
+		uint64 UploadedBytes = 0;
+		// Most bytes recorded by one Update.
+		uint64 LargestFrameBytes = 0;
+	};
+
+	// Called by Update on the render thread when the asset is resident.
+	using ResidentCallback = std::function<void(Payload& payload)>;
+
+	AssetStreamer(Device& device, const Options& options);
+	AssetStreamer(const AssetStreamer& rhs) = delete;
+	AssetStreamer& operator=(const AssetStreamer& rhs) = delete;
+	// Waits for the workers to finish the files they are decoding and for
+	// the uploads in flight.  Queued and decoded assets are dropped.
+	~AssetStreamer();
+
+	///<summary>
+	/// Queues filename for decoding and returns its handle.  onResident runs
+	/// in the Update that finds its upload done.
+	///</summary>
+	Handle Request(const std::string& filename, ResidentCallback onResident);
+
+	State GetState(Handle handle) const;
+
+	///<summary>
+	/// Once a frame on the render thread: finishes the uploads the GPU is
+	/// done with, then records and submits the next ones.
+	///</summary>
+	void Update();
+
+	Stats GetStats() const;
+
+	std::string ToString() const;
+
+private:
+	struct Asset
+	{
+		std::string Filename;
+		State Current = State::Queued;
+		ResidentCallback OnResident;
+		// Set by the workers when the asset is decoded.
+		std::unique_ptr<Payload> Decoded;
+	};
+
+	// Assets between RecordUpload and the end of their upload.  Only the
+	// render thread touches these.
+	struct Upload
+	{
+		Handle Id;
+		std::unique_ptr<Payload> Decoded;
+		ResidentCallback OnResident;
+		uint64 Fence;
+	};
+
+	void Work();
+	void SetState(Handle handle, State state);
+	void Fail(Handle handle, const std::string& message);
+
+	Device& mDevice;
+	Options mOptions;
+
+	mutable std::mutex mMutex;
+	std::condition_variable mWake;
+	// By handle - 1.  A deque, so workers can hold on to an asset while
+	// Request adds more.
+	std::deque<Asset> mAssets;
+	std::deque<Handle> mDecodeQueue;
+	// Decoded, in the order they finished.
+	std::deque<Handle> mUploadQueue;
+	bool mStopping = false;
+	Stats mStats;
+
+	std::vector<Upload> mUploads;
+	std::vector<std::thread> mThreads;
+};
\ No newline at end of file
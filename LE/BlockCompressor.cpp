@@ -0,0 +1,969 @@
+#include "BlockCompressor.h"
+#include "WorkerPool.h"
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define BLOCKCOMPRESSOR_SSE2 1
+#endif
+
+namespace
+{
+	using uint8 = std::uint8_t;
+	using uint16 = std::uint16_t;
+	using uint32 = std::uint32_t;
+	using uint64 = std::uint64_t;
+	using int16 = std::int16_t;
+	using Quality = BlockCompressor::Quality;
+	using Format = BlockCompressor::Format;
+
+	// Rows of blocks encoded by one job of ParallelFor.
+	const uint32 BlockRowsPerJob = 4;
+
+	enum class Kind
+	{
+		None,
+		BC1,
+		BC3,
+		BC4,
+		BC5,
+		BC7,
+	};
+
+	Kind GetKind(Format format)
+	{
+		switch (format)
+		{
+		case Format::BC1_UNORM: case Format::BC1_UNORM_SRGB: return Kind::BC1;
+		case Format::BC3_UNORM: case Format::BC3_UNORM_SRGB: return Kind::BC3;
+		case Format::BC4_UNORM: return Kind::BC4;
+		case Format::BC5_UNORM: return Kind::BC5;
+		case Format::BC7_UNORM: case Format::BC7_UNORM_SRGB: return Kind::BC7;
+		default: return Kind::None;
+		}
+	}
+
+	const char* FormatName(Format format)
+	{
+		switch (format)
+		{
+		case Format::BC1_UNORM: return "BC1_UNORM";
+		case Format::BC1_UNORM_SRGB: return "BC1_UNORM_SRGB";
+		case Format::BC3_UNORM: return "BC3_UNORM";
+		case Format::BC3_UNORM_SRGB: return "BC3_UNORM_SRGB";
+		case Format::BC4_UNORM: return "BC4_UNORM";
+		case Format::BC5_UNORM: return "BC5_UNORM";
+		case Format::BC7_UNORM: return "BC7_UNORM";
+		case Format::BC7_UNORM_SRGB: return "BC7_UNORM_SRGB";
+		default: return "?";
+		}
+	}
+
+	// The 16 texels of a block as RGBA in 16-bit lanes.  Channels a format
+	// does not encode are 0 in the texels and in the palettes, so they add
+	// nothing to the distances.
+	struct Texels
+	{
+		int16 Values[16][4];
+	};
+
+	// Index of the nearest palette entry for every texel, its squared
+	// distance, and the sum of those.
+	uint32 SelectIndices(const Texels& texels, const int16 (*palette)[4], uint32 paletteSize, uint8 indices[16], uint32 distances[16])
+	{
+#ifdef BLOCKCOMPRESSOR_SSE2
+		uint32 total = 0;
+		for (uint32 group = 0; group < 16; group += 4)
+		{
+			const __m128i t01 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(texels.Values[group]));
+			const __m128i t23 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(texels.Values[group + 2]));
+			__m128i best = _mm_set1_epi32(INT_MAX);
+			__m128i bestIndex = _mm_setzero_si128();
+			for (uint32 p = 0; p < paletteSize; ++p)
+			{
+				const __m128i entry = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(palette[p]));
+				const __m128i entries = _mm_unpacklo_epi64(entry, entry);
+				const __m128i d01 = _mm_sub_epi16(t01, entries);
+				const __m128i d23 = _mm_sub_epi16(t23, entries);
+				// (r^2 + g^2, b^2 + a^2) per texel, then the pairs added up.
+				const __m128 m01 = _mm_castsi128_ps(_mm_madd_epi16(d01, d01));
+				const __m128 m23 = _mm_castsi128_ps(_mm_madd_epi16(d23, d23));
+				const __m128i distance = _mm_add_epi32(
+					_mm_castps_si128(_mm_shuffle_ps(m01, m23, _MM_SHUFFLE(2, 0, 2, 0))),
+					_mm_castps_si128(_mm_shuffle_ps(m01, m23, _MM_SHUFFLE(3, 1, 3, 1))));
+				const __m128i closer = _mm_cmplt_epi32(distance, best);
+				best = _mm_or_si128(_mm_and_si128(closer, distance), _mm_andnot_si128(closer, best));
+				bestIndex = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32((int)p)), _mm_andnot_si128(closer, bestIndex));
+			}
+
+			uint32 bestDistances[4];
+			uint32 bestIndices[4];
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(bestDistances), best);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(bestIndices), bestIndex);
+			for (uint32 i = 0; i < 4; ++i)
+			{
+				indices[group + i] = (uint8)bestIndices[i];
+				distances[group + i] = bestDistances[i];
+				total += bestDistances[i];
+			}
+		}
+		return total;
+#else
+		uint32 total = 0;
+		for (uint32 i = 0; i < 16; ++i)
+		{
+			uint32 best = UINT_MAX;
+			for (uint32 p = 0; p < paletteSize; ++p)
+			{
+				uint32 distance = 0;
+				for (uint32 c = 0; c < 4; ++c)
+				{
+					const int d = texels.Values[i][c] - palette[p][c];
+					distance += d * d;
+				}
+				if (distance < best)
+				{
+					best = distance;
+					indices[i] = (uint8)p;
+				}
+			}
+			distances[i] = best;
+			total += best;
+		}
+		return total;
+#endif
+	}
+
+	float Clamp255(float value)
+	{
+		return value < 0.0f ? 0.0f : value > 255.0f ? 255.0f : value;
+	}
+
+	// Endpoints where the principal axis through the texels (channels
+	// [0, channels)) leaves the block.
+	void FitPrincipalAxis(const Texels& texels, uint32 channels, float e0[4], float e1[4])
+	{
+		float mean[4] = {};
+		for (uint32 i = 0; i < 16; ++i)
+		{
+			for (uint32 c = 0; c < channels; ++c)
+				mean[c] += texels.Values[i][c] * (1.0f / 16.0f);
+		}
+
+		float covariance[4][4] = {};
+		for (uint32 i = 0; i < 16; ++i)
+		{
+			for (uint32 a = 0; a < channels; ++a)
+			{
+				for (uint32 b = 0; b < channels; ++b)
+					covariance[a][b] += (texels.Values[i][a] - mean[a]) * (texels.Values[i][b] - mean[b]);
+			}
+		}
+
+		// Power iteration from the channel that varies most.
+		uint32 largest = 0;
+		for (uint32 c = 1; c < channels; ++c)
+		{
+			if (covariance[c][c] > covariance[largest][largest])
+				largest = c;
+		}
+		float axis[4] = {};
+		for (uint32 c = 0; c < channels; ++c)
+			axis[c] = covariance[largest][c];
+		for (int iteration = 0; iteration < 8; ++iteration)
+		{
+			float next[4] = {};
+			float scale = 0.0f;
+			for (uint32 a = 0; a < channels; ++a)
+			{
+				for (uint32 b = 0; b < channels; ++b)
+					next[a] += covariance[a][b] * axis[b];
+				scale = std::max(scale, std::abs(next[a]));
+			}
+			if (scale == 0.0f)
+				break;
+			for (uint32 c = 0; c < channels; ++c)
+				axis[c] = next[c] / scale;
+		}
+
+		float length = 0.0f;
+		for (uint32 c = 0; c < channels; ++c)
+			length += axis[c] * axis[c];
+		length = std::sqrt(length);
+		if (length < 1e-6f)
+		{
+			for (uint32 c = 0; c < 4; ++c)
+				e0[c] = e1[c] = mean[c];
+			return;
+		}
+
+		float low = 0.0f;
+		float high = 0.0f;
+		for (uint32 i = 0; i < 16; ++i)
+		{
+			float t = 0.0f;
+			for (uint32 c = 0; c < channels; ++c)
+				t += (texels.Values[i][c] - mean[c]) * axis[c] / length;
+			low = std::min(low, t);
+			high = std::max(high, t);
+		}
+		for (uint32 c = 0; c < 4; ++c)
+		{
+			e0[c] = c < channels ? Clamp255(mean[c] + axis[c] / length * high) : 0.0f;
+			e1[c] = c < channels ? Clamp255(mean[c] + axis[c] / length * low) : 0.0f;
+		}
+	}
+
+	// Least squares endpoints for fixed indices, where index i sits at
+	// weights[i] of the way from e0 to e1.
+	bool RefineEndpoints(const Texels& texels, uint32 channels, const uint8 indices[16], const float* weights, float e0[4], float e1[4])
+	{
+		float aa = 0.0f;
+		float ab = 0.0f;
+		float bb = 0.0f;
+		float ax[4] = {};
+		float bx[4] = {};
+		for (uint32 i = 0; i < 16; ++i)
+		{
+			const float t = weights[indices[i]];
+			const float s = 1.0f - t;
+			aa += s * s;
+			ab += s * t;
+			bb += t * t;
+			for (uint32 c = 0; c < channels; ++c)
+			{
+				ax[c] += s * texels.Values[i][c];
+				bx[c] += t * texels.Values[i][c];
+			}
+		}
+
+		const float determinant = aa * bb - ab * ab;
+		if (std::abs(determinant) < 1e-6f)
+			return false;
+		for (uint32 c = 0; c < channels; ++c)
+		{
+			e0[c] = Clamp255((bb * ax[c] - ab * bx[c]) / determinant);
+			e1[c] = Clamp255((aa * bx[c] - ab * ax[c]) / determinant);
+		}
+		return true;
+	}
+
+	int Iterations(Quality quality)
+	{
+		return quality == Quality::Fast ? 0 : quality == Quality::Normal ? 1 : 4;
+	}
+
+	//
+	// BC1 (and the color half of BC3)
+	//
+
+	const float BC1Weights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+	struct BC1Block
+	{
+		uint16 Color0 = 0;
+		uint16 Color1 = 0;
+		uint8 Indices[16];
+		uint32 Distances[16];
+		uint32 Error = UINT_MAX;
+	};
+
+	uint16 Pack565(const float color[4])
+	{
+		const uint32 r = (uint32)(color[0] * 31.0f / 255.0f + 0.5f);
+		const uint32 g = (uint32)(color[1] * 63.0f / 255.0f + 0.5f);
+		const uint32 b = (uint32)(color[2] * 31.0f / 255.0f + 0.5f);
+		return (uint16)((r << 11) | (g << 5) | b);
+	}
+
+	void Unpack565(uint16 packed, int16 color[4])
+	{
+		const int r = (packed >> 11) & 31;
+		const int g = (packed >> 5) & 63;
+		const int b = packed & 31;
+		color[0] = (int16)((r << 3) | (r >> 2));
+		color[1] = (int16)((g << 2) | (g >> 4));
+		color[2] = (int16)((b << 3) | (b >> 2));
+		color[3] = 0;
+	}
+
+	// Always the four color mode, color0 > color1.  Equal endpoints mean the
+	// three color mode to a decoder, where only index 0 is safe to use.
+	void EvaluateBC1(const Texels& texels, const float e0[4], const float e1[4], BC1Block& block)
+	{
+		uint16 color0 = Pack565(e0);
+		uint16 color1 = Pack565(e1);
+		if (color0 < color1)
+			std::swap(color0, color1);
+
+		int16 palette[4][4] = {};
+		Unpack565(color0, palette[0]);
+		Unpack565(color1, palette[1]);
+		for (uint32 c = 0; c < 3; ++c)
+		{
+			palette[2][c] = (int16)((2 * palette[0][c] + palette[1][c] + 1) / 3);
+			palette[3][c] = (int16)((palette[0][c] + 2 * palette[1][c] + 1) / 3);
+		}
+
+		BC1Block candidate;
+		candidate.Color0 = color0;
+		candidate.Color1 = color1;
+		candidate.Error = SelectIndices(texels, palette, color0 == color1 ? 1 : 4, candidate.Indices, candidate.Distances);
+		if (candidate.Error < block.Error)
+			block = candidate;
+	}
+
+	BC1Block EncodeBC1(const Texels& texels, Quality quality)
+	{
+		float e0[4];
+		float e1[4];
+		FitPrincipalAxis(texels, 3, e0, e1);
+
+		BC1Block block;
+		EvaluateBC1(texels, e0, e1, block);
+		for (int i = 0; i < Iterations(quality); ++i)
+		{
+			int16 color0[4];
+			int16 color1[4];
+			Unpack565(block.Color0, color0);
+			Unpack565(block.Color1, color1);
+			for (uint32 c = 0; c < 4; ++c)
+			{
+				e0[c] = color0[c];
+				e1[c] = color1[c];
+			}
+			const uint32 error = block.Error;
+			if (!RefineEndpoints(texels, 3, block.Indices, BC1Weights, e0, e1))
+				break;
+			EvaluateBC1(texels, e0, e1, block);
+			if (block.Error >= error)
+				break;
+		}
+		return block;
+	}
+
+	void WriteBC1(const BC1Block& block, uint8* out)
+	{
+		uint32 indices = 0;
+		for (uint32 i = 0; i < 16; ++i)
+			indices |= (uint32)block.Indices[i] << (i * 2);
+		out[0] = (uint8)block.Color0;
+		out[1] = (uint8)(block.Color0 >> 8);
+		out[2] = (uint8)block.Color1;
+		out[3] = (uint8)(block.Color1 >> 8);
+		memcpy(out + 4, &indices, 4);
+	}
+
+	//
+	// BC4 (and BC5, and the alpha half of BC3)
+	//
+
+	const float BC4Weights[8] = { 0.0f, 1.0f, 1.0f / 7.0f, 2.0f / 7.0f, 3.0f / 7.0f, 4.0f / 7.0f, 5.0f / 7.0f, 6.0f / 7.0f };
+
+	struct BC4Block
+	{
+		uint8 Red0 = 0;
+		uint8 Red1 = 0;
+		uint8 Indices[16];
+		float Distances[16];
+		float Error = FLT_MAX;
+	};
+
+	// Nearest of the eight values for every texel of lane 0, like
+	// SelectIndices but in float.
+	float SelectBC4Indices(const Texels& texels, const float palette[8], uint8 indices[16], float distances[16])
+	{
+		float total = 0.0f;
+#ifdef BLOCKCOMPRESSOR_SSE2
+		for (uint32 group = 0; group < 16; group += 4)
+		{
+			const __m128 values = _mm_setr_ps(texels.Values[group][0], texels.Values[group + 1][0],
+				texels.Values[group + 2][0], texels.Values[group + 3][0]);
+			__m128 best = _mm_set1_ps(FLT_MAX);
+			__m128i bestIndex = _mm_setzero_si128();
+			for (uint32 p = 0; p < 8; ++p)
+			{
+				const __m128 d = _mm_sub_ps(values, _mm_set1_ps(palette[p]));
+				const __m128 distance = _mm_mul_ps(d, d);
+				const __m128i closer = _mm_castps_si128(_mm_cmplt_ps(distance, best));
+				best = _mm_min_ps(distance, best);
+				bestIndex = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32((int)p)), _mm_andnot_si128(closer, bestIndex));
+			}
+
+			uint32 bestIndices[4];
+			_mm_storeu_ps(distances + group, best);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(bestIndices), bestIndex);
+			for (uint32 i = 0; i < 4; ++i)
+			{
+				indices[group + i] = (uint8)bestIndices[i];
+				total += distances[group + i];
+			}
+		}
+#else
+		for (uint32 i = 0; i < 16; ++i)
+		{
+			float best = FLT_MAX;
+			for (uint32 p = 0; p < 8; ++p)
+			{
+				const float d = texels.Values[i][0] - palette[p];
+				if (d * d < best)
+				{
+					best = d * d;
+					indices[i] = (uint8)p;
+				}
+			}
+			distances[i] = best;
+			total += best;
+		}
+#endif
+		return total;
+	}
+
+	// red0 > red1 interpolates 6 values between them, otherwise 4 and adds
+	// 0 and 255.  The hardware interpolates in float and does not round to
+	// 8 bits, so neither does the palette the texels are measured against.
+	void EvaluateBC4(const Texels& texels, int red0, int red1, BC4Block& block)
+	{
+		float palette[8];
+		palette[0] = (float)red0;
+		palette[1] = (float)red1;
+		if (red0 > red1)
+		{
+			for (int i = 1; i < 7; ++i)
+				palette[i + 1] = ((7 - i) * red0 + i * red1) / 7.0f;
+		}
+		else
+		{
+			for (int i = 1; i < 5; ++i)
+				palette[i + 1] = ((5 - i) * red0 + i * red1) / 5.0f;
+			palette[6] = 0.0f;
+			palette[7] = 255.0f;
+		}
+
+		BC4Block candidate;
+		candidate.Red0 = (uint8)red0;
+		candidate.Red1 = (uint8)red1;
+		candidate.Error = SelectBC4Indices(texels, palette, candidate.Indices, candidate.Distances);
+		if (candidate.Error < block.Error)
+			block = candidate;
+	}
+
+	// texels holds the channel in lane 0.
+	BC4Block EncodeBC4(const Texels& texels, Quality quality)
+	{
+		int low = 255;
+		int high = 0;
+		// The same without 0 and 255, for the six value mode.
+		int innerLow = 255;
+		int innerHigh = 0;
+		for (uint32 i = 0; i < 16; ++i)
+		{
+			const int value = texels.Values[i][0];
+			low = std::min(low, value);
+			high = std::max(high, value);
+			if (value != 0 && value != 255)
+			{
+				innerLow = std::min(innerLow, value);
+				innerHigh = std::max(innerHigh, value);
+			}
+		}
+
+		BC4Block block;
+		EvaluateBC4(texels, high, low, block);
+		if (quality == Quality::Fast || block.Error == 0.0f)
+			return block;
+
+		if (innerLow <= innerHigh && (low == 0 || high == 255))
+			EvaluateBC4(texels, innerLow, innerHigh, block);
+
+		for (int i = 0; i < Iterations(quality) && block.Red0 > block.Red1; ++i)
+		{
+			float e0[4] = { (float)block.Red0 };
+			float e1[4] = { (float)block.Red1 };
+			const float error = block.Error;
+			if (!RefineEndpoints(texels, 1, block.Indices, BC4Weights, e0, e1))
+				break;
+			const int red0 = (int)(e0[0] + 0.5f);
+			const int red1 = (int)(e1[0] + 0.5f);
+			if (red0 > red1)
+				EvaluateBC4(texels, red0, red1, block);
+			if (block.Error >= error)
+				break;
+		}
+
+		if (quality == Quality::High)
+		{
+			const int red0 = block.Red0;
+			const int red1 = block.Red1;
+			for (int d0 = -3; d0 <= 3; ++d0)
+			{
+				for (int d1 = -3; d1 <= 3; ++d1)
+				{
+					const int a = std::min(255, std::max(0, red0 + d0));
+					const int b = std::min(255, std::max(0, red1 + d1));
+					if ((a > b) == (red0 > red1))
+						EvaluateBC4(texels, a, b, block);
+				}
+			}
+		}
+		return block;
+	}
+
+	void WriteBC4(const BC4Block& block, uint8* out)
+	{
+		uint64 indices = 0;
+		for (uint32 i = 0; i < 16; ++i)
+			indices |= (uint64)block.Indices[i] << (i * 3);
+		out[0] = block.Red0;
+		out[1] = block.Red1;
+		for (uint32 i = 0; i < 6; ++i)
+			out[2 + i] = (uint8)(indices >> (i * 8));
+	}
+
+	//
+	// BC7, mode 6
+	//
+
+	const int BC7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	struct BC7Block
+	{
+		// 7-bit endpoints and their p-bits.
+		uint8 Endpoints[2][4] = {};
+		uint8 PBits[2] = {};
+		uint8 Indices[16];
+		uint32 Distances[16];
+		uint32 Error = UINT_MAX;
+	};
+
+	void QuantizeBC7(const float endpoint[4], uint32 pbit, uint8 quantized[4])
+	{
+		for (uint32 c = 0; c < 4; ++c)
+			quantized[c] = (uint8)std::min(127, std::max(0, (int)((endpoint[c] - pbit) * 0.5f + 0.5f)));
+	}
+
+	// The p-bit that quantizes endpoint with the smaller error.
+	uint32 BestPBit(const float endpoint[4])
+	{
+		float errors[2] = {};
+		for (uint32 pbit = 0; pbit < 2; ++pbit)
+		{
+			uint8 quantized[4];
+			QuantizeBC7(endpoint, pbit, quantized);
+			for (uint32 c = 0; c < 4; ++c)
+			{
+				const float d = (quantized[c] * 2 + pbit) - endpoint[c];
+				errors[pbit] += d * d;
+			}
+		}
+		return errors[1] < errors[0] ? 1 : 0;
+	}
+
+	void EvaluateBC7(const Texels& texels, const float e0[4], const float e1[4], bool allPBits, BC7Block& block)
+	{
+		const uint32 bestPBit0 = BestPBit(e0);
+		const uint32 bestPBit1 = BestPBit(e1);
+		for (uint32 combination = 0; combination < 4; ++combination)
+		{
+			const uint32 pbit0 = combination & 1;
+			const uint32 pbit1 = combination >> 1;
+			if (!allPBits && (pbit0 != bestPBit0 || pbit1 != bestPBit1))
+				continue;
+
+			BC7Block candidate;
+			QuantizeBC7(e0, pbit0, candidate.Endpoints[0]);
+			QuantizeBC7(e1, pbit1, candidate.Endpoints[1]);
+			candidate.PBits[0] = (uint8)pbit0;
+			candidate.PBits[1] = (uint8)pbit1;
+
+			int16 palette[16][4];
+			for (uint32 c = 0; c < 4; ++c)
+			{
+				const int a = candidate.Endpoints[0][c] * 2 + pbit0;
+				const int b = candidate.Endpoints[1][c] * 2 + pbit1;
+				for (uint32 i = 0; i < 16; ++i)
+					palette[i][c] = (int16)(((64 - BC7Weights[i]) * a + BC7Weights[i] * b + 32) >> 6);
+			}
+
+			candidate.Error = SelectIndices(texels, palette, 16, candidate.Indices, candidate.Distances);
+			if (candidate.Error < block.Error)
+				block = candidate;
+		}
+	}
+
+	BC7Block EncodeBC7(const Texels& texels, Quality quality)
+	{
+		float weights[16];
+		for (uint32 i = 0; i < 16; ++i)
+			weights[i] = BC7Weights[i] / 64.0f;
+
+		float e0[4];
+		float e1[4];
+		FitPrincipalAxis(texels, 4, e0, e1);
+
+		const bool allPBits = quality == Quality::High;
+		BC7Block block;
+		EvaluateBC7(texels, e0, e1, allPBits, block);
+		for (int i = 0; i < Iterations(quality) && block.Error > 0; ++i)
+		{
+			for (uint32 c = 0; c < 4; ++c)
+			{
+				e0[c] = (float)(block.Endpoints[0][c] * 2 + block.PBits[0]);
+				e1[c] = (float)(block.Endpoints[1][c] * 2 + block.PBits[1]);
+			}
+			const uint32 error = block.Error;
+			if (!RefineEndpoints(texels, 4, block.Indices, weights, e0, e1))
+				break;
+			EvaluateBC7(texels, e0, e1, allPBits, block);
+			if (block.Error >= error)
+				break;
+		}
+		return block;
+	}
+
+	class BitWriter
+	{
+	public:
+		explicit BitWriter(uint8* out)
+			:
+			mOut(out)
+		{
+			memset(mOut, 0, 16);
+		}
+
+		void Write(uint32 value, uint32 count)
+		{
+			for (uint32 i = 0; i < count; ++i, ++mPosition)
+			{
+				if (value & (1u << i))
+					mOut[mPosition >> 3] |= (uint8)(1u << (mPosition & 7));
+			}
+		}
+
+	private:
+		uint8* mOut;
+		uint32 mPosition = 0;
+	};
+
+	void WriteBC7(BC7Block block, uint8* out)
+	{
+		// The top bit of the first index is implied 0, the endpoints swap
+		// places when it would be 1.  The weights are symmetric, so the
+		// colors stay the same.
+		if (block.Indices[0] & 8)
+		{
+			std::swap(block.Endpoints[0], block.Endpoints[1]);
+			std::swap(block.PBits[0], block.PBits[1]);
+			for (uint32 i = 0; i < 16; ++i)
+				block.Indices[i] = (uint8)(15 - block.Indices[i]);
+		}
+
+		BitWriter bits(out);
+		bits.Write(1u << 6, 7);
+		for (uint32 c = 0; c < 4; ++c)
+		{
+			bits.Write(block.Endpoints[0][c], 7);
+			bits.Write(block.Endpoints[1][c], 7);
+		}
+		bits.Write(block.PBits[0], 1);
+		bits.Write(block.PBits[1], 1);
+		bits.Write(block.Indices[0], 3);
+		for (uint32 i = 1; i < 16; ++i)
+			bits.Write(block.Indices[i], 4);
+	}
+
+	//
+	// Blocks
+	//
+
+	struct Source
+	{
+		const BlockCompressor::Surface* Data;
+		uint32 Width;
+		uint32 Height;
+		uint32 Channels;
+		bool Bgra;
+	};
+
+	// The texels of block (x, y), the edge repeated past the end of levels
+	// smaller than a block.  valid has a bit set for every texel inside.
+	void LoadBlock(const Source& source, uint32 x, uint32 y, Texels& texels, uint32& valid)
+	{
+		valid = 0;
+		for (uint32 i = 0; i < 16; ++i)
+		{
+			const uint32 tx = x * 4 + (i & 3);
+			const uint32 ty = y * 4 + (i >> 2);
+			if (tx < source.Width && ty < source.Height)
+				valid |= 1u << i;
+
+			const uint8* texel = static_cast<const uint8*>(source.Data->Data) +
+				std::min(ty, source.Height - 1) * source.Data->RowPitch + std::min(tx, source.Width - 1) * source.Channels;
+			int16* out = texels.Values[i];
+			if (source.Channels == 1)
+			{
+				out[0] = texel[0];
+				out[1] = out[2] = 0;
+				out[3] = 255;
+			}
+			else
+			{
+				out[0] = texel[source.Bgra ? 2 : 0];
+				out[1] = texel[1];
+				out[2] = texel[source.Bgra ? 0 : 2];
+				out[3] = texel[3];
+			}
+		}
+	}
+
+	// Channel of texels in lane 0, the rest 0.
+	Texels Channel(const Texels& texels, uint32 channel)
+	{
+		Texels result = {};
+		for (uint32 i = 0; i < 16; ++i)
+			result.Values[i][0] = texels.Values[i][channel];
+		return result;
+	}
+
+	template<typename TDistance>
+	double ValidError(const TDistance distances[16], uint32 valid)
+	{
+		double error = 0.0;
+		for (uint32 i = 0; i < 16; ++i)
+		{
+			if (valid & (1u << i))
+				error += distances[i];
+		}
+		return error;
+	}
+
+	// Writes one block, returns its squared error over the texels inside.
+	double EncodeBlock(Kind kind, Quality quality, const Texels& texels, uint32 valid, uint8* out)
+	{
+		switch (kind)
+		{
+		case Kind::BC1:
+		{
+			Texels color = texels;
+			for (uint32 i = 0; i < 16; ++i)
+				color.Values[i][3] = 0;
+			const BC1Block block = EncodeBC1(color, quality);
+			WriteBC1(block, out);
+			return ValidError(block.Distances, valid);
+		}
+		case Kind::BC3:
+		{
+			const BC4Block alpha = EncodeBC4(Channel(texels, 3), quality);
+			WriteBC4(alpha, out);
+			Texels color = texels;
+			for (uint32 i = 0; i < 16; ++i)
+				color.Values[i][3] = 0;
+			const BC1Block block = EncodeBC1(color, quality);
+			WriteBC1(block, out + 8);
+			return ValidError(alpha.Distances, valid) + ValidError(block.Distances, valid);
+		}
+		case Kind::BC4:
+		{
+			const BC4Block block = EncodeBC4(Channel(texels, 0), quality);
+			WriteBC4(block, out);
+			return ValidError(block.Distances, valid);
+		}
+		case Kind::BC5:
+		{
+			const BC4Block red = EncodeBC4(Channel(texels, 0), quality);
+			const BC4Block green = EncodeBC4(Channel(texels, 1), quality);
+			WriteBC4(red, out);
+			WriteBC4(green, out + 8);
+			return ValidError(red.Distances, valid) + ValidError(green.Distances, valid);
+		}
+		case Kind::BC7:
+		{
+			const BC7Block block = EncodeBC7(texels, quality);
+			WriteBC7(block, out);
+			return ValidError(block.Distances, valid);
+		}
+		default:
+			return 0;
+		}
+	}
+
+	uint32 ChannelsKept(Kind kind)
+	{
+		switch (kind)
+		{
+		case Kind::BC1: return 3;
+		case Kind::BC4: return 1;
+		case Kind::BC5: return 2;
+		default: return 4;
+		}
+	}
+}
+
+std::string BlockCompressor::Report::ToString() const
+{
+	static const char* qualities[] = { "fast", "normal", "high" };
+	const double megatexels = Blocks * 16.0 / 1e6;
+	char buffer[256];
+	snprintf(buffer, sizeof(buffer),
+		"[BlockCompressor] %s %s: %ux%u, %u subresources, %u blocks in %.1f ms (%.1f Mtexel/s), PSNR %.2f dB\n",
+		FormatName(Format), qualities[(int)Level], Width, Height, Subresources, Blocks, Milliseconds,
+		Milliseconds > 0.0 ? megatexels / (Milliseconds / 1000.0) : 0.0, Psnr);
+	return buffer;
+}
+
+BlockCompressor::uint32 BlockCompressor::GetBlockBytes(Format format)
+{
+	switch (format)
+	{
+	case Format::BC1_TYPELESS: case Format::BC1_UNORM: case Format::BC1_UNORM_SRGB:
+	case Format::BC4_TYPELESS: case Format::BC4_UNORM: case Format::BC4_SNORM:
+		return 8;
+	case Format::BC2_TYPELESS: case Format::BC2_UNORM: case Format::BC2_UNORM_SRGB:
+	case Format::BC3_TYPELESS: case Format::BC3_UNORM: case Format::BC3_UNORM_SRGB:
+	case Format::BC5_TYPELESS: case Format::BC5_UNORM: case Format::BC5_SNORM:
+	case Format::BC6H_TYPELESS: case Format::BC6H_UF16: case Format::BC6H_SF16:
+	case Format::BC7_TYPELESS: case Format::BC7_UNORM: case Format::BC7_UNORM_SRGB:
+		return 16;
+	default:
+		return 0;
+	}
+}
+
+bool BlockCompressor::Compress(
+	Format format,
+	uint32 width,
+	uint32 height,
+	uint32 mipLevels,
+	const std::vector<Surface>& surfaces,
+	const Options& options,
+	std::vector<uint8_t>& storage,
+	std::vector<Surface>& compressed,
+	Report& report)
+{
+	const Kind kind = GetKind(options.Format);
+	if (kind == Kind::None || width % 4 != 0 || height % 4 != 0 || mipLevels == 0 || surfaces.size() % mipLevels != 0)
+		return false;
+
+	Source source = {};
+	bool srgb = false;
+	switch (format)
+	{
+	case Format::R8G8B8A8_UNORM_SRGB:
+		srgb = true;
+		// fall through
+	case Format::R8G8B8A8_UNORM:
+		source.Channels = 4;
+		break;
+	case Format::B8G8R8A8_UNORM_SRGB:
+		srgb = true;
+		// fall through
+	case Format::B8G8R8A8_UNORM:
+		source.Channels = 4;
+		source.Bgra = true;
+		break;
+	case Format::R8_UNORM:
+		if (kind != Kind::BC4)
+			return false;
+		source.Channels = 1;
+		break;
+	default:
+		return false;
+	}
+
+	Format target = options.Format;
+	switch (kind)
+	{
+	case Kind::BC1: target = srgb ? Format::BC1_UNORM_SRGB : Format::BC1_UNORM; break;
+	case Kind::BC3: target = srgb ? Format::BC3_UNORM_SRGB : Format::BC3_UNORM; break;
+	case Kind::BC4: target = Format::BC4_UNORM; break;
+	case Kind::BC5: target = Format::BC5_UNORM; break;
+	default: target = srgb ? Format::BC7_UNORM_SRGB : Format::BC7_UNORM; break;
+	}
+	const uint32 blockBytes = GetBlockBytes(target);
+
+	// Lay the blocks out first, then cut the work into rows of blocks.
+	struct Job
+	{
+		uint32 Subresource;
+		uint32 FirstRow;
+		uint32 EndRow;
+	};
+	std::vector<Job> jobs;
+	std::vector<size_t> offsets(surfaces.size());
+	compressed.resize(surfaces.size());
+	size_t byteSize = 0;
+	uint32 blockCount = 0;
+	for (uint32 s = 0; s < (uint32)surfaces.size(); ++s)
+	{
+		const uint32 mip = s % mipLevels;
+		const uint32 blocksX = (std::max(1u, width >> mip) + 3) / 4;
+		const uint32 blocksY = (std::max(1u, height >> mip) + 3) / 4;
+		compressed[s].RowPitch = (uint64)blocksX * blockBytes;
+		compressed[s].SlicePitch = compressed[s].RowPitch * blocksY;
+		offsets[s] = byteSize;
+		byteSize += (size_t)compressed[s].SlicePitch;
+		blockCount += blocksX * blocksY;
+		for (uint32 row = 0; row < blocksY; row += BlockRowsPerJob)
+			jobs.push_back({ s, row, std::min(blocksY, row + BlockRowsPerJob) });
+	}
+	storage.resize(byteSize);
+	for (size_t s = 0; s < surfaces.size(); ++s)
+		compressed[s].Data = storage.data() + offsets[s];
+
+	const auto start = std::chrono::steady_clock::now();
+	std::vector<double> errors(jobs.size());
+	const uint32 threadCount = options.ThreadCount ? options.ThreadCount : std::max(1u, std::thread::hardware_concurrency());
+	WorkerPool::ParallelFor((uint32)jobs.size(), threadCount, [&](uint32 j)
+	{
+		const Job& job = jobs[j];
+		const uint32 mip = job.Subresource % mipLevels;
+		Source level = source;
+		level.Data = &surfaces[job.Subresource];
+		level.Width = std::max(1u, width >> mip);
+		level.Height = std::max(1u, height >> mip);
+		const uint32 blocksX = (level.Width + 3) / 4;
+		uint8* out = storage.data() + offsets[job.Subresource];
+
+		double error = 0.0;
+		for (uint32 y = job.FirstRow; y < job.EndRow; ++y)
+		{
+			for (uint32 x = 0; x < blocksX; ++x)
+			{
+				Texels texels;
+				uint32 valid;
+				LoadBlock(level, x, y, texels, valid);
+				error += EncodeBlock(kind, options.Level, texels, valid, out + (size_t)y * compressed[job.Subresource].RowPitch + x * blockBytes);
+			}
+		}
+		errors[j] = error;
+	});
+	const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+	double error = 0.0;
+	uint64 samples = 0;
+	for (double e : errors)
+		error += e;
+	for (uint32 s = 0; s < (uint32)surfaces.size(); ++s)
+	{
+		const uint32 mip = s % mipLevels;
+		samples += (uint64)std::max(1u, width >> mip) * std::max(1u, height >> mip) * ChannelsKept(kind);
+	}
+
+	report.Format = target;
+	report.Level = options.Level;
+	report.Width = width;
+	report.Height = height;
+	report.Subresources = (uint32)surfaces.size();
+	report.Blocks = blockCount;
+	report.Milliseconds = elapsed.count();
+	const double mse = error / samples;
+	report.Psnr = mse > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / mse) : 99.0;
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,82 @@
+#pragma once
+#include "DdsFile.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Encodes 8-bit textures to BC1, BC3, BC4, BC5 or BC7 at import time, so
+// they take a quarter to an eighth of the memory and bandwidth on the GPU.
+//
+// Endpoints are fit along the principal axis of every 4x4 block and then
+// refined by least squares, more often at higher quality.  BC7 is written
+// in mode 6 (one subset, RGBA, 4-bit indices) only.  Index selection runs
+// on SSE2, block rows on several threads.  Every block is measured against
+// its source while it is encoded, for the PSNR of the report.
+//
+// Formats and levels are DdsFile's, D3D12Util converts them to D3D12.
+class BlockCompressor
+{
+public:
+	using uint32 = std::uint32_t;
+	using Format = DdsFile::Format;
+	using Surface = DdsFile::Surface;
+
+	enum class Quality
+	{
+		// Principal axis only.
+		Fast,
+		// One least squares refinement.
+		Normal,
+		// Several refinements, a search around the BC4 endpoints and every
+		// BC7 p-bit combination.
+		High,
+	};
+
+	struct Options
+	{
+		// BC1, BC3, BC4, BC5 or BC7 (either UNORM variant, the sRGB-ness
+		// comes from the source).  UNKNOWN leaves the texture uncompressed.
+		BlockCompressor::Format Format = BlockCompressor::Format::UNKNOWN;
+		Quality Level = Quality::Normal;
+		// 0 uses one thread per hardware thread.
+		uint32 ThreadCount = 0;
+	};
+
+	struct Report
+	{
+		BlockCompressor::Format Format = BlockCompressor::Format::UNKNOWN;
+		Quality Level = Quality::Normal;
+		uint32 Width = 0;
+		uint32 Height = 0;
+		uint32 Subresources = 0;
+		uint32 Blocks = 0;
+		double Milliseconds = 0.0;
+		// Over the channels the format keeps, of every subresource.
+		double Psnr = 0.0;
+
+		std::string ToString() const;
+	};
+
+	///<summary>
+	/// Bytes per 4x4 block of a BC format, 0 for other formats.
+	///</summary>
+	static uint32 GetBlockBytes(Format format);
+
+	///<summary>
+	/// Encodes surfaces (mipLevels per array slice, as MipGenerator leaves
+	/// them) of an R8G8B8A8 or B8G8R8A8 texture, or an R8 one to BC4.
+	/// The blocks go to storage, compressed points into it.  Returns false
+	/// when the formats do not fit or the top level is not a multiple of 4
+	/// in size, which D3D12 requires of BC textures.
+	///</summary>
+	static bool Compress(
+		Format format,
+		uint32 width,
+		uint32 height,
+		uint32 mipLevels,
+		const std::vector<Surface>& surfaces,
+		const Options& options,
+		std::vector<uint8_t>& storage,
+		std::vector<Surface>& compressed,
+		Report& report);
+};
\ No newline at end of file
@@ -0,0 +1,352 @@
+#include "BoundsFitter.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+
+using namespace DirectX;
+
+namespace
+{
+	// Float sums are flushed into doubles every block, which keeps the mean
+	// and covariance of large meshes accurate without giving up the vector adds.
+	const size_t SumBlockSize = 1024;
+
+	const int JacobiSweeps = 16;
+
+	XMVECTOR LoadPosition(const unsigned char* positions, size_t positionByteStride, size_t v)
+	{
+		return XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(positions + v * positionByteStride));
+	}
+
+	void ComputeMinMax(const unsigned char* positions, size_t vertexCount, size_t positionByteStride, XMVECTOR& minimum, XMVECTOR& maximum)
+	{
+		// Four independent chains so the min/max latencies overlap.
+		XMVECTOR min0 = XMVectorReplicate(FLT_MAX), min1 = min0, min2 = min0, min3 = min0;
+		XMVECTOR max0 = XMVectorReplicate(-FLT_MAX), max1 = max0, max2 = max0, max3 = max0;
+
+		size_t v = 0;
+		for (; v + 4 <= vertexCount; v += 4)
+		{
+			XMVECTOR p0 = LoadPosition(positions, positionByteStride, v);
+			XMVECTOR p1 = LoadPosition(positions, positionByteStride, v + 1);
+			XMVECTOR p2 = LoadPosition(positions, positionByteStride, v + 2);
+			XMVECTOR p3 = LoadPosition(positions, positionByteStride, v + 3);
+			min0 = XMVectorMin(min0, p0); max0 = XMVectorMax(max0, p0);
+			min1 = XMVectorMin(min1, p1); max1 = XMVectorMax(max1, p1);
+			min2 = XMVectorMin(min2, p2); max2 = XMVectorMax(max2, p2);
+			min3 = XMVectorMin(min3, p3); max3 = XMVectorMax(max3, p3);
+		}
+		for (; v < vertexCount; ++v)
+		{
+			XMVECTOR p = LoadPosition(positions, positionByteStride, v);
+			min0 = XMVectorMin(min0, p);
+			max0 = XMVectorMax(max0, p);
+		}
+
+		minimum = XMVectorMin(XMVectorMin(min0, min1), XMVectorMin(min2, min3));
+		maximum = XMVectorMax(XMVectorMax(max0, max1), XMVectorMax(max2, max3));
+	}
+
+	BoundingBox BoxFromMinMax(FXMVECTOR minimum, FXMVECTOR maximum)
+	{
+		BoundingBox box;
+		XMStoreFloat3(&box.Center, 0.5f * (minimum + maximum));
+		XMStoreFloat3(&box.Extents, 0.5f * (maximum - minimum));
+		return box;
+	}
+
+	BoundingBox FitBox(const unsigned char* positions, size_t vertexCount, size_t positionByteStride)
+	{
+		if (vertexCount == 0)
+			return BoundingBox(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 0.0f));
+
+		XMVECTOR minimum, maximum;
+		ComputeMinMax(positions, vertexCount, positionByteStride, minimum, maximum);
+		return BoxFromMinMax(minimum, maximum);
+	}
+
+	BoundingSphere FitSphere(const unsigned char* positions, size_t vertexCount, size_t positionByteStride)
+	{
+		if (vertexCount == 0)
+			return BoundingSphere(XMFLOAT3(0.0f, 0.0f, 0.0f), 0.0f);
+
+		// Points with the smallest and largest coordinate on each axis.
+		size_t minIndex[3] = { 0, 0, 0 };
+		size_t maxIndex[3] = { 0, 0, 0 };
+		const float* first = reinterpret_cast<const float*>(positions);
+		float minValue[3] = { first[0], first[1], first[2] };
+		float maxValue[3] = { first[0], first[1], first[2] };
+		for (size_t v = 1; v < vertexCount; ++v)
+		{
+			const float* p = reinterpret_cast<const float*>(positions + v * positionByteStride);
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				if (p[axis] < minValue[axis]) { minValue[axis] = p[axis]; minIndex[axis] = v; }
+				if (p[axis] > maxValue[axis]) { maxValue[axis] = p[axis]; maxIndex[axis] = v; }
+			}
+		}
+
+		// Start with the pair that lies furthest apart.
+		XMVECTOR a = LoadPosition(positions, positionByteStride, minIndex[0]);
+		XMVECTOR b = LoadPosition(positions, positionByteStride, maxIndex[0]);
+		float bestDistanceSq = XMVectorGetX(XMVector3LengthSq(b - a));
+		for (int axis = 1; axis < 3; ++axis)
+		{
+			XMVECTOR pa = LoadPosition(positions, positionByteStride, minIndex[axis]);
+			XMVECTOR pb = LoadPosition(positions, positionByteStride, maxIndex[axis]);
+			float distanceSq = XMVectorGetX(XMVector3LengthSq(pb - pa));
+			if (distanceSq > bestDistanceSq)
+			{
+				bestDistanceSq = distanceSq;
+				a = pa;
+				b = pb;
+			}
+		}
+
+		XMVECTOR center = 0.5f * (a + b);
+		float radius = 0.5f * sqrtf(bestDistanceSq);
+
+		// Each point outside moves the sphere towards it just enough to
+		// touch it with the far side still in place.
+		for (size_t v = 0; v < vertexCount; ++v)
+		{
+			XMVECTOR p = LoadPosition(positions, positionByteStride, v);
+			XMVECTOR offset = p - center;
+			float distanceSq = XMVectorGetX(XMVector3LengthSq(offset));
+			if (distanceSq <= radius * radius)
+				continue;
+
+			float distance = sqrtf(distanceSq);
+			float newRadius = 0.5f * (radius + distance);
+			center += ((newRadius - radius) / distance) * offset;
+			radius = newRadius;
+		}
+
+		BoundingSphere sphere;
+		XMStoreFloat3(&sphere.Center, center);
+		// Rounding in the center update can leave the touching points a hair outside.
+		sphere.Radius = radius * (1.0f + 1e-5f);
+		return sphere;
+	}
+
+	// Eigenvectors of a symmetric 3x3 matrix by cyclic Jacobi rotations.  The
+	// columns of vectors receive the eigenvectors, a is destroyed.
+	void JacobiEigenvectors(double a[3][3], double vectors[3][3])
+	{
+		for (int i = 0; i < 3; ++i)
+			for (int j = 0; j < 3; ++j)
+				vectors[i][j] = i == j ? 1.0 : 0.0;
+
+		const int pairs[3][2] = { { 0, 1 }, { 0, 2 }, { 1, 2 } };
+		for (int sweep = 0; sweep < JacobiSweeps; ++sweep)
+		{
+			double offDiagonal = a[0][1] * a[0][1] + a[0][2] * a[0][2] + a[1][2] * a[1][2];
+			double diagonal = a[0][0] * a[0][0] + a[1][1] * a[1][1] + a[2][2] * a[2][2];
+			if (offDiagonal <= 1e-24 * diagonal)
+				break;
+
+			for (const auto& pair : pairs)
+			{
+				const int p = pair[0];
+				const int q = pair[1];
+				if (a[p][q] == 0.0)
+					continue;
+
+				double theta = (a[q][q] - a[p][p]) / (2.0 * a[p][q]);
+				double t = (theta >= 0.0 ? 1.0 : -1.0) / (fabs(theta) + sqrt(theta * theta + 1.0));
+				double c = 1.0 / sqrt(t * t + 1.0);
+				double s = t * c;
+
+				for (int k = 0; k < 3; ++k)
+				{
+					double akp = a[k][p];
+					double akq = a[k][q];
+					a[k][p] = c * akp - s * akq;
+					a[k][q] = s * akp + c * akq;
+				}
+				for (int k = 0; k < 3; ++k)
+				{
+					double apk = a[p][k];
+					double aqk = a[q][k];
+					a[p][k] = c * apk - s * aqk;
+					a[q][k] = s * apk + c * aqk;
+				}
+				for (int k = 0; k < 3; ++k)
+				{
+					double vkp = vectors[k][p];
+					double vkq = vectors[k][q];
+					vectors[k][p] = c * vkp - s * vkq;
+					vectors[k][q] = s * vkp + c * vkq;
+				}
+			}
+		}
+	}
+
+	XMVECTOR SumPositions(const unsigned char* positions, size_t vertexCount, size_t positionByteStride)
+	{
+		double sum[3] = { 0.0, 0.0, 0.0 };
+		for (size_t block = 0; block < vertexCount; block += SumBlockSize)
+		{
+			const size_t end = std::min(block + SumBlockSize, vertexCount);
+			XMVECTOR sum0 = XMVectorZero(), sum1 = sum0;
+			size_t v = block;
+			for (; v + 2 <= end; v += 2)
+			{
+				sum0 += LoadPosition(positions, positionByteStride, v);
+				sum1 += LoadPosition(positions, positionByteStride, v + 1);
+			}
+			if (v < end)
+				sum0 += LoadPosition(positions, positionByteStride, v);
+
+			XMFLOAT3 partial;
+			XMStoreFloat3(&partial, sum0 + sum1);
+			sum[0] += partial.x;
+			sum[1] += partial.y;
+			sum[2] += partial.z;
+		}
+
+		const double scale = 1.0 / vertexCount;
+		return XMVectorSet((float)(sum[0] * scale), (float)(sum[1] * scale), (float)(sum[2] * scale), 0.0f);
+	}
+
+	BoundingOrientedBox FitOrientedBox(const unsigned char* positions, size_t vertexCount, size_t positionByteStride, const BoundingBox& box)
+	{
+		BoundingOrientedBox aligned;
+		aligned.Center = box.Center;
+		aligned.Extents = box.Extents;
+		aligned.Orientation = XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f);
+		if (vertexCount < 3)
+			return aligned;
+
+		XMVECTOR mean = SumPositions(positions, vertexCount, positionByteStride);
+
+		// Covariance: the squares (xx, yy, zz) in one vector and the mixed
+		// terms (xy, yz, zx) in another.
+		double squares[3] = { 0.0, 0.0, 0.0 };
+		double products[3] = { 0.0, 0.0, 0.0 };
+		for (size_t block = 0; block < vertexCount; block += SumBlockSize)
+		{
+			const size_t end = std::min(block + SumBlockSize, vertexCount);
+			XMVECTOR squareSum = XMVectorZero();
+			XMVECTOR productSum = XMVectorZero();
+			for (size_t v = block; v < end; ++v)
+			{
+				XMVECTOR d = LoadPosition(positions, positionByteStride, v) - mean;
+				squareSum = XMVectorMultiplyAdd(d, d, squareSum);
+				productSum = XMVectorMultiplyAdd(d, XMVectorSwizzle<XM_SWIZZLE_Y, XM_SWIZZLE_Z, XM_SWIZZLE_X, XM_SWIZZLE_W>(d), productSum);
+			}
+
+			XMFLOAT3 s, p;
+			XMStoreFloat3(&s, squareSum);
+			XMStoreFloat3(&p, productSum);
+			squares[0] += s.x; squares[1] += s.y; squares[2] += s.z;
+			products[0] += p.x; products[1] += p.y; products[2] += p.z;
+		}
+
+		double covariance[3][3] =
+		{
+			{ squares[0], products[0], products[2] },
+			{ products[0], squares[1], products[1] },
+			{ products[2], products[1], squares[2] },
+		};
+		double vectors[3][3];
+		JacobiEigenvectors(covariance, vectors);
+
+		XMVECTOR axis0 = XMVector3Normalize(XMVectorSet((float)vectors[0][0], (float)vectors[1][0], (float)vectors[2][0], 0.0f));
+		XMVECTOR axis1 = XMVector3Normalize(XMVectorSet((float)vectors[0][1], (float)vectors[1][1], (float)vectors[2][1], 0.0f));
+		// Re-derive the third axis so the basis is orthonormal and right handed.
+		XMVECTOR axis2 = XMVector3Normalize(XMVector3Cross(axis0, axis1));
+		axis1 = XMVector3Cross(axis2, axis0);
+
+		// Rows are the box axes, so this rotates from box to object space and
+		// its transpose projects object space positions onto the axes.
+		XMMATRIX rotation(axis0, axis1, axis2, g_XMIdentityR3);
+		XMMATRIX project = XMMatrixTranspose(rotation);
+
+		XMVECTOR min0 = XMVectorReplicate(FLT_MAX), min1 = min0;
+		XMVECTOR max0 = XMVectorReplicate(-FLT_MAX), max1 = max0;
+		size_t v = 0;
+		for (; v + 2 <= vertexCount; v += 2)
+		{
+			XMVECTOR p0 = XMVector3TransformNormal(LoadPosition(positions, positionByteStride, v), project);
+			XMVECTOR p1 = XMVector3TransformNormal(LoadPosition(positions, positionByteStride, v + 1), project);
+			min0 = XMVectorMin(min0, p0); max0 = XMVectorMax(max0, p0);
+			min1 = XMVectorMin(min1, p1); max1 = XMVectorMax(max1, p1);
+		}
+		if (v < vertexCount)
+		{
+			XMVECTOR p = XMVector3TransformNormal(LoadPosition(positions, positionByteStride, v), project);
+			min0 = XMVectorMin(min0, p);
+			max0 = XMVectorMax(max0, p);
+		}
+		XMVECTOR minimum = XMVectorMin(min0, min1);
+		XMVECTOR maximum = XMVectorMax(max0, max1);
+
+		XMVECTOR extents = 0.5f * (maximum - minimum);
+		XMFLOAT3 e;
+		XMStoreFloat3(&e, extents);
+		if (e.x * e.y * e.z >= box.Extents.x * box.Extents.y * box.Extents.z)
+			return aligned;
+
+		BoundingOrientedBox oriented;
+		XMStoreFloat3(&oriented.Center, XMVector3TransformNormal(0.5f * (minimum + maximum), rotation));
+		oriented.Extents = e;
+		XMStoreFloat4(&oriented.Orientation, XMQuaternionNormalize(XMQuaternionRotationMatrix(rotation)));
+		return oriented;
+	}
+}
+
+BoundingBox BoundsFitter::ComputeBox(const float* positions, size_t vertexCount, size_t positionByteStride)
+{
+	return FitBox(reinterpret_cast<const unsigned char*>(positions), vertexCount, positionByteStride);
+}
+
+BoundingSphere BoundsFitter::ComputeSphere(const float* positions, size_t vertexCount, size_t positionByteStride)
+{
+	return FitSphere(reinterpret_cast<const unsigned char*>(positions), vertexCount, positionByteStride);
+}
+
+BoundingOrientedBox BoundsFitter::ComputeOrientedBox(const float* positions, size_t vertexCount, size_t positionByteStride)
+{
+	const unsigned char* bytes = reinterpret_cast<const unsigned char*>(positions);
+	return FitOrientedBox(bytes, vertexCount, positionByteStride, FitBox(bytes, vertexCount, positionByteStride));
+}
+
+MeshBounds BoundsFitter::Compute(const float* positions, size_t vertexCount, size_t positionByteStride)
+{
+	const unsigned char* bytes = reinterpret_cast<const unsigned char*>(positions);
+
+	MeshBounds bounds;
+	bounds.Box = FitBox(bytes, vertexCount, positionByteStride);
+	bounds.Sphere = FitSphere(bytes, vertexCount, positionByteStride);
+	bounds.OrientedBox = FitOrientedBox(bytes, vertexCount, positionByteStride, bounds.Box);
+	return bounds;
+}
+
+void BoundsFitter::ComputeMinMax(PrimitiveTypes::MeshData& mesh)
+{
+	BoundingBox box = mesh.Vertices.empty() ?
+		ComputeBox(nullptr, 0, sizeof(PrimitiveTypes::Vertex)) :
+		ComputeBox(&mesh.Vertices[0].Position.x, mesh.Vertices.size(), sizeof(PrimitiveTypes::Vertex));
+
+	XMVECTOR center = XMLoadFloat3(&box.Center);
+	XMVECTOR extents = XMLoadFloat3(&box.Extents);
+	XMStoreFloat3(&mesh.Min, center - extents);
+	XMStoreFloat3(&mesh.Max, center + extents);
+}
+
+std::string BoundsFitter::ToString(const std::string& name, const MeshBounds& bounds)
+{
+	const XMFLOAT3& e = bounds.Box.Extents;
+	const XMFLOAT3& o = bounds.OrientedBox.Extents;
+	const float r = bounds.Sphere.Radius;
+
+	char buffer[256];
+	snprintf(buffer, sizeof(buffer),
+		"[BoundsFitter] %s: box %.3g x %.3g x %.3g, sphere radius %.3g, oriented box %.3g x %.3g x %.3g (%.0f%% of the box volume)\n",
+		name.c_str(), 2.0f * e.x, 2.0f * e.y, 2.0f * e.z, r, 2.0f * o.x, 2.0f * o.y, 2.0f * o.z,
+		e.x * e.y * e.z > 0.0f ? 100.0 * o.x * o.y * o.z / (e.x * e.y * e.z) : 100.0);
+
+	return buffer;
+}
\ No newline at end of file
@@ -0,0 +1,59 @@
+#pragma once
+#include <DirectXCollision.h>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "PrimitiveTypes.h"
+
+// The three bounding volumes fitted to one set of points.
+struct MeshBounds
+{
+	DirectX::BoundingBox Box;
+	DirectX::BoundingSphere Sphere;
+	DirectX::BoundingOrientedBox OrientedBox;
+};
+
+// Fits bounding volumes to vertex positions.  positions points at the first
+// position (3 floats) and positionByteStride is the vertex stride, so the
+// vertex data can be passed as is.
+//
+// The reductions go through DirectXMath vectors with several independent
+// accumulators, the position loads being the only scalar part.
+class BoundsFitter
+{
+public:
+	///<summary>
+	/// Tight axis aligned box.  Empty input gives a zero sized box at the origin.
+	///</summary>
+	static DirectX::BoundingBox ComputeBox(const float* positions, size_t vertexCount, size_t positionByteStride);
+
+	///<summary>
+	/// Ritter's sphere: starts from the most distant pair of axis extreme
+	/// points and grows to take in every point outside, at most a few percent
+	/// larger than the minimal sphere for typical meshes.
+	///</summary>
+	static DirectX::BoundingSphere ComputeSphere(const float* positions, size_t vertexCount, size_t positionByteStride);
+
+	///<summary>
+	/// Box along the principal axes of the point covariance.  Falls back to
+	/// the axis aligned box when that one is smaller.
+	///</summary>
+	static DirectX::BoundingOrientedBox ComputeOrientedBox(const float* positions, size_t vertexCount, size_t positionByteStride);
+
+	static MeshBounds Compute(const float* positions, size_t vertexCount, size_t positionByteStride);
+
+	template<typename TVertex>
+	static MeshBounds Compute(const std::vector<TVertex>& vertices)
+	{
+		if (vertices.empty())
+			return Compute(nullptr, 0, sizeof(TVertex));
+		return Compute(&vertices[0].Position.x, vertices.size(), sizeof(TVertex));
+	}
+
+	///<summary>
+	/// Fills MeshData::Min and Max from its vertices.
+	///</summary>
+	static void ComputeMinMax(PrimitiveTypes::MeshData& mesh);
+
+	static std::string ToString(const std::string& name, const MeshBounds& bounds);
+};
\ No newline at end of file
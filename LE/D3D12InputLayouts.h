@@ -12,4 +12,7 @@ public:
 	static const D3D12_INPUT_ELEMENT_DESC inputLayoutPosNorCol[3];
 	static const D3D12_INPUT_ELEMENT_DESC inputLayoutPosTexNorCol[4];
 	static const D3D12_INPUT_ELEMENT_DESC inputLayoutPosNorTanTexCol[5];
+	static const D3D12_INPUT_ELEMENT_DESC inputLayoutQuantPosTexNorCol[4];
+	static const D3D12_INPUT_ELEMENT_DESC inputLayoutHalfPosTexNorCol[4];
+	static const D3D12_INPUT_ELEMENT_DESC inputLayoutQuantPosNorTanTexCol[5];
 };
\ No newline at end of file
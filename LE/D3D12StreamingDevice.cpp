@@ -0,0 +1,101 @@
+#include "D3D12StreamingDevice.h"
+
+using Microsoft::WRL::ComPtr;
+
+D3D12StreamingDevice::D3D12StreamingDevice(ID3D12Device* device, AssetDatabase& assets, const AssetDatabase::TextureOptions& textureOptions)
+	:
+	mDevice(device),
+	mAssets(assets),
+	mTextureOptions(textureOptions)
+{
+	D3D12_COMMAND_QUEUE_DESC queueDesc = {};
+	queueDesc.Type = D3D12_COMMAND_LIST_TYPE_COPY;
+	queueDesc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
+	ThrowIfFailed(mDevice->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(mQueue.GetAddressOf())));
+	ThrowIfFailed(mDevice->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(mFence.GetAddressOf())));
+}
+
+D3D12StreamingDevice::~D3D12StreamingDevice()
+{
+	WaitForFence(mFenceValue);
+}
+
+std::unique_ptr<AssetStreamer::Payload> D3D12StreamingDevice::Decode(const std::string& filename)
+{
+	auto payload = std::make_unique<TexturePayload>();
+	// The levels go with the payload, the OnResident callback may keep them.
+	payload->Texture.KeepSource = true;
+	mAssets.DecodeTexture(mDevice.Get(), AnsiToWString(filename).c_str(), payload->Texture, mTextureOptions);
+	if (!payload->Texture.Shared)
+		payload->UploadBytes = GetRequiredIntermediateSize(payload->Texture.Resource.Get(), 0, (UINT)payload->Texture.Subresources.size());
+	return std::move(payload);
+}
+
+void D3D12StreamingDevice::RecordUpload(AssetStreamer::Payload& payload)
+{
+	if (mRecording == nullptr)
+	{
+		// The oldest allocator is free once its submit is done.
+		if (!mAllocators.empty() && mAllocators.front().first <= mFence->GetCompletedValue())
+		{
+			mRecording = mAllocators.front().second;
+			mAllocators.pop_front();
+			ThrowIfFailed(mRecording->Reset());
+		}
+		else
+		{
+			ThrowIfFailed(mDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY, IID_PPV_ARGS(mRecording.GetAddressOf())));
+		}
+
+		if (mCommandList == nullptr)
+		{
+			ThrowIfFailed(mDevice->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_COPY, mRecording.Get(), nullptr,
+				IID_PPV_ARGS(mCommandList.GetAddressOf())));
+		}
+		else
+		{
+			ThrowIfFailed(mCommandList->Reset(mRecording.Get(), nullptr));
+		}
+	}
+
+	TexturePayload& texture = static_cast<TexturePayload&>(payload);
+	mAssets.UploadTexture(mDevice.Get(), mCommandList.Get(), texture.Texture,
+		texture.Resource.GetAddressOf(), texture.Upload.GetAddressOf(), D3D12_RESOURCE_STATE_COPY_DEST);
+}
+
+AssetStreamer::uint64 D3D12StreamingDevice::Submit()
+{
+	if (mRecording == nullptr)
+		return mFenceValue;
+
+	ThrowIfFailed(mCommandList->Close());
+	ID3D12CommandList* cmdsLists[] = { mCommandList.Get() };
+	mQueue->ExecuteCommandLists(_countof(cmdsLists), cmdsLists);
+	ThrowIfFailed(mQueue->Signal(mFence.Get(), ++mFenceValue));
+
+	mAllocators.emplace_back(mFenceValue, mRecording);
+	mRecording = nullptr;
+	return mFenceValue;
+}
+
+AssetStreamer::uint64 D3D12StreamingDevice::GetCompletedFence()
+{
+	return mFence->GetCompletedValue();
+}
+
+void D3D12StreamingDevice::WaitForFence(AssetStreamer::uint64 fence)
+{
+	if (mFence->GetCompletedValue() >= fence)
+		return;
+
+	HANDLE eventHandle = CreateEventEx(nullptr, nullptr, FALSE, EVENT_ALL_ACCESS);
+	ThrowIfFailed(mFence->SetEventOnCompletion(fence, eventHandle));
+	WaitForSingleObject(eventHandle, INFINITE);
+	CloseHandle(eventHandle);
+}
+
+void D3D12StreamingDevice::MakeResident(AssetStreamer::Payload& payload)
+{
+	TexturePayload& texture = static_cast<TexturePayload&>(payload);
+	texture.Upload = nullptr;
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+#include "AssetDatabase.h"
+#include "AssetStreamer.h"
+#include <deque>
+
+// AssetStreamer's device on D3D12: textures are decoded through the
+// AssetDatabase and uploaded on a copy queue of their own, so the uploads
+// run next to the frames on the direct queue.
+//
+// Copy queues cannot transition to shader states.  The textures are left in
+// COPY_DEST, decay to COMMON when their upload is done and are promoted to
+// a shader resource state by their first use on the direct queue.
+class D3D12StreamingDevice : public AssetStreamer::Device
+{
+public:
+	struct TexturePayload : AssetStreamer::Payload
+	{
+		AssetDatabase::DecodedTexture Texture;
+		Microsoft::WRL::ComPtr<ID3D12Resource> Resource;
+		Microsoft::WRL::ComPtr<ID3D12Resource> Upload;
+	};
+
+	D3D12StreamingDevice(ID3D12Device* device, AssetDatabase& assets, const AssetDatabase::TextureOptions& textureOptions);
+	D3D12StreamingDevice(const D3D12StreamingDevice& rhs) = delete;
+	D3D12StreamingDevice& operator=(const D3D12StreamingDevice& rhs) = delete;
+	~D3D12StreamingDevice();
+
+	std::unique_ptr<AssetStreamer::Payload> Decode(const std::string& filename) override;
+	void RecordUpload(AssetStreamer::Payload& payload) override;
+	AssetStreamer::uint64 Submit() override;
+	AssetStreamer::uint64 GetCompletedFence() override;
+	void WaitForFence(AssetStreamer::uint64 fence) override;
+	void MakeResident(AssetStreamer::Payload& payload) override;
+
+private:
+	Microsoft::WRL::ComPtr<ID3D12Device> mDevice;
+	AssetDatabase& mAssets;
+	AssetDatabase::TextureOptions mTextureOptions;
+
+	Microsoft::WRL::ComPtr<ID3D12CommandQueue> mQueue;
+	Microsoft::WRL::ComPtr<ID3D12Fence> mFence;
+	UINT64 mFenceValue = 0;
+	Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> mCommandList;
+	// Allocators of earlier submits, with the fence value they are free at.
+	std::deque<std::pair<UINT64, Microsoft::WRL::ComPtr<ID3D12CommandAllocator>>> mAllocators;
+	// The allocator mCommandList records into, nullptr between submits.
+	Microsoft::WRL::ComPtr<ID3D12CommandAllocator> mRecording;
+};
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "D3D12Util.h"
+#include "DdsFile.h"
 #include <comdef.h>
 #include <fstream>
 
@@ -111,3 +112,187 @@ ComPtr<ID3DBlob> D3D12Util::CompileShader(const std::wstring& filename, const D3
 
 	return byteCode;
 }
+
+DXGI_FORMAT D3D12Util::GetDxgiFormat(ImageDecoder::PixelFormat format)
+{
+	switch (format)
+	{
+	case ImageDecoder::PixelFormat::R8: return DXGI_FORMAT_R8_UNORM;
+	case ImageDecoder::PixelFormat::R16: return DXGI_FORMAT_R16_UNORM;
+	case ImageDecoder::PixelFormat::Rgba8: return DXGI_FORMAT_R8G8B8A8_UNORM;
+	case ImageDecoder::PixelFormat::Rgba8Srgb: return DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+	case ImageDecoder::PixelFormat::Bgra8: return DXGI_FORMAT_B8G8R8A8_UNORM;
+	case ImageDecoder::PixelFormat::Bgra8Srgb: return DXGI_FORMAT_B8G8R8A8_UNORM_SRGB;
+	case ImageDecoder::PixelFormat::Rgba16: return DXGI_FORMAT_R16G16B16A16_UNORM;
+	default: return DXGI_FORMAT_UNKNOWN;
+	}
+}
+
+D3D12_RESOURCE_DESC D3D12Util::GetDdsDesc(const DdsFile& dds)
+{
+	// DdsFile keeps the DXGI and D3D12 values, so they cast.
+	static_assert((UINT)DdsFile::Format::BC7_UNORM == DXGI_FORMAT_BC7_UNORM, "DdsFile::Format values");
+	static_assert((UINT)DdsFile::Format::B4G4R4A4_UNORM == DXGI_FORMAT_B4G4R4A4_UNORM, "DdsFile::Format values");
+	static_assert((UINT)DdsFile::Dimension::Texture3D == D3D12_RESOURCE_DIMENSION_TEXTURE3D, "DdsFile::Dimension values");
+
+	const D3D12_RESOURCE_DIMENSION dimension = (D3D12_RESOURCE_DIMENSION)dds.GetDimension();
+
+	D3D12_RESOURCE_DESC desc = {};
+	desc.Dimension = dimension;
+	desc.Width = dds.GetWidth();
+	desc.Height = dds.GetHeight();
+	desc.DepthOrArraySize = (UINT16)(dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D ? dds.GetDepth() : dds.GetArraySize());
+	desc.MipLevels = (UINT16)dds.GetMipLevels();
+	desc.Format = (DXGI_FORMAT)dds.GetFormat();
+	desc.SampleDesc.Count = 1;
+	desc.SampleDesc.Quality = 0;
+	desc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+	desc.Flags = D3D12_RESOURCE_FLAG_NONE;
+	return desc;
+}
+
+std::vector<D3D12_SUBRESOURCE_DATA> D3D12Util::GetDdsSubresources(const DdsFile& dds)
+{
+	return GetSubresources(dds.GetSurfaces());
+}
+
+std::vector<D3D12_SUBRESOURCE_DATA> D3D12Util::GetSubresources(const std::vector<DdsFile::Surface>& surfaces)
+{
+	std::vector<D3D12_SUBRESOURCE_DATA> subresources;
+	subresources.reserve(surfaces.size());
+	for (const DdsFile::Surface& surface : surfaces)
+		subresources.push_back({ surface.Data, (LONG_PTR)surface.RowPitch, (LONG_PTR)surface.SlicePitch });
+	return subresources;
+}
+
+std::vector<DdsFile::Surface> D3D12Util::GetSurfaces(const std::vector<D3D12_SUBRESOURCE_DATA>& subresources)
+{
+	std::vector<DdsFile::Surface> surfaces(subresources.size());
+	for (size_t i = 0; i < subresources.size(); ++i)
+	{
+		surfaces[i].Data = subresources[i].pData;
+		surfaces[i].RowPitch = (DdsFile::uint64)subresources[i].RowPitch;
+		surfaces[i].SlicePitch = (DdsFile::uint64)subresources[i].SlicePitch;
+	}
+	return surfaces;
+}
+
+void D3D12Util::LoadDDSTexture(
+	ID3D12Device* device,
+	ID3D12GraphicsCommandList* commandList,
+	const wchar_t* filename,
+	ID3D12Resource** ppResource,
+	ID3D12Resource** ppUpload)
+{
+	// The subresources point into the mapping, or into ddsData for the
+	// formats DdsFile does not read.
+	DdsFile dds;
+	std::unique_ptr<uint8_t[]> ddsData;
+	std::vector<D3D12_SUBRESOURCE_DATA> subresources;
+	if (dds.Open(WideToAnsi(filename)))
+	{
+		const D3D12_RESOURCE_DESC desc = GetDdsDesc(dds);
+		ThrowIfFailed(device->CreateCommittedResource(
+			&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+			D3D12_HEAP_FLAG_NONE,
+			&desc,
+			D3D12_RESOURCE_STATE_COPY_DEST,
+			nullptr,
+			IID_PPV_ARGS(ppResource)));
+		subresources = GetDdsSubresources(dds);
+	}
+	else
+	{
+		ThrowIfFailed(DirectX::LoadDDSTextureFromFile(device, filename, ppResource, ddsData, subresources));
+	}
+
+	const UINT64 uploadBufferSize = GetRequiredIntermediateSize(*ppResource, 0, static_cast<UINT>(subresources.size()));
+
+	// Create the GPU upload buffer.
+	ThrowIfFailed(
+		device->CreateCommittedResource(
+			&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+			D3D12_HEAP_FLAG_NONE,
+			&CD3DX12_RESOURCE_DESC::Buffer(uploadBufferSize),
+			D3D12_RESOURCE_STATE_GENERIC_READ,
+			nullptr,
+			IID_PPV_ARGS(ppUpload)));
+
+	UpdateSubresources(commandList, *ppResource, *ppUpload, 0, 0, static_cast<UINT>(subresources.size()), subresources.data());
+	commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(*ppResource, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE));
+}
+
+void D3D12Util::LoadWICTexture(
+	ID3D12Device* device,
+	ID3D12GraphicsCommandList* commandList,
+	const wchar_t* filename,
+	ID3D12Resource** ppResource,
+	ID3D12Resource** ppUpload)
+{
+	// Images WIC would have to shrink go to WIC.
+	MappedFile file;
+	ImageDecoder::Info info;
+	if (file.Open(WideToAnsi(filename)) && ImageDecoder::ReadInfo(file.GetData(), file.GetSize(), info) &&
+		info.Width <= D3D12_REQ_TEXTURE2D_U_OR_V_DIMENSION && info.Height <= D3D12_REQ_TEXTURE2D_U_OR_V_DIMENSION)
+	{
+		const D3D12_RESOURCE_DESC desc = CD3DX12_RESOURCE_DESC::Tex2D(GetDxgiFormat(info.Format), info.Width, info.Height, 1, 1);
+		D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint;
+		UINT64 uploadBufferSize = 0;
+		device->GetCopyableFootprints(&desc, 0, 1, 0, &footprint, nullptr, nullptr, &uploadBufferSize);
+
+		ThrowIfFailed(
+			device->CreateCommittedResource(
+				&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+				D3D12_HEAP_FLAG_NONE,
+				&CD3DX12_RESOURCE_DESC::Buffer(uploadBufferSize),
+				D3D12_RESOURCE_STATE_GENERIC_READ,
+				nullptr,
+				IID_PPV_ARGS(ppUpload)));
+
+		// The rows are decoded in their final layout, there is no
+		// intermediate copy of the image.
+		void* mapped = nullptr;
+		ThrowIfFailed((*ppUpload)->Map(0, &CD3DX12_RANGE(0, 0), &mapped));
+		const bool decoded = ImageDecoder::Decode(file.GetData(), file.GetSize(),
+			static_cast<uint8_t*>(mapped) + footprint.Offset, footprint.Footprint.RowPitch);
+		(*ppUpload)->Unmap(0, nullptr);
+
+		if (decoded)
+		{
+			ThrowIfFailed(device->CreateCommittedResource(
+				&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+				D3D12_HEAP_FLAG_NONE,
+				&desc,
+				D3D12_RESOURCE_STATE_COPY_DEST,
+				nullptr,
+				IID_PPV_ARGS(ppResource)));
+
+			commandList->CopyTextureRegion(&CD3DX12_TEXTURE_COPY_LOCATION(*ppResource, 0), 0, 0, 0,
+				&CD3DX12_TEXTURE_COPY_LOCATION(*ppUpload, footprint), nullptr);
+			commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(*ppResource, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE));
+			return;
+		}
+
+		(*ppUpload)->Release();
+		*ppUpload = nullptr;
+	}
+
+	std::unique_ptr<uint8_t[]> decodedData;
+	D3D12_SUBRESOURCE_DATA subresource;
+	ThrowIfFailed(DirectX::LoadWICTextureFromFile(device, filename, ppResource, decodedData, subresource));
+
+	const UINT64 uploadBufferSize = GetRequiredIntermediateSize(*ppResource, 0, 1);
+
+	// Create the GPU upload buffer.
+	ThrowIfFailed(
+		device->CreateCommittedResource(
+			&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+			D3D12_HEAP_FLAG_NONE,
+			&CD3DX12_RESOURCE_DESC::Buffer(uploadBufferSize),
+			D3D12_RESOURCE_STATE_GENERIC_READ,
+			nullptr,
+			IID_PPV_ARGS(ppUpload)));
+
+	UpdateSubresources(commandList, *ppResource, *ppUpload, 0, 0, 1, &subresource);
+	commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(*ppResource, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE));
+}
\ No newline at end of file
@@ -21,6 +21,8 @@
 #include "d3dx12.h"
 #include "DDSTextureLoader12.h"
 #include "WICTextureLoader12.h"
+#include "DdsFile.h"
+#include "ImageDecoder.h"
 
 const int gNumFrameResources = 3;
 
@@ -46,6 +48,13 @@ inline std::wstring AnsiToWString(const std::string& str)
 	return std::wstring(buffer);
 }
 
+inline std::string WideToAnsi(const std::wstring& str)
+{
+	char buffer[512];
+	WideCharToMultiByte(CP_ACP, 0, str.c_str(), -1, buffer, 512, nullptr, nullptr);
+	return std::string(buffer);
+}
+
 class DxException
 {
 public:
@@ -197,6 +206,29 @@ public:
 		const std::string& entrypoint,
 		const std::string& target);
 
+	///<summary>
+	/// Desc of a resource that fits dds, to be created in the COPY_DEST state
+	/// and filled from GetDdsSubresources.
+	///</summary>
+	static D3D12_RESOURCE_DESC GetDdsDesc(const DdsFile& dds);
+
+	///<summary>
+	/// The surfaces of dds, pointing into its mapping.
+	///</summary>
+	static std::vector<D3D12_SUBRESOURCE_DATA> GetDdsSubresources(const DdsFile& dds);
+
+	///<summary>
+	/// Surfaces as subresources and back, for the texture code that works
+	/// on DdsFile's (MipGenerator, BlockCompressor).
+	///</summary>
+	static std::vector<D3D12_SUBRESOURCE_DATA> GetSubresources(const std::vector<DdsFile::Surface>& surfaces);
+	static std::vector<DdsFile::Surface> GetSurfaces(const std::vector<D3D12_SUBRESOURCE_DATA>& subresources);
+
+	///<summary>
+	/// The DXGI format of the pixels ImageDecoder writes.
+	///</summary>
+	static DXGI_FORMAT GetDxgiFormat(ImageDecoder::PixelFormat format);
+
 	static inline void LoadTexture(
 		ID3D12Device* device,
 		ID3D12GraphicsCommandList* commandList,
@@ -217,58 +249,20 @@ public:
 
 private:
 
-	static inline void LoadDDSTexture(
+	// Maps the file and uploads straight from the mapping, see DdsFile.
+	static void LoadDDSTexture(
 		ID3D12Device* device,
 		ID3D12GraphicsCommandList* commandList,
 		const wchar_t* filename,
 		ID3D12Resource** ppResource,
-		ID3D12Resource** ppUpload,
-		D3D12_SRV_DIMENSION srvDimension = D3D12_SRV_DIMENSION_TEXTURE2D)
-	{
-		std::unique_ptr<uint8_t[]> ddsData;
-		std::vector<D3D12_SUBRESOURCE_DATA> subresources;
-		ThrowIfFailed(DirectX::LoadDDSTextureFromFile(device, filename, ppResource, ddsData, subresources));
-
-		const UINT64 uploadBufferSize = GetRequiredIntermediateSize(*ppResource, 0, static_cast<UINT>(subresources.size()));
+		ID3D12Resource** ppUpload);
 
-		// Create the GPU upload buffer.
-		ThrowIfFailed(
-			device->CreateCommittedResource(
-				&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
-				D3D12_HEAP_FLAG_NONE,
-				&CD3DX12_RESOURCE_DESC::Buffer(uploadBufferSize),
-				D3D12_RESOURCE_STATE_GENERIC_READ,
-				nullptr,
-				IID_PPV_ARGS(ppUpload)));
-
-		UpdateSubresources(commandList, *ppResource, *ppUpload, 0, 0, static_cast<UINT>(subresources.size()), subresources.data());
-		commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(*ppResource, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE));
-	}
-
-	static inline void LoadWICTexture(
+	// Decodes PNG, JPEG and TGA into the upload buffer with ImageDecoder and
+	// leaves the rest to WIC.
+	static void LoadWICTexture(
 		ID3D12Device* device,
 		ID3D12GraphicsCommandList* commandList,
 		const wchar_t* filename,
 		ID3D12Resource** ppResource,
-		ID3D12Resource** ppUpload)
-	{
-		std::unique_ptr<uint8_t[]> decodedData;
-		D3D12_SUBRESOURCE_DATA subresource;
-		ThrowIfFailed(DirectX::LoadWICTextureFromFile(device, filename, ppResource, decodedData, subresource));
-
-		const UINT64 uploadBufferSize = GetRequiredIntermediateSize(*ppResource, 0, 1);
-
-		// Create the GPU upload buffer.
-		ThrowIfFailed(
-			device->CreateCommittedResource(
-				&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
-				D3D12_HEAP_FLAG_NONE,
-				&CD3DX12_RESOURCE_DESC::Buffer(uploadBufferSize),
-				D3D12_RESOURCE_STATE_GENERIC_READ,
-				nullptr,
-				IID_PPV_ARGS(ppUpload)));
-
-		UpdateSubresources(commandList, *ppResource, *ppUpload, 0, 0, 1, &subresource);
-		commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(*ppResource, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE));
-	}
+		ID3D12Resource** ppUpload);
 };
\ No newline at end of file
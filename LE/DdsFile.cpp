@@ -0,0 +1,456 @@
+#include "DdsFile.h"
+
+#include <algorithm>
+
+namespace
+{
+	using uint32 = DdsFile::uint32;
+	using uint64 = DdsFile::uint64;
+	using Format = DdsFile::Format;
+	using Dimension = DdsFile::Dimension;
+
+	const uint32 DdsMagic = 0x20534444; // "DDS "
+
+	// Pixel format flags.
+	const uint32 DdpfAlpha = 0x2;
+	const uint32 DdpfFourCC = 0x4;
+	const uint32 DdpfRgb = 0x40;
+	const uint32 DdpfLuminance = 0x20000;
+
+	// Header flags and caps.
+	const uint32 DdsdDepth = 0x800000;
+	const uint32 Caps2CubeMap = 0x200;
+	const uint32 Caps2CubeMapAllFaces = 0xFC00;
+	const uint32 Caps2Volume = 0x200000;
+
+	// DX10 header misc flag.
+	const uint32 MiscTextureCube = 0x4;
+
+	// What a D3D12 resource can hold.
+	const uint32 MaxMipLevels = 15;
+	const uint32 MaxArraySize = UINT16_MAX;
+
+	struct DdsPixelFormat
+	{
+		uint32 Size;
+		uint32 Flags;
+		uint32 FourCC;
+		uint32 RgbBitCount;
+		uint32 RBitMask;
+		uint32 GBitMask;
+		uint32 BBitMask;
+		uint32 ABitMask;
+	};
+
+	struct DdsHeader
+	{
+		uint32 Size;
+		uint32 Flags;
+		uint32 Height;
+		uint32 Width;
+		uint32 PitchOrLinearSize;
+		uint32 Depth;
+		uint32 MipMapCount;
+		uint32 Reserved1[11];
+		DdsPixelFormat PixelFormat;
+		uint32 Caps;
+		uint32 Caps2;
+		uint32 Caps3;
+		uint32 Caps4;
+		uint32 Reserved2;
+	};
+
+	struct DdsHeaderDx10
+	{
+		uint32 Format;
+		uint32 ResourceDimension;
+		uint32 MiscFlag;
+		uint32 ArraySize;
+		uint32 MiscFlags2;
+	};
+
+	static_assert(sizeof(DdsPixelFormat) == 32, "DDS pixel format size");
+	static_assert(sizeof(DdsHeader) == 124, "DDS header size");
+	static_assert(sizeof(DdsHeaderDx10) == 20, "DDS DX10 header size");
+
+	constexpr uint32 FourCC(char a, char b, char c, char d)
+	{
+		return (uint32)(unsigned char)a | ((uint32)(unsigned char)b << 8) |
+			((uint32)(unsigned char)c << 16) | ((uint32)(unsigned char)d << 24);
+	}
+
+	bool HasMasks(const DdsPixelFormat& pf, uint32 r, uint32 g, uint32 b, uint32 a)
+	{
+		return pf.RBitMask == r && pf.GBitMask == g && pf.BBitMask == b && pf.ABitMask == a;
+	}
+
+	Format GetLegacyFormat(const DdsPixelFormat& pf)
+	{
+		if (pf.Flags & DdpfFourCC)
+		{
+			switch (pf.FourCC)
+			{
+			case FourCC('D', 'X', 'T', '1'): return Format::BC1_UNORM;
+			case FourCC('D', 'X', 'T', '2'):
+			case FourCC('D', 'X', 'T', '3'): return Format::BC2_UNORM;
+			case FourCC('D', 'X', 'T', '4'):
+			case FourCC('D', 'X', 'T', '5'): return Format::BC3_UNORM;
+			case FourCC('A', 'T', 'I', '1'):
+			case FourCC('B', 'C', '4', 'U'): return Format::BC4_UNORM;
+			case FourCC('B', 'C', '4', 'S'): return Format::BC4_SNORM;
+			case FourCC('A', 'T', 'I', '2'):
+			case FourCC('B', 'C', '5', 'U'): return Format::BC5_UNORM;
+			case FourCC('B', 'C', '5', 'S'): return Format::BC5_SNORM;
+			// D3DFORMAT values written as FourCC.
+			case 36: return Format::R16G16B16A16_UNORM;
+			case 110: return Format::R16G16B16A16_SNORM;
+			case 111: return Format::R16_FLOAT;
+			case 112: return Format::R16G16_FLOAT;
+			case 113: return Format::R16G16B16A16_FLOAT;
+			case 114: return Format::R32_FLOAT;
+			case 115: return Format::R32G32_FLOAT;
+			case 116: return Format::R32G32B32A32_FLOAT;
+			default: return Format::UNKNOWN;
+			}
+		}
+
+		if (pf.Flags & DdpfRgb)
+		{
+			if (pf.RgbBitCount == 32)
+			{
+				if (HasMasks(pf, 0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000))
+					return Format::R8G8B8A8_UNORM;
+				if (HasMasks(pf, 0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000))
+					return Format::B8G8R8A8_UNORM;
+				if (HasMasks(pf, 0x00ff0000, 0x0000ff00, 0x000000ff, 0))
+					return Format::B8G8R8X8_UNORM;
+				if (HasMasks(pf, 0x0000ffff, 0xffff0000, 0, 0))
+					return Format::R16G16_UNORM;
+				if (HasMasks(pf, 0xffffffff, 0, 0, 0))
+					return Format::R32_FLOAT;
+			}
+			else if (pf.RgbBitCount == 16)
+			{
+				if (HasMasks(pf, 0xf800, 0x07e0, 0x001f, 0))
+					return Format::B5G6R5_UNORM;
+				if (HasMasks(pf, 0x7c00, 0x03e0, 0x001f, 0x8000))
+					return Format::B5G5R5A1_UNORM;
+				if (HasMasks(pf, 0x0f00, 0x00f0, 0x000f, 0xf000))
+					return Format::B4G4R4A4_UNORM;
+			}
+			return Format::UNKNOWN;
+		}
+
+		if (pf.Flags & DdpfLuminance)
+		{
+			if (pf.RgbBitCount == 8 && HasMasks(pf, 0xff, 0, 0, 0))
+				return Format::R8_UNORM;
+			if (pf.RgbBitCount == 16 && HasMasks(pf, 0xffff, 0, 0, 0))
+				return Format::R16_UNORM;
+			if (pf.RgbBitCount == 16 && HasMasks(pf, 0xff, 0, 0, 0xff00))
+				return Format::R8G8_UNORM;
+			return Format::UNKNOWN;
+		}
+
+		if ((pf.Flags & DdpfAlpha) && pf.RgbBitCount == 8)
+			return Format::A8_UNORM;
+
+		return Format::UNKNOWN;
+	}
+
+	// Bytes per 4x4 block of a block compressed format, 0 for other formats.
+	uint32 GetBlockBytes(Format format)
+	{
+		switch (format)
+		{
+		case Format::BC1_TYPELESS:
+		case Format::BC1_UNORM:
+		case Format::BC1_UNORM_SRGB:
+		case Format::BC4_TYPELESS:
+		case Format::BC4_UNORM:
+		case Format::BC4_SNORM:
+			return 8;
+
+		case Format::BC2_TYPELESS:
+		case Format::BC2_UNORM:
+		case Format::BC2_UNORM_SRGB:
+		case Format::BC3_TYPELESS:
+		case Format::BC3_UNORM:
+		case Format::BC3_UNORM_SRGB:
+		case Format::BC5_TYPELESS:
+		case Format::BC5_UNORM:
+		case Format::BC5_SNORM:
+		case Format::BC6H_TYPELESS:
+		case Format::BC6H_UF16:
+		case Format::BC6H_SF16:
+		case Format::BC7_TYPELESS:
+		case Format::BC7_UNORM:
+		case Format::BC7_UNORM_SRGB:
+			return 16;
+
+		default:
+			return 0;
+		}
+	}
+
+	// Bits per pixel of an uncompressed format, 0 for the ones not handled
+	// (block compressed, packed YUV and video formats).
+	uint32 GetBitsPerPixel(Format format)
+	{
+		switch (format)
+		{
+		case Format::R32G32B32A32_TYPELESS:
+		case Format::R32G32B32A32_FLOAT:
+		case Format::R32G32B32A32_UINT:
+		case Format::R32G32B32A32_SINT:
+			return 128;
+
+		case Format::R32G32B32_TYPELESS:
+		case Format::R32G32B32_FLOAT:
+		case Format::R32G32B32_UINT:
+		case Format::R32G32B32_SINT:
+			return 96;
+
+		case Format::R16G16B16A16_TYPELESS:
+		case Format::R16G16B16A16_FLOAT:
+		case Format::R16G16B16A16_UNORM:
+		case Format::R16G16B16A16_UINT:
+		case Format::R16G16B16A16_SNORM:
+		case Format::R16G16B16A16_SINT:
+		case Format::R32G32_TYPELESS:
+		case Format::R32G32_FLOAT:
+		case Format::R32G32_UINT:
+		case Format::R32G32_SINT:
+			return 64;
+
+		case Format::R10G10B10A2_TYPELESS:
+		case Format::R10G10B10A2_UNORM:
+		case Format::R10G10B10A2_UINT:
+		case Format::R11G11B10_FLOAT:
+		case Format::R8G8B8A8_TYPELESS:
+		case Format::R8G8B8A8_UNORM:
+		case Format::R8G8B8A8_UNORM_SRGB:
+		case Format::R8G8B8A8_UINT:
+		case Format::R8G8B8A8_SNORM:
+		case Format::R8G8B8A8_SINT:
+		case Format::R16G16_TYPELESS:
+		case Format::R16G16_FLOAT:
+		case Format::R16G16_UNORM:
+		case Format::R16G16_UINT:
+		case Format::R16G16_SNORM:
+		case Format::R16G16_SINT:
+		case Format::R32_TYPELESS:
+		case Format::D32_FLOAT:
+		case Format::R32_FLOAT:
+		case Format::R32_UINT:
+		case Format::R32_SINT:
+		case Format::R24G8_TYPELESS:
+		case Format::D24_UNORM_S8_UINT:
+		case Format::R9G9B9E5_SHAREDEXP:
+		case Format::B8G8R8A8_UNORM:
+		case Format::B8G8R8X8_UNORM:
+		case Format::B8G8R8A8_TYPELESS:
+		case Format::B8G8R8A8_UNORM_SRGB:
+		case Format::B8G8R8X8_TYPELESS:
+		case Format::B8G8R8X8_UNORM_SRGB:
+			return 32;
+
+		case Format::R8G8_TYPELESS:
+		case Format::R8G8_UNORM:
+		case Format::R8G8_UINT:
+		case Format::R8G8_SNORM:
+		case Format::R8G8_SINT:
+		case Format::R16_TYPELESS:
+		case Format::R16_FLOAT:
+		case Format::D16_UNORM:
+		case Format::R16_UNORM:
+		case Format::R16_UINT:
+		case Format::R16_SNORM:
+		case Format::R16_SINT:
+		case Format::B5G6R5_UNORM:
+		case Format::B5G5R5A1_UNORM:
+		case Format::B4G4R4A4_UNORM:
+			return 16;
+
+		case Format::R8_TYPELESS:
+		case Format::R8_UNORM:
+		case Format::R8_UINT:
+		case Format::R8_SNORM:
+		case Format::R8_SINT:
+		case Format::A8_UNORM:
+			return 8;
+
+		default:
+			return 0;
+		}
+	}
+}
+
+bool DdsFile::GetSurfaceInfo(uint64 width, uint32 height, Format format, uint64& rowBytes, uint32& rowCount)
+{
+	if (uint32 blockBytes = GetBlockBytes(format))
+	{
+		rowBytes = std::max<uint64>(1, (width + 3) / 4) * blockBytes;
+		rowCount = std::max<uint32>(1, (height + 3) / 4);
+		return true;
+	}
+
+	if (uint32 bitsPerPixel = GetBitsPerPixel(format))
+	{
+		rowBytes = (width * bitsPerPixel + 7) / 8;
+		rowCount = height;
+		return true;
+	}
+
+	return false;
+}
+
+bool DdsFile::Open(const std::string& filename)
+{
+	Close();
+
+	if (!mFile.Open(filename) || !Parse(mFile.GetData(), mFile.GetSize()))
+	{
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+void DdsFile::Close()
+{
+	mFile.Close();
+	mDimension = Dimension::Texture2D;
+	mFormat = Format::UNKNOWN;
+	mWidth = 0;
+	mHeight = 0;
+	mDepth = 0;
+	mArraySize = 0;
+	mMipLevels = 0;
+	mCubeMap = false;
+	mSurfaces.clear();
+}
+
+bool DdsFile::Parse(const void* data, size_t byteSize)
+{
+	mSurfaces.clear();
+
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	size_t offset = sizeof(uint32) + sizeof(DdsHeader);
+	if (byteSize < offset || *reinterpret_cast<const uint32*>(bytes) != DdsMagic)
+		return false;
+
+	const DdsHeader& header = *reinterpret_cast<const DdsHeader*>(bytes + sizeof(uint32));
+	if (header.Size != sizeof(DdsHeader) || header.PixelFormat.Size != sizeof(DdsPixelFormat))
+		return false;
+
+	Dimension dimension = Dimension::Texture2D;
+	Format format = Format::UNKNOWN;
+	uint32 width = header.Width;
+	uint32 height = header.Height;
+	uint32 depth = 1;
+	uint32 arraySize = 1;
+	const uint32 mipCount = std::max<uint32>(1, header.MipMapCount);
+	bool cubeMap = false;
+
+	if ((header.PixelFormat.Flags & DdpfFourCC) && header.PixelFormat.FourCC == FourCC('D', 'X', '1', '0'))
+	{
+		if (byteSize < offset + sizeof(DdsHeaderDx10))
+			return false;
+		const DdsHeaderDx10& dx10 = *reinterpret_cast<const DdsHeaderDx10*>(bytes + offset);
+		offset += sizeof(DdsHeaderDx10);
+
+		format = (Format)dx10.Format;
+		arraySize = dx10.ArraySize;
+		dimension = (Dimension)dx10.ResourceDimension;
+		switch (dimension)
+		{
+		case Dimension::Texture1D:
+			height = 1;
+			break;
+		case Dimension::Texture2D:
+			if (dx10.MiscFlag & MiscTextureCube)
+			{
+				// Checked before it is multiplied, a large count would wrap.
+				if (arraySize > MaxArraySize / 6)
+					return false;
+				arraySize *= 6;
+				cubeMap = true;
+			}
+			break;
+		case Dimension::Texture3D:
+			if (!(header.Flags & DdsdDepth) || arraySize != 1)
+				return false;
+			depth = header.Depth;
+			break;
+		default:
+			return false;
+		}
+	}
+	else
+	{
+		format = GetLegacyFormat(header.PixelFormat);
+		if (header.Caps2 & Caps2Volume)
+		{
+			dimension = Dimension::Texture3D;
+			depth = header.Depth;
+		}
+		else if (header.Caps2 & Caps2CubeMap)
+		{
+			// D3D12 has no partial cube maps.
+			if ((header.Caps2 & Caps2CubeMapAllFaces) != Caps2CubeMapAllFaces)
+				return false;
+			arraySize = 6;
+			cubeMap = true;
+		}
+	}
+
+	uint64 rowBytes = 0;
+	uint32 rowCount = 0;
+	if (width == 0 || height == 0 || depth == 0 || arraySize == 0 || arraySize > MaxArraySize || depth > UINT16_MAX ||
+		mipCount > MaxMipLevels || !GetSurfaceInfo(1, 1, format, rowBytes, rowCount))
+		return false;
+
+	// Array slices one after the other, each with its mip chain.  The slices
+	// of a volume are one after the other within each mip.
+	mSurfaces.reserve((size_t)arraySize * mipCount);
+	for (uint32 slice = 0; slice < arraySize; ++slice)
+	{
+		uint64 w = width;
+		uint32 h = height;
+		uint32 d = depth;
+		for (uint32 mip = 0; mip < mipCount; ++mip)
+		{
+			GetSurfaceInfo(w, h, format, rowBytes, rowCount);
+			const uint64 sliceBytes = rowBytes * rowCount;
+			const uint64 mipBytes = sliceBytes * d;
+			if (mipBytes > byteSize - offset)
+			{
+				mSurfaces.clear();
+				return false;
+			}
+
+			Surface surface;
+			surface.Data = bytes + offset;
+			surface.RowPitch = rowBytes;
+			surface.SlicePitch = sliceBytes;
+			mSurfaces.push_back(surface);
+			offset += (size_t)mipBytes;
+
+			w = std::max<uint64>(1, w / 2);
+			h = std::max<uint32>(1, h / 2);
+			d = std::max<uint32>(1, d / 2);
+		}
+	}
+
+	mDimension = dimension;
+	mFormat = format;
+	mWidth = width;
+	mHeight = height;
+	mDepth = depth;
+	mArraySize = dimension == Dimension::Texture3D ? 1 : arraySize;
+	mMipLevels = mipCount;
+	mCubeMap = cubeMap;
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,225 @@
+#pragma once
+#include "MappedFile.h"
+#include <cstdint>
+#include <vector>
+
+// A .dds file mapped into memory and parsed in place.  GetSurfaces point
+// straight into the mapping, so an upload copies from the file's pages into
+// the upload heap and nothing is read into a buffer of its own first.
+//
+// Reads 1D, 2D and 3D textures, arrays and cube maps with a DX10 header, and
+// legacy headers in the common formats (DXTn, ATIn/BCn, 8 and 16-bit RGB(A),
+// luminance, half and float).  Open fails for anything else, the caller can
+// fall back on DirectX::LoadDDSTextureFromFile, which also converts the
+// rarer legacy formats.
+//
+// Only parses, the resource desc and the upload are in D3D12Util.
+class DdsFile
+{
+public:
+	using uint32 = std::uint32_t;
+	using uint64 = std::uint64_t;
+
+	// The formats Parse knows the size of, with their DXGI_FORMAT values.
+	enum class Format : uint32
+	{
+		UNKNOWN = 0,
+		R32G32B32A32_TYPELESS = 1,
+		R32G32B32A32_FLOAT = 2,
+		R32G32B32A32_UINT = 3,
+		R32G32B32A32_SINT = 4,
+		R32G32B32_TYPELESS = 5,
+		R32G32B32_FLOAT = 6,
+		R32G32B32_UINT = 7,
+		R32G32B32_SINT = 8,
+		R16G16B16A16_TYPELESS = 9,
+		R16G16B16A16_FLOAT = 10,
+		R16G16B16A16_UNORM = 11,
+		R16G16B16A16_UINT = 12,
+		R16G16B16A16_SNORM = 13,
+		R16G16B16A16_SINT = 14,
+		R32G32_TYPELESS = 15,
+		R32G32_FLOAT = 16,
+		R32G32_UINT = 17,
+		R32G32_SINT = 18,
+		R10G10B10A2_TYPELESS = 23,
+		R10G10B10A2_UNORM = 24,
+		R10G10B10A2_UINT = 25,
+		R11G11B10_FLOAT = 26,
+		R8G8B8A8_TYPELESS = 27,
+		R8G8B8A8_UNORM = 28,
+		R8G8B8A8_UNORM_SRGB = 29,
+		R8G8B8A8_UINT = 30,
+		R8G8B8A8_SNORM = 31,
+		R8G8B8A8_SINT = 32,
+		R16G16_TYPELESS = 33,
+		R16G16_FLOAT = 34,
+		R16G16_UNORM = 35,
+		R16G16_UINT = 36,
+		R16G16_SNORM = 37,
+		R16G16_SINT = 38,
+		R32_TYPELESS = 39,
+		D32_FLOAT = 40,
+		R32_FLOAT = 41,
+		R32_UINT = 42,
+		R32_SINT = 43,
+		R24G8_TYPELESS = 44,
+		D24_UNORM_S8_UINT = 45,
+		R8G8_TYPELESS = 48,
+		R8G8_UNORM = 49,
+		R8G8_UINT = 50,
+		R8G8_SNORM = 51,
+		R8G8_SINT = 52,
+		R16_TYPELESS = 53,
+		R16_FLOAT = 54,
+		D16_UNORM = 55,
+		R16_UNORM = 56,
+		R16_UINT = 57,
+		R16_SNORM = 58,
+		R16_SINT = 59,
+		R8_TYPELESS = 60,
+		R8_UNORM = 61,
+		R8_UINT = 62,
+		R8_SNORM = 63,
+		R8_SINT = 64,
+		A8_UNORM = 65,
+		R9G9B9E5_SHAREDEXP = 67,
+		BC1_TYPELESS = 70,
+		BC1_UNORM = 71,
+		BC1_UNORM_SRGB = 72,
+		BC2_TYPELESS = 73,
+		BC2_UNORM = 74,
+		BC2_UNORM_SRGB = 75,
+		BC3_TYPELESS = 76,
+		BC3_UNORM = 77,
+		BC3_UNORM_SRGB = 78,
+		BC4_TYPELESS = 79,
+		BC4_UNORM = 80,
+		BC4_SNORM = 81,
+		BC5_TYPELESS = 82,
+		BC5_UNORM = 83,
+		BC5_SNORM = 84,
+		B5G6R5_UNORM = 85,
+		B5G5R5A1_UNORM = 86,
+		B8G8R8A8_UNORM = 87,
+		B8G8R8X8_UNORM = 88,
+		B8G8R8A8_TYPELESS = 90,
+		B8G8R8A8_UNORM_SRGB = 91,
+		B8G8R8X8_TYPELESS = 92,
+		B8G8R8X8_UNORM_SRGB = 93,
+		BC6H_TYPELESS = 94,
+		BC6H_UF16 = 95,
+		BC6H_SF16 = 96,
+		BC7_TYPELESS = 97,
+		BC7_UNORM = 98,
+		BC7_UNORM_SRGB = 99,
+		B4G4R4A4_UNORM = 115,
+	};
+
+	// With their D3D12_RESOURCE_DIMENSION values, as in the DX10 header.
+	enum class Dimension : uint32
+	{
+		Texture1D = 2,
+		Texture2D = 3,
+		Texture3D = 4,
+	};
+
+	// One mip of one array slice (cube face).  A volume mip holds its depth
+	// slices one after the other, SlicePitch apart.
+	struct Surface
+	{
+		const void* Data = nullptr;
+		uint64 RowPitch = 0;
+		uint64 SlicePitch = 0;
+	};
+
+	DdsFile() = default;
+	DdsFile(const DdsFile& rhs) = delete;
+	DdsFile& operator=(const DdsFile& rhs) = delete;
+
+	///<summary>
+	/// Maps filename and parses it.  Returns false if it is missing, damaged
+	/// or in a format Parse does not read.
+	///</summary>
+	bool Open(const std::string& filename);
+	void Close();
+
+	///<summary>
+	/// Parses a DDS image in memory.  The surfaces point into data, which has
+	/// to outlive them.
+	///</summary>
+	bool Parse(const void* data, size_t byteSize);
+
+	Dimension GetDimension() const
+	{
+		return mDimension;
+	}
+
+	Format GetFormat() const
+	{
+		return mFormat;
+	}
+
+	uint64 GetWidth() const
+	{
+		return mWidth;
+	}
+
+	uint32 GetHeight() const
+	{
+		return mHeight;
+	}
+
+	///<summary>
+	/// 1 unless a volume.
+	///</summary>
+	uint32 GetDepth() const
+	{
+		return mDepth;
+	}
+
+	///<summary>
+	/// Array slices, 6 per cube of a cube map, 1 for a volume.
+	///</summary>
+	uint32 GetArraySize() const
+	{
+		return mArraySize;
+	}
+
+	uint32 GetMipLevels() const
+	{
+		return mMipLevels;
+	}
+
+	bool IsCubeMap() const
+	{
+		return mCubeMap;
+	}
+
+	///<summary>
+	/// One per mip of every array slice (cube face), in D3D12 subresource order.
+	///</summary>
+	const std::vector<Surface>& GetSurfaces() const
+	{
+		return mSurfaces;
+	}
+
+	///<summary>
+	/// Pitch and row count of a width x height surface of format.  Rows are
+	/// rows of 4x4 blocks for block compressed formats.  Returns false for
+	/// formats it does not know the size of.
+	///</summary>
+	static bool GetSurfaceInfo(uint64 width, uint32 height, Format format, uint64& rowBytes, uint32& rowCount);
+
+private:
+	MappedFile mFile;
+	Dimension mDimension = Dimension::Texture2D;
+	Format mFormat = Format::UNKNOWN;
+	uint64 mWidth = 0;
+	uint32 mHeight = 0;
+	uint32 mDepth = 0;
+	uint32 mArraySize = 0;
+	uint32 mMipLevels = 0;
+	bool mCubeMap = false;
+	std::vector<Surface> mSurfaces;
+};
\ No newline at end of file
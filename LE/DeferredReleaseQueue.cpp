@@ -0,0 +1,72 @@
+#include "DeferredReleaseQueue.h"
+#include <algorithm>
+#include <cstdio>
+
+using Microsoft::WRL::ComPtr;
+
+DeferredReleaseQueue::DeferredReleaseQueue(ID3D12Fence* fence)
+	:
+	mFence(fence)
+{
+}
+
+void DeferredReleaseQueue::Retire(ComPtr<ID3D12Resource> resource, UINT64 fenceValue)
+{
+	if (resource == nullptr)
+		return;
+
+	// What the resource takes in its heap, not just its content.
+	ComPtr<ID3D12Device> device;
+	ThrowIfFailed(resource->GetDevice(IID_PPV_ARGS(device.GetAddressOf())));
+	const D3D12_RESOURCE_DESC desc = resource->GetDesc();
+	const UINT64 byteSize = device->GetResourceAllocationInfo(0, 1, &desc).SizeInBytes;
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	mRetired.push_back({ std::move(resource), fenceValue, byteSize });
+	mStats.PendingResources++;
+	mStats.PendingBytes += byteSize;
+	mStats.PeakPendingBytes = std::max(mStats.PeakPendingBytes, mStats.PendingBytes);
+}
+
+UINT DeferredReleaseQueue::Collect()
+{
+	const UINT64 completed = mFence->GetCompletedValue();
+
+	// Released outside the lock, the last Release of a resource may take a
+	// while.
+	std::vector<Retired> done;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		auto pending = std::partition(mRetired.begin(), mRetired.end(),
+			[completed](const Retired& retired) { return retired.FenceValue > completed; });
+		done.assign(std::make_move_iterator(pending), std::make_move_iterator(mRetired.end()));
+		mRetired.erase(pending, mRetired.end());
+
+		for (const auto& retired : done)
+		{
+			mStats.PendingResources--;
+			mStats.PendingBytes -= retired.ByteSize;
+			mStats.ReleasedResources++;
+			mStats.ReleasedBytes += retired.ByteSize;
+		}
+	}
+
+	return (UINT)done.size();
+}
+
+DeferredReleaseQueue::Stats DeferredReleaseQueue::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mStats;
+}
+
+std::string DeferredReleaseQueue::ToString() const
+{
+	const Stats stats = GetStats();
+	char buffer[256];
+	snprintf(buffer, sizeof(buffer),
+		"[DeferredReleaseQueue] %u resources (%.1f MB) pending, at most %.1f MB, %u released (%.1f MB)\n",
+		stats.PendingResources, stats.PendingBytes / (1024.0 * 1024.0), stats.PeakPendingBytes / (1024.0 * 1024.0),
+		stats.ReleasedResources, stats.ReleasedBytes / (1024.0 * 1024.0));
+	return buffer;
+}
\ No newline at end of file
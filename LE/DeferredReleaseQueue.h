@@ -0,0 +1,57 @@
+#pragma once
+#include "D3D12Util.h"
+#include <mutex>
+
+// Keeps resources alive until the GPU is done with them.  A resource handed
+// to Retire with a fence value is released by the first Collect that finds
+// the fence at that value, so upload buffers and replaced resources can be
+// let go of right after recording the commands that use them.
+//
+// All functions can be called from several threads at once.
+class DeferredReleaseQueue
+{
+public:
+	struct Stats
+	{
+		UINT PendingResources = 0;
+		UINT64 PendingBytes = 0;
+		// Most bytes that were pending at once.
+		UINT64 PeakPendingBytes = 0;
+		UINT ReleasedResources = 0;
+		UINT64 ReleasedBytes = 0;
+	};
+
+	explicit DeferredReleaseQueue(ID3D12Fence* fence);
+	DeferredReleaseQueue(const DeferredReleaseQueue& rhs) = delete;
+	DeferredReleaseQueue& operator=(const DeferredReleaseQueue& rhs) = delete;
+
+	///<summary>
+	/// Releases resource once the fence reaches fenceValue.  Does nothing
+	/// for nullptr.
+	///</summary>
+	void Retire(Microsoft::WRL::ComPtr<ID3D12Resource> resource, UINT64 fenceValue);
+
+	///<summary>
+	/// Releases what the GPU is done with and returns how many resources
+	/// that were.  Once a frame.
+	///</summary>
+	UINT Collect();
+
+	Stats GetStats() const;
+
+	std::string ToString() const;
+
+private:
+	struct Retired
+	{
+		Microsoft::WRL::ComPtr<ID3D12Resource> Resource;
+		UINT64 FenceValue;
+		UINT64 ByteSize;
+	};
+
+	Microsoft::WRL::ComPtr<ID3D12Fence> mFence;
+
+	mutable std::mutex mMutex;
+	std::vector<Retired> mRetired;
+	Stats mStats;
+};
\ No newline at end of file
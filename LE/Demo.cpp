@@ -4,11 +4,21 @@
 #include "imgui_impl_win32.h"
 #include "imgui_impl_dx12.h"
 
-#include "GeometryGenerator.h"
+#include "BoundsFitter.h"
+#include "GeometryWriter.h"
+#include "MeshBuilder.h"
+#include "MeshCooker.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "TerrainGenerator.h"
+#include "TerrainGeometry.h"
 
 #include "../3rdParty/Assimp/include/assimp/Importer.hpp"
 #include "../3rdParty/Assimp/include/assimp/PostProcess.h"
 #include "../3rdParty/Assimp/include/assimp/Scene.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
 
 #pragma comment (lib, "../3rdParty/assimp/lib/assimp-vc142-mtd.lib")
 
@@ -19,10 +29,139 @@ bool show_wireframe = false;
 XMVECTORF32 clear_color = DirectX::Colors::DarkSlateGray;
 ImFont* font;
 
+struct FbxImport
+{
+	std::string CookedPath;
+	AssetDatabase::uint64 SourceStamp = 0;
+	// The cooked file of an earlier run, if it is still current.
+	std::unique_ptr<CookedMeshFile> Cooked;
+	// Otherwise the imported mesh, built and cooked by BuildGeometry.
+	std::unique_ptr<MeshBuilder> Builder;
+	std::vector<CookedMaterial> Materials;
+	double Milliseconds = 0.0;
+};
+
+namespace
+{
+	const char* const FbxPath = "fbx/delicious-donut-with-sprinkles-gameready-model.quads.fbx";
+	const unsigned FbxImportFlags =
+		aiProcess_Triangulate | aiProcess_CalcTangentSpace | aiProcess_JoinIdenticalVertices | aiProcess_ConvertToLeftHanded;
+
+	struct TextureFile
+	{
+		const char* Name;
+		const wchar_t* Filename;
+		// For textures that come without mips, those get them and are
+		// compressed on import.
+		AssetDatabase::TextureOptions Options;
+	};
+
+	const TextureFile TextureFiles[] =
+	{
+		{ "tex_grid", L"Textures/floor.dds" },
+		{ "WoodCrate01", L"Textures/WoodCrate01.dds" },
+		{ "ice", L"Textures/ice.dds" },
+		// Alpha tested against 0.1 in TreeSprite.hlsl.  BC3 keeps the alpha
+		// apart from the colors.
+		{ "treeArrayTex", L"Textures/treeArray2.dds", { { MipGenerator::Filter::Kaiser, 0.1f }, { DdsFile::Format::BC3_UNORM } } },
+		{ "skyTex", L"Textures/SkyBox.dds" },
+	};
+
+	// Streamed in after startup by Demo::StreamTextures, into this slot of
+	// the SRV heap.
+	const char* const BaseColorFile = "fbx/textures/BaseColor.png";
+	const UINT BaseColorHeapIndex = 4;
+
+	// The textures of the table materials index, by DiffuseSrvHeapIndex.
+	// The SRV heap holds two copies of the table, see Demo::mTextureTable.
+	const char* const TextureTableNames[] = { "tex_grid", "WoodCrate01", "ice", "treeArrayTex", "baseColor" };
+	const UINT TextureTableBases[2] = { 0, 7 };
+
+	// Levels smaller than this stay resident, they are not worth a resource
+	// of their own.
+	const UINT MinResidentLevelSize = 64;
+
+	// A view of all levels of a 2D texture or texture array, a null view for
+	// a texture that is not loaded yet.
+	D3D12_SHADER_RESOURCE_VIEW_DESC TextureViewDesc(ID3D12Resource* resource)
+	{
+		D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+		srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+		if (resource == nullptr)
+		{
+			srvDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+			srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+			srvDesc.Texture2D.MipLevels = 1;
+			return srvDesc;
+		}
+
+		const D3D12_RESOURCE_DESC desc = resource->GetDesc();
+		srvDesc.Format = desc.Format;
+		if (desc.DepthOrArraySize > 1)
+		{
+			srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2DARRAY;
+			srvDesc.Texture2DArray.MostDetailedMip = 0;
+			srvDesc.Texture2DArray.MipLevels = -1;
+			srvDesc.Texture2DArray.FirstArraySlice = 0;
+			srvDesc.Texture2DArray.ArraySize = desc.DepthOrArraySize;
+		}
+		else
+		{
+			srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+			srvDesc.Texture2D.MostDetailedMip = 0;
+			srvDesc.Texture2D.MipLevels = desc.MipLevels;
+			srvDesc.Texture2D.ResourceMinLODClamp = 0.0f;
+		}
+		return srvDesc;
+	}
+
+	const D3D_SHADER_MACRO AlphaTestDefines[] =
+	{
+		"ALPHA_TEST", "1",
+		NULL, NULL
+	};
+
+	struct ShaderFile
+	{
+		const char* Name;
+		const wchar_t* Filename;
+		const D3D_SHADER_MACRO* Defines;
+		const char* Entrypoint;
+		const char* Target;
+	};
+
+	const ShaderFile ShaderFiles[] =
+	{
+		{ "standardVS", L"Shaders\\Color.hlsl", nullptr, "VS", "vs_5_1" },
+		{ "opaquePS", L"Shaders\\Color.hlsl", nullptr, "PS", "ps_5_1" },
+
+		{ "treeSpriteVS", L"Shaders\\TreeSprite.hlsl", nullptr, "VS", "vs_5_1" },
+		{ "treeSpriteGS", L"Shaders\\TreeSprite.hlsl", nullptr, "GS", "gs_5_1" },
+		{ "treeSpritePS", L"Shaders\\TreeSprite.hlsl", AlphaTestDefines, "PS", "ps_5_1" },
+
+		//{ "tessVS", L"Shaders\\Tessellation.hlsl", nullptr, "VS", "vs_5_1" },
+		//{ "tessHS", L"Shaders\\Tessellation.hlsl", nullptr, "HS", "hs_5_1" },
+		//{ "tessDS", L"Shaders\\Tessellation.hlsl", nullptr, "DS", "ds_5_1" },
+		//{ "tessPS", L"Shaders\\Tessellation.hlsl", nullptr, "PS", "ps_5_1" },
+
+		{ "tessVS", L"Shaders\\BezierTessellation.hlsl", nullptr, "VS", "vs_5_1" },
+		{ "tessHS", L"Shaders\\BezierTessellation.hlsl", nullptr, "HS", "hs_5_1" },
+		{ "tessDS", L"Shaders\\BezierTessellation.hlsl", nullptr, "DS", "ds_5_1" },
+		{ "tessPS", L"Shaders\\BezierTessellation.hlsl", nullptr, "PS", "ps_5_1" },
+
+		{ "vecAddCS", L"Shaders\\VecAdd.hlsl", nullptr, "CS", "cs_5_0" },
+
+		{ "skyVS", L"Shaders\\Sky.hlsl", nullptr, "VS", "vs_5_1" },
+		{ "skyPS", L"Shaders\\Sky.hlsl", nullptr, "PS", "ps_5_1" },
+
+		{ "shadowVS", L"Shaders\\Shadow.hlsl", nullptr, "VS", "vs_5_1" },
+		{ "shadowOpaquePS", L"Shaders\\Shadow.hlsl", nullptr, "PS", "ps_5_1" },
+		{ "shadowAlphaTestedPS", L"Shaders\\Shadow.hlsl", AlphaTestDefines, "PS", "ps_5_1" },
+	};
+}
+
 Demo::Demo()
 {
-	mSceneBounds.Center = XMFLOAT3(0.0f, 0.0f, 0.0f);
-	mSceneBounds.Radius = 50.0f;
 }
 
 Demo::~Demo()
@@ -86,35 +225,66 @@ void Demo::Initialize(HWND hwnd, int clientWidth, int clientHeight)
 
 	ThrowIfFailed(mCommandList->Reset(mCommandAllocator.Get(), nullptr));
 
+	mAssets = std::make_unique<AssetDatabase>("Cache");
+	mReleaseQueue = std::make_unique<DeferredReleaseQueue>(mFence.Get());
+
+	// Decoding textures, importing the model, generating the terrain and
+	// compiling shaders only need the device or the CPU and run in parallel.
+	// The steps that record on mCommandList are chained in their old order.
+	TaskGraph startup;
+	mDecodedTextures.resize(_countof(TextureFiles));
+	mCompiledShaders.resize(_countof(ShaderFiles));
+	auto decodeTextures = startup.AddParallel("DecodeTexture", (UINT)_countof(TextureFiles), [this](UINT i) { DecodeTexture(i); });
+	auto importFbx = startup.Add("ImportFbx", [this]() { ImportFbx(); });
+	auto generateTerrain = startup.Add("GenerateTerrain", [this]() { GenerateTerrain(); });
+	auto compileShaders = startup.AddParallel("CompileShader", (UINT)_countof(ShaderFiles), [this](UINT i) { CompileShader(i); });
+
 	// ͼƬԴ
-	LoadTextures();
+	auto loadTextures = startup.Add("LoadTextures", [this]() { LoadTextures(); }, { decodeTextures });
 	// 
-	BuildGeometry();
-	BuildLandGeometry();
+	auto buildGeometry = startup.Add("BuildGeometry", [this]() { BuildGeometry(); }, { loadTextures, importFbx, generateTerrain });
+	auto buildLandGeometry = startup.Add("BuildLandGeometry", [this]() { BuildLandGeometry(); }, { buildGeometry });
 
 	// 
-	BuildMaterials();
+	auto buildMaterials = startup.Add("BuildMaterials", [this]() { BuildMaterials(); });
 	// ɫ벼
-	BuildShadersAndInputLayout();
+	auto buildShaders = startup.Add("BuildShadersAndInputLayout", [this]() { BuildShadersAndInputLayout(); }, { compileShaders });
 	// ɫ
-	BuildRootSignature();
+	auto buildRootSignature = startup.Add("BuildRootSignature", [this]() { BuildRootSignature(); });
 
 	// Ⱦ
-	BuildRenderItems();
+	auto buildRenderItems = startup.Add("BuildRenderItems", [this]() { BuildRenderItems(); },
+		{ buildGeometry, buildLandGeometry, buildMaterials });
 	// ֡Դ
-	BuildFrameResources();
+	startup.Add("BuildFrameResources", [this]() { BuildFrameResources(); }, { buildRenderItems });
 
 	// ڴ洢SRV
-	BuildDescriptorHeaps();
+	startup.Add("BuildDescriptorHeaps", [this]() { BuildDescriptorHeaps(); }, { loadTextures });
 
 	// ˮ״̬
-	BuildPSO();
+	startup.Add("BuildPSO", [this]() { BuildPSO(); }, { buildShaders, buildRootSignature });
+
+	startup.Run();
+
+	::OutputDebugStringA(startup.ToString().c_str());
+	::OutputDebugStringA(mAssets->ToString().c_str());
 
 	// Execute the initialization commands.
 	ThrowIfFailed(mCommandList->Close());
 	ID3D12CommandList* cmdsLists[] = { mCommandList.Get() };
 	mCommandQueue->ExecuteCommandLists(_countof(cmdsLists), cmdsLists);
 	FlushCommandQueue();
+	mReleaseQueue->Collect();
+	::OutputDebugStringA(mReleaseQueue->ToString().c_str());
+
+	// The first frame did not need these, they arrive while the demo runs.
+	AssetDatabase::TextureOptions streamedTextureOptions;
+	streamedTextureOptions.Compression.Format = DdsFile::Format::BC7_UNORM;
+	mStreamingDevice = std::make_unique<D3D12StreamingDevice>(mD3D12Device.Get(), *mAssets, streamedTextureOptions);
+	AssetStreamer::Options streamerOptions;
+	streamerOptions.Log = [](const std::string& message) { ::OutputDebugStringA(message.c_str()); };
+	mStreamer = std::make_unique<AssetStreamer>(*mStreamingDevice, streamerOptions);
+	StreamTextures();
 
 	//mCommandAllocator->Reset();
 	//mCommandList->Reset(mCommandAllocator.Get(), nullptr);
@@ -138,6 +308,8 @@ void Demo::OnResize()
 	D3D12App::OnResize();
 	// The window resized, so update the aspect ratio and recompute the projection matrix.
 	mCameras["MainCamera"]->SetLens(XM_PIDIV4, static_cast<float>(mClientWidth) / mClientHeight, 0.1f, 1000.0f);
+	mLodSelector.SetProjection(mCameras["MainCamera"]->GetFovY(), static_cast<float>(mClientHeight));
+	mTerrainQuadtree.SetProjection(mCameras["MainCamera"]->GetFovY(), static_cast<float>(mClientHeight));
 }
 
 void Demo::Update()
@@ -158,6 +330,9 @@ void Demo::Update()
 		CloseHandle(eventHandle);
 	}
 
+	mReleaseQueue->Collect();
+	mStreamer->Update();
+
 	//mLightRotationAngle += 0.1f * GameTimer::GetInstancePtr()->DeltaTime();
 
 	XMMATRIX R = XMMatrixRotationY(mLightRotationAngle);
@@ -166,6 +341,10 @@ void Demo::Update()
 	XMStoreFloat3(&mRotatedLightDirections, lightDir);
 
 	UpdateObjectCBs();
+	UpdateWorldBounds();
+	UpdateTextureResidency();
+	UpdateClusterCulling();
+	UpdateTerrain();
 	UpdateMainPassCB();
 	UpdateReflectedMainPassCB();
 	UpdateMaterialCB();
@@ -197,6 +376,28 @@ void Demo::PrepareUI()
 		ImGui::Checkbox("Another Window", &show_another_window);
 		ImGui::Checkbox("Wire Frame Mode", &show_wireframe);
 		ImGui::Checkbox("MSAA", &mEnableMSAA);
+		ImGui::Checkbox("Mesh LOD", &mEnableLod);
+		ImGui::Text("LOD meshes: %u triangles (%u at full detail)", mLodTrianglesSubmitted, mLodTrianglesFullDetail);
+		ImGui::Checkbox("Cluster Culling Stats", &mShowClusterStats);
+		if (mShowClusterStats)
+		{
+			ImGui::Text("Clusters: %u frustum culled, %u backface culled of %u, %u triangles left",
+				mClusterStats.FrustumCulled, mClusterStats.BackfaceCulled, mClusterStats.Clusters, mClusterStats.VisibleTriangles);
+		}
+		const TerrainQuadtree::Stats& terrainStats = mTerrainQuadtree.GetStats();
+		ImGui::Text("Terrain: %u tiles drawn, %u culled, %u triangles (threshold x%.2f)",
+			terrainStats.VisibleTiles, terrainStats.CulledTiles, terrainStats.Triangles, terrainStats.ThresholdScale);
+		const AssetStreamer::Stats streamStats = mStreamer->GetStats();
+		ImGui::Text("Streaming: %u of %u resident, %u failed, %.1f MB uploaded",
+			streamStats.Resident, streamStats.Requested, streamStats.Failed, streamStats.UploadedBytes / (1024.0 * 1024.0));
+		ImGui::SliderInt("Texture budget (MB)", &mTextureBudgetMB, 1, 64);
+		const TextureResidency::Stats& residencyStats = mTextureResidency.GetStats();
+		ImGui::Text("Texture mips: %.2f MB resident, %u levels missing, %u streamed, %u evictions, %.2f MB of sources on the CPU",
+			residencyStats.ResidentBytes / (1024.0 * 1024.0), residencyStats.MissingLevels, residencyStats.StreamedLevels, residencyStats.Evictions,
+			residencyStats.SourceBytes / (1024.0 * 1024.0));
+		const DeferredReleaseQueue::Stats releaseStats = mReleaseQueue->GetStats();
+		ImGui::Text("Pending release: %u resources, %.2f MB (%.1f MB released)",
+			releaseStats.PendingResources, releaseStats.PendingBytes / (1024.0 * 1024.0), releaseStats.ReleasedBytes / (1024.0 * 1024.0));
 		ImGui::ColorEdit3("clear color", (float*)&clear_color); // Edit 3 floats representing a color
 
 		//if (ImGui::Button("Button"))                            // Buttons return true when clicked (most widgets return true when edited/activated)
@@ -233,6 +434,8 @@ void Demo::Draw()
 	// Reusing the command list reuses memory.
 	ThrowIfFailed(mCommandList->Reset(cmdListAlloc.Get(), show_wireframe ? mPSOs["opaque_wireframe"].Get() : mPSOs["opaque_solid"].Get()));
 
+	ApplyTextureResidency();
+
 	// You can only bind descriptor heaps of type D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV and D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER.
 	// Only one descriptor heap of each type can be set at one time, which means a maximum of 2 heaps(one sampler, one CBV / SRV / UAV) can be set at one time.
 	// https://docs.microsoft.com/en-us/windows/win32/api/d3d12/nf-d3d12-id3d12graphicscommandlist-setdescriptorheaps
@@ -240,7 +443,7 @@ void Demo::Draw()
 	mCommandList->SetDescriptorHeaps(_countof(descriptorHeaps), descriptorHeaps);
 
 	auto matBuffer = mCurrFrameResource->MaterialCB->Resource();
-	CD3DX12_GPU_DESCRIPTOR_HANDLE tex(mSrvDescriptorHeap->hGPU(0));
+	CD3DX12_GPU_DESCRIPTOR_HANDLE tex(mSrvDescriptorHeap->hGPU(TextureTableBases[mTextureTable]));
 
 	// øǩ
 	mCommandList->SetGraphicsRootSignature(mRootSignature.Get());
@@ -291,6 +494,8 @@ void Demo::Draw()
 	// Ⱦ͸
 	mCommandList->SetPipelineState(mPSOs["opaque_solid"].Get());
 	DrawRenderItemsNew(mCommandList.Get(), mRitemLayer[(int)RenderLayer::Opaque]);
+	// The terrain only receives shadows, it is left out of the shadow map fit.
+	DrawRenderItemsNew(mCommandList.Get(), mRitemLayer[(int)RenderLayer::Terrain]);
 
 	// ø
 	mCommandList->SetPipelineState(mPSOs["treeSprites"].Get());
@@ -387,6 +592,7 @@ void Demo::Draw()
 	ThrowIfFailed(mSwapChain->Present(0, 0));
 	mCurrentBackBuffer = (mCurrentBackBuffer + 1) % SwapChainBufferCount;
 	mCurrFrameResource->Fence = ++mCurrentFence;
+	mTextureTableFences[mTextureTable] = mCurrentFence;
 
 	// Add an instruction to the command queue to set a new fence point. 
 	// Because we are on the GPU timeline, the new fence point won't be 
@@ -433,9 +639,16 @@ void Demo::UpdateCamera()
 
 void Demo::UpdateObjectCBs()
 {
+	mLodTrianglesSubmitted = 0;
+	mLodTrianglesFullDetail = 0;
+
 	// Update the constant buffer with the latest worldViewProj matrix.
 	for (auto& e : mAllRitems)
 	{
+		// Picks the levels first, a change reorders the instances and marks them dirty.
+		if (!e->Lods.empty())
+			UpdateInstanceLods(*e);
+
 		auto currObjectCB = mCurrFrameResource->InstanceBuffer[e.get()].get();
 		// Only update the cbuffer data if the constants have changed.  
 		// This needs to be tracked per frame resource.
@@ -443,7 +656,8 @@ void Demo::UpdateObjectCBs()
 		{
 			for (UINT i = 0; i < e->InstanceCount; i++)
 			{
-				XMMATRIX world = XMLoadFloat4x4(&(e->Instances[i].World));
+				UINT instance = e->InstanceOrder.empty() ? i : e->InstanceOrder[i];
+				XMMATRIX world = XMLoadFloat4x4(&(e->Instances[instance].World));
 				InstanceData instanceData;
 				instanceData.MaterialIndex = e->Mat->MaterialIndex;
 				XMStoreFloat4x4(&instanceData.TexTransform, XMMatrixIdentity());
@@ -458,6 +672,251 @@ void Demo::UpdateObjectCBs()
 	}
 }
 
+void Demo::UpdateInstanceLods(RenderItem& ritem)
+{
+	XMFLOAT3 eye = mCameras["MainCamera"]->GetPosition3f();
+
+	bool changed = ritem.InstanceLods.size() != ritem.InstanceCount;
+	ritem.InstanceLods.resize(ritem.InstanceCount, 0);
+
+	for (UINT i = 0; i < ritem.InstanceCount; i++)
+	{
+		const XMFLOAT4X4& world = ritem.Instances[i].World;
+		XMVECTOR toInstance = XMVectorSet(world._41 - eye.x, world._42 - eye.y, world._43 - eye.z, 0.0f);
+		float distance = XMVectorGetX(XMVector3Length(toInstance));
+
+		// The largest axis scale, errors are measured in object space.
+		float scale = std::max(XMVectorGetX(XMVector3Length(XMVectorSet(world._11, world._12, world._13, 0.0f))),
+			std::max(XMVectorGetX(XMVector3Length(XMVectorSet(world._21, world._22, world._23, 0.0f))),
+				XMVectorGetX(XMVector3Length(XMVectorSet(world._31, world._32, world._33, 0.0f)))));
+
+		UINT lod = mEnableLod ? mLodSelector.Select(ritem.Lods, ritem.InstanceLods[i], scale, distance) : 0;
+		changed |= lod != ritem.InstanceLods[i];
+		ritem.InstanceLods[i] = lod;
+	}
+
+	if (changed)
+	{
+		// Counting sort of the instances by level.
+		std::vector<UINT> firstInstance(ritem.Lods.size() + 1, 0);
+		for (UINT lod : ritem.InstanceLods)
+			firstInstance[lod + 1]++;
+		for (size_t lod = 0; lod < ritem.Lods.size(); lod++)
+			firstInstance[lod + 1] += firstInstance[lod];
+
+		ritem.LodDraws.clear();
+		for (UINT lod = 0; lod < ritem.Lods.size(); lod++)
+		{
+			if (firstInstance[lod + 1] > firstInstance[lod])
+			{
+				RenderItem::LodDraw draw;
+				draw.Lod = lod;
+				draw.FirstInstance = firstInstance[lod];
+				draw.InstanceCount = firstInstance[lod + 1] - firstInstance[lod];
+				ritem.LodDraws.push_back(draw);
+			}
+		}
+
+		ritem.InstanceOrder.resize(ritem.InstanceCount);
+		for (UINT i = 0; i < ritem.InstanceCount; i++)
+			ritem.InstanceOrder[firstInstance[ritem.InstanceLods[i]]++] = i;
+
+		// Every frame resource has to get the new order.
+		ritem.NumFramesDirty = gNumFrameResources;
+	}
+
+	for (const auto& draw : ritem.LodDraws)
+	{
+		for (const auto& part : ritem.Lods[draw.Lod].Parts)
+			mLodTrianglesSubmitted += part.IndexCount / 3 * draw.InstanceCount;
+	}
+	for (const auto& part : ritem.Lods[0].Parts)
+		mLodTrianglesFullDetail += part.IndexCount / 3 * ritem.InstanceCount;
+}
+
+void Demo::UpdateClusterCulling()
+{
+	// Culls the clusters of every part of every clustered instance.  Nothing
+	// draws the compacted lists, so this only runs for the statistics.
+	mClusterStats = MeshClusterBuilder::CullStats();
+	mCulledIndices.clear();
+	if (!mShowClusterStats)
+		return;
+
+	const Camera& camera = *mCameras["MainCamera"];
+	XMMATRIX viewProj = camera.GetViewMatrix() * camera.GetProjMatrix();
+	XMVECTOR eye = camera.GetPosition();
+
+	// Whole instances outside the view skip the per cluster tests.
+	XMMATRIX view = camera.GetViewMatrix();
+	BoundingFrustum frustum(camera.GetProjMatrix());
+	frustum.Transform(frustum, XMMatrixInverse(&XMMatrixDeterminant(view), view));
+
+	for (auto& e : mAllRitems)
+	{
+		if (e->Clusters.empty())
+			continue;
+
+		MeshClusterBuilder::uint32 clusterCount = 0;
+		for (const MeshClusterSet* clusters : e->Clusters)
+			clusterCount += clusters != nullptr ? (MeshClusterBuilder::uint32)clusters->Clusters.size() : 0;
+
+		for (UINT i = 0; i < e->InstanceCount; i++)
+		{
+			if (frustum.Contains(e->WorldBounds[i]) == DISJOINT)
+			{
+				mClusterStats.Clusters += clusterCount;
+				mClusterStats.FrustumCulled += clusterCount;
+				continue;
+			}
+
+			XMMATRIX world = XMLoadFloat4x4(&e->Instances[i].World);
+			XMMATRIX invWorld = XMMatrixInverse(&XMMatrixDeterminant(world), world);
+
+			XMFLOAT4X4 worldViewProj;
+			XMStoreFloat4x4(&worldViewProj, world * viewProj);
+			XMFLOAT3 eyeObject;
+			XMStoreFloat3(&eyeObject, XMVector3TransformCoord(eye, invWorld));
+
+			const ClusterView clusterView = ClusterView::FromMatrix(worldViewProj, eyeObject);
+			for (const MeshClusterSet* clusters : e->Clusters)
+			{
+				if (clusters == nullptr)
+					continue;
+
+				auto stats = MeshClusterBuilder::Cull(*clusters, clusterView, mCulledIndices);
+				mClusterStats.Clusters += stats.Clusters;
+				mClusterStats.FrustumCulled += stats.FrustumCulled;
+				mClusterStats.BackfaceCulled += stats.BackfaceCulled;
+				mClusterStats.VisibleTriangles += stats.VisibleTriangles;
+			}
+			mCulledIndices.clear();
+		}
+	}
+}
+
+void Demo::UpdateTerrain()
+{
+	if (mTerrainRitem == nullptr)
+		return;
+
+	// The quadtree works in the terrain's object space.
+	const Camera& camera = *mCameras["MainCamera"];
+	XMMATRIX view = camera.GetViewMatrix();
+	XMMATRIX world = XMLoadFloat4x4(&mTerrainRitem->Instances[0].World);
+	XMMATRIX invWorld = XMMatrixInverse(&XMMatrixDeterminant(world), world);
+
+	BoundingFrustum frustum(camera.GetProjMatrix());
+	frustum.Transform(frustum, XMMatrixInverse(&XMMatrixDeterminant(view), view) * invWorld);
+	XMFLOAT3 eye;
+	XMStoreFloat3(&eye, XMVector3TransformCoord(camera.GetPosition(), invWorld));
+
+	if (!mTerrainQuadtree.Update(frustum, eye))
+		return;
+
+	// The first tile is the item's own draw, the others are extra parts.
+	const std::vector<SubmeshGeometry>& draws = mTerrainQuadtree.GetDraws();
+	mTerrainRitem->IndexCount = draws.empty() ? 0 : draws[0].IndexCount;
+	mTerrainRitem->StartIndexLocation = draws.empty() ? 0 : draws[0].StartIndexLocation;
+	mTerrainRitem->BaseVertexLocation = draws.empty() ? 0 : draws[0].BaseVertexLocation;
+	mTerrainRitem->ExtraParts.assign(draws.empty() ? draws.end() : draws.begin() + 1, draws.end());
+}
+
+void Demo::UpdateWorldBounds()
+{
+	// Only items whose instances changed are transformed again, the scene
+	// bounds are then merged from the cached boxes.
+	bool changed = false;
+	for (auto& e : mAllRitems)
+	{
+		if (!e->WorldBoundsDirty)
+			continue;
+
+		XMFLOAT3 corners[BoundingOrientedBox::CORNER_COUNT];
+		e->Bounds.GetCorners(corners);
+
+		e->WorldBounds.resize(e->Instances.size());
+		for (size_t i = 0; i < e->Instances.size(); ++i)
+		{
+			// Going through the corners keeps mirrored and non-uniformly
+			// scaled instances correct.
+			XMFLOAT3 worldCorners[BoundingOrientedBox::CORNER_COUNT];
+			XMVector3TransformCoordStream(worldCorners, sizeof(XMFLOAT3), corners, sizeof(XMFLOAT3),
+				BoundingOrientedBox::CORNER_COUNT, XMLoadFloat4x4(&e->Instances[i].World));
+			BoundingBox::CreateFromPoints(e->WorldBounds[i], BoundingOrientedBox::CORNER_COUNT, worldCorners, sizeof(XMFLOAT3));
+		}
+
+		e->WorldBoundsDirty = false;
+		changed = true;
+	}
+
+	if (!changed)
+		return;
+
+	// The shadow map has to cover everything that casts or receives shadows.
+	bool empty = true;
+	BoundingBox scene;
+	for (RenderItem* e : mRitemLayer[(int)RenderLayer::Opaque])
+	{
+		for (const BoundingBox& box : e->WorldBounds)
+		{
+			if (empty)
+				scene = box;
+			else
+				BoundingBox::CreateMerged(scene, scene, box);
+			empty = false;
+		}
+	}
+
+	if (!empty)
+		BoundingSphere::CreateFromBoundingBox(mSceneBounds, scene);
+}
+
+void Demo::UpdateTextureResidency()
+{
+	// Every instance in view asks for the level its texture is seen at: the
+	// texels across its bounds, with the texture repeated as often as the
+	// material transform says, against the pixels the bounds cover.
+	const Camera& camera = *mCameras["MainCamera"];
+	XMVECTOR eye = camera.GetPosition();
+	XMMATRIX view = camera.GetViewMatrix();
+	BoundingFrustum frustum(camera.GetProjMatrix());
+	frustum.Transform(frustum, XMMatrixInverse(&XMMatrixDeterminant(view), view));
+
+	for (auto& e : mAllRitems)
+	{
+		if (e->Mat == nullptr)
+			continue;
+		auto resident = std::find_if(mResidentTextures.begin(), mResidentTextures.end(),
+			[&e](const ResidentTexture& texture) { return (int)texture.HeapIndex == e->Mat->DiffuseSrvHeapIndex; });
+		if (resident == mResidentTextures.end())
+			continue;
+
+		const XMFLOAT4X4& texTransform = e->Mat->MatTransform;
+		const float repeat = std::max(XMVectorGetX(XMVector2Length(XMVectorSet(texTransform._11, texTransform._12, 0.0f, 0.0f))),
+			XMVectorGetX(XMVector2Length(XMVectorSet(texTransform._21, texTransform._22, 0.0f, 0.0f))));
+		const float texels = (float)std::max<UINT64>(resident->Desc.Width, resident->Desc.Height) * repeat;
+		const TextureResidency::TextureId id = (TextureResidency::TextureId)(resident - mResidentTextures.begin());
+
+		for (const BoundingBox& box : e->WorldBounds)
+		{
+			if (frustum.Contains(box) == DISJOINT)
+				continue;
+			float radius = XMVectorGetX(XMVector3Length(XMLoadFloat3(&box.Extents)));
+			float distance = std::max(XMVectorGetX(XMVector3Length(XMLoadFloat3(&box.Center) - eye)) - radius, camera.GetNearZ());
+			float pixels = mLodSelector.ProjectedError(2.0f * radius, 1.0f, distance);
+			mTextureResidency.Request(id, TextureResidency::EstimateMip(texels, pixels));
+		}
+	}
+
+	// Until the other copy of the table is out of use the requests add up,
+	// the next Update goes by the finest of them.
+	mTextureResidency.SetBudget((TextureResidency::uint64)mTextureBudgetMB << 20);
+	if (mTextureTableFences[1 - mTextureTable] > mFence->GetCompletedValue())
+		return;
+	mResidencyChanges = mTextureResidency.Update();
+}
+
 void Demo::UpdateShadowTransform()
 {
 	XMVECTOR lightDir = XMLoadFloat3(&mRotatedLightDirections);
@@ -630,50 +1089,32 @@ void Demo::CalculateFrameStats()
 	}
 }
 
+void Demo::DecodeTexture(UINT i)
+{
+	mAssets->DecodeTexture(mD3D12Device.Get(), TextureFiles[i].Filename, mDecodedTextures[i], TextureFiles[i].Options);
+}
+
 void Demo::LoadTextures()
 {
-	auto gridTex = std::make_unique<Texture>();
-	gridTex->Name = "tex_grid";
-	gridTex->Filename = L"Textures/floor.dds";
-	D3D12Util::LoadTexture(mD3D12Device.Get(), mCommandList.Get(), gridTex->Filename.c_str(),
-		gridTex->Resource.GetAddressOf(), gridTex->UploadHeap.GetAddressOf());
-
-	auto woodTex = std::make_unique<Texture>();
-	woodTex->Name = "WoodCrate01";
-	woodTex->Filename = L"Textures/WoodCrate01.dds";
-	D3D12Util::LoadTexture(mD3D12Device.Get(), mCommandList.Get(), woodTex->Filename.c_str(),
-		woodTex->Resource.GetAddressOf(), woodTex->UploadHeap.GetAddressOf());
-
-	auto iceTex = std::make_unique<Texture>();
-	iceTex->Name = "ice";
-	iceTex->Filename = L"Textures/ice.dds";
-	D3D12Util::LoadTexture(mD3D12Device.Get(), mCommandList.Get(), iceTex->Filename.c_str(),
-		iceTex->Resource.GetAddressOf(), iceTex->UploadHeap.GetAddressOf());
-
-	auto treeArrayTex = std::make_unique<Texture>();
-	treeArrayTex->Name = "treeArrayTex";
-	treeArrayTex->Filename = L"Textures/treeArray2.dds";
-	D3D12Util::LoadTexture(mD3D12Device.Get(), mCommandList.Get(), treeArrayTex->Filename.c_str(),
-		treeArrayTex->Resource.GetAddressOf(), treeArrayTex->UploadHeap.GetAddressOf());
-
-	auto baseColorTex = std::make_unique<Texture>();
-	baseColorTex->Name = "baseColor";
-	baseColorTex->Filename = L"fbx/textures/BaseColor.png";
-	D3D12Util::LoadTexture(mD3D12Device.Get(), mCommandList.Get(), baseColorTex->Filename.c_str(),
-		baseColorTex->Resource.GetAddressOf(), baseColorTex->UploadHeap.GetAddressOf());
-
-	auto skyTex = std::make_unique<Texture>();
-	skyTex->Name = "skyTex";
-	skyTex->Filename = L"Textures/SkyBox.dds";
-	D3D12Util::LoadTexture(mD3D12Device.Get(), mCommandList.Get(), skyTex->Filename.c_str(),
-		skyTex->Resource.GetAddressOf(), skyTex->UploadHeap.GetAddressOf());
-
-	mTextures[gridTex->Name] = std::move(gridTex);
-	mTextures[woodTex->Name] = std::move(woodTex);
-	mTextures[iceTex->Name] = std::move(iceTex);
-	mTextures[treeArrayTex->Name] = std::move(treeArrayTex);
-	mTextures[baseColorTex->Name] = std::move(baseColorTex);
-	mTextures[skyTex->Name] = std::move(skyTex);
+	// Decoded by DecodeTexture, only the uploads are left.
+	for (UINT i = 0; i < _countof(TextureFiles); ++i)
+	{
+		auto tex = std::make_unique<Texture>();
+		tex->Name = TextureFiles[i].Name;
+		tex->Filename = TextureFiles[i].Filename;
+		auto heapIndex = std::find_if(std::begin(TextureTableNames), std::end(TextureTableNames),
+			[&tex](const char* name) { return tex->Name == name; });
+		mDecodedTextures[i].KeepSource = heapIndex != std::end(TextureTableNames);
+		mAssets->UploadTexture(mD3D12Device.Get(), mCommandList.Get(), mDecodedTextures[i],
+			tex->Resource.GetAddressOf(), tex->UploadHeap.GetAddressOf());
+		mReleaseQueue->Retire(std::move(tex->UploadHeap), GetRecordingFence());
+		mTextures[tex->Name] = std::move(tex);
+
+		if (mDecodedTextures[i].KeepSource)
+			AddResidentTexture(TextureFiles[i].Name, (UINT)(heapIndex - std::begin(TextureTableNames)), mDecodedTextures[i]);
+	}
+
+	mDecodedTextures.clear();
 }
 
 void Demo::BuildMaterials()
@@ -714,7 +1155,8 @@ void Demo::BuildMaterials()
 	auto baseColorMat = std::make_unique<Material>();
 	baseColorMat->Name = "baseColor";
 	baseColorMat->MaterialIndex = 4;
-	baseColorMat->DiffuseSrvHeapIndex = 4;
+	// The grid stands in until the streamed texture is resident.
+	baseColorMat->DiffuseSrvHeapIndex = 0;
 	baseColorMat->DiffuseAlbedo = XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
 	baseColorMat->FresnelR0 = XMFLOAT3(0.01f, 0.01f, 0.01f);
 	baseColorMat->Roughness = 0.125f;
@@ -929,39 +1371,18 @@ void Demo::BuildRootSignature()
 	}
 }
 
-void Demo::BuildShadersAndInputLayout()
+void Demo::CompileShader(UINT i)
 {
-	mShaders["standardVS"] = D3D12Util::CompileShader(L"Shaders\\Color.hlsl", nullptr, "VS", "vs_5_1");
-	mShaders["opaquePS"] = D3D12Util::CompileShader(L"Shaders\\Color.hlsl", nullptr, "PS", "ps_5_1");
-
-	const D3D_SHADER_MACRO alphaTestDefines[] =
-	{
-		"ALPHA_TEST", "1",
-		NULL, NULL
-	};
-
-	mShaders["treeSpriteVS"] = D3D12Util::CompileShader(L"Shaders\\TreeSprite.hlsl", nullptr, "VS", "vs_5_1");
-	mShaders["treeSpriteGS"] = D3D12Util::CompileShader(L"Shaders\\TreeSprite.hlsl", nullptr, "GS", "gs_5_1");
-	mShaders["treeSpritePS"] = D3D12Util::CompileShader(L"Shaders\\TreeSprite.hlsl", alphaTestDefines, "PS", "ps_5_1");
-
-	//mShaders["tessVS"] = D3D12Util::CompileShader(L"Shaders\\Tessellation.hlsl", nullptr, "VS", "vs_5_1");
-	//mShaders["tessHS"] = D3D12Util::CompileShader(L"Shaders\\Tessellation.hlsl", nullptr, "HS", "hs_5_1");
-	//mShaders["tessDS"] = D3D12Util::CompileShader(L"Shaders\\Tessellation.hlsl", nullptr, "DS", "ds_5_1");
-	//mShaders["tessPS"] = D3D12Util::CompileShader(L"Shaders\\Tessellation.hlsl", nullptr, "PS", "ps_5_1");
-
-	mShaders["tessVS"] = D3D12Util::CompileShader(L"Shaders\\BezierTessellation.hlsl", nullptr, "VS", "vs_5_1");
-	mShaders["tessHS"] = D3D12Util::CompileShader(L"Shaders\\BezierTessellation.hlsl", nullptr, "HS", "hs_5_1");
-	mShaders["tessDS"] = D3D12Util::CompileShader(L"Shaders\\BezierTessellation.hlsl", nullptr, "DS", "ds_5_1");
-	mShaders["tessPS"] = D3D12Util::CompileShader(L"Shaders\\BezierTessellation.hlsl", nullptr, "PS", "ps_5_1");
-
-	mShaders["vecAddCS"] = D3D12Util::CompileShader(L"Shaders\\VecAdd.hlsl", nullptr, "CS", "cs_5_0");
-
-	mShaders["skyVS"] = D3D12Util::CompileShader(L"Shaders\\Sky.hlsl", nullptr, "VS", "vs_5_1");
-	mShaders["skyPS"] = D3D12Util::CompileShader(L"Shaders\\Sky.hlsl", nullptr, "PS", "ps_5_1");
+	const ShaderFile& shader = ShaderFiles[i];
+	mCompiledShaders[i] = mAssets->CompileShader(shader.Filename, shader.Defines, shader.Entrypoint, shader.Target);
+}
 
-	mShaders["shadowVS"] = D3D12Util::CompileShader(L"Shaders\\Shadow.hlsl", nullptr, "VS", "vs_5_1");
-	mShaders["shadowOpaquePS"] = D3D12Util::CompileShader(L"Shaders\\Shadow.hlsl", nullptr, "PS", "ps_5_1");
-	mShaders["shadowAlphaTestedPS"] = D3D12Util::CompileShader(L"Shaders\\Shadow.hlsl", alphaTestDefines, "PS", "ps_5_1");
+void Demo::BuildShadersAndInputLayout()
+{
+	// Compiled by CompileShader.
+	for (UINT i = 0; i < _countof(ShaderFiles); ++i)
+		mShaders[ShaderFiles[i].Name] = std::move(mCompiledShaders[i]);
+	mCompiledShaders.clear();
 
 	mDefaultInputLayout =
 	{
@@ -983,154 +1404,195 @@ void Demo::BuildShadersAndInputLayout()
 	};
 }
 
-void Demo::BuildGeometry()
+void Demo::ImportFbx()
 {
-	GeometryGenerator geoGen;
-	// Grid
+	// The imported, optimized and simplified mesh is cooked into the asset
+	// cache on the first run, later runs map the cooked file instead.
+	// The streams are compressed, decoding them is cheaper than reading
+	// them raw from a slow disk.
+	mFbxImport = std::make_unique<FbxImport>();
+	FbxImport& fbx = *mFbxImport;
+
+	fbx.SourceStamp = mAssets->ArtifactKey("mesh", FbxPath, FbxImportFlags);
+	fbx.CookedPath = mAssets->ArtifactPath(fbx.SourceStamp, ".mesh");
+
+	auto start = std::chrono::steady_clock::now();
+	fbx.Cooked = MeshCooker::Open(fbx.CookedPath, fbx.SourceStamp);
+	if (fbx.Cooked)
 	{
-		GeometryGenerator::MeshData model = geoGen.CreateGrid(64.0f, 64.0f, 4, 4);
-
-		std::vector<PrimitiveTypes::PosTexNorColVertex> vertices(model.Vertices.size());
-
-		for (size_t i = 0; i < model.Vertices.size(); ++i)
-		{
-			auto& p = model.Vertices[i];
-			vertices[i].Position = { p.Position.x, p.Position.y/*GetHillsHeight(p.Position.x, p.Position.z)*/, p.Position.z };
-			vertices[i].TexCoord = p.TexC;
-			vertices[i].Normal = p.Normal/*GetHillsNormal(p.Position.x, p.Position.z)*/;
-			vertices[i].Color = XMFLOAT4(DirectX::Colors::DarkGreen);
-		}
-
-		std::vector<std::uint16_t> indices;
-		indices.insert(indices.end(), std::begin(model.GetIndices16()), std::end(model.GetIndices16()));
-
-		const UINT vbByteSize = (UINT)vertices.size() * sizeof(PrimitiveTypes::PosTexNorColVertex);
-		const UINT ibByteSize = (UINT)indices.size() * sizeof(std::uint16_t);
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		fbx.Milliseconds = elapsed.count();
+		return;
+	}
 
-		auto geo = std::make_unique<MeshGeometry>();
-		geo->Name = "gridGeo";
+	ImportFbxSource();
+}
 
-		ThrowIfFailed(D3DCreateBlob(vbByteSize, &geo->VertexBufferCPU));
-		CopyMemory(geo->VertexBufferCPU->GetBufferPointer(), vertices.data(), vbByteSize);
+void Demo::ImportFbxSource()
+{
+	FbxImport& fbx = *mFbxImport;
+	auto start = std::chrono::steady_clock::now();
 
-		ThrowIfFailed(D3DCreateBlob(ibByteSize, &geo->IndexBufferCPU));
-		CopyMemory(geo->IndexBufferCPU->GetBufferPointer(), indices.data(), ibByteSize);
+	Assimp::Importer loader;
+	aiMaterial* material = nullptr;
+	aiString path;
 
-		geo->VertexBufferGPU = D3D12Util::CreateDefaultBuffer(mD3D12Device.Get(),
-			mCommandList.Get(), vertices.data(), vbByteSize, geo->VertexBufferUploader);
+	const aiScene* scene = loader.ReadFile(FbxPath, FbxImportFlags);
 
-		geo->IndexBufferGPU = D3D12Util::CreateDefaultBuffer(mD3D12Device.Get(),
-			mCommandList.Get(), indices.data(), ibByteSize, geo->IndexBufferUploader);
+	for (unsigned i = 0; i < scene->mNumMeshes; i++)
+	{
+		aiMesh* aimesh = scene->mMeshes[i];
 
-		geo->VertexByteStride = sizeof(PrimitiveTypes::PosTexNorColVertex);
-		geo->VertexBufferByteSize = vbByteSize;
-		geo->IndexFormat = DXGI_FORMAT_R16_UINT;
-		geo->IndexBufferByteSize = ibByteSize;
+		material = scene->mMaterials[aimesh->mMaterialIndex];
 
-		SubmeshGeometry submesh;
-		submesh.IndexCount = (UINT)indices.size();
-		submesh.StartIndexLocation = 0;
-		submesh.BaseVertexLocation = 0;
+		material->GetTexture(aiTextureType::aiTextureType_DIFFUSE, 0, &path);
+		fbx.Materials.assign(1, CookedMaterial{ material->GetName().C_Str(), path.C_Str() });
 
-		geo->DrawArgs["grid"] = submesh;
-		mGeometries[geo->Name] = std::move(geo);
-	}
-	// Box
-	{
-		GeometryGenerator::MeshData model = geoGen.CreateBox(1.0f, 1.0f, 1.0f, 0);
-		std::vector<PrimitiveTypes::PosTexNorColVertex> vertices(model.Vertices.size());
+		std::vector<PrimitiveTypes::PosTexNorColVertex> vertices(aimesh->mNumVertices);
 
-		for (size_t i = 0; i < model.Vertices.size(); ++i)
+		for (size_t i = 0; i < aimesh->mNumVertices; ++i)
 		{
-			auto& p = model.Vertices[i];
-			vertices[i].Position = { p.Position.x, p.Position.y, p.Position.z };
-			vertices[i].TexCoord = p.TexC;
-			vertices[i].Normal = p.Normal;
-			vertices[i].Color = XMFLOAT4(DirectX::Colors::DarkGreen);
+			auto& p = aimesh->mVertices[i];
+			int uvChannelNum = aimesh->GetNumUVChannels();
+			if (uvChannelNum >= 1)
+			{
+				auto& texC = aimesh->mTextureCoords[0][i];
+				vertices[i].TexCoord = XMFLOAT2{ texC.x, texC.y };
+			}
+			int colorChannelNum = aimesh->GetNumColorChannels();
+			if (colorChannelNum >= 1)
+			{
+				auto& color = aimesh->mColors[0][i];
+				vertices[i].Color = { color.r, color.g, color.b, color.a };
+			}
+			else
+			{
+				vertices[i].Color = XMFLOAT4(DirectX::Colors::White);
+			}
+			auto& normal = aimesh->mNormals[i];
+			vertices[i].Position = { p.x, p.y, p.z };
+			vertices[i].Normal = { normal.x, normal.y, normal.z };
+		}
+		std::vector<std::uint32_t> indices;
+		for (unsigned k = 0; k < aimesh->mNumFaces; k++)
+		{
+			const struct aiFace* face = &aimesh->mFaces[k];
+			for (unsigned m = 0; m < face->mNumIndices; m++)
+			{
+				indices.push_back(face->mIndices[m]);
+			}
 		}
 
-		std::vector<std::uint16_t> indices;
-		indices.insert(indices.end(), std::begin(model.GetIndices16()), std::end(model.GetIndices16()));
-
-		const UINT vbByteSize = (UINT)vertices.size() * sizeof(PrimitiveTypes::PosTexNorColVertex);
-		const UINT ibByteSize = (UINT)indices.size() * sizeof(std::uint16_t);
+		auto cacheReport = MeshOptimizer::OptimizeVertexCache(indices, vertices.size());
+		::OutputDebugStringA(cacheReport.ToString("fbx").c_str());
+		auto overdrawReport = MeshOptimizer::OptimizeOverdraw(indices, vertices, 1.05f);
+		::OutputDebugStringA(overdrawReport.ToString("fbx").c_str());
+		MeshOptimizer::OptimizeVertexFetch(vertices, indices);
 
-		auto geo = std::make_unique<MeshGeometry>();
-		geo->Name = "boxGeo";
+		auto lods = MeshSimplifier::BuildLodChain(indices, vertices, 5, 0.5f, 0.05f);
+		::OutputDebugStringA(MeshSimplifier::ToString("fbx", lods).c_str());
 
-		ThrowIfFailed(D3DCreateBlob(vbByteSize, &geo->VertexBufferCPU));
-		CopyMemory(geo->VertexBufferCPU->GetBufferPointer(), vertices.data(), vbByteSize);
+		fbx.Builder = std::make_unique<MeshBuilder>("fbx", sizeof(PrimitiveTypes::PosTexNorColVertex));
+		fbx.Builder->AddMesh("fbx", vertices, indices);
+		// Every simplified level gets its own copy of the vertices it still uses.
+		for (size_t lod = 1; lod < lods.size(); lod++)
+		{
+			std::vector<PrimitiveTypes::PosTexNorColVertex> lodVertices = vertices;
+			std::vector<std::uint32_t> lodIndices = lods[lod].Indices;
+			MeshOptimizer::OptimizeVertexCache(lodIndices, lodVertices.size());
+			MeshOptimizer::OptimizeVertexFetch(lodVertices, lodIndices);
+			fbx.Builder->AddMesh(MeshBuilder::LodName("fbx", lod), lodVertices, lodIndices, lods[lod].Error);
+		}
+	}
 
-		ThrowIfFailed(D3DCreateBlob(ibByteSize, &geo->IndexBufferCPU));
-		CopyMemory(geo->IndexBufferCPU->GetBufferPointer(), indices.data(), ibByteSize);
+	loader.FreeScene();
 
-		geo->VertexBufferGPU = D3D12Util::CreateDefaultBuffer(mD3D12Device.Get(),
-			mCommandList.Get(), vertices.data(), vbByteSize, geo->VertexBufferUploader);
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+	char message[128];
+	snprintf(message, sizeof(message), "[Demo] fbx: imported through Assimp in %.2f ms\n", elapsed.count());
+	::OutputDebugStringA(message);
+}
 
-		geo->IndexBufferGPU = D3D12Util::CreateDefaultBuffer(mD3D12Device.Get(),
-			mCommandList.Get(), indices.data(), ibByteSize, geo->IndexBufferUploader);
+void Demo::GenerateTerrain()
+{
+	// 4 km on a side, drawn within a fixed triangle budget by mTerrainQuadtree.
+	TerrainGenerator::Desc desc;
+	desc.TilesX = 32;
+	desc.TilesZ = 32;
+	desc.TileQuads = 32;
+	desc.Spacing = 4.0f;
+	desc.SkirtDepth = 2.0f;
+	desc.TextureRepeat = 512.0f;
+	desc.Color = XMFLOAT4(DirectX::Colors::DarkGreen);
+
+	// Long ridges with smaller hills on top, bounded over the whole area.
+	auto height = [](float x, float z)
+	{
+		return 40.0f * sinf(0.004f * x) * cosf(0.005f * z) + 6.0f * sinf(0.03f * x + 1.0f) * sinf(0.025f * z);
+	};
 
-		geo->VertexByteStride = sizeof(PrimitiveTypes::PosTexNorColVertex);
-		geo->VertexBufferByteSize = vbByteSize;
-		geo->IndexFormat = DXGI_FORMAT_R16_UINT;
-		geo->IndexBufferByteSize = ibByteSize;
+	auto start = std::chrono::steady_clock::now();
+	Heightfield heightfield = TerrainGenerator::GenerateHeightfield(desc, height);
+	mGeneratedTerrain = std::make_unique<ChunkedTerrain>(TerrainGenerator::Generate(heightfield, desc));
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+	::OutputDebugStringA(TerrainGenerator::ToString("terrainGeo", *mGeneratedTerrain, elapsed.count()).c_str());
+}
 
-		SubmeshGeometry submeshBox;
-		submeshBox.IndexCount = (UINT)indices.size();
-		submeshBox.StartIndexLocation = 0;
-		submeshBox.BaseVertexLocation = 0;
+void Demo::BuildGeometry()
+{
+	// The arena buffers grow with what is uploaded, these only cap them.  The
+	// terrain alone is 60 MB of vertices (1.25M of 48 bytes), and 128 MB is
+	// the size of a resource every device can create.
+	mGeometryArena = std::make_unique<GeometryArena>(mD3D12Device.Get(), 128 * 1024 * 1024, 16 * 1024 * 1024);
 
-		geo->DrawArgs["box"] = submeshBox;
-		mGeometries[geo->Name] = std::move(geo);
+	// The shapes are written straight into the vertex layout they are drawn with.
+	using ShapeWriter = GeometryWriter<PrimitiveTypes::PosTexNorColVertex>;
+	// Grid
+	{
+		auto counts = ShapeWriter::GridCounts(4, 4);
+		std::vector<PrimitiveTypes::PosTexNorColVertex> vertices(counts.VertexCount);
+		std::vector<std::uint32_t> indices(counts.IndexCount);
+		ShapeWriter::WriteGrid(vertices.data(), indices.data(), 64.0f, 64.0f, 4, 4, XMFLOAT4(DirectX::Colors::DarkGreen));
+
+		auto cacheReport = MeshOptimizer::OptimizeVertexCache(indices, vertices.size());
+		::OutputDebugStringA(cacheReport.ToString("gridGeo").c_str());
+		MeshOptimizer::OptimizeVertexFetch(vertices, indices);
+
+		MeshBuilder builder("gridGeo", sizeof(PrimitiveTypes::PosTexNorColVertex));
+		builder.AddMesh("grid", vertices, indices);
+		mGeometries["gridGeo"] = builder.Build(*mGeometryArena, mD3D12Device.Get(), mCommandList.Get());
+	}
+	// Box
+	{
+		auto counts = ShapeWriter::BoxCounts();
+		std::vector<PrimitiveTypes::PosTexNorColVertex> vertices(counts.VertexCount);
+		std::vector<std::uint32_t> indices(counts.IndexCount);
+		ShapeWriter::WriteBox(vertices.data(), indices.data(), 1.0f, 1.0f, 1.0f, XMFLOAT4(DirectX::Colors::DarkGreen));
+
+		auto cacheReport = MeshOptimizer::OptimizeVertexCache(indices, vertices.size());
+		::OutputDebugStringA(cacheReport.ToString("boxGeo").c_str());
+		auto overdrawReport = MeshOptimizer::OptimizeOverdraw(indices, vertices, 1.05f);
+		::OutputDebugStringA(overdrawReport.ToString("boxGeo").c_str());
+		MeshOptimizer::OptimizeVertexFetch(vertices, indices);
+
+		MeshBuilder builder("boxGeo", sizeof(PrimitiveTypes::PosTexNorColVertex));
+		builder.AddMesh("box", vertices, indices);
+		mGeometries["boxGeo"] = builder.Build(*mGeometryArena, mD3D12Device.Get(), mCommandList.Get());
 	}
 	// Mirror
 	{
-		GeometryGenerator::MeshData model = geoGen.CreateGrid(8.0f, 8.0f, 2, 2);
-
-		std::vector<PrimitiveTypes::PosTexNorColVertex> vertices(model.Vertices.size());
-
-		for (size_t i = 0; i < model.Vertices.size(); ++i)
-		{
-			auto& p = model.Vertices[i];
-			vertices[i].Position = { p.Position.x, p.Position.y, p.Position.z };
-			vertices[i].TexCoord = p.TexC;
-			vertices[i].Normal = p.Normal;
-			vertices[i].Color = XMFLOAT4(DirectX::Colors::DarkGreen);
-		}
-
-		std::vector<std::uint16_t> indices;
-		indices.insert(indices.end(), std::begin(model.GetIndices16()), std::end(model.GetIndices16()));
-
-		const UINT vbByteSize = (UINT)vertices.size() * sizeof(PrimitiveTypes::PosTexNorColVertex);
-		const UINT ibByteSize = (UINT)indices.size() * sizeof(std::uint16_t);
-
-		auto geo = std::make_unique<MeshGeometry>();
-		geo->Name = "mirrorGeo";
-
-		ThrowIfFailed(D3DCreateBlob(vbByteSize, &geo->VertexBufferCPU));
-		CopyMemory(geo->VertexBufferCPU->GetBufferPointer(), vertices.data(), vbByteSize);
-
-		ThrowIfFailed(D3DCreateBlob(ibByteSize, &geo->IndexBufferCPU));
-		CopyMemory(geo->IndexBufferCPU->GetBufferPointer(), indices.data(), ibByteSize);
-
-		geo->VertexBufferGPU = D3D12Util::CreateDefaultBuffer(mD3D12Device.Get(),
-			mCommandList.Get(), vertices.data(), vbByteSize, geo->VertexBufferUploader);
-
-		geo->IndexBufferGPU = D3D12Util::CreateDefaultBuffer(mD3D12Device.Get(),
-			mCommandList.Get(), indices.data(), ibByteSize, geo->IndexBufferUploader);
-
-		geo->VertexByteStride = sizeof(PrimitiveTypes::PosTexNorColVertex);
-		geo->VertexBufferByteSize = vbByteSize;
-		geo->IndexFormat = DXGI_FORMAT_R16_UINT;
-		geo->IndexBufferByteSize = ibByteSize;
-
-		SubmeshGeometry submesh;
-		submesh.IndexCount = (UINT)indices.size();
-		submesh.StartIndexLocation = 0;
-		submesh.BaseVertexLocation = 0;
-
-		geo->DrawArgs["mirror"] = submesh;
-		mGeometries[geo->Name] = std::move(geo);
+		auto counts = ShapeWriter::GridCounts(2, 2);
+		std::vector<PrimitiveTypes::PosTexNorColVertex> vertices(counts.VertexCount);
+		std::vector<std::uint32_t> indices(counts.IndexCount);
+		ShapeWriter::WriteGrid(vertices.data(), indices.data(), 8.0f, 8.0f, 2, 2, XMFLOAT4(DirectX::Colors::DarkGreen));
+
+		auto cacheReport = MeshOptimizer::OptimizeVertexCache(indices, vertices.size());
+		::OutputDebugStringA(cacheReport.ToString("mirrorGeo").c_str());
+		MeshOptimizer::OptimizeVertexFetch(vertices, indices);
+
+		MeshBuilder builder("mirrorGeo", sizeof(PrimitiveTypes::PosTexNorColVertex));
+		builder.AddMesh("mirror", vertices, indices);
+		mGeometries["mirrorGeo"] = builder.Build(*mGeometryArena, mD3D12Device.Get(), mCommandList.Get());
 	}
 	// Tree
 	{
@@ -1158,173 +1620,91 @@ void Demo::BuildGeometry()
 			8, 9, 10, 11, 12, 13, 14, 15
 		};
 
-		const UINT vbByteSize = (UINT)vertices.size() * sizeof(TreeSpriteVertex);
-		const UINT ibByteSize = (UINT)indices.size() * sizeof(std::uint16_t);
-
-		auto geo = std::make_unique<MeshGeometry>();
-		geo->Name = "treeSpritesGeo";
-
-		ThrowIfFailed(D3DCreateBlob(vbByteSize, &geo->VertexBufferCPU));
-		CopyMemory(geo->VertexBufferCPU->GetBufferPointer(), vertices.data(), vbByteSize);
-
-		ThrowIfFailed(D3DCreateBlob(ibByteSize, &geo->IndexBufferCPU));
-		CopyMemory(geo->IndexBufferCPU->GetBufferPointer(), indices.data(), ibByteSize);
-
-		geo->VertexBufferGPU = D3D12Util::CreateDefaultBuffer(mD3D12Device.Get(),
-			mCommandList.Get(), vertices.data(), vbByteSize, geo->VertexBufferUploader);
-
-		geo->IndexBufferGPU = D3D12Util::CreateDefaultBuffer(mD3D12Device.Get(),
-			mCommandList.Get(), indices.data(), ibByteSize, geo->IndexBufferUploader);
-
-		geo->VertexByteStride = sizeof(TreeSpriteVertex);
-		geo->VertexBufferByteSize = vbByteSize;
-		geo->IndexFormat = DXGI_FORMAT_R16_UINT;
-		geo->IndexBufferByteSize = ibByteSize;
-
-		SubmeshGeometry submesh;
-		submesh.IndexCount = (UINT)indices.size();
-		submesh.StartIndexLocation = 0;
-		submesh.BaseVertexLocation = 0;
-
-		geo->DrawArgs["points"] = submesh;
-
-		mGeometries["treeSpritesGeo"] = std::move(geo);
+		MeshBuilder builder("treeSpritesGeo", sizeof(TreeSpriteVertex));
+		builder.SetSplitOversizedMeshes(false);
+		builder.AddMesh("points", vertices.data(), vertices.size(), indices.data(), indices.size());
+		mGeometries["treeSpritesGeo"] = builder.Build(*mGeometryArena, mD3D12Device.Get(), mCommandList.Get());
 	}
-	// FBX
+	// FBX, imported by ImportFbx
 	{
-		Assimp::Importer loader;
-		aiMaterial* material = nullptr;
-		aiString path;
-
-		const aiScene* scene = loader.ReadFile("fbx/delicious-donut-with-sprinkles-gameready-model.quads.fbx",
-			aiProcess_Triangulate | aiProcess_CalcTangentSpace | aiProcess_JoinIdenticalVertices | aiProcess_ConvertToLeftHanded);
-
-		for (unsigned i = 0; i < scene->mNumMeshes; i++)
+		FbxImport& fbx = *mFbxImport;
+		if (fbx.Cooked)
 		{
-			aiMesh* aimesh = scene->mMeshes[i];
-
-			material = scene->mMaterials[aimesh->mMaterialIndex];
-
-			material->GetTexture(aiTextureType::aiTextureType_DIFFUSE, 0, &path);
-
-			std::vector<PrimitiveTypes::PosTexNorColVertex> vertices(aimesh->mNumVertices);
-
-			for (size_t i = 0; i < aimesh->mNumVertices; ++i)
+			auto start = std::chrono::steady_clock::now();
+			auto geo = MeshCooker::Build("fbx", *fbx.Cooked, *mGeometryArena, mD3D12Device.Get(), mCommandList.Get());
+			std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+			if (geo)
 			{
-				auto& p = aimesh->mVertices[i];
-				int uvChannelNum = aimesh->GetNumUVChannels();
-				if (uvChannelNum >= 1)
-				{
-					auto& texC = aimesh->mTextureCoords[0][i];
-					vertices[i].TexCoord = XMFLOAT2{ texC.x, texC.y };
-				}
-				int colorChannelNum = aimesh->GetNumColorChannels();
-				if (colorChannelNum >= 1)
-				{
-					auto& color = aimesh->mColors[0][i];
-					vertices[i].Color = { color.r, color.g, color.b, color.a };
-				}
-				else
-				{
-					vertices[i].Color = XMFLOAT4(DirectX::Colors::White);
-				}
-				auto& normal = aimesh->mNormals[i];
-				vertices[i].Position = { p.x, p.y, p.z };
-				vertices[i].Normal = { normal.x, normal.y, normal.z };
+				mGeometries["fbx"] = std::move(geo);
+				::OutputDebugStringA(MeshCooker::ToString("fbx", *fbx.Cooked, fbx.Milliseconds + elapsed.count()).c_str());
 			}
-			std::vector<std::uint16_t> indices;
-			for (unsigned k = 0; k < aimesh->mNumFaces; k++)
+			else
 			{
-				const struct aiFace* face = &aimesh->mFaces[k];
-				for (unsigned m = 0; m < face->mNumIndices; m++)
-				{
-					int index = face->mIndices[m];
-					indices.push_back(index);
-				}
+				// The streams did not decode, the file is damaged.  Unmapped
+				// before it is deleted, the import below cooks a new one.
+				::OutputDebugStringA(("[Demo] " + fbx.CookedPath + " is damaged, importing the source again\n").c_str());
+				fbx.Cooked.reset();
+				if (std::remove(fbx.CookedPath.c_str()) != 0)
+					::OutputDebugStringA(("[Demo] Could not delete " + fbx.CookedPath + "\n").c_str());
+				ImportFbxSource();
 			}
+		}
 
-			const UINT vbByteSize = (UINT)vertices.size() * sizeof(PrimitiveTypes::PosTexNorColVertex);
-			const UINT ibByteSize = (UINT)indices.size() * sizeof(std::uint16_t);
-
-			auto geo = std::make_unique<MeshGeometry>();
-			geo->Name = "fbx";
-
-			ThrowIfFailed(D3DCreateBlob(vbByteSize, &geo->VertexBufferCPU));
-			CopyMemory(geo->VertexBufferCPU->GetBufferPointer(), vertices.data(), vbByteSize);
-
-			ThrowIfFailed(D3DCreateBlob(ibByteSize, &geo->IndexBufferCPU));
-			CopyMemory(geo->IndexBufferCPU->GetBufferPointer(), indices.data(), ibByteSize);
-
-			geo->VertexBufferGPU = D3D12Util::CreateDefaultBuffer(mD3D12Device.Get(),
-				mCommandList.Get(), vertices.data(), vbByteSize, geo->VertexBufferUploader);
-
-			geo->IndexBufferGPU = D3D12Util::CreateDefaultBuffer(mD3D12Device.Get(),
-				mCommandList.Get(), indices.data(), ibByteSize, geo->IndexBufferUploader);
+		if (fbx.Builder)
+		{
+			mGeometries["fbx"] = fbx.Builder->Build(*mGeometryArena, mD3D12Device.Get(), mCommandList.Get());
 
-			geo->VertexByteStride = sizeof(PrimitiveTypes::PosTexNorColVertex);
-			geo->VertexBufferByteSize = vbByteSize;
-			geo->IndexFormat = DXGI_FORMAT_R16_UINT;
-			geo->IndexBufferByteSize = ibByteSize;
+			// Clustered per drawn 16-bit part, and cached with the cooked
+			// mesh in the asset cache.
+			MeshBuilder::BuildClusters(*mGeometries["fbx"], "fbx");
+			for (const MeshClusterSet* clusters : MeshBuilder::GetPartClusters(*mGeometries["fbx"], "fbx"))
+				::OutputDebugStringA(MeshClusterBuilder::ToString("fbx", *clusters).c_str());
 
-			SubmeshGeometry submesh;
-			submesh.IndexCount = (UINT)indices.size();
-			submesh.StartIndexLocation = 0;
-			submesh.BaseVertexLocation = 0;
+			const MeshGeometry& fbxGeo = *mGeometries["fbx"];
+			::OutputDebugStringA(BoundsFitter::ToString("fbx", { fbxGeo.Bounds, fbxGeo.SphereBounds, fbxGeo.OrientedBounds }).c_str());
 
-			geo->DrawArgs["fbx"] = submesh;
-			mGeometries[geo->Name] = std::move(geo);
+			if (!MeshCooker::Save(fbx.CookedPath, fbxGeo, fbx.Materials, {}, fbx.SourceStamp, true))
+				::OutputDebugStringA(("[Demo] Could not write " + fbx.CookedPath + "\n").c_str());
 		}
 
-		loader.FreeScene();
+		mFbxImport.reset();
 	}
 	// Sky
 	{
-		GeometryGenerator::MeshData model = geoGen.CreateSphere(50.0f, 20, 20);
-		std::vector<PrimitiveTypes::PosTexNorColVertex> vertices(model.Vertices.size());
-
-		for (size_t i = 0; i < model.Vertices.size(); ++i)
-		{
-			auto& p = model.Vertices[i];
-			vertices[i].Position = { p.Position.x, p.Position.y, p.Position.z };
-			vertices[i].TexCoord = p.TexC;
-			vertices[i].Normal = p.Normal;
-			vertices[i].Color = XMFLOAT4(DirectX::Colors::DarkGreen);
-		}
-
-		std::vector<std::uint16_t> indices;
-		indices.insert(indices.end(), std::begin(model.GetIndices16()), std::end(model.GetIndices16()));
-
-		const UINT vbByteSize = (UINT)vertices.size() * sizeof(PrimitiveTypes::PosTexNorColVertex);
-		const UINT ibByteSize = (UINT)indices.size() * sizeof(std::uint16_t);
-
-		auto geo = std::make_unique<MeshGeometry>();
-		geo->Name = "skyGeo";
-
-		ThrowIfFailed(D3DCreateBlob(vbByteSize, &geo->VertexBufferCPU));
-		CopyMemory(geo->VertexBufferCPU->GetBufferPointer(), vertices.data(), vbByteSize);
+		auto counts = ShapeWriter::SphereCounts(20, 20);
+		std::vector<PrimitiveTypes::PosTexNorColVertex> vertices(counts.VertexCount);
+		std::vector<std::uint32_t> indices(counts.IndexCount);
+		ShapeWriter::WriteSphere(vertices.data(), indices.data(), 50.0f, 20, 20, XMFLOAT4(DirectX::Colors::DarkGreen));
+
+		auto cacheReport = MeshOptimizer::OptimizeVertexCache(indices, vertices.size());
+		::OutputDebugStringA(cacheReport.ToString("skyGeo").c_str());
+		MeshOptimizer::OptimizeVertexFetch(vertices, indices);
+
+		MeshBuilder builder("skyGeo", sizeof(PrimitiveTypes::PosTexNorColVertex));
+		builder.AddMesh("sky", vertices, indices);
+		mGeometries["skyGeo"] = builder.Build(*mGeometryArena, mD3D12Device.Get(), mCommandList.Get());
+	}
 
-		ThrowIfFailed(D3DCreateBlob(ibByteSize, &geo->IndexBufferCPU));
-		CopyMemory(geo->IndexBufferCPU->GetBufferPointer(), indices.data(), ibByteSize);
+	// Terrain, generated by GenerateTerrain
+	{
+		const ChunkedTerrain& terrain = *mGeneratedTerrain;
+		mGeometries["terrainGeo"] = TerrainGeometry::Build("terrainGeo", terrain, *mGeometryArena, mD3D12Device.Get(), mCommandList.Get());
 
-		geo->VertexBufferGPU = D3D12Util::CreateDefaultBuffer(mD3D12Device.Get(),
-			mCommandList.Get(), vertices.data(), vbByteSize, geo->VertexBufferUploader);
+		mTerrainQuadtree.Build("terrainGeo", terrain, *mGeometries["terrainGeo"]);
+		mTerrainQuadtree.SetThreshold(2.0f, 0.25f);
+		mTerrainQuadtree.SetTriangleBudget(200000);
 
-		geo->IndexBufferGPU = D3D12Util::CreateDefaultBuffer(mD3D12Device.Get(),
-			mCommandList.Get(), indices.data(), ibByteSize, geo->IndexBufferUploader);
+		mGeneratedTerrain.reset();
+	}
 
-		geo->VertexByteStride = sizeof(PrimitiveTypes::PosTexNorColVertex);
-		geo->VertexBufferByteSize = vbByteSize;
-		geo->IndexFormat = DXGI_FORMAT_R16_UINT;
-		geo->IndexBufferByteSize = ibByteSize;
+	// All arena copies at once, Initialize flushes the queue before the
+	// first frame draws from the arena.
+	mGeometryArena->RecordUploads(mCommandList.Get());
 
-		SubmeshGeometry submeshBox;
-		submeshBox.IndexCount = (UINT)indices.size();
-		submeshBox.StartIndexLocation = 0;
-		submeshBox.BaseVertexLocation = 0;
+	for (auto& geo : mGeometries)
+		geo.second->DisposeUploaders(*mReleaseQueue, GetRecordingFence());
 
-		geo->DrawArgs["sky"] = submeshBox;
-		mGeometries[geo->Name] = std::move(geo);
-	}
+	::OutputDebugStringA(mGeometryArena->GetStatistics().c_str());
 }
 
 void Demo::BuildLandGeometry()
@@ -1391,8 +1771,17 @@ void Demo::BuildLandGeometry()
 	submesh.IndexCount = 16;
 	submesh.StartIndexLocation = 0;
 	submesh.BaseVertexLocation = 0;
+	// The Bezier surface stays inside the convex hull of its control points.
+	MeshBounds bounds = BoundsFitter::Compute(&vertices[0].x, vertices.size(), sizeof(XMFLOAT3));
+	submesh.Bounds = bounds.Box;
+	submesh.SphereBounds = bounds.Sphere;
+	submesh.OrientedBounds = bounds.OrientedBox;
+	geo->Bounds = bounds.Box;
+	geo->SphereBounds = bounds.Sphere;
+	geo->OrientedBounds = bounds.OrientedBox;
 
 	geo->DrawArgs["quadpatch"] = submesh;
+	geo->DisposeUploaders(*mReleaseQueue, GetRecordingFence());
 	mGeometries[geo->Name] = std::move(geo);
 }
 
@@ -1410,10 +1799,11 @@ void Demo::BuildDescriptorHeaps()
 	* 0-4	: tex
 	* 5		: sky
 	* 6		: shadow
+	* 7-11	: tex, the other copy
 	*/
 
 	mSrvDescriptorHeap = std::make_unique<CDescriptorHeapWrapper>();
-	mSrvDescriptorHeap->Create(mD3D12Device.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 7, true);
+	mSrvDescriptorHeap->Create(mD3D12Device.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, 12, true);
 
 	//D3D12_DESCRIPTOR_HEAP_DESC srvHeapDesc = {};
 	//srvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
@@ -1425,64 +1815,21 @@ void Demo::BuildDescriptorHeaps()
 	//
 	// Fill out the heap with actual descriptors.
 	//
-	CD3DX12_CPU_DESCRIPTOR_HANDLE hDescriptor(mSrvDescriptorHeap->hCPU(0));
+	WriteTextureTable(0);
+	WriteTextureTable(1);
 
-	auto floorTex = mTextures["tex_grid"]->Resource;
-	auto woodCrateTex = mTextures["WoodCrate01"]->Resource;
-	auto iceTex = mTextures["ice"]->Resource;
-	auto treeTex = mTextures["treeArrayTex"]->Resource;
-	auto baseColorTex = mTextures["baseColor"]->Resource;
 	auto skyTex = mTextures["skyTex"]->Resource;
 
 	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
 	srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-	srvDesc.Format = floorTex->GetDesc().Format;
-	srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-	srvDesc.Texture2D.MostDetailedMip = 0;
-	srvDesc.Texture2D.MipLevels = floorTex->GetDesc().MipLevels;
-	srvDesc.Texture2D.ResourceMinLODClamp = 0.0f;
-	mD3D12Device->CreateShaderResourceView(floorTex.Get(), &srvDesc, hDescriptor);
-
-	hDescriptor.Offset(1, mD3D12Device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV));
-	srvDesc.Format = woodCrateTex->GetDesc().Format;
-	srvDesc.Texture2D.MipLevels = woodCrateTex->GetDesc().MipLevels;
-	mD3D12Device->CreateShaderResourceView(woodCrateTex.Get(), &srvDesc, hDescriptor);
-
-	hDescriptor.Offset(1, mD3D12Device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV));
-	srvDesc.Format = iceTex->GetDesc().Format;
-	srvDesc.Texture2D.MipLevels = iceTex->GetDesc().MipLevels;
-	mD3D12Device->CreateShaderResourceView(iceTex.Get(), &srvDesc, hDescriptor);
-
-	hDescriptor.Offset(1, mD3D12Device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV));
-	srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2DARRAY;
-	srvDesc.Format = treeTex->GetDesc().Format;
-	srvDesc.Texture2DArray.MostDetailedMip = 0;
-	srvDesc.Texture2DArray.MipLevels = -1;
-	srvDesc.Texture2DArray.FirstArraySlice = 0;
-	srvDesc.Texture2DArray.ArraySize = treeTex->GetDesc().DepthOrArraySize;
-	mD3D12Device->CreateShaderResourceView(treeTex.Get(), &srvDesc, hDescriptor);
-
-	hDescriptor.Offset(1, mD3D12Device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV));
-	srvDesc = {};
-	srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-	srvDesc.Format = baseColorTex->GetDesc().Format;
-	srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-	srvDesc.Texture2D.MostDetailedMip = 0;
-	srvDesc.Texture2D.MipLevels = baseColorTex->GetDesc().MipLevels;
-	srvDesc.Texture2D.ResourceMinLODClamp = 0.0f;
-	mD3D12Device->CreateShaderResourceView(baseColorTex.Get(), &srvDesc, hDescriptor);
-
-	hDescriptor.Offset(1, mD3D12Device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV));
-	srvDesc = {};
-	srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
 	srvDesc.Format = skyTex->GetDesc().Format;
 	srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURECUBE;
 	srvDesc.TextureCube.MostDetailedMip = 0;
 	srvDesc.TextureCube.MipLevels = skyTex->GetDesc().MipLevels;
 	srvDesc.TextureCube.ResourceMinLODClamp = 0.0f;
-	mD3D12Device->CreateShaderResourceView(skyTex.Get(), &srvDesc, hDescriptor);
-
 	mSkyTexHeapIndex = 5;
+	mD3D12Device->CreateShaderResourceView(skyTex.Get(), &srvDesc, mSrvDescriptorHeap->hCPU(mSkyTexHeapIndex));
+
 	mShadowTexHeapIndex = mSkyTexHeapIndex + 1;
 
 	mShadowMap->BuildDescriptors(
@@ -1492,6 +1839,130 @@ void Demo::BuildDescriptorHeaps()
 	);
 }
 
+void Demo::StreamTextures()
+{
+	mStreamer->Request(BaseColorFile, [this](AssetStreamer::Payload& payload)
+	{
+		auto& streamed = static_cast<D3D12StreamingDevice::TexturePayload&>(payload);
+		auto tex = std::make_unique<Texture>();
+		tex->Name = "baseColor";
+		tex->Filename = AnsiToWString(BaseColorFile);
+		tex->Resource = streamed.Resource;
+
+		// No material pointed at the slot so far, so no frame in flight
+		// reads the views that are replaced.
+		const D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = TextureViewDesc(tex->Resource.Get());
+		for (UINT base : TextureTableBases)
+			mD3D12Device->CreateShaderResourceView(tex->Resource.Get(), &srvDesc, mSrvDescriptorHeap->hCPU(base + BaseColorHeapIndex));
+		mTextures[tex->Name] = std::move(tex);
+		AddResidentTexture("baseColor", BaseColorHeapIndex, streamed.Texture);
+
+		Material* baseColorMat = mMaterials["baseColorMat"].get();
+		baseColorMat->DiffuseSrvHeapIndex = BaseColorHeapIndex;
+		baseColorMat->NumFramesDirty = gNumFrameResources;
+	});
+}
+
+void Demo::WriteTextureTable(UINT table)
+{
+	for (UINT i = 0; i < _countof(TextureTableNames); ++i)
+	{
+		auto tex = mTextures.find(TextureTableNames[i]);
+		ID3D12Resource* resource = tex != mTextures.end() ? tex->second->Resource.Get() : nullptr;
+		const D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = TextureViewDesc(resource);
+		mD3D12Device->CreateShaderResourceView(resource, &srvDesc, mSrvDescriptorHeap->hCPU(TextureTableBases[table] + i));
+	}
+}
+
+void Demo::AddResidentTexture(const std::string& name, UINT heapIndex, AssetDatabase::DecodedTexture& source)
+{
+	const D3D12_RESOURCE_DESC desc = source.Resource->GetDesc();
+	if (source.Shared || desc.Dimension != D3D12_RESOURCE_DIMENSION_TEXTURE2D || desc.DepthOrArraySize != 1 ||
+		desc.MipLevels < 2 || source.Subresources.size() != desc.MipLevels)
+	{
+		source = AssetDatabase::DecodedTexture();
+		return;
+	}
+
+	std::vector<TextureResidency::uint64> levelBytes(desc.MipLevels);
+	for (UINT level = 0; level < desc.MipLevels; ++level)
+		mD3D12Device->GetCopyableFootprints(&desc, level, 1, 0, nullptr, nullptr, nullptr, &levelBytes[level]);
+
+	// The first level of a resource has to be whole blocks.
+	const bool blocks = BlockCompressor::GetBlockBytes((DdsFile::Format)desc.Format) > 0;
+	UINT tailMip = 0;
+	for (UINT level = 1; level < desc.MipLevels; ++level)
+	{
+		const UINT width = std::max(1u, (UINT)(desc.Width >> level));
+		const UINT height = std::max(1u, desc.Height >> level);
+		if (std::max(width, height) < MinResidentLevelSize || (blocks && (width % 4 != 0 || height % 4 != 0)))
+			break;
+		tailMip = level;
+	}
+
+	ResidentTexture resident;
+	resident.Name = name;
+	resident.HeapIndex = heapIndex;
+	resident.Desc = desc;
+	resident.Source = std::move(source);
+	// The texture holds the resource, the source only its levels.
+	resident.Source.Resource = nullptr;
+	mTextureResidency.Add(levelBytes, tailMip, 0, AssetDatabase::GetSourceBytes(resident.Source));
+	mResidentTextures.push_back(std::move(resident));
+}
+
+void Demo::ApplyTextureResidency()
+{
+	if (mResidencyChanges.empty())
+		return;
+
+	for (const auto& change : mResidencyChanges)
+	{
+		const ResidentTexture& resident = mResidentTextures[change.Id];
+		D3D12_RESOURCE_DESC desc = resident.Desc;
+		desc.Width = std::max<UINT64>(1, resident.Desc.Width >> change.FirstMip);
+		desc.Height = std::max(1u, resident.Desc.Height >> change.FirstMip);
+		desc.MipLevels = (UINT16)(resident.Desc.MipLevels - change.FirstMip);
+
+		ComPtr<ID3D12Resource> resource;
+		ThrowIfFailed(mD3D12Device->CreateCommittedResource(
+			&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+			D3D12_HEAP_FLAG_NONE,
+			&desc,
+			D3D12_RESOURCE_STATE_COPY_DEST,
+			nullptr,
+			IID_PPV_ARGS(resource.GetAddressOf())));
+
+		ComPtr<ID3D12Resource> upload;
+		ThrowIfFailed(mD3D12Device->CreateCommittedResource(
+			&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+			D3D12_HEAP_FLAG_NONE,
+			&CD3DX12_RESOURCE_DESC::Buffer(GetRequiredIntermediateSize(resource.Get(), 0, desc.MipLevels)),
+			D3D12_RESOURCE_STATE_GENERIC_READ,
+			nullptr,
+			IID_PPV_ARGS(upload.GetAddressOf())));
+
+		// The levels that were resident already are small next to the new
+		// one and are copied again.
+		UpdateSubresources(mCommandList.Get(), resource.Get(), upload.Get(), 0, 0, desc.MipLevels,
+			resident.Source.Subresources.data() + change.FirstMip);
+		mCommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(resource.Get(),
+			D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE));
+
+		// Frames in flight still read the old resource, this one uses the
+		// upload buffer.
+		Texture& tex = *mTextures[resident.Name];
+		mAssets->ForgetTexture(tex.Resource.Get());
+		mReleaseQueue->Retire(std::move(tex.Resource), GetRecordingFence());
+		mReleaseQueue->Retire(std::move(upload), GetRecordingFence());
+		tex.Resource = resource;
+	}
+	mResidencyChanges.clear();
+
+	mTextureTable = 1 - mTextureTable;
+	WriteTextureTable(mTextureTable);
+}
+
 void Demo::BuildRenderItems()
 {
 	auto gridRitem = std::make_unique<RenderItem>();
@@ -1503,6 +1974,7 @@ void Demo::BuildRenderItems()
 	gridRitem->IndexCount = gridRitem->Geo->DrawArgs["grid"].IndexCount;
 	gridRitem->StartIndexLocation = gridRitem->Geo->DrawArgs["grid"].StartIndexLocation;
 	gridRitem->BaseVertexLocation = gridRitem->Geo->DrawArgs["grid"].BaseVertexLocation;
+	gridRitem->Bounds = gridRitem->Geo->DrawArgs["grid"].OrientedBounds;
 	gridRitem->InstanceCount = 1;
 	gridRitem->Instances.resize(1);
 	gridRitem->Instances[0].World = gridRitem->World;
@@ -1519,6 +1991,7 @@ void Demo::BuildRenderItems()
 	boxRitem->IndexCount = boxRitem->Geo->DrawArgs["box"].IndexCount;
 	boxRitem->StartIndexLocation = boxRitem->Geo->DrawArgs["box"].StartIndexLocation;
 	boxRitem->BaseVertexLocation = boxRitem->Geo->DrawArgs["box"].BaseVertexLocation;
+	boxRitem->Bounds = boxRitem->Geo->DrawArgs["box"].OrientedBounds;
 	boxRitem->InstanceCount = 1;
 	boxRitem->Instances.resize(1);
 	boxRitem->Instances[0].World = boxRitem->World;
@@ -1546,6 +2019,7 @@ void Demo::BuildRenderItems()
 	mirrorItem->IndexCount = mirrorItem->Geo->DrawArgs["mirror"].IndexCount;
 	mirrorItem->StartIndexLocation = mirrorItem->Geo->DrawArgs["mirror"].StartIndexLocation;
 	mirrorItem->BaseVertexLocation = mirrorItem->Geo->DrawArgs["mirror"].BaseVertexLocation;
+	mirrorItem->Bounds = mirrorItem->Geo->DrawArgs["mirror"].OrientedBounds;
 	mirrorItem->InstanceCount = 1;
 	mirrorItem->Instances.resize(1);
 	mirrorItem->Instances[0].World = mirrorItem->World;
@@ -1563,6 +2037,7 @@ void Demo::BuildRenderItems()
 	treeSpritesRitem->IndexCount = treeSpritesRitem->Geo->DrawArgs["points"].IndexCount;
 	treeSpritesRitem->StartIndexLocation = treeSpritesRitem->Geo->DrawArgs["points"].StartIndexLocation;
 	treeSpritesRitem->BaseVertexLocation = treeSpritesRitem->Geo->DrawArgs["points"].BaseVertexLocation;
+	treeSpritesRitem->Bounds = treeSpritesRitem->Geo->DrawArgs["points"].OrientedBounds;
 	treeSpritesRitem->InstanceCount = 1;
 	treeSpritesRitem->Instances.resize(1);
 	treeSpritesRitem->Instances[0].World = treeSpritesRitem->World;
@@ -1579,6 +2054,7 @@ void Demo::BuildRenderItems()
 	quadPatchRitem->IndexCount = quadPatchRitem->Geo->DrawArgs["quadpatch"].IndexCount;
 	quadPatchRitem->StartIndexLocation = quadPatchRitem->Geo->DrawArgs["quadpatch"].StartIndexLocation;
 	quadPatchRitem->BaseVertexLocation = quadPatchRitem->Geo->DrawArgs["quadpatch"].BaseVertexLocation;
+	quadPatchRitem->Bounds = quadPatchRitem->Geo->DrawArgs["quadpatch"].OrientedBounds;
 	quadPatchRitem->InstanceCount = 1;
 	quadPatchRitem->Instances.resize(1);
 	quadPatchRitem->Instances[0].World = quadPatchRitem->World;
@@ -1595,6 +2071,12 @@ void Demo::BuildRenderItems()
 	fbxRitem->IndexCount = fbxRitem->Geo->DrawArgs["fbx"].IndexCount;
 	fbxRitem->StartIndexLocation = fbxRitem->Geo->DrawArgs["fbx"].StartIndexLocation;
 	fbxRitem->BaseVertexLocation = fbxRitem->Geo->DrawArgs["fbx"].BaseVertexLocation;
+	auto fbxParts = MeshBuilder::GetDrawArgParts(*fbxRitem->Geo, "fbx");
+	fbxRitem->ExtraParts.assign(fbxParts.begin() + 1, fbxParts.end());
+	fbxRitem->Lods = MeshBuilder::GetLodChain(*fbxRitem->Geo, "fbx");
+	fbxRitem->Clusters = MeshBuilder::GetPartClusters(*fbxRitem->Geo, "fbx");
+	// Covers all levels and split parts.
+	fbxRitem->Bounds = fbxRitem->Geo->OrientedBounds;
 	fbxRitem->InstanceCount = 5;
 	fbxRitem->Instances.resize(5);
 	for (int i = 0; i < 5; i++)
@@ -1615,12 +2097,29 @@ void Demo::BuildRenderItems()
 	SkyRitem->IndexCount = SkyRitem->Geo->DrawArgs["sky"].IndexCount;
 	SkyRitem->StartIndexLocation = SkyRitem->Geo->DrawArgs["sky"].StartIndexLocation;
 	SkyRitem->BaseVertexLocation = SkyRitem->Geo->DrawArgs["sky"].BaseVertexLocation;
+	SkyRitem->Bounds = SkyRitem->Geo->DrawArgs["sky"].OrientedBounds;
 	SkyRitem->InstanceCount = 1;
 	SkyRitem->Instances.resize(1);
 	SkyRitem->Instances[0].World = SkyRitem->World;
 	SkyRitem->Instances[0].MaterialIndex = SkyRitem->Mat->MaterialIndex;
 	mRitemLayer[(int)RenderLayer::Sky].push_back(SkyRitem.get());
 
+	auto terrainRitem = std::make_unique<RenderItem>();
+	XMStoreFloat4x4(&terrainRitem->World, XMMatrixTranslation(0.0f, -30.0f, 0.0f));
+	terrainRitem->ObjCBIndex = 7;
+	terrainRitem->Mat = mMaterials["floor"].get();
+	terrainRitem->Geo = mGeometries["terrainGeo"].get();
+	terrainRitem->PrimitiveType = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	// The tile draws are filled in by UpdateTerrain.
+	terrainRitem->IndexCount = 0;
+	terrainRitem->Bounds = terrainRitem->Geo->OrientedBounds;
+	terrainRitem->InstanceCount = 1;
+	terrainRitem->Instances.resize(1);
+	terrainRitem->Instances[0].World = terrainRitem->World;
+	terrainRitem->Instances[0].MaterialIndex = terrainRitem->Mat->MaterialIndex;
+	mRitemLayer[(int)RenderLayer::Terrain].push_back(terrainRitem.get());
+	mTerrainRitem = terrainRitem.get();
+
 	mAllRitems.push_back(std::move(gridRitem));
 	mAllRitems.push_back(std::move(boxRitem));
 	mAllRitems.push_back(std::move(reflectedBoxRitem));
@@ -1629,6 +2128,7 @@ void Demo::BuildRenderItems()
 	mAllRitems.push_back(std::move(quadPatchRitem));
 	mAllRitems.push_back(std::move(fbxRitem));
 	mAllRitems.push_back(std::move(SkyRitem));
+	mAllRitems.push_back(std::move(terrainRitem));
 }
 
 void Demo::BuildPSO()
@@ -1899,30 +2399,38 @@ void Demo::DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const std::vector
 	UINT matCBByteSize = sizeof(MaterialData)/*D3D12Util::CalcConstantBufferByteSize(sizeof(MaterialData))*/;
 
 	auto matCB = mCurrFrameResource->MaterialCB->Resource();
+	D3D12_VERTEX_BUFFER_VIEW lastVbv = {};
+	D3D12_INDEX_BUFFER_VIEW lastIbv = {};
 	// For each render item...
 	for (size_t i = 0; i < ritems.size(); ++i)
 	{
 		auto ri = ritems[i];
 		auto objectCB = mCurrFrameResource->InstanceBuffer[ri]->Resource();
 
-		cmdList->IASetVertexBuffers(0, 1, &ri->Geo->VertexBufferView());
-		cmdList->IASetIndexBuffer(&ri->Geo->IndexBufferView());
+		// Geometry in the arena shares its buffers, only rebind when they change.
+		D3D12_VERTEX_BUFFER_VIEW vbv = ri->Geo->VertexBufferView();
+		D3D12_INDEX_BUFFER_VIEW ibv = ri->Geo->IndexBufferView();
+		if (i == 0 || memcmp(&vbv, &lastVbv, sizeof(vbv)) != 0)
+			cmdList->IASetVertexBuffers(0, 1, &vbv);
+		if (i == 0 || memcmp(&ibv, &lastIbv, sizeof(ibv)) != 0)
+			cmdList->IASetIndexBuffer(&ibv);
+		lastVbv = vbv;
+		lastIbv = ibv;
 		cmdList->IASetPrimitiveTopology(ri->PrimitiveType);
 
-		cmdList->SetGraphicsRootDescriptorTable(3, mSrvDescriptorHeap->hGPU(ri->Mat->DiffuseSrvHeapIndex));
-
-		D3D12_GPU_VIRTUAL_ADDRESS objAddress = objectCB->GetGPUVirtualAddress();
-		cmdList->SetGraphicsRootShaderResourceView(0, objAddress);
+		cmdList->SetGraphicsRootDescriptorTable(3, mSrvDescriptorHeap->hGPU(TextureTableBases[mTextureTable] + ri->Mat->DiffuseSrvHeapIndex));
 
 		D3D12_GPU_VIRTUAL_ADDRESS matAddress = matCB->GetGPUVirtualAddress() + ri->Mat->MaterialIndex * matCBByteSize;
 		cmdList->SetGraphicsRootShaderResourceView(2, matAddress);
 
-		cmdList->DrawIndexedInstanced(ri->IndexCount, ri->InstanceCount, ri->StartIndexLocation, ri->BaseVertexLocation, 0);
+		DrawRenderItemInstances(cmdList, ri, objectCB->GetGPUVirtualAddress());
 	}
 }
 
 void Demo::DrawRenderItemsNew(ID3D12GraphicsCommandList* cmdList, const std::vector<RenderItem*>& ritems)
 {
+	D3D12_VERTEX_BUFFER_VIEW lastVbv = {};
+	D3D12_INDEX_BUFFER_VIEW lastIbv = {};
 	// For each render item...
 	for (size_t i = 0; i < ritems.size(); ++i)
 	{
@@ -1930,14 +2438,41 @@ void Demo::DrawRenderItemsNew(ID3D12GraphicsCommandList* cmdList, const std::vec
 
 		auto objectCB = mCurrFrameResource->InstanceBuffer[ri]->Resource();
 
-		cmdList->IASetVertexBuffers(0, 1, &ri->Geo->VertexBufferView());
-		cmdList->IASetIndexBuffer(&ri->Geo->IndexBufferView());
+		// Geometry in the arena shares its buffers, only rebind when they change.
+		D3D12_VERTEX_BUFFER_VIEW vbv = ri->Geo->VertexBufferView();
+		D3D12_INDEX_BUFFER_VIEW ibv = ri->Geo->IndexBufferView();
+		if (i == 0 || memcmp(&vbv, &lastVbv, sizeof(vbv)) != 0)
+			cmdList->IASetVertexBuffers(0, 1, &vbv);
+		if (i == 0 || memcmp(&ibv, &lastIbv, sizeof(ibv)) != 0)
+			cmdList->IASetIndexBuffer(&ibv);
+		lastVbv = vbv;
+		lastIbv = ibv;
 		cmdList->IASetPrimitiveTopology(ri->PrimitiveType);
 
-		D3D12_GPU_VIRTUAL_ADDRESS objAddress = objectCB->GetGPUVirtualAddress();
-		cmdList->SetGraphicsRootShaderResourceView(0, objAddress);
+		DrawRenderItemInstances(cmdList, ri, objectCB->GetGPUVirtualAddress());
+	}
+}
+
+void Demo::DrawRenderItemInstances(ID3D12GraphicsCommandList* cmdList, const RenderItem* ri, D3D12_GPU_VIRTUAL_ADDRESS instanceAddress)
+{
+	if (ri->LodDraws.empty())
+	{
+		cmdList->SetGraphicsRootShaderResourceView(0, instanceAddress);
 
 		cmdList->DrawIndexedInstanced(ri->IndexCount, ri->InstanceCount, ri->StartIndexLocation, ri->BaseVertexLocation, 0);
+		for (const auto& part : ri->ExtraParts)
+			cmdList->DrawIndexedInstanced(part.IndexCount, ri->InstanceCount, part.StartIndexLocation, part.BaseVertexLocation, 0);
+		return;
+	}
+
+	// SV_InstanceID restarts at 0 for every draw, so the instance buffer
+	// view is moved to the first instance of each level instead.
+	for (const auto& draw : ri->LodDraws)
+	{
+		cmdList->SetGraphicsRootShaderResourceView(0, instanceAddress + draw.FirstInstance * sizeof(InstanceData));
+
+		for (const auto& part : ri->Lods[draw.Lod].Parts)
+			cmdList->DrawIndexedInstanced(part.IndexCount, draw.InstanceCount, part.StartIndexLocation, part.BaseVertexLocation, 0);
 	}
 }
 
@@ -2062,19 +2597,23 @@ void Demo::BuildComputeBuffers()
 
 	UINT64 byteSize = NumDataElements * sizeof(Data);
 
+	ComPtr<ID3D12Resource> uploadBufferA;
 	mComputeInputBufferA = D3D12Util::CreateDefaultBuffer(
 		mD3D12Device.Get(),
 		mCommandList.Get(),
 		dataA.data(),
 		byteSize,
-		mComputeInputUploadBufferA);
+		uploadBufferA);
+	mReleaseQueue->Retire(std::move(uploadBufferA), GetRecordingFence());
 
+	ComPtr<ID3D12Resource> uploadBufferB;
 	mComputeInputBufferB = D3D12Util::CreateDefaultBuffer(
 		mD3D12Device.Get(),
 		mCommandList.Get(),
 		dataB.data(),
 		byteSize,
-		mComputeInputUploadBufferB);
+		uploadBufferB);
+	mReleaseQueue->Retire(std::move(uploadBufferB), GetRecordingFence());
 
 	mD3D12Device->CreateCommittedResource(
 		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
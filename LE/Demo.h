@@ -6,6 +6,15 @@
 #include "D3D12InputLayouts.h"
 #include "Camera.h"
 #include "ShadowMap.h"
+#include "GeometryArena.h"
+#include "AssetDatabase.h"
+#include "AssetStreamer.h"
+#include "D3D12StreamingDevice.h"
+#include "DeferredReleaseQueue.h"
+#include "TaskGraph.h"
+#include "LodSelector.h"
+#include "TerrainQuadtree.h"
+#include "TextureResidency.h"
 #include <DirectXColors.h>
 
 using namespace DirectX;
@@ -21,9 +30,13 @@ enum class RenderLayer : int
 	Shadow,
 	Tessellation,
 	Sky,
+	Terrain,
 	Count
 };
 
+// The model as imported on a worker thread, see Demo::ImportFbx.
+struct FbxImport;
+
 class Demo : public D3D12App
 {
 public:
@@ -55,6 +68,11 @@ public:
 	void ProcessInput();
 	void UpdateCamera();
 	void UpdateObjectCBs();
+	void UpdateInstanceLods(RenderItem& ritem);
+	void UpdateClusterCulling();
+	void UpdateTerrain();
+	void UpdateWorldBounds();
+	void UpdateTextureResidency();
 	void UpdateShadowTransform();
 	void UpdateMainPassCB();
 	void UpdateReflectedMainPassCB();
@@ -63,6 +81,13 @@ public:
 
 	void CalculateFrameStats();
 
+	// Run as tasks of the startup TaskGraph in Initialize.  The ones before
+	// LoadTextures only need the device or the CPU and run in parallel.
+	void DecodeTexture(UINT i);
+	void CompileShader(UINT i);
+	void ImportFbx();
+	void ImportFbxSource();
+	void GenerateTerrain();
 	void LoadTextures();
 	void BuildMaterials();
 	void BuildRootSignature();
@@ -73,6 +98,8 @@ public:
 	void BuildFrameResources();
 	void BuildDescriptorHeaps();
 	void BuildPSO();
+	// After startup: requests what is streamed in while the demo runs.
+	void StreamTextures();
 
 	struct Data
 	{
@@ -83,8 +110,15 @@ public:
 	void BuildComputeBuffers();
 	void DoComputeWork();
 
+	// Puts the textures of mTextures in one of the two copies of the table.
+	void WriteTextureTable(UINT table);
+	// The textures get the changes of mTextureResidency on their own resource.
+	void AddResidentTexture(const std::string& name, UINT heapIndex, AssetDatabase::DecodedTexture& source);
+	void ApplyTextureResidency();
+
 	void DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const std::vector<RenderItem*>& ritems);
 	void DrawRenderItemsNew(ID3D12GraphicsCommandList* cmdList, const std::vector<RenderItem*>& ritems);
+	void DrawRenderItemInstances(ID3D12GraphicsCommandList* cmdList, const RenderItem* ri, D3D12_GPU_VIRTUAL_ADDRESS instanceAddress);
 	void DrawSceneToShadowMap();
 
 	std::array<const CD3DX12_STATIC_SAMPLER_DESC, 7> GetStaticSamplers();
@@ -92,6 +126,9 @@ public:
 private:
 	void PrepareUI();
 
+	// Fence value the commands recorded on mCommandList now are done at.
+	UINT64 GetRecordingFence() const { return mCurrentFence + 1; }
+
 private:
 	std::vector<std::unique_ptr<FrameResource>> mFrameResources;
 	FrameResource* mCurrFrameResource = nullptr;
@@ -101,9 +138,25 @@ private:
 	std::unique_ptr<CDescriptorHeapWrapper> mSrvDescriptorHeap = nullptr;
 
 	std::unordered_map<std::string, ComPtr<ID3DBlob>> mShaders;
+	// Compiled shaders, decoded textures and cooked meshes of earlier runs.
+	std::unique_ptr<AssetDatabase> mAssets;
+	// Shared buffers for the static geometry in mGeometries.
+	std::unique_ptr<GeometryArena> mGeometryArena;
 	std::unordered_map<std::string, std::unique_ptr<MeshGeometry>> mGeometries;
 	std::unordered_map<std::string, std::unique_ptr<Material>> mMaterials;
 	std::unordered_map<std::string, std::unique_ptr<Texture>> mTextures;
+	// Upload buffers and replaced resources until the GPU is done with them.
+	std::unique_ptr<DeferredReleaseQueue> mReleaseQueue;
+	// Loads textures in the background after startup, the device first so
+	// the streamer goes before it.
+	std::unique_ptr<D3D12StreamingDevice> mStreamingDevice;
+	std::unique_ptr<AssetStreamer> mStreamer;
+
+	// Results of the parallel startup tasks, released once Initialize used them.
+	std::vector<AssetDatabase::DecodedTexture> mDecodedTextures;
+	std::vector<ComPtr<ID3DBlob>> mCompiledShaders;
+	std::unique_ptr<FbxImport> mFbxImport;
+	std::unique_ptr<ChunkedTerrain> mGeneratedTerrain;
 
 	/*InputLayout*/
 	std::vector<D3D12_INPUT_ELEMENT_DESC> mDefaultInputLayout;
@@ -133,7 +186,26 @@ private:
 	POINT mLastMousePos;
 #pragma endregion
 
+	LodSelector mLodSelector;
+	bool mEnableLod = true;
+	// Triangles of the items with LODs in the last update, and what they would be at full detail.
+	UINT mLodTrianglesSubmitted = 0;
+	UINT mLodTrianglesFullDetail = 0;
+
+	// Result of culling the clusters of the clustered items against the main
+	// camera.  The draws are instanced over whole parts, so the culling only
+	// runs while its statistics are shown, and the compacted index lists in
+	// mCulledIndices are scratch.
+	bool mShowClusterStats = false;
+	MeshClusterBuilder::CullStats mClusterStats;
+	std::vector<std::uint32_t> mCulledIndices;
+
+	// Picks the terrain tiles' levels of detail for the main camera.
+	TerrainQuadtree mTerrainQuadtree;
+	RenderItem* mTerrainRitem = nullptr;
+
 	std::unique_ptr<ShadowMap> mShadowMap;
+	// Bounds of the shadow casters, fitted by UpdateWorldBounds.
 	DirectX::BoundingSphere mSceneBounds;
 	float mLightNearZ = 0.0f;
 	float mLightFarZ = 0.0f;
@@ -149,9 +221,7 @@ private:
 	int NumDataElements = 32;
 	ComPtr<ID3D12RootSignature> mComputeRootSignature = nullptr;
 	ComPtr<ID3D12Resource> mComputeInputBufferA = nullptr;
-	ComPtr<ID3D12Resource> mComputeInputUploadBufferA = nullptr;
 	ComPtr<ID3D12Resource> mComputeInputBufferB = nullptr;
-	ComPtr<ID3D12Resource> mComputeInputUploadBufferB = nullptr;
 	ComPtr<ID3D12Resource> mComputeOutputBuffer = nullptr;
 	ComPtr<ID3D12Resource> mComputeReadBackBuffer = nullptr;
 
@@ -161,4 +231,29 @@ private:
 
 	UINT mSkyTexHeapIndex = 0;
 	UINT mShadowTexHeapIndex = 0;
+
+	// The 2D material textures keep the mip levels mTextureResidency asks
+	// for.  A texture changing levels gets a new resource with just those,
+	// uploaded from Source.
+	struct ResidentTexture
+	{
+		std::string Name;
+		UINT HeapIndex = 0;
+		D3D12_RESOURCE_DESC Desc;
+		// All levels on the CPU, mapped from the file where possible.  What
+		// is not mapped counts as TextureResidency::Stats::SourceBytes.
+		AssetDatabase::DecodedTexture Source;
+	};
+	TextureResidency mTextureResidency{ TextureResidency::Options() };
+	// By TextureResidency::TextureId.
+	std::vector<ResidentTexture> mResidentTextures;
+	// From the last TextureResidency::Update, recorded by the next Draw.
+	std::vector<TextureResidency::Change> mResidencyChanges;
+	int mTextureBudgetMB = 64;
+
+	// The material textures are bound through one of two copies of their
+	// table.  New views go into the copy no frame in flight uses, which is
+	// then bound, so a view is never replaced while the GPU may read it.
+	UINT mTextureTable = 0;
+	UINT64 mTextureTableFences[2] = {};
 };
\ No newline at end of file
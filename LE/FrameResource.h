@@ -36,6 +36,38 @@ struct RenderItem
 	UINT InstanceCount = 0;
 	UINT StartIndexLocation = 0;
 	int BaseVertexLocation = 0;
+
+	// Meshes too large for 16-bit indices are split by MeshBuilder, the
+	// remaining parts are drawn right after the one above with the same state.
+	std::vector<SubmeshGeometry> ExtraParts;
+
+	// Levels of detail, Lods[0] being the full mesh.  Empty for items drawn
+	// without LOD selection, which use the parameters above instead.
+	std::vector<MeshLod> Lods;
+	// Level each instance uses, kept between frames for the hysteresis.
+	std::vector<UINT> InstanceLods;
+
+	// The instance buffer holds the instances sorted by level (InstanceOrder
+	// maps its slots back to Instances), one draw per level in use.
+	struct LodDraw
+	{
+		UINT Lod = 0;
+		UINT FirstInstance = 0;
+		UINT InstanceCount = 0;
+	};
+	std::vector<UINT> InstanceOrder;
+	std::vector<LodDraw> LodDraws;
+
+	// Clusters of each part of the full detail mesh (Lods[0].Parts), for
+	// per view culling.  Owned by Geo, empty for items without clusters.
+	std::vector<const MeshClusterSet*> Clusters;
+
+	// Object space bounds of the draw, and the world space box of each
+	// instance.  WorldBounds is only refreshed while WorldBoundsDirty is set,
+	// so set it whenever Bounds or the instance transforms change.
+	DirectX::BoundingOrientedBox Bounds;
+	std::vector<DirectX::BoundingBox> WorldBounds;
+	bool WorldBoundsDirty = true;
 };
 
 struct FrameResource
@@ -0,0 +1,140 @@
+#include "FreeListAllocator.h"
+#include <cassert>
+#include <iterator>
+
+const FreeListAllocator::uint64 FreeListAllocator::InvalidOffset;
+
+FreeListAllocator::FreeListAllocator(uint64 capacity)
+	:
+	mCapacity(capacity)
+{
+	Reset();
+}
+
+void FreeListAllocator::Reset()
+{
+	mFreeByOffset.clear();
+	mFreeBySize.clear();
+	mAllocations.clear();
+	mUsedSize = 0;
+
+	if (mCapacity > 0)
+		InsertFreeBlock(0, mCapacity);
+}
+
+FreeListAllocator::uint64 FreeListAllocator::Allocate(uint64 size, uint64 alignment)
+{
+	assert(alignment > 0);
+	if (size == 0)
+		return InvalidOffset;
+
+	// Smallest block that still fits once the start is aligned.  Usually the
+	// first candidate, the alignment padding is at most alignment - 1.
+	for (auto candidate = mFreeBySize.lower_bound(size); candidate != mFreeBySize.end(); ++candidate)
+	{
+		uint64 blockOffset = candidate->second;
+		uint64 blockSize = candidate->first;
+
+		uint64 offset = (blockOffset + alignment - 1) / alignment * alignment;
+		uint64 padding = offset - blockOffset;
+		if (padding + size > blockSize)
+			continue;
+
+		RemoveFreeBlock(mFreeByOffset.find(blockOffset));
+
+		// Give the padding in front and the tail back to the free list.
+		if (padding > 0)
+			InsertFreeBlock(blockOffset, padding);
+		if (padding + size < blockSize)
+			InsertFreeBlock(offset + size, blockSize - padding - size);
+
+		mAllocations[offset] = size;
+		mUsedSize += size;
+		return offset;
+	}
+
+	return InvalidOffset;
+}
+
+void FreeListAllocator::Free(uint64 offset)
+{
+	auto allocation = mAllocations.find(offset);
+	assert(allocation != mAllocations.end());
+	if (allocation == mAllocations.end())
+		return;
+
+	uint64 size = allocation->second;
+	mAllocations.erase(allocation);
+	mUsedSize -= size;
+
+	// Merge with the free neighbours on both sides.
+	auto next = mFreeByOffset.lower_bound(offset);
+	if (next != mFreeByOffset.end() && next->first == offset + size)
+	{
+		size += next->second;
+		next = std::next(next);
+		RemoveFreeBlock(std::prev(next));
+	}
+
+	if (next != mFreeByOffset.begin())
+	{
+		auto prev = std::prev(next);
+		if (prev->first + prev->second == offset)
+		{
+			offset = prev->first;
+			size += prev->second;
+			RemoveFreeBlock(prev);
+		}
+	}
+
+	InsertFreeBlock(offset, size);
+}
+
+void FreeListAllocator::Grow(uint64 newCapacity)
+{
+	if (newCapacity <= mCapacity)
+		return;
+
+	uint64 offset = mCapacity;
+	uint64 size = newCapacity - mCapacity;
+	mCapacity = newCapacity;
+
+	if (!mFreeByOffset.empty())
+	{
+		auto last = std::prev(mFreeByOffset.end());
+		if (last->first + last->second == offset)
+		{
+			offset = last->first;
+			size += last->second;
+			RemoveFreeBlock(last);
+		}
+	}
+
+	InsertFreeBlock(offset, size);
+}
+
+FreeListAllocator::uint64 FreeListAllocator::GetLargestFreeBlock() const
+{
+	return mFreeBySize.empty() ? 0 : mFreeBySize.rbegin()->first;
+}
+
+void FreeListAllocator::InsertFreeBlock(uint64 offset, uint64 size)
+{
+	mFreeByOffset[offset] = size;
+	mFreeBySize.insert(std::make_pair(size, offset));
+}
+
+void FreeListAllocator::RemoveFreeBlock(std::map<uint64, uint64>::iterator it)
+{
+	auto range = mFreeBySize.equal_range(it->second);
+	for (auto bySize = range.first; bySize != range.second; ++bySize)
+	{
+		if (bySize->second == it->first)
+		{
+			mFreeBySize.erase(bySize);
+			break;
+		}
+	}
+
+	mFreeByOffset.erase(it);
+}
\ No newline at end of file
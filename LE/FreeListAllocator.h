@@ -0,0 +1,67 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+
+// Sub-allocates ranges of an abstract [0, capacity) address space.  It only
+// does the bookkeeping, so the same allocator serves GPU buffers, heaps or
+// anything else addressed by offsets, and does not depend on D3D12.
+//
+// Free blocks are kept by offset (to merge neighbours on Free) and by size
+// (best fit on Allocate).
+class FreeListAllocator
+{
+public:
+	using uint64 = std::uint64_t;
+
+	// Returned by Allocate when no free block is large enough.
+	static const uint64 InvalidOffset = ~0ull;
+
+	explicit FreeListAllocator(uint64 capacity);
+	FreeListAllocator(const FreeListAllocator& rhs) = delete;
+	FreeListAllocator& operator=(const FreeListAllocator& rhs) = delete;
+
+	///<summary>
+	/// Returns the offset of a range of size units aligned to alignment (any
+	/// non-zero value, not only powers of two), or InvalidOffset.
+	///</summary>
+	uint64 Allocate(uint64 size, uint64 alignment = 1);
+
+	///<summary>
+	/// Returns a range handed out by Allocate.
+	///</summary>
+	void Free(uint64 offset);
+
+	///<summary>
+	/// Adds [capacity, newCapacity) to the free space, merged with a free
+	/// block at the end.  Allocations keep their offsets.
+	///</summary>
+	void Grow(uint64 newCapacity);
+
+	///<summary>
+	/// Drops every allocation.
+	///</summary>
+	void Reset();
+
+	uint64 GetCapacity() const { return mCapacity; }
+	uint64 GetUsedSize() const { return mUsedSize; }
+	uint64 GetFreeSize() const { return mCapacity - mUsedSize; }
+	uint64 GetLargestFreeBlock() const;
+	size_t GetAllocationCount() const { return mAllocations.size(); }
+	size_t GetFreeBlockCount() const { return mFreeByOffset.size(); }
+
+private:
+	void InsertFreeBlock(uint64 offset, uint64 size);
+	void RemoveFreeBlock(std::map<uint64, uint64>::iterator it);
+
+	uint64 mCapacity = 0;
+	uint64 mUsedSize = 0;
+
+	// offset -> size
+	std::map<uint64, uint64> mFreeByOffset;
+	// size -> offset
+	std::multimap<uint64, uint64> mFreeBySize;
+	// offset -> size of the live allocations
+	std::unordered_map<uint64, uint64> mAllocations;
+};
\ No newline at end of file
@@ -0,0 +1,283 @@
+#include "GeometryArena.h"
+#include "HashUtil.h"
+#include "MeshGeometry.h"
+#include <algorithm>
+#include <cstring>
+
+const UINT GeometryArena::IndexAlignment;
+
+GeometryArena::GeometryArena(ID3D12Device* device, UINT64 maxVertexBufferByteSize, UINT64 maxIndexBufferByteSize)
+	:
+	mDevice(device),
+	mMaxVertexBufferByteSize(maxVertexBufferByteSize)
+{
+	// The index allocator works in bytes, the vertex allocators in vertices.
+	mIndexBuffer.Allocator = std::make_unique<FreeListAllocator>(0);
+	mIndexBuffer.MaxCapacity = maxIndexBufferByteSize;
+}
+
+void GeometryArena::CreateResource(Buffer& buffer, UINT64 byteSize)
+{
+	ThrowIfFailed(mDevice->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+		D3D12_HEAP_FLAG_NONE,
+		&CD3DX12_RESOURCE_DESC::Buffer(byteSize),
+		D3D12_RESOURCE_STATE_COMMON,
+		nullptr,
+		IID_PPV_ARGS(buffer.Resource.ReleaseAndGetAddressOf())));
+
+	buffer.State = D3D12_RESOURCE_STATE_COMMON;
+	buffer.ByteSize = byteSize;
+}
+
+GeometryArena::Buffer& GeometryArena::GetVertexBuffer(UINT vertexByteStride)
+{
+	Buffer& buffer = mVertexBuffers[vertexByteStride];
+	if (!buffer.Allocator)
+	{
+		buffer.Allocator = std::make_unique<FreeListAllocator>(0);
+		buffer.UnitByteSize = vertexByteStride;
+		buffer.MaxCapacity = mMaxVertexBufferByteSize / vertexByteStride;
+	}
+
+	return buffer;
+}
+
+UINT64 GeometryArena::Allocate(Buffer& buffer, UINT64 size, UINT64 alignment)
+{
+	UINT64 offset = buffer.Allocator->Allocate(size, alignment);
+	if (offset != FreeListAllocator::InvalidOffset)
+		return offset;
+	if (size > buffer.MaxCapacity - buffer.Allocator->GetUsedSize())
+		return FreeListAllocator::InvalidOffset;
+
+	// Grow by what the range needs at most, the resource follows in
+	// RecordUploads.
+	const UINT64 capacity = std::min(buffer.Allocator->GetCapacity() + size + alignment - 1, buffer.MaxCapacity);
+	buffer.Allocator->Grow(capacity);
+	return buffer.Allocator->Allocate(size, alignment);
+}
+
+bool GeometryArena::Upload(MeshGeometry& geo, const void* vertexData, UINT vertexByteSize,
+	const void* indexData, UINT indexByteSize)
+{
+	const UINT stride = geo.VertexByteStride;
+	assert(stride > 0 && vertexByteSize % stride == 0);
+
+	// The GPU is done with the arena by now, buffers replaced by the last
+	// RecordUploads can go.
+	mRetired.clear();
+
+	Buffer& vertexBuffer = GetVertexBuffer(stride);
+
+	HashUtil::uint64 contentHash = HashUtil::HashBytes(vertexData, vertexByteSize, stride);
+	contentHash = HashUtil::HashBytes(indexData, indexByteSize, contentHash ^ geo.IndexFormat);
+	HashUtil::uint64 checkHash = HashUtil::HashBytes(vertexData, vertexByteSize, ~(HashUtil::uint64)stride);
+	checkHash = HashUtil::HashBytes(indexData, indexByteSize, ~checkHash ^ geo.IndexFormat);
+
+	// A hash hit is only shared if the content matches too, a collision
+	// gets its own ranges.
+	auto candidates = mShared.equal_range(contentHash);
+	for (auto shared = candidates.first; shared != candidates.second; ++shared)
+	{
+		SharedRanges& ranges = shared->second;
+		if (ranges.VertexByteStride != stride || ranges.IndexFormat != geo.IndexFormat ||
+			ranges.VertexByteSize != vertexByteSize || ranges.IndexByteSize != indexByteSize ||
+			ranges.CheckHash != checkHash ||
+			(ranges.VertexData && memcmp(ranges.VertexData->GetBufferPointer(), vertexData, vertexByteSize) != 0) ||
+			(ranges.IndexData && memcmp(ranges.IndexData->GetBufferPointer(), indexData, indexByteSize) != 0))
+		{
+			continue;
+		}
+
+		ranges.RefCount++;
+		mSharedUploads++;
+		geo.VertexBufferUploader = nullptr;
+		geo.IndexBufferUploader = nullptr;
+		Attach(geo, ranges.FirstVertex, ranges.IndexByteOffset);
+		return true;
+	}
+
+	UINT64 firstVertex = Allocate(vertexBuffer, vertexByteSize / stride, 1);
+	if (firstVertex == FreeListAllocator::InvalidOffset)
+		return false;
+
+	UINT64 indexByteOffset = Allocate(mIndexBuffer, indexByteSize, IndexAlignment);
+	if (indexByteOffset == FreeListAllocator::InvalidOffset)
+	{
+		vertexBuffer.Allocator->Free(firstVertex);
+		return false;
+	}
+
+	// One staging buffer for both copies, the indices follow the vertices.
+	const UINT64 stagingIndexOffset = (vertexByteSize + IndexAlignment - 1) / IndexAlignment * IndexAlignment;
+	ThrowIfFailed(mDevice->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+		D3D12_HEAP_FLAG_NONE,
+		&CD3DX12_RESOURCE_DESC::Buffer(stagingIndexOffset + indexByteSize),
+		D3D12_RESOURCE_STATE_GENERIC_READ,
+		nullptr,
+		IID_PPV_ARGS(geo.VertexBufferUploader.ReleaseAndGetAddressOf())));
+	geo.IndexBufferUploader = nullptr;
+
+	BYTE* mapped = nullptr;
+	ThrowIfFailed(geo.VertexBufferUploader->Map(0, nullptr, reinterpret_cast<void**>(&mapped)));
+	memcpy(mapped, vertexData, vertexByteSize);
+	memcpy(mapped + stagingIndexOffset, indexData, indexByteSize);
+	geo.VertexBufferUploader->Unmap(0, nullptr);
+
+	mPendingCopies.push_back({ &vertexBuffer, firstVertex * stride, geo.VertexBufferUploader, 0, vertexByteSize });
+	mPendingCopies.push_back({ &mIndexBuffer, indexByteOffset, geo.VertexBufferUploader, stagingIndexOffset, indexByteSize });
+
+	SharedRanges& ranges = mShared.emplace(contentHash, SharedRanges())->second;
+	ranges.FirstVertex = firstVertex;
+	ranges.IndexByteOffset = indexByteOffset;
+	ranges.VertexByteStride = stride;
+	ranges.IndexFormat = geo.IndexFormat;
+	ranges.VertexByteSize = vertexByteSize;
+	ranges.IndexByteSize = indexByteSize;
+	ranges.CheckHash = checkHash;
+	// Only blobs the data was read from, anything else may change.
+	if (geo.VertexBufferCPU && geo.VertexBufferCPU->GetBufferPointer() == vertexData)
+		ranges.VertexData = geo.VertexBufferCPU;
+	if (geo.IndexBufferCPU && geo.IndexBufferCPU->GetBufferPointer() == indexData)
+		ranges.IndexData = geo.IndexBufferCPU;
+	ranges.RefCount = 1;
+	mContentHashes[indexByteOffset] = contentHash;
+
+	Attach(geo, firstVertex, indexByteOffset);
+	return true;
+}
+
+void GeometryArena::RecordUploads(ID3D12GraphicsCommandList* cmdList)
+{
+	if (mPendingCopies.empty())
+		return;
+
+	// The buffers touched, each transitioned once however many copies go
+	// into it.
+	std::vector<Buffer*> destinations;
+	for (const auto& copy : mPendingCopies)
+	{
+		if (std::find(destinations.begin(), destinations.end(), copy.Destination) == destinations.end())
+			destinations.push_back(copy.Destination);
+	}
+
+	// Buffers that grew get a new resource, with the contents of the old
+	// one copied to its start.
+	std::vector<PendingCopy> moves;
+	for (Buffer* buffer : destinations)
+	{
+		const UINT64 byteSize = buffer->Allocator->GetCapacity() * buffer->UnitByteSize;
+		if (byteSize <= buffer->ByteSize)
+			continue;
+
+		Microsoft::WRL::ComPtr<ID3D12Resource> old = buffer->Resource;
+		const UINT64 oldByteSize = buffer->ByteSize;
+		CreateResource(*buffer, byteSize);
+		if (old)
+		{
+			moves.push_back({ buffer, 0, old, 0, oldByteSize });
+			mRetired.push_back(old);
+		}
+	}
+
+	std::vector<D3D12_RESOURCE_BARRIER> barriers;
+	for (Buffer* buffer : destinations)
+		barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(buffer->Resource.Get(), buffer->State, D3D12_RESOURCE_STATE_COPY_DEST));
+	cmdList->ResourceBarrier((UINT)barriers.size(), barriers.data());
+
+	// The old buffers are in GENERIC_READ, which copies read from.
+	for (const auto& copy : moves)
+	{
+		cmdList->CopyBufferRegion(copy.Destination->Resource.Get(), copy.DestinationOffset,
+			copy.Staging.Get(), copy.StagingOffset, copy.ByteSize);
+	}
+	for (const auto& copy : mPendingCopies)
+	{
+		cmdList->CopyBufferRegion(copy.Destination->Resource.Get(), copy.DestinationOffset,
+			copy.Staging.Get(), copy.StagingOffset, copy.ByteSize);
+	}
+
+	barriers.clear();
+	for (Buffer* buffer : destinations)
+	{
+		barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(buffer->Resource.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_GENERIC_READ));
+		buffer->State = D3D12_RESOURCE_STATE_GENERIC_READ;
+	}
+	cmdList->ResourceBarrier((UINT)barriers.size(), barriers.data());
+
+	mPendingCopies.clear();
+
+	for (MeshGeometry* geo : mGeometries)
+		Bind(*geo);
+}
+
+void GeometryArena::Attach(MeshGeometry& geo, UINT64 firstVertex, UINT64 indexByteOffset)
+{
+	const UINT indexSize = geo.IndexFormat == DXGI_FORMAT_R32_UINT ? 4 : 2;
+
+	geo.Arena = this;
+	geo.ArenaFirstVertex = firstVertex;
+	geo.ArenaIndexByteOffset = indexByteOffset;
+
+	for (auto& drawArg : geo.DrawArgs)
+	{
+		drawArg.second.BaseVertexLocation += (INT)firstVertex;
+		drawArg.second.StartIndexLocation += (UINT)(indexByteOffset / indexSize);
+	}
+
+	mGeometries.push_back(&geo);
+	Bind(geo);
+}
+
+void GeometryArena::Bind(MeshGeometry& geo)
+{
+	// Point the handle at the shared buffers, null until they are created.
+	const Buffer& vertexBuffer = mVertexBuffers[geo.VertexByteStride];
+	geo.VertexBufferGPU = vertexBuffer.Resource;
+	geo.IndexBufferGPU = mIndexBuffer.Resource;
+	geo.VertexBufferByteSize = (UINT)vertexBuffer.ByteSize;
+	geo.IndexBufferByteSize = (UINT)mIndexBuffer.ByteSize;
+}
+
+void GeometryArena::Free(MeshGeometry& geo)
+{
+	assert(geo.Arena == this);
+
+	auto contentHash = mContentHashes.find(geo.ArenaIndexByteOffset);
+	auto candidates = mShared.equal_range(contentHash->second);
+	auto shared = std::find_if(candidates.first, candidates.second,
+		[&geo](const std::pair<const std::uint64_t, SharedRanges>& entry) { return entry.second.IndexByteOffset == geo.ArenaIndexByteOffset; });
+	assert(shared != candidates.second);
+
+	if (--shared->second.RefCount == 0)
+	{
+		mVertexBuffers[geo.VertexByteStride].Allocator->Free(geo.ArenaFirstVertex);
+		mIndexBuffer.Allocator->Free(geo.ArenaIndexByteOffset);
+		mShared.erase(shared);
+		mContentHashes.erase(contentHash);
+	}
+
+	mGeometries.erase(std::find(mGeometries.begin(), mGeometries.end(), &geo));
+
+	geo.VertexBufferGPU = nullptr;
+	geo.IndexBufferGPU = nullptr;
+	geo.Arena = nullptr;
+}
+
+std::string GeometryArena::GetStatistics() const
+{
+	std::ostringstream oss;
+	oss << "[GeometryArena]";
+	for (const auto& vertexBuffer : mVertexBuffers)
+	{
+		const FreeListAllocator& allocator = *vertexBuffer.second.Allocator;
+		oss << " stride " << vertexBuffer.first << ": " << allocator.GetUsedSize() << "/" << allocator.GetCapacity()
+			<< " vertices in " << allocator.GetAllocationCount() << " meshes (" << vertexBuffer.second.ByteSize / 1024 << " KB),";
+	}
+	oss << " indices: " << mIndexBuffer.Allocator->GetUsedSize() << "/" << mIndexBuffer.Allocator->GetCapacity() << " bytes,"
+		<< " " << mSharedUploads << " uploads shared\n";
+
+	return oss.str();
+}
\ No newline at end of file
@@ -0,0 +1,130 @@
+#pragma once
+#include "D3D12Util.h"
+#include "FreeListAllocator.h"
+
+struct MeshGeometry;
+
+// Static geometry storage shared by all meshes: one vertex buffer per vertex
+// stride and one index buffer, each sub-allocated with a FreeListAllocator.
+// A MeshGeometry uploaded here is only a handle to its ranges; its buffer
+// views cover the whole shared buffers and its DrawArgs are rebased onto
+// them, so draws of different meshes with the same vertex format and index
+// format can share one IASetVertexBuffers/IASetIndexBuffer.
+//
+// The buffers start empty and grow to what the meshes uploaded to them need,
+// up to the sizes given to the constructor.  A buffer that grew is created
+// again by RecordUploads, with the old contents copied over, and the
+// geometries in it are pointed at the new one.
+//
+// Uploads are deduplicated by content: a mesh whose vertices and indices
+// are already in the arena shares their ranges instead of copying them again.
+// The content is found by hash and told apart from a collision by a second,
+// independent hash, and byte by byte against the CPU blobs it was uploaded
+// from when there are any.  The arena keeps no copy of its own.
+class GeometryArena
+{
+public:
+	// Index ranges are aligned so 16 and 32-bit indices can share the buffer.
+	static const UINT IndexAlignment = 4;
+
+	GeometryArena(ID3D12Device* device, UINT64 maxVertexBufferByteSize, UINT64 maxIndexBufferByteSize);
+	GeometryArena(const GeometryArena& rhs) = delete;
+	GeometryArena& operator=(const GeometryArena& rhs) = delete;
+
+	///<summary>
+	/// Copies the vertices and indices of geo into the arena.  geo must have
+	/// VertexByteStride, IndexFormat and mesh relative DrawArgs filled in.
+	/// Returns false and leaves geo untouched if the arena is full.  The data
+	/// is staged in geo->VertexBufferUploader, which has to stay alive until
+	/// the command list of the next RecordUploads executed.  Content that is
+	/// already in the arena is shared and not copied.  The buffer views of
+	/// geo are valid once RecordUploads ran, and geo must stay where it is
+	/// until Free, RecordUploads may point it at grown buffers.
+	///</summary>
+	bool Upload(MeshGeometry& geo, const void* vertexData, UINT vertexByteSize,
+		const void* indexData, UINT indexByteSize);
+
+	///<summary>
+	/// Records the copies of every Upload since the last call on cmdList,
+	/// with one transition of each shared buffer around all of them, and
+	/// creates the buffers that grew.  The buffers are written in place, so
+	/// the GPU must not be using the arena: upload at load time and flush the
+	/// queue before the first frame draws from it, or flush it before
+	/// uploading again.
+	///</summary>
+	void RecordUploads(ID3D12GraphicsCommandList* cmdList);
+
+	///<summary>
+	/// Returns the ranges of geo to the arena once no other geometry shares
+	/// them.  The GPU must be done with them.
+	///</summary>
+	void Free(MeshGeometry& geo);
+
+	std::string GetStatistics() const;
+
+private:
+	struct Buffer
+	{
+		Microsoft::WRL::ComPtr<ID3D12Resource> Resource;
+		std::unique_ptr<FreeListAllocator> Allocator;
+		D3D12_RESOURCE_STATES State = D3D12_RESOURCE_STATE_COMMON;
+		// Of Resource, which may lag behind the allocator until RecordUploads.
+		UINT64 ByteSize = 0;
+		// Bytes per allocator unit: the vertex stride, or 1 for indices.
+		UINT64 UnitByteSize = 1;
+		// Units the allocator may grow to.
+		UINT64 MaxCapacity = 0;
+	};
+
+	// Ranges uploaded once and used by RefCount geometries.
+	struct SharedRanges
+	{
+		UINT64 FirstVertex = 0;
+		UINT64 IndexByteOffset = 0;
+		UINT VertexByteStride = 0;
+		DXGI_FORMAT IndexFormat = DXGI_FORMAT_UNKNOWN;
+		UINT VertexByteSize = 0;
+		UINT IndexByteSize = 0;
+		// To tell a hash collision: a second hash of the content, and the
+		// blobs of the geometry that uploaded it if it came from them.
+		std::uint64_t CheckHash = 0;
+		Microsoft::WRL::ComPtr<ID3DBlob> VertexData;
+		Microsoft::WRL::ComPtr<ID3DBlob> IndexData;
+		UINT RefCount = 0;
+	};
+
+	// A copy from a staging buffer waiting for RecordUploads.
+	struct PendingCopy
+	{
+		Buffer* Destination = nullptr;
+		UINT64 DestinationOffset = 0;
+		Microsoft::WRL::ComPtr<ID3D12Resource> Staging;
+		UINT64 StagingOffset = 0;
+		UINT64 ByteSize = 0;
+	};
+
+	void CreateResource(Buffer& buffer, UINT64 byteSize);
+	Buffer& GetVertexBuffer(UINT vertexByteStride);
+	UINT64 Allocate(Buffer& buffer, UINT64 size, UINT64 alignment);
+	void Attach(MeshGeometry& geo, UINT64 firstVertex, UINT64 indexByteOffset);
+	void Bind(MeshGeometry& geo);
+
+	ID3D12Device* mDevice = nullptr;
+	UINT64 mMaxVertexBufferByteSize = 0;
+
+	// Keyed by vertex stride, created on first use.
+	std::unordered_map<UINT, Buffer> mVertexBuffers;
+	Buffer mIndexBuffer;
+
+	// Keyed by content hash, and the content hash by index byte offset,
+	// which is unique per upload.  Colliding content has one entry each.
+	std::unordered_multimap<std::uint64_t, SharedRanges> mShared;
+	std::unordered_map<UINT64, std::uint64_t> mContentHashes;
+	UINT mSharedUploads = 0;
+
+	// Everything attached, to point at the buffers when they grow.
+	std::vector<MeshGeometry*> mGeometries;
+	std::vector<PendingCopy> mPendingCopies;
+	// Buffers replaced by larger ones, until the GPU copied them over.
+	std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>> mRetired;
+};
\ No newline at end of file
@@ -4,6 +4,7 @@
 
 #include "GeometryGenerator.h"
 #include <algorithm>
+#include <unordered_map>
 
 using namespace DirectX;
 
@@ -274,6 +275,71 @@ void GeometryGenerator::Subdivide(MeshData& meshData)
 	}
 }
 
+void GeometryGenerator::SubdivideShared(MeshData& meshData)
+{
+	// Same split as Subdivide, but every edge midpoint is looked up by its edge
+	// key first, so the two triangles sharing an edge also share the new vertex.
+	std::vector<uint32> inputIndices;
+	inputIndices.swap(meshData.Indices32);
+
+	uint32 numTris = (uint32)inputIndices.size()/3;
+
+	// A closed mesh has 3T/2 edges, so that is how many midpoints get added.
+	size_t numEdges = (size_t)numTris*3/2;
+	meshData.Vertices.reserve(meshData.Vertices.size() + numEdges);
+	meshData.Indices32.reserve((size_t)numTris*12);
+
+	std::unordered_map<uint64, uint32> midPointCache;
+	midPointCache.reserve(numEdges);
+
+	auto getMidPoint = [&](uint32 i0, uint32 i1)
+	{
+		// The key must not depend on the winding the edge is visited with.
+		uint64 key = i0 < i1 ?
+			((uint64)i0 << 32) | i1 :
+			((uint64)i1 << 32) | i0;
+
+		auto it = midPointCache.find(key);
+		if(it != midPointCache.end())
+			return it->second;
+
+		Vertex m = MidPoint(meshData.Vertices[i0], meshData.Vertices[i1]);
+
+		uint32 index = (uint32)meshData.Vertices.size();
+		meshData.Vertices.push_back(m);
+		midPointCache.emplace(key, index);
+
+		return index;
+	};
+
+	for(uint32 i = 0; i < numTris; ++i)
+	{
+		uint32 v0 = inputIndices[i*3+0];
+		uint32 v1 = inputIndices[i*3+1];
+		uint32 v2 = inputIndices[i*3+2];
+
+		uint32 m0 = getMidPoint(v0, v1);
+		uint32 m1 = getMidPoint(v1, v2);
+		uint32 m2 = getMidPoint(v0, v2);
+
+		meshData.Indices32.push_back(v0);
+		meshData.Indices32.push_back(m0);
+		meshData.Indices32.push_back(m2);
+
+		meshData.Indices32.push_back(m0);
+		meshData.Indices32.push_back(m1);
+		meshData.Indices32.push_back(m2);
+
+		meshData.Indices32.push_back(m2);
+		meshData.Indices32.push_back(m1);
+		meshData.Indices32.push_back(v2);
+
+		meshData.Indices32.push_back(m0);
+		meshData.Indices32.push_back(v1);
+		meshData.Indices32.push_back(m1);
+	}
+}
+
 GeometryGenerator::Vertex GeometryGenerator::MidPoint(const Vertex& v0, const Vertex& v1)
 {
     XMVECTOR p0 = XMLoadFloat3(&v0.Position);
@@ -304,12 +370,13 @@ GeometryGenerator::Vertex GeometryGenerator::MidPoint(const Vertex& v0, const Ve
     return v;
 }
 
-GeometryGenerator::MeshData GeometryGenerator::CreateGeosphere(float radius, uint32 numSubdivisions)
+GeometryGenerator::MeshData GeometryGenerator::CreateGeosphere(float radius, uint32 numSubdivisions, bool shareVertices)
 {
     MeshData meshData;
 
-	// Put a cap on the number of subdivisions.
-    numSubdivisions = std::min<uint32>(numSubdivisions, 6u);
+	// Put a cap on the number of subdivisions.  The shared path only grows by
+	// 4x per level, so it can afford two more levels than the duplicating one.
+    numSubdivisions = std::min<uint32>(numSubdivisions, shareVertices ? 8u : 6u);
 
 	// Approximate a sphere by tessellating an icosahedron.
 
@@ -341,7 +408,12 @@ GeometryGenerator::MeshData GeometryGenerator::CreateGeosphere(float radius, uin
 		meshData.Vertices[i].Position = pos[i];
 
 	for(uint32 i = 0; i < numSubdivisions; ++i)
-		Subdivide(meshData);
+	{
+		if(shareVertices)
+			SubdivideShared(meshData);
+		else
+			Subdivide(meshData);
+	}
 
 	// Project vertices onto sphere and scale.
 	for(uint32 i = 0; i < meshData.Vertices.size(); ++i)
@@ -24,6 +24,7 @@ public:
 
     using uint16 = std::uint16_t;
     using uint32 = std::uint32_t;
+    using uint64 = std::uint64_t;
 
 	struct Vertex
 	{
@@ -88,9 +89,11 @@ public:
 
 	///<summary>
 	/// Creates a geosphere centered at the origin with the given radius.  The
-	/// depth controls the level of tessellation.
+	/// depth controls the level of tessellation.  With shareVertices the edge
+	/// midpoints are cached and reused by both adjacent triangles, so the result
+	/// is a watertight indexed mesh (about 4x vertices per level instead of 6x).
 	///</summary>
-    MeshData CreateGeosphere(float radius, uint32 numSubdivisions);
+    MeshData CreateGeosphere(float radius, uint32 numSubdivisions, bool shareVertices = true);
 
 	///<summary>
 	/// Creates a cylinder parallel to the y-axis, and centered about the origin.  
@@ -112,6 +115,7 @@ public:
 
 private:
 	void Subdivide(MeshData& meshData);
+	void SubdivideShared(MeshData& meshData);
     Vertex MidPoint(const Vertex& v0, const Vertex& v1);
     void BuildCylinderTopCap(float bottomRadius, float topRadius, float height, uint32 sliceCount, uint32 stackCount, MeshData& meshData);
     void BuildCylinderBottomCap(float bottomRadius, float topRadius, float height, uint32 sliceCount, uint32 stackCount, MeshData& meshData);
@@ -0,0 +1,454 @@
+#pragma once
+#include <DirectXMath.h>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+// Which of the attributes the generators produce a vertex layout has room
+// for, found by member name: Position (required, float3), Normal, TangentU,
+// TexCoord or TexC, and Color (float4).
+template<typename TVertex>
+class VertexLayoutTraits
+{
+	template<typename...>
+	struct VoidType { using type = void; };
+
+	template<typename T, typename = void> struct NormalMember : std::false_type {};
+	template<typename T> struct NormalMember<T, typename VoidType<decltype(std::declval<T&>().Normal)>::type> : std::true_type {};
+	template<typename T, typename = void> struct TangentMember : std::false_type {};
+	template<typename T> struct TangentMember<T, typename VoidType<decltype(std::declval<T&>().TangentU)>::type> : std::true_type {};
+	template<typename T, typename = void> struct TexCoordMember : std::false_type {};
+	template<typename T> struct TexCoordMember<T, typename VoidType<decltype(std::declval<T&>().TexCoord)>::type> : std::true_type {};
+	template<typename T, typename = void> struct TexCMember : std::false_type {};
+	template<typename T> struct TexCMember<T, typename VoidType<decltype(std::declval<T&>().TexC)>::type> : std::true_type {};
+	template<typename T, typename = void> struct ColorMember : std::false_type {};
+	template<typename T> struct ColorMember<T, typename VoidType<decltype(std::declval<T&>().Color)>::type> : std::true_type {};
+
+public:
+	static const bool HasNormal = NormalMember<TVertex>::value;
+	static const bool HasTangentU = TangentMember<TVertex>::value;
+	static const bool HasTexCoord = TexCoordMember<TVertex>::value;
+	static const bool HasTexC = TexCMember<TVertex>::value && !HasTexCoord;
+	static const bool HasColor = ColorMember<TVertex>::value;
+
+	static_assert(std::is_same<decltype(std::declval<TVertex&>().Position), DirectX::XMFLOAT3>::value,
+		"GeometryWriter needs a float3 Position");
+};
+
+// Counterpart of GeometryGenerator that writes each shape straight into the
+// target vertex layout and index width instead of going through MeshData and
+// a conversion loop.  The destination can be any memory large enough for the
+// counts returned by the matching *Counts function, a mapped upload buffer
+// as well as a vector.
+//
+// Attributes the layout has no member for are neither stored nor computed.
+// The shapes, vertex order and winding match GeometryGenerator; the subdivided
+// box and the geosphere are only available there.
+template<typename TVertex, typename TIndex = std::uint32_t>
+class GeometryWriter
+{
+	static_assert(std::is_same<TIndex, std::uint16_t>::value || std::is_same<TIndex, std::uint32_t>::value,
+		"GeometryWriter writes 16 or 32-bit indices");
+
+public:
+	using uint32 = std::uint32_t;
+	using Layout = VertexLayoutTraits<TVertex>;
+
+	struct Counts
+	{
+		uint32 VertexCount = 0;
+		uint32 IndexCount = 0;
+	};
+
+	static Counts BoxCounts()
+	{
+		return MakeCounts(24, 36);
+	}
+
+	static Counts SphereCounts(uint32 sliceCount, uint32 stackCount)
+	{
+		return MakeCounts((stackCount - 1) * (sliceCount + 1) + 2, sliceCount * 6 + (stackCount - 2) * sliceCount * 6);
+	}
+
+	static Counts CylinderCounts(uint32 sliceCount, uint32 stackCount)
+	{
+		return MakeCounts((stackCount + 1) * (sliceCount + 1) + 2 * (sliceCount + 2), stackCount * sliceCount * 6 + 2 * sliceCount * 3);
+	}
+
+	static Counts GridCounts(uint32 m, uint32 n)
+	{
+		return MakeCounts(m * n, (m - 1) * (n - 1) * 6);
+	}
+
+	static Counts QuadCounts()
+	{
+		return MakeCounts(4, 6);
+	}
+
+	///<summary>
+	/// Same as GeometryGenerator::CreateBox without subdivisions.
+	///</summary>
+	static Counts WriteBox(TVertex* vertices, TIndex* indices, float width, float height, float depth,
+		const DirectX::XMFLOAT4& color = DefaultColor())
+	{
+		const float w2 = 0.5f * width;
+		const float h2 = 0.5f * height;
+		const float d2 = 0.5f * depth;
+
+		// Position, normal, tangent and texture coordinates of the 4 corners of each face.
+		const float faces[24][11] =
+		{
+			// Front
+			{ -w2, -h2, -d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f },
+			{ -w2, +h2, -d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f },
+			{ +w2, +h2, -d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f },
+			{ +w2, -h2, -d2, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f },
+			// Back
+			{ -w2, -h2, +d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 1.0f },
+			{ +w2, -h2, +d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f },
+			{ +w2, +h2, +d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f },
+			{ -w2, +h2, +d2, 0.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f },
+			// Top
+			{ -w2, +h2, -d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f },
+			{ -w2, +h2, +d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f },
+			{ +w2, +h2, +d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f },
+			{ +w2, +h2, -d2, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f },
+			// Bottom
+			{ -w2, -h2, -d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f, 1.0f },
+			{ +w2, -h2, -d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f },
+			{ +w2, -h2, +d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f },
+			{ -w2, -h2, +d2, 0.0f, -1.0f, 0.0f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f },
+			// Left
+			{ -w2, -h2, +d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 1.0f },
+			{ -w2, +h2, +d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f },
+			{ -w2, +h2, -d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 1.0f, 0.0f },
+			{ -w2, -h2, -d2, -1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 1.0f, 1.0f },
+			// Right
+			{ +w2, -h2, -d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f },
+			{ +w2, +h2, -d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f },
+			{ +w2, +h2, +d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f },
+			{ +w2, -h2, +d2, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f },
+		};
+
+		for (uint32 i = 0; i < 24; ++i)
+		{
+			const float* f = faces[i];
+			WriteVertex(vertices[i], DirectX::XMFLOAT3(f[0], f[1], f[2]), DirectX::XMFLOAT3(f[3], f[4], f[5]),
+				DirectX::XMFLOAT3(f[6], f[7], f[8]), DirectX::XMFLOAT2(f[9], f[10]), color);
+		}
+
+		for (uint32 face = 0; face < 6; ++face)
+		{
+			const uint32 base = face * 4;
+			TIndex* out = indices + face * 6;
+			out[0] = Index(base); out[1] = Index(base + 1); out[2] = Index(base + 2);
+			out[3] = Index(base); out[4] = Index(base + 2); out[5] = Index(base + 3);
+		}
+
+		return BoxCounts();
+	}
+
+	///<summary>
+	/// Same as GeometryGenerator::CreateSphere.
+	///</summary>
+	static Counts WriteSphere(TVertex* vertices, TIndex* indices, float radius, uint32 sliceCount, uint32 stackCount,
+		const DirectX::XMFLOAT4& color = DefaultColor())
+	{
+		using namespace DirectX;
+
+		const Counts counts = SphereCounts(sliceCount, stackCount);
+		CheckIndexWidth(counts);
+
+		TVertex* v = vertices;
+		WriteVertex(*v++, XMFLOAT3(0.0f, +radius, 0.0f), XMFLOAT3(0.0f, +1.0f, 0.0f), XMFLOAT3(1.0f, 0.0f, 0.0f), XMFLOAT2(0.0f, 0.0f), color);
+
+		const float phiStep = XM_PI / stackCount;
+		const float thetaStep = 2.0f * XM_PI / sliceCount;
+		for (uint32 i = 1; i <= stackCount - 1; ++i)
+		{
+			const float phi = i * phiStep;
+			const float sinPhi = sinf(phi);
+			const float cosPhi = cosf(phi);
+
+			for (uint32 j = 0; j <= sliceCount; ++j)
+			{
+				const float theta = j * thetaStep;
+				const float sinTheta = sinf(theta);
+				const float cosTheta = cosf(theta);
+
+				TVertex& vertex = *v++;
+				vertex.Position = XMFLOAT3(radius * sinPhi * cosTheta, radius * cosPhi, radius * sinPhi * sinTheta);
+
+				if (Layout::HasNormal)
+				{
+					XMFLOAT3 normal;
+					XMStoreFloat3(&normal, XMVector3Normalize(XMLoadFloat3(&vertex.Position)));
+					SetNormal(vertex, normal, HasNormalTag());
+				}
+				if (Layout::HasTangentU)
+				{
+					// Partial derivative of P with respect to theta.
+					XMFLOAT3 tangent(-radius * sinPhi * sinTheta, 0.0f, +radius * sinPhi * cosTheta);
+					XMStoreFloat3(&tangent, XMVector3Normalize(XMLoadFloat3(&tangent)));
+					SetTangent(vertex, tangent, HasTangentTag());
+				}
+				SetTexCoord(vertex, XMFLOAT2(theta / XM_2PI, phi / XM_PI), TexCoordTag());
+				SetColor(vertex, color, HasColorTag());
+			}
+		}
+
+		WriteVertex(*v++, XMFLOAT3(0.0f, -radius, 0.0f), XMFLOAT3(0.0f, -1.0f, 0.0f), XMFLOAT3(1.0f, 0.0f, 0.0f), XMFLOAT2(0.0f, 1.0f), color);
+
+		TIndex* out = indices;
+		for (uint32 i = 1; i <= sliceCount; ++i)
+		{
+			*out++ = 0;
+			*out++ = Index(i + 1);
+			*out++ = Index(i);
+		}
+
+		const uint32 baseIndex = 1;
+		const uint32 ringVertexCount = sliceCount + 1;
+		for (uint32 i = 0; i < stackCount - 2; ++i)
+		{
+			for (uint32 j = 0; j < sliceCount; ++j)
+			{
+				*out++ = Index(baseIndex + i * ringVertexCount + j);
+				*out++ = Index(baseIndex + i * ringVertexCount + j + 1);
+				*out++ = Index(baseIndex + (i + 1) * ringVertexCount + j);
+
+				*out++ = Index(baseIndex + (i + 1) * ringVertexCount + j);
+				*out++ = Index(baseIndex + i * ringVertexCount + j + 1);
+				*out++ = Index(baseIndex + (i + 1) * ringVertexCount + j + 1);
+			}
+		}
+
+		const uint32 southPoleIndex = counts.VertexCount - 1;
+		const uint32 lastRing = southPoleIndex - ringVertexCount;
+		for (uint32 i = 0; i < sliceCount; ++i)
+		{
+			*out++ = Index(southPoleIndex);
+			*out++ = Index(lastRing + i);
+			*out++ = Index(lastRing + i + 1);
+		}
+
+		return counts;
+	}
+
+	///<summary>
+	/// Same as GeometryGenerator::CreateCylinder, caps included.
+	///</summary>
+	static Counts WriteCylinder(TVertex* vertices, TIndex* indices, float bottomRadius, float topRadius, float height,
+		uint32 sliceCount, uint32 stackCount, const DirectX::XMFLOAT4& color = DefaultColor())
+	{
+		using namespace DirectX;
+
+		const Counts counts = CylinderCounts(sliceCount, stackCount);
+		CheckIndexWidth(counts);
+
+		const float stackHeight = height / stackCount;
+		const float radiusStep = (topRadius - bottomRadius) / stackCount;
+		const float dTheta = 2.0f * XM_PI / sliceCount;
+		const float dr = bottomRadius - topRadius;
+
+		TVertex* v = vertices;
+		for (uint32 i = 0; i <= stackCount; ++i)
+		{
+			const float y = -0.5f * height + i * stackHeight;
+			const float r = bottomRadius + i * radiusStep;
+
+			for (uint32 j = 0; j <= sliceCount; ++j)
+			{
+				const float c = cosf(j * dTheta);
+				const float s = sinf(j * dTheta);
+
+				TVertex& vertex = *v++;
+				vertex.Position = XMFLOAT3(r * c, y, r * s);
+
+				const XMFLOAT3 tangent(-s, 0.0f, c);
+				if (Layout::HasNormal)
+				{
+					XMFLOAT3 bitangent(dr * c, -height, dr * s);
+					XMFLOAT3 normal;
+					XMStoreFloat3(&normal, XMVector3Normalize(XMVector3Cross(XMLoadFloat3(&tangent), XMLoadFloat3(&bitangent))));
+					SetNormal(vertex, normal, HasNormalTag());
+				}
+				SetTangent(vertex, tangent, HasTangentTag());
+				SetTexCoord(vertex, XMFLOAT2((float)j / sliceCount, 1.0f - (float)i / stackCount), TexCoordTag());
+				SetColor(vertex, color, HasColorTag());
+			}
+		}
+
+		TIndex* out = indices;
+		const uint32 ringVertexCount = sliceCount + 1;
+		for (uint32 i = 0; i < stackCount; ++i)
+		{
+			for (uint32 j = 0; j < sliceCount; ++j)
+			{
+				*out++ = Index(i * ringVertexCount + j);
+				*out++ = Index((i + 1) * ringVertexCount + j);
+				*out++ = Index((i + 1) * ringVertexCount + j + 1);
+
+				*out++ = Index(i * ringVertexCount + j);
+				*out++ = Index((i + 1) * ringVertexCount + j + 1);
+				*out++ = Index(i * ringVertexCount + j + 1);
+			}
+		}
+
+		// Top cap, then bottom cap: a duplicated ring and a center vertex each.
+		for (int cap = 0; cap < 2; ++cap)
+		{
+			const bool top = cap == 0;
+			const float y = top ? 0.5f * height : -0.5f * height;
+			const float radius = top ? topRadius : bottomRadius;
+			const float ny = top ? 1.0f : -1.0f;
+			const uint32 baseIndex = (uint32)(v - vertices);
+
+			for (uint32 i = 0; i <= sliceCount; ++i)
+			{
+				const float x = radius * cosf(i * dTheta);
+				const float z = radius * sinf(i * dTheta);
+
+				// Scaled down by the height to keep the cap texture area
+				// proportional to the side.
+				WriteVertex(*v++, XMFLOAT3(x, y, z), XMFLOAT3(0.0f, ny, 0.0f), XMFLOAT3(1.0f, 0.0f, 0.0f),
+					XMFLOAT2(x / height + 0.5f, z / height + 0.5f), color);
+			}
+			WriteVertex(*v++, XMFLOAT3(0.0f, y, 0.0f), XMFLOAT3(0.0f, ny, 0.0f), XMFLOAT3(1.0f, 0.0f, 0.0f), XMFLOAT2(0.5f, 0.5f), color);
+
+			const uint32 centerIndex = (uint32)(v - vertices) - 1;
+			for (uint32 i = 0; i < sliceCount; ++i)
+			{
+				*out++ = Index(centerIndex);
+				*out++ = Index(baseIndex + (top ? i + 1 : i));
+				*out++ = Index(baseIndex + (top ? i : i + 1));
+			}
+		}
+
+		return counts;
+	}
+
+	///<summary>
+	/// Same as GeometryGenerator::CreateGrid.
+	///</summary>
+	static Counts WriteGrid(TVertex* vertices, TIndex* indices, float width, float depth, uint32 m, uint32 n,
+		const DirectX::XMFLOAT4& color = DefaultColor())
+	{
+		using namespace DirectX;
+
+		const Counts counts = GridCounts(m, n);
+		CheckIndexWidth(counts);
+
+		const float halfWidth = 0.5f * width;
+		const float halfDepth = 0.5f * depth;
+		const float dx = width / (n - 1);
+		const float dz = depth / (m - 1);
+		const float du = 1.0f / (n - 1);
+		const float dv = 1.0f / (m - 1);
+
+		TVertex* v = vertices;
+		for (uint32 i = 0; i < m; ++i)
+		{
+			const float z = halfDepth - i * dz;
+			for (uint32 j = 0; j < n; ++j)
+			{
+				WriteVertex(*v++, XMFLOAT3(-halfWidth + j * dx, 0.0f, z), XMFLOAT3(0.0f, 1.0f, 0.0f), XMFLOAT3(1.0f, 0.0f, 0.0f),
+					XMFLOAT2(j * du, i * dv), color);
+			}
+		}
+
+		TIndex* out = indices;
+		for (uint32 i = 0; i < m - 1; ++i)
+		{
+			for (uint32 j = 0; j < n - 1; ++j)
+			{
+				*out++ = Index(i * n + j);
+				*out++ = Index(i * n + j + 1);
+				*out++ = Index((i + 1) * n + j);
+
+				*out++ = Index((i + 1) * n + j);
+				*out++ = Index(i * n + j + 1);
+				*out++ = Index((i + 1) * n + j + 1);
+			}
+		}
+
+		return counts;
+	}
+
+	///<summary>
+	/// Same as GeometryGenerator::CreateQuad, in NDC space.
+	///</summary>
+	static Counts WriteQuad(TVertex* vertices, TIndex* indices, float x, float y, float w, float h, float depth,
+		const DirectX::XMFLOAT4& color = DefaultColor())
+	{
+		using namespace DirectX;
+
+		const XMFLOAT3 normal(0.0f, 0.0f, -1.0f);
+		const XMFLOAT3 tangent(1.0f, 0.0f, 0.0f);
+		WriteVertex(vertices[0], XMFLOAT3(x, y - h, depth), normal, tangent, XMFLOAT2(0.0f, 1.0f), color);
+		WriteVertex(vertices[1], XMFLOAT3(x, y, depth), normal, tangent, XMFLOAT2(0.0f, 0.0f), color);
+		WriteVertex(vertices[2], XMFLOAT3(x + w, y, depth), normal, tangent, XMFLOAT2(1.0f, 0.0f), color);
+		WriteVertex(vertices[3], XMFLOAT3(x + w, y - h, depth), normal, tangent, XMFLOAT2(1.0f, 1.0f), color);
+
+		indices[0] = 0; indices[1] = 1; indices[2] = 2;
+		indices[3] = 0; indices[4] = 2; indices[5] = 3;
+
+		return QuadCounts();
+	}
+
+private:
+	using HasNormalTag = std::integral_constant<bool, Layout::HasNormal>;
+	using HasTangentTag = std::integral_constant<bool, Layout::HasTangentU>;
+	using HasColorTag = std::integral_constant<bool, Layout::HasColor>;
+	// 0: no texture coordinates, 1: TexCoord, 2: TexC.
+	using TexCoordTag = std::integral_constant<int, Layout::HasTexCoord ? 1 : (Layout::HasTexC ? 2 : 0)>;
+
+	static DirectX::XMFLOAT4 DefaultColor()
+	{
+		return DirectX::XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+	}
+
+	static Counts MakeCounts(uint32 vertexCount, uint32 indexCount)
+	{
+		Counts counts;
+		counts.VertexCount = vertexCount;
+		counts.IndexCount = indexCount;
+		return counts;
+	}
+
+	static void CheckIndexWidth(const Counts& counts)
+	{
+		assert(sizeof(TIndex) == sizeof(uint32) || counts.VertexCount <= 65536);
+		(void)counts;
+	}
+
+	static TIndex Index(uint32 index)
+	{
+		return static_cast<TIndex>(index);
+	}
+
+	static void WriteVertex(TVertex& vertex, const DirectX::XMFLOAT3& position, const DirectX::XMFLOAT3& normal,
+		const DirectX::XMFLOAT3& tangent, const DirectX::XMFLOAT2& texCoord, const DirectX::XMFLOAT4& color)
+	{
+		vertex.Position = position;
+		SetNormal(vertex, normal, HasNormalTag());
+		SetTangent(vertex, tangent, HasTangentTag());
+		SetTexCoord(vertex, texCoord, TexCoordTag());
+		SetColor(vertex, color, HasColorTag());
+	}
+
+	template<typename T> static void SetNormal(T& vertex, const DirectX::XMFLOAT3& normal, std::true_type) { vertex.Normal = normal; }
+	template<typename T> static void SetNormal(T&, const DirectX::XMFLOAT3&, std::false_type) {}
+
+	template<typename T> static void SetTangent(T& vertex, const DirectX::XMFLOAT3& tangent, std::true_type) { vertex.TangentU = tangent; }
+	template<typename T> static void SetTangent(T&, const DirectX::XMFLOAT3&, std::false_type) {}
+
+	template<typename T> static void SetTexCoord(T& vertex, const DirectX::XMFLOAT2& texCoord, std::integral_constant<int, 1>) { vertex.TexCoord = texCoord; }
+	template<typename T> static void SetTexCoord(T& vertex, const DirectX::XMFLOAT2& texCoord, std::integral_constant<int, 2>) { vertex.TexC = texCoord; }
+	template<typename T> static void SetTexCoord(T&, const DirectX::XMFLOAT2&, std::integral_constant<int, 0>) {}
+
+	template<typename T> static void SetColor(T& vertex, const DirectX::XMFLOAT4& color, std::true_type) { vertex.Color = color; }
+	template<typename T> static void SetColor(T&, const DirectX::XMFLOAT4&, std::false_type) {}
+};
\ No newline at end of file
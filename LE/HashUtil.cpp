@@ -0,0 +1,32 @@
+#include "HashUtil.h"
+#include <cstring>
+
+const HashUtil::uint64 HashUtil::FnvOffsetBasis;
+
+namespace
+{
+	const HashUtil::uint64 FnvPrime = 1099511628211ull;
+}
+
+HashUtil::uint64 HashUtil::HashBytes(const void* data, size_t byteSize, uint64 seed)
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	uint64 hash = seed ^ byteSize;
+
+	size_t i = 0;
+	for (; i + sizeof(uint64) <= byteSize; i += sizeof(uint64))
+	{
+		uint64 word;
+		memcpy(&word, bytes + i, sizeof(word));
+		hash ^= word;
+		hash *= FnvPrime;
+		hash ^= hash >> 32;
+	}
+	for (; i < byteSize; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= FnvPrime;
+	}
+
+	return hash;
+}
\ No newline at end of file
@@ -0,0 +1,18 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// The content hash shared by AssetDatabase and GeometryArena.  Not
+// cryptographic: equal hashes only tell two blobs are likely the same.
+class HashUtil
+{
+public:
+	using uint64 = std::uint64_t;
+
+	static const uint64 FnvOffsetBasis = 14695981039346656037ull;
+
+	///<summary>
+	/// 64-bit FNV-1a style hash, 8 bytes at a time.
+	///</summary>
+	static uint64 HashBytes(const void* data, size_t byteSize, uint64 seed = FnvOffsetBasis);
+};
\ No newline at end of file
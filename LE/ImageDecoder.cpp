@@ -0,0 +1,1802 @@
+#include "ImageDecoder.h"
+#include "WorkerPool.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define IMAGEDECODER_SSE2 1
+#endif
+
+namespace
+{
+	using uint8 = std::uint8_t;
+	using uint16 = std::uint16_t;
+	using uint32 = std::uint32_t;
+	using uint64 = std::uint64_t;
+	using int16 = std::int16_t;
+	using int32 = std::int32_t;
+	using PixelFormat = ImageDecoder::PixelFormat;
+
+	// Rows converted by one job of ParallelFor.
+	const uint32 RowsPerJob = 16;
+
+	// Calls body(y) for every row, RowsPerJob rows per job.
+	template<typename TBody>
+	void ParallelRows(uint32 height, uint32 threadCount, const TBody& body)
+	{
+		WorkerPool::ParallelFor((height + RowsPerJob - 1) / RowsPerJob, threadCount, [&](uint32 job)
+		{
+			const uint32 end = std::min(height, (job + 1) * RowsPerJob);
+			for (uint32 y = job * RowsPerJob; y < end; ++y)
+				body(y);
+		});
+	}
+
+	uint32 ReadBE16(const uint8* p)
+	{
+		return ((uint32)p[0] << 8) | p[1];
+	}
+
+	uint32 ReadBE32(const uint8* p)
+	{
+		return ((uint32)p[0] << 24) | ((uint32)p[1] << 16) | ((uint32)p[2] << 8) | p[3];
+	}
+
+	uint32 ReadLE16(const uint8* p)
+	{
+		return p[0] | ((uint32)p[1] << 8);
+	}
+
+	uint8 Clamp255(int32 value)
+	{
+		return (uint8)(value < 0 ? 0 : value > 255 ? 255 : value);
+	}
+
+	// Like MakeSRGB of the WIC loader.
+	PixelFormat MakeSrgb(PixelFormat format)
+	{
+		switch (format)
+		{
+		case PixelFormat::Rgba8: return PixelFormat::Rgba8Srgb;
+		case PixelFormat::Bgra8: return PixelFormat::Bgra8Srgb;
+		default: return format;
+		}
+	}
+
+	//
+	// Conversion kernels.  They write every destination byte once, in order.
+	//
+
+	// RGBA <-> BGRA.
+	void SwapRedBlue(uint8* dst, const uint8* src, uint32 width)
+	{
+		uint32 x = 0;
+#ifdef IMAGEDECODER_SSE2
+		const __m128i alphaGreen = _mm_set1_epi32((int)0xFF00FF00);
+		for (; x + 4 <= width; x += 4)
+		{
+			const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x * 4));
+			// Within every 32-bit lane byte 0 moves to byte 2 and byte 2 to
+			// byte 0, the shifts drop everything else.
+			const __m128i redBlue = _mm_andnot_si128(alphaGreen, pixels);
+			const __m128i swapped = _mm_or_si128(_mm_slli_epi32(redBlue, 16), _mm_srli_epi32(redBlue, 16));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 4), _mm_or_si128(swapped, _mm_and_si128(pixels, alphaGreen)));
+		}
+#endif
+		for (; x < width; ++x)
+		{
+			dst[x * 4 + 0] = src[x * 4 + 2];
+			dst[x * 4 + 1] = src[x * 4 + 1];
+			dst[x * 4 + 2] = src[x * 4 + 0];
+			dst[x * 4 + 3] = src[x * 4 + 3];
+		}
+	}
+
+	// Big endian 16-bit samples to little endian.
+	void SwapBytes16(uint8* dst, const uint8* src, uint32 count)
+	{
+		uint32 i = 0;
+#ifdef IMAGEDECODER_SSE2
+		for (; i + 8 <= count; i += 8)
+		{
+			const __m128i samples = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 2), _mm_or_si128(_mm_slli_epi16(samples, 8), _mm_srli_epi16(samples, 8)));
+		}
+#endif
+		for (; i < count; ++i)
+		{
+			dst[i * 2 + 0] = src[i * 2 + 1];
+			dst[i * 2 + 1] = src[i * 2 + 0];
+		}
+	}
+
+	void RgbToRgba(uint8* dst, const uint8* src, uint32 width)
+	{
+		uint32* out = reinterpret_cast<uint32*>(dst);
+		for (uint32 x = 0; x < width; ++x, src += 3)
+			out[x] = src[0] | ((uint32)src[1] << 8) | ((uint32)src[2] << 16) | 0xFF000000u;
+	}
+
+	void BgrToRgba(uint8* dst, const uint8* src, uint32 width)
+	{
+		uint32* out = reinterpret_cast<uint32*>(dst);
+		for (uint32 x = 0; x < width; ++x, src += 3)
+			out[x] = src[2] | ((uint32)src[1] << 8) | ((uint32)src[0] << 16) | 0xFF000000u;
+	}
+
+	// YCbCr to RGBA exactly as libjpeg's tables round: R = Y + 1.402 Cr,
+	// G = Y - 0.34414 Cb - 0.71414 Cr, B = Y + 1.772 Cb in 16.16 fixed point.
+	// The parts of the factors above 1 are added separately so the rest fits
+	// 16-bit multipliers.
+	void YccToRgba(uint8* dst, const uint8* yRow, const uint8* cbRow, const uint8* crRow, uint32 width)
+	{
+		uint32 x = 0;
+#ifdef IMAGEDECODER_SSE2
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i center = _mm_set1_epi16(128);
+		const __m128i half = _mm_set1_epi32(32768);
+		const __m128i crToR = _mm_set1_epi32(26345);
+		const __m128i cbToB = _mm_set1_epi32(-14942 & 0xFFFF);
+		const __m128i toG = _mm_set1_epi32((-22554 & 0xFFFF) | (18734 << 16));
+		const __m128i alpha = _mm_set1_epi8((char)0xFF);
+
+		auto scale = [&](__m128i lo, __m128i hi, __m128i factor)
+		{
+			return _mm_packs_epi32(
+				_mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(lo, factor), half), 16),
+				_mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(hi, factor), half), 16));
+		};
+
+		for (; x + 8 <= width; x += 8)
+		{
+			const __m128i y = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(yRow + x)), zero);
+			const __m128i cb = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(cbRow + x)), zero), center);
+			const __m128i cr = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(crRow + x)), zero), center);
+
+			const __m128i r = _mm_add_epi16(_mm_add_epi16(y, cr),
+				scale(_mm_unpacklo_epi16(cr, zero), _mm_unpackhi_epi16(cr, zero), crToR));
+			const __m128i b = _mm_add_epi16(_mm_add_epi16(y, _mm_add_epi16(cb, cb)),
+				scale(_mm_unpacklo_epi16(cb, zero), _mm_unpackhi_epi16(cb, zero), cbToB));
+			const __m128i g = _mm_add_epi16(_mm_sub_epi16(y, cr),
+				scale(_mm_unpacklo_epi16(cb, cr), _mm_unpackhi_epi16(cb, cr), toG));
+
+			const __m128i rg = _mm_unpacklo_epi8(_mm_packus_epi16(r, r), _mm_packus_epi16(g, g));
+			const __m128i ba = _mm_unpacklo_epi8(_mm_packus_epi16(b, b), alpha);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 4), _mm_unpacklo_epi16(rg, ba));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 4 + 16), _mm_unpackhi_epi16(rg, ba));
+		}
+#endif
+		for (; x < width; ++x)
+		{
+			const int32 y = yRow[x];
+			const int32 cb = cbRow[x] - 128;
+			const int32 cr = crRow[x] - 128;
+			dst[x * 4 + 0] = Clamp255(y + cr + ((26345 * cr + 32768) >> 16));
+			dst[x * 4 + 1] = Clamp255(y - cr + ((-22554 * cb + 18734 * cr + 32768) >> 16));
+			dst[x * 4 + 2] = Clamp255(y + 2 * cb + ((-14942 * cb + 32768) >> 16));
+			dst[x * 4 + 3] = 0xFF;
+		}
+	}
+
+	//
+	// Inflate (RFC 1951) for PNG.
+	//
+
+	// Huffman codes are read least significant bit first, so the fast table
+	// is indexed by the next FastBits bits reversed.
+	struct InflateTable
+	{
+		static const int FastBits = 10;
+
+		// (length << 9) | symbol, 0 for codes longer than FastBits.
+		uint16 Fast[1 << FastBits];
+		// Canonical decoding of the longer codes, on bit reversed input.
+		uint32 MaxCode[17];
+		uint16 FirstCode[16];
+		uint16 FirstSymbol[16];
+		uint16 Symbols[288];
+	};
+
+	uint32 ReverseBits(uint32 code, int length)
+	{
+		uint32 result = 0;
+		for (int i = 0; i < length; ++i, code >>= 1)
+			result = (result << 1) | (code & 1);
+		return result;
+	}
+
+	bool BuildInflateTable(InflateTable& table, const uint8* lengths, int count)
+	{
+		int sizes[16] = {};
+		for (int i = 0; i < count; ++i)
+			sizes[lengths[i]]++;
+		sizes[0] = 0;
+
+		uint32 nextCode[16];
+		uint32 code = 0;
+		int symbol = 0;
+		for (int length = 1; length < 16; ++length)
+		{
+			nextCode[length] = code;
+			table.FirstCode[length] = (uint16)code;
+			table.FirstSymbol[length] = (uint16)symbol;
+			code += sizes[length];
+			if (code > (1u << length))
+				return false;
+			table.MaxCode[length] = code << (16 - length);
+			code <<= 1;
+			symbol += sizes[length];
+		}
+		table.MaxCode[16] = 0x10000;
+
+		memset(table.Fast, 0, sizeof(table.Fast));
+		for (int i = 0; i < count; ++i)
+		{
+			const int length = lengths[i];
+			if (length == 0)
+				continue;
+			table.Symbols[nextCode[length] - table.FirstCode[length] + table.FirstSymbol[length]] = (uint16)i;
+			if (length <= InflateTable::FastBits)
+			{
+				for (uint32 j = ReverseBits(nextCode[length], length); j < (1u << InflateTable::FastBits); j += 1u << length)
+					table.Fast[j] = (uint16)((length << 9) | i);
+			}
+			nextCode[length]++;
+		}
+		return true;
+	}
+
+	class Inflater
+	{
+	public:
+		Inflater(const uint8* data, size_t byteSize)
+			:
+			mIn(data),
+			mEnd(data + byteSize)
+		{
+		}
+
+		// Inflates a zlib stream into exactly outSize bytes at out.
+		bool Run(uint8* out, size_t outSize)
+		{
+			mOut = out;
+			mOutStart = out;
+			mOutEnd = out + outSize;
+
+			if (mEnd - mIn < 2)
+				return false;
+			const uint32 cmf = mIn[0];
+			const uint32 flg = mIn[1];
+			if ((cmf & 15) != 8 || (cmf * 256 + flg) % 31 != 0 || (flg & 32))
+				return false;
+			mIn += 2;
+
+			bool final = false;
+			while (!final)
+			{
+				final = Bits(1) != 0;
+				bool ok = false;
+				switch (Bits(2))
+				{
+				case 0: ok = Stored(); break;
+				case 1: ok = Fixed(); break;
+				case 2: ok = Dynamic(); break;
+				default: ok = false; break;
+				}
+				if (!ok || mOverrun > 8)
+					return false;
+			}
+			return mOut == mOutEnd;
+		}
+
+	private:
+		void Refill()
+		{
+			if (mEnd - mIn >= 8)
+			{
+				uint64 next;
+				memcpy(&next, mIn, 8);
+				mBits |= next << mCount;
+				mIn += (63 - mCount) >> 3;
+				mCount |= 56;
+				return;
+			}
+			while (mCount <= 56)
+			{
+				// Past the end zeros are read, Run fails if they are used.
+				uint64 next = 0;
+				if (mIn < mEnd)
+					next = *mIn++;
+				else
+					mOverrun++;
+				mBits |= next << mCount;
+				mCount += 8;
+			}
+		}
+
+		uint32 Bits(int count)
+		{
+			if (mCount < count)
+				Refill();
+			const uint32 value = (uint32)(mBits & ((1ull << count) - 1));
+			mBits >>= count;
+			mCount -= count;
+			return value;
+		}
+
+		int Decode(const InflateTable& table)
+		{
+			if (mCount < 16)
+				Refill();
+
+			const uint32 fast = table.Fast[mBits & ((1u << InflateTable::FastBits) - 1)];
+			if (fast != 0)
+			{
+				const int length = fast >> 9;
+				mBits >>= length;
+				mCount -= length;
+				return fast & 511;
+			}
+
+			const uint32 code = ReverseBits((uint32)(mBits & 0xFFFF), 16);
+			int length = InflateTable::FastBits + 1;
+			while (length < 16 && code >= table.MaxCode[length])
+				++length;
+			if (length == 16)
+				return -1;
+
+			const uint32 index = (code >> (16 - length)) - table.FirstCode[length] + table.FirstSymbol[length];
+			if (index >= 288)
+				return -1;
+			mBits >>= length;
+			mCount -= length;
+			return table.Symbols[index];
+		}
+
+		bool Stored()
+		{
+			// Back to whole bytes: drop the rest of this one and hand the
+			// bytes still in the bit buffer back.
+			Bits(mCount & 7);
+			mIn -= mCount >> 3;
+			mBits = 0;
+			mCount = 0;
+			if (mOverrun > 0 || mEnd - mIn < 4)
+				return false;
+
+			const uint32 length = ReadLE16(mIn);
+			const uint32 complement = ReadLE16(mIn + 2);
+			mIn += 4;
+			if ((length ^ 0xFFFF) != complement || (size_t)(mEnd - mIn) < length || (size_t)(mOutEnd - mOut) < length)
+				return false;
+
+			memcpy(mOut, mIn, length);
+			mOut += length;
+			mIn += length;
+			return true;
+		}
+
+		bool Fixed()
+		{
+			uint8 lengths[288 + 32];
+			memset(lengths, 8, 144);
+			memset(lengths + 144, 9, 112);
+			memset(lengths + 256, 7, 24);
+			memset(lengths + 280, 8, 8);
+			memset(lengths + 288, 5, 32);
+			return BuildInflateTable(mLiterals, lengths, 288) && BuildInflateTable(mDistances, lengths + 288, 32) && Block();
+		}
+
+		bool Dynamic()
+		{
+			static const uint8 order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+			const int literalCount = Bits(5) + 257;
+			const int distanceCount = Bits(5) + 1;
+			const int codeLengthCount = Bits(4) + 4;
+
+			uint8 codeLengthLengths[19] = {};
+			for (int i = 0; i < codeLengthCount; ++i)
+				codeLengthLengths[order[i]] = (uint8)Bits(3);
+			if (!BuildInflateTable(mLiterals, codeLengthLengths, 19))
+				return false;
+
+			uint8 lengths[288 + 32];
+			int count = 0;
+			while (count < literalCount + distanceCount)
+			{
+				const int symbol = Decode(mLiterals);
+				if (symbol < 0)
+					return false;
+				if (symbol < 16)
+				{
+					lengths[count++] = (uint8)symbol;
+					continue;
+				}
+
+				uint8 value = 0;
+				int repeat = 0;
+				if (symbol == 16)
+				{
+					if (count == 0)
+						return false;
+					value = lengths[count - 1];
+					repeat = 3 + Bits(2);
+				}
+				else if (symbol == 17)
+				{
+					repeat = 3 + Bits(3);
+				}
+				else
+				{
+					repeat = 11 + Bits(7);
+				}
+				if (count + repeat > literalCount + distanceCount)
+					return false;
+				memset(lengths + count, value, repeat);
+				count += repeat;
+			}
+
+			return BuildInflateTable(mLiterals, lengths, literalCount) &&
+				BuildInflateTable(mDistances, lengths + literalCount, distanceCount) && Block();
+		}
+
+		bool Block()
+		{
+			static const uint16 lengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+			static const uint8 lengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+			static const uint16 distanceBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+			static const uint8 distanceExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+			for (;;)
+			{
+				int symbol = Decode(mLiterals);
+				if (symbol < 256)
+				{
+					if (symbol < 0 || mOut == mOutEnd)
+						return false;
+					*mOut++ = (uint8)symbol;
+					continue;
+				}
+				if (symbol == 256)
+					return true;
+
+				symbol -= 257;
+				if (symbol >= 29)
+					return false;
+				const uint32 length = lengthBase[symbol] + Bits(lengthExtra[symbol]);
+
+				const int distanceSymbol = Decode(mDistances);
+				if (distanceSymbol < 0 || distanceSymbol >= 30)
+					return false;
+				const size_t distance = distanceBase[distanceSymbol] + Bits(distanceExtra[distanceSymbol]);
+				if (distance > (size_t)(mOut - mOutStart) || length > (size_t)(mOutEnd - mOut))
+					return false;
+
+				const uint8* from = mOut - distance;
+				uint8* to = mOut;
+				mOut += length;
+				if (distance >= 8)
+				{
+					// Whole words as long as they do not run past the end.
+					uint32 copied = 0;
+					for (; copied + 8 <= length; copied += 8)
+						memcpy(to + copied, from + copied, 8);
+					for (; copied < length; ++copied)
+						to[copied] = from[copied];
+				}
+				else if (distance == 1)
+				{
+					memset(to, *from, length);
+				}
+				else
+				{
+					for (uint32 i = 0; i < length; ++i)
+						to[i] = from[i];
+				}
+			}
+		}
+
+		const uint8* mIn;
+		const uint8* mEnd;
+		uint64 mBits = 0;
+		int mCount = 0;
+		int mOverrun = 0;
+
+		uint8* mOut = nullptr;
+		uint8* mOutStart = nullptr;
+		uint8* mOutEnd = nullptr;
+
+		InflateTable mLiterals;
+		InflateTable mDistances;
+	};
+
+	//
+	// PNG
+	//
+
+	const uint8 PngSignature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+	enum PngColorType
+	{
+		PngGray = 0,
+		PngRgb = 2,
+		PngPalette = 3,
+		PngGrayAlpha = 4,
+		PngRgba = 6,
+	};
+
+	struct PngImage
+	{
+		uint32 Width = 0;
+		uint32 Height = 0;
+		uint32 BitDepth = 0;
+		uint32 ColorType = 0;
+		bool Srgb = false;
+		// RGBA, alpha from tRNS.
+		uint32 Palette[256] = {};
+		uint32 PaletteSize = 0;
+		// The zlib stream is split over the IDAT chunks.
+		std::vector<std::pair<const uint8*, size_t>> Data;
+	};
+
+	uint32 PngChannels(uint32 colorType)
+	{
+		switch (colorType)
+		{
+		case PngGray: return 1;
+		case PngRgb: return 3;
+		case PngPalette: return 1;
+		case PngGrayAlpha: return 2;
+		case PngRgba: return 4;
+		default: return 0;
+		}
+	}
+
+	bool ParsePng(const uint8* data, size_t byteSize, PngImage& png)
+	{
+		if (byteSize < 8 || memcmp(data, PngSignature, 8) != 0)
+			return false;
+
+		bool header = false;
+		bool gamma = false;
+		size_t offset = 8;
+		while (offset + 12 <= byteSize)
+		{
+			const uint32 length = ReadBE32(data + offset);
+			const uint8* type = data + offset + 4;
+			const uint8* chunk = data + offset + 8;
+			if (length > byteSize - offset - 12)
+				return false;
+			offset += 12 + (size_t)length;
+
+			if (memcmp(type, "IHDR", 4) == 0)
+			{
+				if (length != 13)
+					return false;
+				png.Width = ReadBE32(chunk);
+				png.Height = ReadBE32(chunk + 4);
+				png.BitDepth = chunk[8];
+				png.ColorType = chunk[9];
+				// Compression, filter method, interlace.
+				if (chunk[10] != 0 || chunk[11] != 0 || chunk[12] != 0)
+					return false;
+				header = true;
+			}
+			else if (memcmp(type, "PLTE", 4) == 0)
+			{
+				if (length % 3 != 0 || length / 3 > 256)
+					return false;
+				png.PaletteSize = length / 3;
+				for (uint32 i = 0; i < png.PaletteSize; ++i)
+					png.Palette[i] = chunk[i * 3] | ((uint32)chunk[i * 3 + 1] << 8) | ((uint32)chunk[i * 3 + 2] << 16) | 0xFF000000u;
+			}
+			else if (memcmp(type, "tRNS", 4) == 0)
+			{
+				// Only palette transparency, WIC leaves the color keys of gray
+				// and RGB images alone as well.
+				for (uint32 i = 0; i < length && i < png.PaletteSize; ++i)
+					png.Palette[i] = (png.Palette[i] & 0x00FFFFFFu) | ((uint32)chunk[i] << 24);
+			}
+			else if (memcmp(type, "sRGB", 4) == 0)
+			{
+				png.Srgb = true;
+			}
+			else if (memcmp(type, "gAMA", 4) == 0 && length == 4 && !gamma)
+			{
+				// 1/2.2, which the WIC loader takes for sRGB too.
+				gamma = true;
+				png.Srgb = png.Srgb || ReadBE32(chunk) == 45455;
+			}
+			else if (memcmp(type, "IDAT", 4) == 0)
+			{
+				png.Data.emplace_back(chunk, (size_t)length);
+			}
+			else if (memcmp(type, "IEND", 4) == 0)
+			{
+				break;
+			}
+		}
+
+		if (!header || png.Width == 0 || png.Height == 0 || png.Data.empty())
+			return false;
+
+		switch (png.ColorType)
+		{
+		case PngGray:
+			return png.BitDepth == 1 || png.BitDepth == 2 || png.BitDepth == 4 || png.BitDepth == 8 || png.BitDepth == 16;
+		case PngPalette:
+			return (png.BitDepth == 1 || png.BitDepth == 2 || png.BitDepth == 4 || png.BitDepth == 8) && png.PaletteSize > 0;
+		case PngRgb:
+		case PngGrayAlpha:
+		case PngRgba:
+			return png.BitDepth == 8 || png.BitDepth == 16;
+		default:
+			return false;
+		}
+	}
+
+	// The formats of the WIC PNG decoder after the WIC loader's conversions.
+	void GetPngInfo(const PngImage& png, ImageDecoder::Info& info)
+	{
+		info.Width = png.Width;
+		info.Height = png.Height;
+		switch (png.ColorType)
+		{
+		case PngGray:
+			info.Format = png.BitDepth == 16 ? PixelFormat::R16 : PixelFormat::R8;
+			break;
+		case PngGrayAlpha:
+		case PngRgba:
+			info.Format = png.BitDepth == 16 ? PixelFormat::Rgba16 : PixelFormat::Bgra8;
+			break;
+		default:
+			info.Format = png.BitDepth == 16 ? PixelFormat::Rgba16 : PixelFormat::Rgba8;
+			break;
+		}
+		info.BytesPerPixel = info.Format == PixelFormat::R8 ? 1 : info.Format == PixelFormat::R16 ? 2 :
+			info.Format == PixelFormat::Rgba16 ? 8 : 4;
+		if (png.Srgb)
+			info.Format = MakeSrgb(info.Format);
+	}
+
+	uint8 Paeth(uint8 a, uint8 b, uint8 c)
+	{
+		const int p = a + b - c;
+		const int pa = abs(p - a);
+		const int pb = abs(p - b);
+		const int pc = abs(p - c);
+		return pa <= pb && pa <= pc ? a : pb <= pc ? b : c;
+	}
+
+	// Undoes the filter of row in place, prior is the row above (unfiltered).
+	bool Unfilter(uint8 filter, uint8* row, const uint8* prior, size_t rowBytes, size_t bpp)
+	{
+		switch (filter)
+		{
+		case 0:
+			return true;
+		case 1:
+			for (size_t i = bpp; i < rowBytes; ++i)
+				row[i] = (uint8)(row[i] + row[i - bpp]);
+			return true;
+		case 2:
+			for (size_t i = 0; i < rowBytes; ++i)
+				row[i] = (uint8)(row[i] + prior[i]);
+			return true;
+		case 3:
+			for (size_t i = 0; i < bpp; ++i)
+				row[i] = (uint8)(row[i] + (prior[i] >> 1));
+			for (size_t i = bpp; i < rowBytes; ++i)
+				row[i] = (uint8)(row[i] + ((row[i - bpp] + prior[i]) >> 1));
+			return true;
+		case 4:
+			for (size_t i = 0; i < bpp; ++i)
+				row[i] = (uint8)(row[i] + prior[i]);
+			for (size_t i = bpp; i < rowBytes; ++i)
+				row[i] = (uint8)(row[i] + Paeth(row[i - bpp], prior[i], prior[i - bpp]));
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	void ConvertPngRow(const PngImage& png, uint8* dst, const uint8* src)
+	{
+		const uint32 width = png.Width;
+		uint32* out32 = reinterpret_cast<uint32*>(dst);
+
+		if (png.BitDepth == 16)
+		{
+			switch (png.ColorType)
+			{
+			case PngGray:
+			case PngRgba:
+				SwapBytes16(dst, src, width * PngChannels(png.ColorType));
+				return;
+			case PngRgb:
+			case PngGrayAlpha:
+			{
+				uint16* out16 = reinterpret_cast<uint16*>(dst);
+				const bool rgb = png.ColorType == PngRgb;
+				for (uint32 x = 0; x < width; ++x, out16 += 4)
+				{
+					const uint8* pixel = src + x * (rgb ? 6 : 4);
+					const uint16 first = (uint16)ReadBE16(pixel);
+					out16[0] = first;
+					out16[1] = rgb ? (uint16)ReadBE16(pixel + 2) : first;
+					out16[2] = rgb ? (uint16)ReadBE16(pixel + 4) : first;
+					out16[3] = rgb ? 0xFFFF : (uint16)ReadBE16(pixel + 2);
+				}
+				return;
+			}
+			}
+		}
+
+		switch (png.ColorType)
+		{
+		case PngGray:
+			if (png.BitDepth == 8)
+			{
+				memcpy(dst, src, width);
+			}
+			else
+			{
+				// Scaled to the whole 0-255 range like WIC's 8bppGray.
+				const uint32 depth = png.BitDepth;
+				const uint32 scale = 255 / ((1u << depth) - 1);
+				for (uint32 x = 0; x < width; ++x)
+				{
+					const uint32 bit = x * depth;
+					dst[x] = (uint8)(((src[bit >> 3] >> (8 - depth - (bit & 7))) & ((1u << depth) - 1)) * scale);
+				}
+			}
+			return;
+		case PngRgb:
+			RgbToRgba(dst, src, width);
+			return;
+		case PngPalette:
+		{
+			const uint32 depth = png.BitDepth;
+			for (uint32 x = 0; x < width; ++x)
+			{
+				const uint32 bit = x * depth;
+				const uint32 index = (src[bit >> 3] >> (8 - depth - (bit & 7))) & ((1u << depth) - 1);
+				out32[x] = png.Palette[index];
+			}
+			return;
+		}
+		case PngGrayAlpha:
+			for (uint32 x = 0; x < width; ++x)
+				out32[x] = src[x * 2] * 0x010101u | ((uint32)src[x * 2 + 1] << 24);
+			return;
+		case PngRgba:
+			SwapRedBlue(dst, src, width);
+			return;
+		}
+	}
+
+	bool DecodePng(const uint8* data, size_t byteSize, uint8* destination, size_t rowPitch, uint32 threadCount)
+	{
+		PngImage png;
+		if (!ParsePng(data, byteSize, png))
+			return false;
+
+		// One chunk is inflated in place, several are joined first.
+		std::vector<uint8> joined;
+		const uint8* stream = png.Data[0].first;
+		size_t streamSize = png.Data[0].second;
+		if (png.Data.size() > 1)
+		{
+			for (const auto& part : png.Data)
+				joined.insert(joined.end(), part.first, part.first + part.second);
+			stream = joined.data();
+			streamSize = joined.size();
+		}
+
+		const size_t bitsPerPixel = (size_t)PngChannels(png.ColorType) * png.BitDepth;
+		const size_t rowBytes = (png.Width * bitsPerPixel + 7) / 8;
+		const size_t bpp = std::max<size_t>(1, bitsPerPixel / 8);
+		std::vector<uint8> raw((rowBytes + 1) * png.Height);
+		if (!Inflater(stream, streamSize).Run(raw.data(), raw.size()))
+			return false;
+
+		// Every row depends on the one above, the filters are undone in order.
+		std::vector<uint8> zeros(rowBytes);
+		const uint8* prior = zeros.data();
+		for (uint32 y = 0; y < png.Height; ++y)
+		{
+			uint8* row = raw.data() + y * (rowBytes + 1);
+			if (!Unfilter(row[0], row + 1, prior, rowBytes, bpp))
+				return false;
+			prior = row + 1;
+		}
+
+		ParallelRows(png.Height, threadCount, [&](uint32 y)
+		{
+			ConvertPngRow(png, destination + y * rowPitch, raw.data() + y * (rowBytes + 1) + 1);
+		});
+		return true;
+	}
+
+	//
+	// Baseline JPEG.
+	//
+
+	const uint8 ZigZag[64 + 16] =
+	{
+		0, 1, 8, 16, 9, 2, 3, 10, 17, 24, 32, 25, 18, 11, 4, 5,
+		12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13, 6, 7, 14, 21, 28,
+		35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+		58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63,
+		// Runs past the end of a damaged block land here.
+		63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63, 63,
+	};
+
+	struct JpegHuffman
+	{
+		static const int FastBits = 9;
+
+		// (length << 8) | value, 0 for codes longer than FastBits.
+		uint16 Fast[1 << FastBits];
+		int32 MaxCode[18];
+		int32 ValueOffset[17];
+		uint8 Values[256];
+		bool Defined = false;
+	};
+
+	bool BuildJpegHuffman(JpegHuffman& table, const uint8* counts, const uint8* values, uint32 valueCount)
+	{
+		memcpy(table.Values, values, valueCount);
+		memset(table.Fast, 0, sizeof(table.Fast));
+
+		int32 code = 0;
+		uint32 k = 0;
+		for (int length = 1; length <= 16; ++length)
+		{
+			table.ValueOffset[length] = (int32)k - code;
+			for (uint32 i = 0; i < counts[length - 1]; ++i, ++k, ++code)
+			{
+				if (length <= JpegHuffman::FastBits)
+				{
+					const uint32 first = (uint32)code << (JpegHuffman::FastBits - length);
+					for (uint32 j = 0; j < (1u << (JpegHuffman::FastBits - length)); ++j)
+						table.Fast[first + j] = (uint16)((length << 8) | values[k]);
+				}
+			}
+			if (code > (1 << length))
+				return false;
+			table.MaxCode[length] = counts[length - 1] ? code - 1 : -1;
+			code <<= 1;
+		}
+		table.MaxCode[17] = 0x7FFFFFFF;
+		table.Defined = true;
+		return k == valueCount;
+	}
+
+	struct JpegComponent
+	{
+		uint32 Id = 0;
+		uint32 H = 1;
+		uint32 V = 1;
+		uint32 Quant = 0;
+		uint32 DcTable = 0;
+		uint32 AcTable = 0;
+		// Samples actually covered by the image, the plane is padded to MCUs.
+		uint32 Width = 0;
+		uint32 Height = 0;
+		uint32 Stride = 0;
+		std::vector<uint8> Plane;
+	};
+
+	struct JpegImage
+	{
+		uint32 Width = 0;
+		uint32 Height = 0;
+		uint32 ComponentCount = 0;
+		JpegComponent Components[3];
+		uint16 Quant[4][64] = {};
+		JpegHuffman Dc[4];
+		JpegHuffman Ac[4];
+		uint32 RestartInterval = 0;
+		uint32 MaxH = 1;
+		uint32 MaxV = 1;
+		uint32 McusX = 0;
+		uint32 McusY = 0;
+		bool Rgb = false;
+		bool Srgb = false;
+		const uint8* Scan = nullptr;
+		const uint8* End = nullptr;
+	};
+
+	// EXIF ColorSpace, 1 is sRGB.  The WIC loader reads it as
+	// System.Image.ColorSpace.
+	bool ExifSaysSrgb(const uint8* tiff, size_t byteSize)
+	{
+		if (byteSize < 8 || (memcmp(tiff, "II", 2) != 0 && memcmp(tiff, "MM", 2) != 0))
+			return false;
+		const bool big = tiff[0] == 'M';
+		auto read16 = [&](size_t offset) { return big ? ReadBE16(tiff + offset) : ReadLE16(tiff + offset); };
+		auto read32 = [&](size_t offset)
+		{
+			return big ? ReadBE32(tiff + offset) : ReadLE16(tiff + offset) | (ReadLE16(tiff + offset + 2) << 16);
+		};
+
+		// Looks tag up in the IFD at offset, returns the offset of its value.
+		auto find = [&](size_t ifd, uint32 tag) -> size_t
+		{
+			if (ifd + 2 > byteSize)
+				return 0;
+			const uint32 count = read16(ifd);
+			for (uint32 i = 0; i < count && ifd + 2 + (i + 1) * 12 <= byteSize; ++i)
+			{
+				const size_t entry = ifd + 2 + i * 12;
+				if (read16(entry) == tag)
+					return entry + 8;
+			}
+			return 0;
+		};
+
+		const size_t exifIfd = find(read32(4), 0x8769);
+		if (exifIfd == 0)
+			return false;
+		const size_t colorSpace = find(read32(exifIfd), 0xA001);
+		return colorSpace != 0 && read16(colorSpace) == 1;
+	}
+
+	bool ParseJpeg(const uint8* data, size_t byteSize, JpegImage& jpeg)
+	{
+		if (byteSize < 4 || data[0] != 0xFF || data[1] != 0xD8)
+			return false;
+
+		bool frame = false;
+		bool jfif = false;
+		int adobeTransform = -1;
+		size_t offset = 2;
+		for (;;)
+		{
+			// Markers may be preceded by any number of fill bytes.
+			while (offset < byteSize && data[offset] == 0xFF && offset + 1 < byteSize && data[offset + 1] == 0xFF)
+				++offset;
+			if (offset + 4 > byteSize || data[offset] != 0xFF)
+				return false;
+
+			const uint8 marker = data[offset + 1];
+			const uint32 length = ReadBE16(data + offset + 2);
+			const uint8* segment = data + offset + 4;
+			if (length < 2 || length > byteSize - offset - 2)
+				return false;
+			const uint32 segmentSize = length - 2;
+			offset += 2 + length;
+
+			switch (marker)
+			{
+			case 0xDB: // DQT
+				for (uint32 p = 0; p < segmentSize; )
+				{
+					const uint32 precision = segment[p] >> 4;
+					const uint32 id = segment[p] & 15;
+					const uint32 size = precision ? 128 : 64;
+					if (id > 3 || p + 1 + size > segmentSize)
+						return false;
+					for (uint32 k = 0; k < 64; ++k)
+						jpeg.Quant[id][ZigZag[k]] = (uint16)(precision ? ReadBE16(segment + p + 1 + k * 2) : segment[p + 1 + k]);
+					p += 1 + size;
+				}
+				break;
+
+			case 0xC4: // DHT
+				for (uint32 p = 0; p < segmentSize; )
+				{
+					if (p + 17 > segmentSize)
+						return false;
+					const uint32 tableClass = segment[p] >> 4;
+					const uint32 id = segment[p] & 15;
+					uint32 valueCount = 0;
+					for (uint32 i = 0; i < 16; ++i)
+						valueCount += segment[p + 1 + i];
+					if (tableClass > 1 || id > 3 || valueCount > 256 || p + 17 + valueCount > segmentSize)
+						return false;
+					if (!BuildJpegHuffman(tableClass ? jpeg.Ac[id] : jpeg.Dc[id], segment + p + 1, segment + p + 17, valueCount))
+						return false;
+					p += 17 + valueCount;
+				}
+				break;
+
+			case 0xC0: // Baseline
+			case 0xC1: // Extended sequential, Huffman coded
+			{
+				if (segmentSize < 6 || segment[0] != 8)
+					return false;
+				jpeg.Height = ReadBE16(segment + 1);
+				jpeg.Width = ReadBE16(segment + 3);
+				jpeg.ComponentCount = segment[5];
+				if (jpeg.Width == 0 || jpeg.Height == 0 || (jpeg.ComponentCount != 1 && jpeg.ComponentCount != 3) ||
+					segmentSize < 6 + jpeg.ComponentCount * 3)
+					return false;
+
+				for (uint32 c = 0; c < jpeg.ComponentCount; ++c)
+				{
+					JpegComponent& component = jpeg.Components[c];
+					component.Id = segment[6 + c * 3];
+					component.H = segment[7 + c * 3] >> 4;
+					component.V = segment[7 + c * 3] & 15;
+					component.Quant = segment[8 + c * 3];
+					if (component.H < 1 || component.H > 2 || component.V < 1 || component.V > 2 || component.Quant > 3)
+						return false;
+					jpeg.MaxH = std::max(jpeg.MaxH, component.H);
+					jpeg.MaxV = std::max(jpeg.MaxV, component.V);
+				}
+				// A single component is not interleaved, its MCU is one block.
+				if (jpeg.ComponentCount == 1)
+				{
+					jpeg.Components[0].H = jpeg.Components[0].V = 1;
+					jpeg.MaxH = jpeg.MaxV = 1;
+				}
+				frame = true;
+				break;
+			}
+
+			case 0xC2: case 0xC3: case 0xC5: case 0xC6: case 0xC7:
+			case 0xC9: case 0xCA: case 0xCB: case 0xCD: case 0xCE: case 0xCF:
+				// Progressive, lossless, hierarchical or arithmetic coded.
+				return false;
+
+			case 0xDD: // DRI
+				if (segmentSize < 2)
+					return false;
+				jpeg.RestartInterval = ReadBE16(segment);
+				break;
+
+			case 0xE0: // APP0
+				jfif = jfif || (segmentSize >= 5 && memcmp(segment, "JFIF", 5) == 0);
+				break;
+
+			case 0xE1: // APP1
+				if (segmentSize >= 6 && memcmp(segment, "Exif\0\0", 6) == 0)
+					jpeg.Srgb = ExifSaysSrgb(segment + 6, segmentSize - 6);
+				break;
+
+			case 0xEE: // APP14
+				if (segmentSize >= 12 && memcmp(segment, "Adobe", 5) == 0)
+					adobeTransform = segment[11];
+				break;
+
+			case 0xDA: // SOS
+			{
+				// Only one scan with every component interleaved.
+				if (!frame || segmentSize < 1 || segment[0] != jpeg.ComponentCount || segmentSize < 4 + jpeg.ComponentCount * 2)
+					return false;
+				for (uint32 i = 0; i < jpeg.ComponentCount; ++i)
+				{
+					JpegComponent& component = jpeg.Components[i];
+					const uint32 tables = segment[2 + i * 2];
+					if (segment[1 + i * 2] != component.Id)
+						return false;
+					component.DcTable = tables >> 4;
+					component.AcTable = tables & 15;
+					if (component.DcTable > 3 || component.AcTable > 3 ||
+						!jpeg.Dc[component.DcTable].Defined || !jpeg.Ac[component.AcTable].Defined)
+						return false;
+				}
+				const uint8* spectral = segment + 1 + jpeg.ComponentCount * 2;
+				if (spectral[0] != 0 || spectral[1] != 63 || spectral[2] != 0)
+					return false;
+
+				jpeg.Scan = data + offset;
+				jpeg.End = data + byteSize;
+				jpeg.McusX = (jpeg.Width + jpeg.MaxH * 8 - 1) / (jpeg.MaxH * 8);
+				jpeg.McusY = (jpeg.Height + jpeg.MaxV * 8 - 1) / (jpeg.MaxV * 8);
+				for (uint32 c = 0; c < jpeg.ComponentCount; ++c)
+				{
+					JpegComponent& component = jpeg.Components[c];
+					component.Width = (jpeg.Width * component.H + jpeg.MaxH - 1) / jpeg.MaxH;
+					component.Height = (jpeg.Height * component.V + jpeg.MaxV - 1) / jpeg.MaxV;
+					component.Stride = jpeg.McusX * component.H * 8;
+				}
+
+				// Decided like libjpeg: JFIF is YCbCr, Adobe says which, else
+				// components named R, G, B are RGB.
+				if (jpeg.ComponentCount == 3)
+				{
+					if (jfif)
+						jpeg.Rgb = false;
+					else if (adobeTransform >= 0)
+						jpeg.Rgb = adobeTransform == 0;
+					else
+						jpeg.Rgb = jpeg.Components[0].Id == 'R' && jpeg.Components[1].Id == 'G' && jpeg.Components[2].Id == 'B';
+				}
+				return true;
+			}
+
+			case 0xD9: // EOI before any scan
+				return false;
+
+			default:
+				break;
+			}
+		}
+	}
+
+	void GetJpegInfo(const JpegImage& jpeg, ImageDecoder::Info& info)
+	{
+		info.Width = jpeg.Width;
+		info.Height = jpeg.Height;
+		if (jpeg.ComponentCount == 1)
+		{
+			info.Format = PixelFormat::R8;
+			info.BytesPerPixel = 1;
+		}
+		else
+		{
+			info.Format = jpeg.Srgb ? PixelFormat::Rgba8Srgb : PixelFormat::Rgba8;
+			info.BytesPerPixel = 4;
+		}
+	}
+
+	// Entropy coded data, most significant bit first.  Stops at markers and
+	// reads zeros after them.
+	class JpegBitReader
+	{
+	public:
+		JpegBitReader(const uint8* begin, const uint8* end)
+			:
+			mIn(begin),
+			mEnd(end)
+		{
+		}
+
+		int Decode(const JpegHuffman& table)
+		{
+			if (mCount < 16)
+				Refill();
+
+			const uint32 fast = table.Fast[mBits >> (64 - JpegHuffman::FastBits)];
+			if (fast != 0)
+			{
+				Consume(fast >> 8);
+				return fast & 255;
+			}
+
+			for (int length = JpegHuffman::FastBits + 1; length <= 16; ++length)
+			{
+				const int32 code = (int32)(mBits >> (64 - length));
+				if (code <= table.MaxCode[length])
+				{
+					Consume(length);
+					return table.Values[(code + table.ValueOffset[length]) & 255];
+				}
+			}
+			return -1;
+		}
+
+		// The next count bits as the signed value they code.
+		int32 Receive(int count)
+		{
+			if (count == 0)
+				return 0;
+			if (mCount < count)
+				Refill();
+			const int32 value = (int32)(mBits >> (64 - count));
+			Consume(count);
+			return value < (1 << (count - 1)) ? value - (1 << count) + 1 : value;
+		}
+
+	private:
+		void Refill()
+		{
+			while (mCount <= 56)
+			{
+				uint64 next = 0;
+				if (mIn < mEnd)
+				{
+					if (*mIn != 0xFF)
+					{
+						next = *mIn++;
+					}
+					else if (mIn + 1 < mEnd && mIn[1] == 0x00)
+					{
+						next = 0xFF;
+						mIn += 2;
+					}
+				}
+				mBits |= next << (56 - mCount);
+				mCount += 8;
+			}
+		}
+
+		void Consume(int count)
+		{
+			mBits <<= count;
+			mCount -= count;
+		}
+
+		const uint8* mIn;
+		const uint8* mEnd;
+		uint64 mBits = 0;
+		int mCount = 0;
+	};
+
+	// libjpeg's jpeg_idct_islow, so the output matches it bit for bit.
+	const int32 ConstBits = 13;
+	const int32 Pass1Bits = 2;
+
+	const int32 Fix_0_298631336 = 2446;
+	const int32 Fix_0_390180644 = 3196;
+	const int32 Fix_0_541196100 = 4433;
+	const int32 Fix_0_765366865 = 6270;
+	const int32 Fix_0_899976223 = 7373;
+	const int32 Fix_1_175875602 = 9633;
+	const int32 Fix_1_501321110 = 12299;
+	const int32 Fix_1_847759065 = 15137;
+	const int32 Fix_1_961570560 = 16069;
+	const int32 Fix_2_053119869 = 16819;
+	const int32 Fix_2_562915447 = 20995;
+	const int32 Fix_3_072711026 = 25172;
+
+	// Coefficients are kept in the range of libjpeg's JCOEF (int16), which the
+	// IDCT is exact for without overflowing.  Only damaged or hostile streams
+	// reach the limits.
+	int32 ClampCoefficient(int32 value)
+	{
+		return value < INT16_MIN ? INT16_MIN : value > INT16_MAX ? INT16_MAX : value;
+	}
+
+	int32 Descale(int32 x, int32 n)
+	{
+		return (x + (1 << (n - 1))) >> n;
+	}
+
+	// One pass of the 1D IDCT over in[0], in[step], .. in[7 * step].
+	template<typename TIn, typename TOut>
+	void Idct1D(const TIn* in, int step, TOut* out, int outStep, int32 shift, int32 bias)
+	{
+		int32 z2 = in[2 * step];
+		int32 z3 = in[6 * step];
+		int32 z1 = (z2 + z3) * Fix_0_541196100;
+		int32 tmp2 = z1 + z3 * -Fix_1_847759065;
+		int32 tmp3 = z1 + z2 * Fix_0_765366865;
+
+		int32 tmp0 = ((int32)in[0] + in[4 * step]) * (1 << ConstBits);
+		int32 tmp1 = ((int32)in[0] - in[4 * step]) * (1 << ConstBits);
+
+		const int32 tmp10 = tmp0 + tmp3;
+		const int32 tmp13 = tmp0 - tmp3;
+		const int32 tmp11 = tmp1 + tmp2;
+		const int32 tmp12 = tmp1 - tmp2;
+
+		tmp0 = in[7 * step];
+		tmp1 = in[5 * step];
+		tmp2 = in[3 * step];
+		tmp3 = in[1 * step];
+
+		z1 = tmp0 + tmp3;
+		z2 = tmp1 + tmp2;
+		z3 = tmp0 + tmp2;
+		int32 z4 = tmp1 + tmp3;
+		const int32 z5 = (z3 + z4) * Fix_1_175875602;
+
+		tmp0 *= Fix_0_298631336;
+		tmp1 *= Fix_2_053119869;
+		tmp2 *= Fix_3_072711026;
+		tmp3 *= Fix_1_501321110;
+		z1 *= -Fix_0_899976223;
+		z2 *= -Fix_2_562915447;
+		z3 *= -Fix_1_961570560;
+		z4 *= -Fix_0_390180644;
+
+		z3 += z5;
+		z4 += z5;
+
+		tmp0 += z1 + z3;
+		tmp1 += z2 + z4;
+		tmp2 += z2 + z3;
+		tmp3 += z1 + z4;
+
+		out[0 * outStep] = (TOut)(Descale(tmp10 + tmp3, shift) + bias);
+		out[7 * outStep] = (TOut)(Descale(tmp10 - tmp3, shift) + bias);
+		out[1 * outStep] = (TOut)(Descale(tmp11 + tmp2, shift) + bias);
+		out[6 * outStep] = (TOut)(Descale(tmp11 - tmp2, shift) + bias);
+		out[2 * outStep] = (TOut)(Descale(tmp12 + tmp1, shift) + bias);
+		out[5 * outStep] = (TOut)(Descale(tmp12 - tmp1, shift) + bias);
+		out[3 * outStep] = (TOut)(Descale(tmp13 + tmp0, shift) + bias);
+		out[4 * outStep] = (TOut)(Descale(tmp13 - tmp0, shift) + bias);
+	}
+
+	// Dequantized coefficients in natural order to 8x8 samples.
+	void Idct(const int32* coefficients, uint8* out, uint32 stride)
+	{
+		int32 workspace[64];
+		for (int column = 0; column < 8; ++column)
+		{
+			const int32* in = coefficients + column;
+			if (!in[8] && !in[16] && !in[24] && !in[32] && !in[40] && !in[48] && !in[56])
+			{
+				const int32 dc = in[0] * (1 << Pass1Bits);
+				for (int row = 0; row < 8; ++row)
+					workspace[row * 8 + column] = dc;
+				continue;
+			}
+			Idct1D(in, 8, workspace + column, 8, ConstBits - Pass1Bits, 0);
+		}
+
+		for (int row = 0; row < 8; ++row, out += stride)
+		{
+			const int32* in = workspace + row * 8;
+			int32 samples[8];
+			if (!in[1] && !in[2] && !in[3] && !in[4] && !in[5] && !in[6] && !in[7])
+			{
+				const int32 dc = Descale(in[0], Pass1Bits + 3) + 128;
+				for (int i = 0; i < 8; ++i)
+					samples[i] = dc;
+			}
+			else
+			{
+				Idct1D(in, 1, samples, 1, ConstBits + Pass1Bits + 3, 128);
+			}
+			for (int i = 0; i < 8; ++i)
+				out[i] = Clamp255(samples[i]);
+		}
+	}
+
+	// Decodes the MCUs [firstMcu, endMcu) from one restart interval.
+	bool DecodeJpegMcus(JpegImage& jpeg, const uint8* begin, const uint8* end, uint32 firstMcu, uint32 endMcu)
+	{
+		JpegBitReader bits(begin, end);
+		int32 dcPredictions[3] = {};
+		int32 coefficients[64];
+
+		for (uint32 mcu = firstMcu; mcu < endMcu; ++mcu)
+		{
+			const uint32 mcuX = mcu % jpeg.McusX;
+			const uint32 mcuY = mcu / jpeg.McusX;
+			for (uint32 c = 0; c < jpeg.ComponentCount; ++c)
+			{
+				JpegComponent& component = jpeg.Components[c];
+				const JpegHuffman& dc = jpeg.Dc[component.DcTable];
+				const JpegHuffman& ac = jpeg.Ac[component.AcTable];
+				const uint16* quant = jpeg.Quant[component.Quant];
+
+				for (uint32 v = 0; v < component.V; ++v)
+				{
+					for (uint32 h = 0; h < component.H; ++h)
+					{
+						memset(coefficients, 0, sizeof(coefficients));
+
+						const int dcSize = bits.Decode(dc);
+						if (dcSize < 0 || dcSize > 11)
+							return false;
+						dcPredictions[c] = ClampCoefficient(dcPredictions[c] + bits.Receive(dcSize));
+						coefficients[0] = ClampCoefficient(dcPredictions[c] * quant[0]);
+
+						for (uint32 k = 1; k < 64; )
+						{
+							const int symbol = bits.Decode(ac);
+							if (symbol < 0)
+								return false;
+							const int run = symbol >> 4;
+							const int size = symbol & 15;
+							if (size == 0)
+							{
+								if (run != 15)
+									break;
+								k += 16;
+								continue;
+							}
+							k += run;
+							const uint32 index = ZigZag[std::min<uint32>(k, 64 + 15)];
+							coefficients[index] = ClampCoefficient(bits.Receive(size) * quant[index]);
+							++k;
+						}
+
+						const uint32 blockX = (mcuX * component.H + h) * 8;
+						const uint32 blockY = (mcuY * component.V + v) * 8;
+						Idct(coefficients, component.Plane.data() + blockY * component.Stride + blockX, component.Stride);
+					}
+				}
+			}
+		}
+		return true;
+	}
+
+	// Row y of component c at full resolution, with libjpeg's fancy
+	// (triangle filter) upsampling where it is subsampled.
+	const uint8* UpsampleRow(const JpegImage& jpeg, const JpegComponent& component, uint32 y, uint8* buffer)
+	{
+		const bool h2 = component.H < jpeg.MaxH;
+		const bool v2 = component.V < jpeg.MaxV;
+		const uint8* row = component.Plane.data() + (v2 ? y / 2 : y) * component.Stride;
+		if (!h2 && !v2)
+			return row;
+
+		const uint32 width = component.Width;
+		if (!v2)
+		{
+			// h2v1
+			uint8* out = buffer;
+			uint32 value = row[0];
+			*out++ = (uint8)value;
+			*out++ = (uint8)((value * 3 + row[1] + 2) >> 2);
+			for (uint32 x = 1; x + 1 < width; ++x)
+			{
+				value = row[x] * 3;
+				*out++ = (uint8)((value + row[x - 1] + 1) >> 2);
+				*out++ = (uint8)((value + row[x + 1] + 2) >> 2);
+			}
+			value = row[width - 1];
+			*out++ = (uint8)((value * 3 + row[width - 2] + 1) >> 2);
+			*out++ = (uint8)value;
+			return buffer;
+		}
+
+		// The nearer neighbouring row, the edge rows repeat.
+		const uint32 inRow = y / 2;
+		const uint32 neighbour = (y & 1) ? std::min(inRow + 1, component.Height - 1) : (inRow > 0 ? inRow - 1 : 0);
+		const uint8* near = component.Plane.data() + neighbour * component.Stride;
+
+		if (!h2)
+		{
+			// h1v2
+			const uint32 bias = (y & 1) ? 2 : 1;
+			for (uint32 x = 0; x < width; ++x)
+				buffer[x] = (uint8)((row[x] * 3 + near[x] + bias) >> 2);
+			return buffer;
+		}
+
+		// h2v2
+		uint8* out = buffer;
+		int32 thisSum = row[0] * 3 + near[0];
+		int32 nextSum = row[1] * 3 + near[1];
+		*out++ = (uint8)((thisSum * 4 + 8) >> 4);
+		*out++ = (uint8)((thisSum * 3 + nextSum + 7) >> 4);
+		int32 lastSum = thisSum;
+		thisSum = nextSum;
+		for (uint32 x = 2; x < width; ++x)
+		{
+			nextSum = row[x] * 3 + near[x];
+			*out++ = (uint8)((thisSum * 3 + lastSum + 8) >> 4);
+			*out++ = (uint8)((thisSum * 3 + nextSum + 7) >> 4);
+			lastSum = thisSum;
+			thisSum = nextSum;
+		}
+		*out++ = (uint8)((thisSum * 3 + lastSum + 8) >> 4);
+		*out++ = (uint8)((thisSum * 4 + 7) >> 4);
+		return buffer;
+	}
+
+	bool DecodeJpeg(const uint8* data, size_t byteSize, uint8* destination, size_t rowPitch, uint32 threadCount)
+	{
+		JpegImage jpeg;
+		if (!ParseJpeg(data, byteSize, jpeg))
+			return false;
+
+		for (uint32 c = 0; c < jpeg.ComponentCount; ++c)
+		{
+			JpegComponent& component = jpeg.Components[c];
+			// Room for the upsampling to read one sample past a width of 1.
+			component.Plane.resize((size_t)component.Stride * jpeg.McusY * component.V * 8 + 1);
+		}
+
+		// Restart intervals start on whole bytes after RSTn markers and reset
+		// the DC predictions, so they decode independently.
+		std::vector<const uint8*> intervals(1, jpeg.Scan);
+		const uint8* end = jpeg.End;
+		for (const uint8* p = jpeg.Scan; p + 1 < jpeg.End; ++p)
+		{
+			if (*p != 0xFF || p[1] == 0x00 || p[1] == 0xFF)
+				continue;
+			if (p[1] < 0xD0 || p[1] > 0xD7)
+			{
+				end = p;
+				break;
+			}
+			intervals.push_back(p + 2);
+			++p;
+		}
+
+		const uint32 mcuCount = jpeg.McusX * jpeg.McusY;
+		const uint32 mcusPerInterval = jpeg.RestartInterval ? jpeg.RestartInterval : mcuCount;
+		const uint32 intervalCount = (mcuCount + mcusPerInterval - 1) / mcusPerInterval;
+		if (intervals.size() < intervalCount)
+			return false;
+
+		std::atomic<bool> ok(true);
+		WorkerPool::ParallelFor(intervalCount, threadCount, [&](uint32 i)
+		{
+			const uint8* intervalEnd = i + 1 < intervals.size() ? intervals[i + 1] : end;
+			if (!DecodeJpegMcus(jpeg, intervals[i], intervalEnd, i * mcusPerInterval, std::min(mcuCount, (i + 1) * mcusPerInterval)))
+				ok = false;
+		});
+		if (!ok)
+			return false;
+
+		WorkerPool::ParallelFor((jpeg.Height + RowsPerJob - 1) / RowsPerJob, threadCount, [&](uint32 job)
+		{
+			std::vector<uint8> buffers[3];
+			for (uint32 c = 0; c < jpeg.ComponentCount; ++c)
+				buffers[c].resize(jpeg.Width + 2);
+
+			const uint32 rowEnd = std::min(jpeg.Height, (job + 1) * RowsPerJob);
+			for (uint32 y = job * RowsPerJob; y < rowEnd; ++y)
+			{
+				uint8* out = destination + y * rowPitch;
+				if (jpeg.ComponentCount == 1)
+				{
+					memcpy(out, jpeg.Components[0].Plane.data() + y * jpeg.Components[0].Stride, jpeg.Width);
+					continue;
+				}
+
+				const uint8* rows[3];
+				for (uint32 c = 0; c < 3; ++c)
+					rows[c] = UpsampleRow(jpeg, jpeg.Components[c], y, buffers[c].data());
+
+				if (jpeg.Rgb)
+				{
+					uint32* out32 = reinterpret_cast<uint32*>(out);
+					for (uint32 x = 0; x < jpeg.Width; ++x)
+						out32[x] = rows[0][x] | ((uint32)rows[1][x] << 8) | ((uint32)rows[2][x] << 16) | 0xFF000000u;
+				}
+				else
+				{
+					YccToRgba(out, rows[0], rows[1], rows[2], jpeg.Width);
+				}
+			}
+		});
+		return true;
+	}
+
+	//
+	// TGA
+	//
+
+	struct TgaImage
+	{
+		uint32 Width = 0;
+		uint32 Height = 0;
+		uint32 ImageType = 0;
+		uint32 BitsPerPixel = 0;
+		bool TopDown = false;
+		bool Alpha = false;
+		// RGBA of color mapped images.
+		uint32 ColorMap[256] = {};
+		const uint8* Pixels = nullptr;
+		const uint8* End = nullptr;
+	};
+
+	// Pixel of a truecolor TGA (BGR(A) or 5-5-5-1) as RGBA.
+	uint32 TgaPixel(const uint8* pixel, uint32 bitsPerPixel, bool alpha)
+	{
+		switch (bitsPerPixel)
+		{
+		case 32:
+			return pixel[2] | ((uint32)pixel[1] << 8) | ((uint32)pixel[0] << 16) | ((uint32)(alpha ? pixel[3] : 0xFF) << 24);
+		case 24:
+			return pixel[2] | ((uint32)pixel[1] << 8) | ((uint32)pixel[0] << 16) | 0xFF000000u;
+		default:
+		{
+			const uint32 value = ReadLE16(pixel);
+			const uint32 r = (value >> 10) & 31;
+			const uint32 g = (value >> 5) & 31;
+			const uint32 b = value & 31;
+			return ((r << 3) | (r >> 2)) | (((g << 3) | (g >> 2)) << 8) | (((b << 3) | (b >> 2)) << 16) |
+				((alpha && !(value & 0x8000)) ? 0 : 0xFF000000u);
+		}
+		}
+	}
+
+	// TGA has no signature, the header has to make sense instead.
+	bool ParseTga(const uint8* data, size_t byteSize, TgaImage& tga)
+	{
+		if (byteSize < 18)
+			return false;
+
+		const uint32 idLength = data[0];
+		const uint32 colorMapType = data[1];
+		tga.ImageType = data[2];
+		const uint32 colorMapFirst = ReadLE16(data + 3);
+		const uint32 colorMapLength = ReadLE16(data + 5);
+		const uint32 colorMapBits = data[7];
+		tga.Width = ReadLE16(data + 12);
+		tga.Height = ReadLE16(data + 14);
+		tga.BitsPerPixel = data[16];
+		const uint32 descriptor = data[17];
+		tga.TopDown = (descriptor & 0x20) != 0;
+		tga.Alpha = (descriptor & 15) != 0;
+
+		const uint32 type = tga.ImageType & ~8u;
+		if (colorMapType > 1 || tga.Width == 0 || tga.Height == 0 || (descriptor & 0x10) || (descriptor & 0xC0))
+			return false;
+		if (type == 1)
+		{
+			if (colorMapType != 1 || tga.BitsPerPixel != 8 || colorMapFirst + colorMapLength > 256 ||
+				(colorMapBits != 15 && colorMapBits != 16 && colorMapBits != 24 && colorMapBits != 32))
+				return false;
+		}
+		else if (type == 2)
+		{
+			if (tga.BitsPerPixel != 15 && tga.BitsPerPixel != 16 && tga.BitsPerPixel != 24 && tga.BitsPerPixel != 32)
+				return false;
+		}
+		else if (type == 3)
+		{
+			if (tga.BitsPerPixel != 8)
+				return false;
+		}
+		else
+		{
+			return false;
+		}
+
+		size_t offset = 18 + idLength;
+		if (colorMapType == 1)
+		{
+			const uint32 entryBytes = (colorMapBits + 7) / 8;
+			if (offset + (size_t)colorMapLength * entryBytes > byteSize)
+				return false;
+			for (uint32 i = 0; i < colorMapLength && type == 1; ++i)
+				tga.ColorMap[colorMapFirst + i] = TgaPixel(data + offset + i * entryBytes, colorMapBits == 15 ? 16 : colorMapBits, tga.Alpha);
+			offset += (size_t)colorMapLength * entryBytes;
+		}
+
+		tga.Pixels = data + offset;
+		tga.End = data + byteSize;
+		return offset <= byteSize;
+	}
+
+	void GetTgaInfo(const TgaImage& tga, ImageDecoder::Info& info)
+	{
+		info.Width = tga.Width;
+		info.Height = tga.Height;
+		if ((tga.ImageType & ~8u) == 3)
+		{
+			info.Format = PixelFormat::R8;
+			info.BytesPerPixel = 1;
+		}
+		else
+		{
+			info.Format = PixelFormat::Rgba8;
+			info.BytesPerPixel = 4;
+		}
+	}
+
+	bool DecodeTga(const uint8* data, size_t byteSize, uint8* destination, size_t rowPitch, uint32 threadCount)
+	{
+		TgaImage tga;
+		if (!ParseTga(data, byteSize, tga))
+			return false;
+
+		const uint32 type = tga.ImageType & ~8u;
+		const uint32 pixelBytes = (tga.BitsPerPixel + 7) / 8;
+		const size_t rowBytes = (size_t)tga.Width * pixelBytes;
+
+		// Run length coded packets can cross rows, they are expanded first.
+		std::vector<uint8> expanded;
+		const uint8* pixels = tga.Pixels;
+		if (tga.ImageType & 8)
+		{
+			expanded.resize(rowBytes * tga.Height);
+			const uint8* in = tga.Pixels;
+			size_t out = 0;
+			while (out < expanded.size())
+			{
+				if (in >= tga.End)
+					return false;
+				const uint32 header = *in++;
+				const size_t count = (size_t)(header & 127) + 1;
+				const size_t bytes = count * pixelBytes;
+				if (out + bytes > expanded.size())
+					return false;
+				if (header & 128)
+				{
+					if ((size_t)(tga.End - in) < pixelBytes)
+						return false;
+					for (size_t i = 0; i < count; ++i)
+						memcpy(expanded.data() + out + i * pixelBytes, in, pixelBytes);
+					in += pixelBytes;
+				}
+				else
+				{
+					if ((size_t)(tga.End - in) < bytes)
+						return false;
+					memcpy(expanded.data() + out, in, bytes);
+					in += bytes;
+				}
+				out += bytes;
+			}
+			pixels = expanded.data();
+		}
+		else if ((size_t)(tga.End - tga.Pixels) < rowBytes * tga.Height)
+		{
+			return false;
+		}
+
+		ParallelRows(tga.Height, threadCount, [&](uint32 y)
+		{
+			const uint8* src = pixels + (tga.TopDown ? y : tga.Height - 1 - y) * rowBytes;
+			uint8* dst = destination + y * rowPitch;
+			uint32* dst32 = reinterpret_cast<uint32*>(dst);
+			if (type == 3)
+			{
+				memcpy(dst, src, tga.Width);
+			}
+			else if (type == 1)
+			{
+				for (uint32 x = 0; x < tga.Width; ++x)
+					dst32[x] = tga.ColorMap[src[x]];
+			}
+			else if (tga.BitsPerPixel == 32 && tga.Alpha)
+			{
+				SwapRedBlue(dst, src, tga.Width);
+			}
+			else if (tga.BitsPerPixel == 24)
+			{
+				BgrToRgba(dst, src, tga.Width);
+			}
+			else
+			{
+				for (uint32 x = 0; x < tga.Width; ++x)
+					dst32[x] = TgaPixel(src + x * pixelBytes, tga.BitsPerPixel == 15 ? 16 : tga.BitsPerPixel, tga.Alpha);
+			}
+		});
+		return true;
+	}
+
+	bool IsPng(const uint8* data, size_t byteSize)
+	{
+		return byteSize >= 8 && memcmp(data, PngSignature, 8) == 0;
+	}
+
+	bool IsJpeg(const uint8* data, size_t byteSize)
+	{
+		return byteSize >= 3 && data[0] == 0xFF && data[1] == 0xD8 && data[2] == 0xFF;
+	}
+}
+
+bool ImageDecoder::ReadInfo(const void* data, size_t byteSize, Info& info)
+{
+	const uint8* bytes = static_cast<const uint8*>(data);
+	if (IsPng(bytes, byteSize))
+	{
+		PngImage png;
+		if (!ParsePng(bytes, byteSize, png))
+			return false;
+		GetPngInfo(png, info);
+		return true;
+	}
+
+	if (IsJpeg(bytes, byteSize))
+	{
+		JpegImage jpeg;
+		if (!ParseJpeg(bytes, byteSize, jpeg))
+			return false;
+		GetJpegInfo(jpeg, info);
+		return true;
+	}
+
+	TgaImage tga;
+	if (!ParseTga(bytes, byteSize, tga))
+		return false;
+	GetTgaInfo(tga, info);
+	return true;
+}
+
+bool ImageDecoder::Decode(const void* data, size_t byteSize, void* destination, size_t rowPitch, uint32 threadCount)
+{
+	if (threadCount == 0)
+		threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+	const uint8* bytes = static_cast<const uint8*>(data);
+	uint8* out = static_cast<uint8*>(destination);
+	if (IsPng(bytes, byteSize))
+		return DecodePng(bytes, byteSize, out, rowPitch, threadCount);
+	if (IsJpeg(bytes, byteSize))
+		return DecodeJpeg(bytes, byteSize, out, rowPitch, threadCount);
+	return DecodeTga(bytes, byteSize, out, rowPitch, threadCount);
+}
\ No newline at end of file
@@ -0,0 +1,56 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Decodes PNG, baseline JPEG and TGA images without WIC, so the textures of
+// the assets load the same way on every platform.
+//
+// Images come out in the pixel format the WIC loader would pick for them
+// (8-bit RGBA PNGs as Bgra8, RGB and palette images as Rgba8, gray as R8 or
+// R16, sRGB when the file says so).  D3D12Util::GetDxgiFormat maps it to
+// the DXGI format.  Conversion to that format runs over rows on several
+// threads, with SSE2 for the swizzles and YCbCr, and JPEGs with restart
+// markers decode their intervals in parallel too.  Decode
+// writes every destination byte once and in order and never reads it back,
+// so the destination can be mapped upload memory.
+//
+// Interlaced PNGs and progressive or arithmetic coded JPEGs are not handled,
+// ReadInfo fails for them and the caller can fall back on WIC.
+class ImageDecoder
+{
+public:
+	using uint32 = std::uint32_t;
+
+	enum class PixelFormat
+	{
+		Unknown,
+		// Gray.
+		R8,
+		R16,
+		Rgba8,
+		Rgba8Srgb,
+		Bgra8,
+		Bgra8Srgb,
+		Rgba16,
+	};
+
+	struct Info
+	{
+		uint32 Width = 0;
+		uint32 Height = 0;
+		PixelFormat Format = PixelFormat::Unknown;
+		uint32 BytesPerPixel = 0;
+	};
+
+	///<summary>
+	/// Reads the size and the format Decode writes.  Returns false for files
+	/// that are not PNG, JPEG or TGA or use a variant that is not handled.
+	///</summary>
+	static bool ReadInfo(const void* data, size_t byteSize, Info& info);
+
+	///<summary>
+	/// Decodes into Height rows of rowPitch bytes at destination.  threadCount
+	/// 0 uses one thread per hardware thread.  Returns false for damaged files.
+	///</summary>
+	static bool Decode(const void* data, size_t byteSize, void* destination, size_t rowPitch, uint32 threadCount = 0);
+};
\ No newline at end of file
@@ -0,0 +1,24 @@
+#include "LodSelector.h"
+#include <cmath>
+
+namespace
+{
+	// Keeps the projected error finite for instances around the camera.
+	const float MinDistance = 0.01f;
+}
+
+void LodSelector::SetProjection(float fovY, float viewportHeight)
+{
+	mPixelsPerUnit = viewportHeight / (2.0f * std::tan(0.5f * fovY));
+}
+
+void LodSelector::SetThreshold(float pixelThreshold, float hysteresis)
+{
+	mPixelThreshold = pixelThreshold;
+	mHysteresis = hysteresis;
+}
+
+float LodSelector::ProjectedError(float error, float worldScale, float distance) const
+{
+	return error * worldScale * mPixelsPerUnit / std::max(distance, MinDistance);
+}
\ No newline at end of file
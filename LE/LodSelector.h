@@ -0,0 +1,73 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Picks a level of detail from the projected screen space error: the
+// coarsest level whose geometric error covers at most PixelThreshold pixels.
+//
+// A level only becomes coarser once it is clearly below the threshold and
+// only finer once the current one is clearly above it, so instances sitting
+// right at a switching distance do not pop back and forth every frame.
+//
+// Only needs the Error of each level (MeshLod or anything else with one), so
+// it does not depend on D3D12.
+class LodSelector
+{
+public:
+	using uint32 = std::uint32_t;
+
+	LodSelector() = default;
+
+	///<summary>
+	/// Call when the vertical field of view or the viewport height changes.
+	///</summary>
+	void SetProjection(float fovY, float viewportHeight);
+
+	///<summary>
+	/// hysteresis is the fraction of the threshold a level has to be below
+	/// (coarser) or above (finer) before the selection changes.
+	///</summary>
+	void SetThreshold(float pixelThreshold, float hysteresis);
+
+	///<summary>
+	/// Size in pixels of an object space error at the given view distance.
+	///</summary>
+	float ProjectedError(float error, float worldScale, float distance) const;
+
+	///<summary>
+	/// Returns the level to use for an instance that currently uses currentLod.
+	///</summary>
+	template<typename TLod>
+	uint32 Select(const std::vector<TLod>& lods, uint32 currentLod, float worldScale, float distance) const
+	{
+		if (lods.empty())
+			return 0;
+
+		currentLod = std::min(currentLod, (uint32)lods.size() - 1);
+
+		const float currentError = ProjectedError(lods[currentLod].Error, worldScale, distance);
+		if (currentError > mPixelThreshold * (1.0f + mHysteresis))
+			return CoarsestWithin(lods, mPixelThreshold, worldScale, distance);
+
+		uint32 coarser = CoarsestWithin(lods, mPixelThreshold * (1.0f - mHysteresis), worldScale, distance);
+		return std::max(coarser, currentLod);
+	}
+
+private:
+	template<typename TLod>
+	uint32 CoarsestWithin(const std::vector<TLod>& lods, float pixels, float worldScale, float distance) const
+	{
+		// Errors grow with the level, so stop at the first one that is too coarse.
+		uint32 lod = 0;
+		while (lod + 1 < lods.size() && ProjectedError(lods[lod + 1].Error, worldScale, distance) <= pixels)
+			lod++;
+
+		return lod;
+	}
+
+	// Viewport pixels per world unit at distance 1.
+	float mPixelsPerUnit = 1.0f;
+	float mPixelThreshold = 1.0f;
+	float mHysteresis = 0.25f;
+};
\ No newline at end of file
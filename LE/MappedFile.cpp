@@ -0,0 +1,103 @@
+#include "MappedFile.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const std::string& filename)
+{
+	Close();
+
+	mFile = ::CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (mFile == INVALID_HANDLE_VALUE)
+		return false;
+
+	// An empty file can not be mapped.
+	LARGE_INTEGER size;
+	if (!::GetFileSizeEx(mFile, &size) || size.QuadPart == 0)
+	{
+		Close();
+		return false;
+	}
+
+	mMapping = ::CreateFileMappingA(mFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mMapping != nullptr)
+		mView = static_cast<const unsigned char*>(::MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+	if (mView == nullptr)
+	{
+		Close();
+		return false;
+	}
+
+	mSize = (size_t)size.QuadPart;
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (mView != nullptr)
+		::UnmapViewOfFile(mView);
+	if (mMapping != nullptr)
+		::CloseHandle(mMapping);
+	if (mFile != INVALID_HANDLE_VALUE)
+		::CloseHandle(mFile);
+
+	mView = nullptr;
+	mMapping = nullptr;
+	mFile = INVALID_HANDLE_VALUE;
+	mSize = 0;
+}
+
+#else
+
+bool MappedFile::Open(const std::string& filename)
+{
+	Close();
+
+	mFile = ::open(filename.c_str(), O_RDONLY);
+	if (mFile < 0)
+		return false;
+
+	struct stat status;
+	if (::fstat(mFile, &status) != 0 || status.st_size == 0)
+	{
+		Close();
+		return false;
+	}
+
+	void* view = ::mmap(nullptr, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, mFile, 0);
+	if (view == MAP_FAILED)
+	{
+		Close();
+		return false;
+	}
+
+	mView = static_cast<const unsigned char*>(view);
+	mSize = (size_t)status.st_size;
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (mView != nullptr)
+		::munmap(const_cast<unsigned char*>(mView), mSize);
+	if (mFile >= 0)
+		::close(mFile);
+
+	mView = nullptr;
+	mFile = -1;
+	mSize = 0;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// A file mapped read only into memory.  Pages are only read from disk when
+// they are first touched, so formats that are stored in the layout they are
+// used in can be handed on straight from the mapping without a copy.
+//
+// Uses CreateFileMapping on Windows and mmap elsewhere, the code on top of
+// it does not depend on the platform.
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	MappedFile(const MappedFile& rhs) = delete;
+	MappedFile& operator=(const MappedFile& rhs) = delete;
+	~MappedFile();
+
+	///<summary>
+	/// Maps all of filename.  Returns false if it is missing or empty.
+	///</summary>
+	bool Open(const std::string& filename);
+	void Close();
+
+	const unsigned char* GetData() const
+	{
+		return mView;
+	}
+
+	size_t GetSize() const
+	{
+		return mSize;
+	}
+
+private:
+#ifdef _WIN32
+	HANDLE mFile = INVALID_HANDLE_VALUE;
+	HANDLE mMapping = nullptr;
+#else
+	int mFile = -1;
+#endif
+	const unsigned char* mView = nullptr;
+	size_t mSize = 0;
+};
\ No newline at end of file
@@ -0,0 +1,338 @@
+#include "MeshBuilder.h"
+#include "BoundsFitter.h"
+#include "GeometryArena.h"
+#include <algorithm>
+
+const size_t MeshBuilder::MaxVerticesPer16BitPart;
+
+namespace
+{
+	const MeshBuilder::uint32 InvalidIndex = ~0u;
+
+	std::string PartName(const std::string& name, size_t part)
+	{
+		return part == 0 ? name : name + "#" + std::to_string(part);
+	}
+
+	template<typename TBounded>
+	void SetBounds(TBounded& target, const unsigned char* vertices, size_t vertexCount, UINT vertexByteStride)
+	{
+		MeshBounds bounds = BoundsFitter::Compute(reinterpret_cast<const float*>(vertices), vertexCount, vertexByteStride);
+		target.Bounds = bounds.Box;
+		target.SphereBounds = bounds.Sphere;
+		target.OrientedBounds = bounds.OrientedBox;
+	}
+
+	void CreateOwnBuffers(MeshGeometry& geo, ID3D12Device* device, ID3D12GraphicsCommandList* cmdList)
+	{
+		geo.VertexBufferGPU = D3D12Util::CreateDefaultBuffer(device, cmdList,
+			geo.VertexBufferCPU->GetBufferPointer(), geo.VertexBufferByteSize, geo.VertexBufferUploader);
+
+		geo.IndexBufferGPU = D3D12Util::CreateDefaultBuffer(device, cmdList,
+			geo.IndexBufferCPU->GetBufferPointer(), geo.IndexBufferByteSize, geo.IndexBufferUploader);
+	}
+}
+
+MeshBuilder::MeshBuilder(const std::string& name, UINT vertexByteStride)
+	:
+	mName(name),
+	mVertexByteStride(vertexByteStride)
+{
+}
+
+void MeshBuilder::SetSplitOversizedMeshes(bool split)
+{
+	mSplitOversizedMeshes = split;
+}
+
+void MeshBuilder::AddMesh(const std::string& drawArgName, const void* vertices, size_t vertexCount, const uint16* indices, size_t indexCount, float lodError)
+{
+	std::vector<uint32> indices32(indices, indices + indexCount);
+	AddMesh(drawArgName, vertices, vertexCount, indices32.data(), indices32.size(), lodError);
+}
+
+void MeshBuilder::AddMesh(const std::string& drawArgName, const void* vertices, size_t vertexCount, const uint32* indices, size_t indexCount, float lodError)
+{
+	MeshEntry mesh;
+	mesh.Name = drawArgName;
+	mesh.FirstVertex = mVertices.size() / mVertexByteStride;
+	mesh.VertexCount = vertexCount;
+	mesh.FirstIndex = mIndices.size();
+	mesh.IndexCount = indexCount;
+	mesh.LodError = lodError;
+	mMeshes.push_back(mesh);
+
+	const unsigned char* bytes = static_cast<const unsigned char*>(vertices);
+	mVertices.insert(mVertices.end(), bytes, bytes + vertexCount * mVertexByteStride);
+	mIndices.insert(mIndices.end(), indices, indices + indexCount);
+}
+
+bool MeshBuilder::NeedsSplit(const MeshEntry& mesh) const
+{
+	return mesh.VertexCount > MaxVerticesPer16BitPart;
+}
+
+DXGI_FORMAT MeshBuilder::GetIndexFormat() const
+{
+	if (mSplitOversizedMeshes)
+		return DXGI_FORMAT_R16_UINT;
+
+	for (const MeshEntry& mesh : mMeshes)
+	{
+		if (NeedsSplit(mesh))
+			return DXGI_FORMAT_R32_UINT;
+	}
+
+	return DXGI_FORMAT_R16_UINT;
+}
+
+template<typename TIndex>
+void MeshBuilder::WriteIndices(std::vector<unsigned char>& vertexData, std::vector<TIndex>& indexData,
+	std::unordered_map<std::string, SubmeshGeometry>& drawArgs) const
+{
+	vertexData.reserve(mVertices.size());
+	indexData.reserve(mIndices.size());
+
+	for (const MeshEntry& mesh : mMeshes)
+	{
+		if (sizeof(TIndex) == sizeof(uint16) && NeedsSplit(mesh))
+		{
+			WriteSplitMesh(mesh, vertexData, indexData, drawArgs);
+			continue;
+		}
+
+		SubmeshGeometry submesh;
+		submesh.IndexCount = (UINT)mesh.IndexCount;
+		submesh.StartIndexLocation = (UINT)indexData.size();
+		submesh.BaseVertexLocation = (INT)(vertexData.size() / mVertexByteStride);
+		submesh.LodError = mesh.LodError;
+
+		const unsigned char* vertices = mVertices.data() + mesh.FirstVertex * mVertexByteStride;
+		vertexData.insert(vertexData.end(), vertices, vertices + mesh.VertexCount * mVertexByteStride);
+		SetBounds(submesh, vertices, mesh.VertexCount, mVertexByteStride);
+		for (size_t i = 0; i < mesh.IndexCount; ++i)
+			indexData.push_back(static_cast<TIndex>(mIndices[mesh.FirstIndex + i]));
+
+		drawArgs[mesh.Name] = submesh;
+	}
+}
+
+template<typename TIndex>
+void MeshBuilder::WriteSplitMesh(const MeshEntry& mesh, std::vector<unsigned char>& vertexData, std::vector<TIndex>& indexData,
+	std::unordered_map<std::string, SubmeshGeometry>& drawArgs) const
+{
+	// Walk the triangles in order and start a new part whenever the next
+	// triangle would reference one vertex too many.  Vertices are copied into
+	// each part in first-use order, so the parts also stay fetch friendly.
+	std::vector<uint32> partIndex(mesh.VertexCount, InvalidIndex);
+	std::vector<uint32> partVertices;
+	SubmeshGeometry part;
+	part.LodError = mesh.LodError;
+	size_t partCount = 0;
+
+	auto flushPart = [&]()
+	{
+		if (part.IndexCount == 0)
+			return;
+
+		part.BaseVertexLocation = (INT)(vertexData.size() / mVertexByteStride);
+		for (uint32 v : partVertices)
+		{
+			const unsigned char* vertex = mVertices.data() + (mesh.FirstVertex + v) * mVertexByteStride;
+			vertexData.insert(vertexData.end(), vertex, vertex + mVertexByteStride);
+			partIndex[v] = InvalidIndex;
+		}
+		SetBounds(part, vertexData.data() + part.BaseVertexLocation * mVertexByteStride, partVertices.size(), mVertexByteStride);
+
+		drawArgs[PartName(mesh.Name, partCount++)] = part;
+
+		partVertices.clear();
+		part = SubmeshGeometry();
+		part.LodError = mesh.LodError;
+	};
+
+	const uint32* indices = mIndices.data() + mesh.FirstIndex;
+	for (size_t t = 0; t + 2 < mesh.IndexCount; t += 3)
+	{
+		size_t newVertices = 0;
+		for (size_t k = 0; k < 3; ++k)
+		{
+			uint32 v = indices[t + k];
+			bool seen = partIndex[v] != InvalidIndex ||
+				(k > 0 && indices[t] == v) ||
+				(k > 1 && indices[t + 1] == v);
+			if (!seen)
+				newVertices++;
+		}
+
+		if (partVertices.size() + newVertices > MaxVerticesPer16BitPart)
+			flushPart();
+
+		if (part.IndexCount == 0)
+			part.StartIndexLocation = (UINT)indexData.size();
+
+		for (size_t k = 0; k < 3; ++k)
+		{
+			uint32 v = indices[t + k];
+			if (partIndex[v] == InvalidIndex)
+			{
+				partIndex[v] = (uint32)partVertices.size();
+				partVertices.push_back(v);
+			}
+			indexData.push_back(static_cast<TIndex>(partIndex[v]));
+		}
+		part.IndexCount += 3;
+	}
+
+	flushPart();
+}
+
+std::unique_ptr<MeshGeometry> MeshBuilder::BuildCPU() const
+{
+	auto geo = std::make_unique<MeshGeometry>();
+	geo->Name = mName;
+	geo->IndexFormat = GetIndexFormat();
+
+	std::vector<unsigned char> vertexData;
+	std::vector<uint16> indices16;
+	std::vector<uint32> indices32;
+
+	const void* indexData = nullptr;
+	UINT ibByteSize = 0;
+	if (geo->IndexFormat == DXGI_FORMAT_R16_UINT)
+	{
+		WriteIndices(vertexData, indices16, geo->DrawArgs);
+		indexData = indices16.data();
+		ibByteSize = (UINT)(indices16.size() * sizeof(uint16));
+	}
+	else
+	{
+		WriteIndices(vertexData, indices32, geo->DrawArgs);
+		indexData = indices32.data();
+		ibByteSize = (UINT)(indices32.size() * sizeof(uint32));
+	}
+
+	const UINT vbByteSize = (UINT)vertexData.size();
+	SetBounds(*geo, vertexData.data(), vertexData.size() / mVertexByteStride, mVertexByteStride);
+
+	ThrowIfFailed(D3DCreateBlob(vbByteSize, &geo->VertexBufferCPU));
+	CopyMemory(geo->VertexBufferCPU->GetBufferPointer(), vertexData.data(), vbByteSize);
+
+	ThrowIfFailed(D3DCreateBlob(ibByteSize, &geo->IndexBufferCPU));
+	CopyMemory(geo->IndexBufferCPU->GetBufferPointer(), indexData, ibByteSize);
+
+	geo->VertexByteStride = mVertexByteStride;
+	geo->VertexBufferByteSize = vbByteSize;
+	geo->IndexBufferByteSize = ibByteSize;
+
+	return geo;
+}
+
+std::unique_ptr<MeshGeometry> MeshBuilder::Build(ID3D12Device* device, ID3D12GraphicsCommandList* cmdList) const
+{
+	auto geo = BuildCPU();
+
+	CreateOwnBuffers(*geo, device, cmdList);
+
+	return geo;
+}
+
+std::unique_ptr<MeshGeometry> MeshBuilder::Build(GeometryArena& arena, ID3D12Device* device, ID3D12GraphicsCommandList* cmdList) const
+{
+	auto geo = BuildCPU();
+
+	if (arena.Upload(*geo, geo->VertexBufferCPU->GetBufferPointer(), geo->VertexBufferByteSize,
+		geo->IndexBufferCPU->GetBufferPointer(), geo->IndexBufferByteSize))
+	{
+		return geo;
+	}
+
+	std::string message = "[MeshBuilder] GeometryArena is full, " + mName + " gets its own buffers.\n";
+	::OutputDebugStringA(message.c_str());
+
+	CreateOwnBuffers(*geo, device, cmdList);
+
+	return geo;
+}
+
+std::vector<SubmeshGeometry> MeshBuilder::GetDrawArgParts(const MeshGeometry& geo, const std::string& drawArgName)
+{
+	std::vector<SubmeshGeometry> parts;
+	for (size_t part = 0; ; ++part)
+	{
+		auto it = geo.DrawArgs.find(PartName(drawArgName, part));
+		if (it == geo.DrawArgs.end())
+			break;
+		parts.push_back(it->second);
+	}
+
+	return parts;
+}
+
+void MeshBuilder::BuildClusters(MeshGeometry& geo, const std::string& drawArgName)
+{
+	// The DrawArgs may be rebased onto a GeometryArena, the CPU copies are not.
+	const UINT indexSize = geo.IndexFormat == DXGI_FORMAT_R32_UINT ? 4 : 2;
+	const INT firstVertex = geo.Arena != nullptr ? (INT)geo.ArenaFirstVertex : 0;
+	const UINT firstIndex = geo.Arena != nullptr ? (UINT)(geo.ArenaIndexByteOffset / indexSize) : 0;
+
+	const unsigned char* vertexData = static_cast<const unsigned char*>(geo.VertexBufferCPU->GetBufferPointer());
+	const uint16* indices16 = static_cast<const uint16*>(geo.IndexBufferCPU->GetBufferPointer());
+	const uint32* indices32 = static_cast<const uint32*>(geo.IndexBufferCPU->GetBufferPointer());
+
+	std::vector<uint32> indices;
+	for (size_t part = 0; ; ++part)
+	{
+		const std::string name = PartName(drawArgName, part);
+		auto it = geo.DrawArgs.find(name);
+		if (it == geo.DrawArgs.end())
+			break;
+
+		const SubmeshGeometry& submesh = it->second;
+		const size_t start = submesh.StartIndexLocation - firstIndex;
+		uint32 vertexCount = 0;
+		indices.resize(submesh.IndexCount);
+		for (size_t i = 0; i < indices.size(); ++i)
+		{
+			indices[i] = indexSize == 4 ? indices32[start + i] : indices16[start + i];
+			vertexCount = std::max(vertexCount, indices[i] + 1);
+		}
+
+		const unsigned char* partVertices = vertexData + (size_t)(submesh.BaseVertexLocation - firstVertex) * geo.VertexByteStride;
+		geo.Clusters[name] = MeshClusterBuilder::Build(indices.data(), indices.size(),
+			reinterpret_cast<const float*>(partVertices), vertexCount, geo.VertexByteStride);
+	}
+}
+
+std::vector<const MeshClusterSet*> MeshBuilder::GetPartClusters(const MeshGeometry& geo, const std::string& drawArgName)
+{
+	std::vector<const MeshClusterSet*> clusters;
+	for (size_t part = 0; geo.DrawArgs.count(PartName(drawArgName, part)) != 0; ++part)
+	{
+		auto it = geo.Clusters.find(PartName(drawArgName, part));
+		clusters.push_back(it != geo.Clusters.end() ? &it->second : nullptr);
+	}
+
+	return clusters;
+}
+
+std::string MeshBuilder::LodName(const std::string& drawArgName, size_t lod)
+{
+	return lod == 0 ? drawArgName : drawArgName + "_lod" + std::to_string(lod);
+}
+
+std::vector<MeshLod> MeshBuilder::GetLodChain(const MeshGeometry& geo, const std::string& drawArgName)
+{
+	std::vector<MeshLod> lods;
+	for (size_t lod = 0; ; ++lod)
+	{
+		MeshLod level;
+		level.Parts = GetDrawArgParts(geo, LodName(drawArgName, lod));
+		if (level.Parts.empty())
+			break;
+		level.Error = level.Parts[0].LodError;
+		lods.push_back(level);
+	}
+
+	return lods;
+}
\ No newline at end of file
@@ -0,0 +1,133 @@
+#pragma once
+#include "MeshGeometry.h"
+
+class GeometryArena;
+
+// Collects meshes that share one vertex layout and uploads them into a single
+// MeshGeometry, filling DrawArgs for each of them.
+//
+// The index format is chosen per geometry: R16_UINT whenever every draw can be
+// addressed with 16 bits.  Each mesh gets its own BaseVertexLocation, so this
+// only depends on the vertex count of the individual meshes.  Meshes with more
+// vertices than that are split into parts of at most MaxVerticesPer16BitPart
+// vertices (duplicating the vertices on the seams), unless splitting is turned
+// off, in which case the whole geometry falls back to R32_UINT.
+//
+// The parts of a split mesh are registered as "name", "name#1", "name#2", ...
+// and can be collected with GetDrawArgParts.
+//
+// The bounds of every SubmeshGeometry and of the whole MeshGeometry are fitted
+// to the float3 position every vertex layout passed in has to start with.
+class MeshBuilder
+{
+public:
+	using uint16 = std::uint16_t;
+	using uint32 = std::uint32_t;
+
+	// Vertices one draw with 16-bit indices can reference.
+	static const size_t MaxVerticesPer16BitPart = 65536;
+
+	MeshBuilder(const std::string& name, UINT vertexByteStride);
+	MeshBuilder(const MeshBuilder& rhs) = delete;
+	MeshBuilder& operator=(const MeshBuilder& rhs) = delete;
+
+	///<summary>
+	/// Splitting only works on triangle lists.  Turn it off for other
+	/// topologies, or to keep oversized meshes in a single draw with 32-bit indices.
+	///</summary>
+	void SetSplitOversizedMeshes(bool split);
+
+	///<summary>
+	/// Adds a mesh.  Indices are relative to the first vertex of this mesh.
+	/// lodError ends up in SubmeshGeometry::LodError of its draws.
+	///</summary>
+	void AddMesh(const std::string& drawArgName, const void* vertices, size_t vertexCount, const uint16* indices, size_t indexCount, float lodError = 0.0f);
+	void AddMesh(const std::string& drawArgName, const void* vertices, size_t vertexCount, const uint32* indices, size_t indexCount, float lodError = 0.0f);
+
+	template<typename TVertex, typename TIndex>
+	void AddMesh(const std::string& drawArgName, const std::vector<TVertex>& vertices, const std::vector<TIndex>& indices, float lodError = 0.0f)
+	{
+		assert(sizeof(TVertex) == mVertexByteStride);
+		AddMesh(drawArgName, vertices.data(), vertices.size(), indices.data(), indices.size(), lodError);
+	}
+
+	///<summary>
+	/// Index format Build will use for the meshes added so far.
+	///</summary>
+	DXGI_FORMAT GetIndexFormat() const;
+
+	///<summary>
+	/// Creates the CPU copies and the default heap buffers.  The upload is
+	/// recorded on cmdList, so the uploaders have to stay alive until it executed.
+	///</summary>
+	std::unique_ptr<MeshGeometry> Build(ID3D12Device* device, ID3D12GraphicsCommandList* cmdList) const;
+
+	///<summary>
+	/// Same as above, but sub-allocates the GPU buffers from arena, whose
+	/// copies GeometryArena::RecordUploads records.  Falls back to own
+	/// buffers when the arena is full.
+	///</summary>
+	std::unique_ptr<MeshGeometry> Build(GeometryArena& arena, ID3D12Device* device, ID3D12GraphicsCommandList* cmdList) const;
+
+	///<summary>
+	/// All draws of a mesh added through MeshBuilder, one per part it was split into.
+	///</summary>
+	static std::vector<SubmeshGeometry> GetDrawArgParts(const MeshGeometry& geo, const std::string& drawArgName);
+
+	///<summary>
+	/// Builds the clusters of every part of a mesh added through MeshBuilder,
+	/// from the CPU copies of geo, and stores them in geo.Clusters under the
+	/// name of their part.  Cluster vertices are relative to the part they
+	/// are drawn with.
+	///</summary>
+	static void BuildClusters(MeshGeometry& geo, const std::string& drawArgName);
+
+	///<summary>
+	/// The clusters of each part of a mesh, in the order of GetDrawArgParts,
+	/// nullptr for parts without clusters.
+	///</summary>
+	static std::vector<const MeshClusterSet*> GetPartClusters(const MeshGeometry& geo, const std::string& drawArgName);
+
+	///<summary>
+	/// Name to add level of detail lod of a mesh under, "name" for level 0
+	/// and "name_lod1", "name_lod2", ... for the simplified ones.
+	///</summary>
+	static std::string LodName(const std::string& drawArgName, size_t lod);
+
+	///<summary>
+	/// All levels of detail of a mesh that were added under LodName.
+	///</summary>
+	static std::vector<MeshLod> GetLodChain(const MeshGeometry& geo, const std::string& drawArgName);
+
+private:
+	struct MeshEntry
+	{
+		std::string Name;
+		size_t FirstVertex = 0;
+		size_t VertexCount = 0;
+		size_t FirstIndex = 0;
+		size_t IndexCount = 0;
+		float LodError = 0.0f;
+	};
+
+	bool NeedsSplit(const MeshEntry& mesh) const;
+
+	// Packs the meshes into a MeshGeometry with only the CPU blobs, DrawArgs and sizes filled in.
+	std::unique_ptr<MeshGeometry> BuildCPU() const;
+
+	template<typename TIndex>
+	void WriteIndices(std::vector<unsigned char>& vertexData, std::vector<TIndex>& indexData,
+		std::unordered_map<std::string, SubmeshGeometry>& drawArgs) const;
+
+	template<typename TIndex>
+	void WriteSplitMesh(const MeshEntry& mesh, std::vector<unsigned char>& vertexData, std::vector<TIndex>& indexData,
+		std::unordered_map<std::string, SubmeshGeometry>& drawArgs) const;
+
+	std::string mName;
+	UINT mVertexByteStride = 0;
+	bool mSplitOversizedMeshes = true;
+
+	std::vector<unsigned char> mVertices;
+	std::vector<uint32> mIndices;
+	std::vector<MeshEntry> mMeshes;
+};
\ No newline at end of file
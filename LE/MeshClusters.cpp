@@ -0,0 +1,267 @@
+#include "MeshClusters.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+
+using namespace DirectX;
+
+const size_t MeshClusterBuilder::MaxVertices;
+const size_t MeshClusterBuilder::MaxTriangles;
+
+namespace
+{
+	using uint32 = MeshClusterBuilder::uint32;
+	using uint64 = MeshClusterBuilder::uint64;
+
+	const uint32 InvalidIndex = ~0u;
+
+	// A cone is only worth testing while all normals stay within about 84
+	// degrees of the axis, beyond that it hardly ever culls anything.
+	const float MinConeDot = 0.1f;
+
+	XMFLOAT3 LoadPosition(const float* positions, size_t positionByteStride, uint32 v)
+	{
+		const float* p = reinterpret_cast<const float*>(reinterpret_cast<const unsigned char*>(positions) + v * positionByteStride);
+		return XMFLOAT3(p[0], p[1], p[2]);
+	}
+
+	void ComputeClusterBounds(MeshCluster& cluster, const MeshClusterSet& set, const float* positions, size_t positionByteStride)
+	{
+		const uint32* vertices = &set.Vertices[cluster.VertexOffset];
+		const std::uint8_t* triangles = &set.Triangles[cluster.TriangleOffset * 3];
+
+		XMVECTOR minimum = XMVectorReplicate(FLT_MAX);
+		XMVECTOR maximum = XMVectorReplicate(-FLT_MAX);
+		for (uint32 i = 0; i < cluster.VertexCount; ++i)
+		{
+			XMFLOAT3 p = LoadPosition(positions, positionByteStride, vertices[i]);
+			minimum = XMVectorMin(minimum, XMLoadFloat3(&p));
+			maximum = XMVectorMax(maximum, XMLoadFloat3(&p));
+		}
+		XMStoreFloat3(&cluster.AabbMin, minimum);
+		XMStoreFloat3(&cluster.AabbMax, maximum);
+
+		// Sphere around the box center, a few percent larger than the optimum
+		// but cheap and stable.
+		XMVECTOR center = 0.5f * (minimum + maximum);
+		float radiusSq = 0.0f;
+		for (uint32 i = 0; i < cluster.VertexCount; ++i)
+		{
+			XMFLOAT3 p = LoadPosition(positions, positionByteStride, vertices[i]);
+			radiusSq = std::max(radiusSq, XMVectorGetX(XMVector3LengthSq(XMLoadFloat3(&p) - center)));
+		}
+		XMStoreFloat3(&cluster.Center, center);
+		cluster.Radius = sqrtf(radiusSq);
+
+		// Normal cone: the axis is the average triangle normal, the spread the
+		// largest angle between a normal and the axis.
+		std::vector<XMVECTOR> corners(cluster.TriangleCount * 3);
+		std::vector<XMVECTOR> normals(cluster.TriangleCount);
+		XMVECTOR axis = XMVectorZero();
+		for (uint32 t = 0; t < cluster.TriangleCount; ++t)
+		{
+			for (uint32 k = 0; k < 3; ++k)
+			{
+				XMFLOAT3 p = LoadPosition(positions, positionByteStride, vertices[triangles[t * 3 + k]]);
+				corners[t * 3 + k] = XMLoadFloat3(&p);
+			}
+
+			// Clockwise front faces, so this normal points to the front.
+			XMVECTOR normal = XMVector3Cross(corners[t * 3 + 1] - corners[t * 3], corners[t * 3 + 2] - corners[t * 3]);
+			normals[t] = XMVector3Equal(normal, XMVectorZero()) ? XMVectorZero() : XMVector3Normalize(normal);
+			axis += normals[t];
+		}
+
+		cluster.ConeAxis = XMFLOAT3(0.0f, 0.0f, 0.0f);
+		cluster.ConeApex = cluster.Center;
+		cluster.ConeCutoff = 1.0f;
+		if (XMVector3Equal(axis, XMVectorZero()))
+			return;
+		axis = XMVector3Normalize(axis);
+
+		float minDot = 1.0f;
+		for (uint32 t = 0; t < cluster.TriangleCount; ++t)
+		{
+			if (!XMVector3Equal(normals[t], XMVectorZero()))
+				minDot = std::min(minDot, XMVectorGetX(XMVector3Dot(normals[t], axis)));
+		}
+		if (minDot <= MinConeDot)
+			return;
+
+		// Move the apex back along the axis until it is behind every triangle
+		// plane, so the test holds for eyes close to the cluster as well.
+		float maxT = 0.0f;
+		for (uint32 t = 0; t < cluster.TriangleCount; ++t)
+		{
+			float normalDotAxis = XMVectorGetX(XMVector3Dot(normals[t], axis));
+			if (normalDotAxis <= 0.0f)
+				continue;
+			float distance = XMVectorGetX(XMVector3Dot(center - corners[t * 3], normals[t]));
+			maxT = std::max(maxT, distance / normalDotAxis);
+		}
+
+		XMStoreFloat3(&cluster.ConeAxis, axis);
+		XMStoreFloat3(&cluster.ConeApex, center - axis * maxT);
+		cluster.ConeCutoff = sqrtf(1.0f - minDot * minDot);
+	}
+}
+
+ClusterView ClusterView::FromMatrix(const XMFLOAT4X4& m, const XMFLOAT3& eyePosition)
+{
+	// Row vectors, so clip = p * M and the planes come from the columns:
+	// -w <= x <= w, -w <= y <= w, 0 <= z <= w.
+	XMVECTOR column0 = XMVectorSet(m._11, m._21, m._31, m._41);
+	XMVECTOR column1 = XMVectorSet(m._12, m._22, m._32, m._42);
+	XMVECTOR column2 = XMVectorSet(m._13, m._23, m._33, m._43);
+	XMVECTOR column3 = XMVectorSet(m._14, m._24, m._34, m._44);
+
+	XMVECTOR planes[6] =
+	{
+		column3 + column0,
+		column3 - column0,
+		column3 + column1,
+		column3 - column1,
+		column2,
+		column3 - column2,
+	};
+
+	ClusterView view;
+	for (int i = 0; i < 6; ++i)
+		XMStoreFloat4(&view.Planes[i], XMPlaneNormalize(planes[i]));
+	view.EyePosition = eyePosition;
+
+	return view;
+}
+
+MeshClusterSet MeshClusterBuilder::Build(const uint32* indices, size_t indexCount, const float* positions, size_t vertexCount,
+	size_t positionByteStride, size_t maxVertices, size_t maxTriangles)
+{
+	// Local indices are stored in 8 bits.
+	maxVertices = std::min<size_t>(maxVertices, 256);
+
+	MeshClusterSet set;
+	set.SourceHash = HashSource(indices, indexCount, positions, vertexCount, positionByteStride);
+
+	std::vector<uint32> localIndex(vertexCount, InvalidIndex);
+	MeshCluster cluster;
+
+	auto flush = [&]()
+	{
+		if (cluster.TriangleCount == 0)
+			return;
+
+		for (uint32 i = 0; i < cluster.VertexCount; ++i)
+			localIndex[set.Vertices[cluster.VertexOffset + i]] = InvalidIndex;
+
+		set.Clusters.push_back(cluster);
+
+		cluster = MeshCluster();
+		cluster.VertexOffset = (uint32)set.Vertices.size();
+		cluster.TriangleOffset = (uint32)(set.Triangles.size() / 3);
+	};
+
+	for (size_t t = 0; t + 2 < indexCount; t += 3)
+	{
+		uint32 a = indices[t], b = indices[t + 1], c = indices[t + 2];
+		uint32 newVertices = (localIndex[a] == InvalidIndex) + (localIndex[b] == InvalidIndex && b != a) +
+			(localIndex[c] == InvalidIndex && c != a && c != b);
+
+		if (cluster.VertexCount + newVertices > maxVertices || cluster.TriangleCount >= maxTriangles)
+			flush();
+
+		for (size_t k = 0; k < 3; ++k)
+		{
+			uint32 v = indices[t + k];
+			if (localIndex[v] == InvalidIndex)
+			{
+				localIndex[v] = cluster.VertexCount++;
+				set.Vertices.push_back(v);
+			}
+			set.Triangles.push_back((std::uint8_t)localIndex[v]);
+		}
+		cluster.TriangleCount++;
+	}
+	flush();
+
+	for (MeshCluster& c : set.Clusters)
+		ComputeClusterBounds(c, set, positions, positionByteStride);
+
+	return set;
+}
+
+MeshClusterBuilder::CullStats MeshClusterBuilder::Cull(const MeshClusterSet& set, const ClusterView& view, std::vector<uint32>& indices)
+{
+	CullStats stats;
+	stats.Clusters = (uint32)set.Clusters.size();
+
+	XMVECTOR eye = XMLoadFloat3(&view.EyePosition);
+	for (const MeshCluster& cluster : set.Clusters)
+	{
+		XMVECTOR center = XMLoadFloat3(&cluster.Center);
+
+		bool outside = false;
+		for (int i = 0; i < 6 && !outside; ++i)
+			outside = XMVectorGetX(XMPlaneDotCoord(XMLoadFloat4(&view.Planes[i]), center)) < -cluster.Radius;
+		if (outside)
+		{
+			stats.FrustumCulled++;
+			continue;
+		}
+
+		XMVECTOR toApex = XMLoadFloat3(&cluster.ConeApex) - eye;
+		float distance = XMVectorGetX(XMVector3Length(toApex));
+		if (XMVectorGetX(XMVector3Dot(toApex, XMLoadFloat3(&cluster.ConeAxis))) >= cluster.ConeCutoff * distance && distance > 0.0f)
+		{
+			stats.BackfaceCulled++;
+			continue;
+		}
+
+		const uint32* vertices = &set.Vertices[cluster.VertexOffset];
+		const std::uint8_t* triangles = &set.Triangles[cluster.TriangleOffset * 3];
+		for (uint32 i = 0; i < cluster.TriangleCount * 3; ++i)
+			indices.push_back(vertices[triangles[i]]);
+		stats.VisibleTriangles += cluster.TriangleCount;
+	}
+
+	return stats;
+}
+
+MeshClusterBuilder::uint64 MeshClusterBuilder::HashSource(const uint32* indices, size_t indexCount,
+	const float* positions, size_t vertexCount, size_t positionByteStride)
+{
+	// FNV-1a over the indices and the positions.
+	uint64 hash = 14695981039346656037ull;
+	auto hashBytes = [&hash](const void* data, size_t size)
+	{
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		for (size_t i = 0; i < size; ++i)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+	};
+
+	hashBytes(indices, indexCount * sizeof(uint32));
+	for (size_t v = 0; v < vertexCount; ++v)
+		hashBytes(reinterpret_cast<const unsigned char*>(positions) + v * positionByteStride, 3 * sizeof(float));
+
+	return hash;
+}
+
+std::string MeshClusterBuilder::ToString(const std::string& name, const MeshClusterSet& set)
+{
+	size_t coneCount = 0;
+	for (const MeshCluster& cluster : set.Clusters)
+		coneCount += cluster.ConeCutoff < 1.0f ? 1 : 0;
+
+	char buffer[256];
+	snprintf(buffer, sizeof(buffer),
+		"[MeshClusterBuilder] %s: %zu clusters, %.1f vertices and %.1f triangles per cluster, %zu with a normal cone\n",
+		name.c_str(), set.Clusters.size(),
+		set.Clusters.empty() ? 0.0 : (double)set.Vertices.size() / set.Clusters.size(),
+		set.Clusters.empty() ? 0.0 : (double)set.Triangles.size() / 3 / set.Clusters.size(),
+		coneCount);
+
+	return buffer;
+}
\ No newline at end of file
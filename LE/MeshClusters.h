@@ -0,0 +1,109 @@
+#pragma once
+#include <DirectXMath.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// A small piece of a mesh (at most MeshClusterBuilder::MaxVertices vertices
+// and MaxTriangles triangles) with the bounds needed to cull it on its own.
+struct MeshCluster
+{
+	// Range in MeshClusterSet::Vertices.
+	std::uint32_t VertexOffset = 0;
+	std::uint32_t VertexCount = 0;
+	// Range in MeshClusterSet::Triangles, in triangles.
+	std::uint32_t TriangleOffset = 0;
+	std::uint32_t TriangleCount = 0;
+
+	// Bounding sphere and box in object space.
+	DirectX::XMFLOAT3 Center = { 0.0f, 0.0f, 0.0f };
+	float Radius = 0.0f;
+	DirectX::XMFLOAT3 AabbMin = { 0.0f, 0.0f, 0.0f };
+	DirectX::XMFLOAT3 AabbMax = { 0.0f, 0.0f, 0.0f };
+
+	// Normal cone: every triangle faces away from a viewer at eye when
+	// dot(normalize(ConeApex - eye), ConeAxis) >= ConeCutoff.  Clusters whose
+	// normals spread too far get a zero axis and never pass the test.
+	DirectX::XMFLOAT3 ConeApex = { 0.0f, 0.0f, 0.0f };
+	DirectX::XMFLOAT3 ConeAxis = { 0.0f, 0.0f, 0.0f };
+	float ConeCutoff = 1.0f;
+};
+
+// The clusters of one mesh.  Triangles are stored as local 8-bit indices into
+// the vertex range of their cluster, which in turn holds the mesh's vertex
+// numbers (relative to its BaseVertexLocation).
+struct MeshClusterSet
+{
+	std::vector<MeshCluster> Clusters;
+	std::vector<std::uint32_t> Vertices;
+	std::vector<std::uint8_t> Triangles;
+
+	// MeshClusterBuilder::HashSource of the mesh the clusters were built
+	// from, to tell whether a saved set still matches it.
+	std::uint64_t SourceHash = 0;
+};
+
+// Frustum planes (pointing inwards) and eye position, both in the object space
+// of the mesh being culled.
+struct ClusterView
+{
+	DirectX::XMFLOAT4 Planes[6];
+	DirectX::XMFLOAT3 EyePosition;
+
+	///<summary>
+	/// Extracts the planes from a row vector world * view * projection matrix
+	/// (Gribb and Hartmann).  eyePosition has to be in object space as well.
+	///</summary>
+	static ClusterView FromMatrix(const DirectX::XMFLOAT4X4& worldViewProj, const DirectX::XMFLOAT3& eyePosition);
+};
+
+class MeshClusterBuilder
+{
+public:
+	using uint32 = std::uint32_t;
+	using uint64 = std::uint64_t;
+
+	static const size_t MaxVertices = 64;
+	static const size_t MaxTriangles = 124;
+
+	struct CullStats
+	{
+		uint32 Clusters = 0;
+		uint32 FrustumCulled = 0;
+		uint32 BackfaceCulled = 0;
+		uint32 VisibleTriangles = 0;
+	};
+
+	///<summary>
+	/// Splits an indexed triangle list into clusters in index order, so a
+	/// vertex cache optimized list gives compact clusters.  positions points
+	/// at the first vertex position (3 floats) and positionByteStride is the
+	/// vertex stride.
+	///</summary>
+	static MeshClusterSet Build(const uint32* indices, size_t indexCount, const float* positions, size_t vertexCount,
+		size_t positionByteStride, size_t maxVertices = MaxVertices, size_t maxTriangles = MaxTriangles);
+
+	template<typename TVertex>
+	static MeshClusterSet Build(const std::vector<uint32>& indices, const std::vector<TVertex>& vertices)
+	{
+		return Build(indices.data(), indices.size(), &vertices[0].Position.x, vertices.size(), sizeof(TVertex));
+	}
+
+	///<summary>
+	/// Appends the triangles of the clusters that are inside the frustum and
+	/// not facing away from the eye to indices.  The cone test assumes the
+	/// world matrix only scales uniformly.
+	///</summary>
+	static CullStats Cull(const MeshClusterSet& set, const ClusterView& view, std::vector<uint32>& indices);
+
+	static uint64 HashSource(const uint32* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t positionByteStride);
+
+	template<typename TVertex>
+	static uint64 HashSource(const std::vector<uint32>& indices, const std::vector<TVertex>& vertices)
+	{
+		return HashSource(indices.data(), indices.size(), &vertices[0].Position.x, vertices.size(), sizeof(TVertex));
+	}
+
+	static std::string ToString(const std::string& name, const MeshClusterSet& set);
+};
\ No newline at end of file
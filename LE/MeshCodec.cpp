@@ -0,0 +1,738 @@
+#include "MeshCodec.h"
+#include "WorkerPool.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define MESHCODEC_SSE2 1
+#endif
+
+const MeshCodec::uint32 MeshCodec::BlockVertices;
+
+namespace
+{
+	using uint8 = MeshCodec::uint8;
+	using uint32 = MeshCodec::uint32;
+
+	const uint32 GroupSize = 16;
+	const uint32 GroupsPerPlane = MeshCodec::BlockVertices / GroupSize;
+	// 2 bits of group width per group.
+	const uint32 PlaneHeaderSize = GroupsPerPlane / 4;
+	const uint32 GroupWidths[4] = { 0, 2, 4, 8 };
+	const size_t MaxStackStride = 64;
+
+	// Vertex streams: vertex count, stride and block count, then the offset
+	// of every block from the start of the stream.
+	struct VertexStreamHeader
+	{
+		uint32 VertexCount;
+		uint32 VertexByteStride;
+		uint32 BlockCount;
+	};
+
+	struct IndexStreamHeader
+	{
+		uint32 IndexCount;
+		// Bytes of varint data after the per triangle codes.
+		uint32 DataSize;
+	};
+
+	// Index codes: the high nibble is the edge FIFO entry the triangle shares,
+	// NoEdge if none.  With an edge the low nibble tells where the third vertex
+	// comes from: NextVertex, 1 + a vertex FIFO entry, or ExplicitVertex.
+	// Without an edge bit i of the low nibble is set when vertex i is the next
+	// unused one; the others are explicit.
+	const uint32 NoEdge = 15;
+	const uint32 NextVertex = 0;
+	const uint32 ExplicitVertex = 15;
+	const uint32 EdgeFifoSize = 16;
+	const uint32 VertexFifoSize = 16;
+	// FIFO entries a code can refer to.
+	const uint32 MaxEdgeLookup = 15;
+	const uint32 MaxVertexLookup = 14;
+
+	uint8 ZigzagByte(uint8 delta)
+	{
+		return (uint8)((delta << 1) ^ (uint8)((int8_t)delta >> 7));
+	}
+
+#ifndef MESHCODEC_SSE2
+	uint8 UnzigzagByte(uint8 value)
+	{
+		return (uint8)((value >> 1) ^ (uint8)(0 - (value & 1)));
+	}
+#endif
+
+	uint32 Zigzag(int32_t value)
+	{
+		return ((uint32)value << 1) ^ (uint32)(value >> 31);
+	}
+
+	int32_t Unzigzag(uint32 value)
+	{
+		return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+	}
+
+	void WriteVarint(std::vector<uint8>& out, uint32 value)
+	{
+		while (value >= 0x80)
+		{
+			out.push_back((uint8)(value | 0x80));
+			value >>= 7;
+		}
+		out.push_back((uint8)value);
+	}
+
+	bool ReadVarint(const uint8*& data, const uint8* end, uint32& value)
+	{
+		value = 0;
+		for (uint32 shift = 0; shift < 35; shift += 7)
+		{
+			if (data == end)
+				return false;
+			const uint8 byte = *data++;
+			value |= (uint32)(byte & 0x7F) << shift;
+			if ((byte & 0x80) == 0)
+				return true;
+		}
+		return false;
+	}
+
+	template<typename T>
+	void Append(std::vector<uint8>& out, const T& value)
+	{
+		const uint8* bytes = reinterpret_cast<const uint8*>(&value);
+		out.insert(out.end(), bytes, bytes + sizeof(T));
+	}
+
+	// Bit packs the zigzag deltas of one plane of a block.
+	void EncodePlane(std::vector<uint8>& out, const uint8* deltas)
+	{
+		const size_t headerOffset = out.size();
+		out.resize(out.size() + PlaneHeaderSize, 0);
+
+		for (uint32 group = 0; group < GroupsPerPlane; ++group)
+		{
+			const uint8* values = deltas + group * GroupSize;
+			const uint8 largest = *std::max_element(values, values + GroupSize);
+			const uint32 widthCode = largest == 0 ? 0 : largest < 4 ? 1 : largest < 16 ? 2 : 3;
+			out[headerOffset + group / 4] |= (uint8)(widthCode << (group % 4 * 2));
+
+			switch (widthCode)
+			{
+			case 1:
+				for (uint32 i = 0; i < GroupSize; i += 4)
+					out.push_back((uint8)(values[i] | values[i + 1] << 2 | values[i + 2] << 4 | values[i + 3] << 6));
+				break;
+			case 2:
+				for (uint32 i = 0; i < GroupSize; i += 2)
+					out.push_back((uint8)(values[i] | values[i + 1] << 4));
+				break;
+			case 3:
+				out.insert(out.end(), values, values + GroupSize);
+				break;
+			}
+		}
+	}
+
+	// Decodes one plane of a block: unpacks the 256 zigzag deltas and sums
+	// them up into the byte values, one group of 16 at a time.  Returns the
+	// end of the plane's data or nullptr if it runs past end.
+	const uint8* DecodePlane(const uint8* data, const uint8* end, uint8* plane)
+	{
+		if (end - data < (ptrdiff_t)PlaneHeaderSize)
+			return nullptr;
+		const uint8* header = data;
+		data += PlaneHeaderSize;
+
+#ifdef MESHCODEC_SSE2
+		const __m128i one = _mm_set1_epi8(1);
+		const __m128i low4 = _mm_set1_epi8(0x0F);
+		const __m128i low7 = _mm_set1_epi8(0x7F);
+		// Bits 2k..2k+1 of byte k in every 4 bytes.
+		const __m128i pair0 = _mm_set1_epi32(0x00000003);
+		const __m128i pair1 = _mm_set1_epi32(0x00000C00);
+		const __m128i pair2 = _mm_set1_epi32(0x00300000);
+		const __m128i pair3 = _mm_set1_epi32((int)0xC0000000);
+		__m128i carry = _mm_setzero_si128();
+#else
+		uint8 last = 0;
+#endif
+
+		for (uint32 group = 0; group < GroupsPerPlane; ++group)
+		{
+			const uint32 widthCode = (header[group / 4] >> (group % 4 * 2)) & 3;
+			const uint32 size = GroupWidths[widthCode] * GroupSize / 8;
+			if ((size_t)(end - data) < size)
+				return nullptr;
+
+#ifdef MESHCODEC_SSE2
+			__m128i x;
+			switch (widthCode)
+			{
+			case 0:
+				x = _mm_setzero_si128();
+				break;
+			case 1:
+			{
+				// Spread every byte over 4 lanes, then keep and shift down its k-th pair in lane k.
+				int packed;
+				memcpy(&packed, data, 4);
+				x = _mm_cvtsi32_si128(packed);
+				x = _mm_unpacklo_epi8(x, x);
+				x = _mm_unpacklo_epi16(x, x);
+				x = _mm_or_si128(
+					_mm_or_si128(_mm_and_si128(x, pair0), _mm_srli_epi16(_mm_and_si128(x, pair1), 2)),
+					_mm_or_si128(_mm_srli_epi16(_mm_and_si128(x, pair2), 4), _mm_srli_epi16(_mm_and_si128(x, pair3), 6)));
+				break;
+			}
+			case 2:
+			{
+				const __m128i packed = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(data));
+				x = _mm_unpacklo_epi8(_mm_and_si128(packed, low4), _mm_and_si128(_mm_srli_epi16(packed, 4), low4));
+				break;
+			}
+			default:
+				x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+				break;
+			}
+
+			// Unzigzag: (x >> 1) ^ -(x & 1).
+			x = _mm_xor_si128(_mm_and_si128(_mm_srli_epi16(x, 1), low7), _mm_sub_epi8(_mm_setzero_si128(), _mm_and_si128(x, one)));
+
+			// Inclusive prefix sum over the 16 bytes, plus the last value before them.
+			x = _mm_add_epi8(x, _mm_slli_si128(x, 1));
+			x = _mm_add_epi8(x, _mm_slli_si128(x, 2));
+			x = _mm_add_epi8(x, _mm_slli_si128(x, 4));
+			x = _mm_add_epi8(x, _mm_slli_si128(x, 8));
+			x = _mm_add_epi8(x, carry);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(plane + group * GroupSize), x);
+
+			// Broadcast byte 15 for the next group.
+			carry = _mm_srli_si128(x, 15);
+			carry = _mm_unpacklo_epi8(carry, carry);
+			carry = _mm_unpacklo_epi16(carry, carry);
+			carry = _mm_shuffle_epi32(carry, 0);
+#else
+			uint8 values[GroupSize] = {};
+			for (uint32 i = 0; i < GroupSize && widthCode != 0; ++i)
+			{
+				const uint32 width = GroupWidths[widthCode];
+				const uint32 bit = i * width;
+				values[i] = (uint8)((data[bit / 8] >> (bit % 8)) & ((1u << width) - 1));
+			}
+
+			for (uint32 i = 0; i < GroupSize; ++i)
+			{
+				last = (uint8)(last + UnzigzagByte(values[i]));
+				plane[group * GroupSize + i] = last;
+			}
+#endif
+			data += size;
+		}
+
+		return data;
+	}
+
+	// Writes planes[k * BlockVertices + i] to byte k of vertex i.
+	void TransposePlanes(const uint8* planes, uint8* vertices, uint32 vertexCount, size_t stride)
+	{
+		uint32 k = 0;
+#ifdef MESHCODEC_SSE2
+		// 16 planes and 16 vertices at a time: a 16x16 byte transpose in four
+		// rounds of unpacks, after which register v holds 16 bytes of vertex v.
+		for (; k + 16 <= stride; k += 16)
+		{
+			const uint8* p = planes + k * MeshCodec::BlockVertices;
+			for (uint32 i = 0; i < vertexCount; i += GroupSize)
+			{
+				__m128i a[16];
+				__m128i b[16];
+				for (uint32 j = 0; j < 16; ++j)
+					a[j] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + j * MeshCodec::BlockVertices + i));
+
+				for (uint32 j = 0; j < 8; ++j)
+				{
+					b[j] = _mm_unpacklo_epi8(a[2 * j], a[2 * j + 1]);
+					b[j + 8] = _mm_unpackhi_epi8(a[2 * j], a[2 * j + 1]);
+				}
+				for (uint32 h = 0; h < 16; h += 8)
+				{
+					for (uint32 j = 0; j < 4; ++j)
+					{
+						a[h + j] = _mm_unpacklo_epi16(b[h + 2 * j], b[h + 2 * j + 1]);
+						a[h + j + 4] = _mm_unpackhi_epi16(b[h + 2 * j], b[h + 2 * j + 1]);
+					}
+				}
+				for (uint32 q = 0; q < 16; q += 4)
+				{
+					for (uint32 j = 0; j < 2; ++j)
+					{
+						b[q + j] = _mm_unpacklo_epi32(a[q + 2 * j], a[q + 2 * j + 1]);
+						b[q + j + 2] = _mm_unpackhi_epi32(a[q + 2 * j], a[q + 2 * j + 1]);
+					}
+				}
+				for (uint32 j = 0; j < 16; j += 2)
+				{
+					a[j] = _mm_unpacklo_epi64(b[j], b[j + 1]);
+					a[j + 1] = _mm_unpackhi_epi64(b[j], b[j + 1]);
+				}
+
+				const uint32 count = std::min(GroupSize, vertexCount - i);
+				for (uint32 v = 0; v < count; ++v)
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(vertices + (i + v) * stride + k), a[v]);
+			}
+		}
+
+		// Then 4 planes and 16 vertices at a time.
+		for (; k + 4 <= stride; k += 4)
+		{
+			const uint8* p = planes + k * MeshCodec::BlockVertices;
+			for (uint32 i = 0; i < vertexCount; i += GroupSize)
+			{
+				const __m128i p0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+				const __m128i p1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + MeshCodec::BlockVertices + i));
+				const __m128i p2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 2 * MeshCodec::BlockVertices + i));
+				const __m128i p3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 3 * MeshCodec::BlockVertices + i));
+
+				const __m128i low01 = _mm_unpacklo_epi8(p0, p1);
+				const __m128i low23 = _mm_unpacklo_epi8(p2, p3);
+				const __m128i high01 = _mm_unpackhi_epi8(p0, p1);
+				const __m128i high23 = _mm_unpackhi_epi8(p2, p3);
+				__m128i rows[4] =
+				{
+					_mm_unpacklo_epi16(low01, low23),
+					_mm_unpackhi_epi16(low01, low23),
+					_mm_unpacklo_epi16(high01, high23),
+					_mm_unpackhi_epi16(high01, high23),
+				};
+
+				const uint32 count = std::min(GroupSize, vertexCount - i);
+				for (uint32 v = 0; v < count; ++v)
+				{
+					const int word = _mm_cvtsi128_si32(rows[v / 4]);
+					memcpy(vertices + (i + v) * stride + k, &word, 4);
+					rows[v / 4] = _mm_srli_si128(rows[v / 4], 4);
+				}
+			}
+		}
+#endif
+		for (; k < stride; ++k)
+		{
+			const uint8* plane = planes + k * MeshCodec::BlockVertices;
+			for (uint32 i = 0; i < vertexCount; ++i)
+				vertices[i * stride + k] = plane[i];
+		}
+	}
+
+	bool DecodeVertexBlock(uint8* destination, size_t vertexCount, size_t stride, const uint8* data, size_t dataSize, uint32 block)
+	{
+		const VertexStreamHeader* header = reinterpret_cast<const VertexStreamHeader*>(data);
+		const uint32* blockOffsets = reinterpret_cast<const uint32*>(data + sizeof(VertexStreamHeader));
+		const uint8* end = data + dataSize;
+		const uint32 blockEnd = block + 1 < header->BlockCount ? blockOffsets[block + 1] : (uint32)dataSize;
+		if (blockOffsets[block] > blockEnd || blockEnd > dataSize)
+			return false;
+
+		const uint8* blockData = data + blockOffsets[block];
+		end = data + blockEnd;
+
+		// Strides up to MaxStackStride decode on the stack.
+		alignas(16) uint8 stackPlanes[MaxStackStride * MeshCodec::BlockVertices];
+		std::vector<uint8> heapPlanes(stride > MaxStackStride ? stride * MeshCodec::BlockVertices : 0);
+		uint8* planes = stride > MaxStackStride ? heapPlanes.data() : stackPlanes;
+
+		for (size_t k = 0; k < stride; ++k)
+		{
+			uint8* plane = planes + k * MeshCodec::BlockVertices;
+			blockData = DecodePlane(blockData, end, plane);
+			if (blockData == nullptr)
+				return false;
+		}
+
+		const size_t first = (size_t)block * MeshCodec::BlockVertices;
+		const uint32 count = (uint32)std::min<size_t>(MeshCodec::BlockVertices, vertexCount - first);
+		TransposePlanes(planes, destination + first * stride, count, stride);
+		return true;
+	}
+
+	bool CheckVertexStream(size_t vertexCount, size_t stride, const uint8* data, size_t dataSize)
+	{
+		if (data == nullptr || dataSize < sizeof(VertexStreamHeader))
+			return false;
+
+		const VertexStreamHeader* header = reinterpret_cast<const VertexStreamHeader*>(data);
+		const size_t blockCount = (vertexCount + MeshCodec::BlockVertices - 1) / MeshCodec::BlockVertices;
+		return header->VertexCount == vertexCount && header->VertexByteStride == stride && header->BlockCount == blockCount &&
+			dataSize >= sizeof(VertexStreamHeader) + blockCount * sizeof(uint32);
+	}
+
+	template<typename TIndex>
+	std::vector<uint8> EncodeIndexStream(const TIndex* indices, size_t indexCount)
+	{
+		std::vector<uint8> codes;
+		std::vector<uint8> data;
+		codes.reserve(indexCount / 3);
+
+		uint32 edges[EdgeFifoSize][2] = {};
+		uint32 vertices[VertexFifoSize] = {};
+		uint32 edgeOffset = 0;
+		uint32 vertexOffset = 0;
+		uint32 next = 0;
+		uint32 last = 0;
+
+		// Neighbours walk a shared edge the other way round, so the edges go
+		// into the FIFO reversed.
+		auto pushEdge = [&](uint32 a, uint32 b)
+		{
+			edges[edgeOffset][0] = b;
+			edges[edgeOffset][1] = a;
+			edgeOffset = (edgeOffset + 1) % EdgeFifoSize;
+		};
+		auto pushVertex = [&](uint32 v)
+		{
+			vertices[vertexOffset] = v;
+			vertexOffset = (vertexOffset + 1) % VertexFifoSize;
+		};
+		auto writeExplicit = [&](uint32 v)
+		{
+			WriteVarint(data, Zigzag((int32_t)(v - last)));
+			last = v;
+		};
+
+		for (size_t t = 0; t + 2 < indexCount; t += 3)
+		{
+			const uint32 triangle[3] = { indices[t], indices[t + 1], indices[t + 2] };
+
+			uint32 edge = NoEdge;
+			uint32 rotation = 0;
+			for (uint32 e = 0; e < MaxEdgeLookup && edge == NoEdge; ++e)
+			{
+				const uint32* candidate = edges[(edgeOffset + EdgeFifoSize - 1 - e) % EdgeFifoSize];
+				for (uint32 r = 0; r < 3; ++r)
+				{
+					if (triangle[r] == candidate[0] && triangle[(r + 1) % 3] == candidate[1])
+					{
+						edge = e;
+						rotation = r;
+						break;
+					}
+				}
+			}
+
+			if (edge != NoEdge)
+			{
+				const uint32 a = triangle[rotation];
+				const uint32 b = triangle[(rotation + 1) % 3];
+				const uint32 c = triangle[(rotation + 2) % 3];
+
+				uint32 source = ExplicitVertex;
+				if (c == next)
+				{
+					source = NextVertex;
+					next++;
+				}
+				else
+				{
+					for (uint32 i = 0; i < MaxVertexLookup; ++i)
+					{
+						if (vertices[(vertexOffset + VertexFifoSize - 1 - i) % VertexFifoSize] == c)
+						{
+							source = 1 + i;
+							break;
+						}
+					}
+				}
+
+				codes.push_back((uint8)(edge << 4 | source));
+				if (source == ExplicitVertex)
+					writeExplicit(c);
+				if (source == NextVertex || source == ExplicitVertex)
+					pushVertex(c);
+				last = c;
+
+				pushEdge(b, c);
+				pushEdge(c, a);
+			}
+			else
+			{
+				uint32 nextMask = 0;
+				for (uint32 i = 0; i < 3; ++i)
+				{
+					if (triangle[i] == next)
+					{
+						nextMask |= 1u << i;
+						next++;
+					}
+					else
+					{
+						writeExplicit(triangle[i]);
+					}
+					pushVertex(triangle[i]);
+					last = triangle[i];
+				}
+
+				codes.push_back((uint8)(NoEdge << 4 | nextMask));
+				pushEdge(triangle[0], triangle[1]);
+				pushEdge(triangle[1], triangle[2]);
+				pushEdge(triangle[2], triangle[0]);
+			}
+		}
+
+		std::vector<uint8> out;
+		IndexStreamHeader header = { (uint32)indexCount, (uint32)data.size() };
+		Append(out, header);
+		out.insert(out.end(), codes.begin(), codes.end());
+		out.insert(out.end(), data.begin(), data.end());
+		return out;
+	}
+
+	template<typename TIndex>
+	bool DecodeIndexStream(TIndex* destination, size_t indexCount, const uint8* stream, size_t streamSize)
+	{
+		if (stream == nullptr || streamSize < sizeof(IndexStreamHeader) || indexCount % 3 != 0)
+			return false;
+
+		IndexStreamHeader header;
+		memcpy(&header, stream, sizeof(header));
+		const size_t triangleCount = indexCount / 3;
+		if (header.IndexCount != indexCount || streamSize - sizeof(header) < triangleCount + header.DataSize)
+			return false;
+
+		const uint8* codes = stream + sizeof(header);
+		const uint8* data = codes + triangleCount;
+		const uint8* end = data + header.DataSize;
+
+		uint32 edges[EdgeFifoSize][2] = {};
+		uint32 vertices[VertexFifoSize] = {};
+		uint32 edgeOffset = 0;
+		uint32 vertexOffset = 0;
+		uint32 next = 0;
+		uint32 last = 0;
+
+		for (size_t t = 0; t < triangleCount; ++t)
+		{
+			const uint32 edge = codes[t] >> 4;
+			const uint32 source = codes[t] & 15;
+			uint32 triangle[3];
+
+			if (edge != NoEdge)
+			{
+				const uint32* shared = edges[(edgeOffset + EdgeFifoSize - 1 - edge) % EdgeFifoSize];
+				triangle[0] = shared[0];
+				triangle[1] = shared[1];
+
+				uint32 c;
+				if (source == NextVertex)
+				{
+					c = next++;
+				}
+				else if (source == ExplicitVertex)
+				{
+					uint32 value;
+					if (!ReadVarint(data, end, value))
+						return false;
+					c = last + (uint32)Unzigzag(value);
+				}
+				else
+				{
+					c = vertices[(vertexOffset + VertexFifoSize - source) % VertexFifoSize];
+				}
+
+				if (source == NextVertex || source == ExplicitVertex)
+				{
+					vertices[vertexOffset] = c;
+					vertexOffset = (vertexOffset + 1) % VertexFifoSize;
+				}
+				last = c;
+				triangle[2] = c;
+
+				edges[edgeOffset][0] = c;
+				edges[edgeOffset][1] = triangle[1];
+				edges[(edgeOffset + 1) % EdgeFifoSize][0] = triangle[0];
+				edges[(edgeOffset + 1) % EdgeFifoSize][1] = c;
+				edgeOffset = (edgeOffset + 2) % EdgeFifoSize;
+			}
+			else
+			{
+				for (uint32 i = 0; i < 3; ++i)
+				{
+					if (source & (1u << i))
+					{
+						triangle[i] = next++;
+					}
+					else
+					{
+						uint32 value;
+						if (!ReadVarint(data, end, value))
+							return false;
+						triangle[i] = last + (uint32)Unzigzag(value);
+					}
+					vertices[vertexOffset] = triangle[i];
+					vertexOffset = (vertexOffset + 1) % VertexFifoSize;
+					last = triangle[i];
+				}
+
+				for (uint32 i = 0; i < 3; ++i)
+				{
+					edges[edgeOffset][0] = triangle[(i + 1) % 3];
+					edges[edgeOffset][1] = triangle[i];
+					edgeOffset = (edgeOffset + 1) % EdgeFifoSize;
+				}
+			}
+
+			destination[t * 3] = (TIndex)triangle[0];
+			destination[t * 3 + 1] = (TIndex)triangle[1];
+			destination[t * 3 + 2] = (TIndex)triangle[2];
+		}
+
+		return data == end;
+	}
+}
+
+std::vector<MeshCodec::uint8> MeshCodec::EncodeVertices(const void* vertices, size_t vertexCount, size_t vertexByteStride)
+{
+	const uint8* source = static_cast<const uint8*>(vertices);
+	const uint32 blockCount = (uint32)((vertexCount + BlockVertices - 1) / BlockVertices);
+
+	std::vector<uint8> out;
+	VertexStreamHeader header = { (uint32)vertexCount, (uint32)vertexByteStride, blockCount };
+	Append(out, header);
+	const size_t offsetTable = out.size();
+	out.resize(out.size() + blockCount * sizeof(uint32));
+
+	// Blocks start from zero, so each one decodes on its own.  The tail of
+	// the last block is padded with zero deltas.
+	std::vector<uint8> deltas(BlockVertices);
+	for (uint32 block = 0; block < blockCount; ++block)
+	{
+		const uint32 blockOffset = (uint32)out.size();
+		memcpy(&out[offsetTable + block * sizeof(uint32)], &blockOffset, sizeof(uint32));
+
+		const size_t first = (size_t)block * BlockVertices;
+		const size_t count = std::min<size_t>(BlockVertices, vertexCount - first);
+		for (size_t k = 0; k < vertexByteStride; ++k)
+		{
+			uint8 previous = 0;
+			for (size_t i = 0; i < BlockVertices; ++i)
+			{
+				if (i < count)
+				{
+					const uint8 value = source[(first + i) * vertexByteStride + k];
+					deltas[i] = ZigzagByte((uint8)(value - previous));
+					previous = value;
+				}
+				else
+				{
+					deltas[i] = 0;
+				}
+			}
+			EncodePlane(out, deltas.data());
+		}
+	}
+
+	return out;
+}
+
+bool MeshCodec::DecodeVertices(void* destination, size_t vertexCount, size_t vertexByteStride, const uint8* data, size_t dataSize)
+{
+	if (!CheckVertexStream(vertexCount, vertexByteStride, data, dataSize))
+		return false;
+
+	const uint32 blockCount = reinterpret_cast<const VertexStreamHeader*>(data)->BlockCount;
+	for (uint32 block = 0; block < blockCount; ++block)
+	{
+		if (!DecodeVertexBlock(static_cast<uint8*>(destination), vertexCount, vertexByteStride, data, dataSize, block))
+			return false;
+	}
+	return true;
+}
+
+std::vector<MeshCodec::uint8> MeshCodec::EncodeIndices(const uint32* indices, size_t indexCount)
+{
+	return EncodeIndexStream(indices, indexCount);
+}
+
+std::vector<MeshCodec::uint8> MeshCodec::EncodeIndices(const uint16* indices, size_t indexCount)
+{
+	return EncodeIndexStream(indices, indexCount);
+}
+
+bool MeshCodec::DecodeIndices(uint32* destination, size_t indexCount, const uint8* data, size_t dataSize)
+{
+	return DecodeIndexStream(destination, indexCount, data, dataSize);
+}
+
+bool MeshCodec::DecodeIndices(uint16* destination, size_t indexCount, const uint8* data, size_t dataSize)
+{
+	return DecodeIndexStream(destination, indexCount, data, dataSize);
+}
+
+bool MeshCodec::DecodeParallel(const std::vector<DecodeJob>& jobs, uint32 threadCount)
+{
+	// One work item per vertex block and per index stream.
+	struct WorkItem
+	{
+		const DecodeJob* Job;
+		uint32 Block;
+	};
+
+	std::vector<WorkItem> items;
+	for (const DecodeJob& job : jobs)
+	{
+		if (job.Type != DecodeJob::Kind::Vertices)
+		{
+			items.push_back({ &job, 0 });
+			continue;
+		}
+
+		if (!CheckVertexStream(job.Count, job.VertexByteStride, job.Data, job.DataSize))
+			return false;
+		const uint32 blockCount = reinterpret_cast<const VertexStreamHeader*>(job.Data)->BlockCount;
+		for (uint32 block = 0; block < blockCount; ++block)
+			items.push_back({ &job, block });
+	}
+
+	if (threadCount == 0)
+		threadCount = std::thread::hardware_concurrency();
+	threadCount = std::max(1u, std::min(threadCount, (uint32)items.size()));
+
+	std::atomic<bool> succeeded(true);
+	WorkerPool::ParallelFor((uint32)items.size(), threadCount, [&](uint32 i)
+	{
+		const DecodeJob& job = *items[i].Job;
+		bool result = false;
+		switch (job.Type)
+		{
+		case DecodeJob::Kind::Vertices:
+			result = DecodeVertexBlock(static_cast<uint8*>(job.Destination), job.Count, job.VertexByteStride, job.Data, job.DataSize, items[i].Block);
+			break;
+		case DecodeJob::Kind::Indices16:
+			result = DecodeIndices(static_cast<uint16*>(job.Destination), job.Count, job.Data, job.DataSize);
+			break;
+		case DecodeJob::Kind::Indices32:
+			result = DecodeIndices(static_cast<uint32*>(job.Destination), job.Count, job.Data, job.DataSize);
+			break;
+		}
+		if (!result)
+			succeeded = false;
+	});
+
+	return succeeded;
+}
+
+std::string MeshCodec::ToString(const std::string& name, size_t rawByteSize, size_t encodedByteSize, double milliseconds)
+{
+	char buffer[256];
+	snprintf(buffer, sizeof(buffer),
+		"[MeshCodec] %s: %zu bytes encoded to %zu (%.1f%%), decoded in %.2f ms (%.2f GB/s)\n",
+		name.c_str(), rawByteSize, encodedByteSize,
+		rawByteSize == 0 ? 0.0 : 100.0 * encodedByteSize / rawByteSize, milliseconds,
+		milliseconds <= 0.0 ? 0.0 : rawByteSize / (milliseconds * 1.0e6));
+
+	return buffer;
+}
\ No newline at end of file
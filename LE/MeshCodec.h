@@ -0,0 +1,75 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Lossless compression of vertex and index streams.
+//
+// Vertices are cut into blocks of BlockVertices.  Inside a block every byte
+// of the vertex is delta coded against the same byte of the previous vertex,
+// the deltas are zigzag coded and stored byte plane by byte plane, each plane
+// bit packed in groups of 16 at 0, 2, 4 or 8 bits.  Blocks do not depend on
+// each other, so they decode in parallel, and the decoder unpacks, sums and
+// transposes 16 bytes at a time with SSE2.
+//
+// Triangles are coded one byte each against a FIFO of recently seen edges:
+// most triangles share an edge with one of the last few and only need their
+// third vertex, which is usually the next unused vertex or in a FIFO of
+// recent vertices.  The rest is stored as zigzag varint deltas.  Triangles
+// may come back rotated (same winding).  Vertex streams in first use order,
+// as MeshOptimizer::OptimizeVertexFetch leaves them, compress best.
+class MeshCodec
+{
+public:
+	using uint8 = std::uint8_t;
+	using uint16 = std::uint16_t;
+	using uint32 = std::uint32_t;
+
+	static const uint32 BlockVertices = 256;
+
+	static std::vector<uint8> EncodeVertices(const void* vertices, size_t vertexCount, size_t vertexByteStride);
+
+	///<summary>
+	/// Decodes into destination, which has room for vertexCount vertices of
+	/// vertexByteStride.  Returns false if data does not hold such a stream.
+	///</summary>
+	static bool DecodeVertices(void* destination, size_t vertexCount, size_t vertexByteStride, const uint8* data, size_t dataSize);
+
+	///<summary>
+	/// indexCount has to be a multiple of 3 (triangle lists only).
+	///</summary>
+	static std::vector<uint8> EncodeIndices(const uint32* indices, size_t indexCount);
+	static std::vector<uint8> EncodeIndices(const uint16* indices, size_t indexCount);
+
+	static bool DecodeIndices(uint32* destination, size_t indexCount, const uint8* data, size_t dataSize);
+	static bool DecodeIndices(uint16* destination, size_t indexCount, const uint8* data, size_t dataSize);
+
+	// One stream to decode with DecodeParallel.
+	struct DecodeJob
+	{
+		enum class Kind
+		{
+			Vertices,
+			Indices16,
+			Indices32,
+		};
+
+		Kind Type = Kind::Vertices;
+		void* Destination = nullptr;
+		// Vertices or indices.
+		size_t Count = 0;
+		size_t VertexByteStride = 0;
+		const uint8* Data = nullptr;
+		size_t DataSize = 0;
+	};
+
+	///<summary>
+	/// Decodes several streams, of one or many meshes, on threadCount threads
+	/// (0 for one per hardware thread).  Vertex streams are split by block.
+	/// Returns false if any of them failed.
+	///</summary>
+	static bool DecodeParallel(const std::vector<DecodeJob>& jobs, uint32 threadCount = 0);
+
+	static std::string ToString(const std::string& name, size_t rawByteSize, size_t encodedByteSize, double milliseconds);
+};
\ No newline at end of file
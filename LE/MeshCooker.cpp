@@ -0,0 +1,638 @@
+#include "MeshCooker.h"
+#include "GeometryArena.h"
+#include <cstdio>
+
+using namespace DirectX;
+
+namespace
+{
+	using uint32 = MeshCooker::uint32;
+	using uint64 = MeshCooker::uint64;
+
+	const uint32 FileMagic = 0x534D454C; // "LEMS"
+	const uint32 FileVersion = 3;
+
+	enum StreamEncoding : uint32
+	{
+		EncodingRaw,
+		EncodingMeshCodec,
+	};
+
+	// Every section starts 16 byte aligned, so the mapped streams can be
+	// read with aligned vector loads.
+	const uint64 SectionAlignment = 16;
+
+	struct FileString
+	{
+		uint32 Offset;
+		uint32 Length;
+	};
+
+	struct FileHeader
+	{
+		uint32 Magic;
+		uint32 Version;
+		uint64 SourceStamp;
+		uint64 FileSize;
+		uint32 SubmeshByteSize;
+		uint32 ClusterByteSize;
+
+		uint32 VertexByteStride;
+		uint32 IndexFormat;
+		uint64 VertexOffset;
+		uint64 IndexOffset;
+		// Decoded sizes, and the sizes as stored.
+		uint32 VertexByteSize;
+		uint32 IndexByteSize;
+		uint32 StoredVertexByteSize;
+		uint32 StoredIndexByteSize;
+		uint32 Encoding;
+		uint32 Padding;
+
+		uint64 SubmeshOffset;
+		uint64 MaterialOffset;
+		uint64 ClusterSetOffset;
+		uint64 StringOffset;
+		uint32 SubmeshCount;
+		uint32 MaterialCount;
+		uint32 ClusterSetCount;
+		uint32 StringByteSize;
+
+		BoundingBox Bounds;
+		BoundingSphere SphereBounds;
+		BoundingOrientedBox OrientedBounds;
+	};
+
+	struct FileSubmesh
+	{
+		FileString Name;
+		uint32 IndexCount;
+		uint32 StartIndexLocation;
+		std::int32_t BaseVertexLocation;
+		uint32 MaterialIndex;
+		float LodError;
+		BoundingBox Bounds;
+		BoundingSphere SphereBounds;
+		BoundingOrientedBox OrientedBounds;
+	};
+
+	struct FileMaterial
+	{
+		FileString Name;
+		FileString DiffuseTexture;
+	};
+
+	struct FileClusterSet
+	{
+		FileString Name;
+		uint64 SourceHash;
+		uint64 ClusterOffset;
+		uint64 VertexOffset;
+		uint64 TriangleOffset;
+		uint32 ClusterCount;
+		uint32 VertexCount;
+		uint32 TriangleByteSize;
+	};
+
+	// Lays the file out in memory, one aligned section after the other,
+	// behind room for the header.
+	class FileImage
+	{
+	public:
+		FileImage()
+			: mBytes(sizeof(FileHeader), 0)
+		{
+		}
+
+		uint64 Append(const void* data, size_t byteSize)
+		{
+			mBytes.resize((mBytes.size() + SectionAlignment - 1) / SectionAlignment * SectionAlignment, 0);
+			const uint64 offset = mBytes.size();
+			const unsigned char* bytes = static_cast<const unsigned char*>(data);
+			mBytes.insert(mBytes.end(), bytes, bytes + byteSize);
+			return offset;
+		}
+
+		template<typename T>
+		uint64 Append(const std::vector<T>& items)
+		{
+			return Append(items.data(), items.size() * sizeof(T));
+		}
+
+		FileString AddString(const std::string& text)
+		{
+			FileString result = { (uint32)mStrings.size(), (uint32)text.size() };
+			mStrings += text;
+			return result;
+		}
+
+		const std::string& GetStrings() const
+		{
+			return mStrings;
+		}
+
+		std::vector<unsigned char>& GetBytes()
+		{
+			return mBytes;
+		}
+
+	private:
+		std::vector<unsigned char> mBytes;
+		std::string mStrings;
+	};
+
+	bool Fits(uint64 offset, uint64 byteSize, size_t fileSize)
+	{
+		return offset <= fileSize && byteSize <= fileSize - offset;
+	}
+
+	const FileHeader& Header(const unsigned char* view)
+	{
+		return *reinterpret_cast<const FileHeader*>(view);
+	}
+
+	template<typename TIndex>
+	bool IndicesInRange(const TIndex* indices, const SubmeshGeometry& submesh, uint64 vertexCount)
+	{
+		for (UINT i = 0; i < submesh.IndexCount; ++i)
+		{
+			if (submesh.BaseVertexLocation + (uint64)indices[submesh.StartIndexLocation + i] >= vertexCount)
+				return false;
+		}
+		return true;
+	}
+
+	// A flipped bit can still decode, so check that no submesh reads past
+	// the vertices or indices.
+	bool SubmeshesInRange(const CookedMeshFile& file, const void* indices)
+	{
+		const uint64 vertexCount = file.GetVertexByteSize() / file.GetVertexByteStride();
+		const bool wide = file.GetIndexFormat() == DXGI_FORMAT_R32_UINT;
+		const uint64 indexCount = file.GetIndexByteSize() / (wide ? 4 : 2);
+		for (uint32 i = 0; i < file.GetSubmeshCount(); ++i)
+		{
+			const SubmeshGeometry submesh = file.GetSubmesh(i);
+			if (submesh.BaseVertexLocation < 0 || (uint64)submesh.StartIndexLocation + submesh.IndexCount > indexCount)
+				return false;
+
+			const bool inRange = wide ?
+				IndicesInRange(static_cast<const std::uint32_t*>(indices), submesh, vertexCount) :
+				IndicesInRange(static_cast<const std::uint16_t*>(indices), submesh, vertexCount);
+			if (!inRange)
+				return false;
+		}
+		return true;
+	}
+}
+
+CookedMeshFile::~CookedMeshFile()
+{
+	Close();
+}
+
+bool CookedMeshFile::Open(const std::string& filename)
+{
+	Close();
+
+	if (!mMapped.Open(filename) || mMapped.GetSize() < sizeof(FileHeader))
+	{
+		Close();
+		return false;
+	}
+	mView = mMapped.GetData();
+	mSize = mMapped.GetSize();
+
+	// Only the header and the tables are touched here, the streams are left
+	// for the upload to page in.
+	const FileHeader& header = Header(mView);
+	bool valid = header.Magic == FileMagic && header.Version == FileVersion && header.FileSize == mSize &&
+		header.SubmeshByteSize == sizeof(FileSubmesh) && header.ClusterByteSize == sizeof(MeshCluster) &&
+		header.VertexByteStride > 0 && header.VertexByteSize % header.VertexByteStride == 0 &&
+		(header.IndexFormat == DXGI_FORMAT_R16_UINT || header.IndexFormat == DXGI_FORMAT_R32_UINT) &&
+		(header.Encoding == EncodingRaw || header.Encoding == EncodingMeshCodec) &&
+		(header.Encoding != EncodingRaw || (header.StoredVertexByteSize == header.VertexByteSize && header.StoredIndexByteSize == header.IndexByteSize)) &&
+		Fits(header.VertexOffset, header.StoredVertexByteSize, mSize) &&
+		Fits(header.IndexOffset, header.StoredIndexByteSize, mSize) &&
+		Fits(header.SubmeshOffset, (uint64)header.SubmeshCount * sizeof(FileSubmesh), mSize) &&
+		Fits(header.MaterialOffset, (uint64)header.MaterialCount * sizeof(FileMaterial), mSize) &&
+		Fits(header.ClusterSetOffset, (uint64)header.ClusterSetCount * sizeof(FileClusterSet), mSize) &&
+		Fits(header.StringOffset, header.StringByteSize, mSize);
+
+	for (uint32 i = 0; valid && i < header.ClusterSetCount; ++i)
+	{
+		const FileClusterSet& set = At<FileClusterSet>(header.ClusterSetOffset)[i];
+		valid = Fits(set.ClusterOffset, (uint64)set.ClusterCount * sizeof(MeshCluster), mSize) &&
+			Fits(set.VertexOffset, (uint64)set.VertexCount * sizeof(uint32), mSize) &&
+			Fits(set.TriangleOffset, set.TriangleByteSize, mSize);
+	}
+
+	if (!valid)
+		Close();
+	return valid;
+}
+
+void CookedMeshFile::Close()
+{
+	mMapped.Close();
+	mView = nullptr;
+	mSize = 0;
+}
+
+CookedMeshFile::uint64 CookedMeshFile::GetSourceStamp() const
+{
+	return Header(mView).SourceStamp;
+}
+
+UINT CookedMeshFile::GetVertexByteStride() const
+{
+	return Header(mView).VertexByteStride;
+}
+
+DXGI_FORMAT CookedMeshFile::GetIndexFormat() const
+{
+	return (DXGI_FORMAT)Header(mView).IndexFormat;
+}
+
+const void* CookedMeshFile::GetVertices() const
+{
+	return At<void>(Header(mView).VertexOffset);
+}
+
+UINT CookedMeshFile::GetVertexByteSize() const
+{
+	return Header(mView).VertexByteSize;
+}
+
+const void* CookedMeshFile::GetIndices() const
+{
+	return At<void>(Header(mView).IndexOffset);
+}
+
+UINT CookedMeshFile::GetIndexByteSize() const
+{
+	return Header(mView).IndexByteSize;
+}
+
+bool CookedMeshFile::IsCompressed() const
+{
+	return Header(mView).Encoding == EncodingMeshCodec;
+}
+
+size_t CookedMeshFile::GetStoredByteSize() const
+{
+	return (size_t)Header(mView).StoredVertexByteSize + Header(mView).StoredIndexByteSize;
+}
+
+void CookedMeshFile::AddDecodeJobs(void* vertices, void* indices, std::vector<MeshCodec::DecodeJob>& jobs) const
+{
+	const FileHeader& header = Header(mView);
+	const bool wide = header.IndexFormat == DXGI_FORMAT_R32_UINT;
+
+	MeshCodec::DecodeJob vertexJob;
+	vertexJob.Type = MeshCodec::DecodeJob::Kind::Vertices;
+	vertexJob.Destination = vertices;
+	vertexJob.Count = header.VertexByteSize / header.VertexByteStride;
+	vertexJob.VertexByteStride = header.VertexByteStride;
+	vertexJob.Data = At<MeshCodec::uint8>(header.VertexOffset);
+	vertexJob.DataSize = header.StoredVertexByteSize;
+	jobs.push_back(vertexJob);
+
+	MeshCodec::DecodeJob indexJob;
+	indexJob.Type = wide ? MeshCodec::DecodeJob::Kind::Indices32 : MeshCodec::DecodeJob::Kind::Indices16;
+	indexJob.Destination = indices;
+	indexJob.Count = header.IndexByteSize / (wide ? 4 : 2);
+	indexJob.Data = At<MeshCodec::uint8>(header.IndexOffset);
+	indexJob.DataSize = header.StoredIndexByteSize;
+	jobs.push_back(indexJob);
+}
+
+CookedMeshFile::uint32 CookedMeshFile::GetSubmeshCount() const
+{
+	return Header(mView).SubmeshCount;
+}
+
+std::string CookedMeshFile::GetSubmeshName(uint32 i) const
+{
+	const FileSubmesh& submesh = At<FileSubmesh>(Header(mView).SubmeshOffset)[i];
+	return String(submesh.Name.Offset, submesh.Name.Length);
+}
+
+SubmeshGeometry CookedMeshFile::GetSubmesh(uint32 i) const
+{
+	const FileSubmesh& source = At<FileSubmesh>(Header(mView).SubmeshOffset)[i];
+
+	SubmeshGeometry submesh;
+	submesh.IndexCount = source.IndexCount;
+	submesh.StartIndexLocation = source.StartIndexLocation;
+	submesh.BaseVertexLocation = source.BaseVertexLocation;
+	submesh.Bounds = source.Bounds;
+	submesh.SphereBounds = source.SphereBounds;
+	submesh.OrientedBounds = source.OrientedBounds;
+	submesh.LodError = source.LodError;
+	return submesh;
+}
+
+CookedMeshFile::uint32 CookedMeshFile::GetSubmeshMaterial(uint32 i) const
+{
+	return At<FileSubmesh>(Header(mView).SubmeshOffset)[i].MaterialIndex;
+}
+
+CookedMeshFile::uint32 CookedMeshFile::GetMaterialCount() const
+{
+	return Header(mView).MaterialCount;
+}
+
+CookedMaterial CookedMeshFile::GetMaterial(uint32 i) const
+{
+	const FileMaterial& source = At<FileMaterial>(Header(mView).MaterialOffset)[i];
+
+	CookedMaterial material;
+	material.Name = String(source.Name.Offset, source.Name.Length);
+	material.DiffuseTexture = String(source.DiffuseTexture.Offset, source.DiffuseTexture.Length);
+	return material;
+}
+
+CookedMeshFile::uint32 CookedMeshFile::GetClusterSetCount() const
+{
+	return Header(mView).ClusterSetCount;
+}
+
+std::string CookedMeshFile::GetClusterSetName(uint32 i) const
+{
+	const FileClusterSet& set = At<FileClusterSet>(Header(mView).ClusterSetOffset)[i];
+	return String(set.Name.Offset, set.Name.Length);
+}
+
+MeshClusterSet CookedMeshFile::GetClusterSet(uint32 i) const
+{
+	// The clusters are only read on the CPU, so they are copied out.
+	const FileClusterSet& source = At<FileClusterSet>(Header(mView).ClusterSetOffset)[i];
+
+	MeshClusterSet set;
+	const MeshCluster* clusters = At<MeshCluster>(source.ClusterOffset);
+	const uint32* vertices = At<uint32>(source.VertexOffset);
+	const std::uint8_t* triangles = At<std::uint8_t>(source.TriangleOffset);
+	set.Clusters.assign(clusters, clusters + source.ClusterCount);
+	set.Vertices.assign(vertices, vertices + source.VertexCount);
+	set.Triangles.assign(triangles, triangles + source.TriangleByteSize);
+	set.SourceHash = source.SourceHash;
+	return set;
+}
+
+BoundingBox CookedMeshFile::GetBounds() const
+{
+	return Header(mView).Bounds;
+}
+
+BoundingSphere CookedMeshFile::GetSphereBounds() const
+{
+	return Header(mView).SphereBounds;
+}
+
+BoundingOrientedBox CookedMeshFile::GetOrientedBounds() const
+{
+	return Header(mView).OrientedBounds;
+}
+
+std::string CookedMeshFile::String(uint32 offset, uint32 length) const
+{
+	const FileHeader& header = Header(mView);
+	if ((uint64)offset + length > header.StringByteSize)
+		return std::string();
+	return std::string(At<char>(header.StringOffset + offset), length);
+}
+
+MeshCooker::uint64 MeshCooker::SourceStamp(const std::string& sourceFile, uint64 importSettings)
+{
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	if (!::GetFileAttributesExA(sourceFile.c_str(), GetFileExInfoStandard, &attributes))
+		return 0;
+
+	const uint64 values[] =
+	{
+		((uint64)attributes.nFileSizeHigh << 32) | attributes.nFileSizeLow,
+		((uint64)attributes.ftLastWriteTime.dwHighDateTime << 32) | attributes.ftLastWriteTime.dwLowDateTime,
+		importSettings,
+		FileVersion,
+	};
+
+	// FNV-1a, like MeshClusterBuilder::HashSource.
+	uint64 hash = 14695981039346656037ull;
+	const unsigned char* bytes = reinterpret_cast<const unsigned char*>(values);
+	for (size_t i = 0; i < sizeof(values); ++i)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+
+	// 0 is reserved for a missing source.
+	return hash != 0 ? hash : 1;
+}
+
+bool MeshCooker::Save(const std::string& filename, const MeshGeometry& geo, const std::vector<CookedMaterial>& materials,
+	const std::unordered_map<std::string, uint32>& submeshMaterials, uint64 sourceStamp, bool compress)
+{
+	if (geo.VertexBufferCPU == nullptr || geo.IndexBufferCPU == nullptr)
+		return false;
+
+	// Undo GeometryArena's rebasing, the DrawArgs are stored relative to the
+	// geometry's own streams.
+	const UINT indexSize = geo.IndexFormat == DXGI_FORMAT_R32_UINT ? 4 : 2;
+	const INT firstVertex = geo.Arena != nullptr ? (INT)geo.ArenaFirstVertex : 0;
+	const UINT firstIndex = geo.Arena != nullptr ? (UINT)(geo.ArenaIndexByteOffset / indexSize) : 0;
+
+	FileImage image;
+
+	FileHeader header = {};
+	header.Magic = FileMagic;
+	header.Version = FileVersion;
+	header.SourceStamp = sourceStamp;
+	header.SubmeshByteSize = sizeof(FileSubmesh);
+	header.ClusterByteSize = sizeof(MeshCluster);
+	header.VertexByteStride = geo.VertexByteStride;
+	header.IndexFormat = (uint32)geo.IndexFormat;
+	header.VertexByteSize = (uint32)geo.VertexBufferCPU->GetBufferSize();
+	header.IndexByteSize = (uint32)geo.IndexBufferCPU->GetBufferSize();
+	if (compress)
+	{
+		const std::vector<MeshCodec::uint8> vertices = MeshCodec::EncodeVertices(geo.VertexBufferCPU->GetBufferPointer(),
+			header.VertexByteSize / header.VertexByteStride, header.VertexByteStride);
+		const std::vector<MeshCodec::uint8> indices = indexSize == 4 ?
+			MeshCodec::EncodeIndices(static_cast<const MeshCodec::uint32*>(geo.IndexBufferCPU->GetBufferPointer()), header.IndexByteSize / 4) :
+			MeshCodec::EncodeIndices(static_cast<const MeshCodec::uint16*>(geo.IndexBufferCPU->GetBufferPointer()), header.IndexByteSize / 2);
+
+		header.Encoding = EncodingMeshCodec;
+		header.StoredVertexByteSize = (uint32)vertices.size();
+		header.StoredIndexByteSize = (uint32)indices.size();
+		header.VertexOffset = image.Append(vertices);
+		header.IndexOffset = image.Append(indices);
+	}
+	else
+	{
+		header.Encoding = EncodingRaw;
+		header.StoredVertexByteSize = header.VertexByteSize;
+		header.StoredIndexByteSize = header.IndexByteSize;
+		header.VertexOffset = image.Append(geo.VertexBufferCPU->GetBufferPointer(), header.VertexByteSize);
+		header.IndexOffset = image.Append(geo.IndexBufferCPU->GetBufferPointer(), header.IndexByteSize);
+	}
+	header.Bounds = geo.Bounds;
+	header.SphereBounds = geo.SphereBounds;
+	header.OrientedBounds = geo.OrientedBounds;
+
+	std::vector<FileSubmesh> submeshes;
+	for (const auto& drawArg : geo.DrawArgs)
+	{
+		const SubmeshGeometry& source = drawArg.second;
+		auto material = submeshMaterials.find(drawArg.first);
+
+		FileSubmesh submesh = {};
+		submesh.Name = image.AddString(drawArg.first);
+		submesh.IndexCount = source.IndexCount;
+		submesh.StartIndexLocation = source.StartIndexLocation - firstIndex;
+		submesh.BaseVertexLocation = source.BaseVertexLocation - firstVertex;
+		submesh.MaterialIndex = material != submeshMaterials.end() ? material->second : 0;
+		submesh.LodError = source.LodError;
+		submesh.Bounds = source.Bounds;
+		submesh.SphereBounds = source.SphereBounds;
+		submesh.OrientedBounds = source.OrientedBounds;
+		submeshes.push_back(submesh);
+	}
+	header.SubmeshCount = (uint32)submeshes.size();
+	header.SubmeshOffset = image.Append(submeshes);
+
+	std::vector<FileMaterial> fileMaterials;
+	for (const CookedMaterial& material : materials)
+	{
+		FileMaterial fileMaterial = {};
+		fileMaterial.Name = image.AddString(material.Name);
+		fileMaterial.DiffuseTexture = image.AddString(material.DiffuseTexture);
+		fileMaterials.push_back(fileMaterial);
+	}
+	header.MaterialCount = (uint32)fileMaterials.size();
+	header.MaterialOffset = image.Append(fileMaterials);
+
+	std::vector<FileClusterSet> clusterSets;
+	for (const auto& clusters : geo.Clusters)
+	{
+		const MeshClusterSet& source = clusters.second;
+
+		FileClusterSet set = {};
+		set.Name = image.AddString(clusters.first);
+		set.SourceHash = source.SourceHash;
+		set.ClusterCount = (uint32)source.Clusters.size();
+		set.VertexCount = (uint32)source.Vertices.size();
+		set.TriangleByteSize = (uint32)source.Triangles.size();
+		set.ClusterOffset = image.Append(source.Clusters);
+		set.VertexOffset = image.Append(source.Vertices);
+		set.TriangleOffset = image.Append(source.Triangles);
+		clusterSets.push_back(set);
+	}
+	header.ClusterSetCount = (uint32)clusterSets.size();
+	header.ClusterSetOffset = image.Append(clusterSets);
+
+	header.StringByteSize = (uint32)image.GetStrings().size();
+	header.StringOffset = image.Append(image.GetStrings().data(), image.GetStrings().size());
+
+	std::vector<unsigned char>& bytes = image.GetBytes();
+	header.FileSize = bytes.size();
+	memcpy(bytes.data(), &header, sizeof(header));
+
+	std::ofstream fout(filename, std::ios::binary);
+	if (!fout)
+		return false;
+
+	fout.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+	return fout.good();
+}
+
+std::unique_ptr<CookedMeshFile> MeshCooker::Open(const std::string& filename, uint64 sourceStamp)
+{
+	auto file = std::make_unique<CookedMeshFile>();
+	if (!file->Open(filename))
+		return nullptr;
+
+	if (sourceStamp != 0 && file->GetSourceStamp() != sourceStamp)
+	{
+		std::string message = "[MeshCooker] " + filename + " is out of date.\n";
+		::OutputDebugStringA(message.c_str());
+		return nullptr;
+	}
+
+	return file;
+}
+
+std::unique_ptr<MeshGeometry> MeshCooker::Build(const std::string& name, const CookedMeshFile& file,
+	GeometryArena& arena, ID3D12Device* device, ID3D12GraphicsCommandList* cmdList)
+{
+	auto geo = std::make_unique<MeshGeometry>();
+	geo->Name = name;
+	geo->VertexByteStride = file.GetVertexByteStride();
+	geo->VertexBufferByteSize = file.GetVertexByteSize();
+	geo->IndexFormat = file.GetIndexFormat();
+	geo->IndexBufferByteSize = file.GetIndexByteSize();
+	geo->Bounds = file.GetBounds();
+	geo->SphereBounds = file.GetSphereBounds();
+	geo->OrientedBounds = file.GetOrientedBounds();
+
+	for (uint32 i = 0; i < file.GetSubmeshCount(); ++i)
+		geo->DrawArgs[file.GetSubmeshName(i)] = file.GetSubmesh(i);
+	for (uint32 i = 0; i < file.GetClusterSetCount(); ++i)
+		geo->Clusters[file.GetClusterSetName(i)] = file.GetClusterSet(i);
+
+	// The uploads copy straight from the mapping into the upload heap,
+	// compressed streams are decoded into memory first.
+	const void* vertices = file.GetVertices();
+	const void* indices = file.GetIndices();
+	std::vector<MeshCodec::uint8> decodedVertices;
+	std::vector<MeshCodec::uint8> decodedIndices;
+	if (file.IsCompressed())
+	{
+		decodedVertices.resize(file.GetVertexByteSize());
+		decodedIndices.resize(file.GetIndexByteSize());
+
+		std::vector<MeshCodec::DecodeJob> jobs;
+		file.AddDecodeJobs(decodedVertices.data(), decodedIndices.data(), jobs);
+		if (!MeshCodec::DecodeParallel(jobs))
+		{
+			std::string message = "[MeshCooker] " + name + " could not be decoded.\n";
+			::OutputDebugStringA(message.c_str());
+			return nullptr;
+		}
+
+		vertices = decodedVertices.data();
+		indices = decodedIndices.data();
+	}
+
+	if (!SubmeshesInRange(file, indices))
+	{
+		std::string message = "[MeshCooker] " + name + " has submeshes out of range.\n";
+		::OutputDebugStringA(message.c_str());
+		return nullptr;
+	}
+
+	if (arena.Upload(*geo, vertices, file.GetVertexByteSize(), indices, file.GetIndexByteSize()))
+		return geo;
+
+	std::string message = "[MeshCooker] GeometryArena is full, " + name + " gets its own buffers.\n";
+	::OutputDebugStringA(message.c_str());
+
+	geo->VertexBufferGPU = D3D12Util::CreateDefaultBuffer(device, cmdList,
+		vertices, file.GetVertexByteSize(), geo->VertexBufferUploader);
+	geo->IndexBufferGPU = D3D12Util::CreateDefaultBuffer(device, cmdList,
+		indices, file.GetIndexByteSize(), geo->IndexBufferUploader);
+
+	return geo;
+}
+
+std::string MeshCooker::ToString(const std::string& name, const CookedMeshFile& file, double milliseconds)
+{
+	char buffer[256];
+	snprintf(buffer, sizeof(buffer),
+		"[MeshCooker] %s: %u submeshes, %u materials, %u vertices, %u indices, %zu bytes mapped%s, loaded in %.2f ms\n",
+		name.c_str(), file.GetSubmeshCount(), file.GetMaterialCount(),
+		file.GetVertexByteSize() / file.GetVertexByteStride(),
+		file.GetIndexByteSize() / (file.GetIndexFormat() == DXGI_FORMAT_R32_UINT ? 4 : 2),
+		file.GetFileSize(), file.IsCompressed() ? " (compressed)" : "", milliseconds);
+
+	return buffer;
+}
\ No newline at end of file
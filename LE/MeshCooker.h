@@ -0,0 +1,143 @@
+#pragma once
+#include "MeshGeometry.h"
+#include "MeshCodec.h"
+#include "MappedFile.h"
+
+class GeometryArena;
+
+// A material a cooked mesh refers to, by name and diffuse texture path.
+struct CookedMaterial
+{
+	std::string Name;
+	std::string DiffuseTexture;
+};
+
+// A cooked mesh file mapped into memory.  The vertex and index streams are
+// stored in their final GPU layout, so GetVertices and GetIndices point
+// straight into the mapping and can be handed to the upload as they are.
+// The pointers stay valid while the file lives.
+//
+// Compressed files store the streams encoded with MeshCodec instead, they
+// have to go through AddDecodeJobs before the upload.
+class CookedMeshFile
+{
+public:
+	using uint32 = std::uint32_t;
+	using uint64 = std::uint64_t;
+
+	CookedMeshFile() = default;
+	CookedMeshFile(const CookedMeshFile& rhs) = delete;
+	CookedMeshFile& operator=(const CookedMeshFile& rhs) = delete;
+	~CookedMeshFile();
+
+	///<summary>
+	/// Maps filename and checks its header and section sizes.  Returns false
+	/// if the file is missing, damaged or was written by another version.
+	///</summary>
+	bool Open(const std::string& filename);
+	void Close();
+
+	uint64 GetSourceStamp() const;
+	UINT GetVertexByteStride() const;
+	DXGI_FORMAT GetIndexFormat() const;
+
+	// The streams as stored, MeshCodec encoded when IsCompressed.
+	const void* GetVertices() const;
+	const void* GetIndices() const;
+	// Decoded sizes.
+	UINT GetVertexByteSize() const;
+	UINT GetIndexByteSize() const;
+
+	bool IsCompressed() const;
+	size_t GetStoredByteSize() const;
+
+	///<summary>
+	/// Adds the jobs that decode a compressed file's streams into vertices
+	/// and indices (GetVertexByteSize and GetIndexByteSize bytes), so the
+	/// streams of several files can go through one MeshCodec::DecodeParallel.
+	///</summary>
+	void AddDecodeJobs(void* vertices, void* indices, std::vector<MeshCodec::DecodeJob>& jobs) const;
+
+	uint32 GetSubmeshCount() const;
+	std::string GetSubmeshName(uint32 i) const;
+	SubmeshGeometry GetSubmesh(uint32 i) const;
+	uint32 GetSubmeshMaterial(uint32 i) const;
+
+	uint32 GetMaterialCount() const;
+	CookedMaterial GetMaterial(uint32 i) const;
+
+	uint32 GetClusterSetCount() const;
+	std::string GetClusterSetName(uint32 i) const;
+	MeshClusterSet GetClusterSet(uint32 i) const;
+
+	DirectX::BoundingBox GetBounds() const;
+	DirectX::BoundingSphere GetSphereBounds() const;
+	DirectX::BoundingOrientedBox GetOrientedBounds() const;
+
+	size_t GetFileSize() const
+	{
+		return mSize;
+	}
+
+private:
+	template<typename T>
+	const T* At(uint64 offset) const
+	{
+		return reinterpret_cast<const T*>(mView + offset);
+	}
+
+	std::string String(uint32 offset, uint32 length) const;
+
+	MappedFile mMapped;
+	const unsigned char* mView = nullptr;
+	size_t mSize = 0;
+};
+
+// Writes a built MeshGeometry to a cooked mesh file once, so later runs can
+// skip the import, optimization and simplification and map the result.
+//
+// A cooked file remembers the SourceStamp of the file and import settings
+// it was made from and is only used while they match.
+class MeshCooker
+{
+public:
+	using uint32 = std::uint32_t;
+	using uint64 = std::uint64_t;
+
+	///<summary>
+	/// Hash of the size and last write time of sourceFile and of the import
+	/// settings.  0 when the source is missing, which Open accepts for any
+	/// cooked file, so a build can ship without its sources.
+	///</summary>
+	static uint64 SourceStamp(const std::string& sourceFile, uint64 importSettings);
+
+	///<summary>
+	/// Writes the CPU copies of geo, its DrawArgs (relative to its own
+	/// buffers, also when it lives in a GeometryArena), bounds and clusters.
+	/// submeshMaterials maps DrawArgs names to indices into materials; names
+	/// that are not in it get material 0.  With compress the streams are
+	/// encoded with MeshCodec, which is smaller on disk and costs a decode
+	/// on every load.
+	///</summary>
+	static bool Save(const std::string& filename, const MeshGeometry& geo, const std::vector<CookedMaterial>& materials,
+		const std::unordered_map<std::string, uint32>& submeshMaterials, uint64 sourceStamp, bool compress = false);
+
+	///<summary>
+	/// Maps a cooked file.  Returns nullptr if it can not be opened or was
+	/// cooked from another source stamp.
+	///</summary>
+	static std::unique_ptr<CookedMeshFile> Open(const std::string& filename, uint64 sourceStamp);
+
+	///<summary>
+	/// Uploads the mapped streams into arena (or own buffers when it is full)
+	/// without copying them first, or decodes compressed streams on all
+	/// cores and uploads the result.  The geometry has no CPU copies and the
+	/// file can be closed once this returns.  Returns nullptr, before
+	/// uploading anything, if the streams do not decode or a submesh reads
+	/// past them; the file is damaged then and should be cooked again.
+	///</summary>
+	static std::unique_ptr<MeshGeometry> Build(const std::string& name, const CookedMeshFile& file,
+		GeometryArena& arena, ID3D12Device* device, ID3D12GraphicsCommandList* cmdList);
+
+	static std::string ToString(const std::string& name, const CookedMeshFile& file, double milliseconds);
+};
\ No newline at end of file
@@ -1,5 +1,9 @@
 #pragma once
 #include "D3D12Util.h"
+#include "DeferredReleaseQueue.h"
+#include "MeshClusters.h"
+
+class GeometryArena;
 
 // Defines a subrange of geometry in a MeshGeometry.  This is for when multiple
 // geometries are stored in one vertex and index buffer.  It provides the offsets
@@ -13,7 +17,21 @@ struct SubmeshGeometry
 
 	// Bounding box of the geometry defined by this submesh. 
 	// This is used in later chapters of the book.
+	// Filled by MeshBuilder from the float3 position at the start of each vertex,
+	// together with the bounding sphere and the oriented box (see BoundsFitter).
 	DirectX::BoundingBox Bounds;
+	DirectX::BoundingSphere SphereBounds;
+	DirectX::BoundingOrientedBox OrientedBounds;
+
+	// Object space error of a simplified level of detail, 0 at full detail.
+	float LodError = 0.0f;
+};
+
+// One level of detail of a mesh: the draws of all its parts and their error.
+struct MeshLod
+{
+	std::vector<SubmeshGeometry> Parts;
+	float Error = 0.0f;
 };
 
 struct MeshGeometry
@@ -38,11 +56,31 @@ struct MeshGeometry
 	DXGI_FORMAT IndexFormat = DXGI_FORMAT_R16_UINT;
 	UINT IndexBufferByteSize = 0;
 
+	// Dequantization for the unorm16 position formats: position = stored * scale + offset.
+	// Identity for float and half positions.
+	DirectX::XMFLOAT3 PositionScale = { 1.0f, 1.0f, 1.0f };
+	DirectX::XMFLOAT3 PositionOffset = { 0.0f, 0.0f, 0.0f };
+
+	// Bounds of all vertices in the buffer, in the same space as the DrawArgs bounds.
+	DirectX::BoundingBox Bounds;
+	DirectX::BoundingSphere SphereBounds;
+	DirectX::BoundingOrientedBox OrientedBounds;
+
+	// Set when the buffers are ranges of a GeometryArena.  The GPU buffers are
+	// then the shared arena buffers and DrawArgs are already rebased onto them.
+	GeometryArena* Arena = nullptr;
+	UINT64 ArenaFirstVertex = 0;
+	UINT64 ArenaIndexByteOffset = 0;
+
 	// A MeshGeometry may store multiple geometries in one vertex/index buffer.
 	// Use this container to define the Submesh geometries so we can draw
 	// the Submeshes individually.
 	std::unordered_map<std::string, SubmeshGeometry> DrawArgs;
 
+	// Optional clusters of some of the DrawArgs, under the same name, for
+	// culling finer than whole draws.
+	std::unordered_map<std::string, MeshClusterSet> Clusters;
+
 	D3D12_VERTEX_BUFFER_VIEW VertexBufferView()const
 	{
 		D3D12_VERTEX_BUFFER_VIEW vbv;
@@ -63,9 +101,12 @@ struct MeshGeometry
 		return ibv;
 	}
 
-	// We can free this memory after we finish upload to the GPU.
-	void DisposeUploaders()
+	// We can free this memory after we finish upload to the GPU, which is
+	// once the fence reaches fenceValue.
+	void DisposeUploaders(DeferredReleaseQueue& releaseQueue, UINT64 fenceValue)
 	{
+		releaseQueue.Retire(std::move(VertexBufferUploader), fenceValue);
+		releaseQueue.Retire(std::move(IndexBufferUploader), fenceValue);
 		VertexBufferUploader = nullptr;
 		IndexBufferUploader = nullptr;
 	}
@@ -0,0 +1,657 @@
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+const MeshOptimizer::uint32 MeshOptimizer::DefaultCacheSize;
+const MeshOptimizer::uint32 MeshOptimizer::InvalidIndex;
+
+namespace
+{
+	using uint32 = MeshOptimizer::uint32;
+
+	// Tuning values from the original paper.  The modelled cache is a LRU of
+	// MaxCacheSize entries, which also works well for the FIFO caches in hardware.
+	const int MaxCacheSize = 32;
+	const int MaxValence = 64;
+	const float CacheDecayPower = 1.5f;
+	const float LastTriScore = 0.75f;
+	const float ValenceBoostScale = 2.0f;
+	const float ValenceBoostPower = 0.5f;
+
+	struct ScoreTables
+	{
+		ScoreTables()
+		{
+			for (int i = 0; i < MaxCacheSize; ++i)
+			{
+				if (i < 3)
+				{
+					// The vertices of the last triangle get a fixed score so the
+					// optimizer does not simply walk a strip back and forth.
+					Cache[i] = LastTriScore;
+				}
+				else
+				{
+					const float scaler = 1.0f / (MaxCacheSize - 3);
+					Cache[i] = powf(1.0f - (i - 3) * scaler, CacheDecayPower);
+				}
+			}
+
+			Valence[0] = 0.0f;
+			for (int i = 1; i < MaxValence; ++i)
+			{
+				// Boost vertices with few triangles left so lone triangles get finished.
+				Valence[i] = ValenceBoostScale * powf((float)i, -ValenceBoostPower);
+			}
+		}
+
+		float Cache[MaxCacheSize];
+		float Valence[MaxValence];
+	};
+
+	const ScoreTables& GetScoreTables()
+	{
+		static const ScoreTables tables;
+		return tables;
+	}
+
+	float VertexScore(const ScoreTables& tables, int cachePosition, uint32 remainingTris)
+	{
+		// No triangle left to draw, so the vertex does not matter anymore.
+		if (remainingTris == 0)
+			return -1.0f;
+
+		float score = cachePosition >= 0 ? tables.Cache[cachePosition] : 0.0f;
+		score += tables.Valence[std::min<uint32>(remainingTris, MaxValence - 1)];
+
+		return score;
+	}
+
+	template<typename T>
+	void OptimizeVertexCacheImpl(T* indices, size_t indexCount, size_t vertexCount)
+	{
+		const size_t triCount = indexCount / 3;
+		if (triCount == 0 || vertexCount == 0)
+			return;
+
+		const ScoreTables& tables = GetScoreTables();
+
+		//
+		// Build the vertex -> triangle adjacency.
+		//
+
+		std::vector<uint32> remainingTris(vertexCount, 0);
+		for (size_t i = 0; i < triCount * 3; ++i)
+			remainingTris[indices[i]]++;
+
+		std::vector<uint32> triOffsets(vertexCount + 1, 0);
+		for (size_t v = 0; v < vertexCount; ++v)
+			triOffsets[v + 1] = triOffsets[v] + remainingTris[v];
+
+		std::vector<uint32> triList(triCount * 3);
+		{
+			std::vector<uint32> cursor(triOffsets.begin(), triOffsets.end() - 1);
+			for (size_t i = 0; i < triCount * 3; ++i)
+				triList[cursor[indices[i]]++] = (uint32)(i / 3);
+		}
+
+		//
+		// Initial scores.
+		//
+
+		std::vector<int> cachePosition(vertexCount, -1);
+		std::vector<float> vertexScore(vertexCount);
+		for (size_t v = 0; v < vertexCount; ++v)
+			vertexScore[v] = VertexScore(tables, -1, remainingTris[v]);
+
+		std::vector<float> triScore(triCount);
+		std::vector<char> triEmitted(triCount, 0);
+
+		int bestTri = -1;
+		float bestScore = -1.0f;
+		for (size_t t = 0; t < triCount; ++t)
+		{
+			triScore[t] = vertexScore[indices[t * 3 + 0]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+			if (triScore[t] > bestScore)
+			{
+				bestScore = triScore[t];
+				bestTri = (int)t;
+			}
+		}
+
+		//
+		// Greedily emit the best triangle and update the scores around the cache.
+		//
+
+		std::vector<T> output(triCount * 3);
+
+		int cache[MaxCacheSize + 3];
+		int cacheCount = 0;
+		size_t deadEndCursor = 0;
+
+		for (size_t outTri = 0; outTri < triCount; ++outTri)
+		{
+			if (bestTri < 0)
+			{
+				// None of the cached vertices has triangles left, restart with
+				// the next triangle that has not been emitted yet.
+				while (triEmitted[deadEndCursor])
+					++deadEndCursor;
+				bestTri = (int)deadEndCursor;
+			}
+
+			const T* tri = &indices[bestTri * 3];
+			output[outTri * 3 + 0] = tri[0];
+			output[outTri * 3 + 1] = tri[1];
+			output[outTri * 3 + 2] = tri[2];
+			triEmitted[bestTri] = 1;
+
+			// Remove the triangle from the adjacency of its vertices.
+			for (int k = 0; k < 3; ++k)
+			{
+				uint32 v = tri[k];
+				uint32* begin = &triList[triOffsets[v]];
+				uint32* end = begin + remainingTris[v];
+				uint32* it = std::find(begin, end, (uint32)bestTri);
+				std::swap(*it, *(end - 1));
+				remainingTris[v]--;
+			}
+
+			// The triangle vertices move to the front of the LRU cache.
+			int newCache[MaxCacheSize + 3];
+			int newCacheCount = 0;
+			for (int k = 0; k < 3; ++k)
+				newCache[newCacheCount++] = (int)tri[k];
+
+			for (int i = 0; i < cacheCount; ++i)
+			{
+				int v = cache[i];
+				if (v != (int)tri[0] && v != (int)tri[1] && v != (int)tri[2])
+					newCache[newCacheCount++] = v;
+			}
+
+			// Update the vertex scores, including the ones that just fell out of the cache.
+			for (int i = 0; i < newCacheCount; ++i)
+			{
+				int v = newCache[i];
+				cachePosition[v] = i < MaxCacheSize ? i : -1;
+				vertexScore[v] = VertexScore(tables, cachePosition[v], remainingTris[v]);
+			}
+
+			// Only triangles touching those vertices changed score.
+			bestTri = -1;
+			bestScore = -1.0f;
+			for (int i = 0; i < newCacheCount; ++i)
+			{
+				int v = newCache[i];
+				for (uint32 j = 0; j < remainingTris[v]; ++j)
+				{
+					uint32 t = triList[triOffsets[v] + j];
+					const T* adj = &indices[t * 3];
+					triScore[t] = vertexScore[adj[0]] + vertexScore[adj[1]] + vertexScore[adj[2]];
+					if (triScore[t] > bestScore)
+					{
+						bestScore = triScore[t];
+						bestTri = (int)t;
+					}
+				}
+			}
+
+			cacheCount = std::min(newCacheCount, MaxCacheSize);
+			std::copy(newCache, newCache + cacheCount, cache);
+		}
+
+		std::copy(output.begin(), output.end(), indices);
+	}
+
+	template<typename T>
+	size_t BuildVertexFetchRemapImpl(std::vector<uint32>& remap, const T* indices, size_t indexCount, size_t vertexCount)
+	{
+		remap.assign(vertexCount, MeshOptimizer::InvalidIndex);
+
+		uint32 nextVertex = 0;
+		for (size_t i = 0; i < indexCount; ++i)
+		{
+			uint32& r = remap[indices[i]];
+			if (r == MeshOptimizer::InvalidIndex)
+				r = nextVertex++;
+		}
+
+		return nextVertex;
+	}
+
+	template<typename T>
+	void RemapIndexBufferImpl(T* indices, size_t indexCount, const std::vector<uint32>& remap)
+	{
+		for (size_t i = 0; i < indexCount; ++i)
+			indices[i] = (T)remap[indices[i]];
+	}
+
+	// FIFO post-transform cache simulation.  A vertex is still cached if fewer
+	// than cacheSize misses happened since it was last transformed.
+	class FifoCache
+	{
+	public:
+		FifoCache(size_t vertexCount, uint32 cacheSize)
+			:
+			mTimeStamps(vertexCount, 0),
+			mCacheSize(cacheSize),
+			mTimeStamp(cacheSize + 1)
+		{}
+
+		// Returns the number of vertices of the triangle that had to be transformed.
+		template<typename T>
+		uint32 AccessTriangle(const T* tri)
+		{
+			return Access(tri[0]) + Access(tri[1]) + Access(tri[2]);
+		}
+
+		uint32 Access(uint32 v)
+		{
+			if (mTimeStamp - mTimeStamps[v] > mCacheSize)
+			{
+				mTimeStamps[v] = mTimeStamp++;
+				return 1;
+			}
+			return 0;
+		}
+
+		void Flush()
+		{
+			mTimeStamp += mCacheSize + 1;
+		}
+
+	private:
+		std::vector<uint32> mTimeStamps;
+		uint32 mCacheSize;
+		uint32 mTimeStamp;
+	};
+
+	template<typename T>
+	MeshOptimizer::VertexCacheStats AnalyzeVertexCacheImpl(const T* indices, size_t indexCount, size_t vertexCount, uint32 cacheSize)
+	{
+		MeshOptimizer::VertexCacheStats stats;
+		if (indexCount < 3 || vertexCount == 0)
+			return stats;
+
+		FifoCache cache(vertexCount, cacheSize);
+		std::vector<char> referenced(vertexCount, 0);
+		uint32 uniqueVertices = 0;
+
+		for (size_t i = 0; i < indexCount; ++i)
+		{
+			T v = indices[i];
+			stats.VerticesTransformed += cache.Access(v);
+			if (!referenced[v])
+			{
+				referenced[v] = 1;
+				uniqueVertices++;
+			}
+		}
+
+		stats.ACMR = (float)stats.VerticesTransformed / (indexCount / 3);
+		stats.ATVR = (float)stats.VerticesTransformed / uniqueVertices;
+
+		return stats;
+	}
+
+	struct Float3
+	{
+		float x, y, z;
+	};
+
+	inline Float3 GetPosition(const float* positions, size_t positionByteStride, uint32 v)
+	{
+		const float* p = reinterpret_cast<const float*>(reinterpret_cast<const char*>(positions) + v * positionByteStride);
+		return { p[0], p[1], p[2] };
+	}
+
+	template<typename T>
+	void OptimizeOverdrawImpl(T* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t positionByteStride, float threshold)
+	{
+		const size_t triCount = indexCount / 3;
+		if (triCount == 0 || vertexCount == 0)
+			return;
+
+		//
+		// Hard boundaries: a triangle that misses the cache with all three vertices
+		// starts a new patch that is disjoint from what was drawn before.
+		//
+
+		FifoCache cache(vertexCount, MeshOptimizer::DefaultCacheSize);
+
+		std::vector<uint32> hardClusters;
+		for (size_t t = 0; t < triCount; ++t)
+		{
+			uint32 misses = cache.AccessTriangle(&indices[t * 3]);
+			if (t == 0 || misses == 3)
+				hardClusters.push_back((uint32)t);
+		}
+		hardClusters.push_back((uint32)triCount);
+
+		//
+		// Soft boundaries: split a patch again whenever the triangles since the
+		// last split already reach the patch ACMR (scaled by threshold).  Every
+		// split flushes the cache, which is what costs the vertex cache efficiency.
+		//
+
+		std::vector<uint32> clusters;
+		for (size_t h = 0; h + 1 < hardClusters.size(); ++h)
+		{
+			uint32 start = hardClusters[h];
+			uint32 end = hardClusters[h + 1];
+
+			cache.Flush();
+			uint32 clusterMisses = 0;
+			for (uint32 t = start; t < end; ++t)
+				clusterMisses += cache.AccessTriangle(&indices[t * 3]);
+
+			float clusterThreshold = threshold * (float)clusterMisses / (end - start);
+
+			clusters.push_back(start);
+
+			cache.Flush();
+			uint32 runningMisses = 0;
+			uint32 runningTris = 0;
+			for (uint32 t = start; t < end; ++t)
+			{
+				runningMisses += cache.AccessTriangle(&indices[t * 3]);
+				runningTris++;
+
+				if (t + 1 < end && (float)runningMisses / runningTris <= clusterThreshold)
+				{
+					clusters.push_back(t + 1);
+					cache.Flush();
+					runningMisses = 0;
+					runningTris = 0;
+				}
+			}
+
+			// The tail never reached the target on its own, so merge it into the previous cluster.
+			if (runningTris > 0 && clusters.back() != start)
+				clusters.pop_back();
+		}
+		clusters.push_back((uint32)triCount);
+
+		const size_t clusterCount = clusters.size() - 1;
+
+		//
+		// Sort key: clusters that are far from the mesh center and face outwards
+		// cover the most of the remaining mesh, so draw them first.
+		//
+
+		Float3 meshCentroid = { 0.0f, 0.0f, 0.0f };
+		for (size_t v = 0; v < vertexCount; ++v)
+		{
+			Float3 p = GetPosition(positions, positionByteStride, (uint32)v);
+			meshCentroid.x += p.x;
+			meshCentroid.y += p.y;
+			meshCentroid.z += p.z;
+		}
+		meshCentroid.x /= vertexCount;
+		meshCentroid.y /= vertexCount;
+		meshCentroid.z /= vertexCount;
+
+		std::vector<float> sortKeys(clusterCount);
+		for (size_t c = 0; c < clusterCount; ++c)
+		{
+			Float3 centroid = { 0.0f, 0.0f, 0.0f };
+			Float3 normal = { 0.0f, 0.0f, 0.0f };
+			float areaSum = 0.0f;
+
+			for (uint32 t = clusters[c]; t < clusters[c + 1]; ++t)
+			{
+				Float3 p0 = GetPosition(positions, positionByteStride, indices[t * 3 + 0]);
+				Float3 p1 = GetPosition(positions, positionByteStride, indices[t * 3 + 1]);
+				Float3 p2 = GetPosition(positions, positionByteStride, indices[t * 3 + 2]);
+
+				Float3 e1 = { p1.x - p0.x, p1.y - p0.y, p1.z - p0.z };
+				Float3 e2 = { p2.x - p0.x, p2.y - p0.y, p2.z - p0.z };
+				Float3 n = { e1.y * e2.z - e1.z * e2.y, e1.z * e2.x - e1.x * e2.z, e1.x * e2.y - e1.y * e2.x };
+				float area = sqrtf(n.x * n.x + n.y * n.y + n.z * n.z);
+
+				centroid.x += (p0.x + p1.x + p2.x) / 3.0f * area;
+				centroid.y += (p0.y + p1.y + p2.y) / 3.0f * area;
+				centroid.z += (p0.z + p1.z + p2.z) / 3.0f * area;
+				normal.x += n.x;
+				normal.y += n.y;
+				normal.z += n.z;
+				areaSum += area;
+			}
+
+			float invArea = areaSum > 0.0f ? 1.0f / areaSum : 0.0f;
+			centroid.x *= invArea;
+			centroid.y *= invArea;
+			centroid.z *= invArea;
+
+			float normalLength = sqrtf(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+			float invNormalLength = normalLength > 0.0f ? 1.0f / normalLength : 0.0f;
+
+			sortKeys[c] =
+				(centroid.x - meshCentroid.x) * normal.x * invNormalLength +
+				(centroid.y - meshCentroid.y) * normal.y * invNormalLength +
+				(centroid.z - meshCentroid.z) * normal.z * invNormalLength;
+		}
+
+		std::vector<uint32> clusterOrder(clusterCount);
+		for (size_t c = 0; c < clusterCount; ++c)
+			clusterOrder[c] = (uint32)c;
+
+		std::stable_sort(clusterOrder.begin(), clusterOrder.end(),
+			[&sortKeys](uint32 a, uint32 b) { return sortKeys[a] > sortKeys[b]; });
+
+		std::vector<T> output;
+		output.reserve(triCount * 3);
+		for (size_t i = 0; i < clusterCount; ++i)
+		{
+			uint32 c = clusterOrder[i];
+			output.insert(output.end(), indices + clusters[c] * 3, indices + clusters[c + 1] * 3);
+		}
+
+		std::copy(output.begin(), output.end(), indices);
+	}
+
+	template<typename T>
+	MeshOptimizer::OverdrawStats AnalyzeOverdrawImpl(const T* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t positionByteStride)
+	{
+		MeshOptimizer::OverdrawStats stats;
+		if (indexCount < 3 || vertexCount == 0)
+			return stats;
+
+		const int ViewportSize = 256;
+
+		// Fit the mesh into the unit cube, keeping the aspect ratio.
+		Float3 minP = GetPosition(positions, positionByteStride, 0);
+		Float3 maxP = minP;
+		for (size_t v = 1; v < vertexCount; ++v)
+		{
+			Float3 p = GetPosition(positions, positionByteStride, (uint32)v);
+			minP = { std::min(minP.x, p.x), std::min(minP.y, p.y), std::min(minP.z, p.z) };
+			maxP = { std::max(maxP.x, p.x), std::max(maxP.y, p.y), std::max(maxP.z, p.z) };
+		}
+		float extent = std::max(maxP.x - minP.x, std::max(maxP.y - minP.y, maxP.z - minP.z));
+		float invExtent = extent > 0.0f ? 1.0f / extent : 0.0f;
+
+		// Each view is a rotation of the left-handed world axes: right, up and
+		// forward given as (axis, sign).  right x up = forward for all of them.
+		struct AxisSign { int Axis; float Sign; };
+		const AxisSign views[6][3] =
+		{
+			{ { 0, +1.0f }, { 1, +1.0f }, { 2, +1.0f } },
+			{ { 0, -1.0f }, { 1, +1.0f }, { 2, -1.0f } },
+			{ { 2, -1.0f }, { 1, +1.0f }, { 0, +1.0f } },
+			{ { 2, +1.0f }, { 1, +1.0f }, { 0, -1.0f } },
+			{ { 0, +1.0f }, { 2, -1.0f }, { 1, +1.0f } },
+			{ { 0, +1.0f }, { 2, +1.0f }, { 1, -1.0f } },
+		};
+
+		std::vector<float> depthBuffer(ViewportSize * ViewportSize);
+
+		for (int view = 0; view < 6; ++view)
+		{
+			std::fill(depthBuffer.begin(), depthBuffer.end(), FLT_MAX);
+
+			auto project = [&](uint32 v)
+			{
+				Float3 p = GetPosition(positions, positionByteStride, v);
+				float n[3] = { (p.x - minP.x) * invExtent, (p.y - minP.y) * invExtent, (p.z - minP.z) * invExtent };
+
+				Float3 s;
+				s.x = (views[view][0].Sign > 0.0f ? n[views[view][0].Axis] : 1.0f - n[views[view][0].Axis]) * ViewportSize;
+				s.y = (views[view][1].Sign > 0.0f ? n[views[view][1].Axis] : 1.0f - n[views[view][1].Axis]) * ViewportSize;
+				s.z = views[view][2].Sign > 0.0f ? n[views[view][2].Axis] : 1.0f - n[views[view][2].Axis];
+				return s;
+			};
+
+			for (size_t t = 0; t < indexCount / 3; ++t)
+			{
+				Float3 v0 = project(indices[t * 3 + 0]);
+				Float3 v1 = project(indices[t * 3 + 1]);
+				Float3 v2 = project(indices[t * 3 + 2]);
+
+				// Front faces are clockwise on screen (y up here), so cull the rest.
+				float area = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+				if (area >= 0.0f)
+					continue;
+
+				// Flip to counter-clockwise so all three edge functions are positive inside.
+				std::swap(v1, v2);
+				area = -area;
+
+				int minX = std::max(0, (int)floorf(std::min(v0.x, std::min(v1.x, v2.x))));
+				int maxX = std::min(ViewportSize - 1, (int)ceilf(std::max(v0.x, std::max(v1.x, v2.x))));
+				int minY = std::max(0, (int)floorf(std::min(v0.y, std::min(v1.y, v2.y))));
+				int maxY = std::min(ViewportSize - 1, (int)ceilf(std::max(v0.y, std::max(v1.y, v2.y))));
+
+				for (int y = minY; y <= maxY; ++y)
+				{
+					float py = y + 0.5f;
+					for (int x = minX; x <= maxX; ++x)
+					{
+						float px = x + 0.5f;
+
+						float w0 = (v2.x - v1.x) * (py - v1.y) - (v2.y - v1.y) * (px - v1.x);
+						float w1 = (v0.x - v2.x) * (py - v2.y) - (v0.y - v2.y) * (px - v2.x);
+						float w2 = (v1.x - v0.x) * (py - v0.y) - (v1.y - v0.y) * (px - v0.x);
+						if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f)
+							continue;
+
+						float z = (w0 * v0.z + w1 * v1.z + w2 * v2.z) / area;
+
+						float& depth = depthBuffer[y * ViewportSize + x];
+						if (z < depth)
+						{
+							depth = z;
+							stats.PixelsShaded++;
+						}
+					}
+				}
+			}
+
+			for (float depth : depthBuffer)
+			{
+				if (depth != FLT_MAX)
+					stats.PixelsCovered++;
+			}
+		}
+
+		stats.Overdraw = stats.PixelsCovered > 0 ? (float)stats.PixelsShaded / stats.PixelsCovered : 0.0f;
+
+		return stats;
+	}
+}
+
+void MeshOptimizer::OptimizeVertexCache(uint16* indices, size_t indexCount, size_t vertexCount)
+{
+	OptimizeVertexCacheImpl(indices, indexCount, vertexCount);
+}
+
+void MeshOptimizer::OptimizeVertexCache(uint32* indices, size_t indexCount, size_t vertexCount)
+{
+	OptimizeVertexCacheImpl(indices, indexCount, vertexCount);
+}
+
+size_t MeshOptimizer::BuildVertexFetchRemap(std::vector<uint32>& remap, const uint16* indices, size_t indexCount, size_t vertexCount)
+{
+	return BuildVertexFetchRemapImpl(remap, indices, indexCount, vertexCount);
+}
+
+size_t MeshOptimizer::BuildVertexFetchRemap(std::vector<uint32>& remap, const uint32* indices, size_t indexCount, size_t vertexCount)
+{
+	return BuildVertexFetchRemapImpl(remap, indices, indexCount, vertexCount);
+}
+
+void MeshOptimizer::RemapVertexBuffer(void* dst, const void* src, size_t vertexCount, size_t vertexByteStride, const std::vector<uint32>& remap)
+{
+	const unsigned char* srcBytes = static_cast<const unsigned char*>(src);
+	unsigned char* dstBytes = static_cast<unsigned char*>(dst);
+
+	for (size_t v = 0; v < vertexCount; ++v)
+	{
+		if (remap[v] != InvalidIndex)
+			memcpy(dstBytes + remap[v] * vertexByteStride, srcBytes + v * vertexByteStride, vertexByteStride);
+	}
+}
+
+void MeshOptimizer::RemapIndexBuffer(uint16* indices, size_t indexCount, const std::vector<uint32>& remap)
+{
+	RemapIndexBufferImpl(indices, indexCount, remap);
+}
+
+void MeshOptimizer::RemapIndexBuffer(uint32* indices, size_t indexCount, const std::vector<uint32>& remap)
+{
+	RemapIndexBufferImpl(indices, indexCount, remap);
+}
+
+MeshOptimizer::VertexCacheStats MeshOptimizer::AnalyzeVertexCache(const uint16* indices, size_t indexCount, size_t vertexCount, uint32 cacheSize)
+{
+	return AnalyzeVertexCacheImpl(indices, indexCount, vertexCount, cacheSize);
+}
+
+MeshOptimizer::VertexCacheStats MeshOptimizer::AnalyzeVertexCache(const uint32* indices, size_t indexCount, size_t vertexCount, uint32 cacheSize)
+{
+	return AnalyzeVertexCacheImpl(indices, indexCount, vertexCount, cacheSize);
+}
+
+void MeshOptimizer::OptimizeOverdraw(uint16* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t positionByteStride, float threshold)
+{
+	OptimizeOverdrawImpl(indices, indexCount, positions, vertexCount, positionByteStride, threshold);
+}
+
+void MeshOptimizer::OptimizeOverdraw(uint32* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t positionByteStride, float threshold)
+{
+	OptimizeOverdrawImpl(indices, indexCount, positions, vertexCount, positionByteStride, threshold);
+}
+
+MeshOptimizer::OverdrawStats MeshOptimizer::AnalyzeOverdraw(const uint16* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t positionByteStride)
+{
+	return AnalyzeOverdrawImpl(indices, indexCount, positions, vertexCount, positionByteStride);
+}
+
+MeshOptimizer::OverdrawStats MeshOptimizer::AnalyzeOverdraw(const uint32* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t positionByteStride)
+{
+	return AnalyzeOverdrawImpl(indices, indexCount, positions, vertexCount, positionByteStride);
+}
+
+std::string MeshOptimizer::OverdrawReport::ToString(const std::string& name) const
+{
+	char buffer[256];
+	snprintf(buffer, sizeof(buffer),
+		"[MeshOptimizer] %s: overdraw %.3f -> %.3f, ACMR %.3f -> %.3f\n",
+		name.c_str(), Before.Overdraw, After.Overdraw, CacheBefore.ACMR, CacheAfter.ACMR);
+
+	return buffer;
+}
+
+std::string MeshOptimizer::VertexCacheReport::ToString(const std::string& name) const
+{
+	char buffer[256];
+	snprintf(buffer, sizeof(buffer),
+		"[MeshOptimizer] %s: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n",
+		name.c_str(), Before.ACMR, After.ACMR, Before.ATVR, After.ATVR);
+
+	return buffer;
+}
\ No newline at end of file
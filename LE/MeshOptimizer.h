@@ -0,0 +1,175 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// CPU side mesh optimizations that run on the index/vertex data before it is
+// uploaded.  Nothing in here touches D3D12, so it can also be used by tools.
+class MeshOptimizer
+{
+public:
+	using uint16 = std::uint16_t;
+	using uint32 = std::uint32_t;
+
+	// Size of the FIFO post-transform cache used to measure the meshes.
+	static const uint32 DefaultCacheSize = 16;
+
+	// Remap table entry for vertices that are not referenced by any index.
+	static const uint32 InvalidIndex = ~0u;
+
+	struct VertexCacheStats
+	{
+		// Vertices that missed the cache and had to be transformed.
+		uint32 VerticesTransformed = 0;
+		// Average cache miss ratio: transformed vertices per triangle (0.5 is the ideal).
+		float ACMR = 0.0f;
+		// Average transformed vertex ratio: transformed vertices per vertex (1.0 is the ideal).
+		float ATVR = 0.0f;
+	};
+
+	struct OverdrawStats
+	{
+		// Pixels covered by the mesh, summed over all sample views.
+		uint32 PixelsCovered = 0;
+		// Fragments that passed the depth test, summed over all sample views.
+		uint32 PixelsShaded = 0;
+		// Shaded fragments per covered pixel (1.0 is the ideal).
+		float Overdraw = 0.0f;
+	};
+
+	struct OverdrawReport
+	{
+		VertexCacheStats CacheBefore;
+		VertexCacheStats CacheAfter;
+		OverdrawStats Before;
+		OverdrawStats After;
+
+		std::string ToString(const std::string& name) const;
+	};
+
+	struct VertexCacheReport
+	{
+		VertexCacheStats Before;
+		VertexCacheStats After;
+
+		std::string ToString(const std::string& name) const;
+	};
+
+	///<summary>
+	/// Reorders the triangles of an indexed triangle list for post-transform
+	/// vertex cache locality (Tom Forsyth, "Linear-Speed Vertex Cache Optimisation").
+	/// Only the order of the triangles changes, the winding of each triangle is kept.
+	///</summary>
+	static void OptimizeVertexCache(uint16* indices, size_t indexCount, size_t vertexCount);
+	static void OptimizeVertexCache(uint32* indices, size_t indexCount, size_t vertexCount);
+
+	///<summary>
+	/// Simulates a FIFO post-transform cache of the given size over the index list.
+	///</summary>
+	static VertexCacheStats AnalyzeVertexCache(const uint16* indices, size_t indexCount, size_t vertexCount, uint32 cacheSize = DefaultCacheSize);
+	static VertexCacheStats AnalyzeVertexCache(const uint32* indices, size_t indexCount, size_t vertexCount, uint32 cacheSize = DefaultCacheSize);
+
+	///<summary>
+	/// Builds a remap table that renumbers the vertices in the order the index
+	/// list first references them, so the vertex fetch walks memory linearly.
+	/// remap[oldIndex] is the new index, or InvalidIndex for vertices no triangle
+	/// uses.  Returns the number of vertices that are left.
+	///</summary>
+	static size_t BuildVertexFetchRemap(std::vector<uint32>& remap, const uint16* indices, size_t indexCount, size_t vertexCount);
+	static size_t BuildVertexFetchRemap(std::vector<uint32>& remap, const uint32* indices, size_t indexCount, size_t vertexCount);
+
+	///<summary>
+	/// Applies a remap table to any per-vertex stream with the given stride.
+	/// dst must hold the vertex count returned by BuildVertexFetchRemap and must not alias src.
+	///</summary>
+	static void RemapVertexBuffer(void* dst, const void* src, size_t vertexCount, size_t vertexByteStride, const std::vector<uint32>& remap);
+
+	///<summary>
+	/// Rewrites the index list with the new vertex numbers.
+	///</summary>
+	static void RemapIndexBuffer(uint16* indices, size_t indexCount, const std::vector<uint32>& remap);
+	static void RemapIndexBuffer(uint32* indices, size_t indexCount, const std::vector<uint32>& remap);
+
+	///<summary>
+	/// Stride based vertex fetch optimization.  Reorders the vertices in place,
+	/// rewrites the indices and returns the remap table, so auxiliary streams
+	/// that belong to the same vertices can be reordered with RemapVertexBuffer.
+	/// vertexCount is updated to the number of vertices still referenced.
+	///</summary>
+	template<typename TIndex>
+	static std::vector<uint32> OptimizeVertexFetch(void* vertices, size_t& vertexCount, size_t vertexByteStride, TIndex* indices, size_t indexCount)
+	{
+		std::vector<uint32> remap;
+		size_t newVertexCount = BuildVertexFetchRemap(remap, indices, indexCount, vertexCount);
+
+		std::vector<unsigned char> src((const unsigned char*)vertices, (const unsigned char*)vertices + vertexCount * vertexByteStride);
+		RemapVertexBuffer(vertices, src.data(), vertexCount, vertexByteStride, remap);
+		RemapIndexBuffer(indices, indexCount, remap);
+
+		vertexCount = newVertexCount;
+		return remap;
+	}
+
+	///<summary>
+	/// Typed convenience wrapper for any of the PrimitiveTypes vertex layouts.
+	///</summary>
+	template<typename TVertex, typename TIndex>
+	static std::vector<uint32> OptimizeVertexFetch(std::vector<TVertex>& vertices, std::vector<TIndex>& indices)
+	{
+		size_t vertexCount = vertices.size();
+		std::vector<uint32> remap = OptimizeVertexFetch(vertices.data(), vertexCount, sizeof(TVertex), indices.data(), indices.size());
+		vertices.resize(vertexCount);
+		return remap;
+	}
+
+	///<summary>
+	/// Splits an already cache optimized triangle list into clusters and sorts
+	/// them so that clusters facing away from the mesh center are drawn first,
+	/// which lets them occlude the rest from most view directions.  Clusters are
+	/// only split where the running ACMR is within threshold times the ACMR of
+	/// the surrounding patch, so threshold = 1.05 gives up at most about 5% of
+	/// the vertex cache efficiency.  positions points at the first vertex
+	/// position (3 floats) and positionByteStride is the vertex stride.
+	///</summary>
+	static void OptimizeOverdraw(uint16* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t positionByteStride, float threshold);
+	static void OptimizeOverdraw(uint32* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t positionByteStride, float threshold);
+
+	///<summary>
+	/// Rasterizes the mesh with a small CPU depth buffer from the six axis
+	/// aligned directions (back faces culled) and counts the overdraw.
+	///</summary>
+	static OverdrawStats AnalyzeOverdraw(const uint16* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t positionByteStride);
+	static OverdrawStats AnalyzeOverdraw(const uint32* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t positionByteStride);
+
+	///<summary>
+	/// Runs OptimizeOverdraw on a mesh made of any PrimitiveTypes layout and
+	/// returns the overdraw and vertex cache statistics before and after.
+	///</summary>
+	template<typename TVertex, typename TIndex>
+	static OverdrawReport OptimizeOverdraw(std::vector<TIndex>& indices, const std::vector<TVertex>& vertices, float threshold)
+	{
+		const float* positions = &vertices[0].Position.x;
+
+		OverdrawReport report;
+		report.CacheBefore = AnalyzeVertexCache(indices.data(), indices.size(), vertices.size());
+		report.Before = AnalyzeOverdraw(indices.data(), indices.size(), positions, vertices.size(), sizeof(TVertex));
+		OptimizeOverdraw(indices.data(), indices.size(), positions, vertices.size(), sizeof(TVertex), threshold);
+		report.CacheAfter = AnalyzeVertexCache(indices.data(), indices.size(), vertices.size());
+		report.After = AnalyzeOverdraw(indices.data(), indices.size(), positions, vertices.size(), sizeof(TVertex));
+		return report;
+	}
+
+	///<summary>
+	/// Optimizes the index list in place and returns the cache statistics before and after.
+	///</summary>
+	template<typename T>
+	static VertexCacheReport OptimizeVertexCache(std::vector<T>& indices, size_t vertexCount)
+	{
+		VertexCacheReport report;
+		report.Before = AnalyzeVertexCache(indices.data(), indices.size(), vertexCount);
+		OptimizeVertexCache(indices.data(), indices.size(), vertexCount);
+		report.After = AnalyzeVertexCache(indices.data(), indices.size(), vertexCount);
+		return report;
+	}
+};
\ No newline at end of file
@@ -0,0 +1,658 @@
+#include "MeshSimplifier.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace
+{
+	using uint32 = MeshSimplifier::uint32;
+	using uint64 = std::uint64_t;
+
+	const uint32 InvalidIndex = ~0u;
+
+	// Planes along open borders count this much more than the surface planes,
+	// so borders are the last thing to move.
+	const float BorderWeight = 10.0f;
+
+	enum class VertexKind
+	{
+		// Interior vertex with a single set of attributes, may collapse along any edge.
+		Manifold,
+		// Vertex on an open border, only collapses along the border.
+		Border,
+		// One of two vertices sharing a position with different attributes,
+		// only collapses along the seam, together with its twin.
+		Seam,
+		// Anything more complicated (corners, non-manifold fans, ...) stays.
+		Locked,
+	};
+
+	struct Vector3
+	{
+		float x, y, z;
+	};
+
+	Vector3 Subtract(const Vector3& a, const Vector3& b)
+	{
+		return { a.x - b.x, a.y - b.y, a.z - b.z };
+	}
+
+	Vector3 Cross(const Vector3& a, const Vector3& b)
+	{
+		return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+	}
+
+	float Dot(const Vector3& a, const Vector3& b)
+	{
+		return a.x * b.x + a.y * b.y + a.z * b.z;
+	}
+
+	float Length(const Vector3& a)
+	{
+		return sqrtf(Dot(a, a));
+	}
+
+	// Q(p) = p^T A p + 2 b^T p + c with the symmetric A stored as its six
+	// distinct entries.  Planes are weighted, W is the sum of the weights so
+	// Error() is the weighted mean of the squared distances to the planes.
+	struct Quadric
+	{
+		float A00 = 0.0f, A11 = 0.0f, A22 = 0.0f;
+		float A10 = 0.0f, A20 = 0.0f, A21 = 0.0f;
+		float B0 = 0.0f, B1 = 0.0f, B2 = 0.0f;
+		float C = 0.0f;
+		float W = 0.0f;
+
+		void AddPlane(const Vector3& n, float d, float weight)
+		{
+			A00 += weight * n.x * n.x;
+			A11 += weight * n.y * n.y;
+			A22 += weight * n.z * n.z;
+			A10 += weight * n.y * n.x;
+			A20 += weight * n.z * n.x;
+			A21 += weight * n.z * n.y;
+			B0 += weight * n.x * d;
+			B1 += weight * n.y * d;
+			B2 += weight * n.z * d;
+			C += weight * d * d;
+			W += weight;
+		}
+
+		void Add(const Quadric& q)
+		{
+			A00 += q.A00; A11 += q.A11; A22 += q.A22;
+			A10 += q.A10; A20 += q.A20; A21 += q.A21;
+			B0 += q.B0; B1 += q.B1; B2 += q.B2;
+			C += q.C;
+			W += q.W;
+		}
+
+		float Error(const Vector3& p) const
+		{
+			float r = A00 * p.x * p.x + A11 * p.y * p.y + A22 * p.z * p.z
+				+ 2.0f * (A10 * p.y * p.x + A20 * p.z * p.x + A21 * p.z * p.y)
+				+ 2.0f * (B0 * p.x + B1 * p.y + B2 * p.z)
+				+ C;
+
+			return W > 0.0f ? fabsf(r) / W : 0.0f;
+		}
+	};
+
+	struct Collapse
+	{
+		uint32 From;
+		uint32 To;
+		// Squared distance in the normalized space.
+		float Error;
+	};
+
+	uint64 EdgeKey(uint32 a, uint32 b)
+	{
+		return ((uint64)a << 32) | b;
+	}
+
+	struct PositionKey
+	{
+		float x, y, z;
+
+		bool operator==(const PositionKey& rhs) const
+		{
+			return x == rhs.x && y == rhs.y && z == rhs.z;
+		}
+	};
+
+	struct PositionKeyHash
+	{
+		size_t operator()(const PositionKey& key) const
+		{
+			uint32 bits[3];
+			memcpy(bits, &key, sizeof(bits));
+			return (size_t)(bits[0] * 73856093u ^ bits[1] * 19349663u ^ bits[2] * 83492791u);
+		}
+	};
+
+	// Positions scaled into the unit cube, so the quadrics stay well conditioned
+	// whatever units the mesh is in.
+	struct NormalizedPositions
+	{
+		NormalizedPositions(const float* positions, size_t vertexCount, size_t positionByteStride)
+			:
+			Points(vertexCount)
+		{
+			Vector3 minimum = { FLT_MAX, FLT_MAX, FLT_MAX };
+			Vector3 maximum = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+			for (size_t i = 0; i < vertexCount; ++i)
+			{
+				const float* p = reinterpret_cast<const float*>(reinterpret_cast<const unsigned char*>(positions) + i * positionByteStride);
+				minimum = { std::min(minimum.x, p[0]), std::min(minimum.y, p[1]), std::min(minimum.z, p[2]) };
+				maximum = { std::max(maximum.x, p[0]), std::max(maximum.y, p[1]), std::max(maximum.z, p[2]) };
+			}
+
+			Vector3 size = vertexCount > 0 ? Subtract(maximum, minimum) : Vector3{ 0.0f, 0.0f, 0.0f };
+			Extent = std::max(size.x, std::max(size.y, size.z));
+			Radius = 0.5f * Length(size);
+
+			const float scale = Extent > 0.0f ? 1.0f / Extent : 0.0f;
+			for (size_t i = 0; i < vertexCount; ++i)
+			{
+				const float* p = reinterpret_cast<const float*>(reinterpret_cast<const unsigned char*>(positions) + i * positionByteStride);
+				Points[i] = { (p[0] - minimum.x) * scale, (p[1] - minimum.y) * scale, (p[2] - minimum.z) * scale };
+			}
+		}
+
+		std::vector<Vector3> Points;
+		// Largest side of the bounding box, the normalization scale.
+		float Extent = 0.0f;
+		// Half the diagonal of the bounding box, in mesh units.
+		float Radius = 0.0f;
+	};
+
+	class Simplifier
+	{
+	public:
+		Simplifier(const NormalizedPositions& positions, const std::vector<uint32>& indices)
+			:
+			mPoints(positions.Points),
+			mVertexCount(positions.Points.size())
+		{
+			BuildPositionRemap();
+			ClassifyVertices(indices);
+			BuildQuadrics(indices);
+		}
+
+		// Returns the largest collapse error, as a squared normalized distance.
+		float Run(std::vector<uint32>& indices, size_t targetTriCount, float errorLimit)
+		{
+			float resultError = 0.0f;
+
+			while (indices.size() / 3 > targetTriCount)
+			{
+				size_t collapsed = RunPass(indices, targetTriCount, errorLimit * errorLimit, resultError);
+				if (collapsed == 0)
+					break;
+			}
+
+			return resultError;
+		}
+
+	private:
+		void BuildPositionRemap()
+		{
+			mRemap.resize(mVertexCount);
+			mWedge.resize(mVertexCount);
+
+			std::unordered_map<PositionKey, uint32, PositionKeyHash> firstVertex;
+			firstVertex.reserve(mVertexCount);
+			for (uint32 v = 0; v < (uint32)mVertexCount; ++v)
+			{
+				// + 0.0f folds -0 into +0.
+				const Vector3& p = mPoints[v];
+				PositionKey key = { p.x + 0.0f, p.y + 0.0f, p.z + 0.0f };
+				auto it = firstVertex.insert(std::make_pair(key, v)).first;
+				mRemap[v] = it->second;
+
+				// Vertices at one position form a ring through mWedge.
+				if (it->second == v)
+				{
+					mWedge[v] = v;
+				}
+				else
+				{
+					mWedge[v] = mWedge[it->second];
+					mWedge[it->second] = v;
+				}
+			}
+		}
+
+		size_t WedgeCount(uint32 v) const
+		{
+			size_t count = 1;
+			for (uint32 w = mWedge[v]; w != v; w = mWedge[w])
+				count++;
+			return count;
+		}
+
+		void ClassifyVertices(const std::vector<uint32>& indices)
+		{
+			std::unordered_set<uint64> edges;
+			std::unordered_set<uint64> positionEdges;
+			edges.reserve(indices.size());
+			positionEdges.reserve(indices.size());
+			for (size_t t = 0; t + 2 < indices.size(); t += 3)
+			{
+				for (size_t e = 0; e < 3; ++e)
+				{
+					uint32 a = indices[t + e], b = indices[t + (e + 1) % 3];
+					edges.insert(EdgeKey(a, b));
+					positionEdges.insert(EdgeKey(mRemap[a], mRemap[b]));
+				}
+			}
+
+			// An edge without its reverse is open: on a border or on one side of a seam.
+			mOpenOut.assign(mVertexCount, InvalidIndex);
+			mOpenIn.assign(mVertexCount, InvalidIndex);
+			std::vector<bool> ambiguous(mVertexCount, false);
+			for (size_t t = 0; t + 2 < indices.size(); t += 3)
+			{
+				for (size_t e = 0; e < 3; ++e)
+				{
+					uint32 a = indices[t + e], b = indices[t + (e + 1) % 3];
+					if (edges.count(EdgeKey(b, a)))
+						continue;
+
+					if (mOpenOut[a] != InvalidIndex && mOpenOut[a] != b)
+						ambiguous[a] = true;
+					mOpenOut[a] = b;
+
+					if (mOpenIn[b] != InvalidIndex && mOpenIn[b] != a)
+						ambiguous[b] = true;
+					mOpenIn[b] = a;
+				}
+			}
+
+			mKind.assign(mVertexCount, VertexKind::Locked);
+			for (uint32 v = 0; v < (uint32)mVertexCount; ++v)
+			{
+				size_t wedges = WedgeCount(v);
+				bool hasOut = mOpenOut[v] != InvalidIndex;
+				bool hasIn = mOpenIn[v] != InvalidIndex;
+
+				if (!hasOut && !hasIn)
+				{
+					mKind[v] = wedges == 1 ? VertexKind::Manifold : VertexKind::Locked;
+					continue;
+				}
+
+				if (!hasOut || !hasIn || ambiguous[v])
+					continue;
+
+				bool borderOut = !positionEdges.count(EdgeKey(mRemap[mOpenOut[v]], mRemap[v]));
+				bool borderIn = !positionEdges.count(EdgeKey(mRemap[v], mRemap[mOpenIn[v]]));
+				if (wedges == 1 && borderOut && borderIn)
+					mKind[v] = VertexKind::Border;
+				else if (wedges == 2 && !borderOut && !borderIn)
+					mKind[v] = VertexKind::Seam;
+			}
+
+			// Both sides of a seam have to agree, or neither may move.
+			for (uint32 v = 0; v < (uint32)mVertexCount; ++v)
+			{
+				if (mKind[v] == VertexKind::Seam && mKind[mWedge[v]] != VertexKind::Seam)
+				{
+					mKind[v] = VertexKind::Locked;
+					mKind[mWedge[v]] = VertexKind::Locked;
+				}
+			}
+		}
+
+		void BuildQuadrics(const std::vector<uint32>& indices)
+		{
+			std::unordered_set<uint64> positionEdges;
+			positionEdges.reserve(indices.size());
+			for (size_t t = 0; t + 2 < indices.size(); t += 3)
+			{
+				for (size_t e = 0; e < 3; ++e)
+					positionEdges.insert(EdgeKey(mRemap[indices[t + e]], mRemap[indices[t + (e + 1) % 3]]));
+			}
+
+			mQuadrics.assign(mVertexCount, Quadric());
+			for (size_t t = 0; t + 2 < indices.size(); t += 3)
+			{
+				const Vector3& p0 = mPoints[indices[t + 0]];
+				const Vector3& p1 = mPoints[indices[t + 1]];
+				const Vector3& p2 = mPoints[indices[t + 2]];
+
+				Vector3 normal = Cross(Subtract(p1, p0), Subtract(p2, p0));
+				float length = Length(normal);
+				if (length == 0.0f)
+					continue;
+				normal = { normal.x / length, normal.y / length, normal.z / length };
+
+				// Weighted by area, so large triangles dominate small ones.
+				Quadric plane;
+				plane.AddPlane(normal, -Dot(normal, p0), 0.5f * length);
+				for (size_t k = 0; k < 3; ++k)
+					mQuadrics[mRemap[indices[t + k]]].Add(plane);
+
+				// Planes through the open borders, perpendicular to the triangle.
+				for (size_t e = 0; e < 3; ++e)
+				{
+					uint32 a = mRemap[indices[t + e]], b = mRemap[indices[t + (e + 1) % 3]];
+					if (positionEdges.count(EdgeKey(b, a)))
+						continue;
+
+					Vector3 edge = Subtract(mPoints[b], mPoints[a]);
+					float edgeLength = Length(edge);
+					Vector3 edgeNormal = Cross(edge, normal);
+					float edgeNormalLength = Length(edgeNormal);
+					if (edgeNormalLength == 0.0f)
+						continue;
+					edgeNormal = { edgeNormal.x / edgeNormalLength, edgeNormal.y / edgeNormalLength, edgeNormal.z / edgeNormalLength };
+
+					Quadric border;
+					border.AddPlane(edgeNormal, -Dot(edgeNormal, mPoints[a]), BorderWeight * edgeLength * edgeLength);
+					mQuadrics[a].Add(border);
+					mQuadrics[b].Add(border);
+				}
+			}
+		}
+
+		bool CanCollapse(uint32 from, uint32 to) const
+		{
+			switch (mKind[from])
+			{
+			case VertexKind::Manifold:
+				return true;
+			case VertexKind::Border:
+			case VertexKind::Seam:
+				return mOpenOut[from] == to || mOpenIn[from] == to;
+			default:
+				return false;
+			}
+		}
+
+		float CollapseError(uint32 from, uint32 to) const
+		{
+			Quadric q = mQuadrics[mRemap[from]];
+			q.Add(mQuadrics[mRemap[to]]);
+			return q.Error(mPoints[to]);
+		}
+
+		// The wedge of to that the twin of the seam vertex from collapses into.
+		uint32 SeamTwinTarget(uint32 from, uint32 to) const
+		{
+			uint32 twin = mWedge[from];
+			uint32 twinTo = mOpenOut[from] == to ? mOpenIn[twin] : mOpenOut[twin];
+			if (twinTo == InvalidIndex || mRemap[twinTo] != mRemap[to])
+				return InvalidIndex;
+			return twinTo;
+		}
+
+		void BuildTriangleAdjacency(const std::vector<uint32>& indices)
+		{
+			mTriangleOffsets.assign(mVertexCount + 1, 0);
+			for (uint32 v : indices)
+				mTriangleOffsets[v + 1]++;
+			for (size_t v = 0; v < mVertexCount; ++v)
+				mTriangleOffsets[v + 1] += mTriangleOffsets[v];
+
+			std::vector<uint32> fill(mTriangleOffsets.begin(), mTriangleOffsets.end() - 1);
+			mTriangles.resize(indices.size());
+			for (size_t i = 0; i < indices.size(); ++i)
+				mTriangles[fill[indices[i]]++] = (uint32)(i / 3);
+		}
+
+		// Checks the triangles around from for flipped normals once it moves to
+		// the position of to.  Returns the number of triangles that disappear,
+		// or -1 if a triangle would flip.
+		int CheckTriangles(const std::vector<uint32>& indices, uint32 from, uint32 to) const
+		{
+			int removed = 0;
+			for (uint32 i = mTriangleOffsets[from]; i < mTriangleOffsets[from + 1]; ++i)
+			{
+				const uint32* tri = &indices[mTriangles[i] * 3];
+				if (mRemap[tri[0]] == mRemap[to] || mRemap[tri[1]] == mRemap[to] || mRemap[tri[2]] == mRemap[to])
+				{
+					removed++;
+					continue;
+				}
+
+				Vector3 p[3], q[3];
+				for (size_t k = 0; k < 3; ++k)
+				{
+					p[k] = mPoints[tri[k]];
+					q[k] = tri[k] == from ? mPoints[to] : p[k];
+				}
+
+				Vector3 before = Cross(Subtract(p[1], p[0]), Subtract(p[2], p[0]));
+				Vector3 after = Cross(Subtract(q[1], q[0]), Subtract(q[2], q[0]));
+				if (Dot(before, after) <= 0.0f)
+					return -1;
+			}
+
+			return removed;
+		}
+
+		void LockNeighbours(const std::vector<uint32>& indices, uint32 v, std::vector<bool>& locked) const
+		{
+			for (uint32 i = mTriangleOffsets[v]; i < mTriangleOffsets[v + 1]; ++i)
+			{
+				const uint32* tri = &indices[mTriangles[i] * 3];
+				for (size_t k = 0; k < 3; ++k)
+					locked[mRemap[tri[k]]] = true;
+			}
+		}
+
+		size_t RunPass(std::vector<uint32>& indices, size_t targetTriCount, float errorLimitSq, float& resultError)
+		{
+			std::vector<Collapse> collapses;
+			collapses.reserve(indices.size());
+			for (size_t t = 0; t + 2 < indices.size(); t += 3)
+			{
+				for (size_t e = 0; e < 3; ++e)
+				{
+					uint32 a = indices[t + e], b = indices[t + (e + 1) % 3];
+
+					// Interior edges show up once per triangle, keep one of them.
+					if (mKind[a] == VertexKind::Manifold && mKind[b] == VertexKind::Manifold && a > b)
+						continue;
+
+					float errorAB = CanCollapse(a, b) ? CollapseError(a, b) : FLT_MAX;
+					float errorBA = CanCollapse(b, a) ? CollapseError(b, a) : FLT_MAX;
+					if (errorAB == FLT_MAX && errorBA == FLT_MAX)
+						continue;
+
+					if (errorAB <= errorBA)
+						collapses.push_back({ a, b, errorAB });
+					else
+						collapses.push_back({ b, a, errorBA });
+				}
+			}
+
+			std::sort(collapses.begin(), collapses.end(),
+				[](const Collapse& lhs, const Collapse& rhs) { return lhs.Error < rhs.Error; });
+
+			BuildTriangleAdjacency(indices);
+
+			std::vector<uint32> collapseRemap(mVertexCount);
+			for (uint32 v = 0; v < (uint32)mVertexCount; ++v)
+				collapseRemap[v] = v;
+
+			// Only one collapse per neighbourhood and pass, so the flip checks
+			// above see the positions the collapse will really have.
+			std::vector<bool> locked(mVertexCount, false);
+
+			size_t triCount = indices.size() / 3;
+			size_t collapsed = 0;
+			for (const Collapse& collapse : collapses)
+			{
+				if (collapse.Error > errorLimitSq || triCount <= targetTriCount)
+					break;
+
+				uint32 from = collapse.From, to = collapse.To;
+				if (locked[mRemap[from]] || locked[mRemap[to]])
+					continue;
+
+				uint32 twin = InvalidIndex, twinTo = InvalidIndex;
+				if (mKind[from] == VertexKind::Seam)
+				{
+					twin = mWedge[from];
+					twinTo = SeamTwinTarget(from, to);
+					if (twinTo == InvalidIndex)
+						continue;
+				}
+
+				int removed = CheckTriangles(indices, from, to);
+				if (removed < 0)
+					continue;
+				if (twin != InvalidIndex)
+				{
+					int twinRemoved = CheckTriangles(indices, twin, twinTo);
+					if (twinRemoved < 0)
+						continue;
+					removed += twinRemoved;
+				}
+
+				collapseRemap[from] = to;
+				LockNeighbours(indices, from, locked);
+				if (twin != InvalidIndex)
+				{
+					collapseRemap[twin] = twinTo;
+					LockNeighbours(indices, twin, locked);
+				}
+
+				mQuadrics[mRemap[to]].Add(mQuadrics[mRemap[from]]);
+
+				resultError = std::max(resultError, collapse.Error);
+				triCount -= std::min<size_t>(triCount, removed);
+				collapsed++;
+			}
+
+			if (collapsed == 0)
+				return 0;
+
+			// Rewrite the triangles and drop the ones that collapsed.
+			size_t write = 0;
+			for (size_t t = 0; t + 2 < indices.size(); t += 3)
+			{
+				uint32 a = collapseRemap[indices[t + 0]];
+				uint32 b = collapseRemap[indices[t + 1]];
+				uint32 c = collapseRemap[indices[t + 2]];
+				if (mRemap[a] == mRemap[b] || mRemap[b] == mRemap[c] || mRemap[c] == mRemap[a])
+					continue;
+
+				indices[write++] = a;
+				indices[write++] = b;
+				indices[write++] = c;
+			}
+			indices.resize(write);
+
+			// Keep the border and seam loops pointing at vertices that still exist.
+			// When the neighbour collapsed into v itself, skip over it.
+			for (uint32 v = 0; v < (uint32)mVertexCount; ++v)
+			{
+				if (mOpenOut[v] != InvalidIndex)
+				{
+					uint32 next = mOpenOut[v];
+					uint32 target = collapseRemap[next];
+					mOpenOut[v] = target == v ? mOpenOut[next] : target;
+				}
+				if (mOpenIn[v] != InvalidIndex)
+				{
+					uint32 prev = mOpenIn[v];
+					uint32 target = collapseRemap[prev];
+					mOpenIn[v] = target == v ? mOpenIn[prev] : target;
+				}
+			}
+
+			return collapsed;
+		}
+
+		const std::vector<Vector3>& mPoints;
+		size_t mVertexCount = 0;
+
+		// First vertex with the same position, and the ring of those vertices.
+		std::vector<uint32> mRemap;
+		std::vector<uint32> mWedge;
+
+		std::vector<VertexKind> mKind;
+		// Neighbours along the open edge leaving and entering each vertex.
+		std::vector<uint32> mOpenOut;
+		std::vector<uint32> mOpenIn;
+
+		// Indexed by mRemap, shared by all vertices at one position.
+		std::vector<Quadric> mQuadrics;
+
+		// Triangles around each vertex, rebuilt every pass.
+		std::vector<uint32> mTriangleOffsets;
+		std::vector<uint32> mTriangles;
+	};
+}
+
+float MeshSimplifier::Simplify(std::vector<uint32>& indices, const float* positions, size_t vertexCount, size_t positionByteStride,
+	size_t targetIndexCount, float targetError)
+{
+	NormalizedPositions normalized(positions, vertexCount, positionByteStride);
+	if (normalized.Extent == 0.0f)
+		return 0.0f;
+
+	Simplifier simplifier(normalized, indices);
+	const float errorLimit = targetError * normalized.Radius / normalized.Extent;
+	float error = simplifier.Run(indices, targetIndexCount / 3, errorLimit);
+
+	return sqrtf(error) * normalized.Extent;
+}
+
+std::vector<MeshSimplifier::LodLevel> MeshSimplifier::BuildLodChain(const std::vector<uint32>& indices, const float* positions,
+	size_t vertexCount, size_t positionByteStride, size_t maxLodCount, float reduction, float maxError)
+{
+	std::vector<LodLevel> lods(1);
+	lods[0].Indices = indices;
+
+	NormalizedPositions normalized(positions, vertexCount, positionByteStride);
+	if (normalized.Radius == 0.0f)
+		return lods;
+
+	for (size_t lod = 1; lod < maxLodCount; ++lod)
+	{
+		const LodLevel& previous = lods.back();
+
+		// Every level starts from the previous one, so its error adds to the
+		// errors before it.  Only the remaining budget is left for this level.
+		float remainingError = maxError - previous.Error / normalized.Radius;
+		if (remainingError <= 0.0f)
+			break;
+
+		LodLevel level;
+		level.Indices = previous.Indices;
+		size_t targetIndexCount = (size_t)(previous.Indices.size() / 3 * reduction) * 3;
+		level.Error = previous.Error + Simplify(level.Indices, positions, vertexCount, positionByteStride, targetIndexCount, remainingError);
+
+		// Not worth another draw for less than 10% fewer triangles.
+		if (level.Indices.empty() || level.Indices.size() * 10 > previous.Indices.size() * 9)
+			break;
+
+		lods.push_back(std::move(level));
+	}
+
+	return lods;
+}
+
+std::string MeshSimplifier::ToString(const std::string& name, const std::vector<LodLevel>& lods)
+{
+	std::string result = "[MeshSimplifier] " + name + ":";
+	for (size_t lod = 0; lod < lods.size(); ++lod)
+	{
+		char buffer[128];
+		snprintf(buffer, sizeof(buffer), "%s LOD%zu %zu triangles (error %.4f)",
+			lod == 0 ? "" : ",", lod, lods[lod].Indices.size() / 3, lods[lod].Error);
+		result += buffer;
+	}
+	result += "\n";
+
+	return result;
+}
\ No newline at end of file
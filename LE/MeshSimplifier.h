@@ -0,0 +1,60 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Quadric error mesh simplification (Garland and Heckbert, "Surface
+// Simplification Using Quadric Error Metrics") with the vertex placement
+// restricted to the edge end points, so the attributes of the remaining
+// vertices are never interpolated.  Like MeshOptimizer it only works on CPU
+// data and can be used by tools as well as at load time.
+//
+// Vertices that share a position but not their attributes (UV or normal
+// seams) are only collapsed along the seam, together with their twin on the
+// other side, and open borders only along the border, so seams stay closed
+// and silhouettes of open meshes keep their shape.
+class MeshSimplifier
+{
+public:
+	using uint32 = std::uint32_t;
+
+	struct LodLevel
+	{
+		std::vector<uint32> Indices;
+		// Geometric error in the units of the mesh, 0 for the full detail level.
+		float Error = 0.0f;
+	};
+
+	///<summary>
+	/// Collapses edges of an indexed triangle list until it is down to
+	/// targetIndexCount indices or the next collapse would move the surface
+	/// by more than targetError times the radius of the mesh.  indices
+	/// keeps pointing into the original vertices.  Returns the error of the
+	/// result in the units of the mesh.  positions points at the first vertex
+	/// position (3 floats) and positionByteStride is the vertex stride.
+	///</summary>
+	static float Simplify(std::vector<uint32>& indices, const float* positions, size_t vertexCount, size_t positionByteStride,
+		size_t targetIndexCount, float targetError);
+
+	///<summary>
+	/// Builds up to maxLodCount levels, level 0 being the input.  Every level
+	/// aims for reduction times the triangles of the previous one, the chain
+	/// stops early when a level would exceed maxError (relative to the mesh
+	/// radius) or barely removes anything.
+	///</summary>
+	static std::vector<LodLevel> BuildLodChain(const std::vector<uint32>& indices, const float* positions, size_t vertexCount,
+		size_t positionByteStride, size_t maxLodCount, float reduction, float maxError);
+
+	///<summary>
+	/// Typed convenience wrapper for any of the PrimitiveTypes vertex layouts.
+	///</summary>
+	template<typename TVertex>
+	static std::vector<LodLevel> BuildLodChain(const std::vector<uint32>& indices, const std::vector<TVertex>& vertices,
+		size_t maxLodCount, float reduction, float maxError)
+	{
+		return BuildLodChain(indices, &vertices[0].Position.x, vertices.size(), sizeof(TVertex), maxLodCount, reduction, maxError);
+	}
+
+	static std::string ToString(const std::string& name, const std::vector<LodLevel>& lods);
+};
\ No newline at end of file
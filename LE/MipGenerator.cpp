@@ -0,0 +1,500 @@
+#include "MipGenerator.h"
+#include "WorkerPool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define MIPGENERATOR_SSE2 1
+#endif
+
+namespace
+{
+	using uint8 = std::uint8_t;
+	using uint32 = std::uint32_t;
+
+	// Destination rows filtered by one job of ParallelFor.
+	const uint32 RowsPerJob = 16;
+
+	struct Layout
+	{
+		uint32 Channels;
+		bool Srgb;
+	};
+
+	// Linear values are looked up with this many bits when encoded to sRGB.
+	const uint32 EncodeBits = 14;
+
+	struct SrgbTables
+	{
+		float Decode[256];
+		uint8 Encode[1 << EncodeBits];
+
+		SrgbTables()
+		{
+			for (uint32 i = 0; i < 256; ++i)
+			{
+				const double c = i / 255.0;
+				Decode[i] = (float)(c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4));
+			}
+			for (uint32 i = 0; i < (1u << EncodeBits); ++i)
+			{
+				const double l = (double)i / ((1u << EncodeBits) - 1);
+				const double c = l <= 0.0031308 ? l * 12.92 : 1.055 * std::pow(l, 1.0 / 2.4) - 0.055;
+				Encode[i] = (uint8)(c * 255.0 + 0.5);
+			}
+		}
+	};
+
+	const SrgbTables& GetSrgbTables()
+	{
+		static const SrgbTables tables;
+		return tables;
+	}
+
+	uint8 EncodeSrgb(const SrgbTables& tables, float linear)
+	{
+		const float clamped = linear < 0.0f ? 0.0f : linear > 1.0f ? 1.0f : linear;
+		return tables.Encode[(uint32)(clamped * ((1u << EncodeBits) - 1) + 0.5f)];
+	}
+
+	uint8 EncodeUnorm(float value)
+	{
+		const float clamped = value < 0.0f ? 0.0f : value > 1.0f ? 1.0f : value;
+		return (uint8)(clamped * 255.0f + 0.5f);
+	}
+
+	// A row of 8-bit texels as linear RGBA floats.  R8 fills G and B with 0
+	// and A with 1, so every row is filtered the same way.
+	void LoadRow(const uint8* src, uint32 width, const Layout& layout, float* out)
+	{
+		if (layout.Channels == 1)
+		{
+			for (uint32 x = 0; x < width; ++x, out += 4)
+			{
+				out[0] = src[x] * (1.0f / 255.0f);
+				out[1] = 0.0f;
+				out[2] = 0.0f;
+				out[3] = 1.0f;
+			}
+			return;
+		}
+
+		if (layout.Srgb)
+		{
+			const SrgbTables& tables = GetSrgbTables();
+			for (uint32 x = 0; x < width; ++x, src += 4, out += 4)
+			{
+				out[0] = tables.Decode[src[0]];
+				out[1] = tables.Decode[src[1]];
+				out[2] = tables.Decode[src[2]];
+				out[3] = src[3] * (1.0f / 255.0f);
+			}
+			return;
+		}
+
+		uint32 x = 0;
+#ifdef MIPGENERATOR_SSE2
+		const __m128i zero = _mm_setzero_si128();
+		const __m128 scale = _mm_set1_ps(1.0f / 255.0f);
+		for (; x + 4 <= width; x += 4)
+		{
+			const __m128i texels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x * 4));
+			const __m128i lo = _mm_unpacklo_epi8(texels, zero);
+			const __m128i hi = _mm_unpackhi_epi8(texels, zero);
+			_mm_storeu_ps(out + x * 4 + 0, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), scale));
+			_mm_storeu_ps(out + x * 4 + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), scale));
+			_mm_storeu_ps(out + x * 4 + 8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), scale));
+			_mm_storeu_ps(out + x * 4 + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), scale));
+		}
+#endif
+		// The texels the loop above left, a component at a time.
+		for (x *= 4; x < width * 4; ++x)
+			out[x] = src[x] * (1.0f / 255.0f);
+	}
+
+	void StoreRow(const float* in, uint32 width, const Layout& layout, uint8* dst)
+	{
+		if (layout.Channels == 1)
+		{
+			for (uint32 x = 0; x < width; ++x)
+				dst[x] = EncodeUnorm(in[x * 4]);
+			return;
+		}
+
+		if (layout.Srgb)
+		{
+			const SrgbTables& tables = GetSrgbTables();
+			for (uint32 x = 0; x < width; ++x, in += 4, dst += 4)
+			{
+				dst[0] = EncodeSrgb(tables, in[0]);
+				dst[1] = EncodeSrgb(tables, in[1]);
+				dst[2] = EncodeSrgb(tables, in[2]);
+				dst[3] = EncodeUnorm(in[3]);
+			}
+			return;
+		}
+
+		uint32 x = 0;
+#ifdef MIPGENERATOR_SSE2
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 scale = _mm_set1_ps(255.0f);
+		const __m128 half = _mm_set1_ps(0.5f);
+		auto convert = [&](const float* p)
+		{
+			const __m128 clamped = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(p), zero), one);
+			// Truncating after adding a half rounds like EncodeUnorm.
+			return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(clamped, scale), half));
+		};
+		for (; x + 4 <= width; x += 4)
+		{
+			const __m128i lo = _mm_packs_epi32(convert(in + x * 4 + 0), convert(in + x * 4 + 4));
+			const __m128i hi = _mm_packs_epi32(convert(in + x * 4 + 8), convert(in + x * 4 + 12));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 4), _mm_packus_epi16(lo, hi));
+		}
+#endif
+		// The texels the loop above left, a component at a time.
+		for (x *= 4; x < width * 4; ++x)
+			dst[x] = EncodeUnorm(in[x]);
+	}
+
+	double Sinc(double x)
+	{
+		const double Pi = 3.14159265358979323846;
+		return std::abs(x) < 1e-6 ? 1.0 : std::sin(Pi * x) / (Pi * x);
+	}
+
+	// Modified Bessel function of the first kind, order 0.
+	double Bessel0(double x)
+	{
+		double sum = 1.0;
+		double term = 1.0;
+		for (int k = 1; k < 32; ++k)
+		{
+			term *= (x / (2.0 * k)) * (x / (2.0 * k));
+			sum += term;
+			if (term < sum * 1e-12)
+				break;
+		}
+		return sum;
+	}
+
+	const double KernelRadius = 3.0;
+	const double KaiserAlpha = 4.0;
+
+	// Windowed sinc at x destination texels from the center.
+	double KernelWeight(MipGenerator::Filter filter, double x)
+	{
+		if (std::abs(x) >= KernelRadius)
+			return 0.0;
+		if (filter == MipGenerator::Filter::Lanczos)
+			return Sinc(x) * Sinc(x / KernelRadius);
+		const double t = x / KernelRadius;
+		return Sinc(x) * Bessel0(KaiserAlpha * std::sqrt(1.0 - t * t)) / Bessel0(KaiserAlpha);
+	}
+
+	// The source texels (clamped to the edge) and normalized weights of every
+	// destination texel of a 1D resampling, Count per texel.
+	struct Taps
+	{
+		uint32 Count = 0;
+		std::vector<uint32> Index;
+		std::vector<float> Weight;
+	};
+
+	Taps MakeTaps(uint32 srcSize, uint32 dstSize, MipGenerator::Filter filter)
+	{
+		const double scale = (double)srcSize / dstSize;
+		const double support = filter == MipGenerator::Filter::Box ? 0.5 * scale : KernelRadius * scale;
+
+		Taps taps;
+		taps.Count = (uint32)std::ceil(2.0 * support) + 1;
+		taps.Index.resize((size_t)dstSize * taps.Count);
+		taps.Weight.resize((size_t)dstSize * taps.Count);
+
+		std::vector<double> weights(taps.Count);
+		uint32 used = 0;
+		for (uint32 x = 0; x < dstSize; ++x)
+		{
+			const double center = (x + 0.5) * scale;
+			const int first = (int)std::floor(center - support);
+
+			double sum = 0.0;
+			for (uint32 k = 0; k < taps.Count; ++k)
+			{
+				const int i = first + (int)k;
+				double weight;
+				if (filter == MipGenerator::Filter::Box)
+					weight = std::max(0.0, std::min(center + support, i + 1.0) - std::max(center - support, (double)i));
+				else
+					weight = KernelWeight(filter, (i + 0.5 - center) / scale);
+				weights[k] = weight;
+				sum += weight;
+			}
+
+			for (uint32 k = 0; k < taps.Count; ++k)
+			{
+				const int i = std::min(std::max(first + (int)k, 0), (int)srcSize - 1);
+				taps.Index[x * taps.Count + k] = (uint32)i;
+				taps.Weight[x * taps.Count + k] = (float)(weights[k] / sum);
+				if (weights[k] != 0.0)
+					used = std::max(used, k + 1);
+			}
+		}
+
+		// The last tap is often 0 for every texel, a box of 2 texels for one.
+		if (used < taps.Count)
+		{
+			for (uint32 x = 0; x < dstSize; ++x)
+			{
+				for (uint32 k = 0; k < used; ++k)
+				{
+					taps.Index[x * used + k] = taps.Index[x * taps.Count + k];
+					taps.Weight[x * used + k] = taps.Weight[x * taps.Count + k];
+				}
+			}
+			taps.Count = used;
+		}
+		return taps;
+	}
+
+	// out[x] = sum of weight * in[index] over the taps of x, RGBA floats.
+	void FilterRow(const float* in, const Taps& taps, uint32 width, float* out)
+	{
+		for (uint32 x = 0; x < width; ++x, out += 4)
+		{
+			const uint32* index = taps.Index.data() + x * taps.Count;
+			const float* weight = taps.Weight.data() + x * taps.Count;
+#ifdef MIPGENERATOR_SSE2
+			__m128 sum = _mm_setzero_ps();
+			for (uint32 k = 0; k < taps.Count; ++k)
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weight[k]), _mm_loadu_ps(in + index[k] * 4)));
+			_mm_storeu_ps(out, sum);
+#else
+			float sum[4] = {};
+			for (uint32 k = 0; k < taps.Count; ++k)
+			{
+				for (uint32 c = 0; c < 4; ++c)
+					sum[c] += weight[k] * in[index[k] * 4 + c];
+			}
+			memcpy(out, sum, sizeof(sum));
+#endif
+		}
+	}
+
+	// sum += weight * row, over count floats.
+	void AccumulateRow(float* sum, const float* row, float weight, uint32 count)
+	{
+		uint32 i = 0;
+#ifdef MIPGENERATOR_SSE2
+		const __m128 w = _mm_set1_ps(weight);
+		for (; i + 4 <= count; i += 4)
+			_mm_storeu_ps(sum + i, _mm_add_ps(_mm_loadu_ps(sum + i), _mm_mul_ps(w, _mm_loadu_ps(row + i))));
+#endif
+		for (; i < count; ++i)
+			sum[i] += weight * row[i];
+	}
+
+	void Downsample(
+		const MipGenerator::Surface& src, uint32 srcWidth, uint32 srcHeight,
+		const MipGenerator::Surface& dst, uint32 dstWidth, uint32 dstHeight,
+		const Layout& layout, MipGenerator::Filter filter, uint32 threadCount)
+	{
+		const Taps horizontal = MakeTaps(srcWidth, dstWidth, filter);
+		const Taps vertical = MakeTaps(srcHeight, dstHeight, filter);
+
+		WorkerPool::ParallelFor((dstHeight + RowsPerJob - 1) / RowsPerJob, threadCount, [&](uint32 job)
+		{
+			const uint32 rowBegin = job * RowsPerJob;
+			const uint32 rowEnd = std::min(dstHeight, rowBegin + RowsPerJob);
+			const auto tapsBegin = vertical.Index.begin() + rowBegin * vertical.Count;
+			const auto tapsEnd = vertical.Index.begin() + rowEnd * vertical.Count;
+			const uint32 firstRow = *std::min_element(tapsBegin, tapsEnd);
+			const uint32 lastRow = *std::max_element(tapsBegin, tapsEnd);
+
+			// Every source row the tile reads is filtered horizontally once.
+			std::vector<float> line((size_t)srcWidth * 4);
+			std::vector<float> filtered((size_t)(lastRow - firstRow + 1) * dstWidth * 4);
+			for (uint32 row = firstRow; row <= lastRow; ++row)
+			{
+				LoadRow(static_cast<const uint8*>(src.Data) + row * src.RowPitch, srcWidth, layout, line.data());
+				FilterRow(line.data(), horizontal, dstWidth, filtered.data() + (size_t)(row - firstRow) * dstWidth * 4);
+			}
+
+			std::vector<float> sum((size_t)dstWidth * 4);
+			for (uint32 y = rowBegin; y < rowEnd; ++y)
+			{
+				std::fill(sum.begin(), sum.end(), 0.0f);
+				for (uint32 k = 0; k < vertical.Count; ++k)
+				{
+					const uint32 row = vertical.Index[y * vertical.Count + k];
+					AccumulateRow(sum.data(), filtered.data() + (size_t)(row - firstRow) * dstWidth * 4,
+						vertical.Weight[y * vertical.Count + k], dstWidth * 4);
+				}
+				StoreRow(sum.data(), dstWidth, layout, static_cast<uint8*>(const_cast<void*>(dst.Data)) + y * dst.RowPitch);
+			}
+		});
+	}
+
+	void AlphaHistogram(const MipGenerator::Surface& level, uint32 width, uint32 height, uint32 histogram[256])
+	{
+		std::fill(histogram, histogram + 256, 0u);
+		for (uint32 y = 0; y < height; ++y)
+		{
+			const uint8* row = static_cast<const uint8*>(level.Data) + y * level.RowPitch;
+			for (uint32 x = 0; x < width; ++x)
+				histogram[row[x * 4 + 3]]++;
+		}
+	}
+
+	// Share of the texels that pass the alpha test once alpha is scaled.
+	double Coverage(const uint32 histogram[256], double scale, double reference)
+	{
+		uint64_t passed = 0;
+		uint64_t total = 0;
+		for (uint32 a = 0; a < 256; ++a)
+		{
+			total += histogram[a];
+			if (std::min(255.0, std::floor(a * scale + 0.5)) / 255.0 > reference)
+				passed += histogram[a];
+		}
+		return total ? (double)passed / total : 0.0;
+	}
+
+	// Scales the alpha of level so that coverage of the texels pass the test.
+	void PreserveCoverage(const MipGenerator::Surface& level, uint32 width, uint32 height,
+		double coverage, double reference, uint32 threadCount)
+	{
+		uint32 histogram[256];
+		AlphaHistogram(level, width, height, histogram);
+
+		// Coverage only grows with the scale.
+		double low = 0.0;
+		double high = 4.0;
+		for (int i = 0; i < 16; ++i)
+		{
+			const double middle = 0.5 * (low + high);
+			if (Coverage(histogram, middle, reference) < coverage)
+				low = middle;
+			else
+				high = middle;
+		}
+		const double scale = high;
+
+		uint8 table[256];
+		for (uint32 a = 0; a < 256; ++a)
+			table[a] = (uint8)std::min(255.0, std::floor(a * scale + 0.5));
+
+		WorkerPool::ParallelFor((height + RowsPerJob - 1) / RowsPerJob, threadCount, [&](uint32 job)
+		{
+			for (uint32 y = job * RowsPerJob; y < std::min(height, (job + 1) * RowsPerJob); ++y)
+			{
+				uint8* row = static_cast<uint8*>(const_cast<void*>(level.Data)) + y * level.RowPitch;
+				for (uint32 x = 0; x < width; ++x)
+					row[x * 4 + 3] = table[row[x * 4 + 3]];
+			}
+		});
+	}
+}
+
+bool MipGenerator::IsSupported(Format format)
+{
+	switch (format)
+	{
+	case Format::R8G8B8A8_UNORM:
+	case Format::R8G8B8A8_UNORM_SRGB:
+	case Format::B8G8R8A8_UNORM:
+	case Format::B8G8R8A8_UNORM_SRGB:
+	case Format::R8_UNORM:
+		return true;
+	default:
+		return false;
+	}
+}
+
+MipGenerator::uint32 MipGenerator::GetMipCount(uint32 width, uint32 height)
+{
+	uint32 count = 1;
+	for (uint32 size = std::max(width, height); size > 1; size >>= 1)
+		++count;
+	return count;
+}
+
+bool MipGenerator::Generate(
+	Format format,
+	uint32 width,
+	uint32 height,
+	std::vector<Surface>& surfaces,
+	std::vector<uint8_t>& storage,
+	const Options& options)
+{
+	const uint32 mipCount = GetMipCount(width, height);
+	if (!IsSupported(format) || mipCount == 1 || surfaces.empty())
+		return false;
+
+	Layout layout;
+	layout.Channels = format == Format::R8_UNORM ? 1 : 4;
+	layout.Srgb = format == Format::R8G8B8A8_UNORM_SRGB || format == Format::B8G8R8A8_UNORM_SRGB;
+	const bool coverage = options.AlphaReference > 0.0f && layout.Channels == 4;
+
+	// Lay the new levels out first so the pointers into storage stay valid.
+	const uint32 sliceCount = (uint32)surfaces.size();
+	std::vector<Surface> chain((size_t)sliceCount * mipCount);
+	std::vector<size_t> offsets(chain.size());
+	size_t byteSize = 0;
+	for (uint32 slice = 0; slice < sliceCount; ++slice)
+	{
+		for (uint32 mip = 1; mip < mipCount; ++mip)
+		{
+			const size_t rowPitch = (size_t)std::max(1u, width >> mip) * layout.Channels;
+			const size_t slicePitch = rowPitch * std::max(1u, height >> mip);
+			Surface& level = chain[slice * mipCount + mip];
+			level.RowPitch = rowPitch;
+			level.SlicePitch = slicePitch;
+			offsets[slice * mipCount + mip] = byteSize;
+			byteSize += slicePitch;
+		}
+		chain[slice * mipCount] = surfaces[slice];
+	}
+	storage.resize(byteSize);
+	for (uint32 slice = 0; slice < sliceCount; ++slice)
+	{
+		for (uint32 mip = 1; mip < mipCount; ++mip)
+			chain[slice * mipCount + mip].Data = storage.data() + offsets[slice * mipCount + mip];
+	}
+
+	const uint32 threadCount = options.ThreadCount ? options.ThreadCount : std::max(1u, std::thread::hardware_concurrency());
+	const uint32 threadsPerSlice = std::max(1u, threadCount / sliceCount);
+
+	// Levels depend on the one above, slices do not depend on each other.
+	WorkerPool::ParallelFor(sliceCount, threadCount, [&](uint32 slice)
+	{
+		const Surface* levels = chain.data() + slice * mipCount;
+
+		double topCoverage = 0.0;
+		if (coverage)
+		{
+			uint32 histogram[256];
+			AlphaHistogram(levels[0], width, height, histogram);
+			topCoverage = Coverage(histogram, 1.0, options.AlphaReference);
+		}
+
+		for (uint32 mip = 1; mip < mipCount; ++mip)
+		{
+			const uint32 srcWidth = std::max(1u, width >> (mip - 1));
+			const uint32 srcHeight = std::max(1u, height >> (mip - 1));
+			const uint32 dstWidth = std::max(1u, width >> mip);
+			const uint32 dstHeight = std::max(1u, height >> mip);
+			Downsample(levels[mip - 1], srcWidth, srcHeight, levels[mip], dstWidth, dstHeight, layout, options.Kernel, threadsPerSlice);
+			if (coverage)
+				PreserveCoverage(levels[mip], dstWidth, dstHeight, topCoverage, options.AlphaReference, threadsPerSlice);
+		}
+	});
+
+	surfaces.swap(chain);
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,68 @@
+#pragma once
+#include "DdsFile.h"
+#include <cstdint>
+#include <vector>
+
+// Builds the mip chain of an uncompressed 8-bit texture on the CPU, for
+// images that come without one (PNG, JPEG, single level DDS).
+//
+// Every level is filtered from the one above it with a separable kernel.
+// sRGB formats are averaged in linear light and encoded again, so dark and
+// bright texels keep their weight.  With an alpha reference the alpha of
+// every level is scaled until as many texels pass the alpha test as in the
+// top level, which keeps alpha tested foliage from thinning out in the
+// distance.  Tiles of rows of a level are filtered on several threads with
+// SSE2, array slices in parallel.
+//
+// Formats and levels are DdsFile's, D3D12Util converts them to D3D12.
+class MipGenerator
+{
+public:
+	using uint32 = std::uint32_t;
+	using Format = DdsFile::Format;
+	using Surface = DdsFile::Surface;
+
+	enum class Filter
+	{
+		// 2x2 average (area weighted for odd sizes).
+		Box,
+		// Kaiser windowed sinc, radius 3, alpha 4.
+		Kaiser,
+		// Lanczos, radius 3.
+		Lanczos,
+	};
+
+	struct Options
+	{
+		Filter Kernel = Filter::Kaiser;
+		// Alpha test reference (what the shader clips against), 0 leaves
+		// the alpha coverage alone.
+		float AlphaReference = 0.0f;
+		// 0 uses one thread per hardware thread.
+		uint32 ThreadCount = 0;
+	};
+
+	///<summary>
+	/// R8G8B8A8, B8G8R8A8 (UNORM and UNORM_SRGB) and R8_UNORM.
+	///</summary>
+	static bool IsSupported(Format format);
+
+	///<summary>
+	/// Levels of a full chain down to 1x1.
+	///</summary>
+	static uint32 GetMipCount(uint32 width, uint32 height);
+
+	///<summary>
+	/// surfaces holds the top level of every array slice.  On success it
+	/// holds the whole chain in D3D12 subresource order instead, the new
+	/// levels tightly packed in storage.  Returns false for formats that are
+	/// not supported and for textures that are 1x1 already.
+	///</summary>
+	static bool Generate(
+		Format format,
+		uint32 width,
+		uint32 height,
+		std::vector<Surface>& surfaces,
+		std::vector<uint8_t>& storage,
+		const Options& options);
+};
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 #include <vector>
 #include <DirectXMath.h>
+#include <DirectXPackedVector.h>
 
 class PrimitiveTypes
 {
@@ -191,6 +192,37 @@ public:
 		DirectX::XMFLOAT4 Color;
 	};
 
+	// Compact counterpart of PosTexNorColVertex, 20 bytes instead of 48.
+	// Position is unorm16 inside the mesh bounds and has to be scaled back with
+	// the per-mesh dequantization (see VertexQuantizer), Normal is octahedral.
+	struct QuantPosTexNorColVertex
+	{
+		DirectX::PackedVector::XMUSHORTN4 Position;
+		DirectX::PackedVector::XMHALF2 TexCoord;
+		DirectX::PackedVector::XMSHORTN2 Normal;
+		DirectX::PackedVector::XMUBYTEN4 Color;
+	};
+
+	// Same as QuantPosTexNorColVertex with half float positions, which need no
+	// dequantization but lose precision far away from the origin.
+	struct HalfPosTexNorColVertex
+	{
+		DirectX::PackedVector::XMHALF4 Position;
+		DirectX::PackedVector::XMHALF2 TexCoord;
+		DirectX::PackedVector::XMSHORTN2 Normal;
+		DirectX::PackedVector::XMUBYTEN4 Color;
+	};
+
+	// Compact counterpart of PosNorTanTexColVertex, 24 bytes instead of 60.
+	struct QuantPosNorTanTexColVertex
+	{
+		DirectX::PackedVector::XMUSHORTN4 Position;
+		DirectX::PackedVector::XMSHORTN2 Normal;
+		DirectX::PackedVector::XMSHORTN2 TangentU;
+		DirectX::PackedVector::XMHALF2 TexCoord;
+		DirectX::PackedVector::XMUBYTEN4 Color;
+	};
+
 	struct MeshData
 	{
 		std::vector<Vertex> Vertices;
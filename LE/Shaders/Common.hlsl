@@ -44,6 +44,20 @@ SamplerState gsamAnisotropicWrap  : register(s0);
 SamplerState gsamAnisotropicClamp  : register(s0);
 SamplerComparisonState gsamShadow : register(s6);
 
+// Decoders for the quantized vertex formats written by VertexQuantizer.
+float3 DequantizePosition(float3 posQ, float3 scale, float3 offset)
+{
+    return posQ * scale + offset;
+}
+
+float3 DecodeOctahedral(float2 e)
+{
+    float3 v = float3(e.xy, 1.0f - abs(e.x) - abs(e.y));
+    float t = saturate(-v.z);
+    v.xy += (v.xy >= 0.0f) ? -t : t;
+    return normalize(v);
+}
+
 float CalcShadowFactor(Texture2D shadowMap, SamplerComparisonState samShadow, float4 shadowPosH)
 {
     shadowPosH.xyz /= shadowPosH.w;
@@ -0,0 +1,200 @@
+#include "TaskGraph.h"
+#include <algorithm>
+#include <cassert>
+#include <condition_variable>
+#include <cstdio>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+TaskGraph::TaskId TaskGraph::Add(const std::string& name, std::function<void()> work, const std::vector<TaskId>& dependencies)
+{
+	const TaskId id = (TaskId)mTasks.size();
+
+	Task task;
+	task.Name = name;
+	task.Work = std::move(work);
+	task.Dependencies = dependencies;
+	mTasks.push_back(std::move(task));
+
+	for (TaskId dependency : dependencies)
+	{
+		assert(dependency < id);
+		mTasks[dependency].Dependents.push_back(id);
+	}
+
+	return id;
+}
+
+TaskGraph::TaskId TaskGraph::AddParallel(const std::string& name, uint32 count, std::function<void(uint32)> work, const std::vector<TaskId>& dependencies)
+{
+	std::vector<TaskId> parts;
+	for (uint32 i = 0; i < count; ++i)
+		parts.push_back(Add(name + "#" + std::to_string(i), [work, i]() { work(i); }, dependencies));
+
+	// Nothing to do but wait for the parts.
+	return Add(name, nullptr, parts.empty() ? dependencies : parts);
+}
+
+void TaskGraph::Run(uint32 threadCount)
+{
+	if (threadCount == 0)
+		threadCount = std::max(1u, std::thread::hardware_concurrency());
+	mThreadCount = threadCount;
+
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::vector<TaskId> ready;
+	std::vector<uint32> waitingFor(mTasks.size());
+	size_t remaining = mTasks.size();
+	std::exception_ptr failure;
+
+	// Tasks are only added after their dependencies, so going backwards
+	// every task sees the chains behind it first.  Of the ready tasks the one
+	// with the longest chain behind it goes first, it is most likely to be on
+	// the critical path.
+	std::vector<uint32> chainLength(mTasks.size());
+	for (TaskId id = (TaskId)mTasks.size(); id-- > 0; )
+	{
+		for (TaskId dependent : mTasks[id].Dependents)
+			chainLength[id] = std::max(chainLength[id], chainLength[dependent]);
+		if (mTasks[id].Work)
+			chainLength[id]++;
+	}
+
+	for (TaskId id = 0; id < (TaskId)mTasks.size(); ++id)
+	{
+		mTasks[id].Skipped = false;
+		waitingFor[id] = (uint32)mTasks[id].Dependencies.size();
+		if (waitingFor[id] == 0)
+			ready.push_back(id);
+	}
+
+	const Clock::time_point start = Clock::now();
+	auto milliseconds = [start]()
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	};
+
+	auto worker = [&](uint32 workerIndex)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		for (;;)
+		{
+			wake.wait(lock, [&]() { return !ready.empty() || remaining == 0; });
+			if (ready.empty())
+				return;
+
+			auto next = std::max_element(ready.begin(), ready.end(),
+				[&](TaskId a, TaskId b) { return chainLength[a] < chainLength[b]; });
+			const TaskId id = *next;
+			ready.erase(next);
+			Task& task = mTasks[id];
+
+			// A task whose dependency failed is skipped, and so is everything after it.
+			task.Skipped = std::any_of(task.Dependencies.begin(), task.Dependencies.end(),
+				[this](TaskId dependency) { return mTasks[dependency].Skipped; });
+
+			lock.unlock();
+			task.Worker = workerIndex;
+			task.StartMs = milliseconds();
+			if (!task.Skipped && task.Work)
+			{
+				try
+				{
+					task.Work();
+				}
+				catch (...)
+				{
+					task.Skipped = true;
+					lock.lock();
+					if (!failure)
+						failure = std::current_exception();
+					lock.unlock();
+				}
+			}
+			task.EndMs = milliseconds();
+			lock.lock();
+
+			for (TaskId dependent : task.Dependents)
+			{
+				if (--waitingFor[dependent] == 0)
+					ready.push_back(dependent);
+			}
+			--remaining;
+			wake.notify_all();
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (uint32 t = 1; t < threadCount; ++t)
+		threads.emplace_back(worker, t);
+	worker(0);
+	for (auto& thread : threads)
+		thread.join();
+
+	mElapsedMs = milliseconds();
+
+	if (failure)
+		std::rethrow_exception(failure);
+}
+
+std::string TaskGraph::ToString() const
+{
+	std::vector<TaskId> order(mTasks.size());
+	for (TaskId id = 0; id < (TaskId)order.size(); ++id)
+		order[id] = id;
+	std::sort(order.begin(), order.end(), [this](TaskId a, TaskId b) { return mTasks[a].StartMs < mTasks[b].StartMs; });
+
+	double workMs = 0.0;
+	for (const Task& task : mTasks)
+		workMs += task.EndMs - task.StartMs;
+
+	char line[256];
+	snprintf(line, sizeof(line), "[TaskGraph] %zu tasks on %u threads in %.2f ms, %.2f ms of work (%.2fx parallel)\n",
+		mTasks.size(), mThreadCount, mElapsedMs, workMs, mElapsedMs > 0.0 ? workMs / mElapsedMs : 0.0);
+	std::string result = line;
+
+	for (TaskId id : order)
+	{
+		const Task& task = mTasks[id];
+		if (!task.Work)
+			continue;
+		snprintf(line, sizeof(line), "[TaskGraph]   %8.2f ms +%8.2f ms  worker %2u  %s%s\n",
+			task.StartMs, task.EndMs - task.StartMs, task.Worker, task.Name.c_str(), task.Skipped ? " (skipped)" : "");
+		result += line;
+	}
+
+	if (mTasks.empty())
+		return result;
+
+	// Walk back from the task that ended last, always through the dependency
+	// that ended last: that one held the task up.
+	std::vector<TaskId> path;
+	TaskId current = (TaskId)std::distance(mTasks.begin(), std::max_element(mTasks.begin(), mTasks.end(),
+		[](const Task& a, const Task& b) { return a.EndMs < b.EndMs; }));
+	for (;;)
+	{
+		path.push_back(current);
+		const Task& task = mTasks[current];
+		if (task.Dependencies.empty())
+			break;
+		current = *std::max_element(task.Dependencies.begin(), task.Dependencies.end(),
+			[this](TaskId a, TaskId b) { return mTasks[a].EndMs < mTasks[b].EndMs; });
+	}
+
+	result += "[TaskGraph] critical path:";
+	const char* separator = " ";
+	for (auto it = path.rbegin(); it != path.rend(); ++it)
+	{
+		const Task& task = mTasks[*it];
+		if (!task.Work)
+			continue;
+		snprintf(line, sizeof(line), "%s%s (%.2f ms)", separator, task.Name.c_str(), task.EndMs - task.StartMs);
+		result += line;
+		separator = " -> ";
+	}
+	result += "\n";
+
+	return result;
+}
\ No newline at end of file
@@ -0,0 +1,75 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// A set of named tasks with explicit dependencies, run once on a pool of
+// worker threads.  A task starts as soon as all of its dependencies have
+// finished, so independent work (texture decoding, model import, shader
+// compilation) overlaps and the run takes about as long as its critical
+// path once there are enough cores.
+//
+// Tasks that share something that is not thread safe, like a command list,
+// have to be ordered through dependencies.
+//
+// Run records when and on which worker every task ran, ToString prints that
+// trace together with the critical path.
+class TaskGraph
+{
+public:
+	using uint32 = std::uint32_t;
+	using TaskId = uint32;
+
+	TaskGraph() = default;
+	TaskGraph(const TaskGraph& rhs) = delete;
+	TaskGraph& operator=(const TaskGraph& rhs) = delete;
+
+	///<summary>
+	/// Adds a task that runs work after all dependencies finished.  The
+	/// dependencies have to be added before.
+	///</summary>
+	TaskId Add(const std::string& name, std::function<void()> work, const std::vector<TaskId>& dependencies = {});
+
+	///<summary>
+	/// Adds count tasks that run work(i), and a task that finishes after all
+	/// of them, which is returned to depend on.
+	///</summary>
+	TaskId AddParallel(const std::string& name, uint32 count, std::function<void(uint32)> work, const std::vector<TaskId>& dependencies = {});
+
+	///<summary>
+	/// Runs every task on threadCount threads (0 for one per hardware thread),
+	/// the calling thread being one of them.  If tasks throw, the tasks that
+	/// depend on them are skipped and the first exception is rethrown once
+	/// everything else finished.
+	///</summary>
+	void Run(uint32 threadCount = 0);
+
+	///<summary>
+	/// Tasks in start order with start, duration and worker, then the
+	/// critical path: the chain of dependencies that ended last.
+	///</summary>
+	std::string ToString() const;
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	struct Task
+	{
+		std::string Name;
+		std::function<void()> Work;
+		std::vector<TaskId> Dependencies;
+		std::vector<TaskId> Dependents;
+
+		// Filled by Run.
+		double StartMs = 0.0;
+		double EndMs = 0.0;
+		uint32 Worker = 0;
+		bool Skipped = false;
+	};
+
+	std::vector<Task> mTasks;
+	double mElapsedMs = 0.0;
+	uint32 mThreadCount = 0;
+};
\ No newline at end of file
@@ -0,0 +1,364 @@
+#include "TerrainGenerator.h"
+#include "BoundsFitter.h"
+#include "WorkerPool.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <thread>
+
+using namespace DirectX;
+
+const TerrainGenerator::uint32 TerrainGenerator::MaxTileQuads;
+
+namespace
+{
+	using uint32 = TerrainGenerator::uint32;
+	using Vertex = PrimitiveTypes::PosTexNorColVertex;
+
+	uint32 ThreadCountFor(const TerrainGenerator::Desc& desc, uint32 workCount)
+	{
+		uint32 threads = desc.ThreadCount != 0 ? desc.ThreadCount : std::thread::hardware_concurrency();
+		return std::max(1u, std::min(threads, workCount));
+	}
+
+	uint32 Log2(uint32 value)
+	{
+		uint32 log = 0;
+		while (value > 1)
+		{
+			value >>= 1;
+			++log;
+		}
+		return log;
+	}
+
+	// Appends the index variants of one tile layout.  Triangles can be given
+	// in any order, AddTriangle winds them so they face the given direction.
+	class TileIndexBuilder
+	{
+	public:
+		TileIndexBuilder(uint32 tileQuads, std::vector<std::uint16_t>& indices)
+			: mTileQuads(tileQuads), mN(tileQuads + 1), mIndices(indices)
+		{
+		}
+
+		TerrainIndexRange AddVariant(uint32 level, uint32 coarserEdges)
+		{
+			TerrainIndexRange range;
+			range.StartIndexLocation = (uint32)mIndices.size();
+
+			const uint32 step = 1u << level;
+			const XMVECTOR up = XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+
+			if (step == mTileQuads)
+			{
+				AddTriangle(EdgeVertex(TerrainLevels::EdgeFar, 0, 0), EdgeVertex(TerrainLevels::EdgeFar, mTileQuads, 0),
+					EdgeVertex(TerrainLevels::EdgeNear, 0, 0), up);
+				AddTriangle(EdgeVertex(TerrainLevels::EdgeNear, 0, 0), EdgeVertex(TerrainLevels::EdgeFar, mTileQuads, 0),
+					EdgeVertex(TerrainLevels::EdgeNear, mTileQuads, 0), up);
+			}
+			else
+			{
+				// Inner grid, everything but the outermost ring of quads.
+				for (uint32 r = step; r + step < mTileQuads; r += step)
+				{
+					for (uint32 c = step; c + step < mTileQuads; c += step)
+					{
+						const uint32 a = r * mN + c;
+						AddTriangle(a, a + step, a + step * mN, up);
+						AddTriangle(a + step * mN, a + step, a + step * mN + step, up);
+					}
+				}
+
+				// The ring is zipped edge by edge between the edge vertices and the
+				// inner grid's border, whatever step the edge uses.
+				for (uint32 edge = 0; edge < TerrainLevels::EdgeCount; ++edge)
+				{
+					const uint32 outerStep = OuterStep(edge, step, coarserEdges);
+					const uint32 innerEnd = mTileQuads - step;
+
+					uint32 outer = 0;
+					uint32 inner = step;
+					while (outer < mTileQuads || inner < innerEnd)
+					{
+						if (inner == innerEnd || (outer < mTileQuads && outer + outerStep <= inner + step))
+						{
+							AddTriangle(EdgeVertex(edge, outer, 0), EdgeVertex(edge, outer + outerStep, 0), EdgeVertex(edge, inner, step), up);
+							outer += outerStep;
+						}
+						else
+						{
+							AddTriangle(EdgeVertex(edge, outer, 0), EdgeVertex(edge, inner + step, step), EdgeVertex(edge, inner, step), up);
+							inner += step;
+						}
+					}
+				}
+			}
+
+			// Skirts follow the edge vertices actually used.
+			static const XMVECTORF32 outwards[TerrainLevels::EdgeCount] =
+			{
+				{ 0.0f, 0.0f, 1.0f, 0.0f },
+				{ 0.0f, 0.0f, -1.0f, 0.0f },
+				{ -1.0f, 0.0f, 0.0f, 0.0f },
+				{ 1.0f, 0.0f, 0.0f, 0.0f },
+			};
+			for (uint32 edge = 0; edge < TerrainLevels::EdgeCount; ++edge)
+			{
+				const uint32 outerStep = OuterStep(edge, step, coarserEdges);
+				for (uint32 i = 0; i < mTileQuads; i += outerStep)
+				{
+					const uint32 j = i + outerStep;
+					AddTriangle(SkirtVertex(edge, i), SkirtVertex(edge, j), EdgeVertex(edge, i, 0), outwards[edge]);
+					AddTriangle(EdgeVertex(edge, i, 0), SkirtVertex(edge, j), EdgeVertex(edge, j, 0), outwards[edge]);
+				}
+			}
+
+			range.IndexCount = (uint32)mIndices.size() - range.StartIndexLocation;
+			return range;
+		}
+
+	private:
+		uint32 OuterStep(uint32 edge, uint32 step, uint32 coarserEdges) const
+		{
+			return (coarserEdges & (1u << edge)) != 0 ? std::min(2 * step, mTileQuads) : step;
+		}
+
+		// Grid vertex depth rows or columns in from edge, along vertices along it.
+		uint32 EdgeVertex(uint32 edge, uint32 along, uint32 depth) const
+		{
+			switch (edge)
+			{
+			case TerrainLevels::EdgeFar:
+				return depth * mN + along;
+			case TerrainLevels::EdgeNear:
+				return (mTileQuads - depth) * mN + along;
+			case TerrainLevels::EdgeLeft:
+				return along * mN + depth;
+			default:
+				return along * mN + mTileQuads - depth;
+			}
+		}
+
+		uint32 SkirtVertex(uint32 edge, uint32 along) const
+		{
+			return mN * mN + edge * mN + along;
+		}
+
+		// Grid coordinates (column, 0, -row) with the skirts one unit down,
+		// enough to tell which way a triangle faces.
+		XMVECTOR GridPosition(uint32 vertex) const
+		{
+			float y = 0.0f;
+			if (vertex >= mN * mN)
+			{
+				const uint32 skirt = vertex - mN * mN;
+				vertex = EdgeVertex(skirt / mN, skirt % mN, 0);
+				y = -1.0f;
+			}
+			return XMVectorSet((float)(vertex % mN), y, -(float)(vertex / mN), 0.0f);
+		}
+
+		void AddTriangle(uint32 a, uint32 b, uint32 c, FXMVECTOR facing)
+		{
+			// Clockwise seen from facing, like GeometryGenerator::CreateGrid.
+			const XMVECTOR pa = GridPosition(a);
+			const XMVECTOR normal = XMVector3Cross(GridPosition(b) - pa, GridPosition(c) - pa);
+			if (XMVectorGetX(XMVector3Dot(normal, facing)) < 0.0f)
+				std::swap(b, c);
+
+			mIndices.push_back(static_cast<std::uint16_t>(a));
+			mIndices.push_back(static_cast<std::uint16_t>(b));
+			mIndices.push_back(static_cast<std::uint16_t>(c));
+		}
+
+		uint32 mTileQuads;
+		uint32 mN;
+		std::vector<std::uint16_t>& mIndices;
+	};
+
+	// Largest height difference between the samples of a tile and the surface
+	// of each level, which is linear over the two triangles of each of its quads.
+	std::vector<float> ComputeLevelErrors(const Heightfield& heightfield, uint32 tileX, uint32 tileZ, uint32 tileQuads, uint32 levelCount)
+	{
+		std::vector<float> errors(levelCount, 0.0f);
+		const int x0 = (int)(tileX * tileQuads);
+		const int z0 = (int)(tileZ * tileQuads);
+
+		for (uint32 level = 1; level < levelCount; ++level)
+		{
+			const int step = 1 << level;
+			const float invStep = 1.0f / step;
+			float maxError = errors[level - 1];
+
+			for (int r = 0; r < (int)tileQuads; r += step)
+			{
+				for (int c = 0; c < (int)tileQuads; c += step)
+				{
+					const float a = heightfield.At(x0 + c, z0 + r);
+					const float b = heightfield.At(x0 + c + step, z0 + r);
+					const float d = heightfield.At(x0 + c, z0 + r + step);
+					const float e = heightfield.At(x0 + c + step, z0 + r + step);
+
+					for (int i = 0; i <= step; ++i)
+					{
+						const float v = i * invStep;
+						for (int j = 0; j <= step; ++j)
+						{
+							const float u = j * invStep;
+							const float coarse = u + v <= 1.0f
+								? a + u * (b - a) + v * (d - a)
+								: e + (1.0f - u) * (d - e) + (1.0f - v) * (b - e);
+							maxError = std::max(maxError, fabsf(heightfield.At(x0 + c + j, z0 + r + i) - coarse));
+						}
+					}
+				}
+			}
+
+			errors[level] = maxError;
+		}
+
+		return errors;
+	}
+}
+
+float Heightfield::At(int x, int z) const
+{
+	x = std::min(std::max(x, 0), (int)Width - 1);
+	z = std::min(std::max(z, 0), (int)Depth - 1);
+	return Heights[(size_t)z * Width + x];
+}
+
+XMFLOAT3 Heightfield::Position(std::uint32_t x, std::uint32_t z) const
+{
+	return XMFLOAT3(
+		-0.5f * (Width - 1) * Spacing + x * Spacing,
+		Heights[(size_t)z * Width + x],
+		+0.5f * (Depth - 1) * Spacing - z * Spacing);
+}
+
+XMFLOAT3 Heightfield::Normal(std::uint32_t x, std::uint32_t z) const
+{
+	const int ix = (int)x;
+	const int iz = (int)z;
+	const float dhdx = (At(ix + 1, iz) - At(ix - 1, iz)) / (2.0f * Spacing);
+	// Rows run towards -z.
+	const float dhdz = -(At(ix, iz + 1) - At(ix, iz - 1)) / (2.0f * Spacing);
+
+	XMFLOAT3 normal;
+	XMStoreFloat3(&normal, XMVector3Normalize(XMVectorSet(-dhdx, 1.0f, -dhdz, 0.0f)));
+	return normal;
+}
+
+Heightfield TerrainGenerator::GenerateHeightfield(const Desc& desc, const std::function<float(float, float)>& height)
+{
+	Heightfield heightfield;
+	heightfield.Width = desc.TilesX * desc.TileQuads + 1;
+	heightfield.Depth = desc.TilesZ * desc.TileQuads + 1;
+	heightfield.Spacing = desc.Spacing;
+	heightfield.Heights.resize((size_t)heightfield.Width * heightfield.Depth);
+
+	const float halfWidth = 0.5f * (heightfield.Width - 1) * desc.Spacing;
+	const float halfDepth = 0.5f * (heightfield.Depth - 1) * desc.Spacing;
+
+	WorkerPool::ParallelFor(heightfield.Depth, ThreadCountFor(desc, heightfield.Depth), [&](uint32 z)
+	{
+		float* row = &heightfield.Heights[(size_t)z * heightfield.Width];
+		const float worldZ = halfDepth - z * desc.Spacing;
+		for (uint32 x = 0; x < heightfield.Width; ++x)
+			row[x] = height(-halfWidth + x * desc.Spacing, worldZ);
+	});
+
+	return heightfield;
+}
+
+ChunkedTerrain TerrainGenerator::Generate(const Heightfield& heightfield, const Desc& desc)
+{
+	assert(desc.TileQuads > 0 && desc.TileQuads <= MaxTileQuads && (desc.TileQuads & (desc.TileQuads - 1)) == 0);
+	assert(heightfield.Width == desc.TilesX * desc.TileQuads + 1 && heightfield.Depth == desc.TilesZ * desc.TileQuads + 1);
+
+	const uint32 tileQuads = desc.TileQuads;
+	const uint32 n = tileQuads + 1;
+
+	ChunkedTerrain terrain;
+	terrain.TilesX = desc.TilesX;
+	terrain.TilesZ = desc.TilesZ;
+	terrain.TileQuads = tileQuads;
+	terrain.VerticesPerTile = n * n + 4 * n;
+	terrain.LevelCount = Log2(tileQuads) + 1;
+
+	TileIndexBuilder indexBuilder(tileQuads, terrain.Indices);
+	for (uint32 level = 0; level < terrain.LevelCount; ++level)
+		for (uint32 coarserEdges = 0; coarserEdges < TerrainLevels::VariantsPerLevel; ++coarserEdges)
+			terrain.Variants.push_back(indexBuilder.AddVariant(level, coarserEdges));
+
+	terrain.Tiles.resize((size_t)desc.TilesX * desc.TilesZ);
+	terrain.Vertices.resize(terrain.Tiles.size() * terrain.VerticesPerTile);
+
+	const float du = desc.TextureRepeat / (heightfield.Width - 1);
+	const float dv = desc.TextureRepeat / (heightfield.Depth - 1);
+
+	// Every tile writes its own vertex range, so the tiles need no locking.
+	WorkerPool::ParallelFor((uint32)terrain.Tiles.size(), ThreadCountFor(desc, (uint32)terrain.Tiles.size()), [&](uint32 tileIndex)
+	{
+		TerrainTile& tile = terrain.Tiles[tileIndex];
+		tile.X = tileIndex % desc.TilesX;
+		tile.Z = tileIndex / desc.TilesX;
+
+		Vertex* vertices = &terrain.Vertices[(size_t)tileIndex * terrain.VerticesPerTile];
+		for (uint32 r = 0; r < n; ++r)
+		{
+			const uint32 z = tile.Z * tileQuads + r;
+			for (uint32 c = 0; c < n; ++c)
+			{
+				const uint32 x = tile.X * tileQuads + c;
+
+				Vertex& vertex = vertices[r * n + c];
+				vertex.Position = heightfield.Position(x, z);
+				vertex.Normal = heightfield.Normal(x, z);
+				vertex.TexCoord = XMFLOAT2(x * du, z * dv);
+				vertex.Color = desc.Color;
+			}
+		}
+
+		// Skirts: far, near, left and right edge, each dropped by SkirtDepth.
+		Vertex* skirt = vertices + n * n;
+		for (uint32 i = 0; i < n; ++i)
+		{
+			skirt[i] = vertices[i];
+			skirt[n + i] = vertices[tileQuads * n + i];
+			skirt[2 * n + i] = vertices[i * n];
+			skirt[3 * n + i] = vertices[i * n + tileQuads];
+		}
+		for (uint32 i = 0; i < 4 * n; ++i)
+			skirt[i].Position.y -= desc.SkirtDepth;
+
+		tile.BaseVertexLocation = (std::int32_t)(tileIndex * terrain.VerticesPerTile);
+		tile.Bounds = BoundsFitter::Compute(&vertices[0].Position.x, terrain.VerticesPerTile, sizeof(Vertex));
+
+		tile.LevelErrors = ComputeLevelErrors(heightfield, tile.X, tile.Z, tileQuads, terrain.LevelCount);
+	});
+
+	return terrain;
+}
+
+std::string TerrainGenerator::TileName(const std::string& name, uint32 x, uint32 z)
+{
+	return name + "_" + std::to_string(x) + "_" + std::to_string(z);
+}
+
+float TerrainGenerator::HillsHeight(float x, float z)
+{
+	return 0.3f * (z * sinf(0.1f * x) + x * cosf(0.1f * z));
+}
+
+std::string TerrainGenerator::ToString(const std::string& name, const ChunkedTerrain& terrain, double milliseconds)
+{
+	char buffer[256];
+	snprintf(buffer, sizeof(buffer),
+		"[TerrainGenerator] %s: %ux%u tiles of %ux%u quads, %zu vertices, %u triangles per tile, %u levels, %zu indices in all variants, generated in %.1f ms\n",
+		name.c_str(), terrain.TilesX, terrain.TilesZ, terrain.TileQuads, terrain.TileQuads,
+		terrain.Vertices.size(), terrain.Variants[0].IndexCount / 3, terrain.LevelCount, terrain.Indices.size(), milliseconds);
+
+	return buffer;
+}
\ No newline at end of file
@@ -0,0 +1,126 @@
+#pragma once
+#include "BoundsFitter.h"
+#include "PrimitiveTypes.h"
+#include "TerrainLevels.h"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Height samples on a regular grid in the xz-plane, centered at the origin
+// like GeometryGenerator::CreateGrid: column x is at -0.5 * width + x * Spacing
+// and row z at +0.5 * depth - z * Spacing.
+struct Heightfield
+{
+	std::uint32_t Width = 0;
+	std::uint32_t Depth = 0;
+	float Spacing = 1.0f;
+	// Depth rows of Width samples.
+	std::vector<float> Heights;
+
+	///<summary>
+	/// Height at a sample, clamped to the edges.
+	///</summary>
+	float At(int x, int z) const;
+
+	DirectX::XMFLOAT3 Position(std::uint32_t x, std::uint32_t z) const;
+
+	///<summary>
+	/// Central difference normal, continuous across tile borders.
+	///</summary>
+	DirectX::XMFLOAT3 Normal(std::uint32_t x, std::uint32_t z) const;
+};
+
+// One tile of a chunked terrain.  All tiles share the vertex layout and
+// therefore the index lists, the draws only differ in BaseVertexLocation.
+struct TerrainTile
+{
+	std::uint32_t X = 0;
+	std::uint32_t Z = 0;
+	// First vertex of the tile in ChunkedTerrain::Vertices.
+	std::int32_t BaseVertexLocation = 0;
+	// Of the grid and skirt vertices.
+	MeshBounds Bounds;
+	// Largest height difference between the full detail surface and each
+	// level of detail, growing with the level.
+	std::vector<float> LevelErrors;
+};
+
+struct TerrainIndexRange
+{
+	std::uint32_t StartIndexLocation = 0;
+	std::uint32_t IndexCount = 0;
+};
+
+struct ChunkedTerrain
+{
+	std::vector<PrimitiveTypes::PosTexNorColVertex> Vertices;
+	// All index variants one after the other, see TerrainLevels::VariantIndex.
+	std::vector<std::uint16_t> Indices;
+	std::vector<TerrainIndexRange> Variants;
+	std::vector<TerrainTile> Tiles;
+	std::uint32_t TilesX = 0;
+	std::uint32_t TilesZ = 0;
+	std::uint32_t TileQuads = 0;
+	std::uint32_t VerticesPerTile = 0;
+	// Level l samples every 2^l-th grid vertex, the last level is a single quad.
+	std::uint32_t LevelCount = 0;
+};
+
+// Splits a height field into square tiles of TileQuads x TileQuads quads and
+// generates them on all cores.  Each tile holds (TileQuads + 1)^2 grid
+// vertices followed by a skirt hanging down from each of its 4 edges, which
+// hides the gaps where neighbouring tiles are drawn at different detail.
+//
+// The vertices are always full detail; the levels of detail are index lists
+// over every 2^l-th vertex (geomipmapping).  Every level comes in 16 stitching
+// variants, one per combination of edges whose neighbour is one level coarser:
+// those edges skip every other vertex so they meet the neighbour's edge
+// exactly and no cracks open between the tiles.
+//
+// Generation is std and DirectXMath only, TerrainGeometry uploads the result.
+class TerrainGenerator
+{
+public:
+	using uint16 = std::uint16_t;
+	using uint32 = std::uint32_t;
+
+	// Largest power of two tile that still fits 16-bit indices.
+	static const uint32 MaxTileQuads = 128;
+
+	struct Desc
+	{
+		uint32 TilesX = 8;
+		uint32 TilesZ = 8;
+		uint32 TileQuads = 64;
+		float Spacing = 1.0f;
+		float SkirtDepth = 1.0f;
+		// Times the texture repeats over the whole terrain.
+		float TextureRepeat = 1.0f;
+		DirectX::XMFLOAT4 Color = { 1.0f, 1.0f, 1.0f, 1.0f };
+		// 0 uses one thread per hardware thread.
+		uint32 ThreadCount = 0;
+	};
+
+	///<summary>
+	/// Samples height(x, z) at the (TilesX * TileQuads + 1) x (TilesZ * TileQuads + 1)
+	/// grid points of desc, in parallel over rows.
+	///</summary>
+	static Heightfield GenerateHeightfield(const Desc& desc, const std::function<float(float, float)>& height);
+
+	///<summary>
+	/// Generates the vertices, index variants, per tile bounds and level errors.
+	/// desc.TileQuads has to be a power of two and heightfield has to have the
+	/// sample counts GenerateHeightfield produces for desc.
+	///</summary>
+	static ChunkedTerrain Generate(const Heightfield& heightfield, const Desc& desc);
+
+	static std::string TileName(const std::string& name, uint32 x, uint32 z);
+
+	///<summary>
+	/// The rolling hills of the book's land demo.
+	///</summary>
+	static float HillsHeight(float x, float z);
+
+	static std::string ToString(const std::string& name, const ChunkedTerrain& terrain, double milliseconds);
+};
\ No newline at end of file
@@ -0,0 +1,57 @@
+#include "TerrainGeometry.h"
+#include "GeometryArena.h"
+
+std::unique_ptr<MeshGeometry> TerrainGeometry::Build(const std::string& name, const ChunkedTerrain& terrain,
+	GeometryArena& arena, ID3D12Device* device, ID3D12GraphicsCommandList* cmdList)
+{
+	using Vertex = PrimitiveTypes::PosTexNorColVertex;
+
+	const UINT vbByteSize = (UINT)(terrain.Vertices.size() * sizeof(Vertex));
+	const UINT ibByteSize = (UINT)(terrain.Indices.size() * sizeof(std::uint16_t));
+
+	auto geo = std::make_unique<MeshGeometry>();
+	geo->Name = name;
+
+	ThrowIfFailed(D3DCreateBlob(vbByteSize, &geo->VertexBufferCPU));
+	CopyMemory(geo->VertexBufferCPU->GetBufferPointer(), terrain.Vertices.data(), vbByteSize);
+
+	ThrowIfFailed(D3DCreateBlob(ibByteSize, &geo->IndexBufferCPU));
+	CopyMemory(geo->IndexBufferCPU->GetBufferPointer(), terrain.Indices.data(), ibByteSize);
+
+	geo->VertexByteStride = sizeof(Vertex);
+	geo->VertexBufferByteSize = vbByteSize;
+	geo->IndexFormat = DXGI_FORMAT_R16_UINT;
+	geo->IndexBufferByteSize = ibByteSize;
+
+	MeshBounds bounds = BoundsFitter::Compute(terrain.Vertices);
+	geo->Bounds = bounds.Box;
+	geo->SphereBounds = bounds.Sphere;
+	geo->OrientedBounds = bounds.OrientedBox;
+
+	const TerrainIndexRange& fullDetail = terrain.Variants[0];
+	for (const TerrainTile& tile : terrain.Tiles)
+	{
+		SubmeshGeometry draw;
+		draw.IndexCount = fullDetail.IndexCount;
+		draw.StartIndexLocation = fullDetail.StartIndexLocation;
+		draw.BaseVertexLocation = tile.BaseVertexLocation;
+		draw.Bounds = tile.Bounds.Box;
+		draw.SphereBounds = tile.Bounds.Sphere;
+		draw.OrientedBounds = tile.Bounds.OrientedBox;
+		geo->DrawArgs[TerrainGenerator::TileName(name, tile.X, tile.Z)] = draw;
+	}
+
+	if (arena.Upload(*geo, geo->VertexBufferCPU->GetBufferPointer(), vbByteSize,
+		geo->IndexBufferCPU->GetBufferPointer(), ibByteSize))
+		return geo;
+
+	std::string message = "[TerrainGeometry] GeometryArena is full, " + name + " gets its own buffers.\n";
+	::OutputDebugStringA(message.c_str());
+
+	geo->VertexBufferGPU = D3D12Util::CreateDefaultBuffer(device, cmdList,
+		terrain.Vertices.data(), vbByteSize, geo->VertexBufferUploader);
+	geo->IndexBufferGPU = D3D12Util::CreateDefaultBuffer(device, cmdList,
+		terrain.Indices.data(), ibByteSize, geo->IndexBufferUploader);
+
+	return geo;
+}
\ No newline at end of file
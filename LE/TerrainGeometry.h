@@ -0,0 +1,17 @@
+#pragma once
+#include "MeshGeometry.h"
+#include "TerrainGenerator.h"
+
+// TerrainGenerator's output on D3D12: the vertices and index variants of a
+// ChunkedTerrain go into one MeshGeometry, with a draw per tile.
+class TerrainGeometry
+{
+public:
+	///<summary>
+	/// Uploads a terrain into arena (or own buffers when it is full).  The
+	/// tiles are registered as DrawArgs "name_x_z", see TerrainGenerator::TileName,
+	/// each drawing the full detail variant.
+	///</summary>
+	static std::unique_ptr<MeshGeometry> Build(const std::string& name, const ChunkedTerrain& terrain,
+		GeometryArena& arena, ID3D12Device* device, ID3D12GraphicsCommandList* cmdList);
+};
\ No newline at end of file
@@ -0,0 +1,133 @@
+#include "TerrainLevels.h"
+#include <algorithm>
+
+const TerrainLevels::uint32 TerrainLevels::VariantsPerLevel;
+
+namespace
+{
+	// How often the threshold is raised when the budget is exceeded, after
+	// that the selection is used as it is.
+	const int MaxBudgetSteps = 8;
+	const float BudgetStepScale = 1.5f;
+}
+
+void TerrainLevels::Reset(uint32 tilesX, uint32 tilesZ, const std::vector<std::vector<float>>& levelErrors,
+	const std::vector<uint32>& variantTriangles)
+{
+	mTilesX = tilesX;
+	mTilesZ = tilesZ;
+	mVariantTriangles = variantTriangles;
+
+	mErrors.assign(levelErrors.size(), std::vector<Level>());
+	for (size_t tile = 0; tile < levelErrors.size(); ++tile)
+	{
+		for (float error : levelErrors[tile])
+			mErrors[tile].push_back({ error });
+	}
+
+	// Start coarse, the first selection refines where needed.
+	const uint32 levelCount = levelErrors.empty() ? 0 : (uint32)levelErrors[0].size();
+	mLevels.assign(levelErrors.size(), levelCount > 0 ? levelCount - 1 : 0);
+}
+
+void TerrainLevels::SetProjection(float fovY, float viewportHeight)
+{
+	mSelector.SetProjection(fovY, viewportHeight);
+}
+
+void TerrainLevels::SetThreshold(float pixelThreshold, float hysteresis)
+{
+	mPixelThreshold = pixelThreshold;
+	mHysteresis = hysteresis;
+}
+
+void TerrainLevels::SetTriangleBudget(uint32 triangles)
+{
+	mTriangleBudget = triangles;
+}
+
+float TerrainLevels::Select(const std::vector<float>& distances, const std::vector<char>& visible)
+{
+	const std::vector<uint32> previous = mLevels;
+
+	float scale = 1.0f;
+	for (int step = 0; ; ++step)
+	{
+		mSelector.SetThreshold(mPixelThreshold * scale, mHysteresis);
+		for (size_t i = 0; i < mLevels.size(); ++i)
+			mLevels[i] = mSelector.Select(mErrors[i], previous[i], 1.0f, distances[i]);
+
+		Balance();
+
+		if (mTriangleBudget == 0 || step == MaxBudgetSteps || CountTriangles(visible) <= mTriangleBudget)
+			break;
+		scale *= BudgetStepScale;
+	}
+
+	return scale;
+}
+
+void TerrainLevels::Balance()
+{
+	// Stitching only covers one level of difference, so refine every tile
+	// that is more than one level coarser than a neighbour.  Levels only get
+	// finer, so this settles after at most LevelCount passes.
+	bool changed = true;
+	while (changed)
+	{
+		changed = false;
+		for (uint32 z = 0; z < mTilesZ; ++z)
+		{
+			for (uint32 x = 0; x < mTilesX; ++x)
+			{
+				uint32& level = mLevels[z * mTilesX + x];
+				uint32 finest = level;
+				if (x > 0)
+					finest = std::min(finest, mLevels[z * mTilesX + x - 1] + 1);
+				if (x + 1 < mTilesX)
+					finest = std::min(finest, mLevels[z * mTilesX + x + 1] + 1);
+				if (z > 0)
+					finest = std::min(finest, mLevels[(z - 1) * mTilesX + x] + 1);
+				if (z + 1 < mTilesZ)
+					finest = std::min(finest, mLevels[(z + 1) * mTilesX + x] + 1);
+
+				if (finest < level)
+				{
+					level = finest;
+					changed = true;
+				}
+			}
+		}
+	}
+}
+
+TerrainLevels::uint32 TerrainLevels::CountTriangles(const std::vector<char>& visible) const
+{
+	uint32 triangles = 0;
+	for (uint32 i = 0; i < (uint32)mLevels.size(); ++i)
+	{
+		if (visible[i])
+			triangles += mVariantTriangles[GetVariant(i)];
+	}
+	return triangles;
+}
+
+TerrainLevels::uint32 TerrainLevels::CoarserEdges(uint32 tile) const
+{
+	const uint32 x = tile % mTilesX;
+	const uint32 z = tile / mTilesX;
+	const uint32 level = mLevels[tile];
+
+	// Tile rows run towards -z, so the far neighbour is the previous row.
+	uint32 edges = 0;
+	if (z > 0 && mLevels[tile - mTilesX] > level)
+		edges |= 1u << EdgeFar;
+	if (z + 1 < mTilesZ && mLevels[tile + mTilesX] > level)
+		edges |= 1u << EdgeNear;
+	if (x > 0 && mLevels[tile - 1] > level)
+		edges |= 1u << EdgeLeft;
+	if (x + 1 < mTilesX && mLevels[tile + 1] > level)
+		edges |= 1u << EdgeRight;
+
+	return edges;
+}
\ No newline at end of file
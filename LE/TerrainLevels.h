@@ -0,0 +1,111 @@
+#pragma once
+#include "LodSelector.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Level of detail selection for a grid of terrain tiles, the part of
+// TerrainQuadtree that needs neither geometry nor a device.
+//
+// Levels come from the projected screen space error of each tile (through
+// LodSelector, with its hysteresis), are then refined until neighbours
+// differ by at most one level and finally coarsened as a whole while the
+// visible triangles exceed the budget.  Every level of a tile comes in
+// VariantsPerLevel index variants, one per combination of edges whose
+// neighbour is one level coarser.
+class TerrainLevels
+{
+public:
+	using uint32 = std::uint32_t;
+
+	// Tile edges: far is the first grid row (+z), near the last one, left the
+	// first column (-x) and right the last one.
+	enum Edge : uint32
+	{
+		EdgeFar = 0,
+		EdgeNear,
+		EdgeLeft,
+		EdgeRight,
+		EdgeCount
+	};
+
+	static const uint32 VariantsPerLevel = 1 << EdgeCount;
+
+	///<summary>
+	/// Index of the variant of level whose edges in coarserEdges (bit 1 << Edge)
+	/// are stitched to a neighbour one level coarser.
+	///</summary>
+	static uint32 VariantIndex(uint32 level, uint32 coarserEdges)
+	{
+		return level * VariantsPerLevel + coarserEdges;
+	}
+
+	TerrainLevels() = default;
+
+	///<summary>
+	/// levelErrors holds the error of each level of every tile, rows of
+	/// tilesX tiles, all with the same level count.  variantTriangles holds
+	/// the triangles of each variant, by VariantIndex.  All tiles start at
+	/// the coarsest level.
+	///</summary>
+	void Reset(uint32 tilesX, uint32 tilesZ, const std::vector<std::vector<float>>& levelErrors,
+		const std::vector<uint32>& variantTriangles);
+
+	void SetProjection(float fovY, float viewportHeight);
+
+	void SetThreshold(float pixelThreshold, float hysteresis);
+
+	///<summary>
+	/// 0 disables the budget.
+	///</summary>
+	void SetTriangleBudget(uint32 triangles);
+
+	///<summary>
+	/// Selects the levels for an eye at distances[tile] from each tile.  Only
+	/// the tiles set in visible count against the budget.  Returns the factor
+	/// the pixel threshold was raised by to stay within it.
+	///</summary>
+	float Select(const std::vector<float>& distances, const std::vector<char>& visible);
+
+	uint32 GetLevel(uint32 tile) const
+	{
+		return mLevels[tile];
+	}
+
+	///<summary>
+	/// Edges of tile whose neighbour is one level coarser, bit 1 << Edge.
+	///</summary>
+	uint32 CoarserEdges(uint32 tile) const;
+
+	uint32 GetVariant(uint32 tile) const
+	{
+		return VariantIndex(mLevels[tile], CoarserEdges(tile));
+	}
+
+	uint32 CountTriangles(const std::vector<char>& visible) const;
+
+	uint32 GetTileCount() const
+	{
+		return (uint32)mLevels.size();
+	}
+
+private:
+	struct Level
+	{
+		float Error = 0.0f;
+	};
+
+	void Balance();
+
+	uint32 mTilesX = 0;
+	uint32 mTilesZ = 0;
+	// Per tile, only the errors are used by LodSelector.
+	std::vector<std::vector<Level>> mErrors;
+	std::vector<uint32> mVariantTriangles;
+	std::vector<uint32> mLevels;
+
+	LodSelector mSelector;
+	float mPixelThreshold = 2.0f;
+	float mHysteresis = 0.25f;
+	uint32 mTriangleBudget = 0;
+};
\ No newline at end of file
@@ -0,0 +1,224 @@
+#include "TerrainQuadtree.h"
+#include <algorithm>
+#include <cstdio>
+
+using namespace DirectX;
+
+namespace
+{
+	// Fraction of a tile's width the eye may move before the levels are reselected.
+	const float ReselectTileFraction = 0.1f;
+
+	float DistanceToBox(const BoundingBox& box, const XMFLOAT3& point)
+	{
+		XMVECTOR outside = XMVectorAbs(XMLoadFloat3(&point) - XMLoadFloat3(&box.Center)) - XMLoadFloat3(&box.Extents);
+		return XMVectorGetX(XMVector3Length(XMVectorMax(outside, XMVectorZero())));
+	}
+
+	bool SameDraw(const SubmeshGeometry& a, const SubmeshGeometry& b)
+	{
+		return a.IndexCount == b.IndexCount && a.StartIndexLocation == b.StartIndexLocation &&
+			a.BaseVertexLocation == b.BaseVertexLocation;
+	}
+}
+
+void TerrainQuadtree::Build(const std::string& name, const ChunkedTerrain& terrain, const MeshGeometry& geo)
+{
+	mTilesX = terrain.TilesX;
+	mTilesZ = terrain.TilesZ;
+	mTiles.assign(terrain.Tiles.size(), Tile());
+	mVariants = terrain.Variants;
+	mNodes.clear();
+	mDraws.clear();
+	mRoot = -1;
+	mSelectionDirty = true;
+
+	if (terrain.Tiles.empty())
+		return;
+
+	// Uploading moves the whole index list, so all variants move with the first tile.
+	const SubmeshGeometry& first = geo.DrawArgs.at(TerrainGenerator::TileName(name, 0, 0));
+	const UINT indexOffset = first.StartIndexLocation - terrain.Variants[0].StartIndexLocation;
+	for (TerrainIndexRange& variant : mVariants)
+		variant.StartIndexLocation += indexOffset;
+
+	std::vector<std::vector<float>> levelErrors(mTiles.size());
+	for (size_t i = 0; i < terrain.Tiles.size(); ++i)
+	{
+		const TerrainTile& source = terrain.Tiles[i];
+		Tile& tile = mTiles[source.Z * mTilesX + source.X];
+		tile.X = source.X;
+		tile.Z = source.Z;
+		tile.BaseVertexLocation = geo.DrawArgs.at(TerrainGenerator::TileName(name, source.X, source.Z)).BaseVertexLocation;
+		tile.Bounds = source.Bounds.Box;
+		levelErrors[source.Z * mTilesX + source.X] = source.LevelErrors;
+	}
+
+	std::vector<uint32> variantTriangles;
+	for (const TerrainIndexRange& variant : mVariants)
+		variantTriangles.push_back(variant.IndexCount / 3);
+	mLevels.Reset(mTilesX, mTilesZ, levelErrors, variantTriangles);
+
+	mVisible.assign(mTiles.size(), 0);
+	mPreviousVisible.assign(mTiles.size(), 0);
+
+	mNodes.reserve(2 * mTiles.size());
+	mRoot = BuildNode(0, 0, mTilesX, mTilesZ);
+
+	mReselectDistance = 2.0f * mTiles[0].Bounds.Extents.x * ReselectTileFraction;
+}
+
+void TerrainQuadtree::SetProjection(float fovY, float viewportHeight)
+{
+	mLevels.SetProjection(fovY, viewportHeight);
+	mSelectionDirty = true;
+}
+
+void TerrainQuadtree::SetThreshold(float pixelThreshold, float hysteresis)
+{
+	mLevels.SetThreshold(pixelThreshold, hysteresis);
+	mSelectionDirty = true;
+}
+
+void TerrainQuadtree::SetTriangleBudget(uint32 triangles)
+{
+	mLevels.SetTriangleBudget(triangles);
+	mSelectionDirty = true;
+}
+
+bool TerrainQuadtree::Update(const BoundingFrustum& frustum, const XMFLOAT3& eye)
+{
+	mStats.Reselected = false;
+	if (mRoot < 0)
+		return false;
+
+	mPreviousVisible.swap(mVisible);
+	std::fill(mVisible.begin(), mVisible.end(), 0);
+	Cull(mRoot, frustum, false);
+
+	const float moved = XMVectorGetX(XMVector3Length(XMLoadFloat3(&eye) - XMLoadFloat3(&mSelectedEye)));
+	if (mSelectionDirty || moved > mReselectDistance || mVisible != mPreviousVisible)
+	{
+		SelectLevels(eye);
+		mSelectedEye = eye;
+		mSelectionDirty = false;
+		mStats.Reselected = true;
+	}
+
+	return BuildDraws();
+}
+
+int TerrainQuadtree::BuildNode(uint32 x0, uint32 z0, uint32 x1, uint32 z1)
+{
+	Node node;
+	if (x1 - x0 == 1 && z1 - z0 == 1)
+	{
+		node.Tile = z0 * mTilesX + x0;
+		node.Bounds = mTiles[node.Tile].Bounds;
+	}
+	else
+	{
+		// Halve each side that is longer than one tile.
+		const uint32 xs[3] = { x0, x1 - x0 > 1 ? (x0 + x1) / 2 : x1, x1 };
+		const uint32 zs[3] = { z0, z1 - z0 > 1 ? (z0 + z1) / 2 : z1, z1 };
+
+		int childCount = 0;
+		for (int j = 0; j < 2; ++j)
+		{
+			for (int i = 0; i < 2; ++i)
+			{
+				if (xs[i] == xs[i + 1] || zs[j] == zs[j + 1])
+					continue;
+
+				const int child = BuildNode(xs[i], zs[j], xs[i + 1], zs[j + 1]);
+				if (childCount == 0)
+					node.Bounds = mNodes[child].Bounds;
+				else
+					BoundingBox::CreateMerged(node.Bounds, node.Bounds, mNodes[child].Bounds);
+				node.Children[childCount++] = child;
+			}
+		}
+	}
+
+	mNodes.push_back(node);
+	return (int)mNodes.size() - 1;
+}
+
+void TerrainQuadtree::Cull(int node, const BoundingFrustum& frustum, bool inside)
+{
+	const Node& current = mNodes[node];
+	if (!inside)
+	{
+		// A node completely inside takes all of its tiles without further tests.
+		const ContainmentType containment = frustum.Contains(current.Bounds);
+		if (containment == DISJOINT)
+			return;
+		inside = containment == CONTAINS;
+	}
+
+	if (current.Children[0] < 0)
+	{
+		mVisible[current.Tile] = 1;
+		return;
+	}
+
+	for (int child : current.Children)
+	{
+		if (child >= 0)
+			Cull(child, frustum, inside);
+	}
+}
+
+void TerrainQuadtree::SelectLevels(const XMFLOAT3& eye)
+{
+	std::vector<float> distances(mTiles.size());
+	for (size_t i = 0; i < mTiles.size(); ++i)
+		distances[i] = DistanceToBox(mTiles[i].Bounds, eye);
+
+	mStats.ThresholdScale = mLevels.Select(distances, mVisible);
+}
+
+bool TerrainQuadtree::BuildDraws()
+{
+	std::vector<SubmeshGeometry> draws;
+	draws.reserve(mDraws.size());
+
+	mStats.VisibleTiles = 0;
+	mStats.Triangles = 0;
+	for (uint32 i = 0; i < (uint32)mTiles.size(); ++i)
+	{
+		if (!mVisible[i])
+			continue;
+
+		const TerrainIndexRange& variant = mVariants[mLevels.GetVariant(i)];
+
+		SubmeshGeometry draw;
+		draw.IndexCount = variant.IndexCount;
+		draw.StartIndexLocation = variant.StartIndexLocation;
+		draw.BaseVertexLocation = mTiles[i].BaseVertexLocation;
+		draw.Bounds = mTiles[i].Bounds;
+		draws.push_back(draw);
+
+		mStats.VisibleTiles++;
+		mStats.Triangles += variant.IndexCount / 3;
+	}
+	mStats.CulledTiles = (uint32)mTiles.size() - mStats.VisibleTiles;
+
+	const bool changed = draws.size() != mDraws.size() ||
+		!std::equal(draws.begin(), draws.end(), mDraws.begin(), SameDraw);
+	if (changed)
+		mDraws.swap(draws);
+
+	return changed;
+}
+
+std::string TerrainQuadtree::ToString(const Stats& stats)
+{
+	char buffer[160];
+	snprintf(buffer, sizeof(buffer),
+		"[TerrainQuadtree] %u tiles visible, %u culled, %u triangles, threshold x%.2f%s\n",
+		stats.VisibleTiles, stats.CulledTiles, stats.Triangles, stats.ThresholdScale,
+		stats.Reselected ? ", reselected" : "");
+
+	return buffer;
+}
\ No newline at end of file
@@ -0,0 +1,118 @@
+#pragma once
+#include "MeshGeometry.h"
+#include "TerrainGenerator.h"
+#include "TerrainLevels.h"
+#include <DirectXCollision.h>
+
+// Chooses a level of detail per tile of a ChunkedTerrain and the index
+// variants that stitch neighbouring levels together.
+//
+// The tiles are kept in a quadtree of merged bounds, so the frustum test
+// rejects or accepts whole groups of tiles at once.  The levels are picked
+// by TerrainLevels, from the distance of the eye to each tile.  The
+// selection is only redone after the eye moved a noticeable part of a tile
+// or other tiles came into view, otherwise a frame only re-culls.
+//
+// Everything is in the terrain's object space.
+class TerrainQuadtree
+{
+public:
+	using uint32 = std::uint32_t;
+
+	struct Stats
+	{
+		uint32 VisibleTiles = 0;
+		uint32 CulledTiles = 0;
+		uint32 Triangles = 0;
+		// Factor the pixel threshold was raised by to stay within the budget.
+		float ThresholdScale = 1.0f;
+		bool Reselected = false;
+	};
+
+	TerrainQuadtree() = default;
+
+	///<summary>
+	/// Builds the tree for terrain as uploaded into geo under name (see
+	/// TerrainGenerator::Build), so the draws carry the geometry's offsets.
+	///</summary>
+	void Build(const std::string& name, const ChunkedTerrain& terrain, const MeshGeometry& geo);
+
+	void SetProjection(float fovY, float viewportHeight);
+
+	void SetThreshold(float pixelThreshold, float hysteresis);
+
+	///<summary>
+	/// 0 disables the budget.
+	///</summary>
+	void SetTriangleBudget(uint32 triangles);
+
+	///<summary>
+	/// Culls against frustum and, when needed, selects new levels for eye.
+	/// Returns true when the draws changed.
+	///</summary>
+	bool Update(const DirectX::BoundingFrustum& frustum, const DirectX::XMFLOAT3& eye);
+
+	///<summary>
+	/// One draw per visible tile.
+	///</summary>
+	const std::vector<SubmeshGeometry>& GetDraws() const
+	{
+		return mDraws;
+	}
+
+	uint32 GetTileLevel(uint32 x, uint32 z) const
+	{
+		return mLevels.GetLevel(z * mTilesX + x);
+	}
+
+	const Stats& GetStats() const
+	{
+		return mStats;
+	}
+
+	static std::string ToString(const Stats& stats);
+
+private:
+	struct Node
+	{
+		DirectX::BoundingBox Bounds;
+		// Child nodes, or -1 for a leaf.
+		int Children[4] = { -1, -1, -1, -1 };
+		// Tile for a leaf.
+		uint32 Tile = 0;
+	};
+
+	int BuildNode(uint32 x0, uint32 z0, uint32 x1, uint32 z1);
+	void Cull(int node, const DirectX::BoundingFrustum& frustum, bool inside);
+	void SelectLevels(const DirectX::XMFLOAT3& eye);
+	bool BuildDraws();
+
+	struct Tile
+	{
+		uint32 X = 0;
+		uint32 Z = 0;
+		INT BaseVertexLocation = 0;
+		DirectX::BoundingBox Bounds;
+	};
+
+	std::vector<Tile> mTiles;
+	std::vector<Node> mNodes;
+	std::vector<TerrainIndexRange> mVariants;
+	uint32 mTilesX = 0;
+	uint32 mTilesZ = 0;
+	int mRoot = -1;
+
+	TerrainLevels mLevels;
+	std::vector<char> mVisible;
+	std::vector<char> mPreviousVisible;
+	std::vector<SubmeshGeometry> mDraws;
+
+
+	// The levels are kept while the visible tiles stay the same and the eye
+	// stays within this distance of the one they were selected for.
+	float mReselectDistance = 0.0f;
+	DirectX::XMFLOAT3 mSelectedEye = { 0.0f, 0.0f, 0.0f };
+	bool mSelectionDirty = true;
+
+	Stats mStats;
+};
\ No newline at end of file
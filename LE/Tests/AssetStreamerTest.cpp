@@ -0,0 +1,310 @@
+#include "AssetStreamer.h"
+#include "TestCheck.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// AssetStreamer against a stand-in device that only pretends to upload.
+// The test completes the fences itself, so it decides when the GPU is done.
+namespace
+{
+	using uint32 = AssetStreamer::uint32;
+	using uint64 = AssetStreamer::uint64;
+	using State = AssetStreamer::State;
+
+	std::atomic<int> LivePayloads(0);
+
+	struct TestPayload : AssetStreamer::Payload
+	{
+		TestPayload() { LivePayloads++; }
+		~TestPayload() { LivePayloads--; }
+
+		std::string Filename;
+		bool Recorded = false;
+		bool Resident = false;
+	};
+
+	// Files named "missing" do not decode, "throw" throws while decoding and
+	// "noupload" throws while its upload is recorded.  The others upload as
+	// many bytes as the number after the last '.'.
+	class TestDevice : public AssetStreamer::Device
+	{
+	public:
+		std::unique_ptr<AssetStreamer::Payload> Decode(const std::string& filename) override
+		{
+			Decodes++;
+			if (filename == "missing")
+				return nullptr;
+			if (filename == "throw")
+				throw std::runtime_error("cannot read");
+
+			auto payload = std::make_unique<TestPayload>();
+			payload->Filename = filename;
+			const size_t dot = filename.rfind('.');
+			if (dot != std::string::npos)
+				payload->UploadBytes = std::stoull(filename.substr(dot + 1));
+			return payload;
+		}
+
+		void RecordUpload(AssetStreamer::Payload& payload) override
+		{
+			TestPayload& test = static_cast<TestPayload&>(payload);
+			if (test.Filename == "noupload")
+				throw std::runtime_error("out of memory");
+			test.Recorded = true;
+			Recorded++;
+		}
+
+		uint64 Submit() override
+		{
+			Submits++;
+			return ++Fence;
+		}
+
+		uint64 GetCompletedFence() override
+		{
+			return Completed;
+		}
+
+		void WaitForFence(uint64 fence) override
+		{
+			Waited = std::max(Waited, fence);
+			Completed = std::max(Completed, fence);
+		}
+
+		void MakeResident(AssetStreamer::Payload& payload) override
+		{
+			TestPayload& test = static_cast<TestPayload&>(payload);
+			CHECK(test.Recorded);
+			CHECK(!test.Resident);
+			test.Resident = true;
+		}
+
+		std::atomic<uint32> Decodes{ 0 };
+		uint32 Recorded = 0;
+		uint32 Submits = 0;
+		uint64 Fence = 0;
+		uint64 Completed = 0;
+		uint64 Waited = 0;
+	};
+
+	// Updates until handle is out of the states the workers own, or gives up
+	// after a few seconds.
+	void WaitForDecode(AssetStreamer& streamer, AssetStreamer::Handle handle)
+	{
+		const auto end = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+		while (std::chrono::steady_clock::now() < end)
+		{
+			const State state = streamer.GetState(handle);
+			if (state != State::Queued && state != State::Decoding)
+				return;
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		CHECK(false);
+	}
+
+	// One asset through every state, resident only once its fence is done.
+	void TestResident()
+	{
+		TestDevice device;
+		AssetStreamer streamer(device, AssetStreamer::Options());
+		CHECK(streamer.GetState(AssetStreamer::InvalidHandle) == State::Failed);
+		CHECK(streamer.GetState(100) == State::Failed);
+
+		uint32 calls = 0;
+		std::string residentName;
+		const auto handle = streamer.Request("a.100", [&](AssetStreamer::Payload& payload)
+		{
+			calls++;
+			residentName = static_cast<TestPayload&>(payload).Filename;
+		});
+		CHECK(handle != AssetStreamer::InvalidHandle);
+
+		WaitForDecode(streamer, handle);
+		CHECK(streamer.GetState(handle) == State::Decoded);
+
+		streamer.Update();
+		CHECK(streamer.GetState(handle) == State::Uploading);
+		CHECK(device.Recorded == 1 && device.Submits == 1);
+
+		// Nothing more to record, and the GPU is not done yet.
+		streamer.Update();
+		CHECK(streamer.GetState(handle) == State::Uploading);
+		CHECK(device.Submits == 1 && calls == 0);
+
+		device.Completed = device.Fence;
+		streamer.Update();
+		CHECK(streamer.GetState(handle) == State::Resident);
+		CHECK(calls == 1 && residentName == "a.100");
+
+		streamer.Update();
+		CHECK(calls == 1);
+
+		const AssetStreamer::Stats stats = streamer.GetStats();
+		CHECK(stats.Requested == 1 && stats.Resident == 1 && stats.Failed == 0);
+		CHECK(stats.Submits == 1 && stats.UploadedBytes == 100 && stats.LargestFrameBytes == 100);
+		CHECK(LivePayloads == 0);
+	}
+
+	// Assets that cannot be decoded or uploaded fail, are logged, never call
+	// back and leave no payload behind.  The others go on.
+	void TestFailures()
+	{
+		TestDevice device;
+		std::vector<std::string> log;
+		std::mutex logMutex;
+		AssetStreamer::Options options;
+		options.Log = [&](const std::string& message)
+		{
+			std::lock_guard<std::mutex> lock(logMutex);
+			log.push_back(message);
+		};
+
+		{
+			AssetStreamer streamer(device, options);
+			uint32 calls = 0;
+			auto count = [&calls](AssetStreamer::Payload&) { calls++; };
+			const AssetStreamer::Handle handles[] =
+			{
+				streamer.Request("missing", count),
+				streamer.Request("throw", count),
+				streamer.Request("noupload", count),
+				streamer.Request("good.10", count),
+			};
+			for (auto handle : handles)
+				WaitForDecode(streamer, handle);
+			CHECK(streamer.GetState(handles[0]) == State::Failed);
+			CHECK(streamer.GetState(handles[1]) == State::Failed);
+			CHECK(streamer.GetState(handles[2]) == State::Decoded);
+
+			streamer.Update();
+			CHECK(streamer.GetState(handles[2]) == State::Failed);
+			CHECK(streamer.GetState(handles[3]) == State::Uploading);
+			CHECK(LivePayloads == 1);
+
+			device.Completed = device.Fence;
+			streamer.Update();
+			CHECK(streamer.GetState(handles[3]) == State::Resident);
+			CHECK(calls == 1);
+
+			const AssetStreamer::Stats stats = streamer.GetStats();
+			CHECK(stats.Requested == 4 && stats.Resident == 1 && stats.Failed == 3);
+			CHECK(stats.UploadedBytes == 10);
+		}
+
+		CHECK(log.size() == 3);
+		uint32 decodes = 0, uploads = 0;
+		for (const auto& message : log)
+		{
+			decodes += message == "[AssetStreamer] Could not decode missing\n" ||
+				message == "[AssetStreamer] Could not decode throw\n";
+			uploads += message == "[AssetStreamer] Could not upload noupload\n";
+		}
+		CHECK(decodes == 2 && uploads == 1);
+		CHECK(LivePayloads == 0);
+	}
+
+	// Each Update records the budget at most, in the order the assets were
+	// decoded, and a larger asset still goes alone.
+	void TestBudget()
+	{
+		TestDevice device;
+		AssetStreamer::Options options;
+		options.UploadBytesPerFrame = 100;
+		options.ThreadCount = 1;
+		AssetStreamer streamer(device, options);
+
+		// One worker decodes in request order.
+		const char* const files[] = { "a.60", "b.30", "c.20", "d.250", "e.100", "f.1" };
+		std::vector<AssetStreamer::Handle> handles;
+		for (const char* file : files)
+			handles.push_back(streamer.Request(file, nullptr));
+		for (auto handle : handles)
+			WaitForDecode(streamer, handle);
+
+		const uint32 expected[][6] =
+		{
+			{ 1, 1, 0, 0, 0, 0 },
+			{ 1, 1, 1, 0, 0, 0 },
+			{ 1, 1, 1, 1, 0, 0 },
+			{ 1, 1, 1, 1, 1, 0 },
+			{ 1, 1, 1, 1, 1, 1 },
+		};
+		for (const auto& frame : expected)
+		{
+			streamer.Update();
+			for (size_t i = 0; i < handles.size(); ++i)
+				CHECK((streamer.GetState(handles[i]) == State::Decoded) == (frame[i] == 0));
+		}
+		CHECK(device.Submits == 5);
+
+		device.Completed = device.Fence;
+		streamer.Update();
+		for (auto handle : handles)
+			CHECK(streamer.GetState(handle) == State::Resident);
+
+		const AssetStreamer::Stats stats = streamer.GetStats();
+		CHECK(stats.Submits == 5 && stats.UploadedBytes == 461 && stats.LargestFrameBytes == 250);
+	}
+
+	// Fences complete one after the other, and only the assets of a done
+	// fence become resident.
+	void TestFences()
+	{
+		TestDevice device;
+		AssetStreamer streamer(device, AssetStreamer::Options());
+		const auto first = streamer.Request("first.1", nullptr);
+		WaitForDecode(streamer, first);
+		streamer.Update();
+		const auto second = streamer.Request("second.1", nullptr);
+		WaitForDecode(streamer, second);
+		streamer.Update();
+		CHECK(device.Fence == 2);
+
+		device.Completed = 1;
+		streamer.Update();
+		CHECK(streamer.GetState(first) == State::Resident);
+		CHECK(streamer.GetState(second) == State::Uploading);
+
+		device.Completed = 2;
+		streamer.Update();
+		CHECK(streamer.GetState(second) == State::Resident);
+	}
+
+	// Going away waits for the uploads in flight and drops the rest, with
+	// many requests still queued for the workers.
+	void TestShutdown()
+	{
+		TestDevice device;
+		{
+			AssetStreamer::Options options;
+			options.ThreadCount = 4;
+			AssetStreamer streamer(device, options);
+			const auto handle = streamer.Request("inflight.1", nullptr);
+			WaitForDecode(streamer, handle);
+			streamer.Update();
+			CHECK(device.Fence == 1);
+
+			for (uint32 i = 0; i < 1000; ++i)
+				streamer.Request("queued." + std::to_string(i), nullptr);
+		}
+		CHECK(device.Waited == 1);
+		CHECK(device.Decodes >= 1 && device.Decodes <= 1001);
+		CHECK(LivePayloads == 0);
+	}
+}
+
+int main()
+{
+	TestResident();
+	TestFailures();
+	TestBudget();
+	TestFences();
+	TestShutdown();
+	return TestResult();
+}
\ No newline at end of file
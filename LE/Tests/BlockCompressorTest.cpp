@@ -0,0 +1,482 @@
+#include "BlockCompressor.h"
+#include "TestCheck.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+// Compresses synthetic images to every format, decodes the blocks back with
+// a decoder of its own and measures the PSNR against the source.
+namespace
+{
+	using uint8 = std::uint8_t;
+	using uint16 = std::uint16_t;
+	using uint32 = BlockCompressor::uint32;
+	using uint64 = std::uint64_t;
+	using Format = BlockCompressor::Format;
+	using Quality = BlockCompressor::Quality;
+
+	// RGBA texels of one level.
+	struct Image
+	{
+		uint32 Width;
+		uint32 Height;
+		std::vector<float> Texels;
+
+		float* At(uint32 x, uint32 y)
+		{
+			return Texels.data() + ((size_t)y * Width + x) * 4;
+		}
+	};
+
+	Image MakeImage(uint32 width, uint32 height)
+	{
+		return Image{ width, height, std::vector<float>((size_t)width * height * 4) };
+	}
+
+	//
+	// Decoding, after the D3D11 block compression specification.  Palettes
+	// stay in float, like the hardware interpolates them.
+	//
+
+	void Unpack565(uint16 packed, float color[3])
+	{
+		const uint32 r = (packed >> 11) & 31;
+		const uint32 g = (packed >> 5) & 63;
+		const uint32 b = packed & 31;
+		color[0] = (float)((r << 3) | (r >> 2));
+		color[1] = (float)((g << 2) | (g >> 4));
+		color[2] = (float)((b << 3) | (b >> 2));
+	}
+
+	// BC1 colors into RGB of texels, alpha 0 for the transparent index of
+	// the three color mode unless forced to four colors (BC3).
+	void DecodeBC1(const uint8* block, bool fourColors, float texels[16][4])
+	{
+		const uint16 color0 = (uint16)(block[0] | block[1] << 8);
+		const uint16 color1 = (uint16)(block[2] | block[3] << 8);
+		float palette[4][4] = {};
+		Unpack565(color0, palette[0]);
+		Unpack565(color1, palette[1]);
+		palette[0][3] = palette[1][3] = palette[2][3] = palette[3][3] = 255.0f;
+		for (uint32 c = 0; c < 3; ++c)
+		{
+			if (fourColors || color0 > color1)
+			{
+				palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+				palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+			}
+			else
+			{
+				palette[2][c] = (palette[0][c] + palette[1][c]) / 2.0f;
+				palette[3][c] = 0.0f;
+			}
+		}
+		if (!fourColors && color0 <= color1)
+			palette[3][3] = 0.0f;
+
+		const uint32 indices = (uint32)block[4] | (uint32)block[5] << 8 | (uint32)block[6] << 16 | (uint32)block[7] << 24;
+		for (uint32 i = 0; i < 16; ++i)
+			std::copy(palette[(indices >> (i * 2)) & 3], palette[(indices >> (i * 2)) & 3] + 4, texels[i]);
+	}
+
+	// Eight interpolated values when red0 > red1, otherwise six and 0 and
+	// 255.  Writes channel of texels.
+	void DecodeBC4(const uint8* block, uint32 channel, float texels[16][4])
+	{
+		const float red0 = block[0];
+		const float red1 = block[1];
+		float palette[8] = { red0, red1 };
+		if (red0 > red1)
+		{
+			for (int i = 1; i < 7; ++i)
+				palette[i + 1] = ((7 - i) * red0 + i * red1) / 7.0f;
+		}
+		else
+		{
+			for (int i = 1; i < 5; ++i)
+				palette[i + 1] = ((5 - i) * red0 + i * red1) / 5.0f;
+			palette[6] = 0.0f;
+			palette[7] = 255.0f;
+		}
+
+		uint64 indices = 0;
+		for (uint32 i = 0; i < 6; ++i)
+			indices |= (uint64)block[2 + i] << (i * 8);
+		for (uint32 i = 0; i < 16; ++i)
+			texels[i][channel] = palette[(indices >> (i * 3)) & 7];
+	}
+
+	uint32 ReadBits(const uint8* block, uint32& position, uint32 count)
+	{
+		uint32 value = 0;
+		for (uint32 i = 0; i < count; ++i, ++position)
+			value |= (uint32)((block[position >> 3] >> (position & 7)) & 1) << i;
+		return value;
+	}
+
+	// Mode 6 only, which is all the compressor writes.  Returns false for
+	// any other mode.
+	bool DecodeBC7(const uint8* block, float texels[16][4])
+	{
+		uint32 position = 0;
+		if (ReadBits(block, position, 7) != 1u << 6)
+			return false;
+
+		uint32 endpoints[2][4];
+		for (uint32 c = 0; c < 4; ++c)
+		{
+			endpoints[0][c] = ReadBits(block, position, 7);
+			endpoints[1][c] = ReadBits(block, position, 7);
+		}
+		const uint32 pbit0 = ReadBits(block, position, 1);
+		const uint32 pbit1 = ReadBits(block, position, 1);
+
+		static const uint32 weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+		for (uint32 i = 0; i < 16; ++i)
+		{
+			const uint32 index = ReadBits(block, position, i == 0 ? 3 : 4);
+			for (uint32 c = 0; c < 4; ++c)
+			{
+				const uint32 a = endpoints[0][c] << 1 | pbit0;
+				const uint32 b = endpoints[1][c] << 1 | pbit1;
+				texels[i][c] = (float)(((64 - weights[index]) * a + weights[index] * b + 32) >> 6);
+			}
+		}
+		return true;
+	}
+
+	uint32 ChannelsKept(Format format)
+	{
+		switch (format)
+		{
+		case Format::BC1_UNORM: case Format::BC1_UNORM_SRGB: return 3;
+		case Format::BC4_UNORM: return 1;
+		case Format::BC5_UNORM: return 2;
+		default: return 4;
+		}
+	}
+
+	// The level a surface decodes to, or an empty image for a mode or
+	// format the decoder does not know.
+	Image Decode(Format format, const BlockCompressor::Surface& surface, uint32 width, uint32 height)
+	{
+		Image image = MakeImage(width, height);
+		for (uint32 by = 0; by < (height + 3) / 4; ++by)
+		{
+			for (uint32 bx = 0; bx < (width + 3) / 4; ++bx)
+			{
+				const uint8* block = static_cast<const uint8*>(surface.Data) + by * surface.RowPitch +
+					bx * BlockCompressor::GetBlockBytes(format);
+				float texels[16][4] = {};
+				switch (format)
+				{
+				case Format::BC1_UNORM: case Format::BC1_UNORM_SRGB:
+					DecodeBC1(block, false, texels);
+					break;
+				case Format::BC3_UNORM: case Format::BC3_UNORM_SRGB:
+					DecodeBC1(block + 8, true, texels);
+					DecodeBC4(block, 3, texels);
+					break;
+				case Format::BC4_UNORM:
+					DecodeBC4(block, 0, texels);
+					break;
+				case Format::BC5_UNORM:
+					DecodeBC4(block, 0, texels);
+					DecodeBC4(block + 8, 1, texels);
+					break;
+				case Format::BC7_UNORM: case Format::BC7_UNORM_SRGB:
+					if (!DecodeBC7(block, texels))
+						return MakeImage(0, 0);
+					break;
+				default:
+					return MakeImage(0, 0);
+				}
+
+				for (uint32 i = 0; i < 16; ++i)
+				{
+					const uint32 x = bx * 4 + (i & 3);
+					const uint32 y = by * 4 + (i >> 2);
+					if (x < width && y < height)
+						std::copy(texels[i], texels[i] + 4, image.At(x, y));
+				}
+			}
+		}
+		return image;
+	}
+
+	// Over the channels the format keeps, like the report.
+	double Psnr(const Image& source, const Image& decoded, uint32 channels)
+	{
+		if (decoded.Texels.size() != source.Texels.size())
+			return 0.0;
+		double error = 0.0;
+		for (size_t i = 0; i < source.Texels.size(); ++i)
+		{
+			if (i % 4 < channels)
+			{
+				const double d = source.Texels[i] - decoded.Texels[i];
+				error += d * d;
+			}
+		}
+		const double mse = error / (source.Texels.size() / 4 * channels);
+		return mse > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / mse) : 99.0;
+	}
+
+	// image as the 8-bit texels Compress reads.
+	std::vector<uint8> Store(const Image& image, Format format)
+	{
+		std::vector<uint8> texels;
+		for (size_t i = 0; i < image.Texels.size(); i += 4)
+		{
+			const float* texel = &image.Texels[i];
+			if (format == Format::R8_UNORM)
+				texels.push_back((uint8)texel[0]);
+			else if (format == Format::B8G8R8A8_UNORM)
+				texels.insert(texels.end(), { (uint8)texel[2], (uint8)texel[1], (uint8)texel[0], (uint8)texel[3] });
+			else
+				texels.insert(texels.end(), { (uint8)texel[0], (uint8)texel[1], (uint8)texel[2], (uint8)texel[3] });
+		}
+		return texels;
+	}
+
+	struct Result
+	{
+		BlockCompressor::Report Report;
+		Image Decoded;
+		double Psnr = 0.0;
+	};
+
+	// One level of image from source through target and back.
+	Result RoundTrip(const Image& image, Format source, Format target, Quality quality)
+	{
+		const std::vector<uint8> texels = Store(image, source);
+		BlockCompressor::Surface top;
+		top.Data = texels.data();
+		top.RowPitch = (uint64)image.Width * (source == Format::R8_UNORM ? 1 : 4);
+		top.SlicePitch = top.RowPitch * image.Height;
+
+		BlockCompressor::Options options;
+		options.Format = target;
+		options.Level = quality;
+		std::vector<uint8> storage;
+		std::vector<BlockCompressor::Surface> compressed;
+		Result result;
+		CHECK(BlockCompressor::Compress(source, image.Width, image.Height, 1, { top }, options, storage, compressed, result.Report));
+		CHECK(compressed.size() == 1);
+		if (compressed.size() != 1)
+			return result;
+
+		result.Decoded = Decode(result.Report.Format, compressed[0], image.Width, image.Height);
+		Image expected = image;
+		if (source == Format::R8_UNORM)
+		{
+			for (size_t i = 0; i < expected.Texels.size(); i += 4)
+				expected.Texels[i + 1] = expected.Texels[i + 2] = 0.0f;
+		}
+		result.Psnr = Psnr(expected, result.Decoded, ChannelsKept(result.Report.Format));
+		return result;
+	}
+
+	const Format Targets[] = { Format::BC1_UNORM, Format::BC3_UNORM, Format::BC4_UNORM, Format::BC5_UNORM, Format::BC7_UNORM };
+	const Quality Qualities[] = { Quality::Fast, Quality::Normal, Quality::High };
+
+	// Every block one color, alpha included.
+	Image SolidBlocks()
+	{
+		Image image = MakeImage(32, 32);
+		std::mt19937 random(7);
+		for (uint32 by = 0; by < 8; ++by)
+		{
+			for (uint32 bx = 0; bx < 8; ++bx)
+			{
+				float color[4];
+				for (float& c : color)
+					c = (float)(random() % 256);
+				for (uint32 i = 0; i < 16; ++i)
+					std::copy(color, color + 4, image.At(bx * 4 + (i & 3), by * 4 + (i >> 2)));
+			}
+		}
+		return image;
+	}
+
+	// Smooth ramps in every channel, a different direction each.
+	Image Gradients()
+	{
+		Image image = MakeImage(64, 64);
+		for (uint32 y = 0; y < 64; ++y)
+		{
+			for (uint32 x = 0; x < 64; ++x)
+			{
+				float* texel = image.At(x, y);
+				texel[0] = (float)(x * 4);
+				texel[1] = (float)(y * 4);
+				texel[2] = (float)((x + y) * 2);
+				texel[3] = (float)(255 - x * 2 - y);
+			}
+		}
+		return image;
+	}
+
+	// A leaf: alpha 0 outside, 255 inside and a texel wide edge between,
+	// in blocks that hold all three.
+	Image Cutout()
+	{
+		Image image = MakeImage(32, 32);
+		for (uint32 y = 0; y < 32; ++y)
+		{
+			for (uint32 x = 0; x < 32; ++x)
+			{
+				const float distance = std::sqrt((x - 15.5f) * (x - 15.5f) + (y - 15.5f) * (y - 15.5f));
+				const float alpha = distance < 10.0f ? 255.0f : distance > 11.0f ? 0.0f : 96.0f + (11.0f - distance) * 64.0f;
+				float* texel = image.At(x, y);
+				texel[0] = texel[3] = std::floor(alpha);
+				texel[1] = (float)(x * 8);
+				texel[2] = 64.0f;
+			}
+		}
+		return image;
+	}
+
+	// Solid blocks come back close to exact in every format.  The report
+	// measures the same PSNR as decoding does.
+	void TestSolidBlocks()
+	{
+		const Image image = SolidBlocks();
+		for (Format target : Targets)
+		{
+			for (Quality quality : Qualities)
+			{
+				const Result result = RoundTrip(image, Format::R8G8B8A8_UNORM, target, quality);
+				printf("solid %s", result.Report.ToString().c_str());
+				CHECK(std::fabs(result.Psnr - result.Report.Psnr) < 0.5);
+				// BC1 only has 5:6:5 bits for a single color.
+				const bool bc1 = target == Format::BC1_UNORM || target == Format::BC3_UNORM;
+				CHECK(result.Psnr > (bc1 ? 38.0 : 50.0));
+			}
+		}
+	}
+
+	// Ramps stay within what every format gets out of a gradient, and
+	// higher quality never does worse.
+	void TestGradients()
+	{
+		const Image image = Gradients();
+		const double minimum[] = { 36.0, 38.0, 45.0, 45.0, 40.0 };
+		for (size_t t = 0; t < 5; ++t)
+		{
+			double previous = 0.0;
+			for (Quality quality : Qualities)
+			{
+				const Result result = RoundTrip(image, Format::R8G8B8A8_UNORM, Targets[t], quality);
+				printf("gradients %s", result.Report.ToString().c_str());
+				CHECK(std::fabs(result.Psnr - result.Report.Psnr) < 0.5);
+				CHECK(result.Psnr > minimum[t]);
+				CHECK(result.Psnr >= previous - 0.05);
+				previous = result.Psnr;
+			}
+		}
+	}
+
+	// Blocks with alpha 0 and 255 and an edge between take the six value
+	// mode of BC4, which has 0 and 255 exactly, in BC4 from R8 and in the
+	// alpha of BC3.
+	void TestCutout()
+	{
+		const Image image = Cutout();
+		for (Format target : { Format::BC4_UNORM, Format::BC3_UNORM })
+		{
+			const Result result = RoundTrip(image, target == Format::BC4_UNORM ? Format::R8_UNORM : Format::R8G8B8A8_UNORM,
+				target, Quality::Normal);
+			printf("cutout %s", result.Report.ToString().c_str());
+			CHECK(result.Decoded.Width == image.Width);
+			if (result.Decoded.Width != image.Width)
+				continue;
+
+			const uint32 channel = target == Format::BC4_UNORM ? 0 : 3;
+			bool exact = true;
+			double error = 0.0;
+			for (size_t i = channel; i < image.Texels.size(); i += 4)
+			{
+				const float source = image.Texels[i];
+				if (source == 0.0f || source == 255.0f)
+					exact = exact && result.Decoded.Texels[i] == source;
+				error += (source - result.Decoded.Texels[i]) * (source - result.Decoded.Texels[i]);
+			}
+			CHECK(exact);
+			CHECK(10.0 * std::log10(255.0 * 255.0 / std::max(error / (image.Texels.size() / 4), 1e-9)) > 40.0);
+		}
+
+		// The six value mode puts red0 <= red1 in the block.
+		std::vector<uint8> alpha = { 0, 255, 0, 255, 100, 110, 120, 130, 0, 0, 255, 255, 140, 150, 0, 255 };
+		BlockCompressor::Surface top;
+		top.Data = alpha.data();
+		top.RowPitch = 4;
+		top.SlicePitch = 16;
+		BlockCompressor::Options options;
+		options.Format = Format::BC4_UNORM;
+		BlockCompressor::Report report;
+		std::vector<uint8> storage;
+		std::vector<BlockCompressor::Surface> compressed;
+		CHECK(BlockCompressor::Compress(Format::R8_UNORM, 4, 4, 1, { top }, options, storage, compressed, report));
+		CHECK(storage.size() == 8 && storage[0] <= storage[1]);
+		float texels[16][4] = {};
+		DecodeBC4(storage.data(), 0, texels);
+		bool ends = true;
+		for (uint32 i = 0; i < 16; ++i)
+			ends = ends && (alpha[i] % 255 != 0 || texels[i][0] == alpha[i]);
+		CHECK(ends);
+	}
+
+	// BGRA sources, sRGB targets, mips smaller than a block, and what
+	// Compress turns down.
+	void TestFormats()
+	{
+		const Image image = Gradients();
+		const Result rgba = RoundTrip(image, Format::R8G8B8A8_UNORM, Format::BC7_UNORM, Quality::Normal);
+		const Result bgra = RoundTrip(image, Format::B8G8R8A8_UNORM, Format::BC7_UNORM, Quality::Normal);
+		CHECK(rgba.Decoded.Texels == bgra.Decoded.Texels);
+
+		// Three levels of an 8x8 texture, the last two inside one block.
+		std::vector<uint8> texels(8 * 8 * 4 + 4 * 4 * 4 + 2 * 2 * 4, 200);
+		std::vector<BlockCompressor::Surface> levels(3);
+		size_t offset = 0;
+		for (uint32 mip = 0; mip < 3; ++mip)
+		{
+			levels[mip].Data = texels.data() + offset;
+			levels[mip].RowPitch = (8u >> mip) * 4;
+			levels[mip].SlicePitch = levels[mip].RowPitch * (8u >> mip);
+			offset += (size_t)levels[mip].SlicePitch;
+		}
+		BlockCompressor::Options options;
+		options.Format = Format::BC1_UNORM;
+		BlockCompressor::Report report;
+		std::vector<uint8> storage;
+		std::vector<BlockCompressor::Surface> compressed;
+		CHECK(BlockCompressor::Compress(Format::R8G8B8A8_UNORM_SRGB, 8, 8, 3, levels, options, storage, compressed, report));
+		CHECK(report.Format == Format::BC1_UNORM_SRGB && report.Blocks == 6 && report.Subresources == 3);
+		CHECK(storage.size() == 6 * 8 && compressed.size() == 3);
+		CHECK(compressed[2].RowPitch == 8 && compressed[2].Data == storage.data() + 5 * 8);
+		const Image smallest = Decode(report.Format, compressed[2], 2, 2);
+		CHECK(smallest.Texels.size() == 16 && std::fabs(smallest.Texels[0] - 200.0f) <= 4.0f);
+
+		options.Format = Format::BC3_UNORM;
+		CHECK(!BlockCompressor::Compress(Format::R8_UNORM, 8, 8, 3, levels, options, storage, compressed, report));
+		CHECK(!BlockCompressor::Compress(Format::R8G8B8A8_UNORM, 6, 8, 1, { levels[0] }, options, storage, compressed, report));
+		CHECK(!BlockCompressor::Compress(Format::R16G16B16A16_UNORM, 8, 8, 1, { levels[0] }, options, storage, compressed, report));
+		options.Format = Format::BC2_UNORM;
+		CHECK(!BlockCompressor::Compress(Format::R8G8B8A8_UNORM, 8, 8, 1, { levels[0] }, options, storage, compressed, report));
+
+		CHECK(BlockCompressor::GetBlockBytes(Format::BC1_UNORM) == 8 && BlockCompressor::GetBlockBytes(Format::BC7_UNORM_SRGB) == 16);
+		CHECK(BlockCompressor::GetBlockBytes(Format::R8G8B8A8_UNORM) == 0);
+	}
+}
+
+int main()
+{
+	TestSolidBlocks();
+	TestGradients();
+	TestCutout();
+	TestFormats();
+	return TestResult();
+}
\ No newline at end of file
@@ -0,0 +1,133 @@
+#include "BoundsFitter.h"
+#include "TestCheck.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+// Fits the three volumes to points filling a rotated, moved box and checks
+// that every point is inside each of them and that the oriented box finds
+// the rotated one.  Also times the fit of about 2M vertices.
+namespace
+{
+	using Vertex = PrimitiveTypes::PosTexNorColVertex;
+
+	// Points uniformly inside a box of the given half extents, its corners
+	// among them, rotated and then moved to center.
+	std::vector<Vertex> MakeRotatedBox(size_t count, XMFLOAT3 extents, FXMMATRIX rotation, XMFLOAT3 center, unsigned seed)
+	{
+		std::mt19937 random(seed);
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+		std::vector<Vertex> vertices(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			XMFLOAT3 p(unit(random), unit(random), unit(random));
+			if (i < 8)
+				p = XMFLOAT3(i & 1 ? 1.0f : -1.0f, i & 2 ? 1.0f : -1.0f, i & 4 ? 1.0f : -1.0f);
+
+			const XMVECTOR local = XMVectorSet(p.x * extents.x, p.y * extents.y, p.z * extents.z, 0.0f);
+			const XMVECTOR world = XMVectorAdd(XMVector3TransformNormal(local, rotation), XMLoadFloat3(&center));
+			XMStoreFloat3(&vertices[i].Position, world);
+		}
+		return vertices;
+	}
+
+	// Every vertex within the bounds grown by a little rounding room.
+	bool ContainsAll(const MeshBounds& bounds, const std::vector<Vertex>& vertices)
+	{
+		const float grow = 1.0001f;
+		BoundingBox box = bounds.Box;
+		box.Extents = XMFLOAT3(box.Extents.x * grow + 1e-5f, box.Extents.y * grow + 1e-5f, box.Extents.z * grow + 1e-5f);
+		BoundingSphere sphere = bounds.Sphere;
+		sphere.Radius = sphere.Radius * grow + 1e-5f;
+		BoundingOrientedBox orientedBox = bounds.OrientedBox;
+		const XMFLOAT3& e = orientedBox.Extents;
+		orientedBox.Extents = XMFLOAT3(e.x * grow + 1e-5f, e.y * grow + 1e-5f, e.z * grow + 1e-5f);
+
+		for (const Vertex& vertex : vertices)
+		{
+			const XMVECTOR p = XMLoadFloat3(&vertex.Position);
+			if (box.Contains(p) != CONTAINS || sphere.Contains(p) != CONTAINS || orientedBox.Contains(p) != CONTAINS)
+				return false;
+		}
+		return true;
+	}
+
+	float Volume(const XMFLOAT3& extents)
+	{
+		return 8.0f * extents.x * extents.y * extents.z;
+	}
+
+	void TestRotatedBox()
+	{
+		const XMFLOAT3 extents(4.0f, 1.0f, 0.5f);
+		const XMMATRIX rotation = XMMatrixRotationQuaternion(XMQuaternionNormalize(XMVectorSet(0.3f, 0.5f, -0.2f, 0.8f)));
+		const std::vector<Vertex> vertices = MakeRotatedBox(20000, extents, rotation, XMFLOAT3(100.0f, -20.0f, 5.0f), 3);
+
+		const MeshBounds bounds = BoundsFitter::Compute(vertices);
+		printf("%s", BoundsFitter::ToString("rotated box", bounds).c_str());
+		CHECK(ContainsAll(bounds, vertices));
+
+		// Tight around the rotated box, and much smaller than the axis
+		// aligned box around it.
+		const float volume = Volume(extents);
+		const float orientedVolume = Volume(bounds.OrientedBox.Extents);
+		CHECK(orientedVolume >= volume * 0.999f && orientedVolume <= volume * 1.05f);
+		CHECK(orientedVolume < 0.5f * Volume(bounds.Box.Extents));
+		CHECK(std::fabs(bounds.OrientedBox.Center.x - 100.0f) < 0.05f && std::fabs(bounds.OrientedBox.Center.y + 20.0f) < 0.05f);
+
+		// Ritter's sphere against the sphere around the box.
+		const float boxRadius = std::sqrt(extents.x * extents.x + extents.y * extents.y + extents.z * extents.z);
+		CHECK(bounds.Sphere.Radius >= boxRadius * 0.999f && bounds.Sphere.Radius <= boxRadius * 1.1f);
+	}
+
+	// An axis aligned box keeps the axis aligned box as oriented box.
+	void TestAxisAligned()
+	{
+		const std::vector<Vertex> vertices = MakeRotatedBox(5000, XMFLOAT3(2.0f, 3.0f, 1.0f), XMMatrixIdentity(), XMFLOAT3(1.0f, 2.0f, 3.0f), 4);
+		const MeshBounds bounds = BoundsFitter::Compute(vertices);
+		CHECK(ContainsAll(bounds, vertices));
+		CHECK(std::fabs(bounds.Box.Extents.x - 2.0f) < 1e-4f && std::fabs(bounds.Box.Extents.y - 3.0f) < 1e-4f);
+		CHECK(Volume(bounds.OrientedBox.Extents) <= Volume(bounds.Box.Extents) * 1.0001f);
+	}
+
+	void TestDegenerate()
+	{
+		const MeshBounds empty = BoundsFitter::Compute(std::vector<Vertex>());
+		CHECK(empty.Box.Extents.x == 0.0f && empty.Box.Center.x == 0.0f && empty.Sphere.Radius == 0.0f);
+
+		// A single point and a flat square.
+		std::vector<Vertex> vertices(1);
+		vertices[0].Position = XMFLOAT3(5.0f, 6.0f, 7.0f);
+		CHECK(ContainsAll(BoundsFitter::Compute(vertices), vertices));
+
+		vertices = MakeRotatedBox(1000, XMFLOAT3(1.0f, 0.0f, 1.0f), XMMatrixRotationY(0.7f), XMFLOAT3(0.0f, 0.0f, 0.0f), 5);
+		const MeshBounds flat = BoundsFitter::Compute(vertices);
+		CHECK(ContainsAll(flat, vertices));
+		CHECK(Volume(flat.OrientedBox.Extents) < 1e-3f);
+	}
+
+	void TimeLargeMesh()
+	{
+		const XMMATRIX rotation = XMMatrixRotationQuaternion(XMQuaternionNormalize(XMVectorSet(-0.1f, 0.7f, 0.2f, 0.6f)));
+		const std::vector<Vertex> vertices = MakeRotatedBox(2u << 20, XMFLOAT3(50.0f, 10.0f, 30.0f), rotation, XMFLOAT3(0.0f, 5.0f, 0.0f), 6);
+
+		auto start = std::chrono::steady_clock::now();
+		const MeshBounds bounds = BoundsFitter::Compute(vertices);
+		const double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		printf("%zu vertices: box, sphere and oriented box in %.1f ms\n", vertices.size(), milliseconds);
+		CHECK(ContainsAll(bounds, vertices));
+	}
+}
+
+int main()
+{
+	TestRotatedBox();
+	TestAxisAligned();
+	TestDegenerate();
+	TimeLargeMesh();
+	return TestResult();
+}
\ No newline at end of file
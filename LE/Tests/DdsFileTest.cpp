@@ -0,0 +1,283 @@
+#include "DdsFile.h"
+#include "TestCheck.h"
+#include <cstring>
+#include <vector>
+
+namespace
+{
+	using uint32 = DdsFile::uint32;
+	using uint64 = DdsFile::uint64;
+	using Format = DdsFile::Format;
+	using Dimension = DdsFile::Dimension;
+
+	const uint32 DdsdDepth = 0x800000;
+	const uint32 DdpfFourCC = 0x4;
+	const uint32 DdpfRgb = 0x40;
+	const uint32 Caps2CubeMap = 0x200;
+	const uint32 Caps2CubeMapAllFaces = 0xFC00;
+	const uint32 Caps2Volume = 0x200000;
+	const uint32 MiscTextureCube = 0x4;
+
+	// The 128 byte header (magic included) as 32 words, and the DX10 one.
+	struct Image
+	{
+		uint32 Words[32] = {};
+		bool Dx10 = false;
+		uint32 Dx10Words[5] = {};
+		size_t PayloadBytes = 0;
+	};
+
+	Image MakeImage(uint32 width, uint32 height, uint32 mipCount)
+	{
+		Image image;
+		image.Words[0] = 0x20534444; // "DDS "
+		image.Words[1] = 124;
+		image.Words[3] = height;
+		image.Words[4] = width;
+		image.Words[6] = 1;
+		image.Words[7] = mipCount;
+		image.Words[19] = 32;
+		return image;
+	}
+
+	// A legacy header with 32-bit RGBA masks.
+	Image MakeRgba(uint32 width, uint32 height, uint32 mipCount)
+	{
+		Image image = MakeImage(width, height, mipCount);
+		image.Words[20] = DdpfRgb;
+		image.Words[22] = 32;
+		image.Words[23] = 0x000000ff;
+		image.Words[24] = 0x0000ff00;
+		image.Words[25] = 0x00ff0000;
+		image.Words[26] = 0xff000000;
+		return image;
+	}
+
+	Image MakeDx10(uint32 width, uint32 height, uint32 mipCount, Format format, Dimension dimension, uint32 arraySize, uint32 miscFlag)
+	{
+		Image image = MakeImage(width, height, mipCount);
+		image.Words[20] = DdpfFourCC;
+		image.Words[21] = 0x30315844; // "DX10"
+		image.Dx10 = true;
+		image.Dx10Words[0] = (uint32)format;
+		image.Dx10Words[1] = (uint32)dimension;
+		image.Dx10Words[2] = miscFlag;
+		image.Dx10Words[3] = arraySize;
+		return image;
+	}
+
+	// The bytes of the file, the payload counts up so every surface starts
+	// with a different byte.
+	std::vector<unsigned char> Bytes(const Image& image)
+	{
+		const size_t headerBytes = sizeof(image.Words) + (image.Dx10 ? sizeof(image.Dx10Words) : 0);
+		std::vector<unsigned char> bytes(headerBytes + image.PayloadBytes);
+		memcpy(bytes.data(), image.Words, sizeof(image.Words));
+		if (image.Dx10)
+			memcpy(bytes.data() + sizeof(image.Words), image.Dx10Words, sizeof(image.Dx10Words));
+		for (size_t i = 0; i < image.PayloadBytes; ++i)
+			bytes[headerBytes + i] = (unsigned char)i;
+		return bytes;
+	}
+
+	// The surfaces have to tile the payload exactly, in subresource order.
+	void CheckLayout(const DdsFile& dds, const std::vector<unsigned char>& bytes, size_t headerBytes)
+	{
+		const unsigned char* next = bytes.data() + headerBytes;
+		for (const DdsFile::Surface& surface : dds.GetSurfaces())
+		{
+			CHECK(surface.Data == next);
+			next += surface.SlicePitch;
+		}
+		CHECK(next <= bytes.data() + bytes.size());
+	}
+
+	void TestMipChain()
+	{
+		// 8x4 RGBA with 4 mips: 8x4, 4x2, 2x1, 1x1.
+		Image image = MakeRgba(8, 4, 4);
+		image.PayloadBytes = (8 * 4 + 4 * 2 + 2 * 1 + 1) * 4;
+		const std::vector<unsigned char> bytes = Bytes(image);
+
+		DdsFile dds;
+		CHECK(dds.Parse(bytes.data(), bytes.size()));
+		CHECK(dds.GetDimension() == Dimension::Texture2D);
+		CHECK(dds.GetFormat() == Format::R8G8B8A8_UNORM);
+		CHECK(dds.GetWidth() == 8 && dds.GetHeight() == 4 && dds.GetDepth() == 1);
+		CHECK(dds.GetArraySize() == 1 && dds.GetMipLevels() == 4 && !dds.IsCubeMap());
+		CHECK(dds.GetSurfaces().size() == 4);
+		if (dds.GetSurfaces().size() == 4)
+		{
+			CHECK(dds.GetSurfaces()[0].RowPitch == 32 && dds.GetSurfaces()[0].SlicePitch == 128);
+			CHECK(dds.GetSurfaces()[1].RowPitch == 16 && dds.GetSurfaces()[1].SlicePitch == 32);
+			CHECK(dds.GetSurfaces()[2].RowPitch == 8 && dds.GetSurfaces()[2].SlicePitch == 8);
+			CHECK(dds.GetSurfaces()[3].RowPitch == 4 && dds.GetSurfaces()[3].SlicePitch == 4);
+		}
+		CheckLayout(dds, bytes, 128);
+
+		// One byte short of the last mip.
+		std::vector<unsigned char> truncated(bytes.begin(), bytes.end() - 1);
+		CHECK(!dds.Parse(truncated.data(), truncated.size()));
+		CHECK(dds.GetSurfaces().empty());
+	}
+
+	void TestBlockCompressed()
+	{
+		// BC1 rounds up to whole 4x4 blocks of 8 bytes, down to 1x1.
+		Image image = MakeDx10(10, 6, 3, Format::BC1_UNORM, Dimension::Texture2D, 1, 0);
+		image.PayloadBytes = (3 * 2 + 2 * 1 + 1 * 1) * 8;
+		const std::vector<unsigned char> bytes = Bytes(image);
+
+		DdsFile dds;
+		CHECK(dds.Parse(bytes.data(), bytes.size()));
+		CHECK(dds.GetFormat() == Format::BC1_UNORM);
+		CHECK(dds.GetSurfaces().size() == 3);
+		if (dds.GetSurfaces().size() == 3)
+		{
+			CHECK(dds.GetSurfaces()[0].RowPitch == 24 && dds.GetSurfaces()[0].SlicePitch == 48);
+			CHECK(dds.GetSurfaces()[1].RowPitch == 16 && dds.GetSurfaces()[1].SlicePitch == 16);
+			CHECK(dds.GetSurfaces()[2].RowPitch == 8 && dds.GetSurfaces()[2].SlicePitch == 8);
+		}
+		CheckLayout(dds, bytes, 148);
+
+		uint64 rowBytes = 0;
+		uint32 rowCount = 0;
+		CHECK(DdsFile::GetSurfaceInfo(1, 1, Format::BC7_UNORM, rowBytes, rowCount) && rowBytes == 16 && rowCount == 1);
+		CHECK(!DdsFile::GetSurfaceInfo(1, 1, Format::UNKNOWN, rowBytes, rowCount));
+	}
+
+	void TestArray()
+	{
+		// 3 slices of 4x4 R32_FLOAT with 3 mips each, slice by slice.
+		Image image = MakeDx10(4, 4, 3, Format::R32_FLOAT, Dimension::Texture2D, 3, 0);
+		image.PayloadBytes = 3 * (16 + 4 + 1) * 4;
+		const std::vector<unsigned char> bytes = Bytes(image);
+
+		DdsFile dds;
+		CHECK(dds.Parse(bytes.data(), bytes.size()));
+		CHECK(dds.GetArraySize() == 3 && dds.GetMipLevels() == 3 && !dds.IsCubeMap());
+		CHECK(dds.GetSurfaces().size() == 9);
+		if (dds.GetSurfaces().size() == 9)
+		{
+			// Subresource order: mip + slice * MipLevels.
+			CHECK(dds.GetSurfaces()[3].SlicePitch == 64);
+			CHECK(dds.GetSurfaces()[5].SlicePitch == 4);
+		}
+		CheckLayout(dds, bytes, 148);
+	}
+
+	void TestCubeMaps()
+	{
+		// A DX10 cube array: 2 cubes of 4x4 BC3, 2 mips.
+		Image image = MakeDx10(4, 4, 2, Format::BC3_UNORM, Dimension::Texture2D, 2, MiscTextureCube);
+		image.PayloadBytes = 12 * (16 + 16);
+		std::vector<unsigned char> bytes = Bytes(image);
+
+		DdsFile dds;
+		CHECK(dds.Parse(bytes.data(), bytes.size()));
+		CHECK(dds.IsCubeMap() && dds.GetArraySize() == 12 && dds.GetSurfaces().size() == 24);
+		CheckLayout(dds, bytes, 148);
+
+		// A legacy cube needs all faces.
+		Image legacy = MakeRgba(2, 2, 1);
+		legacy.Words[28] = Caps2CubeMap | Caps2CubeMapAllFaces;
+		legacy.PayloadBytes = 6 * 16;
+		bytes = Bytes(legacy);
+		CHECK(dds.Parse(bytes.data(), bytes.size()));
+		CHECK(dds.IsCubeMap() && dds.GetArraySize() == 6 && dds.GetSurfaces().size() == 6);
+		CheckLayout(dds, bytes, 128);
+
+		legacy.Words[28] = Caps2CubeMap | 0x0400;
+		bytes = Bytes(legacy);
+		CHECK(!dds.Parse(bytes.data(), bytes.size()));
+
+		// Cube counts whose face count would wrap or not fit a resource.
+		const uint32 counts[] = { 0x2AAAAAAB, 0x40000000, 0xFFFFFFFF, 65535 / 6 + 1 };
+		for (uint32 count : counts)
+		{
+			image = MakeDx10(4, 4, 1, Format::BC3_UNORM, Dimension::Texture2D, count, MiscTextureCube);
+			image.PayloadBytes = 6 * 16;
+			bytes = Bytes(image);
+			CHECK(!dds.Parse(bytes.data(), bytes.size()));
+		}
+
+		// The largest cube array a resource holds is fine, if the file is large enough.
+		image = MakeDx10(1, 1, 1, Format::R8_UNORM, Dimension::Texture2D, 65535 / 6, MiscTextureCube);
+		image.PayloadBytes = 65535 / 6 * 6;
+		bytes = Bytes(image);
+		CHECK(dds.Parse(bytes.data(), bytes.size()));
+		CHECK(dds.GetArraySize() == 65535 / 6 * 6);
+	}
+
+	void TestVolume()
+	{
+		// 4x4x4 RGBA with 3 mips, depth halves with every mip.
+		Image image = MakeRgba(4, 4, 3);
+		image.Words[2] |= DdsdDepth;
+		image.Words[6] = 4;
+		image.Words[28] = Caps2Volume;
+		image.PayloadBytes = (4 * 4 * 4 + 2 * 2 * 2 + 1) * 4;
+		const std::vector<unsigned char> bytes = Bytes(image);
+
+		DdsFile dds;
+		CHECK(dds.Parse(bytes.data(), bytes.size()));
+		CHECK(dds.GetDimension() == Dimension::Texture3D);
+		CHECK(dds.GetDepth() == 4 && dds.GetArraySize() == 1 && dds.GetSurfaces().size() == 3);
+		if (dds.GetSurfaces().size() == 3)
+		{
+			CHECK(dds.GetSurfaces()[0].SlicePitch == 64);
+			CHECK(dds.GetSurfaces()[1].SlicePitch == 16);
+			CHECK(dds.GetSurfaces()[1].Data == bytes.data() + 128 + 256);
+			CHECK(dds.GetSurfaces()[2].Data == bytes.data() + 128 + 256 + 32);
+		}
+
+		// A DX10 volume can not be an array.
+		Image dx10 = MakeDx10(4, 4, 1, Format::R8_UNORM, Dimension::Texture3D, 2, 0);
+		dx10.Words[2] |= DdsdDepth;
+		dx10.Words[6] = 4;
+		dx10.PayloadBytes = 64 * 2;
+		const std::vector<unsigned char> arrayBytes = Bytes(dx10);
+		CHECK(!dds.Parse(arrayBytes.data(), arrayBytes.size()));
+	}
+
+	void TestRejected()
+	{
+		DdsFile dds;
+		Image image = MakeRgba(4, 4, 1);
+		image.PayloadBytes = 64;
+		std::vector<unsigned char> bytes = Bytes(image);
+		CHECK(dds.Parse(bytes.data(), bytes.size()));
+
+		// Cut inside the header.
+		CHECK(!dds.Parse(bytes.data(), 100));
+
+		// Bad magic, zero size, too many mips, unknown format.
+		bytes[0] = 'X';
+		CHECK(!dds.Parse(bytes.data(), bytes.size()));
+
+		Image zero = MakeRgba(0, 4, 1);
+		bytes = Bytes(zero);
+		CHECK(!dds.Parse(bytes.data(), bytes.size()));
+
+		Image mips = MakeRgba(1, 1, 16);
+		mips.PayloadBytes = 16 * 4;
+		bytes = Bytes(mips);
+		CHECK(!dds.Parse(bytes.data(), bytes.size()));
+
+		Image unknown = MakeDx10(4, 4, 1, Format::UNKNOWN, Dimension::Texture2D, 1, 0);
+		unknown.PayloadBytes = 64;
+		bytes = Bytes(unknown);
+		CHECK(!dds.Parse(bytes.data(), bytes.size()));
+	}
+}
+
+int main()
+{
+	TestMipChain();
+	TestBlockCompressed();
+	TestArray();
+	TestCubeMaps();
+	TestVolume();
+	TestRejected();
+	return TestResult();
+}
\ No newline at end of file
@@ -0,0 +1,216 @@
+#include "FreeListAllocator.h"
+#include "TestCheck.h"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace
+{
+	using uint64 = FreeListAllocator::uint64;
+
+	void TestAllocate()
+	{
+		FreeListAllocator allocator(100);
+		CHECK(allocator.GetCapacity() == 100);
+		CHECK(allocator.Allocate(0) == FreeListAllocator::InvalidOffset);
+
+		uint64 a = allocator.Allocate(10);
+		uint64 b = allocator.Allocate(20);
+		CHECK(a == 0);
+		CHECK(b == 10);
+		CHECK(allocator.GetUsedSize() == 30);
+		CHECK(allocator.GetAllocationCount() == 2);
+
+		// Alignment pads the start and gives the padding back.
+		uint64 c = allocator.Allocate(8, 16);
+		CHECK(c == 32);
+		CHECK(allocator.GetUsedSize() == 38);
+		CHECK(allocator.GetFreeBlockCount() == 2);
+
+		// Any alignment, not only powers of two.
+		uint64 d = allocator.Allocate(5, 3);
+		CHECK(d != FreeListAllocator::InvalidOffset && d % 3 == 0);
+
+		// Too large for what is left.
+		CHECK(allocator.Allocate(100) == FreeListAllocator::InvalidOffset);
+		CHECK(allocator.GetUsedSize() == 43);
+
+		allocator.Reset();
+		CHECK(allocator.GetUsedSize() == 0);
+		CHECK(allocator.GetAllocationCount() == 0);
+		CHECK(allocator.GetLargestFreeBlock() == 100);
+		CHECK(allocator.Allocate(100) == 0);
+		CHECK(allocator.GetFreeSize() == 0);
+		CHECK(allocator.GetLargestFreeBlock() == 0);
+	}
+
+	void TestFreeAndCoalesce()
+	{
+		FreeListAllocator allocator(40);
+		uint64 a = allocator.Allocate(10);
+		uint64 b = allocator.Allocate(10);
+		uint64 c = allocator.Allocate(10);
+		uint64 d = allocator.Allocate(10);
+		CHECK(allocator.GetFreeBlockCount() == 0);
+
+		// Neither neighbour is free.
+		allocator.Free(b);
+		CHECK(allocator.GetFreeBlockCount() == 1);
+		CHECK(allocator.GetLargestFreeBlock() == 10);
+
+		// Merges with the free block in front.
+		allocator.Free(c);
+		CHECK(allocator.GetFreeBlockCount() == 1);
+		CHECK(allocator.GetLargestFreeBlock() == 20);
+
+		// Merges with the free block behind.
+		allocator.Free(a);
+		CHECK(allocator.GetFreeBlockCount() == 1);
+		CHECK(allocator.GetLargestFreeBlock() == 30);
+
+		// Merges on both sides back into one block.
+		uint64 e = allocator.Allocate(10);
+		CHECK(e == a);
+		allocator.Free(d);
+		allocator.Free(e);
+		CHECK(allocator.GetFreeBlockCount() == 1);
+		CHECK(allocator.GetLargestFreeBlock() == 40);
+		CHECK(allocator.GetUsedSize() == 0);
+	}
+
+	void TestBestFit()
+	{
+		// Free blocks of 30, 10 and 20 units: 8 units go into the 10.
+		FreeListAllocator allocator(100);
+		uint64 a = allocator.Allocate(30);
+		allocator.Allocate(5);
+		uint64 b = allocator.Allocate(10);
+		allocator.Allocate(5);
+		uint64 c = allocator.Allocate(20);
+		allocator.Allocate(30);
+		allocator.Free(a);
+		allocator.Free(b);
+		allocator.Free(c);
+
+		CHECK(allocator.Allocate(8) == b);
+		CHECK(allocator.Allocate(15) == c);
+		CHECK(allocator.Allocate(25) == a);
+	}
+
+	void TestGrow()
+	{
+		// Starts empty, like the GeometryArena buffers.
+		FreeListAllocator allocator(0);
+		CHECK(allocator.Allocate(1) == FreeListAllocator::InvalidOffset);
+		allocator.Grow(10);
+		CHECK(allocator.Allocate(10) == 0);
+
+		// The new space stands alone behind a full block.
+		allocator.Grow(30);
+		CHECK(allocator.GetFreeBlockCount() == 1);
+		uint64 a = allocator.Allocate(15);
+		CHECK(a == 10);
+
+		// And merges with a free block at the end, so a range that did not
+		// fit before fits after growing by the difference.
+		CHECK(allocator.Allocate(10) == FreeListAllocator::InvalidOffset);
+		allocator.Grow(35);
+		CHECK(allocator.GetFreeBlockCount() == 1);
+		CHECK(allocator.GetLargestFreeBlock() == 10);
+		CHECK(allocator.Allocate(10) == 25);
+
+		// Shrinking is not a thing.
+		allocator.Grow(20);
+		CHECK(allocator.GetCapacity() == 35);
+		CHECK(allocator.GetUsedSize() == 35);
+
+		allocator.Free(a);
+		CHECK(allocator.GetLargestFreeBlock() == 15);
+		allocator.Reset();
+		CHECK(allocator.GetLargestFreeBlock() == 35);
+	}
+
+	void TestFragmentation()
+	{
+		// Every other block freed: half the space is free, but nothing larger
+		// than one block fits until the neighbours go too.
+		const uint64 blockCount = 64;
+		FreeListAllocator allocator(blockCount * 16);
+		std::vector<uint64> blocks;
+		for (uint64 i = 0; i < blockCount; ++i)
+			blocks.push_back(allocator.Allocate(16));
+		for (uint64 i = 0; i < blockCount; i += 2)
+			allocator.Free(blocks[i]);
+
+		CHECK(allocator.GetFreeSize() == blockCount * 8);
+		CHECK(allocator.GetFreeBlockCount() == blockCount / 2);
+		CHECK(allocator.GetLargestFreeBlock() == 16);
+		CHECK(allocator.Allocate(17) == FreeListAllocator::InvalidOffset);
+
+		for (uint64 i = 1; i < blockCount; i += 2)
+			allocator.Free(blocks[i]);
+		CHECK(allocator.GetFreeBlockCount() == 1);
+		CHECK(allocator.Allocate(blockCount * 16) == 0);
+	}
+
+	void TestRandom()
+	{
+		// Random traffic against a plain occupancy map: ranges never overlap,
+		// the used size adds up and everything merges back at the end.
+		const uint64 capacity = 4096;
+		FreeListAllocator allocator(capacity);
+		std::vector<int> owner(capacity, -1);
+		std::vector<std::pair<uint64, uint64>> live;
+		std::mt19937 random(7);
+
+		for (int step = 0; step < 20000; ++step)
+		{
+			if (live.empty() || random() % 3 != 0)
+			{
+				const uint64 size = 1 + random() % 64;
+				const uint64 alignment = 1 + random() % 8;
+				const uint64 offset = allocator.Allocate(size, alignment);
+				if (offset == FreeListAllocator::InvalidOffset)
+					continue;
+
+				CHECK(offset % alignment == 0 && offset + size <= capacity);
+				for (uint64 i = offset; i < offset + size; ++i)
+				{
+					CHECK(owner[i] == -1);
+					owner[i] = step;
+				}
+				live.emplace_back(offset, size);
+			}
+			else
+			{
+				const size_t victim = random() % live.size();
+				allocator.Free(live[victim].first);
+				std::fill(owner.begin() + live[victim].first, owner.begin() + live[victim].first + live[victim].second, -1);
+				live.erase(live.begin() + victim);
+			}
+
+			uint64 used = 0;
+			for (const auto& allocation : live)
+				used += allocation.second;
+			CHECK(allocator.GetUsedSize() == used);
+			CHECK(allocator.GetAllocationCount() == live.size());
+		}
+
+		for (const auto& allocation : live)
+			allocator.Free(allocation.first);
+		CHECK(allocator.GetUsedSize() == 0);
+		CHECK(allocator.GetFreeBlockCount() == 1);
+		CHECK(allocator.GetLargestFreeBlock() == capacity);
+	}
+}
+
+int main()
+{
+	TestAllocate();
+	TestFreeAndCoalesce();
+	TestBestFit();
+	TestGrow();
+	TestFragmentation();
+	TestRandom();
+	return TestResult();
+}
\ No newline at end of file
@@ -0,0 +1,140 @@
+#include "GeometryGenerator.h"
+#include "GeometryWriter.h"
+#include "PrimitiveTypes.h"
+#include "TestCheck.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+
+// Large spheres and grids written straight into the Demo's vertex layout
+// by GeometryWriter, against the two pass path it replaced: GeometryGenerator
+// builds MeshData, then a loop converts it into the vertex layout.
+namespace
+{
+	using Vertex = PrimitiveTypes::PosTexNorColVertex;
+	using uint32 = std::uint32_t;
+	using Writer = GeometryWriter<Vertex>;
+
+	const DirectX::XMFLOAT4 Color(0.0f, 0.39f, 0.0f, 1.0f);
+
+	struct Mesh
+	{
+		std::vector<Vertex> Vertices;
+		std::vector<uint32> Indices;
+		// Most bytes the path had allocated at once.
+		size_t PeakBytes = 0;
+	};
+
+	Mesh Convert(GeometryGenerator::MeshData& model)
+	{
+		Mesh mesh;
+		mesh.Vertices.resize(model.Vertices.size());
+		for (size_t i = 0; i < model.Vertices.size(); ++i)
+		{
+			const auto& p = model.Vertices[i];
+			mesh.Vertices[i].Position = p.Position;
+			mesh.Vertices[i].TexCoord = p.TexC;
+			mesh.Vertices[i].Normal = p.Normal;
+			mesh.Vertices[i].Color = Color;
+		}
+		mesh.Indices = model.Indices32;
+
+		mesh.PeakBytes = model.Vertices.size() * sizeof(GeometryGenerator::Vertex) + model.Indices32.size() * sizeof(uint32) +
+			mesh.Vertices.size() * sizeof(Vertex) + mesh.Indices.size() * sizeof(uint32);
+		return mesh;
+	}
+
+	Mesh Write(Writer::Counts counts, const std::function<void(Vertex*, uint32*)>& write)
+	{
+		Mesh mesh;
+		mesh.Vertices.resize(counts.VertexCount);
+		mesh.Indices.resize(counts.IndexCount);
+		write(mesh.Vertices.data(), mesh.Indices.data());
+		mesh.PeakBytes = mesh.Vertices.size() * sizeof(Vertex) + mesh.Indices.size() * sizeof(uint32);
+		return mesh;
+	}
+
+	double Milliseconds(const std::function<Mesh()>& build, int repeats, Mesh& result)
+	{
+		double best = 1e30;
+		for (int i = 0; i < repeats; ++i)
+		{
+			auto start = std::chrono::steady_clock::now();
+			result = build();
+			best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+		}
+		return best;
+	}
+
+	bool Near(const DirectX::XMFLOAT3& a, const DirectX::XMFLOAT3& b)
+	{
+		return std::fabs(a.x - b.x) < 1e-4f && std::fabs(a.y - b.y) < 1e-4f && std::fabs(a.z - b.z) < 1e-4f;
+	}
+
+	void Compare(const char* name, const std::function<Mesh()>& twoPass, const std::function<Mesh()>& direct, int repeats)
+	{
+		Mesh reference, written;
+		const double twoPassTime = Milliseconds(twoPass, repeats, reference);
+		const double directTime = Milliseconds(direct, repeats, written);
+
+		printf("%-22s %9zu vertices  two pass %8.2f ms %8.1f MB peak  writer %8.2f ms %8.1f MB peak\n",
+			name, written.Vertices.size(), twoPassTime, reference.PeakBytes / (1024.0 * 1024.0),
+			directTime, written.PeakBytes / (1024.0 * 1024.0));
+
+		// Same shape, vertex order and winding.
+		CHECK(reference.Vertices.size() == written.Vertices.size());
+		CHECK(reference.Indices == written.Indices);
+		for (size_t i = 0; i < std::min(reference.Vertices.size(), written.Vertices.size()); ++i)
+		{
+			const Vertex& a = reference.Vertices[i];
+			const Vertex& b = written.Vertices[i];
+			if (!Near(a.Position, b.Position) || !Near(a.Normal, b.Normal) ||
+				std::fabs(a.TexCoord.x - b.TexCoord.x) > 1e-4f || std::fabs(a.TexCoord.y - b.TexCoord.y) > 1e-4f)
+			{
+				CHECK(!"vertex differs");
+				break;
+			}
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const bool quick = TestCheck::IsQuick(argc, argv);
+	const int repeats = quick ? 1 : 5;
+	GeometryGenerator geoGen;
+
+	const uint32 sphereSizes[] = { 64, 256, 1024 };
+	for (uint32 slices : sphereSizes)
+	{
+		if (quick && slices > 64)
+			break;
+
+		char name[64];
+		snprintf(name, sizeof(name), "sphere %ux%u", slices, slices);
+		Compare(name,
+			[&]() { auto model = geoGen.CreateSphere(1.0f, slices, slices); return Convert(model); },
+			[&]() { return Write(Writer::SphereCounts(slices, slices),
+				[&](Vertex* v, uint32* i) { Writer::WriteSphere(v, i, 1.0f, slices, slices, Color); }); },
+			repeats);
+	}
+
+	const uint32 gridSizes[] = { 64, 512, 2048 };
+	for (uint32 size : gridSizes)
+	{
+		if (quick && size > 64)
+			break;
+
+		char name[64];
+		snprintf(name, sizeof(name), "grid %ux%u", size, size);
+		Compare(name,
+			[&]() { auto model = geoGen.CreateGrid(64.0f, 64.0f, size, size); return Convert(model); },
+			[&]() { return Write(Writer::GridCounts(size, size),
+				[&](Vertex* v, uint32* i) { Writer::WriteGrid(v, i, 64.0f, 64.0f, size, size, Color); }); },
+			repeats);
+	}
+
+	return TestResult();
+}
\ No newline at end of file
@@ -0,0 +1,91 @@
+#include "GeometryGenerator.h"
+#include "TestCheck.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+// Compares the geosphere built with shared edge midpoints against the old
+// duplicating subdivision: vertex count, memory and generation time.
+namespace
+{
+	struct Result
+	{
+		size_t Vertices = 0;
+		size_t Indices = 0;
+		size_t Bytes = 0;
+		double Milliseconds = 0.0;
+	};
+
+	Result Measure(GeometryGenerator::uint32 level, bool shareVertices, int repeats)
+	{
+		GeometryGenerator geoGen;
+		Result result;
+		result.Milliseconds = 1e30;
+		for (int i = 0; i < repeats; ++i)
+		{
+			auto start = std::chrono::steady_clock::now();
+			GeometryGenerator::MeshData sphere = geoGen.CreateGeosphere(1.0f, level, shareVertices);
+			auto stop = std::chrono::steady_clock::now();
+
+			result.Vertices = sphere.Vertices.size();
+			result.Indices = sphere.Indices32.size();
+			result.Bytes = sphere.Vertices.size() * sizeof(GeometryGenerator::Vertex) + sphere.Indices32.size() * sizeof(GeometryGenerator::uint32);
+			result.Milliseconds = std::min(result.Milliseconds, std::chrono::duration<double, std::milli>(stop - start).count());
+		}
+		return result;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const bool quick = TestCheck::IsQuick(argc, argv);
+	const int repeats = quick ? 1 : 5;
+
+	printf("level  path    vertices   indices    memory KB  ms\n");
+	// The shared path goes up to 8 levels, the duplicating one is capped at
+	// 6.  Under --quick the last levels are left out.
+	const GeometryGenerator::uint32 sharedLevels = quick ? 6u : 8u, splitLevels = quick ? 4u : 6u;
+	for (GeometryGenerator::uint32 level = 0; level <= sharedLevels; ++level)
+	{
+		const Result shared = Measure(level, true, repeats);
+		printf("%5u  shared  %9zu  %9zu  %9.1f  %.3f\n", level, shared.Vertices, shared.Indices, shared.Bytes / 1024.0, shared.Milliseconds);
+
+		// A closed icosphere has V = 10 * 4^n + 2 and F = 20 * 4^n.
+		CHECK(shared.Vertices == 10 * ((size_t)1 << (2 * level)) + 2);
+		CHECK(shared.Indices == 60 * ((size_t)1 << (2 * level)));
+		if (level > splitLevels)
+			continue;
+
+		// The same triangles either way.
+		const Result split = Measure(level, false, repeats);
+		printf("%5u  split   %9zu  %9zu  %9.1f  %.3f\n", level, split.Vertices, split.Indices, split.Bytes / 1024.0, split.Milliseconds);
+		CHECK(shared.Indices == split.Indices);
+		CHECK(shared.Vertices <= split.Vertices);
+	}
+
+	// Every vertex still lies on the sphere and each edge is shared by
+	// exactly two triangles.
+	GeometryGenerator geoGen;
+	GeometryGenerator::MeshData sphere = geoGen.CreateGeosphere(2.0f, 3);
+	for (const auto& v : sphere.Vertices)
+	{
+		const float r = std::sqrt(v.Position.x * v.Position.x + v.Position.y * v.Position.y + v.Position.z * v.Position.z);
+		CHECK(std::fabs(r - 2.0f) < 1e-4f);
+	}
+	std::vector<std::pair<GeometryGenerator::uint32, GeometryGenerator::uint32>> edges;
+	for (size_t i = 0; i < sphere.Indices32.size(); i += 3)
+	{
+		for (int e = 0; e < 3; ++e)
+		{
+			GeometryGenerator::uint32 a = sphere.Indices32[i + e];
+			GeometryGenerator::uint32 b = sphere.Indices32[i + (e + 1) % 3];
+			edges.emplace_back(std::min(a, b), std::max(a, b));
+		}
+	}
+	std::sort(edges.begin(), edges.end());
+	for (size_t i = 0; i < edges.size(); i += 2)
+		CHECK(i + 1 < edges.size() && edges[i] == edges[i + 1] && (i + 2 >= edges.size() || edges[i + 2] != edges[i]));
+
+	return TestResult();
+}
\ No newline at end of file
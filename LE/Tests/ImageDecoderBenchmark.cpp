@@ -0,0 +1,74 @@
+#include "ImageDecoder.h"
+#include "MappedFile.h"
+#include "TestCheck.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Decode time of the larger images of the demo on one thread against one
+// per hardware thread.  The JPEG has no restart markers, so only its color
+// conversion runs in parallel, the PNGs filter in order and convert in
+// parallel.
+namespace
+{
+	using uint32 = ImageDecoder::uint32;
+
+	const char* const Images[] =
+	{
+		"Bomb/maps/masheng-01.jpg",
+		"Textures/tex_grid.png",
+		"Textures/Char_015_tex_body_base.png",
+		"fbx/textures/Ambient_Occlusion.png",
+	};
+
+	// Best of iterations, in milliseconds.
+	double TimeDecode(const MappedFile& file, const ImageDecoder::Info& info, std::vector<unsigned char>& pixels,
+		uint32 threadCount, int iterations)
+	{
+		const size_t rowPitch = (size_t)info.Width * info.BytesPerPixel;
+		double best = 1e30;
+		for (int i = 0; i < iterations; ++i)
+		{
+			const auto start = std::chrono::steady_clock::now();
+			const bool decoded = ImageDecoder::Decode(file.GetData(), file.GetSize(), pixels.data(), rowPitch, threadCount);
+			const auto stop = std::chrono::steady_clock::now();
+			CHECK(decoded);
+			best = std::min(best, std::chrono::duration<double, std::milli>(stop - start).count());
+		}
+		return best;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const bool quick = TestCheck::IsQuick(argc, argv);
+	const int iterations = quick ? 1 : 10;
+	const uint32 threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+	printf("%-40s %11s %10s %10s %10s\n", "image", "size", "1 thread", "threads", "speedup");
+	for (const char* image : Images)
+	{
+		MappedFile file;
+		ImageDecoder::Info info;
+		CHECK(file.Open(std::string(LE_ASSET_DIR "/") + image));
+		if (!file.GetData() || !ImageDecoder::ReadInfo(file.GetData(), file.GetSize(), info))
+		{
+			CHECK(false);
+			continue;
+		}
+
+		std::vector<unsigned char> pixels((size_t)info.Width * info.Height * info.BytesPerPixel);
+		const double single = TimeDecode(file, info, pixels, 1, iterations);
+		const double several = TimeDecode(file, info, pixels, threadCount, iterations);
+
+		char size[32];
+		snprintf(size, sizeof(size), "%ux%u", info.Width, info.Height);
+		printf("%-40s %11s %8.2fms %8.2fms %9.2fx  (%.0f MPixel/s on %u threads)\n", image, size, single, several,
+			single / several, info.Width * (double)info.Height / several / 1000.0, threadCount);
+	}
+
+	return TestResult();
+}
\ No newline at end of file
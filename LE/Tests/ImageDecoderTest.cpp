@@ -0,0 +1,510 @@
+#include "HashUtil.h"
+#include "ImageDecoder.h"
+#include "MappedFile.h"
+#include "TestCheck.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace
+{
+	using uint8 = std::uint8_t;
+	using uint32 = ImageDecoder::uint32;
+	using PixelFormat = ImageDecoder::PixelFormat;
+	using Bytes = std::vector<uint8>;
+
+	void PutBE32(Bytes& out, uint32 value)
+	{
+		out.push_back((uint8)(value >> 24));
+		out.push_back((uint8)(value >> 16));
+		out.push_back((uint8)(value >> 8));
+		out.push_back((uint8)value);
+	}
+
+	void PutLE16(uint8* out, uint32 value)
+	{
+		out[0] = (uint8)value;
+		out[1] = (uint8)(value >> 8);
+	}
+
+	uint32 Crc32(const uint8* data, size_t byteSize)
+	{
+		uint32 crc = 0xFFFFFFFFu;
+		for (size_t i = 0; i < byteSize; ++i)
+		{
+			crc ^= data[i];
+			for (int k = 0; k < 8; ++k)
+				crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+		}
+		return ~crc;
+	}
+
+	void PutChunk(Bytes& png, const char* type, const Bytes& data)
+	{
+		PutBE32(png, (uint32)data.size());
+		const size_t start = png.size();
+		png.insert(png.end(), type, type + 4);
+		png.insert(png.end(), data.begin(), data.end());
+		PutBE32(png, Crc32(png.data() + start, png.size() - start));
+	}
+
+	// A zlib stream of stored blocks, so the test does not need a deflater.
+	Bytes Store(const Bytes& data)
+	{
+		Bytes out = { 0x78, 0x01 };
+		size_t offset = 0;
+		do
+		{
+			const size_t size = std::min<size_t>(data.size() - offset, 65535);
+			out.push_back(offset + size == data.size() ? 1 : 0);
+			out.push_back((uint8)size);
+			out.push_back((uint8)(size >> 8));
+			out.push_back((uint8)~size);
+			out.push_back((uint8)(~size >> 8));
+			out.insert(out.end(), data.begin() + offset, data.begin() + offset + size);
+			offset += size;
+		} while (offset < data.size());
+
+		uint32 a = 1, b = 0;
+		for (uint8 value : data)
+		{
+			a = (a + value) % 65521;
+			b = (b + a) % 65521;
+		}
+		PutBE32(out, (b << 16) | a);
+		return out;
+	}
+
+	uint8 Paeth(int a, int b, int c)
+	{
+		const int p = a + b - c;
+		const int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+		return (uint8)(pa <= pb && pa <= pc ? a : pb <= pc ? b : c);
+	}
+
+	// Rows of raw samples as a PNG, row y filtered with filter y % 5 so all
+	// five are undone.  The IDAT is split in two to join them too.
+	Bytes MakePng(uint32 width, uint32 height, uint32 colorType, uint32 bitDepth, const Bytes& samples,
+		const Bytes& palette = Bytes(), const Bytes& transparency = Bytes(), bool srgb = false)
+	{
+		const uint32 channels = colorType == 0 || colorType == 3 ? 1 : colorType == 2 ? 3 : colorType == 4 ? 2 : 4;
+		const size_t rowBytes = ((size_t)width * channels * bitDepth + 7) / 8;
+		const size_t bpp = std::max<size_t>(1, channels * bitDepth / 8);
+
+		Bytes filtered;
+		Bytes zeros(rowBytes);
+		for (uint32 y = 0; y < height; ++y)
+		{
+			const uint8* row = samples.data() + y * rowBytes;
+			const uint8* prior = y > 0 ? row - rowBytes : zeros.data();
+			const uint8 filter = (uint8)(y % 5);
+			filtered.push_back(filter);
+			for (size_t i = 0; i < rowBytes; ++i)
+			{
+				const int left = i >= bpp ? row[i - bpp] : 0;
+				const int upLeft = i >= bpp ? prior[i - bpp] : 0;
+				int predicted = 0;
+				switch (filter)
+				{
+				case 1: predicted = left; break;
+				case 2: predicted = prior[i]; break;
+				case 3: predicted = (left + prior[i]) / 2; break;
+				case 4: predicted = Paeth(left, prior[i], upLeft); break;
+				}
+				filtered.push_back((uint8)(row[i] - predicted));
+			}
+		}
+
+		Bytes png = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+		Bytes header;
+		PutBE32(header, width);
+		PutBE32(header, height);
+		header.insert(header.end(), { (uint8)bitDepth, (uint8)colorType, 0, 0, 0 });
+		PutChunk(png, "IHDR", header);
+		if (srgb)
+			PutChunk(png, "sRGB", Bytes(1, 0));
+		if (!palette.empty())
+			PutChunk(png, "PLTE", palette);
+		if (!transparency.empty())
+			PutChunk(png, "tRNS", transparency);
+
+		const Bytes stream = Store(filtered);
+		const size_t half = stream.size() / 2;
+		PutChunk(png, "IDAT", Bytes(stream.begin(), stream.begin() + half));
+		PutChunk(png, "IDAT", Bytes(stream.begin() + half, stream.end()));
+		PutChunk(png, "IEND", Bytes());
+		return png;
+	}
+
+	Bytes Samples(size_t byteSize, uint32 seed)
+	{
+		Bytes samples(byteSize);
+		for (size_t i = 0; i < byteSize; ++i)
+			samples[i] = (uint8)(i * 13 + (i * i >> 5) + seed * 101);
+		return samples;
+	}
+
+	// Decodes with a row pitch padded past the row, and checks the padding
+	// is left alone and one thread gives the same bytes as several.
+	bool DecodeRows(const Bytes& file, ImageDecoder::Info& info, Bytes& rows)
+	{
+		if (!ImageDecoder::ReadInfo(file.data(), file.size(), info))
+			return false;
+
+		const size_t rowBytes = (size_t)info.Width * info.BytesPerPixel;
+		const size_t pitch = rowBytes + 16;
+		Bytes single(pitch * info.Height, 0xCD);
+		Bytes several(pitch * info.Height, 0xCD);
+		if (!ImageDecoder::Decode(file.data(), file.size(), single.data(), pitch, 1) ||
+			!ImageDecoder::Decode(file.data(), file.size(), several.data(), pitch, 4))
+			return false;
+		CHECK(single == several);
+
+		rows.clear();
+		for (uint32 y = 0; y < info.Height; ++y)
+		{
+			const uint8* row = single.data() + y * pitch;
+			rows.insert(rows.end(), row, row + rowBytes);
+			CHECK(row[rowBytes] == 0xCD && row[pitch - 1] == 0xCD);
+		}
+		return true;
+	}
+
+	void TestPng()
+	{
+		const uint32 width = 19, height = 23;
+		ImageDecoder::Info info;
+		Bytes rows;
+
+		// Gray, 8 and 16 bits: as is, the 16-bit samples little endian.
+		Bytes gray = Samples(width * height, 1);
+		CHECK(DecodeRows(MakePng(width, height, 0, 8, gray), info, rows));
+		CHECK(info.Width == width && info.Height == height);
+		CHECK(info.Format == PixelFormat::R8 && info.BytesPerPixel == 1);
+		CHECK(rows == gray);
+
+		Bytes gray16 = Samples(width * height * 2, 2);
+		CHECK(DecodeRows(MakePng(width, height, 0, 16, gray16), info, rows));
+		CHECK(info.Format == PixelFormat::R16 && info.BytesPerPixel == 2);
+		bool swapped = rows.size() == gray16.size();
+		for (size_t i = 0; swapped && i < gray16.size(); i += 2)
+			swapped = rows[i] == gray16[i + 1] && rows[i + 1] == gray16[i];
+		CHECK(swapped);
+
+		// Gray at 4 bits per sample is scaled to the whole range.
+		Bytes gray4 = Samples((width + 1) / 2 * height, 3);
+		CHECK(DecodeRows(MakePng(width, height, 0, 4, gray4), info, rows));
+		CHECK(info.Format == PixelFormat::R8);
+		bool scaled = rows.size() == (size_t)width * height;
+		for (uint32 y = 0; scaled && y < height; ++y)
+		{
+			for (uint32 x = 0; x < width; ++x)
+			{
+				const uint8 packed = gray4[y * ((width + 1) / 2) + x / 2];
+				scaled = scaled && rows[y * width + x] == ((x & 1 ? packed : packed >> 4) & 15) * 17;
+			}
+		}
+		CHECK(scaled);
+
+		// RGB gets an opaque alpha.
+		Bytes rgb = Samples(width * height * 3, 4);
+		CHECK(DecodeRows(MakePng(width, height, 2, 8, rgb, Bytes(), Bytes(), true), info, rows));
+		CHECK(info.Format == PixelFormat::Rgba8Srgb && info.BytesPerPixel == 4);
+		bool expanded = rows.size() == (size_t)width * height * 4;
+		for (size_t i = 0; expanded && i < (size_t)width * height; ++i)
+		{
+			expanded = rows[i * 4] == rgb[i * 3] && rows[i * 4 + 1] == rgb[i * 3 + 1] &&
+				rows[i * 4 + 2] == rgb[i * 3 + 2] && rows[i * 4 + 3] == 0xFF;
+		}
+		CHECK(expanded);
+
+		// RGBA comes out as BGRA like from WIC, gray with alpha too.
+		Bytes rgba = Samples(width * height * 4, 5);
+		CHECK(DecodeRows(MakePng(width, height, 6, 8, rgba), info, rows));
+		CHECK(info.Format == PixelFormat::Bgra8 && info.BytesPerPixel == 4);
+		bool swizzled = rows.size() == rgba.size();
+		for (size_t i = 0; swizzled && i < rgba.size(); i += 4)
+		{
+			swizzled = rows[i] == rgba[i + 2] && rows[i + 1] == rgba[i + 1] &&
+				rows[i + 2] == rgba[i] && rows[i + 3] == rgba[i + 3];
+		}
+		CHECK(swizzled);
+
+		Bytes grayAlpha = Samples(width * height * 2, 6);
+		CHECK(DecodeRows(MakePng(width, height, 4, 8, grayAlpha), info, rows));
+		CHECK(info.Format == PixelFormat::Bgra8);
+		bool spread = rows.size() == (size_t)width * height * 4;
+		for (size_t i = 0; spread && i < (size_t)width * height; ++i)
+		{
+			spread = rows[i * 4] == grayAlpha[i * 2] && rows[i * 4 + 1] == grayAlpha[i * 2] &&
+				rows[i * 4 + 2] == grayAlpha[i * 2] && rows[i * 4 + 3] == grayAlpha[i * 2 + 1];
+		}
+		CHECK(spread);
+
+		// A 2-bit palette with alpha for its first entries.
+		const Bytes palette = { 10, 20, 30, 40, 50, 60, 70, 80, 90, 100, 110, 120 };
+		const Bytes transparency = { 0, 128 };
+		Bytes indices = Samples((width * 2 + 7) / 8 * height, 7);
+		CHECK(DecodeRows(MakePng(width, height, 3, 2, indices, palette, transparency), info, rows));
+		CHECK(info.Format == PixelFormat::Rgba8 && info.BytesPerPixel == 4);
+		bool looked = rows.size() == (size_t)width * height * 4;
+		for (uint32 y = 0; looked && y < height; ++y)
+		{
+			for (uint32 x = 0; x < width; ++x)
+			{
+				const uint32 index = (indices[y * ((width * 2 + 7) / 8) + x / 4] >> (6 - (x & 3) * 2)) & 3;
+				const uint8* pixel = rows.data() + (y * width + x) * 4;
+				looked = looked && pixel[0] == palette[index * 3] && pixel[1] == palette[index * 3 + 1] &&
+					pixel[2] == palette[index * 3 + 2] && pixel[3] == (index < transparency.size() ? transparency[index] : 0xFF);
+			}
+		}
+		CHECK(looked);
+
+		// Interlaced images are left to WIC.
+		Bytes interlaced = MakePng(width, height, 0, 8, gray);
+		interlaced[8 + 8 + 12] = 1;
+		CHECK(!ImageDecoder::ReadInfo(interlaced.data(), interlaced.size(), info));
+
+		// A stream one row short.
+		Bytes tall = MakePng(width, height, 0, 8, gray);
+		tall[8 + 8 + 7] = (uint8)(height + 1);
+		Bytes out((size_t)width * (height + 1));
+		CHECK(ImageDecoder::ReadInfo(tall.data(), tall.size(), info));
+		CHECK(!ImageDecoder::Decode(tall.data(), tall.size(), out.data(), width));
+	}
+
+	// 8, 24 and 32-bit TGAs, raw and run length coded, either way up.
+	void TestTga()
+	{
+		const uint32 width = 37, height = 13;
+		for (uint32 variant = 0; variant < 12; ++variant)
+		{
+			const uint32 bits = variant / 4 == 0 ? 8 : variant / 4 == 1 ? 24 : 32;
+			const bool rle = (variant & 1) != 0;
+			const bool topDown = (variant & 2) != 0;
+			const uint32 pixelBytes = bits / 8;
+
+			Bytes pixels((size_t)width * height * pixelBytes);
+			for (size_t i = 0; i < pixels.size(); ++i)
+				pixels[i] = (uint8)(i / (pixelBytes * 5) * 11 + i % pixelBytes * 40);
+
+			Bytes file(18, 0);
+			file[2] = (uint8)((bits == 8 ? 3 : 2) | (rle ? 8 : 0));
+			PutLE16(&file[12], width);
+			PutLE16(&file[14], height);
+			file[16] = (uint8)bits;
+			file[17] = (uint8)((bits == 32 ? 8 : 0) | (topDown ? 0x20 : 0));
+			if (!rle)
+			{
+				file.resize(18 + pixels.size());
+				memcpy(&file[18], pixels.data(), pixels.size());
+			}
+			else
+			{
+				// Runs of equal pixels, the rest as single pixel raw packets.
+				const size_t count = (size_t)width * height;
+				for (size_t i = 0; i < count; )
+				{
+					const uint8* pixel = &pixels[i * pixelBytes];
+					size_t run = 1;
+					while (i + run < count && run < 128 && memcmp(pixel, pixel + run * pixelBytes, pixelBytes) == 0)
+						++run;
+					file.push_back((uint8)(run > 1 ? 0x80 | (run - 1) : 0));
+					file.insert(file.end(), pixel, pixel + pixelBytes);
+					i += run;
+				}
+			}
+
+			ImageDecoder::Info info;
+			Bytes rows;
+			CHECK(DecodeRows(file, info, rows));
+			CHECK(info.Format == (bits == 8 ? PixelFormat::R8 : PixelFormat::Rgba8));
+
+			bool same = rows.size() == (size_t)width * height * (bits == 8 ? 1 : 4);
+			for (uint32 y = 0; same && y < height; ++y)
+			{
+				const uint32 sourceY = topDown ? y : height - 1 - y;
+				for (uint32 x = 0; x < width; ++x)
+				{
+					const uint8* source = &pixels[(sourceY * width + x) * pixelBytes];
+					if (bits == 8)
+					{
+						same = same && rows[y * width + x] == source[0];
+						continue;
+					}
+					const uint8* pixel = &rows[(y * width + x) * 4];
+					same = same && pixel[0] == source[2] && pixel[1] == source[1] && pixel[2] == source[0] &&
+						pixel[3] == (bits == 32 ? source[3] : 0xFF);
+				}
+			}
+			CHECK(same);
+
+			// Cut short, the pixels run out.
+			file.resize(file.size() - 1);
+			Bytes out(rows.size());
+			CHECK(!ImageDecoder::Decode(file.data(), file.size(), out.data(), (size_t)width * (bits == 8 ? 1 : 4)));
+		}
+	}
+
+	// Entropy coded bits, most significant first, with 0xFF stuffed.
+	class BitWriter
+	{
+	public:
+		void Put(uint32 value, uint32 count)
+		{
+			for (uint32 i = count; i-- > 0; )
+			{
+				mByte = (mByte << 1) | ((value >> i) & 1);
+				if (++mCount == 8)
+					Flush();
+			}
+		}
+
+		// Pads the last byte with ones like an encoder does.
+		Bytes Finish()
+		{
+			while (mCount != 0)
+				Put(1, 1);
+			return mBytes;
+		}
+
+	private:
+		void Flush()
+		{
+			mBytes.push_back((uint8)mByte);
+			if (mByte == 0xFF)
+				mBytes.push_back(0);
+			mByte = 0;
+			mCount = 0;
+		}
+
+		Bytes mBytes;
+		uint32 mByte = 0;
+		uint32 mCount = 0;
+	};
+
+	// A gray JPEG that drives the DC predictor and the dequantized
+	// coefficients past int16: 16-bit quantization tables of 65535 and every
+	// block adding the largest DC difference, with no AC coefficients.
+	Bytes MakeOverflowJpeg(uint32 width, uint32 height, bool negative)
+	{
+		Bytes jpeg = { 0xFF, 0xD8 };
+
+		jpeg.insert(jpeg.end(), { 0xFF, 0xDB, 0, 2 + 1 + 128, 0x10 });
+		jpeg.insert(jpeg.end(), 128, 0xFF);
+
+		// One code of one bit each: DC category 11, AC end of block.
+		jpeg.insert(jpeg.end(), { 0xFF, 0xC4, 0, 2 + 17 + 1, 0x00, 1 });
+		jpeg.insert(jpeg.end(), 15, 0);
+		jpeg.push_back(11);
+		jpeg.insert(jpeg.end(), { 0xFF, 0xC4, 0, 2 + 17 + 1, 0x10, 1 });
+		jpeg.insert(jpeg.end(), 15, 0);
+		jpeg.push_back(0);
+
+		jpeg.insert(jpeg.end(), { 0xFF, 0xC0, 0, 11, 8, (uint8)(height >> 8), (uint8)height,
+			(uint8)(width >> 8), (uint8)width, 1, 1, 0x11, 0 });
+		jpeg.insert(jpeg.end(), { 0xFF, 0xDA, 0, 8, 1, 1, 0x00, 0, 63, 0 });
+
+		BitWriter bits;
+		const uint32 blocks = (width + 7) / 8 * ((height + 7) / 8);
+		for (uint32 i = 0; i < blocks; ++i)
+		{
+			bits.Put(0, 1);
+			// +2047, or -2047 as its ones' complement.
+			bits.Put(negative ? 0 : 0x7FF, 11);
+			bits.Put(0, 1);
+		}
+		const Bytes scan = bits.Finish();
+		jpeg.insert(jpeg.end(), scan.begin(), scan.end());
+		jpeg.insert(jpeg.end(), { 0xFF, 0xD9 });
+		return jpeg;
+	}
+
+	void TestJpegOverflow()
+	{
+		const uint32 width = 40, height = 24;
+		for (bool negative : { false, true })
+		{
+			const Bytes jpeg = MakeOverflowJpeg(width, height, negative);
+			ImageDecoder::Info info;
+			Bytes rows;
+			CHECK(DecodeRows(jpeg, info, rows));
+			CHECK(info.Width == width && info.Height == height && info.Format == PixelFormat::R8);
+			CHECK(rows == Bytes((size_t)width * height, negative ? 0 : 0xFF));
+
+			// Every truncation either fails or decodes, without reading past
+			// the end.
+			for (size_t size = 0; size < jpeg.size(); ++size)
+			{
+				const Bytes cut(jpeg.begin(), jpeg.begin() + size);
+				if (ImageDecoder::ReadInfo(cut.data(), cut.size(), info))
+				{
+					Bytes out((size_t)info.Width * info.Height * info.BytesPerPixel);
+					ImageDecoder::Decode(cut.data(), cut.size(), out.data(), (size_t)info.Width * info.BytesPerPixel);
+				}
+			}
+		}
+	}
+
+	// Images of the demo, with the hash of what libpng and libjpeg (islow
+	// IDCT) decode them to in the same format.
+	struct Asset
+	{
+		const char* Path;
+		uint32 Width;
+		uint32 Height;
+		PixelFormat Format;
+		HashUtil::uint64 Hash;
+	};
+
+	const Asset Assets[] =
+	{
+		{ "Textures/tex_grid.png", 512, 512, PixelFormat::Bgra8, 0x7bb51106acc6e250ull },
+		{ "Textures/Char_015_tex_body_base.png", 2048, 2048, PixelFormat::Bgra8, 0xb50ef9e629926f37ull },
+		{ "fbx/textures/internal_ground_ao_texture.jpeg", 512, 512, PixelFormat::Rgba8, 0x506774660338646cull },
+		{ "Bomb/maps/kulou-01.jpg", 512, 330, PixelFormat::Rgba8, 0x0b0b8920c2feca1full },
+		{ "Bomb/maps/masheng-01.jpg", 1200, 580, PixelFormat::Rgba8Srgb, 0x561b42da4053835bull },
+	};
+
+	void TestAssets()
+	{
+		for (const Asset& asset : Assets)
+		{
+			MappedFile file;
+			CHECK(file.Open(std::string(LE_ASSET_DIR "/") + asset.Path));
+			const Bytes data(file.GetData(), file.GetData() + file.GetSize());
+
+			ImageDecoder::Info info;
+			Bytes rows;
+			CHECK(DecodeRows(data, info, rows));
+			CHECK(info.Width == asset.Width && info.Height == asset.Height && info.Format == asset.Format);
+			CHECK(HashUtil::HashBytes(rows.data(), rows.size()) == asset.Hash);
+
+			// Damaged copies fail or decode something, without crashing.
+			srand(1);
+			for (int k = 0; k < 8; ++k)
+			{
+				Bytes damaged = data;
+				for (int m = 0; m < 50; ++m)
+					damaged[100 + rand() % (damaged.size() - 100)] = (uint8)rand();
+				damaged.resize(damaged.size() - rand() % (damaged.size() / 2));
+				if (ImageDecoder::ReadInfo(damaged.data(), damaged.size(), info))
+				{
+					Bytes out((size_t)info.Width * info.Height * info.BytesPerPixel);
+					ImageDecoder::Decode(damaged.data(), damaged.size(), out.data(), (size_t)info.Width * info.BytesPerPixel);
+				}
+			}
+		}
+	}
+}
+
+int main()
+{
+	TestPng();
+	TestTga();
+	TestJpegOverflow();
+	TestAssets();
+	return TestResult();
+}
\ No newline at end of file
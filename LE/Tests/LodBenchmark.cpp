@@ -0,0 +1,134 @@
+#include "LodSelector.h"
+#include "MeshSimplifier.h"
+#include "TestCheck.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+// Triangles submitted with per-instance LOD selection against drawing every
+// instance at full detail, on a camera flying through a field of bumpy
+// spheres.  Uses the settings of the Demo: a chain of 5 levels halving the
+// triangles down to 5% of the radius, a 1 pixel threshold and 25% hysteresis.
+namespace
+{
+	using uint32 = MeshSimplifier::uint32;
+
+	struct Position
+	{
+		float x, y, z;
+	};
+
+	struct Level
+	{
+		float Error = 0.0f;
+		uint32 TriangleCount = 0;
+	};
+
+	const float Pi = 3.14159265f;
+
+	// A unit sphere with some low frequency bumps, so the levels have
+	// something to lose.
+	void BuildSphere(uint32 stacks, uint32 slices, std::vector<Position>& positions, std::vector<uint32>& indices)
+	{
+		for (uint32 i = 0; i <= stacks; ++i)
+		{
+			const float phi = Pi * i / stacks;
+			for (uint32 j = 0; j <= slices; ++j)
+			{
+				const float theta = 2.0f * Pi * j / slices;
+				const float r = 1.0f + 0.05f * std::sin(5.0f * phi) * std::cos(7.0f * theta);
+				positions.push_back({ r * std::sin(phi) * std::cos(theta), r * std::cos(phi), r * std::sin(phi) * std::sin(theta) });
+			}
+		}
+
+		for (uint32 i = 0; i < stacks; ++i)
+		{
+			for (uint32 j = 0; j < slices; ++j)
+			{
+				const uint32 a = i * (slices + 1) + j;
+				const uint32 b = a + slices + 1;
+				indices.insert(indices.end(), { a, b, a + 1, a + 1, b, b + 1 });
+			}
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const bool quick = TestCheck::IsQuick(argc, argv);
+	const uint32 stacks = quick ? 48 : 128;
+	const uint32 gridSize = quick ? 6 : 16;
+	const uint32 frameCount = quick ? 120 : 1200;
+	const float spacing = 6.0f;
+
+	std::vector<Position> positions;
+	std::vector<uint32> indices;
+	BuildSphere(stacks, stacks * 2, positions, indices);
+
+	auto start = std::chrono::steady_clock::now();
+	auto chain = MeshSimplifier::BuildLodChain(indices, &positions[0].x, positions.size(), sizeof(Position), 5, 0.5f, 0.05f);
+	std::chrono::duration<double, std::milli> simplifyTime = std::chrono::steady_clock::now() - start;
+	printf("%s", MeshSimplifier::ToString("sphere", chain).c_str());
+	printf("chain built in %.1f ms\n", simplifyTime.count());
+
+	std::vector<Level> lods;
+	for (const auto& level : chain)
+		lods.push_back({ level.Error, (uint32)level.Indices.size() / 3 });
+	CHECK(lods.size() > 1);
+	for (size_t i = 1; i < lods.size(); ++i)
+		CHECK(lods[i].TriangleCount < lods[i - 1].TriangleCount && lods[i].Error >= lods[i - 1].Error);
+
+	LodSelector selector;
+	selector.SetProjection(0.25f * Pi, 1080.0f);
+	selector.SetThreshold(1.0f, 0.25f);
+
+	// Instances on a grid in the xz plane, the camera flies diagonally
+	// across it at head height and out the other side.
+	std::vector<Position> instances;
+	for (uint32 z = 0; z < gridSize; ++z)
+	{
+		for (uint32 x = 0; x < gridSize; ++x)
+			instances.push_back({ x * spacing, 0.0f, z * spacing });
+	}
+	std::vector<uint32> current(instances.size(), 0);
+
+	const float extent = (gridSize - 1) * spacing;
+	uint64_t fullTriangles = 0;
+	uint64_t lodTriangles = 0;
+	uint64_t switches = 0;
+	uint64_t largestStep = 0;
+	double selectMilliseconds = 0.0;
+	for (uint32 frame = 0; frame < frameCount; ++frame)
+	{
+		const float t = (float)frame / (frameCount - 1);
+		const Position eye = { -20.0f + t * (extent + 40.0f), 1.7f, -20.0f + t * (extent + 40.0f) };
+
+		auto selectStart = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < instances.size(); ++i)
+		{
+			const float dx = instances[i].x - eye.x, dy = instances[i].y - eye.y, dz = instances[i].z - eye.z;
+			const float distance = std::sqrt(dx * dx + dy * dy + dz * dz);
+			const uint32 lod = selector.Select(lods, current[i], 1.0f, distance);
+
+			// The chosen level never looks worse than the threshold plus the
+			// hysteresis band.
+			CHECK(lod == 0 || selector.ProjectedError(lods[lod].Error, 1.0f, distance) <= 1.25f + 1e-4f);
+
+			switches += lod != current[i];
+			largestStep = std::max<uint64_t>(largestStep, lod > current[i] ? lod - current[i] : current[i] - lod);
+			current[i] = lod;
+			fullTriangles += lods[0].TriangleCount;
+			lodTriangles += lods[lod].TriangleCount;
+		}
+		selectMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - selectStart).count();
+	}
+
+	printf("%u instances, %u frames\n", (uint32)instances.size(), frameCount);
+	printf("full detail: %.0f triangles per frame\n", (double)fullTriangles / frameCount);
+	printf("with lod:    %.0f triangles per frame (%.1f%%)\n", (double)lodTriangles / frameCount, 100.0 * lodTriangles / fullTriangles);
+	printf("%.3f level switches per instance and frame, %.4f ms selection per frame\n",
+		(double)switches / ((double)frameCount * instances.size()), selectMilliseconds / frameCount);
+
+	CHECK(lodTriangles < fullTriangles);
+	return TestResult();
+}
\ No newline at end of file
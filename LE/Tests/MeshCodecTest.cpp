@@ -0,0 +1,164 @@
+#include "MeshCodec.h"
+#include "TestCheck.h"
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace
+{
+	using uint8 = MeshCodec::uint8;
+	using uint16 = MeshCodec::uint16;
+	using uint32 = MeshCodec::uint32;
+
+	struct Vertex
+	{
+		float Position[3];
+		float Normal[3];
+		float TexCoord[2];
+	};
+
+	// A grid, so the streams look like a real mesh: neighbouring vertices
+	// close together and triangles sharing edges.
+	void MakeGrid(uint32 size, std::vector<Vertex>& vertices, std::vector<uint32>& indices)
+	{
+		for (uint32 z = 0; z <= size; ++z)
+		{
+			for (uint32 x = 0; x <= size; ++x)
+			{
+				Vertex v = {};
+				v.Position[0] = (float)x;
+				v.Position[1] = 0.1f * (float)((x * 7 + z * 3) % 5);
+				v.Position[2] = (float)z;
+				v.Normal[1] = 1.0f;
+				v.TexCoord[0] = (float)x / size;
+				v.TexCoord[1] = (float)z / size;
+				vertices.push_back(v);
+			}
+		}
+		for (uint32 z = 0; z < size; ++z)
+		{
+			for (uint32 x = 0; x < size; ++x)
+			{
+				const uint32 i = z * (size + 1) + x;
+				indices.insert(indices.end(), { i, i + size + 1, i + 1, i + 1, i + size + 1, i + size + 2 });
+			}
+		}
+	}
+
+	void TestRoundTrip(const std::vector<Vertex>& vertices, const std::vector<uint32>& indices)
+	{
+		const std::vector<uint8> encodedVertices = MeshCodec::EncodeVertices(vertices.data(), vertices.size(), sizeof(Vertex));
+		std::vector<Vertex> decodedVertices(vertices.size());
+		CHECK(MeshCodec::DecodeVertices(decodedVertices.data(), vertices.size(), sizeof(Vertex),
+			encodedVertices.data(), encodedVertices.size()));
+		CHECK(memcmp(decodedVertices.data(), vertices.data(), vertices.size() * sizeof(Vertex)) == 0);
+
+		// Triangles may come back rotated, with the same winding.
+		const std::vector<uint8> encodedIndices = MeshCodec::EncodeIndices(indices.data(), indices.size());
+		std::vector<uint32> decodedIndices(indices.size());
+		CHECK(MeshCodec::DecodeIndices(decodedIndices.data(), indices.size(), encodedIndices.data(), encodedIndices.size()));
+		for (size_t t = 0; t < indices.size(); t += 3)
+		{
+			bool same = false;
+			for (int r = 0; r < 3; ++r)
+			{
+				same = same || (decodedIndices[t] == indices[t + r] && decodedIndices[t + 1] == indices[t + (r + 1) % 3] &&
+					decodedIndices[t + 2] == indices[t + (r + 2) % 3]);
+			}
+			CHECK(same);
+		}
+	}
+
+	// Every truncation has to be rejected, never read past the stream.
+	void TestTruncated(const std::vector<Vertex>& vertices, const std::vector<uint32>& indices)
+	{
+		const std::vector<uint8> encodedVertices = MeshCodec::EncodeVertices(vertices.data(), vertices.size(), sizeof(Vertex));
+		std::vector<Vertex> decodedVertices(vertices.size());
+		for (size_t size = 0; size < encodedVertices.size(); ++size)
+		{
+			// A copy of exactly size bytes, so a read past it is caught by
+			// the sanitizers.
+			const std::vector<uint8> truncated(encodedVertices.begin(), encodedVertices.begin() + size);
+			CHECK(!MeshCodec::DecodeVertices(decodedVertices.data(), vertices.size(), sizeof(Vertex), truncated.data(), size));
+		}
+
+		const std::vector<uint8> encodedIndices = MeshCodec::EncodeIndices(indices.data(), indices.size());
+		std::vector<uint32> decodedIndices(indices.size());
+		for (size_t size = 0; size < encodedIndices.size(); ++size)
+		{
+			const std::vector<uint8> truncated(encodedIndices.begin(), encodedIndices.begin() + size);
+			CHECK(!MeshCodec::DecodeIndices(decodedIndices.data(), indices.size(), truncated.data(), size));
+		}
+	}
+
+	// A flipped bit may still decode to something, but never out of the
+	// destination or the stream.  Run under the sanitizers to see.
+	void TestBitFlips(const std::vector<Vertex>& vertices, const std::vector<uint32>& indices)
+	{
+		std::mt19937 random(7);
+
+		const std::vector<uint8> encodedVertices = MeshCodec::EncodeVertices(vertices.data(), vertices.size(), sizeof(Vertex));
+		const std::vector<uint8> encodedIndices = MeshCodec::EncodeIndices(indices.data(), indices.size());
+		std::vector<Vertex> decodedVertices(vertices.size());
+		std::vector<uint32> decodedIndices(indices.size());
+
+		int rejected = 0;
+		for (int i = 0; i < 2000; ++i)
+		{
+			std::vector<uint8> flipped = encodedVertices;
+			flipped[random() % flipped.size()] ^= (uint8)(1 << (random() % 8));
+			rejected += !MeshCodec::DecodeVertices(decodedVertices.data(), vertices.size(), sizeof(Vertex), flipped.data(), flipped.size());
+
+			flipped = encodedIndices;
+			flipped[random() % flipped.size()] ^= (uint8)(1 << (random() % 8));
+			rejected += !MeshCodec::DecodeIndices(decodedIndices.data(), indices.size(), flipped.data(), flipped.size());
+		}
+		printf("%d of 4000 bit flips rejected\n", rejected);
+	}
+
+	// What MeshCooker::Build relies on: one bad stream fails the whole batch.
+	void TestParallel(const std::vector<Vertex>& vertices, const std::vector<uint32>& indices)
+	{
+		const std::vector<uint8> encodedVertices = MeshCodec::EncodeVertices(vertices.data(), vertices.size(), sizeof(Vertex));
+		std::vector<uint16> indices16(indices.begin(), indices.end());
+		const std::vector<uint8> encodedIndices = MeshCodec::EncodeIndices(indices16.data(), indices16.size());
+
+		std::vector<Vertex> decodedVertices(vertices.size());
+		std::vector<uint16> decodedIndices(indices.size());
+		std::vector<MeshCodec::DecodeJob> jobs(2);
+		jobs[0].Type = MeshCodec::DecodeJob::Kind::Vertices;
+		jobs[0].Destination = decodedVertices.data();
+		jobs[0].Count = vertices.size();
+		jobs[0].VertexByteStride = sizeof(Vertex);
+		jobs[0].Data = encodedVertices.data();
+		jobs[0].DataSize = encodedVertices.size();
+		jobs[1].Type = MeshCodec::DecodeJob::Kind::Indices16;
+		jobs[1].Destination = decodedIndices.data();
+		jobs[1].Count = indices.size();
+		jobs[1].Data = encodedIndices.data();
+		jobs[1].DataSize = encodedIndices.size();
+
+		CHECK(MeshCodec::DecodeParallel(jobs, 4));
+		CHECK(memcmp(decodedVertices.data(), vertices.data(), vertices.size() * sizeof(Vertex)) == 0);
+
+		jobs[1].DataSize /= 2;
+		CHECK(!MeshCodec::DecodeParallel(jobs, 4));
+
+		jobs[1].DataSize = encodedIndices.size();
+		jobs[0].DataSize -= 1;
+		CHECK(!MeshCodec::DecodeParallel(jobs, 4));
+	}
+}
+
+int main()
+{
+	std::vector<Vertex> vertices;
+	std::vector<uint32> indices;
+	MakeGrid(40, vertices, indices);
+
+	TestRoundTrip(vertices, indices);
+	TestTruncated(vertices, indices);
+	TestBitFlips(vertices, indices);
+	TestParallel(vertices, indices);
+	return TestResult();
+}
\ No newline at end of file
@@ -0,0 +1,190 @@
+#include "MeshOptimizer.h"
+#include "TestCheck.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace
+{
+	using uint16 = MeshOptimizer::uint16;
+	using uint32 = MeshOptimizer::uint32;
+
+	struct Vertex
+	{
+		struct
+		{
+			float x, y, z;
+		} Position;
+		// Where the vertex was made, to follow it through a remap.
+		uint32 Id;
+	};
+
+	// A grid of quads with its triangles in random order, about the worst a
+	// mesh exporter hands over, and one vertex no triangle uses.
+	void MakeShuffledGrid(uint32 size, std::vector<Vertex>& vertices, std::vector<uint32>& indices)
+	{
+		for (uint32 z = 0; z <= size; ++z)
+		{
+			for (uint32 x = 0; x <= size; ++x)
+				vertices.push_back({ { (float)x, 0.0f, (float)z }, (uint32)vertices.size() });
+		}
+		vertices.push_back({ { -1.0f, 0.0f, -1.0f }, (uint32)vertices.size() });
+
+		std::vector<uint32> quads;
+		for (uint32 z = 0; z < size; ++z)
+		{
+			for (uint32 x = 0; x < size; ++x)
+				quads.push_back(z * (size + 1) + x);
+		}
+		std::mt19937 random(1);
+		std::shuffle(quads.begin(), quads.end(), random);
+		for (uint32 i : quads)
+			indices.insert(indices.end(), { i, i + size + 1, i + 1, i + 1, i + size + 1, i + size + 2 });
+	}
+
+	// A torus around y with a wavy tube: closed, and from most directions
+	// one part of it hides another.
+	void MakeTorus(uint32 rings, uint32 sides, std::vector<Vertex>& vertices, std::vector<uint32>& indices)
+	{
+		const float pi = 3.14159265f;
+		for (uint32 r = 0; r < rings; ++r)
+		{
+			const float u = 2.0f * pi * r / rings;
+			for (uint32 s = 0; s < sides; ++s)
+			{
+				const float v = 2.0f * pi * s / sides;
+				const float tube = 0.4f + 0.1f * std::sin(5.0f * u);
+				const float radius = 1.0f + tube * std::cos(v);
+				vertices.push_back({ { radius * std::cos(u), tube * std::sin(v), radius * std::sin(u) }, (uint32)vertices.size() });
+			}
+		}
+		for (uint32 r = 0; r < rings; ++r)
+		{
+			for (uint32 s = 0; s < sides; ++s)
+			{
+				const uint32 a = r * sides + s;
+				const uint32 b = ((r + 1) % rings) * sides + s;
+				const uint32 c = ((r + 1) % rings) * sides + (s + 1) % sides;
+				const uint32 d = r * sides + (s + 1) % sides;
+				indices.insert(indices.end(), { a, d, b, b, d, c });
+			}
+		}
+	}
+
+	// Both cache ratios drop, for 16 and 32-bit indices, and the triangles
+	// and their winding are the same as before.
+	void TestVertexCache()
+	{
+		std::vector<Vertex> vertices;
+		std::vector<uint32> indices;
+		MakeShuffledGrid(64, vertices, indices);
+		const std::vector<uint32> original = indices;
+
+		const MeshOptimizer::VertexCacheReport report = MeshOptimizer::OptimizeVertexCache(indices, vertices.size());
+		printf("%s", report.ToString("shuffled grid").c_str());
+		CHECK(report.After.ACMR < report.Before.ACMR);
+		CHECK(report.After.ATVR < report.Before.ATVR);
+		// A grid this size gets close to one vertex per two triangles.
+		CHECK(report.After.ACMR < 0.8f);
+
+		auto sortedTriangles = [](const std::vector<uint32>& list)
+		{
+			std::vector<std::vector<uint32>> triangles;
+			for (size_t i = 0; i < list.size(); i += 3)
+			{
+				// Rotated so the smallest index leads, which keeps the winding.
+				const size_t first = std::min_element(list.begin() + i, list.begin() + i + 3) - (list.begin() + i);
+				triangles.push_back({ list[i + first], list[i + (first + 1) % 3], list[i + (first + 2) % 3] });
+			}
+			std::sort(triangles.begin(), triangles.end());
+			return triangles;
+		};
+		CHECK(sortedTriangles(indices) == sortedTriangles(original));
+
+		std::vector<uint16> indices16(original.begin(), original.end());
+		const MeshOptimizer::VertexCacheReport report16 = MeshOptimizer::OptimizeVertexCache(indices16, vertices.size());
+		CHECK(report16.Before.ACMR == report.Before.ACMR);
+		CHECK(report16.After.ACMR == report.After.ACMR);
+		CHECK(std::equal(indices16.begin(), indices16.end(), indices.begin()));
+	}
+
+	// The vertices come in the order the triangles first use them, the unused
+	// one is dropped, and every triangle still has the same corners.
+	void TestVertexFetch()
+	{
+		std::vector<Vertex> vertices;
+		std::vector<uint32> indices;
+		MakeShuffledGrid(32, vertices, indices);
+		MeshOptimizer::OptimizeVertexCache(indices, vertices.size());
+
+		const std::vector<Vertex> originalVertices = vertices;
+		const std::vector<uint32> originalIndices = indices;
+		const std::vector<uint32> remap = MeshOptimizer::OptimizeVertexFetch(vertices, indices);
+
+		CHECK(vertices.size() == originalVertices.size() - 1);
+		CHECK(remap.size() == originalVertices.size());
+		CHECK(remap.back() == MeshOptimizer::InvalidIndex);
+		CHECK(indices.size() == originalIndices.size());
+
+		bool sameCorners = true;
+		for (size_t i = 0; i < indices.size(); ++i)
+		{
+			sameCorners = sameCorners && indices[i] < vertices.size() &&
+				vertices[indices[i]].Id == originalVertices[originalIndices[i]].Id &&
+				remap[originalIndices[i]] == indices[i];
+		}
+		CHECK(sameCorners);
+
+		// First use order: no index is more than one past the largest before it.
+		uint32 next = 0;
+		bool linear = true;
+		for (uint32 index : indices)
+		{
+			linear = linear && index <= next;
+			next = std::max(next, index + 1);
+		}
+		CHECK(linear);
+
+		// The vertex cache does not care about the numbering.
+		const auto before = MeshOptimizer::AnalyzeVertexCache(originalIndices.data(), originalIndices.size(), originalVertices.size());
+		const auto after = MeshOptimizer::AnalyzeVertexCache(indices.data(), indices.size(), vertices.size());
+		CHECK(before.VerticesTransformed == after.VerticesTransformed);
+	}
+
+	// On a closed mesh the cluster order draws no more pixels than the cache
+	// order it starts from, measured with the CPU depth rasterizer, and the
+	// ACMR stays within the threshold of the cache order.
+	void TestOverdraw()
+	{
+		std::vector<Vertex> vertices;
+		std::vector<uint32> indices;
+		MakeTorus(96, 48, vertices, indices);
+		MeshOptimizer::OptimizeVertexCache(indices, vertices.size());
+
+		for (float threshold : { 1.01f, 1.05f, 1.25f })
+		{
+			std::vector<uint32> optimized = indices;
+			const MeshOptimizer::OverdrawReport report = MeshOptimizer::OptimizeOverdraw(optimized, vertices, threshold);
+			printf("%.2f %s", threshold, report.ToString("torus").c_str());
+
+			CHECK(report.Before.PixelsCovered > 0);
+			CHECK(report.After.PixelsCovered == report.Before.PixelsCovered);
+			CHECK(report.After.Overdraw <= report.Before.Overdraw);
+			CHECK(report.CacheAfter.ACMR <= report.CacheBefore.ACMR * threshold);
+
+			std::vector<uint16> optimized16(indices.begin(), indices.end());
+			MeshOptimizer::OptimizeOverdraw(optimized16.data(), optimized16.size(), &vertices[0].Position.x, vertices.size(),
+				sizeof(Vertex), threshold);
+			CHECK(std::equal(optimized16.begin(), optimized16.end(), optimized.begin()));
+		}
+	}
+}
+
+int main()
+{
+	TestVertexCache();
+	TestVertexFetch();
+	TestOverdraw();
+	return TestResult();
+}
\ No newline at end of file
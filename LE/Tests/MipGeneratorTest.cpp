@@ -0,0 +1,260 @@
+#include "MipGenerator.h"
+#include "TestCheck.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace
+{
+	using uint8 = std::uint8_t;
+	using uint32 = MipGenerator::uint32;
+	using uint64 = std::uint64_t;
+	using Format = MipGenerator::Format;
+	using Filter = MipGenerator::Filter;
+
+	const Filter Filters[] = { Filter::Box, Filter::Kaiser, Filter::Lanczos };
+
+	struct Image
+	{
+		uint32 Width;
+		uint32 Height;
+		uint32 Channels;
+		std::vector<uint8> Texels;
+
+		uint8* At(uint32 x, uint32 y)
+		{
+			return Texels.data() + ((size_t)y * Width + x) * Channels;
+		}
+	};
+
+	Image MakeImage(uint32 width, uint32 height, uint32 channels)
+	{
+		return Image{ width, height, channels, std::vector<uint8>((size_t)width * height * channels) };
+	}
+
+	MipGenerator::Surface Top(const Image& image)
+	{
+		MipGenerator::Surface surface;
+		surface.Data = image.Texels.data();
+		surface.RowPitch = (uint64)image.Width * image.Channels;
+		surface.SlicePitch = surface.RowPitch * image.Height;
+		return surface;
+	}
+
+	// The chain of one slice, or an empty one if Generate turned it down.
+	std::vector<MipGenerator::Surface> Generate(Format format, const Image& image, std::vector<uint8>& storage,
+		const MipGenerator::Options& options)
+	{
+		std::vector<MipGenerator::Surface> surfaces(1, Top(image));
+		if (!MipGenerator::Generate(format, image.Width, image.Height, surfaces, storage, options))
+			surfaces.clear();
+		return surfaces;
+	}
+
+	const uint8* Texel(const MipGenerator::Surface& level, uint32 x, uint32 y, uint32 channels)
+	{
+		return static_cast<const uint8*>(level.Data) + y * level.RowPitch + x * channels;
+	}
+
+	// Share of the texels whose alpha passes a test against reference.
+	double Coverage(const MipGenerator::Surface& level, uint32 width, uint32 height, float reference)
+	{
+		uint32 passed = 0;
+		for (uint32 y = 0; y < height; ++y)
+		{
+			for (uint32 x = 0; x < width; ++x)
+				passed += Texel(level, x, y, 4)[3] / 255.0f > reference;
+		}
+		return (double)passed / (width * height);
+	}
+
+	// Black and white texels averaged in linear light give middle gray in
+	// linear light, which sRGB stores as 188, not as 128.
+	void TestSrgbAverage()
+	{
+		Image image = MakeImage(8, 8, 4);
+		for (uint32 y = 0; y < image.Height; ++y)
+		{
+			for (uint32 x = 0; x < image.Width; ++x)
+			{
+				uint8* texel = image.At(x, y);
+				const uint8 value = (x + y) % 2 ? 255 : 0;
+				texel[0] = texel[1] = texel[2] = value;
+				texel[3] = value;
+			}
+		}
+
+		MipGenerator::Options options;
+		options.Kernel = Filter::Box;
+		std::vector<uint8> storage;
+		const auto srgb = Generate(Format::R8G8B8A8_UNORM_SRGB, image, storage, options);
+		CHECK(srgb.size() == 4);
+		bool srgbGray = true;
+		for (size_t mip = 1; mip < srgb.size(); ++mip)
+		{
+			const uint8* texel = Texel(srgb[mip], 0, 0, 4);
+			srgbGray = srgbGray && std::abs(texel[0] - 188) <= 1 && texel[0] == texel[1] && texel[0] == texel[2] &&
+				std::abs(texel[3] - 128) <= 1;
+		}
+		CHECK(srgbGray);
+
+		std::vector<uint8> unormStorage;
+		const auto unorm = Generate(Format::R8G8B8A8_UNORM, image, unormStorage, options);
+		CHECK(unorm.size() == 4);
+		CHECK(std::abs(Texel(unorm[3], 0, 0, 4)[0] - 128) <= 1);
+	}
+
+	// Odd sizes down to 1x1 with every filter.  A constant image stays
+	// constant to the last texel of every row, which the scalar tail after
+	// the SSE2 loop writes, and a ramp keeps its mean.
+	void TestOddSizes()
+	{
+		const uint32 width = 37, height = 13;
+		Image constant = MakeImage(width, height, 4);
+		Image ramp = MakeImage(width, height, 4);
+		for (uint32 y = 0; y < height; ++y)
+		{
+			for (uint32 x = 0; x < width; ++x)
+			{
+				const uint8 texel[4] = { 10, 100, 200, 250 };
+				std::copy(texel, texel + 4, constant.At(x, y));
+				uint8* r = ramp.At(x, y);
+				r[0] = (uint8)(x * 255 / (width - 1));
+				r[1] = (uint8)(y * 255 / (height - 1));
+				r[2] = 128;
+				r[3] = 255;
+			}
+		}
+		const double rampMean[2] = { 127.5, 127.5 };
+
+		for (Filter filter : Filters)
+		{
+			MipGenerator::Options options;
+			options.Kernel = filter;
+			std::vector<uint8> storage, rampStorage;
+			const auto levels = Generate(Format::B8G8R8A8_UNORM, constant, storage, options);
+			const auto rampLevels = Generate(Format::R8G8B8A8_UNORM, ramp, rampStorage, options);
+			CHECK(levels.size() == MipGenerator::GetMipCount(width, height));
+			CHECK(levels.size() == 6 && rampLevels.size() == 6);
+
+			bool sizes = true, same = true, means = true;
+			for (uint32 mip = 1; mip < levels.size(); ++mip)
+			{
+				const uint32 w = std::max(1u, width >> mip), h = std::max(1u, height >> mip);
+				sizes = sizes && levels[mip].RowPitch == w * 4 && levels[mip].SlicePitch == (uint64)w * h * 4;
+				double sum[2] = {};
+				for (uint32 y = 0; y < h; ++y)
+				{
+					for (uint32 x = 0; x < w; ++x)
+					{
+						same = same && std::equal(Texel(levels[mip], x, y, 4), Texel(levels[mip], x, y, 4) + 4, Texel(levels[0], 0, 0, 4));
+						sum[0] += Texel(rampLevels[mip], x, y, 4)[0];
+						sum[1] += Texel(rampLevels[mip], x, y, 4)[1];
+					}
+				}
+				for (int c = 0; c < 2; ++c)
+					means = means && std::fabs(sum[c] / (w * h) - rampMean[c]) < 3.0;
+			}
+			CHECK(sizes);
+			CHECK(same);
+			CHECK(means);
+		}
+	}
+
+	// Grass-like blades, one texel wide, thin out under plain filtering and
+	// keep their coverage to within a few percent when alpha is scaled.
+	void TestAlphaCoverage()
+	{
+		const uint32 size = 128;
+		const float reference = 0.5f;
+		Image image = MakeImage(size, size, 4);
+		std::mt19937 random(5);
+		for (uint32 x = 0; x < size; ++x)
+		{
+			const uint32 top = random() % size;
+			const bool blade = random() % 3 == 0;
+			for (uint32 y = 0; y < size; ++y)
+			{
+				uint8* texel = image.At(x, y);
+				texel[0] = texel[2] = 40;
+				texel[1] = 160;
+				texel[3] = blade && y >= top ? 255 : 0;
+			}
+		}
+
+		std::vector<uint8> plainStorage, keptStorage;
+		MipGenerator::Options options;
+		const auto plain = Generate(Format::R8G8B8A8_UNORM, image, plainStorage, options);
+		options.AlphaReference = reference;
+		const auto kept = Generate(Format::R8G8B8A8_UNORM, image, keptStorage, options);
+
+		const double top = Coverage(kept[0], size, size, reference);
+		CHECK(top > 0.05);
+		bool close = true, thinner = false;
+		for (uint32 mip = 1; size >> mip >= 8; ++mip)
+		{
+			const uint32 s = size >> mip;
+			const double keptCoverage = Coverage(kept[mip], s, s, reference);
+			close = close && std::fabs(keptCoverage - top) < 0.05;
+			thinner = thinner || Coverage(plain[mip], s, s, reference) < top - 0.05;
+		}
+		CHECK(close);
+		CHECK(thinner);
+
+		// Only alpha changes.
+		bool colorKept = true;
+		for (uint32 y = 0; y < (size >> 3); ++y)
+		{
+			for (uint32 x = 0; x < (size >> 3); ++x)
+				colorKept = colorKept && std::equal(Texel(kept[3], x, y, 4), Texel(kept[3], x, y, 4) + 3, Texel(plain[3], x, y, 4));
+		}
+		CHECK(colorKept);
+	}
+
+	// R8, array slices, the thread count and what Generate turns down.
+	void TestFormats()
+	{
+		Image first = MakeImage(19, 6, 1);
+		Image second = MakeImage(19, 6, 1);
+		std::fill(first.Texels.begin(), first.Texels.end(), (uint8)30);
+		std::fill(second.Texels.begin(), second.Texels.end(), (uint8)220);
+
+		MipGenerator::Options options;
+		std::vector<uint8> storage;
+		std::vector<MipGenerator::Surface> surfaces = { Top(first), Top(second) };
+		CHECK(MipGenerator::Generate(Format::R8_UNORM, 19, 6, surfaces, storage, options));
+		CHECK(surfaces.size() == 10);
+		CHECK(surfaces[0].Data == first.Texels.data() && surfaces[5].Data == second.Texels.data());
+		CHECK(*Texel(surfaces[4], 0, 0, 1) == 30 && *Texel(surfaces[9], 0, 0, 1) == 220);
+		CHECK(surfaces[1].RowPitch == 9);
+
+		// Every thread count filters the same.
+		Image noise = MakeImage(61, 45, 4);
+		std::mt19937 random(9);
+		for (uint8& value : noise.Texels)
+			value = (uint8)random();
+		std::vector<uint8> one, many;
+		options.ThreadCount = 1;
+		Generate(Format::R8G8B8A8_UNORM_SRGB, noise, one, options);
+		options.ThreadCount = 8;
+		Generate(Format::R8G8B8A8_UNORM_SRGB, noise, many, options);
+		CHECK(one == many);
+
+		std::vector<uint8> unused;
+		CHECK(Generate(Format::R16G16B16A16_UNORM, noise, unused, options).empty());
+		CHECK(Generate(Format::BC1_UNORM, noise, unused, options).empty());
+		CHECK(Generate(Format::R8G8B8A8_UNORM, MakeImage(1, 1, 4), unused, options).empty());
+		CHECK(MipGenerator::GetMipCount(1, 1) == 1 && MipGenerator::GetMipCount(1024, 3) == 11);
+	}
+}
+
+int main()
+{
+	TestSrgbAverage();
+	TestOddSizes();
+	TestAlphaCoverage();
+	TestFormats();
+	return TestResult();
+}
\ No newline at end of file
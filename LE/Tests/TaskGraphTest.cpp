@@ -0,0 +1,190 @@
+#include "TaskGraph.h"
+#include "TestCheck.h"
+#include <atomic>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+	using uint32 = TaskGraph::uint32;
+	using TaskId = TaskGraph::TaskId;
+
+	const uint32 ThreadCounts[] = { 1, 2, 4, 8 };
+
+	// A random graph of tasks that each take a ticket when they run: every
+	// task runs once and after all of its dependencies.
+	void TestDependencyOrder()
+	{
+		for (uint32 threadCount : ThreadCounts)
+		{
+			const uint32 taskCount = 300;
+			std::mt19937 random(threadCount);
+			std::atomic<uint32> nextTicket(0);
+			std::vector<std::atomic<uint32>> runs(taskCount);
+			std::vector<uint32> tickets(taskCount);
+			std::vector<std::vector<TaskId>> dependencies(taskCount);
+
+			TaskGraph graph;
+			for (uint32 i = 0; i < taskCount; ++i)
+			{
+				runs[i] = 0;
+				const uint32 dependencyCount = i > 0 ? random() % 4 : 0;
+				for (uint32 d = 0; d < dependencyCount; ++d)
+					dependencies[i].push_back(random() % i);
+				graph.Add("task" + std::to_string(i), [&, i]()
+				{
+					tickets[i] = nextTicket++;
+					runs[i]++;
+				}, dependencies[i]);
+			}
+			graph.Run(threadCount);
+
+			bool once = true, ordered = true;
+			for (uint32 i = 0; i < taskCount; ++i)
+			{
+				once = once && runs[i] == 1;
+				for (TaskId dependency : dependencies[i])
+					ordered = ordered && tickets[dependency] < tickets[i];
+			}
+			CHECK(once);
+			CHECK(ordered);
+		}
+	}
+
+	// A throwing task skips everything downstream of it, independent tasks
+	// still run and Run rethrows once they are done.
+	void TestExceptionSkipsDependents()
+	{
+		for (uint32 threadCount : ThreadCounts)
+		{
+			std::atomic<uint32> ran(0);
+			bool afterRan = false, joinRan = false, independentRan = false;
+
+			TaskGraph graph;
+			const TaskId root = graph.Add("root", [&]() { ran++; });
+			const TaskId failing = graph.Add("failing", [&]() { throw std::runtime_error("failing"); }, { root });
+			const TaskId after = graph.Add("after", [&]() { afterRan = true; }, { failing });
+			const TaskId independent = graph.Add("independent", [&]() { independentRan = true; }, { root });
+			graph.Add("join", [&]() { joinRan = true; }, { after, independent });
+
+			std::string message;
+			try
+			{
+				graph.Run(threadCount);
+			}
+			catch (const std::runtime_error& e)
+			{
+				message = e.what();
+			}
+			CHECK(message == "failing");
+			CHECK(ran == 1 && independentRan);
+			CHECK(!afterRan && !joinRan);
+
+			const std::string trace = graph.ToString();
+			CHECK(trace.find("failing (skipped)") != std::string::npos);
+			CHECK(trace.find("join (skipped)") != std::string::npos);
+			CHECK(trace.find("independent (skipped)") == std::string::npos);
+		}
+
+		// A part of AddParallel that throws skips what waits on the join.
+		TaskGraph graph;
+		bool afterRan = false;
+		const TaskId parts = graph.AddParallel("parts", 8, [](uint32 i)
+		{
+			if (i == 5)
+				throw std::logic_error("part 5");
+		});
+		graph.Add("after", [&]() { afterRan = true; }, { parts });
+		bool thrown = false;
+		try
+		{
+			graph.Run(4);
+		}
+		catch (const std::logic_error&)
+		{
+			thrown = true;
+		}
+		CHECK(thrown && !afterRan);
+	}
+
+	// The task AddParallel returns finishes after every part, and the parts
+	// start after its dependencies.  Without parts it waits on those itself.
+	void TestParallelJoin()
+	{
+		for (uint32 threadCount : ThreadCounts)
+		{
+			for (uint32 count : { 0u, 1u, 7u, 64u })
+			{
+				std::atomic<uint32> done(0);
+				std::vector<std::atomic<uint32>> runs(count);
+				for (auto& run : runs)
+					run = 0;
+				bool setUp = false, partsSawSetUp = true;
+				uint32 doneAtJoin = ~0u;
+				bool joinSawSetUp = false;
+
+				TaskGraph graph;
+				const TaskId setup = graph.Add("setup", [&]() { setUp = true; });
+				const TaskId parts = graph.AddParallel("parts", count, [&](uint32 i)
+				{
+					if (!setUp)
+						partsSawSetUp = false;
+					runs[i]++;
+					done++;
+				}, { setup });
+				graph.Add("after", [&]()
+				{
+					doneAtJoin = done;
+					joinSawSetUp = setUp;
+				}, { parts });
+				graph.Run(threadCount);
+
+				bool once = true;
+				for (auto& run : runs)
+					once = once && run == 1;
+				CHECK(once);
+				CHECK(partsSawSetUp && joinSawSetUp);
+				CHECK(doneAtJoin == count);
+			}
+		}
+	}
+
+	// Run can be repeated and forgets the skips of the previous run.
+	void TestRunAgain()
+	{
+		bool fail = true;
+		uint32 afterRuns = 0;
+		TaskGraph graph;
+		const TaskId first = graph.Add("first", [&]()
+		{
+			if (fail)
+				throw std::runtime_error("first");
+		});
+		graph.Add("after", [&]() { afterRuns++; }, { first });
+
+		bool thrown = false;
+		try
+		{
+			graph.Run(2);
+		}
+		catch (const std::runtime_error&)
+		{
+			thrown = true;
+		}
+		fail = false;
+		graph.Run(2);
+		CHECK(thrown && afterRuns == 1);
+		CHECK(graph.ToString().find("(skipped)") == std::string::npos);
+	}
+}
+
+int main()
+{
+	TestDependencyOrder();
+	TestExceptionSkipsDependents();
+	TestParallelJoin();
+	TestRunAgain();
+	return TestResult();
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+#include "TerrainGenerator.h"
+#include "TestCheck.h"
+#include <chrono>
+#include <cstdio>
+
+// Generates the hills of the Demo at 8193 x 8193 samples, 64 x 64 tiles of
+// 128 x 128 quads, and times the height field and the tiles apart.  --quick
+// generates 1025 x 1025 samples instead.
+namespace
+{
+	using uint32 = TerrainGenerator::uint32;
+
+	double MillisecondsSince(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const bool quick = TestCheck::IsQuick(argc, argv);
+
+	TerrainGenerator::Desc desc;
+	desc.TilesX = quick ? 8 : 64;
+	desc.TilesZ = desc.TilesX;
+	desc.TileQuads = TerrainGenerator::MaxTileQuads;
+	desc.Spacing = 0.5f;
+	desc.SkirtDepth = 2.0f;
+	desc.TextureRepeat = 64.0f;
+
+	auto start = std::chrono::steady_clock::now();
+	Heightfield heightfield = TerrainGenerator::GenerateHeightfield(desc, TerrainGenerator::HillsHeight);
+	const double heightfieldMilliseconds = MillisecondsSince(start);
+
+	start = std::chrono::steady_clock::now();
+	ChunkedTerrain terrain = TerrainGenerator::Generate(heightfield, desc);
+	const double generateMilliseconds = MillisecondsSince(start);
+
+	printf("%u x %u samples: height field in %.1f ms\n", heightfield.Width, heightfield.Depth, heightfieldMilliseconds);
+	printf("%s", TerrainGenerator::ToString("hills", terrain, generateMilliseconds).c_str());
+	printf("%.1f M vertices per second\n", terrain.Vertices.size() / (generateMilliseconds * 1000.0));
+
+	const uint32 samples = desc.TilesX * desc.TileQuads + 1;
+	CHECK(heightfield.Width == samples && heightfield.Depth == samples);
+	CHECK(terrain.Tiles.size() == (size_t)desc.TilesX * desc.TilesZ);
+	CHECK(terrain.Vertices.size() == terrain.Tiles.size() * terrain.VerticesPerTile);
+	CHECK(terrain.LevelCount == 8 && terrain.Variants.size() == terrain.LevelCount * TerrainLevels::VariantsPerLevel);
+
+	// Every tile starts at its own vertices and its box holds them.
+	bool tilesFit = true;
+	for (size_t i = 0; i < terrain.Tiles.size(); ++i)
+	{
+		const TerrainTile& tile = terrain.Tiles[i];
+		tilesFit = tilesFit && tile.BaseVertexLocation == (std::int32_t)(i * terrain.VerticesPerTile) &&
+			tile.LevelErrors.size() == terrain.LevelCount;
+		for (uint32 v = 0; v < terrain.VerticesPerTile; v += 97)
+		{
+			const DirectX::XMFLOAT3& p = terrain.Vertices[tile.BaseVertexLocation + v].Position;
+			tilesFit = tilesFit && tile.Bounds.Box.Contains(DirectX::XMLoadFloat3(&p)) != DirectX::DISJOINT;
+		}
+	}
+	CHECK(tilesFit);
+	return TestResult();
+}
\ No newline at end of file
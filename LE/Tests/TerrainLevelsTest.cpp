@@ -0,0 +1,216 @@
+#include "TerrainLevels.h"
+#include "TestCheck.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+	using uint32 = TerrainLevels::uint32;
+
+	const uint32 TilesX = 16;
+	const uint32 TilesZ = 16;
+	const uint32 LevelCount = 5;
+	const float TileSize = 64.0f;
+
+	// A tile of level l has (32 >> l)^2 quads, a stitched edge drops half of
+	// its triangles along that edge.
+	uint32 VariantTriangles(uint32 level, uint32 coarserEdges)
+	{
+		const uint32 quads = 32 >> level;
+		uint32 triangles = 2 * quads * quads;
+		for (uint32 edge = 0; edge < TerrainLevels::EdgeCount; ++edge)
+		{
+			if (coarserEdges & (1u << edge))
+				triangles -= quads / 2;
+		}
+		return triangles;
+	}
+
+	void ResetGrid(TerrainLevels& levels)
+	{
+		// The error doubles with every level, the finest one is exact.
+		std::vector<std::vector<float>> errors(TilesX * TilesZ);
+		for (auto& tile : errors)
+		{
+			for (uint32 level = 0; level < LevelCount; ++level)
+				tile.push_back(level == 0 ? 0.0f : 0.125f * (float)(1 << level));
+		}
+
+		std::vector<uint32> triangles(LevelCount * TerrainLevels::VariantsPerLevel);
+		for (uint32 level = 0; level < LevelCount; ++level)
+		{
+			for (uint32 edges = 0; edges < TerrainLevels::VariantsPerLevel; ++edges)
+				triangles[TerrainLevels::VariantIndex(level, edges)] = VariantTriangles(level, edges);
+		}
+
+		levels.Reset(TilesX, TilesZ, errors, triangles);
+		levels.SetProjection(0.25f * 3.14159265f, 1080.0f);
+	}
+
+	// Eye at (x, z) above the grid, tile (0, 0) covers [0, TileSize)^2.
+	std::vector<float> Distances(float x, float y, float z)
+	{
+		std::vector<float> distances(TilesX * TilesZ);
+		for (uint32 tz = 0; tz < TilesZ; ++tz)
+		{
+			for (uint32 tx = 0; tx < TilesX; ++tx)
+			{
+				const float dx = std::max(std::max(tx * TileSize - x, x - (tx + 1) * TileSize), 0.0f);
+				const float dz = std::max(std::max(tz * TileSize - z, z - (tz + 1) * TileSize), 0.0f);
+				distances[tz * TilesX + tx] = std::sqrt(dx * dx + y * y + dz * dz);
+			}
+		}
+		return distances;
+	}
+
+	void CheckConsistent(const TerrainLevels& levels, const std::vector<char>& visible)
+	{
+		uint32 triangles = 0;
+		for (uint32 z = 0; z < TilesZ; ++z)
+		{
+			for (uint32 x = 0; x < TilesX; ++x)
+			{
+				const uint32 tile = z * TilesX + x;
+				const uint32 level = levels.GetLevel(tile);
+				CHECK(level < LevelCount);
+
+				// Neighbours differ by at most one level and the stitched
+				// edges are exactly those with a coarser neighbour.
+				uint32 edges = 0;
+				auto neighbour = [&](bool exists, uint32 other, TerrainLevels::Edge edge)
+				{
+					if (!exists)
+						return;
+					const uint32 otherLevel = levels.GetLevel(other);
+					CHECK(otherLevel + 1 >= level && otherLevel <= level + 1);
+					if (otherLevel > level)
+						edges |= 1u << edge;
+				};
+				neighbour(z > 0, tile - TilesX, TerrainLevels::EdgeFar);
+				neighbour(z + 1 < TilesZ, tile + TilesX, TerrainLevels::EdgeNear);
+				neighbour(x > 0, tile - 1, TerrainLevels::EdgeLeft);
+				neighbour(x + 1 < TilesX, tile + 1, TerrainLevels::EdgeRight);
+				CHECK(levels.CoarserEdges(tile) == edges);
+				CHECK(levels.GetVariant(tile) == TerrainLevels::VariantIndex(level, edges));
+
+				if (visible[tile])
+					triangles += VariantTriangles(level, edges);
+			}
+		}
+		CHECK(levels.CountTriangles(visible) == triangles);
+	}
+
+	void TestStartsCoarse()
+	{
+		TerrainLevels levels;
+		ResetGrid(levels);
+		CHECK(levels.GetTileCount() == TilesX * TilesZ);
+
+		const std::vector<char> visible(TilesX * TilesZ, 1);
+		for (uint32 tile = 0; tile < levels.GetTileCount(); ++tile)
+			CHECK(levels.GetLevel(tile) == LevelCount - 1);
+		CHECK(levels.CountTriangles(visible) == TilesX * TilesZ * VariantTriangles(LevelCount - 1, 0));
+	}
+
+	void TestNearerIsFiner()
+	{
+		TerrainLevels levels;
+		ResetGrid(levels);
+
+		// Eye low over the corner tile, looking along the diagonal.
+		const std::vector<char> visible(TilesX * TilesZ, 1);
+		CHECK(levels.Select(Distances(1.0f, 2.0f, 1.0f), visible) == 1.0f);
+		CheckConsistent(levels, visible);
+
+		CHECK(levels.GetLevel(0) == 0);
+		CHECK(levels.GetLevel(TilesX * TilesZ - 1) == LevelCount - 1);
+		for (uint32 i = 1; i < TilesX; ++i)
+		{
+			const uint32 nearer = (i - 1) * TilesX + (i - 1);
+			const uint32 farther = i * TilesX + i;
+			CHECK(levels.GetLevel(nearer) <= levels.GetLevel(farther));
+		}
+	}
+
+	void TestCameraPath()
+	{
+		TerrainLevels levels;
+		ResetGrid(levels);
+
+		// Unlimited first, to know what the path costs without a budget.
+		std::vector<uint32> unlimited;
+		const int steps = 200;
+		for (int pass = 0; pass < 2; ++pass)
+		{
+			const uint32 budget = pass == 0 ? 0 : 20000;
+			levels.SetTriangleBudget(budget);
+
+			bool raised = false;
+			for (int step = 0; step < steps; ++step)
+			{
+				// Across the grid and back at a low height, every other frame
+				// only the tiles in front of the eye are visible.
+				const float t = (float)step / steps;
+				const float x = TilesX * TileSize * (t < 0.5f ? 2.0f * t : 2.0f - 2.0f * t);
+				const float z = TilesZ * TileSize * 0.5f + 200.0f * std::sin(6.28318531f * t);
+				std::vector<char> visible(TilesX * TilesZ, 1);
+				if (step % 2 == 1)
+				{
+					for (uint32 tile = 0; tile < visible.size(); ++tile)
+						visible[tile] = (tile % TilesX) * TileSize + TileSize >= x;
+				}
+
+				const float scale = levels.Select(Distances(x, 10.0f, z), visible);
+				CheckConsistent(levels, visible);
+
+				const uint32 triangles = levels.CountTriangles(visible);
+				if (budget == 0)
+				{
+					CHECK(scale == 1.0f);
+					unlimited.push_back(triangles);
+				}
+				else
+				{
+					CHECK(scale >= 1.0f);
+					CHECK(triangles <= budget || scale > 1000.0f);
+					raised = raised || scale > 1.0f;
+				}
+			}
+
+			// The budget only matters if the path goes over it.
+			if (budget != 0)
+			{
+				CHECK(*std::max_element(unlimited.begin(), unlimited.end()) > budget);
+				CHECK(raised);
+			}
+		}
+	}
+
+	void TestHysteresis()
+	{
+		TerrainLevels levels;
+		ResetGrid(levels);
+		levels.SetThreshold(2.0f, 0.25f);
+
+		// A step back that stays within the hysteresis keeps the levels.
+		const std::vector<char> visible(TilesX * TilesZ, 1);
+		levels.Select(Distances(500.0f, 50.0f, 500.0f), visible);
+		std::vector<uint32> before;
+		for (uint32 tile = 0; tile < levels.GetTileCount(); ++tile)
+			before.push_back(levels.GetLevel(tile));
+
+		levels.Select(Distances(500.0f, 51.0f, 500.0f), visible);
+		for (uint32 tile = 0; tile < levels.GetTileCount(); ++tile)
+			CHECK(levels.GetLevel(tile) == before[tile]);
+	}
+}
+
+int main()
+{
+	TestStartsCoarse();
+	TestNearerIsFiner();
+	TestCameraPath();
+	TestHysteresis();
+	return TestResult();
+}
\ No newline at end of file
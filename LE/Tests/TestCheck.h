@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdio>
+#include <cstring>
+
+// Just enough for the headless tests: CHECK reports and counts a failure
+// without stopping, and main returns TestResult().
+namespace TestCheck
+{
+	inline int& Failures()
+	{
+		static int failures = 0;
+		return failures;
+	}
+
+	// Benchmarks take --quick under ctest so a run stays short.
+	inline bool IsQuick(int argc, char** argv)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			if (strcmp(argv[i], "--quick") == 0)
+				return true;
+		}
+		return false;
+	}
+}
+
+#define CHECK(expr) \
+	do \
+	{ \
+		if (!(expr)) \
+		{ \
+			fprintf(stderr, "%s(%d): CHECK failed: %s\n", __FILE__, __LINE__, #expr); \
+			TestCheck::Failures()++; \
+		} \
+	} while (false)
+
+inline int TestResult()
+{
+	if (TestCheck::Failures() != 0)
+		fprintf(stderr, "%d checks failed\n", TestCheck::Failures());
+	return TestCheck::Failures() == 0 ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,208 @@
+#include "TextureResidency.h"
+#include "TestCheck.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+	using uint32 = TextureResidency::uint32;
+	using uint64 = TextureResidency::uint64;
+
+	// Level sizes of a square texture, finest first.
+	std::vector<uint64> MipChain(uint32 size, uint32 bytesPerTexel)
+	{
+		std::vector<uint64> levels;
+		for (;;)
+		{
+			levels.push_back((uint64)size * size * bytesPerTexel);
+			if (size == 1)
+				return levels;
+			size /= 2;
+		}
+	}
+
+	uint64 BytesFrom(const std::vector<uint64>& levels, uint32 firstMip)
+	{
+		uint64 bytes = 0;
+		for (size_t level = firstMip; level < levels.size(); ++level)
+			bytes += levels[level];
+		return bytes;
+	}
+
+	void TestEstimateMip()
+	{
+		CHECK(TextureResidency::EstimateMip(1024.0f, 1024.0f) == 0.0f);
+		CHECK(TextureResidency::EstimateMip(1024.0f, 4096.0f) == 0.0f);
+		CHECK(std::fabs(TextureResidency::EstimateMip(1024.0f, 128.0f) - 3.0f) < 1e-5f);
+		CHECK(TextureResidency::EstimateMip(1024.0f, 0.0f) > 100.0f);
+	}
+
+	// Eight textured objects on a line, 20 units apart, and a camera that flies
+	// past them and back, seeing what is up to 60 units ahead.  The budget
+	// holds about two textures in full, so levels come and go all the way.
+	void TestCameraPath()
+	{
+		const uint32 textureCount = 8, tailMip = 6, frames = 2000;
+		const std::vector<uint64> levels = MipChain(2048, 4);
+
+		TextureResidency::Options options;
+		options.BudgetBytes = 40ull << 20;
+		options.StreamBytesPerUpdate = 8ull << 20;
+		TextureResidency residency(options);
+		for (uint32 i = 0; i < textureCount; ++i)
+			residency.Add(levels, tailMip, tailMip);
+
+		const uint64 tails = textureCount * BytesFrom(levels, tailMip);
+		CHECK(residency.GetStats().ResidentBytes == tails);
+
+		std::vector<uint32> firstMips(textureCount, tailMip);
+		uint64 streamedBytes = 0;
+		bool withinBudget = true, consistent = true, changesMatch = true, streamCapped = true;
+		uint32 fullyResident = 0;
+		for (uint32 frame = 0; frame < frames; ++frame)
+		{
+			const float t = frame / (frames / 2.0f);
+			const float camera = t < 1.0f ? -10.0f + 160.0f * t : 150.0f - 160.0f * (t - 1.0f);
+			const float direction = t < 1.0f ? 1.0f : -1.0f;
+			for (uint32 i = 0; i < textureCount; ++i)
+			{
+				const float distance = (i * 20.0f - camera) * direction;
+				if (distance <= 0.5f || distance > 60.0f)
+					continue;
+				// Two units wide, 1000 pixels to the unit at distance one.
+				residency.Request(i, TextureResidency::EstimateMip(2048.0f, 2000.0f / distance));
+			}
+
+			for (const auto& change : residency.Update())
+			{
+				changesMatch = changesMatch && change.FirstMip != firstMips[change.Id] &&
+					change.FirstMip == residency.GetFirstMip(change.Id);
+				firstMips[change.Id] = change.FirstMip;
+			}
+
+			const TextureResidency::Stats& stats = residency.GetStats();
+			withinBudget = withinBudget && stats.ResidentBytes <= options.BudgetBytes;
+
+			uint64 resident = 0;
+			for (uint32 i = 0; i < textureCount; ++i)
+			{
+				changesMatch = changesMatch && firstMips[i] == residency.GetFirstMip(i);
+				consistent = consistent && residency.GetFirstMip(i) <= tailMip;
+				resident += BytesFrom(levels, residency.GetFirstMip(i));
+				fullyResident += residency.GetFirstMip(i) == 0;
+			}
+			consistent = consistent && resident == stats.ResidentBytes;
+
+			// One level larger than the cap may go alone.
+			const uint64 streamed = stats.StreamedBytes - streamedBytes;
+			streamCapped = streamCapped && (streamed <= options.StreamBytesPerUpdate || streamed == levels[0]);
+			streamedBytes = stats.StreamedBytes;
+		}
+
+		CHECK(withinBudget);
+		CHECK(consistent);
+		CHECK(changesMatch);
+		CHECK(streamCapped);
+		CHECK(fullyResident > 0);
+
+		const TextureResidency::Stats& stats = residency.GetStats();
+		CHECK(stats.Evictions > 0);
+		CHECK(stats.StreamedBytes - stats.EvictedBytes == stats.ResidentBytes - tails);
+		printf("%s", residency.ToString().c_str());
+
+		// Lowering the budget drops what nobody asks for, down to the tails.
+		residency.SetBudget(tails);
+		residency.Update();
+		CHECK(residency.GetStats().ResidentBytes == tails);
+		for (uint32 i = 0; i < textureCount; ++i)
+			CHECK(residency.GetFirstMip(i) == tailMip);
+	}
+
+	// The least recently used texture gives up its levels first, and levels
+	// that are requested are never evicted for others.
+	void TestLruEviction()
+	{
+		const std::vector<uint64> levels = { 64, 16, 4, 1 };
+		TextureResidency::Options options;
+		// Two textures in full, the tail of the third and its level 2.
+		options.BudgetBytes = 2 * BytesFrom(levels, 0) + BytesFrom(levels, 2);
+		TextureResidency residency(options);
+		const auto a = residency.Add(levels, 3, 0, 1000);
+		const auto b = residency.Add(levels, 3, 3, 200);
+		const auto c = residency.Add(levels, 3, 3);
+		// Sources are counted apart from the budget.
+		CHECK(residency.GetStats().SourceBytes == 1200);
+
+		residency.Request(a, 0.0f);
+		CHECK(residency.Update().empty());
+
+		residency.Request(b, 0.0f);
+		residency.Update();
+		CHECK(residency.GetFirstMip(a) == 0 && residency.GetFirstMip(b) == 0);
+		CHECK(residency.GetStats().ResidentBytes == 2 * BytesFrom(levels, 0) + 1);
+		CHECK(residency.GetStats().Evictions == 0);
+
+		// A was used before B, so C takes A's levels, the finest first.
+		residency.Request(c, 0.0f);
+		residency.Update();
+		CHECK(residency.GetFirstMip(a) == 2);
+		CHECK(residency.GetFirstMip(b) == 0);
+		CHECK(residency.GetFirstMip(c) == 0);
+		CHECK(residency.GetStats().Evictions == 2 && residency.GetStats().EvictedBytes == 80);
+		CHECK(residency.GetStats().ResidentBytes == options.BudgetBytes);
+
+		// Everything in use: A waits rather than evicting B or C.
+		residency.Request(a, 0.0f);
+		residency.Request(b, 0.0f);
+		residency.Request(c, 0.0f);
+		CHECK(residency.Update().empty());
+		CHECK(residency.GetFirstMip(a) == 2);
+		CHECK(residency.GetStats().OverBudgetUpdates == 1);
+		CHECK(residency.GetStats().MissingLevels == 2);
+		CHECK(residency.GetStats().ResidentBytes == options.BudgetBytes);
+
+		// Now B is the oldest.
+		residency.Request(a, 0.0f);
+		residency.Request(c, 0.0f);
+		residency.Update();
+		CHECK(residency.GetFirstMip(a) == 0);
+		CHECK(residency.GetFirstMip(b) == 2);
+		CHECK(residency.GetFirstMip(c) == 0);
+	}
+
+	// A texture close up streams over several updates, a level at a time
+	// within the cap, the coarser levels first.
+	void TestStreamCap()
+	{
+		const std::vector<uint64> levels = MipChain(2048, 4);
+		TextureResidency::Options options;
+		options.StreamBytesPerUpdate = 2ull << 20;
+		TextureResidency residency(options);
+		const auto id = residency.Add(levels, 6, 6);
+
+		uint32 updates = 0;
+		uint32 previous = residency.GetFirstMip(id);
+		while (residency.GetFirstMip(id) != 0 && updates < 20)
+		{
+			residency.Request(id, 0.2f);
+			residency.Update();
+			CHECK(residency.GetFirstMip(id) < previous);
+			previous = residency.GetFirstMip(id);
+			updates++;
+		}
+		CHECK(residency.GetFirstMip(id) == 0);
+		// The levels up to 1 MB first, then 4 MB and 16 MB alone.
+		CHECK(updates == 3);
+		CHECK(residency.GetStats().ResidentBytes == BytesFrom(levels, 0));
+	}
+}
+
+int main()
+{
+	TestEstimateMip();
+	TestCameraPath();
+	TestLruEviction();
+	TestStreamCap();
+	return TestResult();
+}
\ No newline at end of file
@@ -0,0 +1,93 @@
+#include "VertexQuantizer.h"
+#include "TestCheck.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+
+// Quantizes a geosphere into every packed format and checks that the error
+// report stays within what the formats guarantee.
+namespace
+{
+	template<typename TVertex>
+	void TestFormat(const char* name, const VertexQuantizer::SourceStreams& src)
+	{
+		std::vector<TVertex> vertices;
+		VertexQuantizer::PositionQuantization quantization;
+		const VertexQuantizer::ErrorReport report = VertexQuantizer::Quantize(src, vertices, quantization);
+		printf("%s", report.ToString(name).c_str());
+		CHECK(report.VertexCount == src.VertexCount);
+		CHECK(report.WithinBounds());
+		CHECK(report.MaxPositionError > 0.0f);
+	}
+
+	void TestHalfFormat(const char* name, const VertexQuantizer::SourceStreams& src)
+	{
+		std::vector<PrimitiveTypes::HalfPosTexNorColVertex> vertices;
+		const VertexQuantizer::ErrorReport report = VertexQuantizer::Quantize(src, vertices);
+		printf("%s", report.ToString(name).c_str());
+		CHECK(report.VertexCount == src.VertexCount);
+		CHECK(report.WithinBounds());
+	}
+
+	// Angle between two unit vectors in degrees.
+	float AngleDegrees(FXMVECTOR a, FXMVECTOR b)
+	{
+		const float chord = XMVectorGetX(XMVector3Length(XMVectorSubtract(a, b)));
+		return 2.0f * std::asin(std::min(1.0f, chord * 0.5f)) * 57.2957795f;
+	}
+
+	// The octahedral map folds the lower half over the corners, so
+	// directions near -z land on the edges of the square and near +z in its
+	// middle.  Both have to come back from snorm16 within the bound.
+	void TestOctahedralPoles()
+	{
+		float worst = 0.0f;
+		bool finite = true;
+		const float offsets[] = { 0.0f, 1e-6f, -1e-6f, 1e-4f, -1e-4f, 1e-2f, -1e-2f };
+		for (float z : { 1.0f, -1.0f })
+		{
+			for (float x : offsets)
+			{
+				for (float y : offsets)
+				{
+					const XMVECTOR n = XMVector3Normalize(XMVectorSet(x, y, z, 0.0f));
+					XMSHORTN2 stored;
+					XMStoreShortN2(&stored, VertexQuantizer::EncodeOctahedral(n));
+					const XMVECTOR decoded = VertexQuantizer::DecodeOctahedral(XMLoadShortN2(&stored));
+					finite = finite && std::isfinite(XMVectorGetX(decoded)) && std::isfinite(XMVectorGetZ(decoded));
+					CHECK(XMVectorGetZ(decoded) * z > 0.99f);
+					worst = std::max(worst, AngleDegrees(n, decoded));
+				}
+			}
+		}
+		printf("octahedral near +-z: %.5f degrees at most\n", worst);
+		CHECK(finite);
+		CHECK(worst <= VertexQuantizer::OctahedralErrorBound);
+	}
+}
+
+int main()
+{
+	GeometryGenerator geoGen;
+	const GeometryGenerator::MeshData sphere = geoGen.CreateGeosphere(1.0f, 5);
+	const VertexQuantizer::SourceStreams src = VertexQuantizer::FromMeshData(sphere);
+	TestFormat<PrimitiveTypes::QuantPosTexNorColVertex>("geosphere QuantPosTexNorCol", src);
+	TestFormat<PrimitiveTypes::QuantPosNorTanTexColVertex>("geosphere QuantPosNorTanTexCol", src);
+	TestHalfFormat("geosphere HalfPosTexNorCol", src);
+
+	// Far from the origin half floats lose most, and the bounds have to
+	// grow with the positions.
+	GeometryGenerator::MeshData moved = geoGen.CreateGeosphere(50.0f, 3);
+	for (auto& v : moved.Vertices)
+		v.Position.x += 1000.0f;
+	const VertexQuantizer::SourceStreams movedSrc = VertexQuantizer::FromMeshData(moved);
+	TestFormat<PrimitiveTypes::QuantPosTexNorColVertex>("moved geosphere QuantPosTexNorCol", movedSrc);
+	TestHalfFormat("moved geosphere HalfPosTexNorCol", movedSrc);
+
+	TestOctahedralPoles();
+	return TestResult();
+}
\ No newline at end of file
@@ -0,0 +1,96 @@
+#include "WorkerPool.h"
+#include "TestCheck.h"
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	using uint32 = WorkerPool::uint32;
+
+	// Every item runs once, whatever the thread count.
+	void TestEveryItemOnce()
+	{
+		for (uint32 threadCount : { 1u, 2u, 4u, 64u })
+		{
+			for (uint32 count : { 0u, 1u, 7u, 1000u })
+			{
+				std::vector<std::atomic<uint32>> runs(count);
+				for (auto& run : runs)
+					run = 0;
+				WorkerPool::ParallelFor(count, threadCount, [&](uint32 i) { runs[i]++; });
+
+				bool once = true;
+				for (auto& run : runs)
+					once = once && run == 1;
+				CHECK(once);
+			}
+		}
+	}
+
+	// Loops inside loops, from several threads at once, like MipGenerator
+	// under the startup TaskGraph.  The callers finish on their own when the
+	// workers are taken.
+	void TestNestedAndConcurrent()
+	{
+		const uint32 callers = 4, outer = 8, inner = 100;
+		std::vector<std::atomic<uint32>> sums(callers);
+		for (auto& sum : sums)
+			sum = 0;
+
+		std::vector<std::thread> threads;
+		for (uint32 c = 0; c < callers; ++c)
+		{
+			threads.emplace_back([&sums, c]()
+			{
+				WorkerPool::ParallelFor(outer, 4, [&](uint32 i)
+				{
+					WorkerPool::ParallelFor(inner, 4, [&](uint32 j) { sums[c] += i * inner + j; });
+				});
+			});
+		}
+		for (auto& thread : threads)
+			thread.join();
+
+		const uint32 n = outer * inner;
+		for (auto& sum : sums)
+			CHECK(sum == n * (n - 1) / 2);
+	}
+
+	// The first exception comes back to the caller once the other items
+	// stopped, and the pool still works after it.
+	void TestException()
+	{
+		std::atomic<uint32> started(0);
+		bool caught = false;
+		try
+		{
+			WorkerPool::ParallelFor(1000, 4, [&](uint32 i)
+			{
+				started++;
+				if (i == 10)
+					throw std::runtime_error("item 10");
+			});
+		}
+		catch (const std::runtime_error&)
+		{
+			caught = true;
+		}
+		CHECK(caught);
+		CHECK(started >= 11 && started < 1000);
+
+		std::atomic<uint32> after(0);
+		WorkerPool::ParallelFor(100, 4, [&](uint32) { after++; });
+		CHECK(after == 100);
+	}
+}
+
+int main()
+{
+	printf("%u workers\n", WorkerPool::GetWorkerCount());
+	TestEveryItemOnce();
+	TestNestedAndConcurrent();
+	TestException();
+	return TestResult();
+}
\ No newline at end of file
@@ -0,0 +1,184 @@
+#include "TextureResidency.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+TextureResidency::TextureResidency(const Options& options)
+	:
+	mOptions(options)
+{
+}
+
+float TextureResidency::EstimateMip(float texels, float pixels)
+{
+	if (!(pixels > 0.0f))
+		return 1e9f;
+	return std::max(0.0f, std::log2(texels / pixels));
+}
+
+TextureResidency::TextureId TextureResidency::Add(const std::vector<uint64>& levelBytes, uint32 tailMip, uint32 firstMip, uint64 sourceBytes)
+{
+	Texture texture;
+	texture.LevelBytes = levelBytes;
+	texture.TailMip = std::min(tailMip, (uint32)levelBytes.size() - 1);
+	texture.FirstMip = std::min(firstMip, texture.TailMip);
+	texture.RequestedMip = texture.TailMip;
+	mStats.ResidentBytes += BytesFrom(texture, texture.FirstMip);
+	mStats.SourceBytes += sourceBytes;
+	mTextures.push_back(std::move(texture));
+	return (TextureId)mTextures.size() - 1;
+}
+
+void TextureResidency::Request(TextureId id, float mip)
+{
+	Texture& texture = mTextures[id];
+	const uint32 level = (uint32)std::min((float)texture.TailMip, std::max(0.0f, std::floor(mip)));
+	texture.RequestedMip = texture.Requested ? std::min(texture.RequestedMip, level) : level;
+	texture.Requested = true;
+	texture.LastUsed = mUpdate;
+}
+
+std::vector<TextureResidency::Change> TextureResidency::Update()
+{
+	// Textures nobody asked for only need their tail.
+	std::vector<uint32> wanted(mTextures.size());
+	std::vector<uint32> first(mTextures.size());
+	mStats.RequestedBytes = 0;
+	for (size_t i = 0; i < mTextures.size(); ++i)
+	{
+		const Texture& texture = mTextures[i];
+		wanted[i] = texture.Requested ? texture.RequestedMip : texture.TailMip;
+		first[i] = texture.FirstMip;
+		mStats.RequestedBytes += BytesFrom(texture, wanted[i]);
+	}
+
+	uint64 resident = mStats.ResidentBytes;
+
+	// Drops the finest level of the least recently used texture that has
+	// more levels than it asked for.
+	auto evict = [&]()
+	{
+		size_t victim = mTextures.size();
+		for (size_t i = 0; i < mTextures.size(); ++i)
+		{
+			if (first[i] >= wanted[i])
+				continue;
+			if (victim == mTextures.size() || mTextures[i].LastUsed < mTextures[victim].LastUsed ||
+				(mTextures[i].LastUsed == mTextures[victim].LastUsed &&
+					mTextures[i].LevelBytes[first[i]] > mTextures[victim].LevelBytes[first[victim]]))
+				victim = i;
+		}
+		if (victim == mTextures.size())
+			return false;
+
+		const uint64 bytes = mTextures[victim].LevelBytes[first[victim]++];
+		resident -= bytes;
+		mStats.Evictions++;
+		mStats.EvictedBytes += bytes;
+		return true;
+	};
+
+	// The budget may have been lowered.
+	bool overBudget = false;
+	while (resident > mOptions.BudgetBytes && evict())
+		;
+
+	// One level at a time for the texture furthest from its request, so a
+	// texture close up does not take the whole budget of the update.
+	uint64 streamed = 0;
+	for (;;)
+	{
+		size_t next = mTextures.size();
+		for (size_t i = 0; i < mTextures.size(); ++i)
+		{
+			if (first[i] <= wanted[i])
+				continue;
+			if (next == mTextures.size() || first[i] - wanted[i] > first[next] - wanted[next] ||
+				(first[i] - wanted[i] == first[next] - wanted[next] && mTextures[i].LastUsed > mTextures[next].LastUsed))
+				next = i;
+		}
+		if (next == mTextures.size())
+			break;
+
+		const uint64 bytes = mTextures[next].LevelBytes[first[next] - 1];
+		if (streamed > 0 && streamed + bytes > mOptions.StreamBytesPerUpdate)
+			break;
+		while (resident + bytes > mOptions.BudgetBytes && evict())
+			;
+		if (resident + bytes > mOptions.BudgetBytes)
+		{
+			overBudget = true;
+			break;
+		}
+
+		first[next]--;
+		resident += bytes;
+		streamed += bytes;
+		mStats.StreamedLevels++;
+		mStats.StreamedBytes += bytes;
+	}
+
+	std::vector<Change> changes;
+	mStats.MissingLevels = 0;
+	for (size_t i = 0; i < mTextures.size(); ++i)
+	{
+		Texture& texture = mTextures[i];
+		if (first[i] != texture.FirstMip)
+		{
+			texture.FirstMip = first[i];
+			changes.push_back({ (TextureId)i, first[i] });
+		}
+		mStats.MissingLevels += first[i] > wanted[i] ? first[i] - wanted[i] : 0;
+		texture.Requested = false;
+	}
+
+	mStats.ResidentBytes = resident;
+	if (overBudget)
+		mStats.OverBudgetUpdates++;
+	mUpdate++;
+	return changes;
+}
+
+TextureResidency::uint32 TextureResidency::GetFirstMip(TextureId id) const
+{
+	return mTextures[id].FirstMip;
+}
+
+TextureResidency::uint32 TextureResidency::GetTextureCount() const
+{
+	return (uint32)mTextures.size();
+}
+
+void TextureResidency::SetBudget(uint64 budgetBytes)
+{
+	mOptions.BudgetBytes = budgetBytes;
+}
+
+const TextureResidency::Options& TextureResidency::GetOptions() const
+{
+	return mOptions;
+}
+
+const TextureResidency::Stats& TextureResidency::GetStats() const
+{
+	return mStats;
+}
+
+std::string TextureResidency::ToString() const
+{
+	char buffer[256];
+	snprintf(buffer, sizeof(buffer),
+		"[TextureResidency] %u textures, %.1f of %.1f MB resident (%.1f MB requested), %u levels missing, %u streamed, %u evicted, %.1f MB of sources\n",
+		(uint32)mTextures.size(), mStats.ResidentBytes / (1024.0 * 1024.0), mOptions.BudgetBytes / (1024.0 * 1024.0),
+		mStats.RequestedBytes / (1024.0 * 1024.0), mStats.MissingLevels, mStats.StreamedLevels, mStats.Evictions,
+		mStats.SourceBytes / (1024.0 * 1024.0));
+	return buffer;
+}
+
+TextureResidency::uint64 TextureResidency::BytesFrom(const Texture& texture, uint32 firstMip) const
+{
+	uint64 bytes = 0;
+	for (size_t level = firstMip; level < texture.LevelBytes.size(); ++level)
+		bytes += texture.LevelBytes[level];
+	return bytes;
+}
\ No newline at end of file
@@ -0,0 +1,119 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Decides which mip levels of each texture are resident within a memory
+// budget.  Every frame the application requests the level each texture is
+// seen at (EstimateMip from its size on screen), and Update makes finer
+// levels resident, a budget of bytes per call at most, evicting levels of
+// the least recently used textures when they do not fit.
+//
+// The resident levels of a texture always run from its first resident level
+// down to the smallest one, and the levels from its tail on are never
+// evicted.  Levels that are no longer requested stay resident until the
+// budget needs their memory, so a texture coming back into view does not
+// stream again.
+//
+// Nothing here touches the GPU.  Update returns the textures whose first
+// resident level changed and the application moves them to their new levels,
+// so the same policy runs against a replayed camera path without a device.
+class TextureResidency
+{
+public:
+	using uint32 = std::uint32_t;
+	using uint64 = std::uint64_t;
+	using TextureId = uint32;
+
+	struct Options
+	{
+		uint64 BudgetBytes = 64ull << 20;
+		// Bytes of the levels made resident per Update.  A level larger than
+		// that still goes alone, so it does not wait forever.
+		uint64 StreamBytesPerUpdate = 8ull << 20;
+	};
+
+	struct Change
+	{
+		TextureId Id;
+		uint32 FirstMip;
+	};
+
+	struct Stats
+	{
+		uint64 ResidentBytes = 0;
+		// What the textures would take at the levels last requested.
+		uint64 RequestedBytes = 0;
+		// Requested levels that are not resident yet.
+		uint32 MissingLevels = 0;
+		uint32 StreamedLevels = 0;
+		uint64 StreamedBytes = 0;
+		uint32 Evictions = 0;
+		uint64 EvictedBytes = 0;
+		// Updates that left requested levels out because the budget was
+		// taken by levels in use.
+		uint32 OverBudgetUpdates = 0;
+		// CPU memory the application keeps to upload levels again, as given
+		// to Add.  Not part of the budget.
+		uint64 SourceBytes = 0;
+	};
+
+	explicit TextureResidency(const Options& options);
+	TextureResidency(const TextureResidency& rhs) = delete;
+	TextureResidency& operator=(const TextureResidency& rhs) = delete;
+
+	///<summary>
+	/// Level the texture is sampled at when texels of it cover pixels on
+	/// screen, texels and pixels measured along the same line.
+	///</summary>
+	static float EstimateMip(float texels, float pixels);
+
+	///<summary>
+	/// levelBytes holds the size of every level, finest first.  Levels from
+	/// tailMip on stay resident, firstMip is the first one resident now.
+	/// sourceBytes is what the texture keeps on the CPU to stream from.
+	///</summary>
+	TextureId Add(const std::vector<uint64>& levelBytes, uint32 tailMip, uint32 firstMip, uint64 sourceBytes = 0);
+
+	///<summary>
+	/// The texture is seen at mip this frame.  The finest request between
+	/// two Updates counts.
+	///</summary>
+	void Request(TextureId id, float mip);
+
+	///<summary>
+	/// Once a frame, or less often: evicts and streams levels for the
+	/// requests since the last Update and returns the textures that changed.
+	///</summary>
+	std::vector<Change> Update();
+
+	uint32 GetFirstMip(TextureId id) const;
+	uint32 GetTextureCount() const;
+
+	void SetBudget(uint64 budgetBytes);
+	const Options& GetOptions() const;
+
+	const Stats& GetStats() const;
+
+	std::string ToString() const;
+
+private:
+	struct Texture
+	{
+		std::vector<uint64> LevelBytes;
+		uint32 TailMip;
+		uint32 FirstMip;
+		// Finest level requested since the last Update.
+		uint32 RequestedMip;
+		bool Requested = false;
+		// Update that last saw a request, for the LRU order.
+		uint64 LastUsed = 0;
+	};
+
+	uint64 BytesFrom(const Texture& texture, uint32 firstMip) const;
+
+	Options mOptions;
+	std::vector<Texture> mTextures;
+	uint64 mUpdate = 0;
+	Stats mStats;
+};
\ No newline at end of file
@@ -0,0 +1,335 @@
+#include "VertexQuantizer.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+
+const float VertexQuantizer::OctahedralErrorBound = 0.01f;
+
+namespace
+{
+	// Half floats keep 11 significant bits, so the rounding error is at most
+	// 2^-11 of the magnitude (plus the denormal step close to zero).
+	const float HalfRelativeError = 1.0f / 2048.0f;
+	const float HalfDenormalError = 1.0f / 33554432.0f;
+
+	inline const float* Element(const float* stream, size_t byteStride, size_t i)
+	{
+		return reinterpret_cast<const float*>(reinterpret_cast<const char*>(stream) + i * byteStride);
+	}
+
+	XMVECTOR LoadPosition(const VertexQuantizer::SourceStreams& src, size_t i)
+	{
+		return XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(Element(src.Positions, src.PositionByteStride, i)));
+	}
+
+	XMVECTOR LoadDirection(const float* stream, size_t byteStride, size_t i, FXMVECTOR fallback)
+	{
+		if (stream == nullptr)
+			return fallback;
+
+		XMVECTOR v = XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(Element(stream, byteStride, i)));
+		if (XMVectorGetX(XMVector3LengthSq(v)) < 1e-12f)
+			return fallback;
+
+		return XMVector3Normalize(v);
+	}
+
+	XMVECTOR LoadNormal(const VertexQuantizer::SourceStreams& src, size_t i)
+	{
+		return LoadDirection(src.Normals, src.NormalByteStride, i, XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+	}
+
+	XMVECTOR LoadTangent(const VertexQuantizer::SourceStreams& src, size_t i)
+	{
+		return LoadDirection(src.Tangents, src.TangentByteStride, i, XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f));
+	}
+
+	XMVECTOR LoadTexCoord(const VertexQuantizer::SourceStreams& src, size_t i)
+	{
+		if (src.TexCoords == nullptr)
+			return XMVectorZero();
+
+		return XMLoadFloat2(reinterpret_cast<const XMFLOAT2*>(Element(src.TexCoords, src.TexCoordByteStride, i)));
+	}
+
+	XMVECTOR LoadColor(const VertexQuantizer::SourceStreams& src, size_t i)
+	{
+		if (src.Colors == nullptr)
+			return XMVectorSaturate(XMLoadFloat4(&src.DefaultColor));
+
+		return XMVectorSaturate(XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(Element(src.Colors, src.ColorByteStride, i))));
+	}
+
+	//
+	// Per format store/load of the position, overloaded on the packed type.
+	//
+
+	void StorePosition(XMUSHORTN4* dst, FXMVECTOR p, FXMVECTOR invScale, FXMVECTOR offset)
+	{
+		XMStoreUShortN4(dst, XMVectorSetW(XMVectorMultiply(XMVectorSubtract(p, offset), invScale), 1.0f));
+	}
+
+	void StorePosition(XMHALF4* dst, FXMVECTOR p, FXMVECTOR, FXMVECTOR)
+	{
+		XMStoreHalf4(dst, XMVectorSetW(p, 1.0f));
+	}
+
+	XMVECTOR LoadPosition(const XMUSHORTN4* src, FXMVECTOR scale, FXMVECTOR offset)
+	{
+		return XMVectorMultiplyAdd(XMLoadUShortN4(src), scale, offset);
+	}
+
+	XMVECTOR LoadPosition(const XMHALF4* src, FXMVECTOR, FXMVECTOR)
+	{
+		return XMLoadHalf4(src);
+	}
+
+	//
+	// Only some formats carry a tangent.
+	//
+
+	template<typename TVertex>
+	void StoreTangent(TVertex&, FXMVECTOR)
+	{
+	}
+
+	void StoreTangent(PrimitiveTypes::QuantPosNorTanTexColVertex& v, FXMVECTOR t)
+	{
+		XMStoreShortN2(&v.TangentU, VertexQuantizer::EncodeOctahedral(t));
+	}
+
+	template<typename TVertex>
+	bool LoadTangent(const TVertex&, XMVECTOR&)
+	{
+		return false;
+	}
+
+	bool LoadTangent(const PrimitiveTypes::QuantPosNorTanTexColVertex& v, XMVECTOR& t)
+	{
+		t = VertexQuantizer::DecodeOctahedral(XMLoadShortN2(&v.TangentU));
+		return true;
+	}
+
+	// Angle between two unit vectors in degrees.  2*asin(|a-b|/2) stays
+	// accurate for the tiny angles we care about, acos(dot) does not.
+	float AngleDegrees(FXMVECTOR a, FXMVECTOR b)
+	{
+		float chord = XMVectorGetX(XMVector3Length(XMVectorSubtract(a, b)));
+		return XMConvertToDegrees(2.0f * asinf(std::min(chord * 0.5f, 1.0f)));
+	}
+
+	template<typename TVertex>
+	void QuantizeImpl(const VertexQuantizer::SourceStreams& src, const VertexQuantizer::PositionQuantization& quantization, TVertex* dst)
+	{
+		XMVECTOR scale = XMLoadFloat3(&quantization.Scale);
+		XMVECTOR offset = XMLoadFloat3(&quantization.Offset);
+
+		// Flat axes have a zero scale, all their vertices sit on the offset.
+		XMVECTOR invScale = XMVectorSelect(XMVectorReciprocal(scale), XMVectorZero(), XMVectorEqual(scale, XMVectorZero()));
+
+		for (size_t i = 0; i < src.VertexCount; ++i)
+		{
+			TVertex& v = dst[i];
+
+			StorePosition(&v.Position, LoadPosition(src, i), invScale, offset);
+			XMStoreShortN2(&v.Normal, VertexQuantizer::EncodeOctahedral(LoadNormal(src, i)));
+			StoreTangent(v, LoadTangent(src, i));
+			XMStoreHalf2(&v.TexCoord, LoadTexCoord(src, i));
+			XMStoreUByteN4(&v.Color, LoadColor(src, i));
+		}
+	}
+
+	template<typename TVertex>
+	VertexQuantizer::ErrorReport MeasureErrorImpl(const VertexQuantizer::SourceStreams& src, const VertexQuantizer::PositionQuantization& quantization, const TVertex* vertices, bool halfPositions)
+	{
+		VertexQuantizer::ErrorReport report;
+		report.VertexCount = src.VertexCount;
+
+		XMVECTOR scale = XMLoadFloat3(&quantization.Scale);
+		XMVECTOR offset = XMLoadFloat3(&quantization.Offset);
+
+		XMVECTOR maxAbsPosition = XMVectorZero();
+		XMVECTOR maxAbsTexCoord = XMVectorZero();
+
+		for (size_t i = 0; i < src.VertexCount; ++i)
+		{
+			const TVertex& v = vertices[i];
+
+			XMVECTOR position = LoadPosition(src, i);
+			XMVECTOR texCoord = LoadTexCoord(src, i);
+			maxAbsPosition = XMVectorMax(maxAbsPosition, XMVectorAbs(position));
+			maxAbsTexCoord = XMVectorMax(maxAbsTexCoord, XMVectorAbs(texCoord));
+
+			XMVECTOR decodedPosition = LoadPosition(&v.Position, scale, offset);
+			report.MaxPositionError = std::max(report.MaxPositionError,
+				XMVectorGetX(XMVector3Length(XMVectorSubtract(decodedPosition, position))));
+
+			XMVECTOR decodedNormal = VertexQuantizer::DecodeOctahedral(XMLoadShortN2(&v.Normal));
+			report.MaxNormalError = std::max(report.MaxNormalError, AngleDegrees(decodedNormal, LoadNormal(src, i)));
+
+			XMVECTOR decodedTangent;
+			if (LoadTangent(v, decodedTangent))
+				report.MaxTangentError = std::max(report.MaxTangentError, AngleDegrees(decodedTangent, LoadTangent(src, i)));
+
+			XMVECTOR decodedTexCoord = XMLoadHalf2(&v.TexCoord);
+			report.MaxTexCoordError = std::max(report.MaxTexCoordError,
+				XMVectorGetX(XMVector2Length(XMVectorSubtract(decodedTexCoord, texCoord))));
+
+			XMVECTOR decodedColor = XMLoadUByteN4(&v.Color);
+			XMVECTOR colorError = XMVectorAbs(XMVectorSubtract(decodedColor, LoadColor(src, i)));
+			report.MaxColorError = std::max(report.MaxColorError, std::max(
+				std::max(XMVectorGetX(colorError), XMVectorGetY(colorError)),
+				std::max(XMVectorGetZ(colorError), XMVectorGetW(colorError))));
+		}
+
+		// Half a quantization step per component, plus float rounding in the decode.
+		float floatRounding = XMVectorGetX(XMVector3Length(maxAbsPosition)) * FLT_EPSILON * 4.0f;
+		if (halfPositions)
+			report.PositionBound = XMVectorGetX(XMVector3Length(maxAbsPosition)) * HalfRelativeError + HalfDenormalError + floatRounding;
+		else
+			report.PositionBound = XMVectorGetX(XMVector3Length(scale)) * (0.5f / 65535.0f) + floatRounding;
+
+		report.NormalBound = VertexQuantizer::OctahedralErrorBound;
+		report.TangentBound = VertexQuantizer::OctahedralErrorBound;
+		report.TexCoordBound = XMVectorGetX(XMVector2Length(maxAbsTexCoord)) * HalfRelativeError + HalfDenormalError;
+		report.ColorBound = 0.5f / 255.0f + FLT_EPSILON;
+
+		return report;
+	}
+}
+
+bool VertexQuantizer::ErrorReport::WithinBounds() const
+{
+	return MaxPositionError <= PositionBound &&
+		MaxNormalError <= NormalBound &&
+		MaxTangentError <= TangentBound &&
+		MaxTexCoordError <= TexCoordBound &&
+		MaxColorError <= ColorBound;
+}
+
+std::string VertexQuantizer::ErrorReport::ToString(const std::string& name) const
+{
+	char buffer[512];
+	snprintf(buffer, sizeof(buffer),
+		"[VertexQuantizer] %s: %u vertices, position %g (bound %g), normal %.4f deg, tangent %.4f deg (bound %.4f), "
+		"texcoord %g (bound %g), color %.4f (bound %.4f)%s\n",
+		name.c_str(), (unsigned)VertexCount,
+		MaxPositionError, PositionBound,
+		MaxNormalError, MaxTangentError, NormalBound,
+		MaxTexCoordError, TexCoordBound,
+		MaxColorError, ColorBound,
+		WithinBounds() ? "" : " OUT OF BOUNDS");
+
+	return buffer;
+}
+
+VertexQuantizer::SourceStreams VertexQuantizer::FromMeshData(const GeometryGenerator::MeshData& mesh)
+{
+	SourceStreams src;
+	src.VertexCount = mesh.Vertices.size();
+	if (src.VertexCount == 0)
+		return src;
+
+	const GeometryGenerator::Vertex& v = mesh.Vertices[0];
+	src.Positions = &v.Position.x;
+	src.PositionByteStride = sizeof(GeometryGenerator::Vertex);
+	src.Normals = &v.Normal.x;
+	src.NormalByteStride = sizeof(GeometryGenerator::Vertex);
+	src.Tangents = &v.TangentU.x;
+	src.TangentByteStride = sizeof(GeometryGenerator::Vertex);
+	src.TexCoords = &v.TexC.x;
+	src.TexCoordByteStride = sizeof(GeometryGenerator::Vertex);
+
+	return src;
+}
+
+VertexQuantizer::PositionQuantization VertexQuantizer::ComputePositionQuantization(const SourceStreams& src)
+{
+	PositionQuantization quantization;
+	if (src.VertexCount == 0)
+		return quantization;
+
+	XMVECTOR vMin = LoadPosition(src, 0);
+	XMVECTOR vMax = vMin;
+	for (size_t i = 1; i < src.VertexCount; ++i)
+	{
+		XMVECTOR p = LoadPosition(src, i);
+		vMin = XMVectorMin(vMin, p);
+		vMax = XMVectorMax(vMax, p);
+	}
+
+	XMStoreFloat3(&quantization.Scale, XMVectorSubtract(vMax, vMin));
+	XMStoreFloat3(&quantization.Offset, vMin);
+
+	return quantization;
+}
+
+void VertexQuantizer::Quantize(const SourceStreams& src, const PositionQuantization& quantization, PrimitiveTypes::QuantPosTexNorColVertex* dst)
+{
+	QuantizeImpl(src, quantization, dst);
+}
+
+void VertexQuantizer::Quantize(const SourceStreams& src, const PositionQuantization& quantization, PrimitiveTypes::QuantPosNorTanTexColVertex* dst)
+{
+	QuantizeImpl(src, quantization, dst);
+}
+
+void VertexQuantizer::Quantize(const SourceStreams& src, PrimitiveTypes::HalfPosTexNorColVertex* dst)
+{
+	QuantizeImpl(src, PositionQuantization(), dst);
+}
+
+VertexQuantizer::ErrorReport VertexQuantizer::MeasureError(const SourceStreams& src, const PositionQuantization& quantization, const PrimitiveTypes::QuantPosTexNorColVertex* vertices)
+{
+	return MeasureErrorImpl(src, quantization, vertices, false);
+}
+
+VertexQuantizer::ErrorReport VertexQuantizer::MeasureError(const SourceStreams& src, const PositionQuantization& quantization, const PrimitiveTypes::QuantPosNorTanTexColVertex* vertices)
+{
+	return MeasureErrorImpl(src, quantization, vertices, false);
+}
+
+VertexQuantizer::ErrorReport VertexQuantizer::MeasureError(const SourceStreams& src, const PrimitiveTypes::HalfPosTexNorColVertex* vertices)
+{
+	return MeasureErrorImpl(src, PositionQuantization(), vertices, true);
+}
+
+VertexQuantizer::ErrorReport VertexQuantizer::Quantize(const SourceStreams& src, std::vector<PrimitiveTypes::HalfPosTexNorColVertex>& vertices)
+{
+	vertices.resize(src.VertexCount);
+	Quantize(src, vertices.data());
+	return MeasureError(src, vertices.data());
+}
+
+XMVECTOR XM_CALLCONV VertexQuantizer::EncodeOctahedral(FXMVECTOR n)
+{
+	// Project onto the octahedron |x| + |y| + |z| = 1.
+	XMVECTOR l1 = XMVector3Dot(XMVectorAbs(n), XMVectorSplatOne());
+	XMVECTOR p = XMVectorDivide(n, l1);
+
+	// Fold the lower hemisphere over the diagonals.
+	XMVECTOR sign = XMVectorSelect(XMVectorSplatOne(), XMVectorNegate(XMVectorSplatOne()), XMVectorLess(p, XMVectorZero()));
+	XMVECTOR folded = XMVectorMultiply(XMVectorSubtract(XMVectorSplatOne(), XMVectorAbs(XMVectorSwizzle<1, 0, 2, 3>(p))), sign);
+
+	XMVECTOR lowerHemisphere = XMVectorLess(XMVectorSplatZ(p), XMVectorZero());
+	return XMVectorSelect(p, folded, lowerHemisphere);
+}
+
+XMVECTOR XM_CALLCONV VertexQuantizer::DecodeOctahedral(FXMVECTOR e)
+{
+	// Same as DecodeOctahedral in Common.hlsl.
+	XMVECTOR absE = XMVectorAbs(e);
+	float z = 1.0f - XMVectorGetX(absE) - XMVectorGetY(absE);
+	XMVECTOR v = XMVectorSetZ(e, z);
+
+	XMVECTOR t = XMVectorReplicate(std::max(-z, 0.0f));
+	XMVECTOR positive = XMVectorGreaterOrEqual(v, XMVectorZero());
+	v = XMVectorAdd(v, XMVectorSelect(t, XMVectorNegate(t), positive));
+	v = XMVectorSetZ(v, z);
+
+	return XMVector3Normalize(XMVectorSetW(v, 0.0f));
+}
\ No newline at end of file
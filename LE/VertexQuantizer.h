@@ -0,0 +1,152 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <DirectXMath.h>
+#include <DirectXPackedVector.h>
+#include "GeometryGenerator.h"
+#include "PrimitiveTypes.h"
+
+// Converts float vertex data into the compact PrimitiveTypes formats
+// (unorm16/half positions, octahedral normals and tangents, half UVs and
+// RGBA8 colors) and measures how much precision the conversion lost.
+class VertexQuantizer
+{
+public:
+	// Strided views of the source attributes, so MeshData and the Assimp
+	// arrays can be converted without copying them first.  Any stream but the
+	// positions may be null: normals then default to +y, tangents to +x, UVs
+	// to zero and colors to DefaultColor.
+	struct SourceStreams
+	{
+		size_t VertexCount = 0;
+
+		const float* Positions = nullptr;
+		size_t PositionByteStride = 0;
+		const float* Normals = nullptr;
+		size_t NormalByteStride = 0;
+		const float* Tangents = nullptr;
+		size_t TangentByteStride = 0;
+		const float* TexCoords = nullptr;
+		size_t TexCoordByteStride = 0;
+		const float* Colors = nullptr;
+		size_t ColorByteStride = 0;
+
+		DirectX::XMFLOAT4 DefaultColor = { 1.0f, 1.0f, 1.0f, 1.0f };
+	};
+
+	// Per-mesh dequantization of the unorm16 positions:
+	// position = stored * Scale + Offset.  Copy it to MeshGeometry::PositionScale/PositionOffset.
+	struct PositionQuantization
+	{
+		DirectX::XMFLOAT3 Scale = { 1.0f, 1.0f, 1.0f };
+		DirectX::XMFLOAT3 Offset = { 0.0f, 0.0f, 0.0f };
+	};
+
+	struct ErrorReport
+	{
+		size_t VertexCount = 0;
+
+		// Largest error over all vertices.  Positions and UVs are the distance
+		// to the source value, normals and tangents the angle in degrees.
+		float MaxPositionError = 0.0f;
+		float MaxNormalError = 0.0f;
+		float MaxTangentError = 0.0f;
+		float MaxTexCoordError = 0.0f;
+		float MaxColorError = 0.0f;
+
+		// What the formats guarantee for this mesh, the errors are checked against these.
+		float PositionBound = 0.0f;
+		float NormalBound = 0.0f;
+		float TangentBound = 0.0f;
+		float TexCoordBound = 0.0f;
+		float ColorBound = 0.0f;
+
+		bool WithinBounds() const;
+		std::string ToString(const std::string& name) const;
+	};
+
+	// Worst case angle error of a snorm16 octahedral direction, in degrees.
+	static const float OctahedralErrorBound;
+
+	static SourceStreams FromMeshData(const GeometryGenerator::MeshData& mesh);
+
+	///<summary>
+	/// Views of an aiMesh.  A template, so neither this header nor the
+	/// quantizer itself needs the Assimp headers.
+	///</summary>
+	template<typename TMesh>
+	static SourceStreams FromAssimp(const TMesh& mesh)
+	{
+		SourceStreams src;
+		src.VertexCount = mesh.mNumVertices;
+		if (src.VertexCount == 0 || mesh.mVertices == nullptr)
+			return src;
+
+		src.Positions = &mesh.mVertices[0].x;
+		src.PositionByteStride = sizeof(mesh.mVertices[0]);
+		if (mesh.mNormals)
+		{
+			src.Normals = &mesh.mNormals[0].x;
+			src.NormalByteStride = sizeof(mesh.mNormals[0]);
+		}
+		if (mesh.mTangents)
+		{
+			src.Tangents = &mesh.mTangents[0].x;
+			src.TangentByteStride = sizeof(mesh.mTangents[0]);
+		}
+		// Assimp stores UVs as 3D vectors, only xy is read.
+		if (mesh.mTextureCoords[0])
+		{
+			src.TexCoords = &mesh.mTextureCoords[0][0].x;
+			src.TexCoordByteStride = sizeof(mesh.mTextureCoords[0][0]);
+		}
+		if (mesh.mColors[0])
+		{
+			src.Colors = &mesh.mColors[0][0].r;
+			src.ColorByteStride = sizeof(mesh.mColors[0][0]);
+		}
+
+		return src;
+	}
+
+	///<summary>
+	/// Fits the unorm16 position range to the bounding box of the mesh.
+	///</summary>
+	static PositionQuantization ComputePositionQuantization(const SourceStreams& src);
+
+	///<summary>
+	/// Converts src.VertexCount vertices into dst.
+	///</summary>
+	static void Quantize(const SourceStreams& src, const PositionQuantization& quantization, PrimitiveTypes::QuantPosTexNorColVertex* dst);
+	static void Quantize(const SourceStreams& src, const PositionQuantization& quantization, PrimitiveTypes::QuantPosNorTanTexColVertex* dst);
+	static void Quantize(const SourceStreams& src, PrimitiveTypes::HalfPosTexNorColVertex* dst);
+
+	///<summary>
+	/// Decodes the packed vertices again and compares them with the source.
+	///</summary>
+	static ErrorReport MeasureError(const SourceStreams& src, const PositionQuantization& quantization, const PrimitiveTypes::QuantPosTexNorColVertex* vertices);
+	static ErrorReport MeasureError(const SourceStreams& src, const PositionQuantization& quantization, const PrimitiveTypes::QuantPosNorTanTexColVertex* vertices);
+	static ErrorReport MeasureError(const SourceStreams& src, const PrimitiveTypes::HalfPosTexNorColVertex* vertices);
+
+	///<summary>
+	/// Quantizes a whole mesh and returns the error report.  quantization
+	/// receives the dequantization the mesh has to be drawn with.
+	///</summary>
+	template<typename TVertex>
+	static ErrorReport Quantize(const SourceStreams& src, std::vector<TVertex>& vertices, PositionQuantization& quantization)
+	{
+		quantization = ComputePositionQuantization(src);
+		vertices.resize(src.VertexCount);
+		Quantize(src, quantization, vertices.data());
+		return MeasureError(src, quantization, vertices.data());
+	}
+
+	static ErrorReport Quantize(const SourceStreams& src, std::vector<PrimitiveTypes::HalfPosTexNorColVertex>& vertices);
+
+	///<summary>
+	/// Maps a unit vector onto the [-1, 1] square of the octahedral encoding (xy of the result).
+	///</summary>
+	static DirectX::XMVECTOR XM_CALLCONV EncodeOctahedral(DirectX::FXMVECTOR n);
+	static DirectX::XMVECTOR XM_CALLCONV DecodeOctahedral(DirectX::FXMVECTOR e);
+};
\ No newline at end of file
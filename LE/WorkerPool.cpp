@@ -0,0 +1,161 @@
+#include "WorkerPool.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	using uint32 = WorkerPool::uint32;
+
+	// A ParallelFor call, on the stack of the thread that made it.
+	struct Loop
+	{
+		uint32 Count = 0;
+		void (*Function)(const void* context, uint32 i) = nullptr;
+		const void* Context = nullptr;
+		std::atomic<uint32> Next{ 0 };
+
+		// Under the pool's mutex: workers that may still join, workers in
+		// the loop, and the first exception.
+		uint32 OpenSlots = 0;
+		uint32 Active = 0;
+		std::exception_ptr Failure;
+	};
+
+	class Pool
+	{
+	public:
+		Pool()
+		{
+			const uint32 workerCount = std::max(1u, std::thread::hardware_concurrency()) - 1;
+			for (uint32 i = 0; i < workerCount; ++i)
+				mThreads.emplace_back([this]() { Work(); });
+		}
+
+		Pool(const Pool& rhs) = delete;
+		Pool& operator=(const Pool& rhs) = delete;
+
+		~Pool()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+				mStopping = true;
+			}
+			mWake.notify_all();
+			for (auto& thread : mThreads)
+				thread.join();
+		}
+
+		uint32 GetWorkerCount() const
+		{
+			return (uint32)mThreads.size();
+		}
+
+		void Run(Loop& loop)
+		{
+			const bool oneWorker = loop.OpenSlots == 1;
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+				mLoops.push_back(&loop);
+			}
+			if (oneWorker)
+				mWake.notify_one();
+			else
+				mWake.notify_all();
+
+			RunItems(loop);
+
+			// Workers that did not get to the loop yet are not waited for.
+			std::unique_lock<std::mutex> lock(mMutex);
+			auto queued = std::find(mLoops.begin(), mLoops.end(), &loop);
+			if (queued != mLoops.end())
+				mLoops.erase(queued);
+			mDone.wait(lock, [&loop]() { return loop.Active == 0; });
+
+			if (loop.Failure)
+				std::rethrow_exception(loop.Failure);
+		}
+
+	private:
+		void Work()
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			for (;;)
+			{
+				mWake.wait(lock, [this]() { return mStopping || !mLoops.empty(); });
+				if (mStopping)
+					return;
+
+				Loop& loop = *mLoops.front();
+				loop.Active++;
+				if (--loop.OpenSlots == 0)
+					mLoops.pop_front();
+
+				lock.unlock();
+				RunItems(loop);
+				lock.lock();
+
+				if (--loop.Active == 0)
+					mDone.notify_all();
+			}
+		}
+
+		void RunItems(Loop& loop)
+		{
+			try
+			{
+				for (uint32 i = loop.Next++; i < loop.Count; i = loop.Next++)
+					loop.Function(loop.Context, i);
+			}
+			catch (...)
+			{
+				loop.Next = loop.Count;
+				std::lock_guard<std::mutex> lock(mMutex);
+				if (!loop.Failure)
+					loop.Failure = std::current_exception();
+			}
+		}
+
+		std::vector<std::thread> mThreads;
+		std::mutex mMutex;
+		std::condition_variable mWake;
+		std::condition_variable mDone;
+		// Loops that still take workers, oldest first.
+		std::deque<Loop*> mLoops;
+		bool mStopping = false;
+	};
+
+	Pool& GetPool()
+	{
+		static Pool pool;
+		return pool;
+	}
+}
+
+WorkerPool::uint32 WorkerPool::GetWorkerCount()
+{
+	return GetPool().GetWorkerCount();
+}
+
+void WorkerPool::Run(uint32 count, uint32 threadCount, Function function, const void* context)
+{
+	const uint32 threads = std::min(std::min(threadCount, count), GetWorkerCount() + 1);
+	if (threads <= 1)
+	{
+		for (uint32 i = 0; i < count; ++i)
+			function(context, i);
+		return;
+	}
+
+	Loop loop;
+	loop.Count = count;
+	loop.Function = function;
+	loop.Context = context;
+	loop.OpenSlots = threads - 1;
+	GetPool().Run(loop);
+}
\ No newline at end of file
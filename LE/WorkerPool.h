@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+
+// One set of worker threads, started on first use and shared by the loops
+// that split their work over rows, blocks or tiles, so a loop does not start
+// and join threads of its own on every call.
+//
+// The calling thread works on its own loop too and finishes it alone when
+// the workers are busy, so loops can nest and run from several threads at
+// once, like the texture tasks of the startup TaskGraph do.
+class WorkerPool
+{
+public:
+	using uint32 = std::uint32_t;
+
+	///<summary>
+	/// Runs body(i) for every i below count on up to threadCount threads, the
+	/// calling one included, and returns once all of them finished.  Items
+	/// are handed out one at a time, so uneven work still spreads evenly.  If
+	/// body throws, the items not started yet are skipped and the first
+	/// exception is rethrown.
+	///</summary>
+	template<typename TBody>
+	static void ParallelFor(uint32 count, uint32 threadCount, const TBody& body)
+	{
+		Run(count, threadCount, [](const void* context, uint32 i) { (*static_cast<const TBody*>(context))(i); }, &body);
+	}
+
+	///<summary>
+	/// Threads besides the calling one a loop can get, one less than the
+	/// hardware threads.
+	///</summary>
+	static uint32 GetWorkerCount();
+
+private:
+	using Function = void (*)(const void* context, uint32 i);
+
+	static void Run(uint32 count, uint32 threadCount, Function function, const void* context);
+};
\ No newline at end of file